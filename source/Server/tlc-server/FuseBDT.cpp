@@ -25,6 +25,8 @@
 #include "bdt/CacheManager.h"
 #include "bdt/ReadManager.h"
 #include "bdt/MetaManager.h"
+#include "bdt/CatalogJournal.h"
+#include "bdt/TapeOrderIndex.h"
 #include "bdt/ServiceServer.h"
 #include "bdt/FileOperationCIFS.h"
 #include "ltfs_management/TapeLibraryMgr.h"
@@ -67,16 +69,9 @@ int FuseBDT::getattr (const char * pathname, struct stat *stbuf)
     LogDebug ( pathname );
 
     try {
-        if ( meta_->GetActiveStat(pathname, *stbuf) ) {
+        if ( meta_->GetStat(pathname, *stbuf) ) {
             FuseReturn(0,pathname);
         }
-        auto_ptr<Inode> inode(meta_->GetInode(pathname));
-        if ( inode.get() ) {
-            if ( inode->GetStat(*stbuf) ) {
-                //LogInfo(boost::lexical_cast<string>(stbuf->st_size));
-                FuseReturn(0,pathname);
-            }
-        }
     } catch (const std::exception & e) {
         LogError(e.what());
     }
@@ -259,6 +254,7 @@ int FuseBDT::utime (const char * pathname, struct utimbuf *buf)
     }
 
     if ( 0 == ::utime( inode->Path().string().c_str(), buf ) ) {
+        meta_->InvalidateAttribute(path);
         FuseReturn(0,pathname);
     } else {
         FuseReturnError(pathname);
@@ -338,6 +334,34 @@ int FuseBDT::write (
         size_t size,
         off_t offset,
         struct fuse_file_info * info )
+{
+    struct fuse_context * context = fuse_get_context();
+    return write( pathname, buf, size, offset, info,
+            GetThrottleClient(context->uid, context->pid) );
+}
+
+
+int FuseBDT::write (
+        const char * pathname,
+        const char * buf,
+        size_t size,
+        off_t offset,
+        struct fuse_file_info * info,
+        uid_t uid,
+        pid_t pid )
+{
+    return write( pathname, buf, size, offset, info,
+            GetThrottleClient(uid, pid) );
+}
+
+
+int FuseBDT::write (
+        const char * pathname,
+        const char * buf,
+        size_t size,
+        off_t offset,
+        struct fuse_file_info * info,
+        const string & client )
 {
 #ifdef DEBUG
     LogDebug ( pathname << " offset: " << offset << " size: " << size );
@@ -357,7 +381,7 @@ int FuseBDT::write (
 //    file->GetTape(tape);
 //    boost::lock_guard<boost::mutex> lock(*GetMutex(tape));
 
-    Factory::GetThrottle()->Request(size);
+    Factory::GetThrottle()->Request(size,client);
 
     size_t sizeWrite;
     if ( file->Write(offset,buf,size,sizeWrite) ) {
@@ -507,6 +531,18 @@ int FuseBDT::getxattr (
     LogDebug ( pathname << " " << name );
 
     try {
+        //  the online state is computed from the cache file, keep it with
+        //  the cached attributes
+        if ( Inode::ATTRIBUTE_ONLINE == name ) {
+            Inode::OnlineState state;
+            int ret;
+            if ( meta_->GetOnline(pathname,state)
+                    && Inode::GetOnlineAttribute(state,value,size,ret) ) {
+                FuseReturn(ret,pathname);
+            }
+            FuseReturnError(pathname);
+        }
+
         auto_ptr<Inode> inode(meta_->GetInode(pathname));
         if ( inode.get() ) {
             int ret;
@@ -626,18 +662,30 @@ int FuseBDT::readdir (
 
     DIR * dir = reinterpret_cast<DIR *>(info->fh);
 
-    struct dirent * ent = NULL;
-    do {
-        ent = ::readdir(dir);
-        if ( ent != NULL ) {
-            if ( filler(buf,ent->d_name,NULL,0) != 0 ) {
-                errno = ENOMEM;
-                FuseReturnError(pathname);
+    //  every entry is filled with its attributes and the offset of the
+    //  next entry, a listing stopped by a full buffer resumes from there
+    if ( offset == 0 ) {
+        ::rewinddir(dir);
+    } else {
+        ::seekdir(dir, offset);
+    }
+
+    try {
+        FolderEntry entry;
+        while ( meta_->ReadFolder(pathname, dir, entry) ) {
+            if ( filler( buf, entry.name.c_str(),
+                    &entry.stat, entry.offset ) != 0 ) {
+                FuseReturn(0,pathname);
             }
         }
-    } while ( ent != NULL );
+        if ( errno == 0 ) {
+            FuseReturn(0,pathname);
+        }
+    } catch (const std::exception & e) {
+        LogError(e.what());
+    }
 
-    FuseReturn(0,pathname);
+    FuseReturnError(pathname);
 }
 
 
@@ -676,11 +724,17 @@ void * FuseBDT::init(struct fuse_conn_info *)
     Factory::CreateThrottle(
             Factory::GetConfigure()->GetValueSize(Configure::ThrottleInterval),
             Factory::GetConfigure()->GetValueSize(Configure::ThrottleValve) );
+    Factory::GetThrottle()->ResetClient(
+            Factory::GetConfigure()->GetValueSize(Configure::ThrottleInterval),
+            Factory::GetConfigure()->GetValueSize(
+                    Configure::ThrottleClientValve) );
     Factory::CreateTapeLibraryManager();
     Factory::CreateTapeManager();
     Factory::CreateCacheManager();
     Factory::CreateReadManager();
     Factory::CreateSchedule();
+    Factory::CreateCatalogJournal();
+    Factory::CreateTapeOrderIndex();
     Factory::CreateMetaManager();
     meta_ = bdt::Factory::GetMetaManager();
 
@@ -746,6 +800,23 @@ namespace bdt
     {
         changer_.reset();
     }
+
+    void
+    Factory::ReleaseCatalogJournal()
+    {
+        //  what is not applied by then is applied after the next start
+        if ( NULL != journal_.get() && ! journal_->Flush(10 * 1000) ) {
+            LogWarn(journal_->GetPending() << " catalog changes wait for the next start");
+        }
+        journal_.reset();
+        applier_.reset();
+    }
+
+    void
+    Factory::ReleaseTapeOrderIndex()
+    {
+        order_.reset();
+    }
 }
 
 
@@ -759,6 +830,8 @@ void FuseBDT::destroy(void *)
     bdt::Factory::ReleaseMetaManager();
     bdt::Factory::ReleaseSchedule();
     bdt::Factory::ReleaseReadManager();
+    bdt::Factory::ReleaseCatalogJournal();
+    bdt::Factory::ReleaseTapeOrderIndex();
     bdt::Factory::ReleaseCacheManager();
     bdt::Factory::ReleaseTapeManager();
     bdt::Factory::ReleaseTapeLibraryManager();
@@ -887,3 +960,17 @@ FuseBDT::fgetattr(const char * pathname, struct stat * stbuf,
         FuseReturnError(pathname);
     }
 }
+
+
+string
+FuseBDT::GetThrottleClient(uid_t uid, pid_t pid)
+{
+    static string key = Factory::GetConfigure()->GetValue(
+            Configure::ThrottleClientKey );
+
+    if ( key == "uid" ) {
+        return "uid:" + boost::lexical_cast<string>(uid);
+    } else {
+        return "pid:" + boost::lexical_cast<string>(pid);
+    }
+}
@@ -52,6 +52,10 @@ public:
             struct fuse_file_info *);
     virtual int write (const char *, const char *, size_t, off_t,
             struct fuse_file_info *);
+    virtual int write (const char *, const char *, size_t, off_t,
+            struct fuse_file_info *, uid_t, pid_t);
+    int write (const char *, const char *, size_t, off_t,
+            struct fuse_file_info *, const string & client);
     virtual int statfs (const char *, struct statvfs *);
     virtual int flush (const char *, struct fuse_file_info *);
     virtual int release (const char *, struct fuse_file_info *);
@@ -75,6 +79,9 @@ public:
     virtual int ftruncate(const char *, off_t, struct fuse_file_info *);
     virtual int fgetattr(const char *, struct stat *, struct fuse_file_info *);
 
+    //  the client a write is throttled for, by pid or uid
+    static string GetThrottleClient(uid_t uid, pid_t pid);
+
 private:
     auto_ptr<ServiceServer> server_;
     MetaManager * meta_;
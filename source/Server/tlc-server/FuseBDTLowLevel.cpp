@@ -0,0 +1,659 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * FuseBDTLowLevel.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: agent
+ */
+
+
+#include "bdt/stdafx.h"
+
+using namespace bdt;
+
+#include "FuseBase.h"
+#include "FuseBDTLowLevel.h"
+
+
+//  inode number reported for directory entries without attributes,
+//  the same value the high level fuse library uses
+static const ino_t UNKNOWN_INO = 0xffffffff;
+
+
+struct DirHandle
+{
+    uint64_t dir;
+    fuse_req_t req;
+    string buffer;
+};
+
+
+struct fuse_lowlevel_ops FuseBDTLowLevel::FuseOperations =
+{
+    init        : FuseBDTLowLevel::init,
+    destroy     : FuseBDTLowLevel::destroy,
+    lookup      : FuseBDTLowLevel::lookup,
+    forget      : FuseBDTLowLevel::forget,
+    getattr     : FuseBDTLowLevel::getattr,
+    setattr     : FuseBDTLowLevel::setattr,
+    readlink    : NULL,
+    mknod       : NULL,
+    mkdir       : FuseBDTLowLevel::mkdir,
+    unlink      : FuseBDTLowLevel::unlink,
+    rmdir       : FuseBDTLowLevel::rmdir,
+    symlink     : NULL,
+    rename      : FuseBDTLowLevel::rename,
+    link        : NULL,
+    open        : FuseBDTLowLevel::open,
+    read        : FuseBDTLowLevel::read,
+    write       : FuseBDTLowLevel::write,
+    flush       : FuseBDTLowLevel::flush,
+    release     : FuseBDTLowLevel::release,
+    fsync       : FuseBDTLowLevel::fsync,
+    opendir     : FuseBDTLowLevel::opendir,
+    readdir     : FuseBDTLowLevel::readdir,
+    releasedir  : FuseBDTLowLevel::releasedir,
+    fsyncdir    : FuseBDTLowLevel::fsyncdir,
+    statfs      : FuseBDTLowLevel::statfs,
+    setxattr    : FuseBDTLowLevel::setxattr,
+    getxattr    : FuseBDTLowLevel::getxattr,
+    listxattr   : FuseBDTLowLevel::listxattr,
+    removexattr : FuseBDTLowLevel::removexattr,
+    access      : FuseBDTLowLevel::access,
+    create      : FuseBDTLowLevel::create,
+};
+
+
+FuseBDTLowLevel::FuseBDTLowLevel(FuseBase * bdt)
+: bdt_(bdt)
+, timeoutEntry_(1.0)
+, timeoutAttr_(1.0)
+{
+}
+
+
+FuseBDTLowLevel::~FuseBDTLowLevel()
+{
+}
+
+
+FuseBDTLowLevel *
+FuseBDTLowLevel::Self(fuse_req_t req)
+{
+    return reinterpret_cast<FuseBDTLowLevel *>(fuse_req_userdata(req));
+}
+
+
+bool
+FuseBDTLowLevel::GetPath(fuse_ino_t ino, fs::path & path)
+{
+    return inodes_.GetPath(ino, path);
+}
+
+
+bool
+FuseBDTLowLevel::GetPath(
+        fuse_ino_t parent, const char * name, fs::path & path)
+{
+    if ( ! inodes_.GetPath(parent, path) ) {
+        return false;
+    }
+    path /= name;
+    return true;
+}
+
+
+int
+FuseBDTLowLevel::FillEntry(const fs::path & path,
+        struct fuse_entry_param & entry)
+{
+    memset(&entry, 0, sizeof(entry));
+
+    int ret = bdt_->getattr(path.string().c_str(), &entry.attr);
+    if ( ret < 0 ) {
+        return ret;
+    }
+
+    //  the stat is the one of the meta stub, an open file only reports
+    //  the size of its cache file, so st_ino is the number of the stub
+    entry.ino = inodes_.Lookup(path, entry.attr);
+    if ( 0 == entry.ino ) {
+        return - EIO;
+    }
+    entry.attr.st_ino = entry.ino;
+    entry.generation = 1;
+    entry.entry_timeout = timeoutEntry_;
+    entry.attr_timeout = timeoutAttr_;
+    return 0;
+}
+
+
+void
+FuseBDTLowLevel::ReplyEntry(fuse_req_t req, const fs::path & path)
+{
+    struct fuse_entry_param entry;
+    int ret = FillEntry(path, entry);
+    if ( ret < 0 ) {
+        fuse_reply_err(req, -ret);
+        return;
+    }
+
+    if ( fuse_reply_entry(req, &entry) != 0 ) {
+        inodes_.Forget(entry.ino, 1);
+    }
+}
+
+
+#define FuseReplyError(ret)             \
+    if ( ret < 0 ) {                    \
+        fuse_reply_err(req, -ret);      \
+        return;                         \
+    }
+#define FuseGetPath(ino,path)           \
+    fs::path path;                      \
+    if ( ! self->GetPath(ino,path) ) {  \
+        fuse_reply_err(req, ENOENT);    \
+        return;                         \
+    }
+
+
+void FuseBDTLowLevel::init(void * userdata, struct fuse_conn_info * conn)
+{
+    FuseBDTLowLevel * self = reinterpret_cast<FuseBDTLowLevel *>(userdata);
+
+    self->bdt_->init(conn);
+
+    self->timeoutEntry_ = Factory::GetConfigure()->GetValueSize(
+            Configure::FuseEntryTimeout);
+    self->timeoutAttr_ = Factory::GetConfigure()->GetValueSize(
+            Configure::FuseAttrTimeout);
+}
+
+
+void FuseBDTLowLevel::destroy(void * userdata)
+{
+    FuseBDTLowLevel * self = reinterpret_cast<FuseBDTLowLevel *>(userdata);
+
+    self->bdt_->destroy(NULL);
+}
+
+
+void FuseBDTLowLevel::lookup(fuse_req_t req, fuse_ino_t parent,
+        const char * name)
+{
+    FuseBDTLowLevel * self = Self(req);
+    fs::path path;
+    if ( ! self->GetPath(parent, name, path) ) {
+        fuse_reply_err(req, ENOENT);
+        return;
+    }
+    self->ReplyEntry(req, path);
+}
+
+
+void FuseBDTLowLevel::forget(fuse_req_t req, fuse_ino_t ino,
+        unsigned long nlookup)
+{
+    Self(req)->inodes_.Forget(ino, nlookup);
+    fuse_reply_none(req);
+}
+
+
+void FuseBDTLowLevel::getattr(fuse_req_t req, fuse_ino_t ino,
+        struct fuse_file_info *)
+{
+    FuseBDTLowLevel * self = Self(req);
+    FuseGetPath(ino,path);
+
+    struct stat stbuf;
+    int ret = self->bdt_->getattr(path.string().c_str(), &stbuf);
+    FuseReplyError(ret);
+
+    stbuf.st_ino = ino;
+    fuse_reply_attr(req, &stbuf, self->timeoutAttr_);
+}
+
+
+void FuseBDTLowLevel::setattr(fuse_req_t req, fuse_ino_t ino,
+        struct stat * attr, int to_set, struct fuse_file_info * info)
+{
+    FuseBDTLowLevel * self = Self(req);
+    FuseGetPath(ino,path);
+    string name = path.string();
+    const char * pathname = name.c_str();
+
+    int ret = 0;
+    if ( to_set & FUSE_SET_ATTR_MODE ) {
+        ret = self->bdt_->chmod(pathname, attr->st_mode);
+        FuseReplyError(ret);
+    }
+    if ( to_set & ( FUSE_SET_ATTR_UID | FUSE_SET_ATTR_GID ) ) {
+        uid_t uid = ( to_set & FUSE_SET_ATTR_UID ) ? attr->st_uid : -1;
+        gid_t gid = ( to_set & FUSE_SET_ATTR_GID ) ? attr->st_gid : -1;
+        ret = self->bdt_->chown(pathname, uid, gid);
+        FuseReplyError(ret);
+    }
+    if ( to_set & FUSE_SET_ATTR_SIZE ) {
+        if ( info ) {
+            ret = self->bdt_->ftruncate(pathname, attr->st_size, info);
+        } else {
+            ret = self->bdt_->truncate(pathname, attr->st_size);
+        }
+        FuseReplyError(ret);
+    }
+    if ( to_set & ( FUSE_SET_ATTR_ATIME | FUSE_SET_ATTR_MTIME ) ) {
+        struct stat stbuf;
+        ret = self->bdt_->getattr(pathname, &stbuf);
+        FuseReplyError(ret);
+
+        struct utimbuf buf;
+        buf.actime = ( to_set & FUSE_SET_ATTR_ATIME )
+                ? attr->st_atime : stbuf.st_atime;
+        buf.modtime = ( to_set & FUSE_SET_ATTR_MTIME )
+                ? attr->st_mtime : stbuf.st_mtime;
+#ifdef FUSE_SET_ATTR_ATIME_NOW
+        if ( to_set & FUSE_SET_ATTR_ATIME_NOW ) {
+            buf.actime = time(NULL);
+        }
+        if ( to_set & FUSE_SET_ATTR_MTIME_NOW ) {
+            buf.modtime = time(NULL);
+        }
+#endif
+        ret = self->bdt_->utime(pathname, &buf);
+        FuseReplyError(ret);
+    }
+
+    struct stat stbuf;
+    ret = self->bdt_->getattr(pathname, &stbuf);
+    FuseReplyError(ret);
+
+    stbuf.st_ino = ino;
+    fuse_reply_attr(req, &stbuf, self->timeoutAttr_);
+}
+
+
+void FuseBDTLowLevel::mkdir(fuse_req_t req, fuse_ino_t parent,
+        const char * name, mode_t mode)
+{
+    FuseBDTLowLevel * self = Self(req);
+    fs::path path;
+    if ( ! self->GetPath(parent, name, path) ) {
+        fuse_reply_err(req, ENOENT);
+        return;
+    }
+
+    int ret = self->bdt_->mkdir(path.string().c_str(), mode);
+    FuseReplyError(ret);
+
+    self->ReplyEntry(req, path);
+}
+
+
+void FuseBDTLowLevel::unlink(fuse_req_t req, fuse_ino_t parent,
+        const char * name)
+{
+    FuseBDTLowLevel * self = Self(req);
+    fs::path path;
+    if ( ! self->GetPath(parent, name, path) ) {
+        fuse_reply_err(req, ENOENT);
+        return;
+    }
+
+    int ret = self->bdt_->unlink(path.string().c_str());
+    FuseReplyError(ret);
+
+    self->inodes_.Remove(path);
+    fuse_reply_err(req, 0);
+}
+
+
+void FuseBDTLowLevel::rmdir(fuse_req_t req, fuse_ino_t parent,
+        const char * name)
+{
+    FuseBDTLowLevel * self = Self(req);
+    fs::path path;
+    if ( ! self->GetPath(parent, name, path) ) {
+        fuse_reply_err(req, ENOENT);
+        return;
+    }
+
+    int ret = self->bdt_->rmdir(path.string().c_str());
+    FuseReplyError(ret);
+
+    self->inodes_.Remove(path);
+    fuse_reply_err(req, 0);
+}
+
+
+void FuseBDTLowLevel::rename(fuse_req_t req, fuse_ino_t parent,
+        const char * name, fuse_ino_t newparent, const char * newname)
+{
+    FuseBDTLowLevel * self = Self(req);
+    fs::path from, to;
+    if ( ! self->GetPath(parent, name, from)
+            || ! self->GetPath(newparent, newname, to) ) {
+        fuse_reply_err(req, ENOENT);
+        return;
+    }
+
+    int ret = self->bdt_->rename(
+            from.string().c_str(), to.string().c_str() );
+    FuseReplyError(ret);
+
+    self->inodes_.Rename(from, to);
+    fuse_reply_err(req, 0);
+}
+
+
+void FuseBDTLowLevel::open(fuse_req_t req, fuse_ino_t ino,
+        struct fuse_file_info * info)
+{
+    FuseBDTLowLevel * self = Self(req);
+    FuseGetPath(ino,path);
+
+    int ret = self->bdt_->open(path.string().c_str(), info);
+    FuseReplyError(ret);
+
+    info->direct_io = 1;
+    if ( fuse_reply_open(req, info) != 0 ) {
+        self->bdt_->release(path.string().c_str(), info);
+    }
+}
+
+
+void FuseBDTLowLevel::read(fuse_req_t req, fuse_ino_t ino, size_t size,
+        off_t offset, struct fuse_file_info * info)
+{
+    FuseBDTLowLevel * self = Self(req);
+    //  the file is already open, the path is only used for logging
+    fs::path path;
+    self->GetPath(ino, path);
+
+    boost::scoped_array<char> buffer(new char[size]);
+    int ret = self->bdt_->read(
+            path.string().c_str(), buffer.get(), size, offset, info);
+    FuseReplyError(ret);
+
+    fuse_reply_buf(req, buffer.get(), ret);
+}
+
+
+void FuseBDTLowLevel::write(fuse_req_t req, fuse_ino_t ino,
+        const char * buf, size_t size, off_t offset,
+        struct fuse_file_info * info)
+{
+    FuseBDTLowLevel * self = Self(req);
+    fs::path path;
+    self->GetPath(ino, path);
+
+    const struct fuse_ctx * context = fuse_req_ctx(req);
+    int ret = self->bdt_->write( path.string().c_str(), buf, size, offset,
+            info, context->uid, context->pid );
+    FuseReplyError(ret);
+
+    fuse_reply_write(req, ret);
+}
+
+
+void FuseBDTLowLevel::flush(fuse_req_t req, fuse_ino_t ino,
+        struct fuse_file_info * info)
+{
+    FuseBDTLowLevel * self = Self(req);
+    fs::path path;
+    self->GetPath(ino, path);
+
+    int ret = self->bdt_->flush(path.string().c_str(), info);
+    fuse_reply_err(req, -ret);
+}
+
+
+void FuseBDTLowLevel::release(fuse_req_t req, fuse_ino_t ino,
+        struct fuse_file_info * info)
+{
+    FuseBDTLowLevel * self = Self(req);
+    fs::path path;
+    self->GetPath(ino, path);
+
+    int ret = self->bdt_->release(path.string().c_str(), info);
+    fuse_reply_err(req, -ret);
+}
+
+
+void FuseBDTLowLevel::fsync(fuse_req_t req, fuse_ino_t ino, int datasync,
+        struct fuse_file_info * info)
+{
+    FuseBDTLowLevel * self = Self(req);
+    fs::path path;
+    self->GetPath(ino, path);
+
+    int ret = self->bdt_->fsync(path.string().c_str(), datasync, info);
+    fuse_reply_err(req, -ret);
+}
+
+
+void FuseBDTLowLevel::opendir(fuse_req_t req, fuse_ino_t ino,
+        struct fuse_file_info * info)
+{
+    FuseBDTLowLevel * self = Self(req);
+    FuseGetPath(ino,path);
+
+    int ret = self->bdt_->opendir(path.string().c_str(), info);
+    FuseReplyError(ret);
+
+    DirHandle * handle = new DirHandle();
+    handle->dir = info->fh;
+    handle->req = NULL;
+    info->fh = reinterpret_cast<uint64_t>(handle);
+
+    if ( fuse_reply_open(req, info) != 0 ) {
+        info->fh = handle->dir;
+        self->bdt_->releasedir(path.string().c_str(), info);
+        delete handle;
+    }
+}
+
+
+int FuseBDTLowLevel::FillDir(void * buf, const char * name,
+        const struct stat * stbuf, off_t)
+{
+    DirHandle * handle = reinterpret_cast<DirHandle *>(buf);
+
+    struct stat stat;
+    if ( stbuf ) {
+        stat = *stbuf;
+    } else {
+        memset(&stat, 0, sizeof(stat));
+        stat.st_ino = UNKNOWN_INO;
+    }
+
+    size_t offset = handle->buffer.size();
+    size_t size = fuse_add_direntry(handle->req, NULL, 0, name, NULL, 0);
+    handle->buffer.resize(offset + size);
+    fuse_add_direntry( handle->req, &handle->buffer[offset], size,
+            name, &stat, offset + size );
+    return 0;
+}
+
+
+void FuseBDTLowLevel::readdir(fuse_req_t req, fuse_ino_t ino, size_t size,
+        off_t offset, struct fuse_file_info * info)
+{
+    FuseBDTLowLevel * self = Self(req);
+    DirHandle * handle = reinterpret_cast<DirHandle *>(info->fh);
+
+    //  the whole folder is listed on the first call, the following calls
+    //  are served from the buffer with the offset of the next entry
+    if ( offset == 0 ) {
+        fs::path path;
+        self->GetPath(ino, path);
+
+        DIR * dir = reinterpret_cast<DIR *>(handle->dir);
+        ::rewinddir(dir);
+        handle->buffer.clear();
+        handle->req = req;
+
+        struct fuse_file_info infoDir = *info;
+        infoDir.fh = handle->dir;
+        int ret = self->bdt_->readdir( path.string().c_str(),
+                handle, FuseBDTLowLevel::FillDir, 0, &infoDir );
+        handle->req = NULL;
+        FuseReplyError(ret);
+    }
+
+    if ( static_cast<size_t>(offset) < handle->buffer.size() ) {
+        fuse_reply_buf( req, handle->buffer.data() + offset,
+                min( handle->buffer.size() - offset, size ) );
+    } else {
+        fuse_reply_buf(req, NULL, 0);
+    }
+}
+
+
+void FuseBDTLowLevel::releasedir(fuse_req_t req, fuse_ino_t ino,
+        struct fuse_file_info * info)
+{
+    FuseBDTLowLevel * self = Self(req);
+    DirHandle * handle = reinterpret_cast<DirHandle *>(info->fh);
+    fs::path path;
+    self->GetPath(ino, path);
+
+    info->fh = handle->dir;
+    int ret = self->bdt_->releasedir(path.string().c_str(), info);
+    delete handle;
+
+    fuse_reply_err(req, -ret);
+}
+
+
+void FuseBDTLowLevel::fsyncdir(fuse_req_t req, fuse_ino_t,
+        int, struct fuse_file_info *)
+{
+    fuse_reply_err(req, 0);
+}
+
+
+void FuseBDTLowLevel::statfs(fuse_req_t req, fuse_ino_t)
+{
+    FuseBDTLowLevel * self = Self(req);
+
+    struct statvfs stbuf;
+    int ret = self->bdt_->statfs("/", &stbuf);
+    FuseReplyError(ret);
+
+    fuse_reply_statfs(req, &stbuf);
+}
+
+
+void FuseBDTLowLevel::setxattr(fuse_req_t req, fuse_ino_t ino,
+        const char * name, const char * value, size_t size, int flags)
+{
+    FuseBDTLowLevel * self = Self(req);
+    FuseGetPath(ino,path);
+
+    int ret = self->bdt_->setxattr(
+            path.string().c_str(), name, value, size, flags );
+    fuse_reply_err(req, -ret);
+}
+
+
+void FuseBDTLowLevel::getxattr(fuse_req_t req, fuse_ino_t ino,
+        const char * name, size_t size)
+{
+    FuseBDTLowLevel * self = Self(req);
+    FuseGetPath(ino,path);
+
+    if ( size == 0 ) {
+        int ret = self->bdt_->getxattr(path.string().c_str(), name, NULL, 0);
+        FuseReplyError(ret);
+        fuse_reply_xattr(req, ret);
+        return;
+    }
+
+    boost::scoped_array<char> buffer(new char[size]);
+    int ret = self->bdt_->getxattr(
+            path.string().c_str(), name, buffer.get(), size );
+    FuseReplyError(ret);
+    fuse_reply_buf(req, buffer.get(), ret);
+}
+
+
+void FuseBDTLowLevel::listxattr(fuse_req_t req, fuse_ino_t ino, size_t size)
+{
+    FuseBDTLowLevel * self = Self(req);
+    FuseGetPath(ino,path);
+
+    if ( size == 0 ) {
+        int ret = self->bdt_->listxattr(path.string().c_str(), NULL, 0);
+        FuseReplyError(ret);
+        fuse_reply_xattr(req, ret);
+        return;
+    }
+
+    boost::scoped_array<char> buffer(new char[size]);
+    int ret = self->bdt_->listxattr(
+            path.string().c_str(), buffer.get(), size );
+    FuseReplyError(ret);
+    fuse_reply_buf(req, buffer.get(), ret);
+}
+
+
+void FuseBDTLowLevel::removexattr(fuse_req_t req, fuse_ino_t ino,
+        const char * name)
+{
+    FuseBDTLowLevel * self = Self(req);
+    FuseGetPath(ino,path);
+
+    int ret = self->bdt_->removexattr(path.string().c_str(), name);
+    fuse_reply_err(req, -ret);
+}
+
+
+void FuseBDTLowLevel::access(fuse_req_t req, fuse_ino_t ino, int mask)
+{
+    FuseBDTLowLevel * self = Self(req);
+    FuseGetPath(ino,path);
+
+    int ret = self->bdt_->access(path.string().c_str(), mask);
+    fuse_reply_err(req, -ret);
+}
+
+
+void FuseBDTLowLevel::create(fuse_req_t req, fuse_ino_t parent,
+        const char * name, mode_t mode, struct fuse_file_info * info)
+{
+    FuseBDTLowLevel * self = Self(req);
+    fs::path path;
+    if ( ! self->GetPath(parent, name, path) ) {
+        fuse_reply_err(req, ENOENT);
+        return;
+    }
+
+    int ret = self->bdt_->create(path.string().c_str(), mode, info);
+    FuseReplyError(ret);
+    info->direct_io = 1;
+
+    struct fuse_entry_param entry;
+    ret = self->FillEntry(path, entry);
+    if ( ret < 0 ) {
+        self->bdt_->release(path.string().c_str(), info);
+        fuse_reply_err(req, -ret);
+        return;
+    }
+
+    if ( fuse_reply_create(req, &entry, info) != 0 ) {
+        self->inodes_.Forget(entry.ino, 1);
+        self->bdt_->release(path.string().c_str(), info);
+    }
+}
@@ -0,0 +1,106 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * FuseBDTLowLevel.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: agent
+ */
+
+
+#pragma once
+
+
+#include "FuseHeader.h"
+#include <fuse_lowlevel.h>
+#include "bdt/InodeTable.h"
+
+
+class FuseBase;
+
+
+//  Low level fuse frontend of FuseBDT. The kernel talks to us with inode
+//  numbers which are resolved to paths by the InodeTable, every operation
+//  is then forwarded to the path based FuseBDT. Entries and attributes are
+//  cached by the kernel for FuseEntryTimeout / FuseAttrTimeout seconds.
+class FuseBDTLowLevel
+{
+public:
+    FuseBDTLowLevel(FuseBase * bdt);
+
+    ~FuseBDTLowLevel();
+
+    static struct fuse_lowlevel_ops FuseOperations;
+
+private:
+    FuseBase * bdt_;
+    bdt::InodeTable inodes_;
+    double timeoutEntry_;
+    double timeoutAttr_;
+
+    static FuseBDTLowLevel *
+    Self(fuse_req_t req);
+
+    bool
+    GetPath(fuse_ino_t ino, fs::path & path);
+
+    bool
+    GetPath(fuse_ino_t parent, const char * name, fs::path & path);
+
+    int
+    FillEntry(const fs::path & path, struct fuse_entry_param & entry);
+
+    void
+    ReplyEntry(fuse_req_t req, const fs::path & path);
+
+    static void init(void *, struct fuse_conn_info *);
+    static void destroy(void *);
+    static void lookup(fuse_req_t, fuse_ino_t, const char *);
+    static void forget(fuse_req_t, fuse_ino_t, unsigned long);
+    static void getattr(fuse_req_t, fuse_ino_t, struct fuse_file_info *);
+    static void setattr(fuse_req_t, fuse_ino_t, struct stat *, int,
+            struct fuse_file_info *);
+    static void mkdir(fuse_req_t, fuse_ino_t, const char *, mode_t);
+    static void unlink(fuse_req_t, fuse_ino_t, const char *);
+    static void rmdir(fuse_req_t, fuse_ino_t, const char *);
+    static void rename(fuse_req_t, fuse_ino_t, const char *,
+            fuse_ino_t, const char *);
+    static void open(fuse_req_t, fuse_ino_t, struct fuse_file_info *);
+    static void read(fuse_req_t, fuse_ino_t, size_t, off_t,
+            struct fuse_file_info *);
+    static void write(fuse_req_t, fuse_ino_t, const char *, size_t, off_t,
+            struct fuse_file_info *);
+    static void flush(fuse_req_t, fuse_ino_t, struct fuse_file_info *);
+    static void release(fuse_req_t, fuse_ino_t, struct fuse_file_info *);
+    static void fsync(fuse_req_t, fuse_ino_t, int, struct fuse_file_info *);
+    static void opendir(fuse_req_t, fuse_ino_t, struct fuse_file_info *);
+    static void readdir(fuse_req_t, fuse_ino_t, size_t, off_t,
+            struct fuse_file_info *);
+    static void releasedir(fuse_req_t, fuse_ino_t, struct fuse_file_info *);
+    static void fsyncdir(fuse_req_t, fuse_ino_t, int,
+            struct fuse_file_info *);
+    static void statfs(fuse_req_t, fuse_ino_t);
+    static void setxattr(fuse_req_t, fuse_ino_t, const char *, const char *,
+            size_t, int);
+    static void getxattr(fuse_req_t, fuse_ino_t, const char *, size_t);
+    static void listxattr(fuse_req_t, fuse_ino_t, size_t);
+    static void removexattr(fuse_req_t, fuse_ino_t, const char *);
+    static void access(fuse_req_t, fuse_ino_t, int);
+    static void create(fuse_req_t, fuse_ino_t, const char *, mode_t,
+            struct fuse_file_info *);
+
+    static int
+    FillDir(void * buf, const char * name, const struct stat * stbuf,
+            off_t offset);
+};
@@ -23,6 +23,7 @@
 #include "bdt/ServiceServer.h"
 #include "bdt/TapeManagerProxyServer.h"
 #include "bdt/ScheduleProxyServer.h"
+#include "bdt/RpcChannel.h"
 #include "bdt/CacheManager.h"
 #include "bdt/CacheMonitorServer.h"
 
@@ -165,6 +166,10 @@ int main(int argc, char *argv[])
 
 	EventInfo("Service_Start", "System service started.");
 
+#ifdef BDT_DAEMON
+#else
+    map<string,boost::shared_ptr<RpcChannel> > channels;
+#endif
     while(running) {
         sleep(1);
 #ifdef BDT_DAEMON
@@ -173,17 +178,15 @@ int main(int argc, char *argv[])
         string service;
         cin >> command >> service;
 
-        int handle = Factory::SocketClientHandle(
-                ServiceServer::Service + service );
-        if ( handle < 0 ) {
-            cerr << "GetHandle: " << service << endl;
-            continue;
+        boost::shared_ptr<RpcChannel> & channel = channels[service];
+        if ( NULL == channel.get() ) {
+            channel.reset( new RpcChannel(
+                    ServiceServer::Service + service,
+                    1,
+                    Factory::GetConfigure()->GetValueBool(
+                            Configure::RpcChannelBinary) ) );
         }
 
-        xmlrpc_c::clientXmlTransport_pstream transport(
-                xmlrpc_c::clientXmlTransport_pstream::constrOpt()
-                .fd(handle));
-        xmlrpc_c::client_xml client(&transport);
         xmlrpc_c::paramList params;
 
         string method;
@@ -240,6 +243,18 @@ int main(int argc, char *argv[])
                 params.add(xmlrpc_c::value_i8(valve));
             }
             break;
+        case 6:
+            method = ServiceServer::SetThrottle;
+            {
+                int interval;
+                long long valve;
+                string scope;
+                cin >> interval >> valve >> scope;
+                params.add(xmlrpc_c::value_int(interval));
+                params.add(xmlrpc_c::value_i8(valve));
+                params.add(xmlrpc_c::value_string(scope));
+            }
+            break;
         default:
             method = ServiceServer::ReleaseTape;
             params.add(xmlrpc_c::value_string("00000000"));
@@ -247,31 +262,21 @@ int main(int argc, char *argv[])
         }
         cout << "Method: " << method << endl;
 
-        xmlrpc_c::rpc rpc(method,params);
-        xmlrpc_c::carriageParm_pstream carriage;
-
-        try {
-            rpc.call(&client,&carriage);
-        } catch ( std::exception const & e ) {
-            LogError(e.what());
-        }
-        if ( ! rpc.isSuccessful() ) {
-            xmlrpc_c::fault fault = rpc.getFault();
-            LogError(fault.getCode() << ":" << fault.getDescription());
+        xmlrpc_c::value result;
+        if ( ! channel->Call(method,params,result) ) {
+            cerr << "Call: " << service << endl;
         } else {
             try {
-                long long ret = xmlrpc_c::value_i8(rpc.getResult());
+                long long ret = xmlrpc_c::value_i8(result);
                 cout << "Return: " << ret << endl;
             } catch ( std::exception const & e ) {
             }
             try {
-                bool ret = xmlrpc_c::value_boolean(rpc.getResult());
+                bool ret = xmlrpc_c::value_boolean(result);
                 cout << "Return: " << (ret ? "true" : "false") << endl;
             } catch ( std::exception const & e ) {
             }
         }
-
-        close(handle);
 #endif
     }
     EventWarn("Service_Stop", "Stopping system service.");
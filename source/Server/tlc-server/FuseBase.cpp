@@ -150,6 +150,12 @@ int FuseBase::write (const char *path, const char *buf, size_t size, off_t offse
 }
 
 
+int FuseBase::write (const char *path, const char *buf, size_t size, off_t offset, struct fuse_file_info *info, uid_t, pid_t)
+{
+    return write(path, buf, size, offset, info);
+}
+
+
 int FuseBase::statfs (const char *path, struct statvfs *stbuf)
 {
     return -ENOENT;
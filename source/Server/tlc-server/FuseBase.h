@@ -52,6 +52,9 @@ public:
             struct fuse_file_info *);
     virtual int write (const char *, const char *, size_t, off_t,
             struct fuse_file_info *);
+    //  the caller of the low level frontend, which has no fuse context
+    virtual int write (const char *, const char *, size_t, off_t,
+            struct fuse_file_info *, uid_t, pid_t);
     virtual int statfs (const char *, struct statvfs *);
     virtual int flush (const char *, struct fuse_file_info *);
     virtual int release (const char *, struct fuse_file_info *);
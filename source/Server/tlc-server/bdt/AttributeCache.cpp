@@ -0,0 +1,201 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * AttributeCache.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: agent
+ */
+
+
+#include "stdafx.h"
+#include <boost/functional/hash.hpp>
+#include "AttributeCache.h"
+
+
+namespace bdt
+{
+
+    const size_t AttributeCache::ShardCount;
+
+
+    AttributeCache::AttributeCache(size_t capacity, time_t timeout)
+    : capacity_(capacity),
+      capacityShard_((capacity + ShardCount - 1) / ShardCount),
+      timeout_(timeout)
+    {
+        for ( size_t i = 0; i < ShardCount; ++ i ) {
+            shards_[i].version = 0;
+        }
+    }
+
+
+    AttributeCache::~AttributeCache()
+    {
+    }
+
+
+    AttributeCache::Shard &
+    AttributeCache::GetShard(const string & name)
+    {
+        return shards_[ boost::hash<string>()(name) % ShardCount ];
+    }
+
+
+    void
+    AttributeCache::Erase(Shard & shard, MapItemType::iterator i)
+    {
+        shard.lru.erase(i->second.lru);
+        shard.items.erase(i);
+    }
+
+
+    bool
+    AttributeCache::Get(
+            const fs::path & path,
+            InodeAttribute & attribute,
+            unsigned long long & version)
+    {
+        const string name = path.string();
+        Shard & shard = GetShard(name);
+
+        boost::lock_guard<boost::mutex> lock(shard.mutex);
+
+        version = shard.version;
+        if ( capacity_ == 0 ) {
+            return false;
+        }
+
+        MapItemType::iterator i = shard.items.find(name);
+        if ( i == shard.items.end() ) {
+            return false;
+        }
+        if ( i->second.expire <= ::time(NULL) ) {
+            Erase(shard, i);
+            return false;
+        }
+
+        shard.lru.splice(shard.lru.begin(), shard.lru, i->second.lru);
+        attribute = i->second.attribute;
+        return true;
+    }
+
+
+    void
+    AttributeCache::Put(
+            const fs::path & path,
+            const InodeAttribute & attribute,
+            unsigned long long version)
+    {
+        if ( capacity_ == 0 ) {
+            return;
+        }
+
+        const string name = path.string();
+        Shard & shard = GetShard(name);
+
+        boost::lock_guard<boost::mutex> lock(shard.mutex);
+
+        //  invalidated after the attribute was read
+        if ( version != shard.version ) {
+            return;
+        }
+
+        MapItemType::iterator i = shard.items.find(name);
+        if ( i == shard.items.end() ) {
+            while ( shard.items.size() >= capacityShard_ ) {
+                Erase(shard, shard.items.find(shard.lru.back()));
+            }
+            shard.lru.push_front(name);
+            Item item;
+            item.lru = shard.lru.begin();
+            i = shard.items.insert( MapItemType::value_type(
+                    name, item ) ).first;
+        } else {
+            shard.lru.splice(shard.lru.begin(), shard.lru, i->second.lru);
+        }
+
+        i->second.attribute = attribute;
+        i->second.expire = ::time(NULL) + timeout_;
+    }
+
+
+    void
+    AttributeCache::Invalidate(const fs::path & path)
+    {
+        const string name = path.string();
+        Shard & shard = GetShard(name);
+
+        boost::lock_guard<boost::mutex> lock(shard.mutex);
+
+        ++ shard.version;
+        MapItemType::iterator i = shard.items.find(name);
+        if ( i != shard.items.end() ) {
+            Erase(shard, i);
+        }
+    }
+
+
+    void
+    AttributeCache::InvalidateFolder(const fs::path & path)
+    {
+        const string name = path.string();
+        const string prefix = name + "/";
+
+        for ( size_t s = 0; s < ShardCount; ++ s ) {
+            Shard & shard = shards_[s];
+
+            boost::lock_guard<boost::mutex> lock(shard.mutex);
+
+            ++ shard.version;
+            MapItemType::iterator i = shard.items.find(name);
+            if ( i != shard.items.end() ) {
+                Erase(shard, i);
+            }
+            i = shard.items.lower_bound(prefix);
+            while ( i != shard.items.end()
+                    && i->first.compare(0, prefix.size(), prefix) == 0 ) {
+                Erase(shard, i++);
+            }
+        }
+    }
+
+
+    void
+    AttributeCache::Clear()
+    {
+        for ( size_t s = 0; s < ShardCount; ++ s ) {
+            Shard & shard = shards_[s];
+
+            boost::lock_guard<boost::mutex> lock(shard.mutex);
+
+            ++ shard.version;
+            shard.items.clear();
+            shard.lru.clear();
+        }
+    }
+
+
+    size_t
+    AttributeCache::Size()
+    {
+        size_t size = 0;
+        for ( size_t s = 0; s < ShardCount; ++ s ) {
+            boost::lock_guard<boost::mutex> lock(shards_[s].mutex);
+            size += shards_[s].items.size();
+        }
+        return size;
+    }
+
+}
@@ -0,0 +1,116 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * AttributeCache.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: agent
+ */
+
+
+#pragma once
+
+
+#include <list>
+
+
+namespace bdt
+{
+
+    //  Attributes of a meta inode as returned by getattr, st_size is the
+    //  logical size from ATTRIBUTE_SIZE
+    struct InodeAttribute
+    {
+        struct stat stat;
+        long state;
+        Inode::OnlineState online;
+    };
+
+
+    //  Size bounded cache of inode attributes keyed by path. The entries
+    //  are spread over shards with their own lock and LRU list, so lookups
+    //  of different paths do not serialize. Each shard has a version which
+    //  is increased by every invalidation, a Put with a version taken
+    //  before the invalidation is dropped.
+    class AttributeCache
+    {
+    public:
+        AttributeCache(size_t capacity, time_t timeout);
+
+        ~AttributeCache();
+
+        bool
+        Get(const fs::path & path,
+                InodeAttribute & attribute,
+                unsigned long long & version);
+
+        void
+        Put(const fs::path & path,
+                const InodeAttribute & attribute,
+                unsigned long long version);
+
+        void
+        Invalidate(const fs::path & path);
+
+        //  the path and every path below it
+        void
+        InvalidateFolder(const fs::path & path);
+
+        void
+        Clear();
+
+        size_t
+        Size();
+
+        bool
+        IsEnabled()
+        {
+            return capacity_ > 0;
+        }
+
+    private:
+        static const size_t ShardCount = 16;
+
+        typedef list<string> ListPathType;
+
+        struct Item
+        {
+            InodeAttribute attribute;
+            time_t expire;
+            ListPathType::iterator lru;
+        };
+
+        typedef map<string, Item> MapItemType;
+
+        struct Shard
+        {
+            boost::mutex mutex;
+            MapItemType items;
+            ListPathType lru;
+            unsigned long long version;
+        };
+
+        size_t capacity_;
+        size_t capacityShard_;
+        time_t timeout_;
+        Shard shards_[ShardCount];
+
+        Shard &
+        GetShard(const string & name);
+
+        void
+        Erase(Shard & shard, MapItemType::iterator i);
+    };
+
+}
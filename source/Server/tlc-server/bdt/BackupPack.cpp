@@ -0,0 +1,72 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * BackupPack.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+
+
+#include "stdafx.h"
+#include "BackupPack.h"
+
+
+namespace bdt
+{
+
+    BackupPack::BackupPack(
+            const vector<boost::shared_ptr<FileOperationInterface> > &
+                    targets)
+    : targets_(targets), size_(0)
+    {
+    }
+
+
+    BackupPack::~BackupPack()
+    {
+    }
+
+
+    const vector<FileOperationInterface *> &
+    BackupPack::Next()
+    {
+        ranges_.clear();
+        files_.clear();
+        BOOST_FOREACH( boost::shared_ptr<FileOperationInterface> & target,
+                targets_ ) {
+            boost::shared_ptr<FileOperationRange> range(
+                    new FileOperationRange(target,size_,-1) );
+            ranges_.push_back(range);
+            files_.push_back(range.get());
+        }
+        return files_;
+    }
+
+
+    void
+    BackupPack::Finish()
+    {
+        off_t end = 0;
+        BOOST_FOREACH( boost::shared_ptr<FileOperationRange> & range,
+                ranges_ ) {
+            end = max<off_t>( end, range->GetEnd() );
+        }
+        size_ += end;
+        ranges_.clear();
+        files_.clear();
+    }
+
+}
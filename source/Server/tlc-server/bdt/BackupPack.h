@@ -0,0 +1,65 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * BackupPack.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+
+
+#pragma once
+
+
+#include "FileOperationRange.h"
+
+
+namespace bdt
+{
+
+    //  Small files packed into one file on each tape of a backup, one
+    //  after the other. The file on every tape gets the same layout, a
+    //  tape which fails a file leaves a hole and goes on with the next.
+    class BackupPack
+    {
+    public:
+        BackupPack(
+                const vector<boost::shared_ptr<FileOperationInterface> > &
+                        targets);
+
+        ~BackupPack();
+
+        //  the targets of the next file, it starts at GetSize()
+        const vector<FileOperationInterface *> &
+        Next();
+
+        //  the file after goes behind the last byte of any tape
+        void
+        Finish();
+
+        off_t
+        GetSize()
+        {
+            return size_;
+        }
+
+    private:
+        vector<boost::shared_ptr<FileOperationInterface> > targets_;
+        vector<boost::shared_ptr<FileOperationRange> > ranges_;
+        vector<FileOperationInterface *> files_;
+        off_t size_;
+    };
+
+}
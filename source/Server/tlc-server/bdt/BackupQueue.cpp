@@ -0,0 +1,133 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * BackupQueue.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+
+
+
+#include "stdafx.h"
+#include "BackupQueue.h"
+
+
+namespace bdt
+{
+
+    BackupQueue::BackupQueue()
+    {
+    }
+
+
+    BackupQueue::~BackupQueue()
+    {
+    }
+
+
+    void
+    BackupQueue::Push(
+            const fs::path & path,
+            const boost::posix_time::ptime & time)
+    {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+
+        MapTimeType::iterator i = times_.find(path);
+        if ( i != times_.end() ) {
+            pending_.erase( KeyType( i->second, path ) );
+            i->second = time;
+        } else {
+            times_.insert( MapTimeType::value_type( path, time ) );
+        }
+        ready_.erase(path);
+        pending_.insert( KeyType( time, path ) );
+
+        //  the waiter may sleep beyond the new time
+        if ( pending_.begin()->second == path ) {
+            condition_.notify_all();
+        }
+    }
+
+
+    void
+    BackupQueue::Done(const fs::path & path)
+    {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+        ready_.erase(path);
+    }
+
+
+    void
+    BackupQueue::GetReady(vector<fs::path> & paths)
+    {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+
+        Collect( boost::posix_time::microsec_clock::local_time() );
+
+        paths.assign( ready_.begin(), ready_.end() );
+    }
+
+
+    bool
+    BackupQueue::Wait(int timeout)
+    {
+        boost::unique_lock<boost::mutex> lock(mutex_);
+
+        boost::posix_time::ptime now =
+                boost::posix_time::microsec_clock::local_time();
+        boost::posix_time::ptime deadline =
+                now + boost::posix_time::milliseconds(timeout);
+
+        while ( true ) {
+            if ( ! pending_.empty() && pending_.begin()->first <= now ) {
+                Collect(now);
+                return true;
+            }
+            if ( now >= deadline ) {
+                return false;
+            }
+
+            boost::posix_time::ptime wakeup = deadline;
+            if ( ! pending_.empty() && pending_.begin()->first < wakeup ) {
+                wakeup = pending_.begin()->first;
+            }
+            //  the times are local, so wait for a duration
+            condition_.timed_wait(lock, wakeup - now);
+            now = boost::posix_time::microsec_clock::local_time();
+        }
+    }
+
+
+    size_t
+    BackupQueue::Size()
+    {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+        return pending_.size() + ready_.size();
+    }
+
+
+    void
+    BackupQueue::Collect(const boost::posix_time::ptime & now)
+    {
+        while ( ! pending_.empty() && pending_.begin()->first <= now ) {
+            const fs::path & path = pending_.begin()->second;
+            times_.erase(path);
+            ready_.insert(path);
+            pending_.erase(pending_.begin());
+        }
+    }
+
+}
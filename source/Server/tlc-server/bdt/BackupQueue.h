@@ -0,0 +1,75 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * BackupQueue.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+
+
+#pragma once
+
+
+namespace bdt
+{
+
+    //  Files waiting for backup, in the order of the time they are ready.
+    //  A file enters when it is closed after writing, with the time its
+    //  last write ends plus the wait of a file; once that time passes it
+    //  is ready and stays so until it is done. The backup thread sleeps
+    //  until the next file is ready instead of scanning the open files.
+    class BackupQueue
+    {
+    public:
+        BackupQueue();
+
+        ~BackupQueue();
+
+        //  replaces the entry of the path, ready or not
+        void
+        Push(const fs::path & path, const boost::posix_time::ptime & time);
+
+        //  the path is backed up or does not need it any more
+        void
+        Done(const fs::path & path);
+
+        //  the ready paths, including the ones whose time has passed now
+        void
+        GetReady(vector<fs::path> & paths);
+
+        //  waits at most timeout milliseconds for a path to get ready
+        bool
+        Wait(int timeout);
+
+        size_t
+        Size();
+
+    private:
+        typedef pair<boost::posix_time::ptime, fs::path> KeyType;
+        typedef map<fs::path, boost::posix_time::ptime> MapTimeType;
+
+        boost::mutex mutex_;
+        boost::condition_variable condition_;
+
+        set<KeyType> pending_;
+        MapTimeType times_;
+        set<fs::path> ready_;
+
+        void
+        Collect(const boost::posix_time::ptime & now);
+    };
+
+}
@@ -23,7 +23,11 @@
 #include "BackupTapeTask.h"
 #include "CacheManager.h"
 #include "FileOperationTape.h"
+#include "BackupPack.h"
+#include "BackupWriter.h"
 #include "FileMetaParser.h"
+#include "CatalogApplier.h"
+#include "TapeOrderIndex.h"
 #include "../ltfs_management/TapeDbManager.h"
 #include "../lib/common/Common.h"
 
@@ -37,7 +41,8 @@ namespace bdt
     : tape_(Factory::GetTapeManager()),
       cache_(Factory::GetCacheManager()),
       schedule_(Factory::GetSchedule()),
-      meta_(Factory::GetMetaManager())
+      meta_(Factory::GetMetaManager()),
+      folders_(100000)
     {
         uuid_ = Factory::GetService();
         catalogDb_.reset(CatalogDbManager::Instance());
@@ -311,8 +316,8 @@ namespace bdt
             time_t lastCheck = time(NULL);
 
             while(true) {
-                boost::this_thread::sleep( boost::posix_time::seconds(
-                        backupInterval ) );
+                //  a file getting ready wakes the loop before the interval
+                meta_->WaitBackup( backupInterval * 1000 );
                 backupInterval = 1;
                 bool backup = false;
 
@@ -366,8 +371,17 @@ namespace bdt
                         backup = false;
                     }
                     if ( ! backup ) {
+                        //  sleep for the idle time, or less when the wait
+                        //  time of the ready files comes first
                         backupInterval = config->GetValueSize(
                                 Configure::TapeIdleTime );
+                        if ( list.size() > 0 ) {
+                            boost::posix_time::ptime current =
+                                    boost::posix_time::second_clock::local_time();
+                            backupInterval = max( 1, min( backupInterval,
+                                    waitTime - (int)
+                                    (current - backupTime).total_seconds() ) );
+                        }
                         continue;
                     }
                     for(unsigned i = 0; i < list.size(); i++){
@@ -480,6 +494,8 @@ namespace bdt
     {
         try {
             SetBackupTapes(bkTapes, true);
+            // the buffers of the copies are allocated once for the run
+            BackupWriter writer(Factory::GetConfigure()->GetValueSize(Configure::BackupBufferCount));
             while(maxSize > 0L){
                 if ( boost::this_thread::interruption_requested() ) {
                     LogWarn("Interrupt backup");
@@ -493,7 +509,7 @@ namespace bdt
                     break;
                 }
                 try {
-                    ret = Backup(fileItems, bkTapes);
+                    ret = Backup(fileItems, bkTapes, writer);
                 } catch (const std::exception & e) {
                     LogError(e.what());
                     ret = false;
@@ -510,7 +526,7 @@ namespace bdt
 
 
     bool
-    BackupTapeTask::Backup(const vector<BackupItem> &items, const vector<string>& tapes)
+    BackupTapeTask::Backup(const vector<BackupItem> &items, const vector<string>& tapes, BackupWriter& writer)
     {
         int retryTimes = 0;
 
@@ -556,30 +572,47 @@ BackupRetry:
         }
         LogDebug("############# end request tape " << boost::join(tapes, ","));
 
+        // the folders are known only while the tapes are held here
+        BOOST_FOREACH( const string & tape, tapes ) {
+            folders_.Forget(tape);
+        }
+
         unsigned long fileNum = 0;
         off_t sizeFileTotal = 0;
         off_t sizeOnTape = 0;
         map<string, vector<TapeFileInfo> > fileInfoMap;
+        off_t packFileSize = Factory::GetConfigure()->GetValueSize(Configure::BackupPackFileSize);
+        vector<BackupItem> itemsPack;
         for(unsigned int i = 0; i < items.size(); i++){
-            bool bRet = true;
             BackupItem item = items[i];
+            if(packFileSize > 0 && item.size < packFileSize){
+                itemsPack.push_back(item);
+                continue;
+            }
             fs::path pathRelative = item.path;
             string pathSrc = COMM_META_CACHE_PATH + "/" + uuid_ + pathRelative.string();
             auto_ptr<ExtendedAttribute> eaMerge(new ExtendedAttribute(pathSrc));
-            bool bWrittenToTape = false;
+            string pathBackup = "";
+            if(!catalogDb_->GetPathForBackup(boost::lexical_cast<string>(item.number), pathBackup)){
+                LogError("Failed to get backup path for file " << pathRelative.string());
+                boost::unique_lock<boost::mutex> lock(filesMutex_);
+                files_[item.number].running = false;
+                continue;
+            }
+
+            // the copies are written at once, a tape failing does not stop the others
+            vector<boost::shared_ptr<FileOperationInterface> > targets;
+            vector<FileOperationInterface *> files;
+            vector<string> tapesTarget;
+            vector<fs::path> pathsDst;
             BOOST_FOREACH( const string & tape, tapes ) {
-                string dstPath = "";
-                if(!catalogDb_->GetPathForBackup(boost::lexical_cast<string>(item.number), dstPath)){
-                    LogError("Failed to get backup path for file " << pathRelative.string());
-                    bRet = false;
-                    break;
-                }
-                dstPath = COMM_MOUNT_PATH + "/" + tape + "/" + dstPath;
+                string dstPath = COMM_MOUNT_PATH + "/" + tape + "/" + pathBackup;
                 LogDebug("dstPath: " << dstPath);
                 fs::path pathDst = dstPath;
                 if ( fs::exists(pathDst) ) {
                     try {
                         if ( fs::is_directory(pathDst) ) {
+                            folders_.Forget(tape);
                             fs::remove_all(pathDst);
                         } else {
                             LogError(pathDst);
@@ -591,86 +624,267 @@ BackupRetry:
                 }
                 if ( fs::exists(pathDst) ) {
                     LogError(pathDst);
-                    bRet = false;
-                    break;
+                    continue;
                 }
 
                 LogDebug("pathRelative: " << pathRelative.string() << ", pathDst: " << pathDst.string() << ", tape = " << tape);
-                auto_ptr<FileOperationInterface> target;
+                if ( ! folders_.Create(tape, pathDst.parent_path()) ) {
+                    LogError("Failed to create folder of tape file: " << pathDst.string() << ", pathRelative: " << pathRelative.string());
+                    continue;
+                }
+                boost::shared_ptr<FileOperationInterface> target;
                 try{
                     mode_t mode = 0644;
-                    fs::path pFolder = pathDst.parent_path();
-                    string cmd = "mkdir -p " + pFolder.string();
-                    std::system(cmd.c_str());
                     target.reset(new FileOperationTape(pathDst, mode, O_RDWR, tape));
                 }catch(...){
                     LogError("Exception to create tape file: " << pathDst.string() << ", pathRelative: " << pathRelative.string());
-                    bRet = false;
-                    break;
+                    continue;
                 }
-                fs::path pathNew = pathRelative;
-                bool writeTape = false;
-                if(!meta_->Backup(pathRelative, target.get(), tape, pathNew, writeTape)){
+                targets.push_back(target);
+                files.push_back(target.get());
+                tapesTarget.push_back(tape);
+                pathsDst.push_back(pathDst);
+            }
+
+            fs::path pathNew = pathRelative;
+            vector<bool> done;
+            vector<bool> written;
+            bool bRet = false;
+            if ( ! files.empty() ) {
+                bRet = meta_->BackupCopies(writer, pathRelative, files, tapesTarget, pathNew, done, written);
+            }
+            bool bWrittenToTape = false;
+            for(unsigned int t = 0; t < files.size(); t++){
+                const string & tape = tapesTarget[t];
+                const fs::path & pathDst = pathsDst[t];
+                if ( written[t] ) {
+                    bWrittenToTape = true;
+                }
+                if ( ! done[t] ) {
                     LogWarn("Failed to backup file " << pathRelative.string() << " to tape " << tape << ". Dst path: " << pathDst.string());
                     if (fs::exists(pathDst)) {
                         fs::remove(pathDst);
                     }
-                    bRet = false;
-                    if(writeTape == true){
-                        bWrittenToTape = true;
-                    }
-                    break;
-                }else{
-                    LogDebug("Finished backup file " << pathRelative.string() << " to tape" << tape << ". Dst path: " << pathDst.string());
-                    auto_ptr<Inode> inode;
-                    inode.reset(meta_->GetInode(pathRelative));
-                    off_t offset = 0;
-                    auto_ptr<ExtendedAttribute> ea(new ExtendedAttribute(pathDst));
-                    char startblock[1024];
-                    memset(startblock,0,sizeof(startblock));
-                    int valuesize;
-                    if ( ea->GetValue( "user.ltfs.startblock", startblock, sizeof(startblock), valuesize ) ) {
-                        startblock[valuesize] = '\0';
-                        offset = boost::lexical_cast<off_t>(string(startblock));
-                    }
-                    if(!eaMerge->MergeAttrTo(pathDst)){
-                        LogError("Failed to merge Extended Attributes from file " << pathSrc << " to " << pathDst.string());
-                    }
-                    inode->SetBackup(1);
-                    TapeFileInfo fInfo;
-                    fInfo.mUuid = boost::lexical_cast<string>(item.number);
-                    fInfo.mMetaFilePath = pathNew.string();
-                    fInfo.mOffset = offset;
-                    fInfo.mSize = item.size;
-                    if(fileInfoMap.find(tape) == fileInfoMap.end()){
-                        vector<TapeFileInfo> info;
-                        fileInfoMap[tape] = info;
-                    }
-                    fileInfoMap[tape].push_back(fInfo);
-                }//if
-            }//BOOST_FOREACH
-            if(bRet == true){
-                fileNum++;
-                sizeFileTotal += item.size;
-                sizeOnTape += item.size;
-                boost::unique_lock<boost::mutex> lock(filesMutex_);
-                DeleteTapeBackupItem(item);
-            }else{
-                if (bWrittenToTape){
-                    sizeOnTape += item.size;
+                    continue;
                 }
-                boost::unique_lock<boost::mutex> lock(filesMutex_);
-                files_[item.number].running = false;
+                LogDebug("Finished backup file " << pathRelative.string() << " to tape" << tape << ". Dst path: " << pathDst.string());
+                off_t offset = 0;
+                auto_ptr<ExtendedAttribute> ea(new ExtendedAttribute(pathDst));
+                char startblock[1024];
+                memset(startblock,0,sizeof(startblock));
+                int valuesize;
+                if ( ea->GetValue( "user.ltfs.startblock", startblock, sizeof(startblock), valuesize ) ) {
+                    startblock[valuesize] = '\0';
+                    offset = boost::lexical_cast<off_t>(string(startblock));
+                }
+                if(!eaMerge->MergeAttrTo(pathDst)){
+                    LogError("Failed to merge Extended Attributes from file " << pathSrc << " to " << pathDst.string());
+                }
+                TapeFileInfo fInfo;
+                fInfo.mUuid = boost::lexical_cast<string>(item.number);
+                fInfo.mMetaFilePath = pathNew.string();
+                fInfo.mOffset = offset;
+                fInfo.mSize = item.size;
+                if(fileInfoMap.find(tape) == fileInfoMap.end()){
+                    vector<TapeFileInfo> info;
+                    fileInfoMap[tape] = info;
+                }
+                fileInfoMap[tape].push_back(fInfo);
             }
+            FinishBackupItem(item, bRet, bWrittenToTape, fileNum, sizeFileTotal, sizeOnTape);
         }//for
+        if(!itemsPack.empty()){
+            BackupPackedFiles(itemsPack, tapes, writer, fileInfoMap, fileNum, sizeFileTotal, sizeOnTape);
+        }
         if ( ! tape_->SetTapesUse(tapes, fileNum, sizeFileTotal, sizeOnTape) ) {
             LogWarn(stringTapes);
         }
+        AddTapeFiles(fileInfoMap);
+
+        return true;
+    }
+
+
+    void
+    BackupTapeTask::AddTapeFiles(map<string, vector<TapeFileInfo> >& fileInfoMap)
+    {
+        TapeOrderIndex * index = Factory::GetTapeOrderIndex();
+        if(index != NULL){
+            for(map<string, vector<TapeFileInfo> >::iterator it = fileInfoMap.begin(); it != fileInfoMap.end(); it++){
+                BOOST_FOREACH(const TapeFileInfo & info, it->second){
+                    TapeOrderItem item;
+                    item.block = info.mOffset;
+                    item.number = boost::lexical_cast<unsigned long long>(info.mUuid);
+                    item.size = info.mSize;
+                    index->Add(it->first, item);
+                }
+            }
+        }
+
+        // the journal takes the files while the catalog is slow or away, the
+        // tapes keep on streaming
+        CatalogJournal * journal = Factory::GetCatalogJournal();
+        if(journal != NULL){
+            CatalogRecord record;
+            CatalogApplier::SetFiles(uuid_, fileInfoMap, record);
+            if(journal->Append(record)){
+                return;
+            }
+
+            // the records still pending for these files or tapes would
+            // overwrite the rows written directly once applied
+            static const int flushTimeout = 5 * 1000;
+            bool flushed = true;
+            for(map<string, vector<TapeFileInfo> >::iterator it = fileInfoMap.begin(); flushed && it != fileInfoMap.end(); it++){
+                flushed = journal->FlushTape(flushTimeout, it->first);
+                for(unsigned int i = 0; flushed && i < it->second.size(); i++){
+                    flushed = journal->FlushFile(flushTimeout, it->second[i].mUuid);
+                }
+            }
+            if(!flushed){
+                LogError("Failed to add files to the catalog, " << journal->GetPending() << " changes are pending.");
+                return;
+            }
+            LogWarn("Files go to the catalog directly.");
+        }
         if(!catalogDb_->AddTapeFiles(uuid_, fileInfoMap)){
             LogError("Failed to add files to database.");
         }
+    }
 
-        return true;
+
+    void
+    BackupTapeTask::BackupPackedFiles(const vector<BackupItem> &items, const vector<string>& tapes, BackupWriter& writer, map<string, vector<TapeFileInfo> >& fileInfoMap, unsigned long& fileNum, off_t& sizeFileTotal, off_t& sizeOnTape)
+    {
+        static off_t packSize = Factory::GetConfigure()->GetValueSize(Configure::BackupPackSize);
+
+        unsigned int next = 0;
+        while(next < items.size()){
+            if ( boost::this_thread::interruption_requested() ) {
+                break;
+            }
+
+            // one pack file on every tape, named after the first file in it
+            string pathPack = "pack/" + boost::posix_time::to_iso_string(boost::posix_time::microsec_clock::local_time())
+                    + "-" + boost::lexical_cast<string>(items[next].number);
+            vector<boost::shared_ptr<FileOperationInterface> > targets;
+            vector<string> tapesTarget;
+            vector<fs::path> pathsDst;
+            BOOST_FOREACH( const string & tape, tapes ) {
+                fs::path pathDst = COMM_MOUNT_PATH + "/" + tape + "/" + pathPack;
+                if ( ! folders_.Create(tape, pathDst.parent_path()) ) {
+                    LogError("Failed to create folder of pack file: " << pathDst.string());
+                    continue;
+                }
+                boost::shared_ptr<FileOperationInterface> target;
+                try{
+                    target.reset(new FileOperationTape(pathDst, 0644, O_RDWR, tape));
+                }catch(...){
+                    LogError("Exception to create pack file: " << pathDst.string());
+                    continue;
+                }
+                targets.push_back(target);
+                tapesTarget.push_back(tape);
+                pathsDst.push_back(pathDst);
+            }
+            if(targets.empty()){
+                break;
+            }
+
+            // the extended attributes of the files are not kept on tape for a pack
+            vector<vector<TapeFileInfo> > infos(targets.size());
+            {
+                BackupPack pack(targets);
+                for( ; next < items.size() && pack.GetSize() < packSize; next++){
+                    if ( boost::this_thread::interruption_requested() ) {
+                        break;
+                    }
+                    const BackupItem & item = items[next];
+                    off_t position = pack.GetSize();
+                    fs::path pathNew = item.path;
+                    vector<bool> done;
+                    vector<bool> written;
+                    bool bRet = meta_->BackupCopies(writer, item.path, pack.Next(), tapesTarget, pathNew, done, written);
+                    pack.Finish();
+                    bool bWrittenToTape = false;
+                    for(unsigned int t = 0; t < targets.size(); t++){
+                        if ( written[t] ) {
+                            bWrittenToTape = true;
+                        }
+                        if ( ! done[t] ) {
+                            LogWarn("Failed to pack file " << item.path.string() << " to tape " << tapesTarget[t] << ". Pack: " << pathPack);
+                            continue;
+                        }
+                        TapeFileInfo fInfo;
+                        fInfo.mUuid = boost::lexical_cast<string>(item.number);
+                        fInfo.mMetaFilePath = pathNew.string();
+                        fInfo.mOffset = 0;
+                        fInfo.mSize = item.size;
+                        fInfo.mPack = pathPack;
+                        fInfo.mPosition = position;
+                        infos[t].push_back(fInfo);
+                    }
+                    FinishBackupItem(item, bRet, bWrittenToTape, fileNum, sizeFileTotal, sizeOnTape);
+                }
+                LogInfo("Packed " << pathPack << ", size: " << pack.GetSize());
+            }
+            targets.clear();
+
+            // the files of a pack share its start block
+            for(unsigned int t = 0; t < tapesTarget.size(); t++){
+                const fs::path & pathDst = pathsDst[t];
+                if(infos[t].empty()){
+                    if (fs::exists(pathDst)) {
+                        fs::remove(pathDst);
+                    }
+                    continue;
+                }
+                off_t offset = 0;
+                auto_ptr<ExtendedAttribute> ea(new ExtendedAttribute(pathDst));
+                char startblock[1024];
+                memset(startblock,0,sizeof(startblock));
+                int valuesize;
+                if ( ea->GetValue( "user.ltfs.startblock", startblock, sizeof(startblock), valuesize ) ) {
+                    startblock[valuesize] = '\0';
+                    offset = boost::lexical_cast<off_t>(string(startblock));
+                }
+                vector<TapeFileInfo> & info = fileInfoMap[tapesTarget[t]];
+                BOOST_FOREACH( TapeFileInfo & fInfo, infos[t] ) {
+                    fInfo.mOffset = offset;
+                    info.push_back(fInfo);
+                }
+            }
+        }
+
+        // the files left are tried again with the next backup
+        boost::unique_lock<boost::mutex> lock(filesMutex_);
+        for( ; next < items.size(); next++){
+            files_[items[next].number].running = false;
+        }
+    }
+
+
+    void
+    BackupTapeTask::FinishBackupItem(const BackupItem & item, bool bDone, bool bWrittenToTape, unsigned long& fileNum, off_t& sizeFileTotal, off_t& sizeOnTape)
+    {
+        if(bDone == true){
+            auto_ptr<Inode> inode;
+            inode.reset(meta_->GetInode(item.path));
+            if ( inode.get() != NULL ) {
+                inode->SetBackup(1);
+            }
+            fileNum++;
+            sizeFileTotal += item.size;
+            sizeOnTape += item.size;
+            boost::unique_lock<boost::mutex> lock(filesMutex_);
+            DeleteTapeBackupItem(item);
+        }else{
+            if (bWrittenToTape){
+                sizeOnTape += item.size;
+            }
+            boost::unique_lock<boost::mutex> lock(filesMutex_);
+            files_[item.number].running = false;
+        }
     }
 
 }
@@ -22,6 +22,7 @@
 #pragma once
 #include "MetaManager.h"
 #include "FileMetaParser.h"
+#include "TapeFolder.h"
 #include "../ltfs_management/CatalogDbManager.h"
 using namespace ltfs_management;
 
@@ -99,7 +100,10 @@ namespace bdt
     private:
         void StartBackupSub(const vector<string>& bkTapes, off_t maxSize);
         void HandleBackupSub(const vector<string>& bkTapes, off_t maxSize);
-        bool Backup(const vector<BackupItem> &items, const vector<string>& tapes);
+        bool Backup(const vector<BackupItem> &items, const vector<string>& tapes, BackupWriter& writer);
+        void BackupPackedFiles(const vector<BackupItem> &items, const vector<string>& tapes, BackupWriter& writer, map<string, vector<TapeFileInfo> >& fileInfoMap, unsigned long& fileNum, off_t& sizeFileTotal, off_t& sizeOnTape);
+        void AddTapeFiles(map<string, vector<TapeFileInfo> >& fileInfoMap);
+        void FinishBackupItem(const BackupItem & item, bool bDone, bool bWrittenToTape, unsigned long& fileNum, off_t& sizeFileTotal, off_t& sizeOnTape);
         void SetBackupTapes(const vector<string>& bkTapes, bool bRunning);
         int GetRunningNum();
         bool IsTapesRunning(const vector<string>& tapes);
@@ -120,6 +124,7 @@ namespace bdt
         string				uuid_;
         auto_ptr<CatalogDbManager> catalogDb_;
         FileMetaParser      parser_;
+        TapeFolder          folders_;
     };
 
 }
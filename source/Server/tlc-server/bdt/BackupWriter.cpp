@@ -0,0 +1,232 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * BackupWriter.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+
+
+#include "stdafx.h"
+#include "BackupWriter.h"
+
+
+namespace bdt
+{
+
+    const size_t BackupWriter::ChunkSize;
+
+
+    BackupWriter::BackupWriter(size_t buffers, size_t bufsize)
+    : buffers_(max<size_t>(buffers,1)), bufsize_(bufsize),
+      produced_(0), end_(false), abort_(false)
+    {
+        memory_.reset(new char[buffers_ * bufsize_]);
+    }
+
+
+    BackupWriter::~BackupWriter()
+    {
+    }
+
+
+    bool
+    BackupWriter::Copy(
+            FileOperationInterface * source,
+            const vector<FileOperationInterface *> & targets,
+            const boost::function<bool ()> & check,
+            vector<bool> & done,
+            vector<bool> & written,
+            off_t & size)
+    {
+        {
+            boost::lock_guard<boost::mutex> lock(mutex_);
+            targets_.clear();
+            BOOST_FOREACH( FileOperationInterface * file, targets ) {
+                Target target;
+                target.file = file;
+                target.next = 0;
+                target.failed = false;
+                target.written = false;
+                targets_.push_back(target);
+            }
+            Slot slot;
+            slot.offset = 0;
+            slot.size = 0;
+            slot.pending = 0;
+            slots_.assign(buffers_,slot);
+            produced_ = 0;
+            end_ = false;
+            abort_ = false;
+        }
+
+        boost::thread_group writers;
+        for ( size_t i = 0; i < targets.size(); ++ i ) {
+            writers.create_thread(
+                    boost::bind( &BackupWriter::WriteTask, this, i ) );
+        }
+
+        bool complete = false;
+        try {
+            complete = Read(source,check,size);
+        } catch ( ... ) {
+            {
+                boost::lock_guard<boost::mutex> lock(mutex_);
+                abort_ = true;
+            }
+            condition_.notify_all();
+            writers.join_all();
+            throw;
+        }
+
+        {
+            boost::lock_guard<boost::mutex> lock(mutex_);
+            if ( complete ) {
+                end_ = true;
+            } else {
+                abort_ = true;
+            }
+        }
+        condition_.notify_all();
+        writers.join_all();
+
+        bool ret = false;
+        done.assign(targets_.size(),false);
+        written.assign(targets_.size(),false);
+        for ( size_t i = 0; i < targets_.size(); ++ i ) {
+            done[i] = complete && ! targets_[i].failed;
+            written[i] = targets_[i].written;
+            ret = ret || done[i];
+        }
+        return ret;
+    }
+
+
+    bool
+    BackupWriter::Read(
+            FileOperationInterface * source,
+            const boost::function<bool ()> & check,
+            off_t & size)
+    {
+        size = 0;
+        while ( true ) {
+            size_t slot;
+            {
+                boost::unique_lock<boost::mutex> lock(mutex_);
+                slot = produced_ % buffers_;
+                while ( slots_[slot].pending > 0 ) {
+                    condition_.wait(lock);
+                }
+                if ( GetActive() == 0 ) {
+                    LogWarn("No target is left");
+                    return false;
+                }
+            }
+
+            if ( ! check() ) {
+                return false;
+            }
+            char * buffer = memory_.get() + slot * bufsize_;
+            size_t sizeRead;
+            if ( ! source->Read(size,buffer,bufsize_,sizeRead) ) {
+                LogError("Fails to read at " << size);
+                return false;
+            }
+            if ( sizeRead == 0 ) {
+                return true;
+            }
+
+            {
+                boost::lock_guard<boost::mutex> lock(mutex_);
+                slots_[slot].offset = size;
+                slots_[slot].size = sizeRead;
+                slots_[slot].pending = GetActive();
+                ++ produced_;
+            }
+            condition_.notify_all();
+            size += sizeRead;
+        }
+    }
+
+
+    void
+    BackupWriter::WriteTask(size_t number)
+    {
+        boost::unique_lock<boost::mutex> lock(mutex_);
+        Target & target = targets_[number];
+
+        while ( true ) {
+            while ( target.next == produced_ && ! end_ && ! abort_ ) {
+                condition_.wait(lock);
+            }
+            if ( abort_ || target.next == produced_ ) {
+                return;
+            }
+
+            size_t index = target.next % buffers_;
+            Slot & slot = slots_[index];
+            off_t offset = slot.offset;
+            size_t size = slot.size;
+            char * buffer = memory_.get() + index * bufsize_;
+            //  a failed write may have used space on the tape already
+            target.written = true;
+
+            lock.unlock();
+
+            bool ret = true;
+            for ( size_t done = 0; done < size; ) {
+                size_t sizeWritten;
+                if ( ! target.file->Write( offset + done,
+                        buffer + done, size - done, sizeWritten )
+                        || sizeWritten == 0 ) {
+                    LogError("Fails to write at " << offset + done);
+                    ret = false;
+                    break;
+                }
+                done += sizeWritten;
+            }
+
+            lock.lock();
+
+            if ( ! ret ) {
+                //  the chunks it still holds are not waited for
+                target.failed = true;
+                for ( size_t i = target.next; i < produced_; ++ i ) {
+                    -- slots_[i % buffers_].pending;
+                }
+                condition_.notify_all();
+                return;
+            }
+            -- slot.pending;
+            ++ target.next;
+            condition_.notify_all();
+        }
+    }
+
+
+    size_t
+    BackupWriter::GetActive()
+    {
+        size_t active = 0;
+        BOOST_FOREACH( const Target & target, targets_ ) {
+            if ( ! target.failed ) {
+                ++ active;
+            }
+        }
+        return active;
+    }
+
+}
@@ -0,0 +1,99 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * BackupWriter.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+
+
+#pragma once
+
+
+namespace bdt
+{
+
+    //  Copies a cache file to all the tapes of a backup at once. Every
+    //  chunk is read once and written to each tape on a thread of its
+    //  own, a tape runs ahead of the slowest one by at most the number of
+    //  buffers. A tape which fails is dropped and the others go on.
+    class BackupWriter
+    {
+    public:
+        //  the size of a chunk read from the cache file
+        static const size_t ChunkSize = 512 * 1024;
+
+        //  the buffers are kept for all the copies of the writer, a backup
+        //  run copies all its files with one writer
+        BackupWriter(size_t buffers, size_t bufsize = ChunkSize);
+
+        ~BackupWriter();
+
+        //  check is called before each chunk is read, the copy stops when
+        //  it fails; done tells the targets holding the whole source and
+        //  written the ones which got any of it. false if no target is
+        //  done.
+        bool
+        Copy(
+                FileOperationInterface * source,
+                const vector<FileOperationInterface *> & targets,
+                const boost::function<bool ()> & check,
+                vector<bool> & done,
+                vector<bool> & written,
+                off_t & size);
+
+    private:
+        struct Target
+        {
+            FileOperationInterface * file;
+            size_t next;
+            bool failed;
+            bool written;
+        };
+
+        struct Slot
+        {
+            off_t offset;
+            size_t size;
+            size_t pending;
+        };
+
+        size_t buffers_;
+        size_t bufsize_;
+        boost::scoped_array<char> memory_;
+
+        boost::mutex mutex_;
+        boost::condition_variable condition_;
+        vector<Target> targets_;
+        vector<Slot> slots_;
+        size_t produced_;
+        bool end_;
+        bool abort_;
+
+        bool
+        Read(
+                FileOperationInterface * source,
+                const boost::function<bool ()> & check,
+                off_t & size);
+
+        void
+        WriteTask(size_t number);
+
+        size_t
+        GetActive();
+    };
+
+}
@@ -20,18 +20,57 @@
 
 
 #include "stdafx.h"
+
+#include <limits>
+
 #include "Bitmap.h"
 
 
 namespace bdt
 {
 
-    Bitmap::Bitmap(BitmapIO * io, size_t sizeBlock)
-    : io_(io), sizeBlock_(sizeBlock), bitmap_(new char[LENGTH_BITMAP]()),
-      begin_(-1), end_(-1), length_(0), dirty_(false)
+    //  first word of a saved run list, a plain bitmap starts with the block
+    //  size instead
+    static const unsigned long MAGIC_RUNS = 0x736e75722e746462UL;
+
+    static const off_t BLOCK_MAX = numeric_limits<off_t>::max();
+
+
+    static void
+    PutVarint(vector<unsigned char> & buffer,unsigned long long value)
+    {
+        while ( value >= 0x80 ) {
+            buffer.push_back( (unsigned char)(value | 0x80) );
+            value >>= 7;
+        }
+        buffer.push_back( (unsigned char)value );
+    }
+
+
+    static bool
+    GetVarint(const unsigned char * & buffer,const unsigned char * end,
+            unsigned long long & value)
+    {
+        value = 0;
+        for ( int shift = 0; buffer < end && shift < 64; shift += 7 ) {
+            unsigned char byte = * buffer ++;
+            value |= (unsigned long long)(byte & 0x7f) << shift;
+            if ( (byte & 0x80) == 0 ) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+
+    Bitmap::Bitmap(BitmapIO * io, size_t sizeBlock,
+            int saveBlocks, int saveInterval)
+    : io_(io), sizeBlock_(sizeBlock),
+      begin_(-1), end_(-1), length_(0), dirty_(false),
+      saveBlocks_(saveBlocks), saveInterval_(saveInterval), dirtyBlocks_(0)
     {
         OpenBitmap();
-        * reinterpret_cast<typeof(sizeBlock_) *>(bitmap_.get()) = sizeBlock_;
+        lengthSaved_ = length_;
     }
 
 
@@ -56,13 +95,102 @@ namespace bdt
         if ( ! io_->GetBitmap(NULL,size) ) {
             return false;
         }
-        if ( size > LENGTH_BITMAP ) {
+        if ( size < (int)sizeof(sizeBlock_) || size > LENGTH_BITMAP ) {
             return false;
         }
-        if ( ! io_->GetBitmap(bitmap_.get(),size) ) {
+        boost::scoped_array<unsigned char> buffer(new unsigned char[size]);
+        if ( ! io_->GetBitmap(buffer.get(),size) ) {
             return false;
         }
-        sizeBlock_ = * reinterpret_cast<typeof(sizeBlock_) *>(bitmap_.get());
+
+        typeof(sizeBlock_) head = 0;
+        memcpy(&head,buffer.get(),sizeof(head));
+        bool ret;
+        if ( head == MAGIC_RUNS ) {
+            ret = LoadRuns(buffer.get(),size);
+        } else {
+            ret = LoadBits(buffer.get(),size);
+        }
+        if ( ! ret ) {
+            LogWarn("invalid bitmap of " << size << " bytes");
+            runs_.clear();
+        }
+        return ret;
+    }
+
+
+    bool
+    Bitmap::LoadRuns(const unsigned char * buffer,int size)
+    {
+        const unsigned char * end = buffer + size;
+        buffer += sizeof(MAGIC_RUNS);
+        if ( end - buffer < (int)sizeof(sizeBlock_) ) {
+            return false;
+        }
+        memcpy(&sizeBlock_,buffer,sizeof(sizeBlock_));
+        buffer += sizeof(sizeBlock_);
+
+        off_t block = 0;
+        while ( buffer < end ) {
+            unsigned long long gap = 0;
+            unsigned long long count = 0;
+            if ( ! GetVarint(buffer,end,gap)
+                    || ! GetVarint(buffer,end,count) ) {
+                return false;
+            }
+            if ( gap > (unsigned long long)(BLOCK_MAX - block) ) {
+                return false;
+            }
+            block += gap;
+            if ( count > (unsigned long long)(BLOCK_MAX - block) ) {
+                return false;
+            }
+            SetRange(block,block + count,true);
+            block += count;
+        }
+        return true;
+    }
+
+
+    bool
+    Bitmap::LoadBits(const unsigned char * buffer,int size)
+    {
+        memcpy(&sizeBlock_,buffer,sizeof(sizeBlock_));
+        buffer += sizeof(sizeBlock_);
+        size -= sizeof(sizeBlock_);
+
+        off_t first = -1;
+        for ( int i = 0; i < size; ++ i ) {
+            off_t block = (off_t)i * 8;
+            if ( buffer[i] == 0xff ) {
+                if ( first < 0 ) {
+                    first = block;
+                }
+                continue;
+            }
+            if ( buffer[i] == 0 ) {
+                if ( first >= 0 ) {
+                    SetRange(first,block,true);
+                    first = -1;
+                }
+                continue;
+            }
+            for ( int bit = 0; bit < 8; ++ bit ) {
+                if ( buffer[i] & (1 << bit) ) {
+                    if ( first < 0 ) {
+                        first = block + bit;
+                    }
+                } else if ( first >= 0 ) {
+                    SetRange(first,block + bit,true);
+                    first = -1;
+                }
+            }
+        }
+        if ( first >= 0 ) {
+            SetRange(first,(off_t)size * 8,true);
+        }
+        //  saved in the new format on the next save
+        dirty_ = true;
         return true;
     }
 
@@ -130,6 +258,7 @@ namespace bdt
         GetBitmap(3 * sizeBlock_,mark3);
         LogDebug( "block: " << sizeBlock_ << " length: " << length_
                 << " begin: " << begin_ << " end: " << end_
+                << " runs: " << runs_.size()
                 << " bitmap: " << mark0 << mark1 << mark2 << mark3 );
     }
 
@@ -137,31 +266,91 @@ namespace bdt
     void
     Bitmap::GetBitmap(off_t offset,bool & mark)
     {
-        int offsetBlock = offset / sizeBlock_;
-        int offsetByte = offsetBlock / 8 + sizeof(sizeBlock_);
-        int offsetBit = offsetBlock % 8;
-
-        mark = (bitmap_[offsetByte] & (1 << offsetBit)) ? true : false;
+        off_t block = offset / (off_t)sizeBlock_;
+        mark = CheckRange(block,block + 1);
     }
 
 
     void
     Bitmap::SetBitmap(off_t offset,bool mark)
     {
-        int offsetBlock = offset / sizeBlock_;
-        int offsetByte = offsetBlock / 8 + sizeof(sizeBlock_);
-        int offsetBit = offsetBlock % 8;
+        off_t block = offset / (off_t)sizeBlock_;
+        SetRange(block,block + 1,mark);
+    }
+
+
+    void
+    Bitmap::SetRange(off_t first,off_t last,bool mark)
+    {
+        if ( first >= last ) {
+            return;
+        }
 
-        unsigned char mask = 1 << offsetBit;
-        unsigned char old = bitmap_[offsetByte];
+        MapRunType::iterator i = runs_.upper_bound(first);
         if ( mark ) {
-            bitmap_[offsetByte] |= mask;
-        } else {
-            bitmap_[offsetByte] &= (~mask);
+            off_t end = last;
+            if ( i != runs_.begin() ) {
+                MapRunType::iterator prev = i;
+                -- prev;
+                if ( prev->second >= first ) {
+                    if ( prev->second >= last ) {
+                        return;
+                    }
+                    first = prev->first;
+                    i = prev;
+                }
+            }
+            //  swallow the runs overlapping or touching [first,last)
+            while ( i != runs_.end() && i->first <= last ) {
+                end = max(end,i->second);
+                runs_.erase(i ++);
+            }
+            runs_[first] = end;
+            dirty_ = true;
+            return;
+        }
+
+        if ( i != runs_.begin() ) {
+            MapRunType::iterator prev = i;
+            -- prev;
+            if ( prev->second > first ) {
+                off_t end = prev->second;
+                if ( prev->first < first ) {
+                    prev->second = first;
+                } else {
+                    runs_.erase(prev);
+                }
+                dirty_ = true;
+                if ( end > last ) {
+                    runs_[last] = end;
+                    return;
+                }
+            }
         }
-        if ( bitmap_[offsetByte] != old ) {
+        while ( i != runs_.end() && i->first < last ) {
+            off_t end = i->second;
+            runs_.erase(i ++);
             dirty_ = true;
+            if ( end > last ) {
+                runs_[last] = end;
+                return;
+            }
+        }
+    }
+
+
+    bool
+    Bitmap::CheckRange(off_t first,off_t last)
+    {
+        if ( first >= last ) {
+            return true;
         }
+        MapRunType::iterator i = runs_.upper_bound(first);
+        if ( i == runs_.begin() ) {
+            return false;
+        }
+        -- i;
+        return i->second >= last;
     }
 
 
@@ -172,21 +361,85 @@ namespace bdt
             return false;
         }
 
-        if ( (! force) && (! dirty_) ) {
+        if ( (! force) && ( (! dirty_) || (! IsSaveDue()) ) ) {
             return true;
         }
 
-        int size = sizeof(sizeBlock_);
-        size += (length_ + sizeBlock_ * 8 - 1) / (sizeBlock_ * 8);
-        for ( int i = 1; i < 8; ++ i ) {
-            SetBitmap(length_ + sizeBlock_ * i - 1, false);
-        }
-        memset(bitmap_.get() + size, 0, LENGTH_BITMAP - size);
+        off_t sizeBlock = sizeBlock_;
+        SetRange((length_ + sizeBlock - 1) / sizeBlock, BLOCK_MAX, false);
 
         if ( io_ == NULL ) {
+            SetSaved();
             return true;
         }
-        return io_->SetBitmap(bitmap_.get(),size) && io_->SetLength(length_);
+
+        //  the marks of a batch may outlive the page cache of their data,
+        //  one fdatasync per batch keeps a saved mark behind its data
+        bool batched = saveBlocks_ > 0 || saveInterval_ > 0;
+        if ( batched && dirtyBlocks_ > 0 && ! io_->SyncData() ) {
+            LogWarn("sync " << errno);
+            return false;
+        }
+
+        vector<unsigned char> buffer(sizeof(MAGIC_RUNS) + sizeof(sizeBlock_));
+        memcpy(&buffer[0],&MAGIC_RUNS,sizeof(MAGIC_RUNS));
+        memcpy(&buffer[sizeof(MAGIC_RUNS)],&sizeBlock_,sizeof(sizeBlock_));
+        off_t block = 0;
+        for ( MapRunType::iterator i = runs_.begin(); i != runs_.end(); ++ i ) {
+            size_t size = buffer.size();
+            PutVarint(buffer,i->first - block);
+            PutVarint(buffer,i->second - i->first);
+            if ( buffer.size() > LENGTH_BITMAP ) {
+                //  the runs left out are recalled again after reopen
+                LogWarn(runs_.size() << " runs do not fit in the bitmap");
+                buffer.resize(size);
+                break;
+            }
+            block = i->second;
+        }
+
+        if ( ! io_->SetBitmap(&buffer[0],buffer.size()) ) {
+            return false;
+        }
+        //  the length goes after the bitmap, a new length with the old
+        //  bitmap could take the last block of the old length as full
+        if ( length_ != lengthSaved_ && ! io_->SetLength(length_) ) {
+            return false;
+        }
+        SetSaved();
+        return true;
+    }
+
+
+    bool
+    Bitmap::IsSaveDue()
+    {
+        if ( saveBlocks_ <= 0 && saveInterval_ <= 0 ) {
+            return true;
+        }
+        if ( saveBlocks_ > 0 && dirtyBlocks_ >= saveBlocks_ ) {
+            return true;
+        }
+        if ( saveInterval_ <= 0 ) {
+            return false;
+        }
+        boost::posix_time::ptime now =
+                boost::posix_time::microsec_clock::universal_time();
+        if ( dirtyTime_.is_not_a_date_time() ) {
+            dirtyTime_ = now;
+        }
+        return now - dirtyTime_
+                >= boost::posix_time::milliseconds(saveInterval_);
+    }
+
+
+    void
+    Bitmap::SetSaved()
+    {
+        dirty_ = false;
+        dirtyBlocks_ = 0;
+        dirtyTime_ = boost::posix_time::not_a_date_time;
+        lengthSaved_ = length_;
     }
 
 
@@ -216,6 +469,7 @@ namespace bdt
                 begin_ = end_;
                 if ( end_ > length_ ) {
                     length_ = end_;
+                    dirty_ = true;
                 }
                 //LogDebug(begin_ << " " << end_ << " " << length_);
                 return;
@@ -223,15 +477,25 @@ namespace bdt
             //LogDebug(begin_ << " " << end_ << " " << length_);
         }
 
-        for ( ; (off_t)(begin_ + sizeBlock_) <= end_; begin_ += sizeBlock_ ) {
-            //LogDebug(begin_ << " " << end_ << " " << length_);
-            SetBitmap(begin_,true);
+        off_t sizeBlock = sizeBlock_;
+        if ( begin_ / sizeBlock < end_ / sizeBlock ) {
+            SetRange( begin_ / sizeBlock, end_ / sizeBlock, true );
+            dirtyBlocks_ += end_ / sizeBlock - begin_ / sizeBlock;
+            begin_ = (end_ / sizeBlock) * sizeBlock;
         }
 
         if ( end_ >= length_ ) {
-            length_ = end_;
+            if ( end_ > length_ ) {
+                length_ = end_;
+                dirty_ = true;
+            }
             //LogDebug(begin_ << " " << end_ << " " << length_);
-            SetBitmap( length_ - 1, true );
+            bool mark = false;
+            GetBitmap( length_ - 1, mark );
+            if ( ! mark ) {
+                SetBitmap( length_ - 1, true );
+                ++ dirtyBlocks_;
+            }
         }
     }
 
@@ -243,18 +507,12 @@ namespace bdt
             return true;
         }
         off_t end = offset + size;
-        offset = (offset / sizeBlock_) * sizeBlock_;
-        for ( ; offset < end; offset  += sizeBlock_ ) {
-            bool mark = false;
-            GetBitmap(offset,mark);
-            if ( ! mark ) {
-                return false;
-            }
-        }
         if ( length_ < end ) {
             return false;
         }
-        return true;
+        off_t sizeBlock = sizeBlock_;
+        return CheckRange( offset / sizeBlock,
+                (end + sizeBlock - 1) / sizeBlock );
     }
 
 
@@ -264,4 +522,3 @@ namespace bdt
         return CheckBitmap(0,length_);
     }
 }
-
@@ -36,13 +36,32 @@ namespace bdt
         virtual bool GetBitmap(void * buffer,int & size) = 0;
 
         virtual bool SetBitmap(const void * buffer,int size) = 0;
+
+        //  makes the written data durable before a batched save marks it
+        virtual bool SyncData()
+        {
+            return true;
+        }
     };
 
 
+    //  Tracks which blocks of a cache file are present as runs of blocks,
+    //  so the file size is not limited by the size of the attribute and a
+    //  range is checked with one lookup. The runs are saved as varints of
+    //  the gap and the length of each run, behind a magic number; bitmaps
+    //  saved as plain bit arrays by older versions are still loaded.
+    //
+    //  Marked blocks are saved once saveBlocks of them are pending or the
+    //  oldest pending change is saveInterval milliseconds old, 0 turns the
+    //  limit off and with both 0 every change is saved at once. A block is
+    //  only marked after its data is written, and a batched save syncs the
+    //  data first, so a crash loses at most the pending blocks and never
+    //  leaves a block marked that was not written.
     class Bitmap
     {
     public:
-        Bitmap(BitmapIO * io, size_t sizeBlock = 0);
+        Bitmap(BitmapIO * io, size_t sizeBlock = 0,
+                int saveBlocks = 0, int saveInterval = 0);
 
         ~Bitmap();
 
@@ -87,27 +106,55 @@ namespace bdt
         enum {
             LENGTH_BITMAP = 16 * 1024,
         };
-        boost::scoped_array<char> bitmap_;
+        //  first block -> end block of the runs of present blocks, adjacent
+        //  runs are always merged
+        typedef map<off_t, off_t> MapRunType;
+        MapRunType runs_;
 
         off_t begin_;
         off_t end_;
         off_t length_;
         bool dirty_;
 
+        int saveBlocks_;
+        int saveInterval_;
+        int dirtyBlocks_;
+        boost::posix_time::ptime dirtyTime_;
+        off_t lengthSaved_;
+
         bool
         OpenBitmap();
 
+        bool
+        LoadRuns(const unsigned char * buffer,int size);
+
+        bool
+        LoadBits(const unsigned char * buffer,int size);
+
         void
         MarkBitmapUnlock(off_t offset,size_t size);
 
         bool
         SaveBitmap(bool force);
 
+        bool
+        IsSaveDue();
+
+        void
+        SetSaved();
+
         void
         GetBitmap(off_t offset,bool & mark);
 
         void
         SetBitmap(off_t offset,bool mark);
+
+        //  blocks [first,last)
+        void
+        SetRange(off_t first,off_t last,bool mark);
+
+        bool
+        CheckRange(off_t first,off_t last);
     };
 
 }
@@ -0,0 +1,117 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * CacheCapacity.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+
+#include "stdafx.h"
+#include "CacheCapacity.h"
+
+
+namespace bdt
+{
+
+    CacheCapacity::CacheCapacity(
+            const fs::path & folder, int interval, off_t slack)
+    : folder_(folder), interval_(interval), slack_(slack),
+      valid_(false), used_(0), free_(0)
+    {
+        //  running out of space altogether
+        thresholds_.push_back(0);
+    }
+
+
+    CacheCapacity::~CacheCapacity()
+    {
+    }
+
+
+    void
+    CacheCapacity::AddThreshold(off_t size)
+    {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+        thresholds_.push_back(size);
+    }
+
+
+    bool
+    CacheCapacity::GetCapacity(off_t & usedCapacity, off_t & freeCapacity)
+    {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+
+        if ( IsSyncDue() && ! Sync() ) {
+            return false;
+        }
+        usedCapacity = used_;
+        freeCapacity = free_;
+        return true;
+    }
+
+
+    void
+    CacheCapacity::Reserve(off_t size)
+    {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+        used_ += size;
+        free_ -= size;
+    }
+
+
+    void
+    CacheCapacity::Release(off_t size)
+    {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+        used_ -= size;
+        free_ += size;
+    }
+
+
+    bool
+    CacheCapacity::IsSyncDue()
+    {
+        if ( ! valid_ || interval_ <= 0 ) {
+            return true;
+        }
+        BOOST_FOREACH( off_t threshold, thresholds_ ) {
+            if ( free_ > threshold - slack_ && free_ < threshold + slack_ ) {
+                return true;
+            }
+        }
+        return boost::posix_time::microsec_clock::universal_time() - synced_
+                >= boost::posix_time::milliseconds(interval_);
+    }
+
+
+    bool
+    CacheCapacity::Sync()
+    {
+        struct statfs stat;
+        if ( 0 != statfs(folder_.string().c_str(), &stat) ) {
+            LogWarn(folder_);
+            valid_ = false;
+            return false;
+        }
+
+        free_ = (off_t)stat.f_bsize * stat.f_bfree;
+        used_ = (off_t)stat.f_bsize * (stat.f_blocks - stat.f_bfree);
+        synced_ = boost::posix_time::microsec_clock::universal_time();
+        valid_ = true;
+        return true;
+    }
+
+}
@@ -0,0 +1,73 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * CacheCapacity.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+
+#pragma once
+
+
+namespace bdt
+{
+
+    //  Keeps a running estimate of the used and free space of the cache
+    //  file system. Writes reserve their size and deletes release the size
+    //  of the file, statfs is only called again after interval milliseconds
+    //  or while the estimate is within slack of a threshold the callers
+    //  compare against, so crossing a threshold is never missed because of
+    //  space used or freed outside the estimate.
+    class CacheCapacity
+    {
+    public:
+        CacheCapacity(const fs::path & folder, int interval, off_t slack);
+
+        ~CacheCapacity();
+
+        void
+        AddThreshold(off_t size);
+
+        bool
+        GetCapacity(off_t & usedCapacity, off_t & freeCapacity);
+
+        void
+        Reserve(off_t size);
+
+        void
+        Release(off_t size);
+
+    private:
+        boost::mutex mutex_;
+
+        fs::path folder_;
+        int interval_;
+        off_t slack_;
+        vector<off_t> thresholds_;
+
+        bool valid_;
+        off_t used_;
+        off_t free_;
+        boost::posix_time::ptime synced_;
+
+        bool
+        IsSyncDue();
+
+        bool
+        Sync();
+    };
+
+}
@@ -21,6 +21,8 @@
 
 #include "stdafx.h"
 #include "CacheManager.h"
+#include "CacheCapacity.h"
+#include "CacheNumber.h"
 #include "FileOperation.h"
 #include "FileOperationBitmap.h"
 
@@ -29,6 +31,7 @@ namespace bdt
 {
 
     static const string numberFile = "number";
+    static const string numberJournal = "number.journal";
 
     CacheManager::CacheManager()
     : folder_(Factory::GetCacheFolder() / Factory::GetService()),
@@ -45,39 +48,58 @@ namespace bdt
             }
         }
 
-        number_ = GetNumber(folder_,0);
-
-        fs::path numberPath = folder_ / numberFile;
-        ifstream file(numberPath.string().c_str());
-        unsigned long long number = 0;
-        file >> number;
-        if ( number > number_ ) {
-            number_ = number;
+        Configure * config = Factory::GetConfigure();
+        capacity_.reset( new CacheCapacity( folder_,
+                config->GetValueSize(Configure::CacheCapacitySyncInterval),
+                config->GetValueSize(Configure::CacheCapacitySyncSize) ) );
+        //  the limits the callers of GetCapacity check
+        capacity_->AddThreshold(
+                config->GetValueSize(Configure::CacheFreeLeastSize) );
+        capacity_->AddThreshold(
+                config->GetValueSize(Configure::WriteCacheFreeSize) );
+        capacity_->AddThreshold(
+                config->GetValueSize(Configure::ReadCacheFreeSize) );
+        capacity_->AddThreshold(
+                config->GetValueSize(Configure::ReadCacheFreeSize)
+                + config->GetValueSize(Configure::CacheFileSizeRead) );
+
+        numbers_.reset( new CacheNumber( folder_ / numberJournal,
+                config->GetValueSize(Configure::CacheNumberReserveCount) ) );
+        if ( numbers_->IsEmpty() ) {
+            //  the numbers in use are looked up once, the journal knows
+            //  them from now on
+            unsigned long long number = GetNumber(folder_,0);
+
+            fs::path numberPath = folder_ / numberFile;
+            ifstream file(numberPath.string().c_str());
+            unsigned long long numberSaved = 0;
+            file >> numberSaved;
+            if ( numberSaved > number ) {
+                number = numberSaved;
+            }
+            if ( ! numbers_->Reset(number) ) {
+                LogError("Cache numbers fail to start after " << number);
+            }
         }
     }
 
 
     CacheManager::~CacheManager()
     {
-        fs::path numberPath = folder_ / numberFile;
-        ofstream file(numberPath.string().c_str(),ios::out|ios::trunc);
-        file << number_;
     }
 
 
     bool
     CacheManager::GetCapacity(off_t & usedCapacity,off_t & freeCapacity)
     {
-        struct statfs stat;
-        if ( 0 != statfs(folder_.string().c_str(), &stat) ) {
-            LogWarn(folder_);
-            return false;
-        }
+        return capacity_->GetCapacity(usedCapacity,freeCapacity);
+    }
 
-        freeCapacity = (off_t)stat.f_bsize * stat.f_bfree;
-        usedCapacity = (off_t)stat.f_bsize
-                * (stat.f_blocks - stat.f_bfree);
-        return true;
+
+    void
+    CacheManager::ReserveCapacity(off_t size)
+    {
+        capacity_->Reserve(size);
     }
 
 
@@ -108,6 +130,10 @@ namespace bdt
     {
         static const int sizeBlock = Factory::GetConfigure()->GetValueSize(
                 Configure::CacheFileSizeBlock );
+        static const int saveBlocks = Factory::GetConfigure()->GetValueSize(
+                Configure::CacheBitmapSaveBlocks );
+        static const int saveInterval = Factory::GetConfigure()->GetValueSize(
+                Configure::CacheBitmapSaveInterval );
 
         fs::path path;
         if ( ! GetPath(number,path) ) {
@@ -119,7 +145,8 @@ namespace bdt
             return NULL;
         }
         try {
-            return new FileOperationBitmap(path,flags,sizeBlock);
+            return new FileOperationBitmap(
+                    path,flags,sizeBlock,saveBlocks,saveInterval);
         } catch ( const std::exception & e ) {
             LogWarn(path << " " << e.what());
             return NULL;
@@ -143,7 +170,9 @@ namespace bdt
     {
         boost::lock_guard<boost::mutex> lock_(mutex_);
 
-        number = number_ + 1;
+        if ( ! numbers_->Next(number) ) {
+            return false;
+        }
         fs::path path;
         if ( ! GetPath(number,path) ) {
             return false;
@@ -153,7 +182,6 @@ namespace bdt
             fs::create_directories(path.parent_path());
         }
         ofstream(path.string().c_str());
-        ++ number_;
         return true;
     }
 
@@ -177,10 +205,7 @@ namespace bdt
         }
         ofstream(path.string().c_str());
 
-        if ( number > number_ ) {
-            number_ = number;
-        }
-        return true;
+        return numbers_->Use(number);
     }
 
 
@@ -194,8 +219,14 @@ namespace bdt
         if ( ! fs::exists(path) ) {
             return true;
         }
+        struct stat stat;
+        off_t size = 0;
+        if ( 0 == ::stat(path.string().c_str(),&stat) ) {
+            size = (off_t)stat.st_blocks * 512;
+        }
         try {
             fs::remove(path);
+            capacity_->Release(size);
             return true;
         } catch ( const std::exception & e ) {
             LogWarn("Fail to remove " << path << ": " << e.what());
@@ -273,7 +304,8 @@ namespace bdt
         for ( fs::directory_iterator i(folder); i != end; ++ i ) {
             if ( level < 7 ) {
                 if ( fs::is_regular_file(i->status()) ) {
-                    if ( i->path() == folder_ / numberFile ) {
+                    if ( i->path() == folder_ / numberFile
+                            || i->path() == folder_ / numberJournal ) {
                         continue;
                     }
                     LogWarn( "File " << i->path()
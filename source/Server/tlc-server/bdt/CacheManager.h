@@ -26,6 +26,8 @@ namespace bdt
 {
 
     class FileOperationBitmap;
+    class CacheCapacity;
+    class CacheNumber;
 
     class CacheManager
     {
@@ -34,9 +36,14 @@ namespace bdt
 
         ~CacheManager();
 
+        //  an estimate, see CacheCapacity
         bool
         GetCapacity(off_t & usedCapacity, off_t & freeCapacity);
 
+        //  size is about to be written to the cache
+        void
+        ReserveCapacity(off_t size);
+
         bool
         CreateNewFile(unsigned long long & number);
 
@@ -87,10 +94,12 @@ namespace bdt
 
         fs::path folder_;
 
-        volatile unsigned long long number_;
-
         volatile int state_;
 
+        auto_ptr<CacheCapacity> capacity_;
+
+        auto_ptr<CacheNumber> numbers_;
+
         unsigned long long
         GetNumber(const fs::path & path, int level);
 
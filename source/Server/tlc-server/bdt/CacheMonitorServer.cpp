@@ -22,7 +22,6 @@
 #include "stdafx.h"
 #include "CacheMonitorServer.h"
 #include "ServiceServer.h"
-#include "CacheManager.h"
 
 #ifdef MORE_TEST
 #else
@@ -72,78 +71,6 @@ namespace bdt
     }
 
 
-    void
-    CacheMonitorServer::ScanFolder(const fs::path & folder)
-    {
-        CacheManager * cache = Factory::GetCacheManager();
-        fs::path folderMeta = Factory::GetMetaFolder() / Factory::GetService();
-
-        try {
-            fs::directory_iterator end;
-            for ( fs::directory_iterator i(folder); i != end; ++ i ) {
-                if ( fs::is_directory(i->status()) ) {
-                    ScanFolder(i->path());
-                } else {
-                    struct stat stat;
-                    if ( 0 != ::stat(i->path().string().c_str(),&stat) ) {
-                        continue;
-                    }
-
-                    ExtendedAttribute ea(i->path());
-                    unsigned long long number;
-                    int valuesize;
-                    if ( ! ea.GetValue(
-                            Inode::ATTRIBUTE_NUMBER,
-                            &number,
-                            sizeof(number),
-                            valuesize ) ) {
-                        continue;
-                    }
-                    long state;
-                    if ( ! ea.GetValue(
-                            Inode::ATTRIBUTE_STATE,
-                            &state,
-                            sizeof(state),
-                            valuesize) ) {
-                        continue;
-                    }
-                    if ( state != Inode::StateBegin ) {
-                        continue;
-                    }
-                    long long size = 0;
-                    if ( ! ea.GetValue(
-                            Inode::ATTRIBUTE_SIZE,
-                            &size,
-                            sizeof(size),
-                            valuesize) ) {
-                        continue;
-                    }
-                    if ( size <= 0 ) {
-                        continue;
-                    }
-
-                    if ( ! cache->ExistFile(number) ) {
-                        continue;
-                    }
-
-                    vector<FileInfo> files;
-                    FileMap::iterator iter = files_.insert(
-                            FileMap::value_type(stat.st_atime,files) ).first;
-                    FileInfo file;
-                    file.service = Factory::GetService();
-                    file.path = i->path().string().substr(
-                            folderMeta.string().size() );
-                    iter->second.push_back(file);
-                }
-            }
-        } catch ( const boost::filesystem::filesystem_error& e ) {
-        	LogError(e.what());
-        } catch ( const std::exception & e ) {
-        	LogError(e.what());
-        }
-    }
-
-
     void
     CacheMonitorServer::ServerThread()
     {
@@ -183,39 +110,118 @@ namespace bdt
             }
             LogInfo(folderMeta_);
 
+            //  the services keep the files in the order of their last
+            //  access, the oldest ones of each are released batch by
+            //  batch until enough space is free or none is left
+            vector<string> services;
             fs::directory_iterator end;
             for ( fs::directory_iterator i(folderMeta_); i != end; ++ i ) {
-                if ( ! fs::is_directory(i->status()) ) {
-                    continue;
+                if ( fs::is_directory(i->status()) ) {
+                    services.push_back(i->path().filename().string());
+                }
+            }
+            while ( run_ && ! services.empty()
+                    && ! CheckFreeSize(maxFreeSize_) ) {
+                for ( size_t i = 0; i < services.size(); ) {
+                    size_t count = 0;
+                    if ( GetEvictionList(services[i],count) && count > 0 ) {
+                        ++ i;
+                    } else {
+                        services.erase(services.begin() + i);
+                    }
+                }
+                //  the files failing to release would come back again
+                if ( 0 == ReleaseFiles() ) {
+                    break;
                 }
-                string service = i->path().filename().string();
-                Factory::SetService(service);
-                Factory::CreateCacheManager();
-                ScanFolder(i->path());
-                Factory::ReleaseCacheManager();
-                Factory::SetService("");
             }
+        }
+    }
 
-            for ( FileMap::iterator i = files_.begin();
-                    i != files_.end();
-                    ++ i ) {
+
+    size_t
+    CacheMonitorServer::ReleaseFiles()
+    {
+        size_t released = 0;
+        for ( FileMap::iterator i = files_.begin();
+                i != files_.end();
+                ++ i ) {
+            if ( CheckFreeSize(maxFreeSize_) ) {
+                break;
+            }
+
+            for ( vector<FileInfo>::iterator iter = i->second.begin();
+                    iter != i->second.end();
+                    ++ iter ) {
                 if ( CheckFreeSize(maxFreeSize_) ) {
                     break;
                 }
 
-                for ( vector<FileInfo>::iterator iter = i->second.begin();
-                        iter != i->second.end();
-                        ++ iter ) {
-                    if ( CheckFreeSize(maxFreeSize_) ) {
-                        break;
-                    }
-
-                    ReleaseFile(*iter);
+                if ( ReleaseFile(*iter) ) {
+                    ++ released;
                 }
             }
+        }
+
+        files_.clear();
+        return released;
+    }
+
+
+    bool
+    CacheMonitorServer::GetEvictionList(const string & service, size_t & count)
+    {
+        static int batch = Factory::GetConfigure()->GetValueSize(
+                Configure::CachePurgeBatchCount );
 
-            files_.clear();
+        int handle = Factory::SocketClientHandle(
+                ServiceServer::Service + service );
+        if ( handle < 0 ) {
+            LogError("GetHandle");
+            return false;
         }
+
+        xmlrpc_c::clientXmlTransport_pstream transport(
+                xmlrpc_c::clientXmlTransport_pstream::constrOpt()
+                .fd(handle));
+        xmlrpc_c::client_xml client(&transport);
+        string const method(ServiceServer::GetEvictionList);
+        xmlrpc_c::paramList params;
+        params.add(xmlrpc_c::value_int(batch));
+        xmlrpc_c::rpc rpc(method,params);
+        xmlrpc_c::carriageParm_pstream carriage;
+
+        bool ret = false;
+        try {
+            rpc.call(&client,&carriage);
+            if ( ! rpc.isSuccessful() ) {
+                xmlrpc_c::fault fault = rpc.getFault();
+                LogError(fault.getCode() << ":" << fault.getDescription());
+            } else {
+                vector<xmlrpc_c::value> data =
+                        xmlrpc_c::value_array(rpc.getResult())
+                        .vectorValueValue();
+                BOOST_FOREACH(const xmlrpc_c::value & value, data) {
+                    xmlrpc_c::cstruct item =
+                            xmlrpc_c::value_struct(value).cvalue();
+                    FileInfo file;
+                    file.service = service;
+                    file.path = xmlrpc_c::value_string(
+                            item["path"]).cvalue();
+                    time_t atime = xmlrpc_c::value_i8(item["atime"]).cvalue();
+                    files_[atime].push_back(file);
+                }
+                LogDebug(service << " : " << data.size());
+                count = data.size();
+                ret = true;
+            }
+        } catch ( std::exception const & e ) {
+            LogError(e.what());
+        }
+
+        close(handle);
+
+        return ret;
     }
 
 
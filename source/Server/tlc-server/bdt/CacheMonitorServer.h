@@ -53,8 +53,13 @@ namespace bdt
         typedef map<time_t,vector<FileInfo> > FileMap;
         FileMap files_;
 
-        void
-        ScanFolder(const fs::path & folder);
+        //  count is the number of files the service returned
+        bool
+        GetEvictionList(const string & service, size_t & count);
+
+        //  the number of files released
+        size_t
+        ReleaseFiles();
 
         bool
         CheckFreeSize(off_t freesize);
@@ -0,0 +1,261 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * CacheNumber.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+
+
+#include "stdafx.h"
+#include <sys/file.h>
+#include "CacheNumber.h"
+
+
+namespace bdt
+{
+
+    //  the journal is rewritten with its last record after so many
+    static const int CompactRecords = 1024;
+
+    CacheNumber::CacheNumber(
+            const fs::path & pathname, unsigned long long count)
+    : pathname_(pathname), count_(count), empty_(true), number_(0), limit_(0)
+    {
+        if ( count_ < 1 ) {
+            count_ = 1;
+        }
+        Journal journal;
+        if ( ! Lock(journal) ) {
+            return;
+        }
+        if ( journal.partial ) {
+            LogWarn(pathname_ << " has incomplete record");
+        }
+        empty_ = journal.empty;
+        limit_ = journal.limit;
+        number_ = limit_;
+        ::close(journal.handle);
+    }
+
+
+    CacheNumber::~CacheNumber()
+    {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+        if ( empty_ || number_ >= limit_ ) {
+            return;
+        }
+        Journal journal;
+        if ( ! Lock(journal) ) {
+            return;
+        }
+        //  the rest of the reserved range is free again, unless another
+        //  instance sharing the journal reserved after it
+        if ( journal.limit == limit_ ) {
+            Append(journal, number_);
+        }
+        ::close(journal.handle);
+    }
+
+
+    bool
+    CacheNumber::IsEmpty()
+    {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+        return empty_;
+    }
+
+
+    bool
+    CacheNumber::Reset(unsigned long long number)
+    {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+        return Reserve(number, 0);
+    }
+
+
+    bool
+    CacheNumber::Next(unsigned long long & number)
+    {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+        if ( number_ >= limit_ && ! Reserve(number_, count_) ) {
+            return false;
+        }
+        number = ++ number_;
+        return true;
+    }
+
+
+    bool
+    CacheNumber::Use(unsigned long long number)
+    {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+        if ( number <= number_ ) {
+            return true;
+        }
+        if ( number > limit_ ) {
+            return Reserve(number, count_);
+        }
+        number_ = number;
+        return true;
+    }
+
+
+    bool
+    CacheNumber::Reserve(unsigned long long number, unsigned long long count)
+    {
+        Journal journal;
+        if ( ! Lock(journal) ) {
+            return false;
+        }
+
+        //  the numbers up to the last record may be handed out by another
+        //  instance, the range starts behind them
+        if ( number < journal.limit ) {
+            number = journal.limit;
+        }
+        unsigned long long limit = number + count;
+        bool ret = true;
+        if ( journal.empty || limit > journal.limit ) {
+            ret = Append(journal, limit);
+        }
+        ::close(journal.handle);
+        if ( ! ret ) {
+            return false;
+        }
+        number_ = number;
+        limit_ = limit;
+        empty_ = false;
+        return true;
+    }
+
+
+    bool
+    CacheNumber::Lock(Journal & journal)
+    {
+        for ( ; ; ) {
+            journal.handle = ::open( pathname_.string().c_str(),
+                    O_RDWR|O_APPEND|O_CREAT, 0644 );
+            if ( journal.handle < 0 ) {
+                LogError(pathname_ << " fails to open: " << strerror(errno));
+                return false;
+            }
+            if ( 0 != ::flock(journal.handle, LOCK_EX) ) {
+                LogError(pathname_ << " fails to lock: " << strerror(errno));
+                ::close(journal.handle);
+                return false;
+            }
+
+            //  a compaction by another instance replaces the file while
+            //  waiting for the lock
+            struct stat statHandle;
+            struct stat statPath;
+            if ( 0 != ::fstat(journal.handle, &statHandle) ) {
+                LogError(pathname_ << " fails to stat: " << strerror(errno));
+                ::close(journal.handle);
+                return false;
+            }
+            if ( 0 == ::stat(pathname_.string().c_str(), &statPath)
+                    && statHandle.st_ino == statPath.st_ino
+                    && statHandle.st_dev == statPath.st_dev ) {
+                break;
+            }
+            ::close(journal.handle);
+        }
+
+        string content;
+        char buffer[4096];
+        ssize_t length;
+        while ( ( length = ::pread( journal.handle, buffer, sizeof(buffer),
+                content.size() ) ) > 0 ) {
+            content.append(buffer, length);
+        }
+
+        //  a record is complete with its newline, one cut short by a crash
+        //  was not synced and no number of its range was handed out
+        journal.limit = 0;
+        journal.records = 0;
+        journal.empty = true;
+        journal.partial = false;
+        size_t begin = 0;
+        while ( begin < content.size() ) {
+            size_t end = content.find('\n', begin);
+            if ( end == string::npos ) {
+                journal.partial = true;
+                break;
+            }
+            string line = content.substr(begin, end - begin);
+            begin = end + 1;
+            ++ journal.records;
+            try {
+                journal.limit = boost::lexical_cast<unsigned long long>(line);
+                journal.empty = false;
+            } catch ( const std::exception & e ) {
+                LogWarn(pathname_ << " has invalid record " << line);
+            }
+        }
+        return true;
+    }
+
+
+    bool
+    CacheNumber::Append(Journal & journal, unsigned long long limit)
+    {
+        if ( journal.records >= CompactRecords ) {
+            return Compact(limit);
+        }
+
+        //  the incomplete record of a crash is ended first
+        string record = boost::lexical_cast<string>(limit) + "\n";
+        if ( journal.partial ) {
+            record = "\n" + record;
+        }
+        if ( ::write(journal.handle, record.data(), record.size())
+                != (ssize_t)record.size()
+                || 0 != ::fdatasync(journal.handle) ) {
+            LogError(pathname_ << " fails to write: " << strerror(errno));
+            return false;
+        }
+        return true;
+    }
+
+
+    bool
+    CacheNumber::Compact(unsigned long long limit)
+    {
+        fs::path pathname = pathname_.string() + ".new";
+        string record = boost::lexical_cast<string>(limit) + "\n";
+
+        int handle = ::open( pathname.string().c_str(),
+                O_WRONLY|O_CREAT|O_TRUNC, 0644 );
+        if ( handle < 0 ) {
+            LogError(pathname << " fails to open: " << strerror(errno));
+            return false;
+        }
+        bool ret = ::write(handle, record.data(), record.size())
+                == (ssize_t)record.size()
+                && 0 == ::fsync(handle);
+        ::close(handle);
+        if ( ! ret || 0 != ::rename(
+                pathname.string().c_str(), pathname_.string().c_str() ) ) {
+            LogError(pathname << " fails to replace " << pathname_
+                    << ": " << strerror(errno));
+            return false;
+        }
+        return true;
+    }
+
+}
@@ -0,0 +1,93 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * CacheNumber.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+
+
+#pragma once
+
+
+namespace bdt
+{
+
+    //  Hands out the numbers of the cache files. The numbers are reserved
+    //  in ranges of count; the end of a range is appended to the journal
+    //  and synced before the first number of the range is handed out, so
+    //  a restart after a crash continues behind the last reserved range.
+    //  A clean shutdown records the last number handed out instead.
+    //  The journal may be shared by the instances of several processes, a
+    //  range is reserved under a flock behind the last record of any of
+    //  them.
+    class CacheNumber
+    {
+    public:
+        CacheNumber(const fs::path & pathname, unsigned long long count);
+
+        ~CacheNumber();
+
+        //  the journal has no record, the numbers in use are unknown
+        bool
+        IsEmpty();
+
+        //  the numbers up to number are in use
+        bool
+        Reset(unsigned long long number);
+
+        bool
+        Next(unsigned long long & number);
+
+        //  number is in use, the next numbers come after it
+        bool
+        Use(unsigned long long number);
+
+    private:
+        struct Journal
+        {
+            int handle;
+            int records;
+            bool empty;
+            bool partial;
+            unsigned long long limit;
+        };
+
+        boost::mutex mutex_;
+
+        fs::path pathname_;
+        unsigned long long count_;
+        bool empty_;
+
+        unsigned long long number_;
+        unsigned long long limit_;
+
+        //  reserves count numbers after number and the last record
+        bool
+        Reserve(unsigned long long number, unsigned long long count);
+
+        //  opens and locks the journal and reads its records
+        bool
+        Lock(Journal & journal);
+
+        bool
+        Append(Journal & journal, unsigned long long limit);
+
+        bool
+        Compact(unsigned long long limit);
+    };
+
+}
@@ -0,0 +1,168 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * CacheWriter.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+
+#include "stdafx.h"
+#include "CacheWriter.h"
+#include "FileOperationBitmap.h"
+
+
+namespace bdt
+{
+
+    CacheWriter::CacheWriter(size_t buffers, size_t bufsize)
+    : bufsize_(bufsize), writing_(false), errno_(0), stop_(false)
+    {
+        buffers = max<size_t>(buffers,1);
+        memory_.reset(new char[buffers * bufsize_]);
+        for ( size_t i = 0; i < buffers; ++ i ) {
+            free_.push_back(memory_.get() + i * bufsize_);
+        }
+        thread_.reset( new boost::thread( &CacheWriter::WriteTask, this ) );
+    }
+
+
+    CacheWriter::~CacheWriter()
+    {
+        {
+            boost::lock_guard<boost::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        condition_.notify_all();
+        thread_->join();
+    }
+
+
+    char *
+    CacheWriter::GetBuffer()
+    {
+        boost::unique_lock<boost::mutex> lock(mutex_);
+
+        while ( free_.empty() && errno_ == 0 ) {
+            condition_.wait(lock);
+        }
+        if ( errno_ != 0 ) {
+            errno = errno_;
+            return NULL;
+        }
+
+        char * buffer = free_.back();
+        free_.pop_back();
+        return buffer;
+    }
+
+
+    void
+    CacheWriter::Discard(char * buffer)
+    {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+        free_.push_back(buffer);
+    }
+
+
+    void
+    CacheWriter::Write(
+            FileOperationBitmap * file,
+            off_t offset,
+            char * buffer,
+            size_t size)
+    {
+        Item item;
+        item.file = file;
+        item.offset = offset;
+        item.buffer = buffer;
+        item.size = size;
+        {
+            boost::lock_guard<boost::mutex> lock(mutex_);
+            queue_.push_back(item);
+        }
+        condition_.notify_all();
+    }
+
+
+    bool
+    CacheWriter::Flush()
+    {
+        boost::unique_lock<boost::mutex> lock(mutex_);
+
+        while ( writing_ || ! queue_.empty() ) {
+            condition_.wait(lock);
+        }
+
+        int error = errno_;
+        errno_ = 0;
+        if ( error != 0 ) {
+            errno = error;
+            return false;
+        }
+        return true;
+    }
+
+
+    void
+    CacheWriter::WriteTask()
+    {
+        boost::unique_lock<boost::mutex> lock(mutex_);
+
+        while ( true ) {
+            while ( queue_.empty() && ! stop_ ) {
+                condition_.wait(lock);
+            }
+            if ( queue_.empty() ) {
+                return;
+            }
+
+            Item item = queue_.front();
+            queue_.pop_front();
+            //  the writes after a failure are dropped until the Flush
+            bool skip = errno_ != 0;
+            writing_ = true;
+
+            lock.unlock();
+
+            int error = 0;
+            for ( size_t done = 0; ! skip && done < item.size; ) {
+                size_t size;
+                if ( ! item.file->WriteData( item.offset + done,
+                        item.buffer + done, item.size - done, size ) ) {
+                    error = errno != 0 ? errno : EIO;
+                    LogError(item.offset + done << ":" << item.size - done);
+                    break;
+                }
+                if ( size == 0 ) {
+                    error = EIO;
+                    LogError(item.offset + done << " writes nothing");
+                    break;
+                }
+                done += size;
+            }
+
+            lock.lock();
+
+            writing_ = false;
+            if ( error != 0 && errno_ == 0 ) {
+                errno_ = error;
+            }
+            free_.push_back(item.buffer);
+            condition_.notify_all();
+        }
+    }
+
+}
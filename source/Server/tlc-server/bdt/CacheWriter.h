@@ -0,0 +1,96 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * CacheWriter.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+
+#pragma once
+
+
+#include <deque>
+
+
+namespace bdt
+{
+
+    class FileOperationBitmap;
+
+
+    //  Writes the buffers filled from tape to the cache file on its own
+    //  thread, so the next buffer is read while the previous one is
+    //  written. Only the data is written, the caller marks the bitmap
+    //  once the range is flushed.
+    class CacheWriter
+    {
+    public:
+        CacheWriter(size_t buffers, size_t bufsize);
+
+        ~CacheWriter();
+
+        size_t
+        GetBufferSize()
+        {
+            return bufsize_;
+        }
+
+        //  waits for a free buffer, NULL if a write failed since the
+        //  last Flush
+        char *
+        GetBuffer();
+
+        void
+        Discard(char * buffer);
+
+        void
+        Write(
+                FileOperationBitmap * file,
+                off_t offset,
+                char * buffer,
+                size_t size);
+
+        //  waits for the queued writes, false if one of them failed
+        bool
+        Flush();
+
+    private:
+        struct Item
+        {
+            FileOperationBitmap * file;
+            off_t offset;
+            char * buffer;
+            size_t size;
+        };
+
+        size_t bufsize_;
+        boost::scoped_array<char> memory_;
+
+        boost::mutex mutex_;
+        boost::condition_variable condition_;
+        deque<Item> queue_;
+        vector<char *> free_;
+        bool writing_;
+        int errno_;
+        bool stop_;
+
+        auto_ptr<boost::thread> thread_;
+
+        void
+        WriteTask();
+    };
+
+}
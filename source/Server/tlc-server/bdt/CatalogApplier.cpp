@@ -0,0 +1,189 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * CatalogApplier.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+
+
+
+#include "stdafx.h"
+#include "CatalogApplier.h"
+
+
+namespace bdt
+{
+
+    //  the SQL errors that go away when the change is applied again
+    static bool
+    IsTransient(int error)
+    {
+        switch ( error ) {
+        case 1040:  //  too many connections
+        case 1205:  //  lock wait timeout
+        case 1213:  //  deadlock
+        case 2006:  //  server has gone away
+        case 2013:  //  lost connection during the query
+            return true;
+        default:
+            return false;
+        }
+    }
+
+
+    CatalogApplier::CatalogApplier()
+    : catalog_(ltfs_management::CatalogDbManager::Instance())
+    {
+    }
+
+
+    CatalogApplier::~CatalogApplier()
+    {
+    }
+
+
+    size_t
+    CatalogApplier::Apply(const vector<CatalogRecord> & records)
+    {
+        const CatalogRecord & record = records[0];
+        const vector<string> & values = record.values;
+        size_t count = 1;
+        bool ret = true;
+
+        switch ( record.type ) {
+        case CatalogRecord::TypeAddFiles:
+            {
+                map<string, vector<ltfs_management::TapeFileInfo> > files;
+                if ( GetFiles(record,files) ) {
+                    ret = catalog_->AddTapeFiles(record.share, files);
+                }
+            }
+            break;
+        case CatalogRecord::TypeDeleteFile:
+            if ( values.size() == 1 ) {
+                //  the deletes in a row go at once, deleting them again
+                //  after a crash changes nothing
+                vector<string> uuids(values);
+                while ( count < records.size()
+                        && records[count].type == CatalogRecord::TypeDeleteFile
+                        && records[count].share == record.share
+                        && records[count].values.size() == 1 ) {
+                    uuids.push_back(records[count].values[0]);
+                    ++ count;
+                }
+                ret = catalog_->DeleteMetaFiles(record.share, uuids);
+            }
+            break;
+        case CatalogRecord::TypeDeleteFolder:
+            if ( values.size() == 1 ) {
+                ret = catalog_->DeleteMetaFolders(record.share, values);
+            }
+            break;
+        case CatalogRecord::TypeRenameFile:
+            if ( values.size() == 2 ) {
+                ret = catalog_->RenameMetaFile(
+                        record.share, values[0], values[1]);
+            }
+            break;
+        case CatalogRecord::TypeRenameFolder:
+            if ( values.size() == 2 ) {
+                ret = catalog_->RenameMetaFolder(
+                        record.share, values[0], values[1]);
+            }
+            break;
+        default:
+            LogError("Catalog change " << record.sequence
+                    << " has unknown type " << record.type);
+            break;
+        }
+
+        if ( ret ) {
+            return count;
+        }
+        int error = catalog_->GetLastError();
+        if ( IsTransient(error) ) {
+            LogWarn("Catalog change " << record.sequence
+                    << " fails with error " << error << ", it is retried");
+            return 0;
+        }
+        if ( catalog_->IsAvailable() ) {
+            LogError("Catalog refuses change " << record.sequence
+                    << " of type " << record.type << " of " << record.share
+                    << " with error " << error);
+            return count;
+        }
+        return 0;
+    }
+
+
+    void
+    CatalogApplier::SetFiles(
+            const string & share,
+            const map<string, vector<ltfs_management::TapeFileInfo> > & files,
+            CatalogRecord & record )
+    {
+        record.type = CatalogRecord::TypeAddFiles;
+        record.share = share;
+        record.values.clear();
+        map<string, vector<ltfs_management::TapeFileInfo> >::const_iterator i;
+        for ( i = files.begin(); i != files.end(); ++ i ) {
+            BOOST_FOREACH( const ltfs_management::TapeFileInfo & info, i->second ) {
+                record.values.push_back(i->first);
+                record.values.push_back(info.mUuid);
+                record.values.push_back(info.mMetaFilePath);
+                record.values.push_back(boost::lexical_cast<string>(info.mOffset));
+                record.values.push_back(boost::lexical_cast<string>(info.mSize));
+                record.values.push_back(info.mPack);
+                record.values.push_back(boost::lexical_cast<string>(info.mPosition));
+            }
+        }
+    }
+
+
+    bool
+    CatalogApplier::GetFiles(
+            const CatalogRecord & record,
+            map<string, vector<ltfs_management::TapeFileInfo> > & files )
+    {
+        const vector<string> & values = record.values;
+        if ( values.size() % CatalogRecord::FileValues != 0 ) {
+            LogError("Catalog change " << record.sequence << " has "
+                    << values.size() << " values");
+            return false;
+        }
+        try {
+            for ( size_t i = 0;
+                    i < values.size();
+                    i += CatalogRecord::FileValues ) {
+                ltfs_management::TapeFileInfo info;
+                info.mUuid = values[i+1];
+                info.mMetaFilePath = values[i+2];
+                info.mOffset = boost::lexical_cast<unsigned long long>(values[i+3]);
+                info.mSize = boost::lexical_cast<unsigned long long>(values[i+4]);
+                info.mPack = values[i+5];
+                info.mPosition = boost::lexical_cast<unsigned long long>(values[i+6]);
+                files[values[i]].push_back(info);
+            }
+        } catch ( const boost::bad_lexical_cast & e ) {
+            LogError("Catalog change " << record.sequence << " has "
+                    << "invalid values: " << e.what());
+            return false;
+        }
+        return true;
+    }
+
+}
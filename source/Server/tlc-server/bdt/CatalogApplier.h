@@ -0,0 +1,64 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * CatalogApplier.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+
+#pragma once
+
+
+#include "CatalogJournal.h"
+#include "../ltfs_management/CatalogDbManager.h"
+
+
+namespace bdt
+{
+
+    //  Applies the catalog journal to the catalog database. A change
+    //  failing on a deadlock, a lock wait timeout or a lost connection is
+    //  retried like one while the database is away. A change that cannot
+    //  be decoded, or that the database refuses otherwise while it
+    //  answers, is logged and skipped, it would hold up the ones behind it
+    //  for good.
+    class CatalogApplier : public CatalogApplierInterface
+    {
+    public:
+        CatalogApplier();
+
+        virtual
+        ~CatalogApplier();
+
+        virtual size_t
+        Apply(const vector<CatalogRecord> & records);
+
+        static void
+        SetFiles(
+                const string & share,
+                const map<string, vector<ltfs_management::TapeFileInfo> > & files,
+                CatalogRecord & record );
+
+        static bool
+        GetFiles(
+                const CatalogRecord & record,
+                map<string, vector<ltfs_management::TapeFileInfo> > & files );
+
+    private:
+        ltfs_management::CatalogDbManager * catalog_;
+    };
+
+}
@@ -0,0 +1,567 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * CatalogJournal.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+
+
+
+#include "stdafx.h"
+#include "CatalogJournal.h"
+
+#include <boost/crc.hpp>
+
+
+namespace bdt
+{
+
+    //  records passed to the applier at a time
+    static const size_t ApplyRecords = 256;
+    //  the journal is emptied once all of it is applied and it has grown
+    //  beyond this size
+    static const off_t CompactSize = 64LL * 1024 * 1024;
+    //  milliseconds between the retries while the catalog is not available
+    static const int RetryMin = 100;
+    static const int RetryMax = 5000;
+    //  a record is its size and checksum, then the encoded record
+    static const size_t HeaderSize = 2 * sizeof(uint32_t);
+    //  larger records are taken for garbage
+    static const uint32_t RecordMaxSize = 256 * 1024 * 1024;
+    //  the sequence of the last record applied, padded to one write
+    static const int AppliedSize = 21;
+
+
+    CatalogJournal::CatalogJournal(
+            const fs::path & pathname,
+            CatalogApplierInterface * applier,
+            int lag )
+    : pathname_(pathname), pathApplied_(pathname.string() + ".applied"),
+      applier_(applier), lag_(lag), handle_(-1), handleApplied_(-1),
+      size_(0), sequence_(0), sequenceApplied_(0), group_(new Group()),
+      writing_(false), lagging_(false)
+    {
+        Load();
+        thread_.reset( new boost::thread(
+                boost::bind(&CatalogJournal::Run, this) ) );
+    }
+
+
+    CatalogJournal::~CatalogJournal()
+    {
+        //  the records not applied yet are applied after the next start
+        thread_->interrupt();
+        thread_->join();
+        if ( handle_ >= 0 ) {
+            ::close(handle_);
+        }
+        if ( handleApplied_ >= 0 ) {
+            ::close(handleApplied_);
+        }
+    }
+
+
+    bool
+    CatalogJournal::Append(const CatalogRecord & record)
+    {
+        boost::unique_lock<boost::mutex> lock(mutex_);
+
+        boost::shared_ptr<Group> group = group_;
+        group->records.push_back(record);
+        group->records.back().time = time(NULL);
+
+        while ( ! group->done ) {
+            if ( writing_ ) {
+                written_.wait(lock);
+                continue;
+            }
+
+            //  the records appended while this group is written go with
+            //  the next one
+            writing_ = true;
+            group_.reset( new Group() );
+            for ( size_t i = 0; i < group->records.size(); ++ i ) {
+                group->records[i].sequence = sequence_ + i + 1;
+            }
+            lock.unlock();
+            bool ok = Write(group->records);
+            lock.lock();
+
+            writing_ = false;
+            group->done = true;
+            group->ok = ok;
+            if ( ok ) {
+                sequence_ += group->records.size();
+                pending_.insert( pending_.end(),
+                        group->records.begin(), group->records.end() );
+                BOOST_FOREACH( const CatalogRecord & written, group->records ) {
+                    Track(written);
+                }
+                applied_.notify_all();
+            }
+            written_.notify_all();
+        }
+        return group->ok;
+    }
+
+
+    bool
+    CatalogJournal::Flush(int timeout)
+    {
+        boost::unique_lock<boost::mutex> lock(mutex_);
+        return WaitApplied(lock, sequence_, timeout);
+    }
+
+
+    bool
+    CatalogJournal::FlushFile(int timeout, const string & number)
+    {
+        boost::unique_lock<boost::mutex> lock(mutex_);
+        MapSequenceType::iterator i = files_.find(number);
+        if ( i == files_.end() ) {
+            return true;
+        }
+        return WaitApplied(lock, i->second, timeout);
+    }
+
+
+    bool
+    CatalogJournal::FlushTape(int timeout, const string & tape)
+    {
+        boost::unique_lock<boost::mutex> lock(mutex_);
+        MapSequenceType::iterator i = tapes_.find(tape);
+        if ( i == tapes_.end() ) {
+            return true;
+        }
+        return WaitApplied(lock, i->second, timeout);
+    }
+
+
+    void
+    CatalogJournal::GetPendingDeletes(vector<string> & numbers)
+    {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+        BOOST_FOREACH( const CatalogRecord & record, pending_ ) {
+            if ( record.type == CatalogRecord::TypeDeleteFile
+                    && record.values.size() == 1 ) {
+                numbers.push_back(record.values[0]);
+            }
+        }
+    }
+
+
+    bool
+    CatalogJournal::WaitApplied(
+            boost::unique_lock<boost::mutex> & lock,
+            unsigned long long sequence,
+            int timeout)
+    {
+        boost::posix_time::ptime deadline =
+                boost::posix_time::microsec_clock::universal_time()
+                + boost::posix_time::milliseconds(timeout);
+        while ( sequenceApplied_ < sequence ) {
+            if ( ! applied_.timed_wait(lock,deadline) ) {
+                return sequenceApplied_ >= sequence;
+            }
+        }
+        return true;
+    }
+
+
+    size_t
+    CatalogJournal::GetPending()
+    {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+        return pending_.size();
+    }
+
+
+    bool
+    CatalogJournal::IsLagging()
+    {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+        return lagging_;
+    }
+
+
+    void
+    CatalogJournal::Load()
+    {
+        ifstream inputApplied(pathApplied_.string().c_str());
+        if ( inputApplied ) {
+            string line;
+            if ( getline(inputApplied,line) ) {
+                try {
+                    sequenceApplied_ = boost::lexical_cast<unsigned long long>(
+                            boost::trim_copy(line) );
+                } catch ( const std::exception & e ) {
+                    LogWarn(pathApplied_ << " has invalid record " << line);
+                }
+            }
+        }
+        sequence_ = sequenceApplied_;
+
+        //  a record cut short by a crash was not synced, Append did not
+        //  return for it
+        ifstream input(pathname_.string().c_str(), ios::in|ios::binary);
+        while ( input ) {
+            uint32_t header[2];
+            if ( ! input.read((char *)header, sizeof(header)) ) {
+                if ( input.gcount() > 0 ) {
+                    LogWarn(pathname_ << " has incomplete record at " << size_);
+                }
+                break;
+            }
+            if ( header[0] > RecordMaxSize ) {
+                LogWarn(pathname_ << " has invalid record at " << size_);
+                break;
+            }
+            string buffer(header[0], '\0');
+            if ( ! input.read(&buffer[0], buffer.size()) ) {
+                LogWarn(pathname_ << " has incomplete record at " << size_);
+                break;
+            }
+            boost::crc_32_type crc;
+            crc.process_bytes(buffer.data(), buffer.size());
+            CatalogRecord record;
+            if ( crc.checksum() != header[1] || ! Decode(buffer,record) ) {
+                LogWarn(pathname_ << " has invalid record at " << size_);
+                break;
+            }
+            size_ += HeaderSize + buffer.size();
+            if ( record.sequence > sequence_ ) {
+                sequence_ = record.sequence;
+            }
+            if ( record.sequence > sequenceApplied_ ) {
+                pending_.push_back(record);
+                Track(record);
+            }
+        }
+        input.close();
+
+        handle_ = ::open( pathname_.string().c_str(),
+                O_WRONLY|O_APPEND|O_CREAT, 0644 );
+        if ( handle_ < 0 ) {
+            LogError(pathname_ << " fails to open: " << strerror(errno));
+        } else if ( 0 != ::ftruncate(handle_, size_) ) {
+            LogError(pathname_ << " fails to truncate: " << strerror(errno));
+        }
+        handleApplied_ = ::open( pathApplied_.string().c_str(),
+                O_WRONLY|O_CREAT, 0644 );
+        if ( handleApplied_ < 0 ) {
+            LogError(pathApplied_ << " fails to open: " << strerror(errno));
+        }
+
+        if ( ! pending_.empty() ) {
+            LogInfo(pathname_ << " has " << pending_.size()
+                    << " records to apply after " << sequenceApplied_);
+        }
+    }
+
+
+    bool
+    CatalogJournal::Write(vector<CatalogRecord> & records)
+    {
+        if ( handle_ < 0 ) {
+            errno = EBADF;
+            return false;
+        }
+
+        string buffer;
+        for ( size_t i = 0; i < records.size(); ++ i ) {
+            string data;
+            Encode(records[i], data);
+            boost::crc_32_type crc;
+            crc.process_bytes(data.data(), data.size());
+            uint32_t header[2] = { (uint32_t)data.size(), crc.checksum() };
+            buffer.append((const char *)header, sizeof(header));
+            buffer.append(data);
+        }
+
+        size_t done = 0;
+        while ( done < buffer.size() ) {
+            ssize_t ret = ::write(handle_,
+                    buffer.data() + done, buffer.size() - done);
+            if ( ret < 0 ) {
+                if ( errno == EINTR ) {
+                    continue;
+                }
+                break;
+            }
+            done += ret;
+        }
+        if ( done < buffer.size() || 0 != ::fdatasync(handle_) ) {
+            LogError(pathname_ << " fails to write: " << strerror(errno));
+            //  the records behind must not follow a part of these
+            if ( 0 != ::ftruncate(handle_, size_) ) {
+                LogError(pathname_ << " fails to truncate: "
+                        << strerror(errno));
+            }
+            return false;
+        }
+        size_ += buffer.size();
+        return true;
+    }
+
+
+    bool
+    CatalogJournal::SetApplied(unsigned long long sequence)
+    {
+        if ( handleApplied_ < 0 ) {
+            errno = EBADF;
+            return false;
+        }
+        char record[AppliedSize + 1];
+        snprintf(record, sizeof(record), "%20llu\n", sequence);
+        if ( ::pwrite(handleApplied_, record, AppliedSize, 0) != AppliedSize
+                || 0 != ::fdatasync(handleApplied_) ) {
+            LogError(pathApplied_ << " fails to write: " << strerror(errno));
+            return false;
+        }
+        return true;
+    }
+
+
+    void
+    CatalogJournal::CheckLag()
+    {
+        time_t age = pending_.empty() ? 0 : time(NULL) - pending_.front().time;
+        if ( ! lagging_ && age >= lag_ ) {
+            lagging_ = true;
+            LogError("Catalog is " << age << " seconds behind, "
+                    << pending_.size() << " changes not applied");
+        } else if ( lagging_ && age < lag_ ) {
+            lagging_ = false;
+            LogInfo("Catalog is up to date again, "
+                    << pending_.size() << " changes not applied");
+        }
+    }
+
+
+    void
+    CatalogJournal::Track(const CatalogRecord & record)
+    {
+        const vector<string> & values = record.values;
+        switch ( record.type ) {
+        case CatalogRecord::TypeAddFiles:
+            for ( size_t i = 0; i + CatalogRecord::FileValues <= values.size();
+                    i += CatalogRecord::FileValues ) {
+                tapes_[values[i]] = record.sequence;
+                files_[values[i+1]] = record.sequence;
+            }
+            break;
+        case CatalogRecord::TypeDeleteFile:
+        case CatalogRecord::TypeRenameFile:
+            if ( ! values.empty() ) {
+                files_[values[0]] = record.sequence;
+            }
+            break;
+        default:
+            //  the folders change the paths in the share only
+            break;
+        }
+    }
+
+
+    //  the entries of the records behind stay
+    static void
+    UntrackValue(
+            map<string, unsigned long long> & sequences,
+            const string & value,
+            unsigned long long sequence)
+    {
+        map<string, unsigned long long>::iterator i = sequences.find(value);
+        if ( i != sequences.end() && i->second <= sequence ) {
+            sequences.erase(i);
+        }
+    }
+
+
+    void
+    CatalogJournal::Untrack(const CatalogRecord & record)
+    {
+        const vector<string> & values = record.values;
+        switch ( record.type ) {
+        case CatalogRecord::TypeAddFiles:
+            for ( size_t i = 0; i + CatalogRecord::FileValues <= values.size();
+                    i += CatalogRecord::FileValues ) {
+                UntrackValue(tapes_, values[i], record.sequence);
+                UntrackValue(files_, values[i+1], record.sequence);
+            }
+            break;
+        case CatalogRecord::TypeDeleteFile:
+        case CatalogRecord::TypeRenameFile:
+            if ( ! values.empty() ) {
+                UntrackValue(files_, values[0], record.sequence);
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+
+    void
+    CatalogJournal::Run()
+    {
+        int retry = 0;
+        boost::unique_lock<boost::mutex> lock(mutex_);
+        while ( true ) {
+            CheckLag();
+            if ( pending_.empty() ) {
+                applied_.timed_wait( lock,
+                        boost::posix_time::seconds(1) );
+                continue;
+            }
+
+            vector<CatalogRecord> records( pending_.begin(),
+                    pending_.begin() + min(pending_.size(), ApplyRecords) );
+            lock.unlock();
+            size_t count = applier_->Apply(records);
+            if ( count > records.size() ) {
+                count = records.size();
+            }
+            if ( count > 0 && ! SetApplied(records[count-1].sequence) ) {
+                //  applied again after the next start
+                LogWarn(records[count-1].sequence << " is not recorded");
+            }
+            if ( count == 0 ) {
+                if ( 0 == retry ) {
+                    LogWarn("Catalog is not available, "
+                            << records.size() << " changes wait");
+                }
+                retry = min( max(retry * 2, RetryMin), RetryMax );
+                boost::this_thread::sleep(
+                        boost::posix_time::milliseconds(retry) );
+                lock.lock();
+                continue;
+            }
+            if ( retry > 0 ) {
+                LogInfo("Catalog is available again");
+                retry = 0;
+            }
+            lock.lock();
+
+            pending_.erase(pending_.begin(), pending_.begin() + count);
+            sequenceApplied_ = records[count-1].sequence;
+            for ( size_t i = 0; i < count; ++ i ) {
+                Untrack(records[i]);
+            }
+            applied_.notify_all();
+
+            //  all of it is applied, the sequence is kept in the other file
+            if ( pending_.empty() && ! writing_ && size_ > CompactSize ) {
+                if ( 0 == ::ftruncate(handle_, 0) ) {
+                    size_ = 0;
+                } else {
+                    LogError(pathname_ << " fails to truncate: "
+                            << strerror(errno));
+                }
+            }
+        }
+    }
+
+
+    static void
+    EncodeValue(unsigned long long value, string & buffer)
+    {
+        buffer.append((const char *)&value, sizeof(value));
+    }
+
+
+    static void
+    EncodeValue(const string & value, string & buffer)
+    {
+        uint32_t size = value.size();
+        buffer.append((const char *)&size, sizeof(size));
+        buffer.append(value);
+    }
+
+
+    static bool
+    DecodeValue(const string & buffer, size_t & offset,
+            unsigned long long & value)
+    {
+        if ( offset + sizeof(value) > buffer.size() ) {
+            return false;
+        }
+        memcpy(&value, buffer.data() + offset, sizeof(value));
+        offset += sizeof(value);
+        return true;
+    }
+
+
+    static bool
+    DecodeValue(const string & buffer, size_t & offset, string & value)
+    {
+        uint32_t size = 0;
+        if ( offset + sizeof(size) > buffer.size() ) {
+            return false;
+        }
+        memcpy(&size, buffer.data() + offset, sizeof(size));
+        offset += sizeof(size);
+        if ( offset + size > buffer.size() ) {
+            return false;
+        }
+        value.assign(buffer, offset, size);
+        offset += size;
+        return true;
+    }
+
+
+    void
+    CatalogJournal::Encode(const CatalogRecord & record, string & buffer)
+    {
+        EncodeValue(record.sequence, buffer);
+        EncodeValue(record.time, buffer);
+        EncodeValue(record.type, buffer);
+        EncodeValue(record.share, buffer);
+        EncodeValue(record.values.size(), buffer);
+        for ( size_t i = 0; i < record.values.size(); ++ i ) {
+            EncodeValue(record.values[i], buffer);
+        }
+    }
+
+
+    bool
+    CatalogJournal::Decode(const string & buffer, CatalogRecord & record)
+    {
+        size_t offset = 0;
+        unsigned long long time = 0;
+        unsigned long long type = 0;
+        unsigned long long count = 0;
+        if ( ! DecodeValue(buffer, offset, record.sequence)
+                || ! DecodeValue(buffer, offset, time)
+                || ! DecodeValue(buffer, offset, type)
+                || ! DecodeValue(buffer, offset, record.share)
+                || ! DecodeValue(buffer, offset, count) ) {
+            return false;
+        }
+        record.time = time;
+        record.type = type;
+        record.values.clear();
+        for ( unsigned long long i = 0; i < count; ++ i ) {
+            string value;
+            if ( ! DecodeValue(buffer, offset, value) ) {
+                return false;
+            }
+            record.values.push_back(value);
+        }
+        return offset == buffer.size();
+    }
+
+}
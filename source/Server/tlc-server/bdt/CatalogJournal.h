@@ -0,0 +1,200 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * CatalogJournal.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+
+#pragma once
+
+
+#include <deque>
+
+
+namespace bdt
+{
+
+    //  A change of the catalog as it is kept in the journal
+    struct CatalogRecord
+    {
+        enum Type {
+            TypeNone = 0,
+            //  every copy is tape, number, path, offset, size, pack,
+            //  position in values
+            TypeAddFiles,
+            //  number
+            TypeDeleteFile,
+            //  path
+            TypeDeleteFolder,
+            //  number, path
+            TypeRenameFile,
+            //  path from, path to
+            TypeRenameFolder,
+        };
+
+        //  the values of a copy in TypeAddFiles
+        static const size_t FileValues = 7;
+
+        unsigned long long sequence;
+        time_t time;
+        int type;
+        string share;
+        vector<string> values;
+    };
+
+
+    class CatalogApplierInterface
+    {
+    public:
+        CatalogApplierInterface()
+        {
+        }
+
+        virtual
+        ~CatalogApplierInterface()
+        {
+        }
+
+        //  applies some of the records from the first one in order and
+        //  returns how many, none while the catalog is not available. The
+        //  records of the last call are applied again after a crash, the
+        //  catalog has to end up as if they were applied once.
+        virtual size_t
+        Apply(const vector<CatalogRecord> & records) = 0;
+    };
+
+
+    //  Write-behind journal of the catalog changes. A change is appended
+    //  and synced to the journal before Append returns; the appenders
+    //  waiting meanwhile are synced together with the next write. A thread
+    //  applies the records in order and syncs the sequence of the last one
+    //  applied, a restart applies the records behind it. While the catalog
+    //  is not available the records are retried, and once the oldest one
+    //  is older than lag seconds an alarm is logged until it is applied.
+    class CatalogJournal
+    {
+    public:
+        CatalogJournal(
+                const fs::path & pathname,
+                CatalogApplierInterface * applier,
+                int lag );
+
+        ~CatalogJournal();
+
+        bool
+        Append(const CatalogRecord & record);
+
+        //  waits at most timeout milliseconds until the records appended
+        //  before are applied
+        bool
+        Flush(int timeout);
+
+        //  waits like Flush, only while a record not applied yet adds,
+        //  deletes or renames the file number
+        bool
+        FlushFile(int timeout, const string & number);
+
+        //  waits like Flush, only while a record not applied yet adds
+        //  files to the tape
+        bool
+        FlushTape(int timeout, const string & tape);
+
+        //  the file numbers the records not applied yet delete
+        void
+        GetPendingDeletes(vector<string> & numbers);
+
+        //  records appended and not applied yet
+        size_t
+        GetPending();
+
+        bool
+        IsLagging();
+
+    private:
+        struct Group
+        {
+            Group()
+            : done(false), ok(false)
+            {
+            }
+
+            vector<CatalogRecord> records;
+            bool done;
+            bool ok;
+        };
+
+        fs::path pathname_;
+        fs::path pathApplied_;
+        CatalogApplierInterface * applier_;
+        int lag_;
+
+        boost::mutex mutex_;
+        boost::condition_variable written_;
+        boost::condition_variable applied_;
+        int handle_;
+        int handleApplied_;
+        off_t size_;
+        unsigned long long sequence_;
+        unsigned long long sequenceApplied_;
+        boost::shared_ptr<Group> group_;
+        bool writing_;
+        deque<CatalogRecord> pending_;
+        bool lagging_;
+
+        typedef map<string, unsigned long long> MapSequenceType;
+        //  the sequence of the last record in pending_ for a file number,
+        //  and for a tape
+        MapSequenceType files_;
+        MapSequenceType tapes_;
+
+        auto_ptr<boost::thread> thread_;
+
+        void
+        Load();
+
+        bool
+        Write(vector<CatalogRecord> & records);
+
+        bool
+        SetApplied(unsigned long long sequence);
+
+        void
+        CheckLag();
+
+        void
+        Track(const CatalogRecord & record);
+
+        void
+        Untrack(const CatalogRecord & record);
+
+        bool
+        WaitApplied(
+                boost::unique_lock<boost::mutex> & lock,
+                unsigned long long sequence,
+                int timeout);
+
+        void
+        Run();
+
+        static void
+        Encode(const CatalogRecord & record, string & buffer);
+
+        static bool
+        Decode(const string & buffer, CatalogRecord & record);
+    };
+
+}
@@ -43,12 +43,18 @@ namespace bdt
     const string Configure::CacheFreeMaxPercent("CacheFreeMaxPercent");
     const string Configure::CacheFileSizeRead("CacheFileSizeRead");
     const string Configure::CacheFileSizeBlock("CacheFileSizeBlock");
+    const string Configure::CacheBitmapSaveBlocks("CacheBitmapSaveBlocks");
+    const string Configure::CacheBitmapSaveInterval("CacheBitmapSaveInterval");
+    const string Configure::CacheCapacitySyncInterval("CacheCapacitySyncInterval");
+    const string Configure::CacheCapacitySyncSize("CacheCapacitySyncSize");
+    const string Configure::CacheNumberReserveCount("CacheNumberReserveCount");
     const string Configure::CacheWriteMode("CacheWriteMode");
     const string Configure::FileMaxSize("FileMaxSize");
     const string Configure::TapeIdleTime("TapeIdleTime");
     const string Configure::FileIdleTime("FileIdleTime");
     const string Configure::DigestMD5Enable("DigestMD5Enable");
     const string Configure::DigestSHA1Enable("DigestSHA1Enable");
+    const string Configure::DigestWindowSize("DigestWindowSize");
     const string Configure::ThrottleInterval("ThrottleInterval");
     const string Configure::ThrottleValve("ThrottleValve");
     const string Configure::BackupWaitSize("WriteToTapeWaitSize");
@@ -63,6 +69,8 @@ namespace bdt
     const string Configure::ChangerSyncMode("ChangerSyncMode");
     const string Configure::CachePurgeWaitTime("CachePurgeWaitTime");
     const string Configure::CachePurgeWaitFile("CachePurgeWaitFile");
+    const string Configure::CachePurgeBatchCount("CachePurgeBatchCount");
+    const string Configure::CacheEvictionSaveInterval("CacheEvictionSaveInterval");
     const string Configure::TapeAuditorRunAt("TapeAuditorRun");
     const string Configure::TapeAuditorMaxnum("TapeAuditorMaxnum");
     const string Configure::TapeAuditorInterval("TapeAuditorInterval");
@@ -73,7 +81,25 @@ namespace bdt
     const string Configure::IgnoreWriteByReadCheckTime("IgnoreWriteByReadCheckTime");
     const string Configure::IgnoreWriteByReadPercent("IgnoreWriteByReadPercent");
     const string Configure::BackupMultipleWaitTime("WriteToTapeMultipleWaitTime");
+    const string Configure::BackupBufferCount("WriteToTapeBufferCount");
+    const string Configure::BackupPackFileSize("WriteToTapePackFileSize");
+    const string Configure::BackupPackSize("WriteToTapePackSize");
     const string Configure::AutoReformatFreePercent("AutoReformatFreePercent");
+    const string Configure::FuseEntryTimeout("FuseEntryTimeout");
+    const string Configure::FuseAttrTimeout("FuseAttrTimeout");
+    const string Configure::AttributeCacheSize("AttributeCacheSize");
+    const string Configure::AttributeCacheTimeout("AttributeCacheTimeout");
+    const string Configure::ThrottleClientValve("ThrottleClientValve");
+    const string Configure::ThrottleClientKey("ThrottleClientKey");
+    const string Configure::RecallQueueWindow("RecallQueueWindow");
+    const string Configure::ReadTaskThreads("ReadTaskThreads");
+    const string Configure::ReadTaskTapeLimit("ReadTaskTapeLimit");
+    const string Configure::ReadTaskBufferSize("ReadTaskBufferSize");
+    const string Configure::ReadTaskBufferCount("ReadTaskBufferCount");
+    const string Configure::CatalogJournalLag("CatalogJournalLag");
+    const string Configure::TapeOrderIndexTapes("TapeOrderIndexTapes");
+    const string Configure::RpcChannelConnections("RpcChannelConnections");
+    const string Configure::RpcChannelBinary("RpcChannelBinary");
 
     static const unsigned long long defaultMetaFreeLeastSize =
             1LL * 1024 * 1024 * 1024;
@@ -93,12 +119,20 @@ namespace bdt
     static const unsigned long long defaultCacheFileSizeRead =
             4LL * 1024 * 1024 * 1024;
     static const int defaultCacheFileSizeBlock = 128 * 1024 * 1024;
+    static const int defaultCacheBitmapSaveBlocks = 4;
+    static const int defaultCacheBitmapSaveInterval = 1000;
+    static const int defaultCacheCapacitySyncInterval = 1000;
+    static const unsigned long long defaultCacheCapacitySyncSize =
+            1LL * 1024 * 1024 * 1024;
+    static const int defaultCacheNumberReserveCount = 4096;
     static const int defaultCacheWriteMode = true;
     static const unsigned long long defaultFileMaxSize = 0;
     static const int defaultTapeIdleTime = 10;
     static const int defaultFileIdleTime = 3;
     static const bool defaultDigestMD5Enable = true;
     static const bool defaultDigestSHA1Enable = true;
+    static const unsigned long long defaultDigestWindowSize =
+            16LL * 1024 * 1024;
     static const int defaultThrottleInterval = 1000;
     static const unsigned long long defaultThrottleValve = 256LL * 1024 * 1024;
     static const unsigned long long defaultBackupWaitSize =
@@ -114,6 +148,8 @@ namespace bdt
     static const bool defaultChangerSyncMode = false;
     static const int defaultCachePurgeWaitTime = 5;
     static const int defaultCachePurgeWaitFile = 600;
+    static const int defaultCachePurgeBatchCount = 10000;
+    static const int defaultCacheEvictionSaveInterval = 1000;
     static const string defaultTapeAuditorRun = "01:01";
     static const int defaultTapeAuditorMaxnum = 2;
     static const int defaultTapeAuditorInterval = 3;
@@ -124,7 +160,26 @@ namespace bdt
     static const unsigned long defaultIgnoreWriteByReadCheckTime = 300;
     static const unsigned long defaultIgnoreWriteByReadPercent = 80;
     static const int defaultBackupMultipleWaitTime = 30 * 60;
+    static const int defaultBackupBufferCount = 8;
+    static const unsigned long long defaultBackupPackFileSize = 0;
+    static const unsigned long long defaultBackupPackSize =
+            1LL * 1024 * 1024 * 1024;
     static const unsigned long long defaultAutoReformatFreePercent = 40;
+    static const int defaultFuseEntryTimeout = 1;
+    static const int defaultFuseAttrTimeout = 1;
+    static const unsigned long long defaultAttributeCacheSize = 64 * 1024;
+    static const int defaultAttributeCacheTimeout = 5;
+    static const unsigned long long defaultThrottleClientValve = 0;
+    static const string defaultThrottleClientKey("pid");
+    static const int defaultRecallQueueWindow = 200;
+    static const int defaultReadTaskThreads = 16;
+    static const int defaultReadTaskTapeLimit = 1;
+    static const int defaultReadTaskBufferSize = 512 * 1024;
+    static const int defaultReadTaskBufferCount = 2;
+    static const int defaultCatalogJournalLag = 5 * 60;
+    static const int defaultTapeOrderIndexTapes = 4;
+    static const int defaultRpcChannelConnections = 4;
+    static const bool defaultRpcChannelBinary = true;
 
 
     Configure::Configure()
@@ -162,6 +217,21 @@ namespace bdt
         setting_.insert( MapType::value_type(
                 Configure::CacheFileSizeBlock,
                 boost::lexical_cast<string>(defaultCacheFileSizeBlock)));
+        setting_.insert( MapType::value_type(
+                Configure::CacheBitmapSaveBlocks,
+                boost::lexical_cast<string>(defaultCacheBitmapSaveBlocks)));
+        setting_.insert( MapType::value_type(
+                Configure::CacheBitmapSaveInterval,
+                boost::lexical_cast<string>(defaultCacheBitmapSaveInterval)));
+        setting_.insert( MapType::value_type(
+                Configure::CacheCapacitySyncInterval,
+                boost::lexical_cast<string>(defaultCacheCapacitySyncInterval)));
+        setting_.insert( MapType::value_type(
+                Configure::CacheCapacitySyncSize,
+                boost::lexical_cast<string>(defaultCacheCapacitySyncSize)));
+        setting_.insert( MapType::value_type(
+                Configure::CacheNumberReserveCount,
+                boost::lexical_cast<string>(defaultCacheNumberReserveCount)));
         setting_.insert( MapType::value_type(
                 Configure::CacheWriteMode,
                 boost::lexical_cast<string>(defaultCacheWriteMode)));
@@ -180,6 +250,9 @@ namespace bdt
         setting_.insert( MapType::value_type(
                 Configure::DigestSHA1Enable,
                 boost::lexical_cast<string>(defaultDigestSHA1Enable)));
+        setting_.insert( MapType::value_type(
+                Configure::DigestWindowSize,
+                boost::lexical_cast<string>(defaultDigestWindowSize)));
         setting_.insert( MapType::value_type(
                 Configure::ThrottleInterval,
                 boost::lexical_cast<string>(defaultThrottleInterval)));
@@ -222,6 +295,12 @@ namespace bdt
         setting_.insert( MapType::value_type(
                 Configure::CachePurgeWaitFile,
                 boost::lexical_cast<string>(defaultCachePurgeWaitFile)));
+        setting_.insert( MapType::value_type(
+                Configure::CachePurgeBatchCount,
+                boost::lexical_cast<string>(defaultCachePurgeBatchCount)));
+        setting_.insert( MapType::value_type(
+                Configure::CacheEvictionSaveInterval,
+                boost::lexical_cast<string>(defaultCacheEvictionSaveInterval)));
         setting_.insert( MapType::value_type(
                 Configure::TapeAuditorRunAt,
                 defaultTapeAuditorRun));
@@ -252,6 +331,60 @@ namespace bdt
         setting_.insert( MapType::value_type(
                 Configure::BackupMultipleWaitTime,
                 boost::lexical_cast<string>(defaultBackupMultipleWaitTime)));
+        setting_.insert( MapType::value_type(
+                Configure::BackupBufferCount,
+                boost::lexical_cast<string>(defaultBackupBufferCount)));
+        setting_.insert( MapType::value_type(
+                Configure::BackupPackFileSize,
+                boost::lexical_cast<string>(defaultBackupPackFileSize)));
+        setting_.insert( MapType::value_type(
+                Configure::BackupPackSize,
+                boost::lexical_cast<string>(defaultBackupPackSize)));
+        setting_.insert( MapType::value_type(
+                Configure::FuseEntryTimeout,
+                boost::lexical_cast<string>(defaultFuseEntryTimeout)));
+        setting_.insert( MapType::value_type(
+                Configure::FuseAttrTimeout,
+                boost::lexical_cast<string>(defaultFuseAttrTimeout)));
+        setting_.insert( MapType::value_type(
+                Configure::AttributeCacheSize,
+                boost::lexical_cast<string>(defaultAttributeCacheSize)));
+        setting_.insert( MapType::value_type(
+                Configure::AttributeCacheTimeout,
+                boost::lexical_cast<string>(defaultAttributeCacheTimeout)));
+        setting_.insert( MapType::value_type(
+                Configure::ThrottleClientValve,
+                boost::lexical_cast<string>(defaultThrottleClientValve)));
+        setting_.insert( MapType::value_type(
+                Configure::ThrottleClientKey,
+                defaultThrottleClientKey));
+        setting_.insert( MapType::value_type(
+                Configure::RecallQueueWindow,
+                boost::lexical_cast<string>(defaultRecallQueueWindow)));
+        setting_.insert( MapType::value_type(
+                Configure::ReadTaskThreads,
+                boost::lexical_cast<string>(defaultReadTaskThreads)));
+        setting_.insert( MapType::value_type(
+                Configure::ReadTaskTapeLimit,
+                boost::lexical_cast<string>(defaultReadTaskTapeLimit)));
+        setting_.insert( MapType::value_type(
+                Configure::ReadTaskBufferSize,
+                boost::lexical_cast<string>(defaultReadTaskBufferSize)));
+        setting_.insert( MapType::value_type(
+                Configure::ReadTaskBufferCount,
+                boost::lexical_cast<string>(defaultReadTaskBufferCount)));
+        setting_.insert( MapType::value_type(
+                Configure::CatalogJournalLag,
+                boost::lexical_cast<string>(defaultCatalogJournalLag)));
+        setting_.insert( MapType::value_type(
+                Configure::TapeOrderIndexTapes,
+                boost::lexical_cast<string>(defaultTapeOrderIndexTapes)));
+        setting_.insert( MapType::value_type(
+                Configure::RpcChannelConnections,
+                boost::lexical_cast<string>(defaultRpcChannelConnections)));
+        setting_.insert( MapType::value_type(
+                Configure::RpcChannelBinary,
+                boost::lexical_cast<string>(defaultRpcChannelBinary)));
     }
 
 
@@ -358,7 +491,7 @@ namespace bdt
         return value;
 #else
         if ( name == ThrottleInterval || name == ThrottleValve
-                || name == BackupWaitFile ) {
+                || name == BackupWaitFile || name == BackupPackFileSize ) {
             string shareConfPrefix = ConfigPrefix + "ShareRetention."
                     + Factory::GetService() + ".";
             UInt64_t result = 0;
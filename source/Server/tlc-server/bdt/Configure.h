@@ -46,12 +46,18 @@ namespace bdt
         static const string CacheFreeMaxPercent;
         static const string CacheFileSizeRead;
         static const string CacheFileSizeBlock;
+        static const string CacheBitmapSaveBlocks;
+        static const string CacheBitmapSaveInterval;
+        static const string CacheCapacitySyncInterval;
+        static const string CacheCapacitySyncSize;
+        static const string CacheNumberReserveCount;
         static const string CacheWriteMode;
         static const string FileMaxSize;
         static const string TapeIdleTime;
         static const string FileIdleTime;
         static const string DigestMD5Enable;
         static const string DigestSHA1Enable;
+        static const string DigestWindowSize;
         static const string ThrottleInterval;
         static const string ThrottleValve;
         static const string BackupWaitSize;
@@ -66,6 +72,8 @@ namespace bdt
         static const string ChangerSyncMode;
         static const string CachePurgeWaitTime;
         static const string CachePurgeWaitFile;
+        static const string CachePurgeBatchCount;
+        static const string CacheEvictionSaveInterval;
         static const string TapeAuditorRunAt;
         static const string TapeAuditorMaxnum;
         static const string TapeAuditorInterval;
@@ -76,7 +84,25 @@ namespace bdt
         static const string IgnoreWriteByReadCheckTime;
         static const string IgnoreWriteByReadPercent;
         static const string BackupMultipleWaitTime;
+        static const string BackupBufferCount;
+        static const string BackupPackFileSize;
+        static const string BackupPackSize;
         static const string AutoReformatFreePercent;
+        static const string FuseEntryTimeout;
+        static const string FuseAttrTimeout;
+        static const string AttributeCacheSize;
+        static const string AttributeCacheTimeout;
+        static const string ThrottleClientValve;
+        static const string ThrottleClientKey;
+        static const string RecallQueueWindow;
+        static const string ReadTaskThreads;
+        static const string ReadTaskTapeLimit;
+        static const string ReadTaskBufferSize;
+        static const string ReadTaskBufferCount;
+        static const string CatalogJournalLag;
+        static const string TapeOrderIndexTapes;
+        static const string RpcChannelConnections;
+        static const string RpcChannelBinary;
 
         string
         GetValue(const string & name);
@@ -0,0 +1,396 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * EvictionIndex.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+
+
+#include "stdafx.h"
+#include "EvictionIndex.h"
+
+
+namespace bdt
+{
+
+    //  a small journal is not worth rewriting
+    static const size_t CompactLeast = 4096;
+
+    //  the records are split at tabs and new lines, which a file name may
+    //  have as well
+    static string
+    EscapePath(const string & path)
+    {
+        string value;
+        value.reserve(path.size());
+        BOOST_FOREACH( char c, path ) {
+            switch ( c ) {
+            case '\\':
+                value += "\\\\";
+                break;
+            case '\t':
+                value += "\\t";
+                break;
+            case '\n':
+                value += "\\n";
+                break;
+            default:
+                value += c;
+                break;
+            }
+        }
+        return value;
+    }
+
+
+    static string
+    UnescapePath(const string & value)
+    {
+        string path;
+        path.reserve(value.size());
+        for ( size_t i = 0; i < value.size(); ++ i ) {
+            if ( value[i] != '\\' || i + 1 == value.size() ) {
+                path += value[i];
+                continue;
+            }
+            switch ( value[++ i] ) {
+            case 't':
+                path += '\t';
+                break;
+            case 'n':
+                path += '\n';
+                break;
+            default:
+                path += value[i];
+                break;
+            }
+        }
+        return path;
+    }
+
+
+    EvictionIndex::EvictionIndex(const fs::path & pathname, int interval)
+    : pathname_(pathname),
+      interval_(interval),
+      records_(0),
+      saved_(boost::posix_time::microsec_clock::universal_time()),
+      compacting_(false)
+    {
+        boost::unique_lock<boost::mutex> lock(mutex_);
+        if ( ! Load() ) {
+            LogWarn(pathname_ << " fails to load");
+        } else if ( records_ > 2 * index_.size() + CompactLeast ) {
+            Compact(lock);
+        }
+    }
+
+
+    EvictionIndex::~EvictionIndex()
+    {
+        Save();
+    }
+
+
+    void
+    EvictionIndex::Touch(const fs::path & path, time_t atime)
+    {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+
+        TouchUnlock(path.string(), atime);
+        journal_ += "T\t" + boost::lexical_cast<string>(atime)
+                + "\t" + EscapePath(path.string()) + "\n";
+        ++ records_;
+
+        if ( interval_ <= 0 || (
+                boost::posix_time::microsec_clock::universal_time()
+                - saved_ ).total_milliseconds() >= interval_ ) {
+            SaveUnlock();
+        }
+    }
+
+
+    void
+    EvictionIndex::Remove(const fs::path & path)
+    {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+
+        if ( index_.find(path.string()) == index_.end() ) {
+            return;
+        }
+        RemoveUnlock(path.string());
+        journal_ += "D\t" + EscapePath(path.string()) + "\n";
+        ++ records_;
+    }
+
+
+    void
+    EvictionIndex::Rename(const fs::path & from, const fs::path & to)
+    {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+
+        RenameUnlock(from.string(), to.string());
+        journal_ += "M\t" + EscapePath(from.string()) + "\n"
+                + "N\t" + EscapePath(to.string()) + "\n";
+        records_ += 2;
+    }
+
+
+    void
+    EvictionIndex::GetOldest(
+            size_t count,
+            vector<EvictionItem> & items,
+            const fs::path & after)
+    {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+
+        ListItemType::iterator begin = items_.begin();
+        if ( ! after.empty() ) {
+            MapItemType::iterator i = index_.find(after.string());
+            if ( i != index_.end() ) {
+                begin = i->second;
+                ++ begin;
+            }
+        }
+        for ( ListItemType::iterator i = begin;
+                i != items_.end() && items.size() < count;
+                ++ i ) {
+            items.push_back(*i);
+        }
+    }
+
+
+    size_t
+    EvictionIndex::Size()
+    {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+        return index_.size();
+    }
+
+
+    bool
+    EvictionIndex::Save()
+    {
+        boost::unique_lock<boost::mutex> lock(mutex_);
+
+        if ( compacting_ ) {
+            return true;
+        }
+        if ( records_ > 2 * index_.size() + CompactLeast ) {
+            saved_ = boost::posix_time::microsec_clock::universal_time();
+            return Compact(lock);
+        }
+        return SaveUnlock();
+    }
+
+
+    bool
+    EvictionIndex::Load()
+    {
+        if ( ! fs::exists(pathname_) ) {
+            return true;
+        }
+
+        ifstream input(pathname_.string().c_str());
+        if ( ! input ) {
+            return false;
+        }
+
+        //  a record cut short by a crash names a path nobody has, it ages
+        //  out like any other stale entry
+        string line;
+        string from;
+        while ( getline(input,line) ) {
+            ++ records_;
+            if ( line.size() < 2 || line[1] != '\t' ) {
+                LogWarn(pathname_ << " has invalid record " << line);
+                continue;
+            }
+            string value = line.substr(2);
+            switch ( line[0] ) {
+            case 'T': {
+                string::size_type tab = value.find('\t');
+                if ( tab == string::npos ) {
+                    LogWarn(pathname_ << " has invalid record " << line);
+                    break;
+                }
+                TouchUnlock( UnescapePath(value.substr(tab + 1)),
+                        strtoll(value.substr(0,tab).c_str(), NULL, 10) );
+                break;
+            }
+            case 'D':
+                RemoveUnlock(UnescapePath(value));
+                break;
+            case 'M':
+                from = UnescapePath(value);
+                break;
+            case 'N':
+                RenameUnlock(from,UnescapePath(value));
+                break;
+            default:
+                LogWarn(pathname_ << " has invalid record " << line);
+                break;
+            }
+        }
+
+        LogInfo(pathname_ << " has " << index_.size() << " entries in "
+                << records_ << " records");
+        return true;
+    }
+
+
+    void
+    EvictionIndex::TouchUnlock(const string & path, time_t atime)
+    {
+        MapItemType::iterator i = index_.find(path);
+        if ( i == index_.end() ) {
+            EvictionItem item;
+            item.path = path;
+            item.atime = atime;
+            index_.insert( MapItemType::value_type(
+                    path, items_.insert(items_.end(), item) ) );
+            return;
+        }
+        i->second->atime = atime;
+        items_.splice(items_.end(), items_, i->second);
+    }
+
+
+    void
+    EvictionIndex::RemoveUnlock(const string & path)
+    {
+        MapItemType::iterator i = index_.find(path);
+        if ( i == index_.end() ) {
+            return;
+        }
+        items_.erase(i->second);
+        index_.erase(i);
+    }
+
+
+    void
+    EvictionIndex::RenameUnlock(const string & from, const string & to)
+    {
+        if ( from == to ) {
+            return;
+        }
+
+        //  the entries below a folder are adjacent in the index
+        vector<MapItemType::iterator> moves;
+        MapItemType::iterator i = index_.find(from);
+        if ( i != index_.end() ) {
+            moves.push_back(i);
+        }
+        string prefix = from + "/";
+        for ( i = index_.lower_bound(prefix);
+                i != index_.end()
+                && 0 == i->first.compare(0, prefix.size(), prefix);
+                ++ i ) {
+            moves.push_back(i);
+        }
+        if ( moves.empty() ) {
+            return;
+        }
+
+        vector<pair<string, ListItemType::iterator> > targets;
+        BOOST_FOREACH( MapItemType::iterator move, moves ) {
+            targets.push_back( make_pair(
+                    to + move->first.substr(from.size()), move->second ) );
+            index_.erase(move);
+        }
+
+        //  a file renamed over another one replaces it, as do the files
+        //  below a folder over the ones left in the target folder
+        for ( size_t j = 0; j < targets.size(); ++ j ) {
+            RemoveUnlock(targets[j].first);
+            targets[j].second->path = targets[j].first;
+            index_.insert( MapItemType::value_type(
+                    targets[j].first, targets[j].second ) );
+        }
+    }
+
+
+    bool
+    EvictionIndex::SaveUnlock()
+    {
+        saved_ = boost::posix_time::microsec_clock::universal_time();
+
+        //  the changes wait for the rewritten journal
+        if ( compacting_ || journal_.empty() ) {
+            return true;
+        }
+
+        ofstream output(
+                pathname_.string().c_str(),
+                ios::out|ios::app|ios::binary );
+        output.write(journal_.data(), journal_.size());
+        output.close();
+        if ( ! output ) {
+            LogError(pathname_ << " fails to save");
+            return false;
+        }
+        journal_.clear();
+        return true;
+    }
+
+
+    bool
+    EvictionIndex::Compact(boost::unique_lock<boost::mutex> & lock)
+    {
+        //  the entries are written out of the lock, the changes made
+        //  meanwhile are kept for the rewritten journal
+        vector<EvictionItem> items(items_.begin(), items_.end());
+        string journal;
+        journal.swap(journal_);
+        size_t records = records_;
+        records_ = items.size();
+        compacting_ = true;
+        lock.unlock();
+
+        bool ret = true;
+        fs::path pathname = pathname_.string() + ".new";
+        {
+            ofstream output(
+                    pathname.string().c_str(),
+                    ios::out|ios::trunc|ios::binary );
+            BOOST_FOREACH( const EvictionItem & item, items ) {
+                output << "T\t" << item.atime << "\t"
+                        << EscapePath(item.path.string()) << "\n";
+            }
+            output.close();
+            if ( ! output ) {
+                LogError(pathname << " fails to save");
+                ret = false;
+            }
+        }
+
+        if ( ret && 0 != ::rename(
+                pathname.string().c_str(),
+                pathname_.string().c_str() ) ) {
+            LogError(pathname << " fails to rename to " << pathname_);
+            ret = false;
+        }
+
+        lock.lock();
+        compacting_ = false;
+        if ( ! ret ) {
+            journal_ = journal + journal_;
+            records_ += records - items.size();
+        }
+        return ret;
+    }
+
+}
@@ -0,0 +1,110 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * EvictionIndex.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+
+
+#pragma once
+
+
+namespace bdt
+{
+
+    struct EvictionItem
+    {
+        fs::path path;
+        time_t atime;
+    };
+
+
+    //  Files of a service in the order of their last access, the least
+    //  recently used first. The changes are appended to a journal which
+    //  is written at most every interval milliseconds and replayed on
+    //  load; once the journal holds more than twice the records needed
+    //  for the current entries Save rewrites it from them, the changes
+    //  go on meanwhile.
+    class EvictionIndex
+    {
+    public:
+        EvictionIndex(const fs::path & pathname, int interval);
+
+        ~EvictionIndex();
+
+        void
+        Touch(const fs::path & path, time_t atime);
+
+        void
+        Remove(const fs::path & path);
+
+        //  a folder moves all the entries below it
+        void
+        Rename(const fs::path & from, const fs::path & to);
+
+        //  continues after the entry of after, from the oldest entry when
+        //  after is empty or no longer in the index
+        void
+        GetOldest(
+                size_t count,
+                vector<EvictionItem> & items,
+                const fs::path & after = fs::path());
+
+        size_t
+        Size();
+
+        //  called from the background, it may rewrite the journal
+        bool
+        Save();
+
+    private:
+        typedef list<EvictionItem> ListItemType;
+        typedef map<string, ListItemType::iterator> MapItemType;
+
+        boost::mutex mutex_;
+
+        fs::path pathname_;
+        int interval_;
+
+        ListItemType items_;
+        MapItemType index_;
+
+        string journal_;
+        size_t records_;
+        boost::posix_time::ptime saved_;
+        bool compacting_;
+
+        bool
+        Load();
+
+        void
+        TouchUnlock(const string & path, time_t atime);
+
+        void
+        RemoveUnlock(const string & path);
+
+        void
+        RenameUnlock(const string & from, const string & to);
+
+        bool
+        SaveUnlock();
+
+        bool
+        Compact(boost::unique_lock<boost::mutex> & lock);
+    };
+
+}
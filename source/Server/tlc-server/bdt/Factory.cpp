@@ -30,10 +30,13 @@
 #include "ScheduleProxy.h"
 #include "CacheManager.h"
 #include "ReadManager.h"
+#include "CatalogJournal.h"
+#include "TapeOrderIndex.h"
 
 #ifdef MORE_TEST
 #else
 #include "BackupTapeTask.h"
+#include "CatalogApplier.h"
 #endif
 //#include "CacheMonitorTask.h"
 
@@ -129,6 +132,9 @@ namespace bdt
     auto_ptr<ReadManager> Factory::read_;
     auto_ptr<ScheduleInterface> Factory::schedule_;
     auto_ptr<tape::TapeLibraryManager> Factory::changer_;
+    auto_ptr<CatalogApplierInterface> Factory::applier_;
+    auto_ptr<CatalogJournal> Factory::journal_;
+    auto_ptr<TapeOrderIndex> Factory::order_;
 
     vector<BackendTask *> Factory::tasks_;
     auto_ptr<boost::thread_group> Factory::taskGroup_;
@@ -207,6 +213,33 @@ namespace bdt
     }
 
 
+    void
+    Factory::CreateCatalogJournal()
+    {
+        assert( NULL == journal_.get() );
+#ifdef MORE_TEST
+#else
+        applier_.reset( new CatalogApplier() );
+        journal_.reset( new CatalogJournal(
+                GetCacheFolder() / (GetService() + ".catalog"),
+                applier_.get(),
+                GetConfigure()->GetValueSize(Configure::CatalogJournalLag) ) );
+#endif
+    }
+
+
+    void
+    Factory::CreateTapeOrderIndex()
+    {
+        assert( NULL == order_.get() );
+#ifdef MORE_TEST
+#else
+        order_.reset( new TapeOrderIndex(
+                GetConfigure()->GetValueSize(Configure::TapeOrderIndexTapes) ) );
+#endif
+    }
+
+
     void
     Factory::StartBackendTasks()
     {
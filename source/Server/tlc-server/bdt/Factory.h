@@ -177,6 +177,9 @@ namespace bdt
     class ReadManager;
     class MetaManager;
     class BackupTapeTask;
+    class CatalogJournal;
+    class CatalogApplierInterface;
+    class TapeOrderIndex;
 
 
     class Factory
@@ -393,6 +396,34 @@ namespace bdt
             return changer_.get();
         }
 
+
+        static void
+        CreateCatalogJournal();
+
+        static void
+        ReleaseCatalogJournal();
+
+        //  NULL when the catalog is changed directly
+        static CatalogJournal *
+        GetCatalogJournal()
+        {
+            return journal_.get();
+        }
+
+
+        static void
+        CreateTapeOrderIndex();
+
+        static void
+        ReleaseTapeOrderIndex();
+
+        //  NULL when the tape order comes from the catalog
+        static TapeOrderIndex *
+        GetTapeOrderIndex()
+        {
+            return order_.get();
+        }
+
         static BackupTapeTask * GetBackupTask()
         {
         	if(tasks_.size() > 0){
@@ -436,6 +467,9 @@ namespace bdt
         static auto_ptr<ReadManager> read_;
         static auto_ptr<ScheduleInterface> schedule_;
         static auto_ptr<tape::TapeLibraryManager> changer_;
+        static auto_ptr<CatalogApplierInterface> applier_;
+        static auto_ptr<CatalogJournal> journal_;
+        static auto_ptr<TapeOrderIndex> order_;
 
         static vector<BackendTask *> tasks_;
         static auto_ptr<boost::thread_group> taskGroup_;
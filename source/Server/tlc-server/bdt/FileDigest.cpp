@@ -26,10 +26,20 @@
 namespace bdt
 {
 
+    //  bytes of data waiting for the digest threads
+    static const size_t queueSize = 8 * 1024 * 1024;
+
+    static const size_t zeroSize = 1024 * 1024;
+    static const char zero[zeroSize] = { 0 };
+
+
     FileDigest::FileDigest()
-    : offset_(0), size_(0), error_(false), finish_(false)
+    : window_(0)
     {
+        Init();
+
         Configure * configure = Factory::GetConfigure();
+        window_ = configure->GetValueSize(Configure::DigestWindowSize);
         try {
             if ( configure->GetValueBool(Configure::DigestMD5Enable) ) {
                 EnableDigest(DIGEST_MD5);
@@ -47,14 +57,35 @@ namespace bdt
     }
 
 
+    FileDigest::FileDigest(size_t window)
+    : window_(window)
+    {
+        Init();
+    }
+
+
     FileDigest::~FileDigest()
     {
-        for_each(
-                engine_.begin(),
-                engine_.end(),
-                boost::bind(
-                        &EVP_MD_CTX_free,
-                        boost::bind(&EngineMap::value_type::second,_1) ) );
+        Stop();
+        BOOST_FOREACH( EngineMap::value_type & engine, engine_ ) {
+            EVP_MD_CTX_free(engine.second->ctx);
+        }
+    }
+
+
+    void
+    FileDigest::Init()
+    {
+        sizePending_ = 0;
+        offset_ = 0;
+        size_ = 0;
+        error_ = false;
+        finish_ = false;
+        produced_ = 0;
+        consumed_ = 0;
+        sizeQueue_ = 0;
+        running_ = false;
+        stop_ = false;
     }
 
 
@@ -67,7 +98,7 @@ namespace bdt
 
         EngineMap::iterator i = engine_.find(digest);
         if ( i == engine_.end() ) {
-            if ( offset_ != 0 ) {
+            if ( offset_ != 0 || finish_ ) {
                 return false;
             }
 
@@ -94,7 +125,10 @@ namespace bdt
                 EVP_MD_CTX_free(ctx);
                 return false;
             }
-            engine_.insert(EngineMap::value_type(digest,ctx));
+            boost::shared_ptr<Engine> engine(new Engine);
+            engine->ctx = ctx;
+            engine->next = 0;
+            engine_.insert(EngineMap::value_type(digest,engine));
             return true;
         } else {
             return true;
@@ -106,20 +140,11 @@ namespace bdt
     FileDigest::FillPad(off_t size)
     {
         if ( size > offset_ ) {
-            char pad[4096];
-            memset(pad,0,sizeof(pad));
-            do {
-                size_t padlen = min(sizeof(pad),(size_t)(size - offset_));
-                for_each(
-                        engine_.begin(),
-                        engine_.end(),
-                        boost::bind(
-                            &EVP_DigestUpdate,
-                            boost::bind(&EngineMap::value_type::second,_1),
-                            pad,
-                            padlen) );
-                offset_ += padlen;
-            } while ( size > offset_ );
+            Extent extent;
+            extent.begin = 0;
+            extent.length = size - offset_;
+            Feed(extent);
+            offset_ = size;
             return true;
         } else {
             return false;
@@ -135,25 +160,37 @@ namespace bdt
             return false;
         }
 
+        if ( offset < offset_ ) {
+            LogDebug("Write behind the digest at " << offset);
+            error_ = true;
+            return false;
+        }
+        if ( length == 0 ) {
+            return true;
+        }
+
+        //  the last write of a place wins
+        Trim(offset,offset+length);
+
         if ( offset > offset_ ) {
-            FillPad(offset);
-        }
-
-        if ( offset == offset_ ) {
-            offset_ += length;
-            for_each(
-                    engine_.begin(),
-                    engine_.end(),
-                    boost::bind(
-                        &EVP_DigestUpdate,
-                        boost::bind(&EngineMap::value_type::second,_1),
-                        buffer,
-                        length) );
+            Keep(offset,buffer,length);
+            while ( sizePending_ > window_ ) {
+                //  too far ahead, the gap is a hole
+                FillPad(pending_.begin()->first);
+                Drain();
+            }
             return true;
         }
 
-        error_ = true;
-        return false;
+        Extent extent;
+        extent.data.reset(new char[length]);
+        memcpy(extent.data.get(),buffer,length);
+        extent.begin = 0;
+        extent.length = length;
+        Feed(extent);
+        offset_ += length;
+        Drain();
+        return true;
     }
 
 
@@ -175,6 +212,185 @@ namespace bdt
     }
 
 
+    void
+    FileDigest::Keep(off_t offset,const void * buffer,size_t length)
+    {
+        Extent extent;
+        extent.data.reset(new char[length]);
+        memcpy(extent.data.get(),buffer,length);
+        extent.begin = 0;
+        extent.length = length;
+        pending_.insert(ExtentMap::value_type(offset,extent));
+        sizePending_ += length;
+    }
+
+
+    void
+    FileDigest::Trim(off_t begin,off_t end)
+    {
+        ExtentMap::iterator i = pending_.lower_bound(begin);
+        if ( i != pending_.begin() ) {
+            -- i;
+        }
+        while ( i != pending_.end() && i->first < end ) {
+            off_t first = i->first;
+            off_t last = first + i->second.length;
+            if ( last <= begin ) {
+                ++ i;
+                continue;
+            }
+
+            Extent extent = i->second;
+            pending_.erase(i++);
+            sizePending_ -= extent.length;
+            if ( first < begin ) {
+                Extent head = extent;
+                head.length = begin - first;
+                pending_.insert(ExtentMap::value_type(first,head));
+                sizePending_ += head.length;
+            }
+            if ( last > end ) {
+                Extent tail = extent;
+                tail.begin += end - first;
+                tail.length = last - end;
+                i = pending_.insert(ExtentMap::value_type(end,tail)).first;
+                sizePending_ += tail.length;
+                ++ i;
+            }
+        }
+    }
+
+
+    void
+    FileDigest::Drain()
+    {
+        while ( ! pending_.empty() && pending_.begin()->first == offset_ ) {
+            Extent extent = pending_.begin()->second;
+            pending_.erase(pending_.begin());
+            sizePending_ -= extent.length;
+            Feed(extent);
+            offset_ += extent.length;
+        }
+    }
+
+
+    void
+    FileDigest::Update(EVP_MD_CTX * ctx,const Extent & extent)
+    {
+        if ( extent.data ) {
+            EVP_DigestUpdate(ctx,extent.data.get()+extent.begin,extent.length);
+            return;
+        }
+        for ( size_t done = 0; done < extent.length; ) {
+            size_t length = min(zeroSize,extent.length-done);
+            EVP_DigestUpdate(ctx,zero,length);
+            done += length;
+        }
+    }
+
+
+    void
+    FileDigest::Feed(const Extent & extent)
+    {
+        if ( engine_.size() <= 1 ) {
+            BOOST_FOREACH( EngineMap::value_type & engine, engine_ ) {
+                Update(engine.second->ctx,extent);
+            }
+            return;
+        }
+
+        boost::unique_lock<boost::mutex> lock(mutex_);
+        if ( ! running_ ) {
+            running_ = true;
+            BOOST_FOREACH( EngineMap::value_type & engine, engine_ ) {
+                threads_.create_thread( boost::bind(
+                        &FileDigest::DigestTask, this, engine.second ) );
+            }
+        }
+        //  a hole costs no memory
+        size_t size = extent.data ? extent.length : 0;
+        while ( sizeQueue_ > 0 && sizeQueue_ + size > queueSize ) {
+            condition_.wait(lock);
+        }
+        queue_.push_back(extent);
+        sizeQueue_ += size;
+        ++ produced_;
+        condition_.notify_all();
+    }
+
+
+    void
+    FileDigest::DigestTask(boost::shared_ptr<Engine> engine)
+    {
+        boost::unique_lock<boost::mutex> lock(mutex_);
+        while ( true ) {
+            while ( engine->next == produced_ && ! stop_ ) {
+                condition_.wait(lock);
+            }
+            if ( engine->next == produced_ ) {
+                return;
+            }
+
+            Extent extent = queue_[engine->next - consumed_];
+            lock.unlock();
+            Update(engine->ctx,extent);
+            lock.lock();
+            ++ engine->next;
+
+            //  the first extent is done once every engine has it
+            bool done = true;
+            BOOST_FOREACH( EngineMap::value_type & other, engine_ ) {
+                if ( other.second->next == consumed_ ) {
+                    done = false;
+                    break;
+                }
+            }
+            if ( done ) {
+                if ( queue_.front().data ) {
+                    sizeQueue_ -= queue_.front().length;
+                }
+                queue_.pop_front();
+                ++ consumed_;
+                condition_.notify_all();
+            }
+        }
+    }
+
+
+    void
+    FileDigest::Stop()
+    {
+        {
+            boost::lock_guard<boost::mutex> lock(mutex_);
+            if ( ! running_ ) {
+                return;
+            }
+            stop_ = true;
+        }
+        condition_.notify_all();
+        threads_.join_all();
+
+        boost::lock_guard<boost::mutex> lock(mutex_);
+        running_ = false;
+        stop_ = false;
+    }
+
+
+    void
+    FileDigest::Finish()
+    {
+        while ( ! pending_.empty() ) {
+            FillPad(pending_.begin()->first);
+            Drain();
+        }
+        if ( size_ > offset_ ) {
+            FillPad(size_);
+        }
+        //  the threads finish the queue before they stop
+        Stop();
+    }
+
+
     static string
     HexOutput(unsigned char c)
     {
@@ -206,33 +422,26 @@ namespace bdt
             return false;
         }
 
-        if ( size_ > offset_ ) {
-            FillPad(size_);
+        if ( ! finish_ ) {
+            Finish();
+            BOOST_FOREACH( EngineMap::value_type & engine, engine_ ) {
+                unsigned char digestValue[EVP_MAX_MD_SIZE];
+                unsigned int digestSize;
+                EVP_DigestFinal_ex(engine.second->ctx,digestValue,&digestSize);
+                string value;
+                for ( unsigned int i = 0; i < digestSize; ++i ) {
+                    value = value + HexOutput(digestValue[i]);
+                }
+                digest_.insert(DigestMap::value_type(engine.first,value));
+            }
+            finish_ = true;
         }
 
         DigestMap::iterator iterDigest = digest_.find(digest);
-        if ( iterDigest != digest_.end() ) {
-            checksum = iterDigest->second;
-            return true;
-        }
-
-        EngineMap::iterator iterEngine = engine_.find(digest);
-        if ( iterEngine == engine_.end() ) {
+        if ( iterDigest == digest_.end() ) {
             return false;
         }
-
-        unsigned char digestValue[EVP_MAX_MD_SIZE];
-        unsigned int digestSize;
-        EVP_DigestFinal_ex(iterEngine->second,digestValue,&digestSize);
-        EVP_MD_CTX_free(iterEngine->second);
-        engine_.erase(iterEngine);
-
-        for ( unsigned int i = 0; i < digestSize; ++i ) {
-            checksum = checksum + HexOutput(digestValue[i]);
-        }
-        digest_.insert(DigestMap::value_type(digest,checksum));
-        finish_ = true;
-
+        checksum = iterDigest->second;
         return true;
     }
 
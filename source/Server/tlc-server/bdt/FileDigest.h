@@ -22,16 +22,25 @@
 #pragma once
 
 #include <openssl/evp.h>
+#include <boost/shared_array.hpp>
+#include <deque>
 
 
 namespace bdt
 {
 
+    //  MD5 and SHA1 of a file as it is written. The writes ahead of the
+    //  digested data are kept up to the window and taken in order when
+    //  the gap is written; a gap left beyond the window, or at the end,
+    //  is a hole of zeros. A write behind the digested data spoils it.
+    //  With more than one digest each runs on a thread of its own.
     class FileDigest
     {
     public:
         FileDigest();
 
+        FileDigest(size_t window);
+
         ~FileDigest();
 
         enum {
@@ -60,22 +69,77 @@ namespace bdt
         }
 
     private:
-        typedef map<int,EVP_MD_CTX *> EngineMap;
+        //  a part of a buffer, zeros when there is no buffer
+        struct Extent
+        {
+            boost::shared_array<char> data;
+            size_t begin;
+            size_t length;
+        };
+
+        struct Engine
+        {
+            EVP_MD_CTX * ctx;
+            unsigned long long next;
+        };
+
+        typedef map<int,boost::shared_ptr<Engine> > EngineMap;
         EngineMap engine_;
 
         typedef map<int,string> DigestMap;
         DigestMap digest_;
 
+        typedef map<off_t,Extent> ExtentMap;
+        ExtentMap pending_;
+        size_t window_;
+        size_t sizePending_;
+
         off_t offset_;
         off_t size_;
 
         bool error_;
         bool finish_;
 
+        //  the queue of the digest threads
+        boost::mutex mutex_;
+        boost::condition_variable condition_;
+        boost::thread_group threads_;
+        deque<Extent> queue_;
+        unsigned long long produced_;
+        unsigned long long consumed_;
+        size_t sizeQueue_;
+        bool running_;
+        bool stop_;
+
+        void
+        Init();
+
         bool
         FillPad(off_t size);
 
+        void
+        Keep(off_t offset,const void * buffer,size_t length);
+
+        void
+        Trim(off_t begin,off_t end);
+
+        void
+        Drain();
+
+        void
+        Feed(const Extent & extent);
+
+        void
+        DigestTask(boost::shared_ptr<Engine> engine);
+
+        void
+        Finish();
+
+        void
+        Stop();
+
+        static void
+        Update(EVP_MD_CTX * ctx,const Extent & extent);
     };
 
 }
-
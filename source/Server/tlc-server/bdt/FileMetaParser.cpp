@@ -35,17 +35,10 @@ namespace bdt
     FileMetaParser::FileMetaParser()
     : isMultiple_(false), isManifest_(false)
     {
-        Py_Initialize();
-        module_ = PyImport_ImportModule("cPickle");
-        function_ = PyObject_GetAttrString(module_,"loads");
-
     }
 
     FileMetaParser::~FileMetaParser()
     {
-        Py_DECREF(function_);
-        Py_DECREF(module_);
-        Py_Finalize();
     }
 
     bool
@@ -69,8 +62,8 @@ namespace bdt
                     metaName, buffer, sizeof(buffer) - 1, size )) {
                 break;
             }
-            buffer[size] = '\0';
-            swiftContent += buffer;
+            //  a binary pickle may hold zeros
+            swiftContent.append(buffer, size);
         }
         try {
             return ParseSwift(swiftContent);
@@ -82,7 +75,7 @@ namespace bdt
     }
 
     bool
-    FileMetaParser::ParseSwift(string meta)
+    FileMetaParser::ParseSwift(const string & meta)
     {
         static const boost::regex namePattern("^(.*)/(\\d+[[.period.]]\\d+)/(\\d+)/(\\d+)/(\\d+)$");
         static const boost::regex manifestPattern("^(.*)/(\\d+[[.period.]]\\d+)/(\\d+)/(\\d+)/$");
@@ -93,27 +86,20 @@ namespace bdt
         total_ = 1;
         manifest_ = "";
 
-        PyObject * content = PyUnicode_FromString(meta.c_str());
-        PyObject * args = PyTuple_New(1);
-        PyTuple_SetItem(args, 0, content);
-        PyObject * result = PyObject_CallObject(function_,args);
-        Py_DECREF(args);
-
-        if ( result == NULL ) {
+        PickleParser::DictType result;
+        if ( ! pickle_.Parse(meta, result) ) {
             LogWarn("Cannot parse meta: " << meta);
             return false;
         }
 
-        PyObject * valueName = PyDict_GetItemString(result, SwiftKeyName.c_str());
-        if ( valueName == NULL ) {
-            Py_DECREF(result);
+        PickleParser::DictType::iterator valueName = result.find(SwiftKeyName);
+        if ( valueName == result.end() ) {
             return false;
         } else {
-            name_ = PyUnicode_AsUTF8(valueName);
+            name_ = valueName->second;
         }
 
-        PyObject * valueSingle = PyDict_GetItemString(result, SwiftKeySingle.c_str());
-        if ( valueSingle != NULL ) {
+        if ( result.find(SwiftKeySingle) != result.end() ) {
             isMultiple_ = false;
             isManifest_ = false;
             number_ = 0;
@@ -138,11 +124,12 @@ namespace bdt
             }
         }
 
-        PyObject * valueManifest = PyDict_GetItemString(result, SwiftKeyMultipleManifest.c_str());
-        if ( valueManifest != NULL ) {
+        PickleParser::DictType::iterator valueManifest =
+                result.find(SwiftKeyMultipleManifest);
+        if ( valueManifest != result.end() ) {
             isMultiple_ = true;
             isManifest_ = true;
-            manifest_ = PyUnicode_AsUTF8(valueManifest);
+            manifest_ = valueManifest->second;
             boost::smatch what;
             if ( boost::regex_match(
                     manifest_, what, manifestPattern, boost::match_extra ) ) {
@@ -160,8 +147,6 @@ namespace bdt
             }
         }
 
-        Py_DECREF(result);
-
         return true;
     }
 
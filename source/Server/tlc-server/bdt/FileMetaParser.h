@@ -22,7 +22,7 @@
 #pragma once
 
 
-#include <Python.h>
+#include "PickleParser.h"
 
 
 namespace bdt
@@ -68,8 +68,7 @@ namespace bdt
         }
 
     private:
-        PyObject * module_;
-        PyObject * function_;
+        PickleParser pickle_;
 
         string name_;
         string manifest_;
@@ -78,7 +77,7 @@ namespace bdt
         int number_;
         int total_;
 
-        bool ParseSwift(string meta);
+        bool ParseSwift(const string & meta);
     };
 
 }
@@ -45,6 +45,18 @@ namespace bdt
     }
 
 
+    FileOperationBitmap::FileOperationBitmap(
+            const fs::path & path,
+            int flags,
+            unsigned long sizeBlock,
+            int saveBlocks,
+            int saveInterval)
+    : FileOperation(path,flags), ea_(path)
+    {
+        bitmap_.reset(new Bitmap(this,sizeBlock,saveBlocks,saveInterval));
+    }
+
+
     FileOperationBitmap::~FileOperationBitmap()
     {
         if ( bitmap_->IsFull() ) {
@@ -99,6 +111,13 @@ namespace bdt
     }
 
 
+    bool
+    FileOperationBitmap::SyncData()
+    {
+        return Sync(true);
+    }
+
+
     bool
     FileOperationBitmap::Write(
             off_t offset, const void * buffer, size_t bufsize, size_t & size )
@@ -111,6 +130,21 @@ namespace bdt
     }
 
 
+    bool
+    FileOperationBitmap::WriteData(
+            off_t offset, const void * buffer, size_t bufsize, size_t & size )
+    {
+        return FileOperation::Write(offset,buffer,bufsize,size);
+    }
+
+
+    void
+    FileOperationBitmap::MarkBitmap(off_t offset,size_t size)
+    {
+        bitmap_->MarkBitmap(offset,size);
+    }
+
+
     bool
     FileOperationBitmap::Truncate(off_t length)
     {
@@ -41,12 +41,31 @@ namespace bdt
         FileOperationBitmap(
                 const fs::path & path, int flags, unsigned long sizeBlock);
 
+        //  see Bitmap for saveBlocks and saveInterval
+        FileOperationBitmap(
+                const fs::path & path,
+                int flags,
+                unsigned long sizeBlock,
+                int saveBlocks,
+                int saveInterval);
+
         virtual
         ~FileOperationBitmap();
 
         bool
         Write(off_t offset,const void * buffer,size_t bufsize,size_t & size);
 
+        //  writes the data without marking the bitmap, see MarkBitmap
+        virtual bool
+        WriteData(
+                off_t offset,
+                const void * buffer,
+                size_t bufsize,
+                size_t & size);
+
+        void
+        MarkBitmap(off_t offset,size_t size);
+
         bool
         Truncate(off_t length);
 
@@ -84,6 +103,8 @@ namespace bdt
         bool GetBitmap(void * buffer,int & size);
 
         bool SetBitmap(const void * buffer,int size);
+
+        bool SyncData();
     };
 
 }
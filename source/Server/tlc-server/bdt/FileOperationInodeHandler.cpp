@@ -108,6 +108,7 @@ namespace bdt
         }
 
         if ( FileOperationEntity::Write(offset,buffer,bufsize,size) ) {
+            cache_->ReserveCapacity(size);
             if ( ! write_ ) {
                 write_ = true;
                 handler_->InvokeAction(InodeHandler::ActionWriteBegin);
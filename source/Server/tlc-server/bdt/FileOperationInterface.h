@@ -101,6 +101,12 @@ namespace bdt
         {
             return true;
         }
+
+        //  the reader has nothing to read until its next request
+        virtual void
+        Idle()
+        {
+        }
     };
 
 }
@@ -0,0 +1,116 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * FileOperationRange.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+
+
+#pragma once
+
+
+#include "FileOperationInterface.h"
+
+
+namespace bdt
+{
+
+    //  A part of a file seen as a file of its own, a file packed with
+    //  others on tape. The part starts at position, a length below 0
+    //  leaves it open to grow with the writes.
+    class FileOperationRange : public FileOperationInterface
+    {
+    public:
+        FileOperationRange(
+                boost::shared_ptr<FileOperationInterface> file,
+                off_t position,
+                off_t length)
+        : file_(file), position_(position), length_(length), end_(0)
+        {
+        }
+
+        virtual
+        ~FileOperationRange()
+        {
+        }
+
+        bool
+        GetStat(struct stat & stat)
+        {
+            if ( ! file_->GetStat(stat) ) {
+                return false;
+            }
+            stat.st_size = GetEnd();
+            return true;
+        }
+
+        bool
+        Read(off_t offset, void * buffer, size_t bufsize, size_t & size)
+        {
+            off_t end = GetEnd();
+            if ( offset >= end ) {
+                size = 0;
+                return true;
+            }
+            if ( (off_t)(offset + bufsize) > end ) {
+                bufsize = end - offset;
+            }
+            return file_->Read(position_ + offset, buffer, bufsize, size);
+        }
+
+        bool
+        Write(off_t offset, const void * buffer, size_t bufsize, size_t & size)
+        {
+            if ( length_ >= 0 && (off_t)(offset + bufsize) > length_ ) {
+                errno = EFBIG;
+                return false;
+            }
+            if ( ! file_->Write(position_ + offset, buffer, bufsize, size) ) {
+                return false;
+            }
+            end_ = max<off_t>( end_, offset + size );
+            return true;
+        }
+
+        bool
+        Truncate(off_t length)
+        {
+            errno = EPERM;
+            return false;
+        }
+
+        bool
+        Sync(bool data)
+        {
+            return file_->Sync(data);
+        }
+
+        //  the length, or the end of the writes when it is open
+        off_t
+        GetEnd()
+        {
+            return length_ >= 0 ? length_ : end_;
+        }
+
+    private:
+        boost::shared_ptr<FileOperationInterface> file_;
+        off_t position_;
+        off_t length_;
+        off_t end_;
+    };
+
+}
@@ -0,0 +1,105 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * FileOperationRecall.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+
+#pragma once
+
+
+#include "RecallQueue.h"
+
+
+namespace bdt
+{
+
+    //  Tape source of a recall, the turn of the tape in the RecallQueue is
+    //  passed on once the source is closed or its reader goes idle
+    class FileOperationRecall : public FileOperationInterface
+    {
+    public:
+        FileOperationRecall(
+                FileOperationInterface * file,
+                RecallQueue * queue,
+                const string & tape)
+        : file_(file), queue_(queue), tape_(tape), turn_(true)
+        {
+        }
+
+        virtual
+        ~FileOperationRecall()
+        {
+            file_.reset();
+            Leave();
+        }
+
+        bool
+        GetStat(struct stat & stat)
+        {
+            return file_->GetStat(stat);
+        }
+
+        bool
+        Read(off_t offset, void * buffer, size_t bufsize, size_t & size)
+        {
+            return file_->Read(offset,buffer,bufsize,size);
+        }
+
+        bool
+        Write(off_t offset, const void * buffer, size_t bufsize, size_t & size)
+        {
+            return file_->Write(offset,buffer,bufsize,size);
+        }
+
+        bool
+        Truncate(off_t length)
+        {
+            return file_->Truncate(length);
+        }
+
+        bool
+        Sync(bool data)
+        {
+            return file_->Sync(data);
+        }
+
+        void
+        Idle()
+        {
+            Leave();
+        }
+
+    private:
+        auto_ptr<FileOperationInterface> file_;
+        RecallQueue * queue_;
+        string tape_;
+        boost::mutex mutex_;
+        bool turn_;
+
+        void
+        Leave()
+        {
+            boost::lock_guard<boost::mutex> lock(mutex_);
+            if ( turn_ ) {
+                turn_ = false;
+                queue_->Leave(tape_);
+            }
+        }
+    };
+
+}
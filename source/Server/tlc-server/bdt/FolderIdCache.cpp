@@ -0,0 +1,169 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * FolderIdCache.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+
+#include "stdafx.h"
+#include "FolderIdCache.h"
+
+
+namespace bdt
+{
+
+    FolderIdCache::FolderIdCache(size_t capacity)
+    : capacity_(capacity), version_(0)
+    {
+    }
+
+
+    FolderIdCache::~FolderIdCache()
+    {
+    }
+
+
+    bool
+    FolderIdCache::Get(
+            const string & path,
+            long long & id,
+            unsigned long long & version)
+    {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+
+        version = version_;
+        MapItemType::iterator i = items_.find(path);
+        if ( i == items_.end() ) {
+            return false;
+        }
+
+        lru_.splice(lru_.begin(), lru_, i->second.lru);
+        id = i->second.id;
+        return true;
+    }
+
+
+    void
+    FolderIdCache::Put(
+            const string & path,
+            long long id,
+            unsigned long long version)
+    {
+        if ( capacity_ == 0 ) {
+            return;
+        }
+
+        boost::lock_guard<boost::mutex> lock(mutex_);
+
+        //  renamed or erased after the id was read
+        if ( version != version_ ) {
+            return;
+        }
+        Insert(path, id);
+    }
+
+
+    void
+    FolderIdCache::Rename(const string & oldPath, const string & newPath)
+    {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+
+        ++ version_;
+        vector<pair<string, long long> > moved;
+        MapItemType::iterator i = items_.lower_bound(oldPath);
+        while ( i != items_.end()
+                && i->first.compare(0, oldPath.size(), oldPath) == 0 ) {
+            moved.push_back( make_pair(
+                    newPath + i->first.substr(oldPath.size()),
+                    i->second.id ) );
+            lru_.erase(i->second.lru);
+            items_.erase(i++);
+        }
+
+        EraseFolder(newPath);
+        for ( size_t j = 0; j < moved.size(); ++ j ) {
+            Insert(moved[j].first, moved[j].second);
+        }
+    }
+
+
+    void
+    FolderIdCache::Erase(const string & path)
+    {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+
+        ++ version_;
+        EraseFolder(path);
+    }
+
+
+    void
+    FolderIdCache::Clear()
+    {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+
+        ++ version_;
+        items_.clear();
+        lru_.clear();
+    }
+
+
+    size_t
+    FolderIdCache::Size()
+    {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+        return items_.size();
+    }
+
+
+    void
+    FolderIdCache::Insert(const string & path, long long id)
+    {
+        if ( capacity_ == 0 ) {
+            return;
+        }
+
+        MapItemType::iterator i = items_.find(path);
+        if ( i == items_.end() ) {
+            while ( items_.size() >= capacity_ ) {
+                MapItemType::iterator last = items_.find(lru_.back());
+                lru_.pop_back();
+                items_.erase(last);
+            }
+            lru_.push_front(path);
+            Item item;
+            item.lru = lru_.begin();
+            i = items_.insert( MapItemType::value_type( path, item ) ).first;
+        } else {
+            lru_.splice(lru_.begin(), lru_, i->second.lru);
+        }
+        i->second.id = id;
+    }
+
+
+    void
+    FolderIdCache::EraseFolder(const string & path)
+    {
+        MapItemType::iterator i = items_.lower_bound(path);
+        while ( i != items_.end()
+                && i->first.compare(0, path.size(), path) == 0 ) {
+            lru_.erase(i->second.lru);
+            items_.erase(i++);
+        }
+    }
+
+}
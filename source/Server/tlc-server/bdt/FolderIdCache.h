@@ -0,0 +1,87 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * FolderIdCache.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+
+#pragma once
+
+
+#include <list>
+
+
+namespace bdt
+{
+
+    //  Size bounded LRU of catalog folder paths to their ids. The paths end
+    //  with '/', so the folders below one are the keys sharing its prefix
+    //  and a folder rename moves them together. Every rename or erase
+    //  increases the version, a Put with a version taken before is dropped.
+    class FolderIdCache
+    {
+    public:
+        FolderIdCache(size_t capacity);
+
+        ~FolderIdCache();
+
+        bool
+        Get(const string & path, long long & id, unsigned long long & version);
+
+        void
+        Put(const string & path, long long id, unsigned long long version);
+
+        //  the folders below oldPath are below newPath now, the ones that
+        //  were cached below newPath are dropped
+        void
+        Rename(const string & oldPath, const string & newPath);
+
+        //  the path and every path below it
+        void
+        Erase(const string & path);
+
+        void
+        Clear();
+
+        size_t
+        Size();
+
+    private:
+        typedef list<string> ListPathType;
+
+        struct Item
+        {
+            long long id;
+            ListPathType::iterator lru;
+        };
+
+        typedef map<string, Item> MapItemType;
+
+        size_t capacity_;
+        boost::mutex mutex_;
+        MapItemType items_;
+        ListPathType lru_;
+        unsigned long long version_;
+
+        void
+        Insert(const string & path, long long id);
+
+        void
+        EraseFolder(const string & path);
+    };
+
+}
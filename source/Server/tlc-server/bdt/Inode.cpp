@@ -395,6 +395,25 @@ namespace bdt
     }
 
 
+    bool
+    Inode::GetOnlineAttribute(
+            OnlineState state, void * buf, int bufsize, int & size)
+    {
+        if ( buf == NULL || bufsize == 0 ) {
+            size = 8;
+            return true;
+        }
+        if ( bufsize < 8 ) {
+            errno = ERANGE;
+            return false;
+        }
+        memset(buf,0,bufsize);
+        * (int *)buf = state;
+        size = 8;
+        return true;
+    }
+
+
     bool
     Inode::GetExtendedAttribute(
             const string & name, void * buf, int bufsize, int & size)
@@ -405,18 +424,7 @@ namespace bdt
                 errno = ENODATA;
                 return false;
             }
-            if ( buf == NULL || bufsize == 0 ) {
-                size = 8;
-                return true;
-            }
-            if ( bufsize < 8 ) {
-                errno = ERANGE;
-                return false;
-            }
-            memset(buf,0,bufsize);
-            * (int *)buf = state;
-            size = 8;
-            return true;
+            return GetOnlineAttribute(state,buf,bufsize,size);
         }
 
         if ( ! CheckExtendedAttribute(name) ) {
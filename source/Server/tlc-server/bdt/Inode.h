@@ -123,6 +123,10 @@ namespace bdt
         bool
         GetOnline(OnlineState & state);
 
+        static bool
+        GetOnlineAttribute(OnlineState state,
+                void * buf,int bufsize,int & size);
+
 
         bool
         SetDigest(FileDigest * digest);
@@ -26,6 +26,7 @@
 #include "MetaManager.h"
 #include "ReadManager.h"
 #include "FileOperationInodeHandler.h"
+#include "BackupWriter.h"
 
 
 namespace bdt
@@ -75,6 +76,8 @@ namespace bdt
         state_ = (Inode::State)state;
 
         inode_->GetSize(size_);
+
+        QueueBackup();
     }
 
 
@@ -159,14 +162,17 @@ namespace bdt
 
     bool
     InodeHandler::InvokeBackup(
-            FileOperationInterface * file,
-            const string & tape,
+            BackupWriter & writer,
+            const vector<FileOperationInterface *> & files,
+            const vector<string> & tapes,
             fs::path & path,
-            bool & writeTape)
+            vector<bool> & done,
+            vector<bool> & written)
     {
         boost::lock_guard<boost::mutex> lock(mutexBackup_);
 
-        writeTape = false;
+        done.assign(files.size(),false);
+        written.assign(files.size(),false);
 
         auto_ptr<FileOperationInterface> source;
         source.reset(cache_->GetFileOperation(number_,O_RDONLY));
@@ -175,39 +181,29 @@ namespace bdt
             return false;
         }
 
-        const int bufsize = 512 * 1024;
-        boost::scoped_array<char> buffer(new char[bufsize]);
         off_t offset = 0;
-        do {
-            {
-                boost::lock_guard<boost::mutex> lock(mutex_);
-                if ( ! NeedBackup() ) {
-                    return false;
-                }
-            }
-            size_t size;
-            if ( ! source->Read(offset,buffer.get(),bufsize,size) ) {
-                break;
-            }
-            if ( size == 0 ) {
-                break;
-            }
-            writeTape = true;
-            if ( ! file->Write(offset,buffer.get(),size,size) ) {
-                return false;
-            }
-            offset += size;
-        } while ( true );
+        if ( ! writer.Copy( source.get(), files,
+                boost::bind(&InodeHandler::CheckBackup,this),
+                done, written, offset ) ) {
+            return false;
+        }
 
         {
             boost::lock_guard<boost::mutex> lock(mutex_);
 
             if ( ! NeedBackup() ) {
+                done.assign(files.size(),false);
                 return false;
             }
 
+            //  a tape which failed gets no copy, the others are kept
             SetState(Inode::StateBegin);
-            inode_->SetTape(tape);
+            for ( size_t i = 0; i < files.size(); ++ i ) {
+                if ( done[i] ) {
+                    inode_->SetTape(tapes[i]);
+                    break;
+                }
+            }
             inode_->SetTapeSize(offset);
             path = path_;
             pathOld_ = path_;
@@ -279,6 +275,7 @@ namespace bdt
             -- writting_;
             if ( writting_ == 0 ) {
                 written_ = boost::posix_time::microsec_clock::local_time();
+                QueueBackup();
             }
             return true;
         }
@@ -289,6 +286,7 @@ namespace bdt
             inode_->SetState(state_);
             inode_->SetSize(size_);
             needBackup_ = database_->IsBackupFile(path_);
+            QueueBackup();
             return true;
         }
 
@@ -408,19 +406,26 @@ namespace bdt
     }
 
 
-    bool
-    InodeHandler::NeedBackup()
+    static int
+    GetWaitFile()
     {
         static int waitFile = Factory::GetConfigure()->GetValueSize(
                 Configure::BackupWaitFile );
+        return waitFile;
+    }
 
+
+    bool
+    InodeHandler::NeedBackup()
+    {
         if ( writting_ != 0 ) {
             return false;
         }
 
+        //  the same clock as the time in the backup queue
         boost::posix_time::ptime now;
-        now = boost::posix_time::second_clock::local_time();
-        if ( (now - written_).total_seconds() < waitFile ) {
+        now = boost::posix_time::microsec_clock::local_time();
+        if ( now - written_ < boost::posix_time::seconds(GetWaitFile()) ) {
             return false;
         }
 
@@ -428,6 +433,14 @@ namespace bdt
     }
 
 
+    bool
+    InodeHandler::CheckBackup()
+    {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+        return NeedBackup();
+    }
+
+
     bool
     InodeHandler::RequireBackup()
     {
@@ -439,6 +452,18 @@ namespace bdt
     }
 
 
+    void
+    InodeHandler::QueueBackup()
+    {
+        if ( writting_ != 0 || ! RequireBackup() ) {
+            return;
+        }
+
+        meta_->QueueBackup( path_,
+                written_ + boost::posix_time::seconds(GetWaitFile()) );
+    }
+
+
     bool
     InodeHandler::Persist()
     {
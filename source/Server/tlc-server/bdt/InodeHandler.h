@@ -26,6 +26,7 @@ namespace bdt
 {
 
     class MetaDatabase;
+    class BackupWriter;
 
 
     class InodeHandler
@@ -65,11 +66,15 @@ namespace bdt
                 off_t & size,
                 boost::posix_time::ptime & time);
 
+        //  copies the cache file to all the tapes at once with writer,
+        //  done and written are per tape as in BackupWriter::Copy
         bool InvokeBackup(
-                FileOperationInterface * file,
-                const string & tape,
+                BackupWriter & writer,
+                const vector<FileOperationInterface *> & files,
+                const vector<string> & tapes,
                 fs::path & path,
-                bool & writeTape);
+                vector<bool> & done,
+                vector<bool> & written);
 
         bool GetStat(struct stat & stat);
 
@@ -107,8 +112,12 @@ namespace bdt
 
         bool NeedBackup();
 
+        bool CheckBackup();
+
         bool RequireBackup();
 
+        void QueueBackup();
+
         int refer_;
         int writting_;
         bool access_;
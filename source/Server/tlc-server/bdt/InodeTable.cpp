@@ -0,0 +1,200 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * InodeTable.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: agent
+ */
+
+
+#include "stdafx.h"
+#include "InodeTable.h"
+
+
+namespace bdt
+{
+
+    const unsigned long long InodeTable::RootInode;
+
+
+    InodeTable::InodeTable()
+    {
+        Entry root;
+        root.path = "/";
+        root.nlookup = 1;
+        inodes_.insert( MapInodeType::value_type( RootInode, root ) );
+        paths_.insert( MapPathType::value_type( "/", RootInode ) );
+    }
+
+
+    InodeTable::~InodeTable()
+    {
+    }
+
+
+    unsigned long long
+    InodeTable::Lookup(const fs::path & path, const struct stat & stat)
+    {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+
+        const string name = path.string();
+        if ( name == "/" ) {
+            return RootInode;
+        }
+
+        unsigned long long ino = stat.st_ino;
+        if ( ino == RootInode ) {
+            //  handing it out would make the kernel take the entry for the
+            //  root folder
+            LogError(path << " has the inode number of the root folder");
+            errno = EIO;
+            return 0;
+        }
+
+        MapPathType::iterator p = paths_.find(name);
+        if ( p != paths_.end() && p->second != ino ) {
+            //  the path is replaced by another inode
+            MapInodeType::iterator i = inodes_.find(p->second);
+            if ( i != inodes_.end() ) {
+                i->second.path.clear();
+            }
+            paths_.erase(p);
+        }
+
+        MapInodeType::iterator i = inodes_.find(ino);
+        if ( i == inodes_.end() ) {
+            Entry entry;
+            entry.path = path;
+            entry.nlookup = 0;
+            i = inodes_.insert( MapInodeType::value_type( ino, entry ) ).first;
+        } else if ( i->second.path != path ) {
+            p = paths_.find(i->second.path.string());
+            if ( p != paths_.end() && p->second == ino ) {
+                paths_.erase(p);
+            }
+            i->second.path = path;
+        }
+
+        ++ i->second.nlookup;
+        paths_[name] = ino;
+        return ino;
+    }
+
+
+    bool
+    InodeTable::GetPath(const unsigned long long ino, fs::path & path)
+    {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+
+        MapInodeType::iterator i = inodes_.find(ino);
+        if ( i == inodes_.end() || i->second.path.empty() ) {
+            errno = ENOENT;
+            return false;
+        }
+
+        path = i->second.path;
+        return true;
+    }
+
+
+    void
+    InodeTable::Forget(const unsigned long long ino, unsigned long nlookup)
+    {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+
+        if ( ino == RootInode ) {
+            return;
+        }
+
+        MapInodeType::iterator i = inodes_.find(ino);
+        if ( i == inodes_.end() ) {
+            return;
+        }
+
+        if ( i->second.nlookup > nlookup ) {
+            i->second.nlookup -= nlookup;
+            return;
+        }
+
+        MapPathType::iterator p = paths_.find(i->second.path.string());
+        if ( p != paths_.end() && p->second == ino ) {
+            paths_.erase(p);
+        }
+        inodes_.erase(i);
+    }
+
+
+    void
+    InodeTable::Rename(const fs::path & from, const fs::path & to)
+    {
+        Remove(to);
+
+        boost::lock_guard<boost::mutex> lock(mutex_);
+
+        const string nameFrom = from.string();
+        const string prefix = nameFrom + "/";
+        vector<pair<string, unsigned long long> > changes;
+
+        MapPathType::iterator p = paths_.find(nameFrom);
+        if ( p != paths_.end() ) {
+            changes.push_back( make_pair( to.string(), p->second ) );
+            paths_.erase(p);
+        }
+
+        p = paths_.lower_bound(prefix);
+        while ( p != paths_.end()
+                && p->first.compare(0, prefix.size(), prefix) == 0 ) {
+            changes.push_back( make_pair(
+                    (to / p->first.substr(prefix.size())).string(),
+                    p->second ) );
+            paths_.erase(p++);
+        }
+
+        for ( size_t i = 0; i < changes.size(); ++ i ) {
+            paths_[changes[i].first] = changes[i].second;
+            MapInodeType::iterator entry = inodes_.find(changes[i].second);
+            if ( entry != inodes_.end() ) {
+                entry->second.path = changes[i].first;
+            }
+        }
+    }
+
+
+    void
+    InodeTable::Remove(const fs::path & path)
+    {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+
+        MapPathType::iterator p = paths_.find(path.string());
+        if ( p == paths_.end() ) {
+            return;
+        }
+
+        MapInodeType::iterator i = inodes_.find(p->second);
+        if ( i != inodes_.end() ) {
+            i->second.path.clear();
+        }
+        paths_.erase(p);
+    }
+
+
+    size_t
+    InodeTable::Size()
+    {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+        return inodes_.size();
+    }
+
+}
@@ -0,0 +1,76 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * InodeTable.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: agent
+ */
+
+
+#pragma once
+
+
+namespace bdt
+{
+
+    //  Maps the inode numbers handed to the kernel by the low level fuse
+    //  frontend to the current path of the inode in the meta folder.
+    //  The number is the st_ino of the meta stub, so it survives renames
+    //  and remounts; the root folder is always RootInode. Lookup returns 0
+    //  for a stub that has the number of the root folder.
+    class InodeTable
+    {
+    public:
+        InodeTable();
+
+        ~InodeTable();
+
+        static const unsigned long long RootInode = 1;
+
+        unsigned long long
+        Lookup(const fs::path & path, const struct stat & stat);
+
+        bool
+        GetPath(const unsigned long long ino, fs::path & path);
+
+        void
+        Forget(const unsigned long long ino, unsigned long nlookup);
+
+        void
+        Rename(const fs::path & from, const fs::path & to);
+
+        void
+        Remove(const fs::path & path);
+
+        size_t
+        Size();
+
+    private:
+        boost::mutex mutex_;
+
+        struct Entry
+        {
+            fs::path path;
+            unsigned long nlookup;
+        };
+
+        typedef map<unsigned long long, Entry> MapInodeType;
+        typedef map<string, unsigned long long> MapPathType;
+
+        MapInodeType inodes_;
+        MapPathType paths_;
+    };
+
+}
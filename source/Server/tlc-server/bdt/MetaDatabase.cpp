@@ -25,6 +25,8 @@
 #else
 #include "../ltfs_management/CatalogDbManager.h"
 #include "../lib/common/Common.h"
+#include "CatalogJournal.h"
+#include "TapeOrderIndex.h"
 #endif
 
 #include <boost/regex.hpp>
@@ -33,6 +35,13 @@
 namespace bdt
 {
 
+#ifdef MORE_TEST
+#else
+    //  milliseconds a lookup waits for the journal
+    static const int FlushTimeout = 5 * 1000;
+#endif
+
+
     MetaDatabase::MetaDatabase()
     {
 #ifdef MORE_TEST
@@ -53,9 +62,17 @@ namespace bdt
 #ifdef MORE_TEST
         return true;
 #else
-        return catalog_->DeleteUuid(
-                Factory::GetService(), boost::lexical_cast<string>(number) );
-
+        TapeOrderIndex * index = Factory::GetTapeOrderIndex();
+        if ( NULL != index ) {
+            index->Remove(number);
+        }
+        string uuid = boost::lexical_cast<string>(number);
+        JournalResult result = AppendJournal(
+                CatalogRecord::TypeDeleteFile, uuid );
+        if ( result != JournalDirect ) {
+            return result == JournalAppended;
+        }
+        return catalog_->DeleteUuid(Factory::GetService(), uuid);
 #endif
     }
 
@@ -66,6 +83,11 @@ namespace bdt
 #ifdef MORE_TEST
         return true;
 #else
+        JournalResult result = AppendJournal(
+                CatalogRecord::TypeDeleteFolder, path.string() );
+        if ( result != JournalDirect ) {
+            return result == JournalAppended;
+        }
         return catalog_->DeleteMetaFolder(
                 Factory::GetService(), path.string() );
 #endif
@@ -79,10 +101,14 @@ namespace bdt
 #ifdef MORE_TEST
         return true;
 #else
+        string uuid = boost::lexical_cast<string>(number);
+        JournalResult result = AppendJournal(
+                CatalogRecord::TypeRenameFile, uuid, path.string() );
+        if ( result != JournalDirect ) {
+            return result == JournalAppended;
+        }
         return catalog_->RenameMetaFile(
-                Factory::GetService(),
-                boost::lexical_cast<string>(number),
-                path.string() );
+                Factory::GetService(), uuid, path.string() );
 #endif
     }
 
@@ -93,6 +119,11 @@ namespace bdt
 #ifdef MORE_TEST
         return true;
 #else
+        JournalResult result = AppendJournal(
+                CatalogRecord::TypeRenameFolder, from.string(), to.string() );
+        if ( result != JournalDirect ) {
+            return result == JournalAppended;
+        }
         return catalog_->RenameMetaFolder(
                 Factory::GetService(),from.string(),to.string());
 #endif
@@ -142,6 +173,7 @@ namespace bdt
         path = "/dev/zero";
         return true;
 #else
+        FlushFile(number);
         map<string,ltfs_management::BackupInfo> infos;
         if ( ! catalog_->GetBackupInfo(
                 Factory::GetService(),
@@ -167,6 +199,63 @@ namespace bdt
     }
 
 
+    bool
+    MetaDatabase::GetFileStartBlock(
+            const unsigned long long number,
+            const string & tape,
+            off_t & block)
+    {
+#ifdef MORE_TEST
+        block = number;
+        return true;
+#else
+        TapeOrderIndex * index = LoadTapeOrder(tape);
+        if ( NULL != index && index->GetBlock(tape,number,block) ) {
+            return true;
+        }
+        FlushFile(number);
+        return catalog_->GetTapeFileOffset(
+                Factory::GetService(),
+                tape,
+                boost::lexical_cast<string>(number),
+                block);
+#endif
+    }
+
+
+    bool
+    MetaDatabase::GetFilePack(
+            const unsigned long long number,
+            const string & tape,
+            fs::path & path,
+            off_t & position,
+            off_t & size)
+    {
+        position = -1;
+#ifdef MORE_TEST
+        return true;
+#else
+        FlushFile(number);
+        string pack;
+        if ( ! catalog_->GetTapeFilePack(
+                Factory::GetService(),
+                tape,
+                boost::lexical_cast<string>(number),
+                pack,
+                position,
+                size) ) {
+            return false;
+        }
+        if ( pack.empty() ) {
+            position = -1;
+            return true;
+        }
+        path = COMM_MOUNT_PATH + "/" + tape + "/" + pack;
+        return true;
+#endif
+    }
+
+
     bool
     MetaDatabase::GetNextBackupFile(
             const unsigned long long number,
@@ -179,6 +268,12 @@ namespace bdt
         size = 5 * 1024 * 1024;
         return true;
 #else
+        TapeOrderIndex * index = LoadTapeOrder(tape);
+        if ( NULL != index && index->GetNext(tape,number,next,size) ) {
+            return 0 != next;
+        }
+        //  a file deleted meanwhile is only read ahead for nothing
+        FlushTape(tape);
         string path;
         string nextName;
         if ( ! catalog_->GetNextTapeFile(
@@ -199,6 +294,115 @@ namespace bdt
     }
 
 
+#ifdef MORE_TEST
+#else
+    MetaDatabase::JournalResult
+    MetaDatabase::AppendJournal(
+            int type, const string & value, const string & other)
+    {
+        CatalogJournal * journal = Factory::GetCatalogJournal();
+        if ( NULL == journal ) {
+            return JournalDirect;
+        }
+        CatalogRecord record;
+        record.type = type;
+        record.share = Factory::GetService();
+        record.values.push_back(value);
+        if ( ! other.empty() ) {
+            record.values.push_back(other);
+        }
+        if ( journal->Append(record) ) {
+            return JournalAppended;
+        }
+
+        //  the direct change must not overtake the ones still pending, they
+        //  would overwrite it once applied. The changes of folders are
+        //  matched by path, they wait for all.
+        bool flushed;
+        if ( type == CatalogRecord::TypeDeleteFile
+                || type == CatalogRecord::TypeRenameFile ) {
+            flushed = journal->FlushFile(FlushTimeout, value);
+        } else {
+            flushed = journal->Flush(FlushTimeout);
+        }
+        if ( ! flushed ) {
+            LogError("Catalog change of " << value << " fails, "
+                    << journal->GetPending() << " changes are pending");
+            errno = EIO;
+            return JournalFailed;
+        }
+        LogWarn("Catalog change of " << value << " goes to the catalog directly");
+        return JournalDirect;
+    }
+
+
+    void
+    MetaDatabase::FlushFile(unsigned long long number)
+    {
+        CatalogJournal * journal = Factory::GetCatalogJournal();
+        if ( NULL != journal && ! journal->FlushFile(
+                FlushTimeout, boost::lexical_cast<string>(number) ) ) {
+            LogWarn("Catalog is behind by " << journal->GetPending()
+                    << " changes, " << number << " among them");
+        }
+    }
+
+
+    void
+    MetaDatabase::FlushTape(const string & tape)
+    {
+        CatalogJournal * journal = Factory::GetCatalogJournal();
+        if ( NULL != journal && ! journal->FlushTape(FlushTimeout, tape) ) {
+            LogWarn("Catalog is behind by " << journal->GetPending()
+                    << " changes, " << tape << " among them");
+        }
+    }
+
+
+    TapeOrderIndex *
+    MetaDatabase::LoadTapeOrder(const string & tape)
+    {
+        TapeOrderIndex * index = Factory::GetTapeOrderIndex();
+        if ( NULL == index || ! index->BeginLoad(tape) ) {
+            return index;
+        }
+
+        FlushTape(tape);
+        //  the catalog still has the files whose deletes are not applied,
+        //  the ones applied meanwhile are not read from it
+        vector<string> deletes;
+        CatalogJournal * journal = Factory::GetCatalogJournal();
+        if ( NULL != journal ) {
+            journal->GetPendingDeletes(deletes);
+        }
+        vector<ltfs_management::TapeFileOrder> files;
+        if ( ! catalog_->GetTapeFiles(Factory::GetService(),tape,files) ) {
+            LogWarn(tape << " fails to load the order of its files");
+            index->Unload(tape);
+            return NULL;
+        }
+        vector<TapeOrderItem> items;
+        items.reserve(files.size());
+        BOOST_FOREACH( const ltfs_management::TapeFileOrder & file, files ) {
+            TapeOrderItem item;
+            item.block = file.mOffset;
+            item.number = file.mUuid;
+            item.size = file.mSize;
+            items.push_back(item);
+        }
+        vector<ltfs_management::TapeFileOrder>().swap(files);
+        index->Load(tape,items);
+        BOOST_FOREACH( const string & number, deletes ) {
+            try {
+                index->Remove( boost::lexical_cast<unsigned long long>(number) );
+            } catch ( const boost::bad_lexical_cast & e ) {
+            }
+        }
+        return index;
+    }
+#endif
+
+
     bool
     MetaDatabase::IsFilterFile(const fs::path & path)
     {
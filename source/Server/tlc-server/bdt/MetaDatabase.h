@@ -30,6 +30,8 @@ namespace ltfs_management
 
 namespace bdt
 {
+    class TapeOrderIndex;
+
 
     class MetaDatabase
     {
@@ -66,6 +68,23 @@ namespace bdt
                 string & tape,
                 fs::path & path);
 
+        //  the start block of the file on the tape
+        bool
+        GetFileStartBlock(
+                const unsigned long long number,
+                const string & tape,
+                off_t & block);
+
+        //  the pack on the tape holding the file at position; position is
+        //  -1 and path is left alone if the file is on the tape by itself
+        bool
+        GetFilePack(
+                const unsigned long long number,
+                const string & tape,
+                fs::path & path,
+                off_t & position,
+                off_t & size);
+
         bool
         GetNextBackupFile(
                 const unsigned long long number,
@@ -89,6 +108,34 @@ namespace bdt
 #ifdef MORE_TEST
 #else
         ltfs_management::CatalogDbManager * catalog_;
+
+        enum JournalResult {
+            JournalAppended,
+            //  there is no journal, or it fails and no change appended
+            //  before is left that the direct one could overtake
+            JournalDirect,
+            JournalFailed,
+        };
+
+        JournalResult
+        AppendJournal(
+                int type,
+                const string & value,
+                const string & other = "");
+
+        //  the changes appended before to the file number, or to the files
+        //  of the tape, reach the catalog, or at least some time is given
+        //  to them; the other changes do not hold up the lookup
+        void
+        FlushFile(unsigned long long number);
+
+        void
+        FlushTape(const string & tape);
+
+        //  NULL when the order of the tape has to come from the catalog;
+        //  the lookups miss the tape while another thread loads it
+        TapeOrderIndex *
+        LoadTapeOrder(const string & tape);
 #endif
     };
 
@@ -25,6 +25,11 @@
 #include "CacheManager.h"
 #include "InodeHandler.h"
 #include "FileOperation.h"
+#include "AttributeCache.h"
+#include "EvictionIndex.h"
+#include "BackupQueue.h"
+#include "BackupWriter.h"
+#include <boost/functional/hash.hpp>
 
 
 namespace bdt
@@ -32,10 +37,22 @@ namespace bdt
 
     static int CheckInterval = 10;
 
+    const size_t MetaManager::ShardCount;
+
     MetaManager::MetaManager()
     : folder_(Factory::GetMetaFolder() / Factory::GetService()),
       database_(new MetaDatabase()),
       cache_(Factory::GetCacheManager()),
+      attributes_(new AttributeCache(
+              Factory::GetConfigure()->GetValueSize(
+                      Configure::AttributeCacheSize),
+              Factory::GetConfigure()->GetValueSize(
+                      Configure::AttributeCacheTimeout))),
+      eviction_(new EvictionIndex(
+              Factory::GetCacheFolder() / (Factory::GetService() + ".lru"),
+              Factory::GetConfigure()->GetValueSize(
+                      Configure::CacheEvictionSaveInterval))),
+      backups_(new BackupQueue()),
       check_(boost::posix_time::second_clock::local_time())
     {
         if (fs::exists(folder_)) {
@@ -90,6 +107,7 @@ namespace bdt
             int handle = ::creat(fullpath.string().c_str(),mode);
             if ( handle >= 0 ) {
                 close(handle);
+                attributes_->Invalidate(path);
                 return true;
             } else {
                 return false;
@@ -110,7 +128,11 @@ namespace bdt
                 errno = ENOSPC;
                 return false;
             }
-            return ( 0 == ::mkdir(fullpath.string().c_str(),mode) );
+            if ( 0 != ::mkdir(fullpath.string().c_str(),mode) ) {
+                return false;
+            }
+            attributes_->Invalidate(path);
+            return true;
         }
     }
 
@@ -120,7 +142,9 @@ namespace bdt
     {
         fs::path pathname = folder_ / path;
 
-        boost::lock_guard<boost::mutex> lock(mutex_);
+        boost::shared_lock<boost::shared_mutex> lockTable(table_);
+        HandlerShard & shard = GetShard(path);
+        boost::lock_guard<boost::mutex> lock(shard.mutex);
 
         auto_ptr<Inode> inode(GetInode(path));
 
@@ -129,6 +153,8 @@ namespace bdt
             return true;
         }
 
+        attributes_->Invalidate(path);
+
         if ( fs::is_directory(pathname) ) {
             bool ret = ( 0 == ::rmdir(pathname.string().c_str()) );
             if ( ! database_->DeleteFolder(path) ) {
@@ -150,6 +176,7 @@ namespace bdt
         if ( 0 != ::unlink(pathname.string().c_str()) ) {
             return false;
         }
+        eviction_->Remove(path);
 
         if ( backup ) {
             if ( ! database_->DeleteFile(number) ) {
@@ -157,17 +184,13 @@ namespace bdt
             }
         }
 
-        MapHandlerType::iterator i = handlersOpen_.find(path);
-        if ( i != handlersOpen_.end() ) {
+        MapHandlerType::iterator i = shard.handlers.find(path);
+        if ( i != shard.handlers.end() ) {
             if ( ! i->second->InvokeAction(InodeHandler::ActionDelete) ) {
                 LogWarn(path << " fails for delete action");
             }
-            if ( i->second->Handle() ) {
-                delete i->second;
-            } else {
-                handlersDelete_.push_back(i->second);
-            }
-            handlersOpen_.erase(i);
+            DeleteHandler(i->second);
+            shard.handlers.erase(i);
         } else {
             if ( ! cache_->DeleteFile(number) ) {
                 LogError(path << " fails to be deleted");
@@ -184,7 +207,30 @@ namespace bdt
         fs::path pathFrom = folder_ / from;
         fs::path pathTo = folder_ / to;
 
-        boost::lock_guard<boost::mutex> lock(mutex_);
+        //  the kernel keeps the parent folders locked during a rename, from
+        //  can not change between a file and a folder until it is done
+        bool folder = fs::is_directory(pathFrom);
+
+        boost::unique_lock<boost::shared_mutex> lockRename(
+                table_, boost::defer_lock );
+        boost::shared_lock<boost::shared_mutex> lockTable(
+                table_, boost::defer_lock );
+        HandlerShard & shardFrom = GetShard(from);
+        HandlerShard & shardTo = GetShard(to);
+        boost::unique_lock<boost::mutex> lockFrom(
+                shardFrom.mutex, boost::defer_lock );
+        boost::unique_lock<boost::mutex> lockTo(
+                shardTo.mutex, boost::defer_lock );
+        if ( folder ) {
+            lockRename.lock();
+        } else {
+            lockTable.lock();
+            if ( &shardFrom == &shardTo ) {
+                lockFrom.lock();
+            } else {
+                boost::lock(lockFrom, lockTo);
+            }
+        }
 
         if ( 0 != ::rename(
                 pathFrom.string().c_str(),
@@ -192,6 +238,10 @@ namespace bdt
             return false;
         }
 
+        attributes_->InvalidateFolder(from);
+        attributes_->InvalidateFolder(to);
+        eviction_->Rename(from,to);
+
         if ( fs::is_directory(pathTo) ) {
             if ( ! database_->RenameFolder(from,to) ) {
                 LogError(from << " fails to rename to " << to
@@ -211,49 +261,49 @@ namespace bdt
             }
         }
 
-        if ( fs::is_directory(pathTo) ) {
+        if ( folder ) {
             string prefix = from.string() + "/";
             int prefixLen = prefix.size();
             MapHandlerType changes;
-            vector<fs::path> deletes;
-            BOOST_FOREACH(MapHandlerType::value_type & pair, handlersOpen_) {
-                if ( pair.first.string().substr(0,prefixLen) != prefix ) {
-                    continue;
+            BOOST_FOREACH(HandlerShard & shard, shards_) {
+                vector<fs::path> deletes;
+                BOOST_FOREACH(MapHandlerType::value_type & pair,
+                        shard.handlers) {
+                    if ( pair.first.string().substr(0,prefixLen) != prefix ) {
+                        continue;
+                    }
+                    fs::path pathNew =
+                            to / pair.first.string().substr(prefixLen);
+                    if ( ! pair.second->InvokeAction(
+                            InodeHandler::ActionRename, pathNew.string() ) ) {
+                        LogWarn(pair.first << " fails for rename action to "
+                                << pathNew);
+                    }
+                    deletes.push_back(pair.first);
+                    changes.insert( MapHandlerType::value_type(
+                            pathNew, pair.second ) );
                 }
-                fs::path pathNew = to / pair.first.string().substr(prefixLen);
-                if ( ! pair.second->InvokeAction(
-                        InodeHandler::ActionRename, pathNew.string() ) ) {
-                    LogWarn(pair.first << " fails for rename action to "
-                            << pathNew);
+                BOOST_FOREACH(const fs::path & path, deletes) {
+                    shard.handlers.erase(path);
                 }
-                deletes.push_back(pair.first);
-                changes.insert( MapHandlerType::value_type(
-                        pathNew, pair.second ) );
-            }
-            BOOST_FOREACH(const fs::path & path, deletes) {
-                handlersOpen_.erase(path);
             }
             BOOST_FOREACH(MapHandlerType::value_type & pair, changes) {
-                handlersOpen_.insert( MapHandlerType::value_type(
-                    pair.first, pair.second ) );
+                GetShard(pair.first).handlers.insert(
+                        MapHandlerType::value_type(pair.first, pair.second) );
             }
             return true;
         } else {
-            MapHandlerType::iterator i = handlersOpen_.find(to);
-            if ( i != handlersOpen_.end() ) {
+            MapHandlerType::iterator i = shardTo.handlers.find(to);
+            if ( i != shardTo.handlers.end() ) {
                 if ( ! i->second->InvokeAction(InodeHandler::ActionDelete) ) {
                     LogWarn(to << " fails for delete action in rename");
                 }
-                if ( i->second->Handle() ) {
-                    delete i->second;
-                } else {
-                    handlersDelete_.push_back(i->second);
-                }
-                handlersOpen_.erase(i);
+                DeleteHandler(i->second);
+                shardTo.handlers.erase(i);
             }
 
-            i = handlersOpen_.find(from);
-            if ( i == handlersOpen_.end() ) {
+            i = shardFrom.handlers.find(from);
+            if ( i == shardFrom.handlers.end() ) {
                 return true;
             }
             if ( ! i->second->InvokeAction(
@@ -261,8 +311,8 @@ namespace bdt
                 LogWarn(from << " fails for rename action to " << to);
             }
             InodeHandler * handler = i->second;
-            handlersOpen_.erase(i);
-            handlersOpen_.insert(MapHandlerType::value_type(to,handler));
+            shardFrom.handlers.erase(i);
+            shardTo.handlers.insert(MapHandlerType::value_type(to,handler));
             return true;
         }
     }
@@ -273,10 +323,12 @@ namespace bdt
     {
         auto_ptr<FileOperationInterface> file;
         {
-            boost::lock_guard<boost::mutex> lock(mutex_);
+            boost::shared_lock<boost::shared_mutex> lockTable(table_);
+            HandlerShard & shard = GetShard(path);
+            boost::lock_guard<boost::mutex> lock(shard.mutex);
 
-            MapHandlerType::iterator i = handlersOpen_.find(path);
-            if ( i == handlersOpen_.end() ) {
+            MapHandlerType::iterator i = shard.handlers.find(path);
+            if ( i == shard.handlers.end() ) {
                 return false;
             }
             file.reset(i->second->GetFileOperation(O_RDONLY));
@@ -284,6 +336,152 @@ namespace bdt
         return file->GetStat(stat);
     }
 
+
+    bool
+    MetaManager::GetStat(const fs::path & path,struct stat & stat)
+    {
+        InodeAttribute attribute;
+        if ( ! GetAttribute(path,attribute) ) {
+            return false;
+        }
+        stat = attribute.stat;
+        return true;
+    }
+
+
+    bool
+    MetaManager::GetAttribute(
+            const fs::path & path,
+            InodeAttribute & attribute)
+    {
+        unsigned long long version;
+        if ( attributes_->Get(path,attribute,version) ) {
+            return true;
+        }
+
+        //  open files change with every write, they are not cached
+        attribute.state = 0;
+        attribute.online = Inode::OnlineStateUnknown;
+        if ( GetActiveStat(path,attribute.stat) ) {
+            return true;
+        }
+
+        auto_ptr<Inode> inode(GetInode(path));
+        if ( NULL == inode.get() ) {
+            errno = ENOENT;
+            return false;
+        }
+        if ( ! inode->GetState(attribute.state) ) {
+            attribute.state = 0;
+        }
+        if ( ! inode->GetStat(attribute.stat) ) {
+            return false;
+        }
+        attributes_->Put(path,attribute,version);
+        return true;
+    }
+
+
+    bool
+    MetaManager::GetOnline(const fs::path & path,Inode::OnlineState & state)
+    {
+        unsigned long long version;
+        InodeAttribute attribute;
+        bool cached = attributes_->Get(path,attribute,version);
+        if ( cached && attribute.online != Inode::OnlineStateUnknown ) {
+            state = attribute.online;
+            return true;
+        }
+
+        auto_ptr<Inode> inode(GetInode(path));
+        if ( NULL == inode.get() ) {
+            errno = ENOENT;
+            return false;
+        }
+        if ( ! inode->GetOnline(state) ) {
+            return false;
+        }
+
+        if ( cached ) {
+            attribute.online = state;
+            attributes_->Put(path,attribute,version);
+        }
+        return true;
+    }
+
+
+    void
+    MetaManager::InvalidateAttribute(const fs::path & path)
+    {
+        attributes_->Invalidate(path);
+    }
+
+
+    bool
+    MetaManager::ReadFolder(
+            const fs::path & path,
+            DIR * dir,
+            FolderEntry & entry)
+    {
+        //  the attributes of all entries are read relative to the open
+        //  folder, this saves the path lookups of a getattr per entry
+        for ( ; ; ) {
+            errno = 0;
+            struct dirent * ent = ::readdir(dir);
+            if ( NULL == ent ) {
+                return false;
+            }
+
+            entry.name = ent->d_name;
+            entry.offset = ::telldir(dir);
+            if ( 0 != ::fstatat(
+                    ::dirfd(dir), ent->d_name, &entry.stat, 0 ) ) {
+                //  deleted after readdir
+                continue;
+            }
+            if ( entry.name == "." || entry.name == ".." ) {
+                return true;
+            }
+
+            fs::path pathEntry = path / entry.name;
+            InodeAttribute attribute;
+            unsigned long long version;
+            if ( attributes_->Get(pathEntry,attribute,version) ) {
+                entry.stat = attribute.stat;
+                return true;
+            }
+            if ( GetActiveStat(pathEntry,attribute.stat) ) {
+                attribute.stat.st_ino = entry.stat.st_ino;
+                entry.stat = attribute.stat;
+                return true;
+            }
+
+            attribute.state = 0;
+            attribute.online = Inode::OnlineStateUnknown;
+            if ( S_ISREG(entry.stat.st_mode) ) {
+                ExtendedAttribute xattr(folder_ / pathEntry);
+                int size;
+                off_t sizeLogical;
+                if ( xattr.GetValue( Inode::ATTRIBUTE_SIZE,
+                        &sizeLogical, sizeof(sizeLogical), size ) ) {
+                    entry.stat.st_size = sizeLogical;
+                }
+                //  the state is only needed by the attribute cache
+                if ( attributes_->IsEnabled() && ! xattr.GetValue(
+                        Inode::ATTRIBUTE_STATE,
+                        &attribute.state, sizeof(attribute.state), size ) ) {
+                    attribute.state = 0;
+                }
+            }
+            entry.stat.st_blocks = (entry.stat.st_size + 512 - 1) / 512;
+
+            attribute.stat = entry.stat;
+            attributes_->Put(pathEntry,attribute,version);
+            return true;
+        }
+    }
+
+
     FileOperationInterface *
     MetaManager::GetFileOperation(
             const fs::path & path,
@@ -309,13 +507,19 @@ namespace bdt
             }
         }
 
-        boost::lock_guard<boost::mutex> lock(mutex_);
+        boost::shared_lock<boost::shared_mutex> lockTable(table_);
+        HandlerShard & shard = GetShard(path);
+        boost::lock_guard<boost::mutex> lock(shard.mutex);
+
+        //  the stat of an open file comes from its handler
+        attributes_->Invalidate(path);
 
-        MapHandlerType::iterator i = handlersOpen_.find(path);
-        if ( i == handlersOpen_.end() ) {
-            i = handlersOpen_.insert( MapHandlerType::value_type(
+        MapHandlerType::iterator i = shard.handlers.find(path);
+        if ( i == shard.handlers.end() ) {
+            i = shard.handlers.insert( MapHandlerType::value_type(
                     path, new InodeHandler(path) ) ).first;
         }
+        eviction_->Touch(path,time(NULL));
         return i->second->GetFileOperation(flags);
     }
 
@@ -363,24 +567,30 @@ namespace bdt
     {
         list.clear();
 
-        boost::lock_guard<boost::mutex> lock(mutex_);
+        vector<fs::path> paths;
+        backups_->GetReady(paths);
 
-        vector<fs::path> removes;
-        BOOST_FOREACH(MapHandlerType::value_type & pair, handlersOpen_) {
-            if ( pair.second->Handle() ) {
-                delete pair.second;
-                removes.push_back(pair.first);
-                continue;
-            }
-            BackupItem item;
-            if ( pair.second->NeedBackup(item.number,item.size,item.time) ) {
-                item.path = pair.first;
+        {
+            boost::shared_lock<boost::shared_mutex> lockTable(table_);
+
+            //  only the ready files, the idle handlers are left alone
+            BOOST_FOREACH(const fs::path & path, paths) {
+                HandlerShard & shard = GetShard(path);
+                boost::lock_guard<boost::mutex> lock(shard.mutex);
+
+                //  a handler queues itself again when it is written
+                MapHandlerType::iterator i = shard.handlers.find(path);
+                BackupItem item;
+                if ( i == shard.handlers.end()
+                        || ! i->second->NeedBackup(
+                                item.number,item.size,item.time) ) {
+                    backups_->Done(path);
+                    continue;
+                }
+                item.path = path;
                 list.push_back(item);
             }
         }
-        BOOST_FOREACH(const fs::path & path, removes) {
-            handlersOpen_.erase(path);
-        }
 
         CheckHandlers(false);
 
@@ -396,59 +606,136 @@ namespace bdt
             fs::path & pathNew,
             bool & writeTape)
     {
-        boost::unique_lock<boost::mutex> lock(mutex_);
+        vector<FileOperationInterface *> files(1,file);
+        vector<string> tapes(1,tape);
+        vector<bool> done;
+        vector<bool> written;
+        BackupWriter writer( Factory::GetConfigure()->GetValueSize(
+                Configure::BackupBufferCount ) );
+        bool ret = BackupCopies(writer,path,files,tapes,pathNew,done,written);
+        writeTape = written[0];
+        return ret;
+    }
 
-        MapHandlerType::iterator i = handlersOpen_.find(path);
-        if ( i == handlersOpen_.end() ) {
-            return false;
-        }
-        BackupItem item;
-        if ( ! i->second->NeedBackup(item.number,item.size,item.time) ) {
-            return false;
+
+    bool
+    MetaManager::BackupCopies(
+            BackupWriter & writer,
+            const fs::path & path,
+            const vector<FileOperationInterface *> & files,
+            const vector<string> & tapes,
+            fs::path & pathNew,
+            vector<bool> & done,
+            vector<bool> & written)
+    {
+        done.assign(files.size(),false);
+        written.assign(files.size(),false);
+
+        InodeHandler * handler;
+        {
+            boost::shared_lock<boost::shared_mutex> lockTable(table_);
+            HandlerShard & shard = GetShard(path);
+            boost::lock_guard<boost::mutex> lock(shard.mutex);
+
+            MapHandlerType::iterator i = shard.handlers.find(path);
+            if ( i == shard.handlers.end() ) {
+                return false;
+            }
+            BackupItem item;
+            if ( ! i->second->NeedBackup(item.number,item.size,item.time) ) {
+                return false;
+            }
+            handler = i->second;
         }
 
-        lock.unlock();
+        bool ret = handler->InvokeBackup(
+                writer,files,tapes,pathNew,done,written);
+        attributes_->Invalidate(path);
+        return ret;
+    }
+
+
+    void
+    MetaManager::QueueBackup(
+            const fs::path & path,
+            const boost::posix_time::ptime & time)
+    {
+        backups_->Push(path,time);
+    }
+
 
-        return i->second->InvokeBackup(file,tape,pathNew,writeTape);
+    bool
+    MetaManager::WaitBackup(int timeout)
+    {
+        return backups_->Wait(timeout);
+    }
+
+
+    MetaManager::HandlerShard &
+    MetaManager::GetShard(const fs::path & path)
+    {
+        return shards_[ boost::hash<string>()(path.string()) % ShardCount ];
     }
 
 
     void
-    MetaManager::CheckHandlers(bool checkOpenHandlers)
+    MetaManager::DeleteHandler(InodeHandler * handler)
     {
-        boost::posix_time::ptime now(
-                boost::posix_time::second_clock::local_time() );
-        if ( (now - check_).total_seconds() < CheckInterval ) {
-            return;
+        if ( handler->Handle() ) {
+            delete handler;
+        } else {
+            boost::lock_guard<boost::mutex> lock(mutexDelete_);
+            handlersDelete_.push_back(handler);
         }
+    }
 
-        for ( size_t i = 0; i < handlersDelete_.size(); ) {
-            if ( handlersDelete_[i]->Handle() ) {
-                delete handlersDelete_[i];
-                handlersDelete_[i] = * handlersDelete_.rbegin();
-                handlersDelete_.pop_back();
-            } else {
-                ++ i;
+
+    void
+    MetaManager::CheckHandlers(bool checkOpenHandlers)
+    {
+        {
+            boost::lock_guard<boost::mutex> lock(mutexDelete_);
+
+            boost::posix_time::ptime now(
+                    boost::posix_time::second_clock::local_time() );
+            if ( (now - check_).total_seconds() < CheckInterval ) {
+                return;
             }
+
+            for ( size_t i = 0; i < handlersDelete_.size(); ) {
+                if ( handlersDelete_[i]->Handle() ) {
+                    delete handlersDelete_[i];
+                    handlersDelete_[i] = * handlersDelete_.rbegin();
+                    handlersDelete_.pop_back();
+                } else {
+                    ++ i;
+                }
+            }
+
+            check_ = now;
         }
 
         if ( ! checkOpenHandlers ) {
-            check_ = boost::posix_time::second_clock::local_time();
             return;
         }
 
-        vector<fs::path> removes;
-        BOOST_FOREACH(MapHandlerType::value_type & pair, handlersOpen_) {
-            if ( pair.second->Handle() ) {
-                delete pair.second;
-                removes.push_back(pair.first);
+        boost::shared_lock<boost::shared_mutex> lockTable(table_);
+        BOOST_FOREACH(HandlerShard & shard, shards_) {
+            boost::lock_guard<boost::mutex> lock(shard.mutex);
+
+            vector<fs::path> removes;
+            BOOST_FOREACH(MapHandlerType::value_type & pair, shard.handlers) {
+                if ( pair.second->Handle() ) {
+                    delete pair.second;
+                    removes.push_back(pair.first);
+                }
+            }
+            //  the last close of a file is its last access
+            BOOST_FOREACH(const fs::path & path, removes) {
+                shard.handlers.erase(path);
+                eviction_->Touch(path,time(NULL));
             }
         }
-        BOOST_FOREACH(const fs::path & path, removes) {
-            handlersOpen_.erase(path);
-        }
-
-        check_ = boost::posix_time::second_clock::local_time();
         return;
     }
 
@@ -460,8 +747,10 @@ namespace bdt
             try {
                 boost::this_thread::sleep( boost::posix_time::seconds(
                         CheckInterval ) );
-                boost::lock_guard<boost::mutex> lock(mutex_);
                 CheckHandlers(true);
+                //  a rewrite of the eviction journal stays off the paths
+                //  of the file operations
+                eviction_->Save();
             } catch ( const boost::thread_interrupted & e ) {
                 break;
             }
@@ -472,11 +761,13 @@ namespace bdt
     bool
     MetaManager::IsFileInUse(const fs::path & path)
     {
-        boost::lock_guard<boost::mutex> lock(mutex_);
+        boost::shared_lock<boost::shared_mutex> lockTable(table_);
+        HandlerShard & shard = GetShard(path);
+        boost::lock_guard<boost::mutex> lock(shard.mutex);
 
-        MapHandlerType::iterator i = handlersOpen_.find(path);
+        MapHandlerType::iterator i = shard.handlers.find(path);
 
-        if ( i == handlersOpen_.end() ) {
+        if ( i == shard.handlers.end() ) {
             return false;
         }
 
@@ -487,10 +778,12 @@ namespace bdt
     bool
     MetaManager::ReleaseFile(const fs::path & path)
     {
-        boost::lock_guard<boost::mutex> lock(mutex_);
+        boost::shared_lock<boost::shared_mutex> lockTable(table_);
+        HandlerShard & shard = GetShard(path);
+        boost::lock_guard<boost::mutex> lock(shard.mutex);
 
-        MapHandlerType::iterator i = handlersOpen_.find(path);
-        if ( i != handlersOpen_.end() ) {
+        MapHandlerType::iterator i = shard.handlers.find(path);
+        if ( i != shard.handlers.end() ) {
             return false;
         }
 
@@ -504,7 +797,63 @@ namespace bdt
             return false;
         }
 
-        return cache_->DeleteFile(number);
+        attributes_->Invalidate(path);
+        if ( ! cache_->DeleteFile(number) ) {
+            return false;
+        }
+        eviction_->Remove(path);
+        return true;
+    }
+
+
+    void
+    MetaManager::GetEvictionList(size_t count, vector<EvictionItem> & items)
+    {
+        //  the files not to be released yet stay at the head of the index,
+        //  the walk goes on past them until count files are found; at most
+        //  every entry is looked at once
+        size_t left = eviction_->Size();
+        fs::path after;
+        while ( items.size() < count && left > 0 ) {
+            vector<EvictionItem> oldest;
+            eviction_->GetOldest(count,oldest,after);
+            if ( oldest.empty() ) {
+                break;
+            }
+
+            BOOST_FOREACH(const EvictionItem & item, oldest) {
+                if ( items.size() >= count || 0 == left ) {
+                    break;
+                }
+                -- left;
+
+                auto_ptr<Inode> inode(GetInode(item.path));
+                unsigned long long number;
+                if ( NULL == inode.get()
+                        || ! inode->GetNumber(number)
+                        || ! cache_->ExistFile(number) ) {
+                    //  deleted or released already
+                    eviction_->Remove(item.path);
+                    continue;
+                }
+                after = item.path;
+
+                //  the same as the scan of CacheMonitorServer, a file not
+                //  written to tape yet stays in the index until it is
+                long state;
+                if ( ! inode->GetState(state) || state != Inode::StateBegin ) {
+                    continue;
+                }
+                off_t size;
+                if ( ! inode->GetSize(size) || size <= 0 ) {
+                    continue;
+                }
+                if ( IsFileInUse(item.path) ) {
+                    continue;
+                }
+                items.push_back(item);
+            }
+        }
     }
 
 
@@ -522,9 +871,13 @@ namespace bdt
                 SaveHandlersPathname().string().c_str(),
                 ios::out|ios::trunc);
 
-        BOOST_FOREACH(const MapHandlerType::value_type & pair,handlersOpen_) {
-            if ( pair.second->Persist() ) {
-                output << pair.first.string() << endl;
+        boost::unique_lock<boost::shared_mutex> lockTable(table_);
+        BOOST_FOREACH(HandlerShard & shard, shards_) {
+            BOOST_FOREACH(const MapHandlerType::value_type & pair,
+                    shard.handlers) {
+                if ( pair.second->Persist() ) {
+                    output << pair.first.string() << endl;
+                }
             }
         }
 
@@ -535,7 +888,7 @@ namespace bdt
     bool
     MetaManager::LoadHandlers()
     {
-        boost::lock_guard<boost::mutex> lock(mutex_);
+        boost::unique_lock<boost::shared_mutex> lockTable(table_);
 
         if ( ! fs::is_regular_file(SaveHandlersPathname()) ) {
             ScanHandlers(folder_);
@@ -547,15 +900,16 @@ namespace bdt
         char pathBuffer[PATH_MAX];
         while ( input.getline(pathBuffer,sizeof(pathBuffer)) ) {
             fs::path path = pathBuffer;
-            MapHandlerType::iterator i = handlersOpen_.find(path);
-            if ( i != handlersOpen_.end() ) {
+            MapHandlerType & handlers = GetShard(path).handlers;
+            MapHandlerType::iterator i = handlers.find(path);
+            if ( i != handlers.end() ) {
                 LogWarn(path << " exists already");
                 continue;
             }
 
             try {
                 auto_ptr<InodeHandler> handler(new InodeHandler(path));
-                handlersOpen_.insert( MapHandlerType::value_type(
+                handlers.insert( MapHandlerType::value_type(
                         path, handler.release() ) );
             } catch ( const std::exception & e ) {
                 LogWarn(e.what());
@@ -592,7 +946,7 @@ namespace bdt
             auto_ptr<InodeHandler> handler;
             handler.reset(new InodeHandler(path));
             if ( ! handler->Handle() ) {
-                handlersOpen_.insert( MapHandlerType::value_type(
+                GetShard(path).handlers.insert( MapHandlerType::value_type(
                         path, handler.release() ) );
             }
         }
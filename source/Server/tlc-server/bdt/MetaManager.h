@@ -27,6 +27,12 @@ namespace bdt
 
     class InodeHandler;
     class MetaDatabase;
+    class AttributeCache;
+    class EvictionIndex;
+    class BackupQueue;
+    class BackupWriter;
+    struct EvictionItem;
+    struct InodeAttribute;
 
 
     struct BackupItem
@@ -38,6 +44,14 @@ namespace bdt
     };
 
 
+    struct FolderEntry
+    {
+        string name;
+        struct stat stat;
+        off_t offset;
+    };
+
+
     class MetaManager
     {
     public:
@@ -63,15 +77,41 @@ namespace bdt
         bool
         GetActiveStat(const fs::path & path,struct stat & stat);
 
+        bool
+        GetStat(const fs::path & path,struct stat & stat);
+
+        bool
+        GetAttribute(const fs::path & path,InodeAttribute & attribute);
+
+        bool
+        GetOnline(const fs::path & path,Inode::OnlineState & state);
+
+        void
+        InvalidateAttribute(const fs::path & path);
+
+        bool
+        ReadFolder(const fs::path & path,DIR * dir,FolderEntry & entry);
+
         FileOperationInterface *
         GetFileOperation(const fs::path & path, int flags);
 
         bool
         CheckFreeCapacity();
 
+        //  the open files ready for backup
         void
         GetBackupList(vector<BackupItem> & list);
 
+        //  the file is ready for backup at the time
+        void
+        QueueBackup(
+                const fs::path & path,
+                const boost::posix_time::ptime & time);
+
+        //  waits at most timeout milliseconds for a file to get ready
+        bool
+        WaitBackup(int timeout);
+
         bool
         Backup(
                 const fs::path & path,
@@ -80,32 +120,69 @@ namespace bdt
                 fs::path & pathNew,
                 bool & writeTape );
 
+        //  backs up to all the tapes at once with writer, done and
+        //  written are per tape as in BackupWriter::Copy
+        bool
+        BackupCopies(
+                BackupWriter & writer,
+                const fs::path & path,
+                const vector<FileOperationInterface *> & files,
+                const vector<string> & tapes,
+                fs::path & pathNew,
+                vector<bool> & done,
+                vector<bool> & written );
+
         bool
         IsFileInUse(const fs::path & path);
 
         bool
         ReleaseFile(const fs::path & path);
 
+        //  the least recently used files which can be released now
+        void
+        GetEvictionList(size_t count, vector<EvictionItem> & items);
+
         bool
         LoadHandlers();
 
     private:
-        boost::mutex mutex_;
-
         fs::path folder_;
         auto_ptr<MetaDatabase> database_;
         CacheManager * cache_;
+        auto_ptr<AttributeCache> attributes_;
+        auto_ptr<EvictionIndex> eviction_;
+        auto_ptr<BackupQueue> backups_;
 
         typedef map<fs::path, InodeHandler *> MapHandlerType;
         typedef vector<InodeHandler *> ListHandlerType;
 
-        MapHandlerType handlersOpen_;
+        //  the open handlers are striped over shards by path, operations
+        //  on a path hold table_ shared and the mutex of its shard; a
+        //  folder rename holds table_ exclusively to re-key the handlers
+        struct HandlerShard
+        {
+            boost::mutex mutex;
+            MapHandlerType handlers;
+        };
+
+        static const size_t ShardCount = 16;
+
+        boost::shared_mutex table_;
+        HandlerShard shards_[ShardCount];
+
+        boost::mutex mutexDelete_;
         ListHandlerType handlersDelete_;
 
         boost::posix_time::ptime check_;
 
         auto_ptr<boost::thread> checkHandlersThread_;
 
+        HandlerShard &
+        GetShard(const fs::path & path);
+
+        void
+        DeleteHandler(InodeHandler * handler);
+
         void
         CheckHandlersTask();
 
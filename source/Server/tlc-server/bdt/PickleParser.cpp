@@ -0,0 +1,555 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * PickleParser.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+
+
+
+#include "stdafx.h"
+#include "PickleParser.h"
+
+
+namespace bdt
+{
+
+    //  the opcodes of protocol 0 to 2 which a dict of strings may use
+    enum {
+        OpMark = '(',
+        OpStop = '.',
+        OpInt = 'I',
+        OpBinInt = 'J',
+        OpBinInt1 = 'K',
+        OpBinInt2 = 'M',
+        OpLong = 'L',
+        OpNone = 'N',
+        OpFloat = 'F',
+        OpBinFloat = 'G',
+        OpString = 'S',
+        OpBinString = 'T',
+        OpShortBinString = 'U',
+        OpUnicode = 'V',
+        OpBinUnicode = 'X',
+        OpDict = 'd',
+        OpEmptyDict = '}',
+        OpSetItem = 's',
+        OpSetItems = 'u',
+        OpGet = 'g',
+        OpBinGet = 'h',
+        OpLongBinGet = 'j',
+        OpPut = 'p',
+        OpBinPut = 'q',
+        OpLongBinPut = 'r',
+        OpProto = 0x80,
+        OpNewTrue = 0x88,
+        OpNewFalse = 0x89,
+        OpLong1 = 0x8a,
+        OpLong4 = 0x8b,
+    };
+
+
+    PickleParser::PickleParser()
+    : data_(NULL), size_(0), position_(0)
+    {
+    }
+
+
+    PickleParser::~PickleParser()
+    {
+    }
+
+
+    bool
+    PickleParser::Parse(const string & data, DictType & dict)
+    {
+        dict.clear();
+
+        data_ = data.data();
+        size_ = data.size();
+        position_ = 0;
+        stack_.clear();
+        memo_.clear();
+        texts_.clear();
+        dicts_.clear();
+
+        bool ret = Load();
+        if ( ret ) {
+            if ( stack_.size() == 1 && stack_[0].type == Item::TypeDict ) {
+                dict.swap(dicts_[stack_[0].length]);
+            } else {
+                LogWarn("The pickle does not hold a dict");
+                ret = false;
+            }
+        }
+
+        data_ = NULL;
+        return ret;
+    }
+
+
+    bool
+    PickleParser::Load()
+    {
+        while ( position_ < size_ ) {
+            unsigned char op = data_[position_++];
+            const char * line;
+            size_t length;
+            long long value;
+
+            switch ( op ) {
+            case OpProto:
+                if ( ! ReadInteger(1,value) || value > 2 ) {
+                    LogWarn("Unsupported pickle protocol");
+                    return false;
+                }
+                break;
+
+            case OpStop:
+                return true;
+
+            case OpMark:
+                Push(Item::TypeMark);
+                break;
+
+            case OpEmptyDict:
+            case OpDict:
+                {
+                    size_t index = dicts_.size();
+                    dicts_.resize(index + 1);
+                    if ( op == OpDict ) {
+                        size_t mark;
+                        if ( ! FindMark(mark)
+                                || ! SetItems(dicts_[index],mark+1) ) {
+                            return false;
+                        }
+                        stack_.pop_back();
+                    }
+                    Push(Item::TypeDict, NULL, index);
+                }
+                break;
+
+            case OpSetItem:
+            case OpSetItems:
+                {
+                    //  the dict is below the mark or the pair
+                    size_t target;
+                    if ( op == OpSetItems ) {
+                        if ( ! FindMark(target) ) {
+                            return false;
+                        }
+                    } else {
+                        target = stack_.size() - 2;
+                    }
+                    if ( target == 0 || target > stack_.size()
+                            || stack_[target-1].type != Item::TypeDict ) {
+                        return false;
+                    }
+                    -- target;
+                    size_t begin = op == OpSetItems ? target + 2 : target + 1;
+                    if ( ! SetItems(dicts_[stack_[target].length],begin) ) {
+                        return false;
+                    }
+                    stack_.resize(target + 1);
+                }
+                break;
+
+            case OpString:
+            case OpUnicode:
+                if ( ! ReadLine(line,length) ) {
+                    return false;
+                }
+                Push( op == OpString ? Item::TypeString : Item::TypeUnicode,
+                        line, length );
+                break;
+
+            case OpBinString:
+            case OpShortBinString:
+            case OpBinUnicode:
+                if ( ! ReadInteger(op == OpShortBinString ? 1 : 4,value)
+                        || value < 0 || (size_t)value > size_ - position_ ) {
+                    return false;
+                }
+                Push(Item::TypeBytes, data_ + position_, value);
+                position_ += value;
+                break;
+
+            case OpInt:
+            case OpLong:
+            case OpFloat:
+                {
+                    if ( ! ReadLine(line,length) ) {
+                        return false;
+                    }
+                    string text(line,length);
+                    if ( op == OpInt && text == "00" ) {
+                        text = "False";
+                    } else if ( op == OpInt && text == "01" ) {
+                        text = "True";
+                    } else if ( op == OpLong && ! text.empty()
+                            && text[text.size()-1] == 'L' ) {
+                        text.erase(text.size()-1);
+                    }
+                    PushText(text);
+                }
+                break;
+
+            case OpBinInt:
+            case OpBinInt1:
+            case OpBinInt2:
+                {
+                    size_t size = op == OpBinInt1 ? 1 :
+                            ( op == OpBinInt2 ? 2 : 4 );
+                    if ( ! ReadInteger(size,value) ) {
+                        return false;
+                    }
+                    if ( op == OpBinInt ) {
+                        value = (int)value;
+                    }
+                    PushText(boost::lexical_cast<string>(value));
+                }
+                break;
+
+            case OpLong1:
+            case OpLong4:
+                {
+                    long long size;
+                    if ( ! ReadInteger(op == OpLong1 ? 1 : 4,size)
+                            || size < 0 || size > 8
+                            || ! ReadInteger(size,value) ) {
+                        LogWarn("Unsupported pickle long");
+                        return false;
+                    }
+                    //  two's complement of the bytes read
+                    if ( size > 0 && size < 8
+                            && ( value >> (size * 8 - 1) ) != 0 ) {
+                        value -= 1LL << (size * 8);
+                    }
+                    PushText(boost::lexical_cast<string>(value));
+                }
+                break;
+
+            case OpBinFloat:
+                {
+                    if ( 8 > size_ - position_ ) {
+                        return false;
+                    }
+                    //  big endian
+                    unsigned long long bits = 0;
+                    for ( size_t i = 0; i < 8; ++ i ) {
+                        bits = (bits << 8)
+                                | (unsigned char)data_[position_ + i];
+                    }
+                    position_ += 8;
+                    double number;
+                    memcpy(&number,&bits,sizeof(number));
+                    char buffer[32];
+                    snprintf(buffer,sizeof(buffer),"%.17g",number);
+                    PushText(buffer);
+                }
+                break;
+
+            case OpNone:
+                PushText("None");
+                break;
+
+            case OpNewTrue:
+                PushText("True");
+                break;
+
+            case OpNewFalse:
+                PushText("False");
+                break;
+
+            case OpPut:
+            case OpBinPut:
+            case OpLongBinPut:
+            case OpGet:
+            case OpBinGet:
+            case OpLongBinGet:
+                {
+                    if ( op == OpPut || op == OpGet ) {
+                        if ( ! ReadLine(line,length) || length == 0 ) {
+                            return false;
+                        }
+                        char * end;
+                        value = strtoll(line,&end,10);
+                        if ( end != line + length ) {
+                            return false;
+                        }
+                    } else {
+                        bool binary = op == OpBinPut || op == OpBinGet;
+                        if ( ! ReadInteger(binary ? 1 : 4,value) ) {
+                            return false;
+                        }
+                    }
+                    //  the memo is numbered from 0 up, one per opcode
+                    if ( value < 0 || (size_t)value > size_ ) {
+                        return false;
+                    }
+
+                    if ( op == OpPut || op == OpBinPut || op == OpLongBinPut ) {
+                        if ( stack_.empty()
+                                || stack_.back().type == Item::TypeMark ) {
+                            return false;
+                        }
+                        if ( (size_t)value >= memo_.size() ) {
+                            Item none;
+                            none.type = Item::TypeNone;
+                            none.data = NULL;
+                            none.length = 0;
+                            memo_.resize(value + 1, none);
+                        }
+                        memo_[value] = stack_.back();
+                    } else {
+                        if ( (size_t)value >= memo_.size()
+                                || memo_[value].type == Item::TypeNone ) {
+                            return false;
+                        }
+                        stack_.push_back(memo_[value]);
+                    }
+                }
+                break;
+
+            default:
+                LogWarn("Unsupported pickle opcode " << (int)op
+                        << " at " << position_ - 1);
+                return false;
+            }
+        }
+
+        LogWarn("The pickle has no stop");
+        return false;
+    }
+
+
+    bool
+    PickleParser::ReadLine(const char * & line, size_t & length)
+    {
+        const char * end = (const char *)memchr(
+                data_ + position_, '\n', size_ - position_);
+        if ( NULL == end ) {
+            return false;
+        }
+        line = data_ + position_;
+        length = end - line;
+        position_ += length + 1;
+        return true;
+    }
+
+
+    bool
+    PickleParser::ReadInteger(size_t length, long long & value)
+    {
+        if ( length > size_ - position_ ) {
+            return false;
+        }
+        //  little endian, unsigned
+        unsigned long long number = 0;
+        for ( size_t i = length; i > 0; -- i ) {
+            number = (number << 8) | (unsigned char)data_[position_ + i - 1];
+        }
+        value = number;
+        position_ += length;
+        return true;
+    }
+
+
+    void
+    PickleParser::Push(Item::Type type, const char * data, size_t length)
+    {
+        Item item;
+        item.type = type;
+        item.data = data;
+        item.length = length;
+        stack_.push_back(item);
+    }
+
+
+    void
+    PickleParser::PushText(const string & text)
+    {
+        Push(Item::TypeText, NULL, texts_.size());
+        texts_.push_back(text);
+    }
+
+
+    bool
+    PickleParser::FindMark(size_t & mark)
+    {
+        for ( size_t i = stack_.size(); i > 0; -- i ) {
+            if ( stack_[i-1].type == Item::TypeMark ) {
+                mark = i - 1;
+                return true;
+            }
+        }
+        return false;
+    }
+
+
+    bool
+    PickleParser::SetItems(DictType & dict, size_t begin)
+    {
+        if ( (stack_.size() - begin) % 2 != 0 ) {
+            return false;
+        }
+        string key;
+        for ( size_t i = begin; i < stack_.size(); i += 2 ) {
+            if ( ! GetText(stack_[i],key)
+                    || ! GetText(stack_[i+1],dict[key]) ) {
+                LogWarn("Only strings are supported in a pickle dict");
+                return false;
+            }
+        }
+        stack_.resize(begin);
+        return true;
+    }
+
+
+    bool
+    PickleParser::GetText(const Item & item, string & text)
+    {
+        switch ( item.type ) {
+        case Item::TypeText:
+            text = texts_[item.length];
+            return true;
+        case Item::TypeBytes:
+            text.assign(item.data,item.length);
+            return true;
+        case Item::TypeString:
+            return DecodeString(item.data,item.length,text);
+        case Item::TypeUnicode:
+            return DecodeUnicode(item.data,item.length,text);
+        default:
+            return false;
+        }
+    }
+
+
+    bool
+    PickleParser::DecodeString(const char * line, size_t length, string & text)
+    {
+        //  the repr of a str, quoted by ' or "
+        if ( length < 2 || ( line[0] != '\'' && line[0] != '"' )
+                || line[length-1] != line[0] ) {
+            return false;
+        }
+
+        size_t end = length - 1;
+        const char * escape =
+                (const char *) memchr(line + 1, '\\', end - 1);
+        if ( escape == NULL ) {
+            text.assign(line + 1, end - 1);
+            return true;
+        }
+
+        text.assign(line + 1, escape - line - 1);
+        for ( size_t i = escape - line; i < end; ++ i ) {
+            if ( line[i] != '\\' ) {
+                text += line[i];
+                continue;
+            }
+            if ( ++ i >= end ) {
+                return false;
+            }
+            switch ( line[i] ) {
+            case 'n':
+                text += '\n';
+                break;
+            case 'r':
+                text += '\r';
+                break;
+            case 't':
+                text += '\t';
+                break;
+            case 'x':
+                {
+                    if ( i + 2 >= end || ! isxdigit(line[i+1])
+                            || ! isxdigit(line[i+2]) ) {
+                        return false;
+                    }
+                    string hex(line + i + 1, 2);
+                    text += (char)strtol(hex.c_str(),NULL,16);
+                    i += 2;
+                }
+                break;
+            default:
+                //  \\, \' and \"
+                text += line[i];
+                break;
+            }
+        }
+        return true;
+    }
+
+
+    bool
+    PickleParser::DecodeUnicode(const char * line, size_t length, string & text)
+    {
+        //  raw-unicode-escape, the other bytes are latin-1
+        text.clear();
+        for ( size_t i = 0; i < length; ++ i ) {
+            size_t digits = 0;
+            if ( line[i] == '\\' && i + 1 < length ) {
+                if ( line[i+1] == 'u' ) {
+                    digits = 4;
+                } else if ( line[i+1] == 'U' ) {
+                    digits = 8;
+                }
+            }
+            if ( digits == 0 ) {
+                AppendUTF8((unsigned char)line[i],text);
+                continue;
+            }
+
+            if ( i + 2 + digits > length ) {
+                return false;
+            }
+            for ( size_t j = 0; j < digits; ++ j ) {
+                if ( ! isxdigit(line[i+2+j]) ) {
+                    return false;
+                }
+            }
+            string hex(line + i + 2, digits);
+            AppendUTF8(strtoul(hex.c_str(),NULL,16),text);
+            i += 1 + digits;
+        }
+        return true;
+    }
+
+
+    void
+    PickleParser::AppendUTF8(unsigned long code, string & text)
+    {
+        if ( code < 0x80 ) {
+            text += (char)code;
+        } else if ( code < 0x800 ) {
+            text += (char)(0xc0 | (code >> 6));
+            text += (char)(0x80 | (code & 0x3f));
+        } else if ( code < 0x10000 ) {
+            text += (char)(0xe0 | (code >> 12));
+            text += (char)(0x80 | ((code >> 6) & 0x3f));
+            text += (char)(0x80 | (code & 0x3f));
+        } else {
+            text += (char)(0xf0 | (code >> 18));
+            text += (char)(0x80 | ((code >> 12) & 0x3f));
+            text += (char)(0x80 | ((code >> 6) & 0x3f));
+            text += (char)(0x80 | (code & 0x3f));
+        }
+    }
+
+}
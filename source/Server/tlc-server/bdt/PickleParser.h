@@ -0,0 +1,109 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * PickleParser.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+
+
+#pragma once
+
+
+namespace bdt
+{
+
+    //  Loads a pickle of protocol 0 to 2 holding a dict, as Swift keeps
+    //  the metadata of an object. The keys are strings; the values are
+    //  strings, or ints, longs, floats, bools and None kept as their text.
+    //  Unicode is returned as UTF-8. Lists, tuples and objects fail.
+    class PickleParser
+    {
+    public:
+        typedef map<string, string> DictType;
+
+        PickleParser();
+
+        ~PickleParser();
+
+        bool
+        Parse(const string & data, DictType & dict);
+
+    private:
+        //  a string stays in the data until it goes into the dict, a
+        //  text or a dict is kept aside by its index
+        struct Item
+        {
+            enum Type {
+                TypeNone,
+                TypeMark,
+                TypeText,
+                TypeBytes,
+                TypeString,
+                TypeUnicode,
+                TypeDict,
+            };
+
+            Type type;
+            const char * data;
+            size_t length;
+        };
+
+        const char * data_;
+        size_t size_;
+        size_t position_;
+
+        vector<Item> stack_;
+        vector<Item> memo_;
+        vector<string> texts_;
+        vector<DictType> dicts_;
+
+        bool
+        Load();
+
+        bool
+        ReadLine(const char * & line, size_t & length);
+
+        bool
+        ReadInteger(size_t length, long long & value);
+
+        void
+        Push(Item::Type type, const char * data = NULL, size_t length = 0);
+
+        void
+        PushText(const string & text);
+
+        bool
+        FindMark(size_t & mark);
+
+        //  the pairs on the stack from begin are set and popped
+        bool
+        SetItems(DictType & dict, size_t begin);
+
+        bool
+        GetText(const Item & item, string & text);
+
+        static bool
+        DecodeString(const char * line, size_t length, string & text);
+
+        static bool
+        DecodeUnicode(const char * line, size_t length, string & text);
+
+        static void
+        AppendUTF8(unsigned long code, string & text);
+    };
+
+}
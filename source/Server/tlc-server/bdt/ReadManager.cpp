@@ -22,11 +22,14 @@
 #include "stdafx.h"
 #include "ReadManager.h"
 #include "ReadTask.h"
+#include "ReadTaskPool.h"
 #include "CacheManager.h"
 #include "MetaDatabase.h"
 #include "FileOperationBitmap.h"
 #include "FileOperationPriority.h"
 #include "FileOperationDelay.h"
+#include "FileOperationRecall.h"
+#include "FileOperationRange.h"
 
 
 namespace bdt
@@ -36,7 +39,18 @@ namespace bdt
 
 
     ReadManager::ReadManager()
-    : cache_(Factory::GetCacheManager()), database_(new MetaDatabase())
+    : cache_(Factory::GetCacheManager()), database_(new MetaDatabase()),
+      recalls_(new RecallQueue(Factory::GetConfigure()->GetValueSize(
+              Configure::RecallQueueWindow))),
+      pool_(new ReadTaskPool(
+              Factory::GetConfigure()->GetValueSize(
+                      Configure::ReadTaskThreads),
+              Factory::GetConfigure()->GetValueSize(
+                      Configure::ReadTaskTapeLimit),
+              Factory::GetConfigure()->GetValueSize(
+                      Configure::ReadTaskBufferCount),
+              Factory::GetConfigure()->GetValueSize(
+                      Configure::ReadTaskBufferSize)))
     {
         PreReadTimeout = Factory::GetConfigure()->GetValueSize(
               Configure::FileIdleTime );
@@ -106,6 +120,21 @@ namespace bdt
         if ( ! database_->GetFileBackupInfo(number,tape,path) ) {
             return false;
         }
+        off_t position;
+        off_t size;
+        if ( ! database_->GetFilePack(number,tape,path,position,size) ) {
+            LogWarn(number << " fails to get pack on tape " << tape);
+            return false;
+        }
+
+        off_t block = 0;
+        if ( ! database_->GetFileStartBlock(number,tape,block) ) {
+            LogWarn(number << " fails to get start block on tape " << tape);
+        }
+
+        //  the recalls of a tape are issued in the order of the start block,
+        //  the turn is held until the read task finishes or goes idle
+        bool ordered = recalls_->Enter(tape,block,timeout);
 
         StopPreRead(tape);
 
@@ -120,11 +149,29 @@ namespace bdt
                     ScheduleInterface::PRIORITY_READ ) );
         } catch ( const std::exception & e ) {
             LogInfo(number << " fails to schedule tape " << tape);
+            if ( ordered ) {
+                recalls_->Leave(tape);
+            }
             return false;
         }
 #endif
+        if ( position >= 0 ) {
+            source.reset( new FileOperationRange(
+                    boost::shared_ptr<FileOperationInterface>(source.release()),
+                    position, size ) );
+        }
+        if ( ordered ) {
+            source.reset( new FileOperationRecall(
+                    source.release(), recalls_.get(), tape ) );
+        }
 
+        //  another open of the number may have begun the read while this
+        //  one waited for the turn
         lock.lock();
+        if ( items_.find(number) != items_.end() ) {
+            LogWarn(number << " in read task already");
+            return true;
+        }
         auto_ptr<FileOperationBitmap> target;
         target.reset(cache_->GetFileOperationBitmap(number,O_WRONLY));
         if ( NULL == target.get() ) {
@@ -135,7 +182,8 @@ namespace bdt
         item.tape = tape;
         item.offset = -1;
         item.task = new ReadTask(
-                number, source.release(), target.release(), this);
+                number, tape, source.release(), target.release(), this,
+                pool_.get());
         item.preRead = false;
         items_.insert( ReadMap::value_type( number, item ) );
         return true;
@@ -270,6 +318,11 @@ namespace bdt
             return;
         }
 
+        //  pending recalls of the tape go first
+        if ( ! recalls_->IsIdle(tape) ) {
+            return;
+        }
+
         boost::lock_guard<boost::mutex> lock(mutexPreRead_);
 
         PreReadMap::iterator i = preReadItems_.find(tape);
@@ -401,6 +454,11 @@ namespace bdt
             LogWarn(number << " fails to get backup info for tape " << tape);
             return false;
         }
+        off_t position;
+        if ( ! database_->GetFilePack(number,tape,path,position,size) ) {
+            LogWarn(number << " fails to get pack on tape " << tape);
+            return false;
+        }
 
         if ( boost::this_thread::interruption_requested() ) {
             LogInfo(number << " is interrupted for pre-read");
@@ -421,6 +479,11 @@ namespace bdt
             return false;
         }
 #endif
+        if ( position >= 0 ) {
+            source.reset( new FileOperationRange(
+                    boost::shared_ptr<FileOperationInterface>(source.release()),
+                    position, size ) );
+        }
 
         if ( boost::this_thread::interruption_requested() ) {
             LogInfo(number << " is interrupted for pre-read");
@@ -30,6 +30,8 @@ namespace bdt
 
     class MetaDatabase;
     class FileOperationBitmap;
+    class RecallQueue;
+    class ReadTaskPool;
 
 
     struct ReadItem
@@ -78,6 +80,8 @@ namespace bdt
     private:
         CacheManager * cache_;
         auto_ptr<MetaDatabase> database_;
+        auto_ptr<RecallQueue> recalls_;
+        auto_ptr<ReadTaskPool> pool_;
 
         boost::mutex mutex_;
         typedef map<unsigned long long,ReadItem> ReadMap;
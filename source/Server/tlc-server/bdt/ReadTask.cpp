@@ -21,6 +21,8 @@
 
 #include "stdafx.h"
 #include "ReadTask.h"
+#include "ReadTaskPool.h"
+#include "CacheWriter.h"
 #include "FileOperationBitmap.h"
 #include "CacheManager.h"
 
@@ -28,27 +30,49 @@
 namespace bdt
 {
 
-    static const int BUFFER_SIZE = 512 * 1024;
-
-
     ReadTask::ReadTask(
             const unsigned long long number,
+            const string & tape,
             FileOperationInterface * source,
             FileOperationBitmap * file,
-            ReadTaskCallback * callback)
-    : number_(number), cache_(Factory::GetCacheManager()),
+            ReadTaskCallback * callback,
+            ReadTaskPool * pool)
+    : number_(number), tape_(tape), cache_(Factory::GetCacheManager()),
       source_(source), file_(file),
-      running_(false), success_(false), current_(-1), errno_(0),
+      running_(true), success_(false), stop_(false), pool_(pool),
+      current_(-1), errno_(0),
       callback_(callback)
     {
-        thread_.reset( new boost::thread( &ReadTask::BackendTask, this ) );
-        running_ = true;
+        //  finishes at once if the file is in the cache already, otherwise
+        //  the task waits for the first request
+        boost::lock_guard<boost::mutex> lock(mutex_);
+        if ( file_->IsFull() ) {
+            Schedule();
+        }
     }
 
     ReadTask::~ReadTask()
     {
-        thread_->interrupt();
-        thread_->join();
+        {
+            boost::lock_guard<boost::mutex> lock(mutex_);
+            stop_ = true;
+        }
+
+        pool_->Cancel(this);
+
+        {
+            boost::lock_guard<boost::mutex> lock(mutex_);
+            if ( running_ ) {
+                LogDebug(number_ << " read stopped");
+                running_ = false;
+                success_ = false;
+                errno_ = ECANCELED;
+            }
+            source_.reset();
+            file_.reset();
+        }
+
+        condition_.notify_all();
     }
 
 
@@ -97,11 +121,13 @@ namespace bdt
                 }
             }
             if ( wait ) {
+                Schedule();
                 condition_.wait(lock);
                 continue;
             } else {
                 if ( (current_ < 0) && queueWait_.empty() ) {
                     queueWait_.push_back(offset / sizeBlock * sizeBlock);
+                    Schedule();
                 }
                 lock.unlock();
                 return true;
@@ -126,6 +152,12 @@ namespace bdt
             return false;
         }
 
+        //  a truncate is no request to read, the tape is not needed until
+        //  the next one
+        if ( source_.get() != NULL && current_ < 0 && queueWait_.empty() ) {
+            source_->Idle();
+        }
+
         if ( length < lengthOld ) {
             if ( file_->SetBitmapLength(length) ) {
                 return true;
@@ -181,232 +213,247 @@ namespace bdt
     }
 
 
+    bool
+    ReadTask::IsStopped()
+    {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+
+        return stop_;
+    }
+
+
     void
-    ReadTask::BackendTask()
+    ReadTask::Schedule()
     {
-        success_ = false;
-        errno_ = 0;
+        //  mutex_ is held by the caller
+        if ( ! stop_ ) {
+            pool_->Schedule(this);
+        }
+    }
 
-        off_t length;
-        boost::scoped_array<char> buf;
-        buf.reset(new char[BUFFER_SIZE]);
+
+    bool
+    ReadTask::Run(CacheWriter & writer)
+    {
+        {
+            boost::lock_guard<boost::mutex> lock(mutex_);
+            if ( stop_ || ! running_ ) {
+                return false;
+            }
+        }
 
         if ( file_->IsFull() ) {
-            goto BackendTaskFinish;
+            Finish();
+            return false;
         }
 
         size_t sizeBlock;
         if ( ! file_->GetBlockSize(sizeBlock) ) {
             LogError(number_ << " has a corrupt bitmap");
-            errno = EIO;
-            goto BackendTaskError;
+            Fail(EIO);
+            return false;
         }
 
-        do {
-            if ( boost::this_thread::interruption_requested() ) {
-                LogWarn("Interrupt: " << number_);
-                goto BackendTaskStop;
-            }
-            if ( ! CanWriteCache() ) {
-                LogWarn("Cache is not writable: " << number_);
-                goto BackendTaskError;
-            }
+        if ( ! CanWriteCache() ) {
+            LogWarn("Cache is not writable: " << number_);
+            Fail(errno);
+            return false;
+        }
 
-            vector<off_t>::iterator i;
-            {
-                boost::lock_guard<boost::mutex> lock(mutex_);
-                i = queueWait_.begin();
-                if ( i != queueWait_.end() ) {
-                    current_ = *i;
-                    LogDebug(number_ << " " << current_);
-                }
+        off_t length;
+        int sizeRead = sizeBlock;
+        {
+            boost::lock_guard<boost::mutex> lock(mutex_);
+            vector<off_t>::iterator i = queueWait_.begin();
+            if ( i != queueWait_.end() ) {
+                current_ = *i;
             }
             if ( current_ < 0 ) {
-                boost::this_thread::yield();
-                continue;
+                //  nothing is requested yet, Prepare schedules the task
+                source_->Idle();
+                return false;
             }
 
             LogDebug(number_ << " " << current_);
 
-            if ( boost::this_thread::interruption_requested() ) {
-                LogWarn("Interrupt: " << number_);
-                goto BackendTaskStop;
-            }
-            if ( ! CanWriteCache() ) {
-                LogWarn("Cache is not writable: " << number_);
-                goto BackendTaskError;
-            }
-
-            int sizeRead = sizeBlock;
-            {
-                boost::lock_guard<boost::mutex> lock(mutex_);
-                file_->GetBitmapLength(length);
-                if ( length <= current_ ) {
-                    LogWarn(number_ << " " << length << " " << current_);
-                    i = queueWait_.begin();
-                    while ( i != queueWait_.end() ) {
-                        if ( length <= *i ) {
-                            LogWarn(number_ << " " << *i);
-                            i = queueWait_.erase(i);
-                        } else {
-                            ++ i;
-                        }
-                    }
-                    current_ = 0;
-                    if ( file_->IsFull() ) {
-                        goto BackendTaskFinish;
-                    }
-                    continue;
-                }
-                if ( (length - current_) < sizeRead ) {
-                    sizeRead = length - current_;
-                }
-            }
-            condition_.notify_all();
-
-            if ( ! file_->CheckBitmap(current_,sizeRead) ) {
-                LogDebug(number_ << " " << current_ << " " << sizeRead);
-                size_t size;
-                off_t begin = current_;
-                while ( source_->Read(
-                        begin, buf.get(), BUFFER_SIZE, size ) ) {
-                    if ( size == 0 ) {
-                        file_->GetBitmapLength(length);
-                        if ( length > begin ) {
-                            LogError(number_ << " " << length << " " << begin);
-                            errno = EIO;
-                            goto BackendTaskError;
-                        } else {
-                            LogWarn(number_ << " " << length << " " << begin);
-                            break;
-                        }
-                    }
-                    if ( boost::this_thread::interruption_requested() ) {
-                        LogWarn("Interrupt: " << number_);
-                        goto BackendTaskStop;
-                    }
-                    if ( ! CanWriteCache() ) {
-                        LogWarn("Cache is not writable: " << number_);
-                        goto BackendTaskError;
-                    }
-                    {
-                        //lock is required,
-                        //in case the file is truncated during writting
-                        boost::lock_guard<boost::mutex> lock(mutex_);
-                        file_->GetBitmapLength(length);
-                        if ( length <= begin ) {
-                            break;
-                        }
-                        if ( (length - begin) < (int)size ) {
-                            size = length - begin;
-                        }
-                        if ( ! file_->Write(begin,buf.get(),size,size) ) {
-                            LogError(number_ << ":" << begin << ":" << size);
-                            goto BackendTaskError;
-                        }
-                    }
-                    condition_.notify_all();
-                    begin += size;
-                    if ( begin >= current_ + sizeRead ) {
-                        break;
-                    }
-                }
-            }
-
-            bool notify = false;
-            {
-                boost::unique_lock<boost::mutex> lock(mutex_);
+            file_->GetBitmapLength(length);
+            if ( length <= current_ ) {
+                LogWarn(number_ << " " << length << " " << current_);
                 i = queueWait_.begin();
                 while ( i != queueWait_.end() ) {
-                    if ( current_ == *i ) {
+                    if ( length <= *i ) {
+                        LogWarn(number_ << " " << *i);
                         i = queueWait_.erase(i);
-                        notify = true;
                     } else {
                         ++ i;
                     }
                 }
-                if ( notify ) {
-                    lock.unlock();
-                    condition_.notify_all();
+                current_ = 0;
+                return true;
+            }
+            if ( (length - current_) < sizeRead ) {
+                sizeRead = length - current_;
+            }
+        }
+        condition_.notify_all();
+
+        if ( ! file_->CheckBitmap(current_,sizeRead) ) {
+            LogDebug(number_ << " " << current_ << " " << sizeRead);
+            if ( ! Copy(writer,current_,sizeRead) ) {
+                if ( errno != ECANCELED ) {
+                    Fail(errno);
                 }
+                return false;
             }
+        }
 
-            current_ += sizeRead;
-            file_->GetBitmapLength(length);
-            if ( current_ >= length ) {
-                if ( file_->IsFull() ) {
-                    goto BackendTaskFinish;
+        bool notify = false;
+        {
+            boost::unique_lock<boost::mutex> lock(mutex_);
+            vector<off_t>::iterator i = queueWait_.begin();
+            while ( i != queueWait_.end() ) {
+                if ( current_ == *i ) {
+                    i = queueWait_.erase(i);
+                    notify = true;
                 } else {
-                    current_ = 0;
+                    ++ i;
                 }
             }
-        } while (true);
+        }
+        if ( notify ) {
+            condition_.notify_all();
+        }
 
-        goto BackendTaskError;
+        current_ += sizeRead;
+        file_->GetBitmapLength(length);
+        if ( current_ >= length ) {
+            if ( file_->IsFull() ) {
+                Finish();
+                return false;
+            } else {
+                current_ = 0;
+            }
+        }
+        return true;
+    }
 
 
-BackendTaskFinish:
+    bool
+    ReadTask::Copy(CacheWriter & writer, off_t offset, size_t size)
+    {
+        off_t begin = offset;
+        off_t length;
+        int error = 0;
 
-        LogDebug(number_ << " read success");
+        while ( begin < (off_t)(offset + size) ) {
+            if ( IsStopped() ) {
+                LogWarn("Interrupt: " << number_);
+                error = ECANCELED;
+                break;
+            }
+            if ( ! CanWriteCache() ) {
+                LogWarn("Cache is not writable: " << number_);
+                error = errno;
+                break;
+            }
+            char * buffer = writer.GetBuffer();
+            if ( NULL == buffer ) {
+                error = errno;
+                break;
+            }
+            size_t sizeRead;
+            if ( ! source_->Read(
+                    begin, buffer, writer.GetBufferSize(), sizeRead ) ) {
+                writer.Discard(buffer);
+                break;
+            }
+            if ( sizeRead == 0 ) {
+                writer.Discard(buffer);
+                file_->GetBitmapLength(length);
+                if ( length > begin ) {
+                    LogError(number_ << " " << length << " " << begin);
+                    error = EIO;
+                } else {
+                    LogWarn(number_ << " " << length << " " << begin);
+                }
+                break;
+            }
+            {
+                //  in case the file is truncated during the read
+                boost::lock_guard<boost::mutex> lock(mutex_);
+                file_->GetBitmapLength(length);
+            }
+            if ( length <= begin ) {
+                writer.Discard(buffer);
+                break;
+            }
+            if ( (length - begin) < (off_t)sizeRead ) {
+                sizeRead = length - begin;
+            }
+            writer.Write(file_.get(), begin, buffer, sizeRead);
+            cache_->ReserveCapacity(sizeRead);
+            begin += sizeRead;
+        }
 
-        if ( ! file_->IsFull() ) {
-            LogWarn(number_);
-            goto BackendTaskError;
+        //  the queued buffers refer to file_
+        if ( ! writer.Flush() && error == 0 ) {
+            LogError(number_ << " fails to write at " << offset);
+            error = errno;
+        }
+        if ( error != 0 ) {
+            errno = error;
+            return false;
         }
 
         {
+            //  one bitmap update for the whole range
             boost::lock_guard<boost::mutex> lock(mutex_);
-            running_ = false;
-            success_ = file_->IsFull();
-            source_.reset();
+            file_->GetBitmapLength(length);
+            if ( min(begin,length) > offset ) {
+                file_->MarkBitmap(offset, min(begin,length) - offset);
+            }
         }
-
         condition_.notify_all();
 
-        if ( callback_ != NULL ) {
-            callback_->FinishReadTask(number_);
-        }
-
-        return;
-
+        return true;
+    }
 
-BackendTaskStop:
 
-        LogDebug(number_ << " read stopped");
+    void
+    ReadTask::Finish()
+    {
+        LogDebug(number_ << " read success");
 
         {
             boost::lock_guard<boost::mutex> lock(mutex_);
             running_ = false;
-            success_ = false;
-            errno_ = ECANCELED;
+            success_ = file_->IsFull();
             source_.reset();
-            file_.reset();
         }
 
         condition_.notify_all();
 
-        return;
-
+        if ( callback_ != NULL ) {
+            callback_->FinishReadTask(number_);
+        }
+    }
 
-BackendTaskError:
 
+    void
+    ReadTask::Fail(int error)
+    {
         LogDebug(number_ << " read error");
 
         {
             boost::lock_guard<boost::mutex> lock(mutex_);
             running_ = false;
             success_ = false;
-            errno_ = errno;
+            errno_ = error;
             source_.reset();
             file_.reset();
         }
 
         condition_.notify_all();
-
-        return;
     }
 
-
 }
-
-
@@ -27,6 +27,8 @@ namespace bdt
 
     class CacheManager;
     class FileOperationBitmap;
+    class ReadTaskPool;
+    class CacheWriter;
 
 
     class ReadTaskCallback
@@ -42,9 +44,11 @@ namespace bdt
     public:
         ReadTask(
                 const unsigned long long number,
+                const string & tape,
                 FileOperationInterface * source,
                 FileOperationBitmap * file,
-                ReadTaskCallback * callback);
+                ReadTaskCallback * callback,
+                ReadTaskPool * pool);
 
         ~ReadTask();
 
@@ -62,8 +66,20 @@ namespace bdt
         bool
         IsRunning();
 
+        const string &
+        GetTape()
+        {
+            return tape_;
+        }
+
+        //  called by the pool, reads the next block into the cache;
+        //  false when there is nothing to do until the next request
+        bool
+        Run(CacheWriter & writer);
+
     private:
         unsigned long long number_;
+        string tape_;
         CacheManager * cache_;
         auto_ptr<FileOperationInterface> source_;
         auto_ptr<FileOperationBitmap> file_;
@@ -73,7 +89,8 @@ namespace bdt
 
         bool running_;
         bool success_;
-        auto_ptr<boost::thread> thread_;
+        bool stop_;
+        ReadTaskPool * pool_;
         vector<off_t> queueWait_;
         off_t current_;
         int errno_;
@@ -81,8 +98,20 @@ namespace bdt
         bool
         CanWriteCache();
 
+        bool
+        IsStopped();
+
+        void
+        Schedule();
+
+        bool
+        Copy(CacheWriter & writer, off_t offset, size_t size);
+
+        void
+        Finish();
+
         void
-        BackendTask();
+        Fail(int error);
 
         ReadTaskCallback * callback_;
     };
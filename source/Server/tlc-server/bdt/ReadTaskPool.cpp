@@ -0,0 +1,152 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * ReadTaskPool.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+
+#include "stdafx.h"
+#include "ReadTaskPool.h"
+#include "ReadTask.h"
+#include "CacheWriter.h"
+
+
+namespace bdt
+{
+
+    ReadTaskPool::ReadTaskPool(
+            size_t threads,
+            size_t tapeLimit,
+            size_t buffers,
+            size_t bufsize)
+    : tapeLimit_(max<size_t>(tapeLimit,1)),
+      buffers_(max<size_t>(buffers,1)),
+      bufsize_(max<size_t>(bufsize,4096)),
+      stop_(false)
+    {
+        threads = max<size_t>(threads,1);
+        for ( size_t i = 0; i < threads; ++ i ) {
+            threads_.create_thread( boost::bind(&ReadTaskPool::Worker,this) );
+        }
+    }
+
+
+    ReadTaskPool::~ReadTaskPool()
+    {
+        {
+            boost::lock_guard<boost::mutex> lock(mutex_);
+            if ( ! tasks_.empty() ) {
+                LogWarn(tasks_.size() << " read tasks are left in the pool");
+            }
+            stop_ = true;
+        }
+        conditionWork_.notify_all();
+        threads_.join_all();
+    }
+
+
+    void
+    ReadTaskPool::Schedule(ReadTask * task)
+    {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+
+        MapTaskType::iterator i = tasks_.find(task);
+        if ( i == tasks_.end() ) {
+            tasks_.insert( MapTaskType::value_type( task, TaskQueued ) );
+            queue_.push_back(task);
+            conditionWork_.notify_one();
+        } else if ( i->second == TaskRunning ) {
+            //  queued again once the running block is done
+            i->second = TaskRunningAgain;
+        }
+    }
+
+
+    void
+    ReadTaskPool::Cancel(ReadTask * task)
+    {
+        boost::unique_lock<boost::mutex> lock(mutex_);
+
+        while ( true ) {
+            MapTaskType::iterator i = tasks_.find(task);
+            if ( i == tasks_.end() ) {
+                return;
+            }
+            if ( i->second == TaskQueued ) {
+                queue_.remove(task);
+                tasks_.erase(i);
+                return;
+            }
+            i->second = TaskRunning;
+            conditionDone_.wait(lock);
+        }
+    }
+
+
+    void
+    ReadTaskPool::Worker()
+    {
+        CacheWriter writer(buffers_,bufsize_);
+
+        boost::unique_lock<boost::mutex> lock(mutex_);
+
+        while ( ! stop_ ) {
+            list<ReadTask *>::iterator i = queue_.begin();
+            while ( i != queue_.end() ) {
+                MapTapeType::iterator tape = tapes_.find((*i)->GetTape());
+                if ( tape == tapes_.end() || tape->second < tapeLimit_ ) {
+                    break;
+                }
+                ++ i;
+            }
+            if ( i == queue_.end() ) {
+                conditionWork_.wait(lock);
+                continue;
+            }
+
+            ReadTask * task = *i;
+            string tape = task->GetTape();
+            queue_.erase(i);
+            tasks_[task] = TaskRunning;
+            ++ tapes_[tape];
+
+            lock.unlock();
+            bool more = task->Run(writer);
+            lock.lock();
+
+            MapTapeType::iterator t = tapes_.find(tape);
+            if ( -- t->second == 0 ) {
+                tapes_.erase(t);
+            }
+
+            MapTaskType::iterator s = tasks_.find(task);
+            if ( more || s->second == TaskRunningAgain ) {
+                s->second = TaskQueued;
+                queue_.push_back(task);
+            } else {
+                tasks_.erase(s);
+            }
+
+            //  a slot of the tape is free for the other workers
+            if ( ! queue_.empty() ) {
+                conditionWork_.notify_all();
+            }
+            conditionDone_.notify_all();
+        }
+    }
+
+}
@@ -0,0 +1,93 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * ReadTaskPool.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+
+#pragma once
+
+
+#include <list>
+
+
+namespace bdt
+{
+
+    class ReadTask;
+
+
+    //  Fixed set of threads running the read tasks. A task is queued when
+    //  it has work to do, a worker runs one block of it and queues it
+    //  again at the back, so the tasks share the workers. At most
+    //  tapeLimit workers run tasks of the same tape. Every worker has a
+    //  CacheWriter with the given number of buffers of bufsize bytes, so
+    //  the pool runs two threads per worker.
+    class ReadTaskPool
+    {
+    public:
+        ReadTaskPool(
+                size_t threads,
+                size_t tapeLimit,
+                size_t buffers,
+                size_t bufsize);
+
+        ~ReadTaskPool();
+
+        void
+        Schedule(ReadTask * task);
+
+        //  the task is neither queued nor running on return
+        void
+        Cancel(ReadTask * task);
+
+        size_t
+        GetThreadCount()
+        {
+            return threads_.size();
+        }
+
+    private:
+        enum TaskState
+        {
+            TaskQueued,
+            TaskRunning,
+            TaskRunningAgain
+        };
+
+        typedef map<ReadTask *, TaskState> MapTaskType;
+        typedef map<string, size_t> MapTapeType;
+
+        size_t tapeLimit_;
+        size_t buffers_;
+        size_t bufsize_;
+        bool stop_;
+
+        boost::mutex mutex_;
+        boost::condition_variable conditionWork_;
+        boost::condition_variable conditionDone_;
+        list<ReadTask *> queue_;
+        MapTaskType tasks_;
+        MapTapeType tapes_;
+
+        boost::thread_group threads_;
+
+        void
+        Worker();
+    };
+
+}
@@ -0,0 +1,163 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * RecallQueue.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+
+#include "stdafx.h"
+#include "RecallQueue.h"
+
+
+namespace bdt
+{
+
+    RecallQueue::RecallQueue(int window)
+    : window_(window), ticket_(0)
+    {
+        if ( window_ < 0 ) {
+            window_ = 0;
+        }
+    }
+
+
+    RecallQueue::~RecallQueue()
+    {
+    }
+
+
+    bool
+    RecallQueue::Enter(const string & tape, off_t block, int timeout)
+    {
+        boost::unique_lock<boost::mutex> lock(mutex_);
+
+        boost::posix_time::ptime now =
+                boost::posix_time::microsec_clock::universal_time();
+        boost::posix_time::ptime deadline =
+                now + boost::posix_time::milliseconds(timeout);
+
+        MapTapeType::iterator i = tapes_.find(tape);
+        if ( i == tapes_.end() ) {
+            Tape item;
+            item.granted = 0;
+            item.busy = false;
+            item.position = 0;
+            item.collect = now + boost::posix_time::milliseconds(window_);
+            i = tapes_.insert( MapTapeType::value_type( tape, item ) ).first;
+        }
+        Tape & item = i->second;
+
+        KeyType key( block, ++ ticket_ );
+        item.pending.insert(key);
+
+        try {
+            while ( true ) {
+                if ( item.granted == key.second ) {
+                    item.granted = 0;
+                    item.busy = true;
+                    return true;
+                }
+
+                now = boost::posix_time::microsec_clock::universal_time();
+                bool idle = ( ! item.busy ) && item.granted == 0;
+                if ( idle && now >= item.collect ) {
+                    Dispatch(item);
+                    continue;
+                }
+                if ( now >= deadline ) {
+                    LogInfo(tape << " has no turn for block " << block);
+                    Cancel(i,key);
+                    return false;
+                }
+
+                boost::posix_time::ptime wakeup = deadline;
+                if ( idle && item.collect < wakeup ) {
+                    wakeup = item.collect;
+                }
+                condition_.timed_wait(lock,wakeup);
+            }
+        } catch ( const boost::thread_interrupted & ) {
+            Cancel(i,key);
+            throw;
+        }
+    }
+
+
+    void
+    RecallQueue::Leave(const string & tape)
+    {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+
+        MapTapeType::iterator i = tapes_.find(tape);
+        if ( i == tapes_.end() || ! i->second.busy ) {
+            LogWarn(tape << " is not in recall");
+            return;
+        }
+
+        i->second.busy = false;
+        if ( i->second.pending.empty() ) {
+            tapes_.erase(i);
+        } else {
+            Dispatch(i->second);
+        }
+    }
+
+
+    bool
+    RecallQueue::IsIdle(const string & tape)
+    {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+        return tapes_.find(tape) == tapes_.end();
+    }
+
+
+    void
+    RecallQueue::Dispatch(Tape & tape)
+    {
+        set<KeyType>::iterator next = tape.pending.lower_bound(
+                KeyType( tape.position, 0 ) );
+        if ( next == tape.pending.end() ) {
+            //  start the next sweep
+            next = tape.pending.begin();
+        }
+        tape.position = next->first;
+        tape.granted = next->second;
+        tape.pending.erase(next);
+        condition_.notify_all();
+    }
+
+
+    void
+    RecallQueue::Cancel(MapTapeType::iterator i, const KeyType & key)
+    {
+        Tape & tape = i->second;
+        tape.pending.erase(key);
+        if ( tape.granted == key.second ) {
+            tape.granted = 0;
+        }
+        if ( tape.busy || tape.granted != 0 ) {
+            return;
+        }
+        if ( tape.pending.empty() ) {
+            tapes_.erase(i);
+        } else {
+            //  the waiters check the window themselves
+            condition_.notify_all();
+        }
+    }
+
+}
@@ -0,0 +1,80 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * RecallQueue.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+
+#pragma once
+
+
+namespace bdt
+{
+
+    //  Orders the recalls of a tape by their start block. Only one recall
+    //  of a tape holds the turn at a time. When the tape is idle, the
+    //  recalls arriving within the window are collected before the first
+    //  one is granted; then the turn goes to the lowest start block at or
+    //  after the last granted one. Late arrivals ahead of the position join
+    //  the running sweep, the ones behind wait for the next sweep, which
+    //  starts again from the lowest start block.
+    class RecallQueue
+    {
+    public:
+        RecallQueue(int window);
+
+        ~RecallQueue();
+
+        //  waits at most timeout milliseconds for the turn
+        bool
+        Enter(const string & tape, off_t block, int timeout);
+
+        void
+        Leave(const string & tape);
+
+        //  no recall holds or waits for the tape
+        bool
+        IsIdle(const string & tape);
+
+    private:
+        typedef pair<off_t, unsigned long long> KeyType;
+
+        struct Tape
+        {
+            set<KeyType> pending;
+            unsigned long long granted;
+            bool busy;
+            off_t position;
+            boost::posix_time::ptime collect;
+        };
+
+        typedef map<string, Tape> MapTapeType;
+
+        int window_;
+        unsigned long long ticket_;
+        boost::mutex mutex_;
+        boost::condition_variable condition_;
+        MapTapeType tapes_;
+
+        void
+        Dispatch(Tape & tape);
+
+        void
+        Cancel(MapTapeType::iterator i, const KeyType & key);
+    };
+
+}
@@ -0,0 +1,464 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * RpcChannel.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+
+
+
+#include "stdafx.h"
+#include "RpcChannel.h"
+#include "RpcCodec.h"
+
+#include <poll.h>
+#include <arpa/inet.h>
+#include <xmlrpc-c/xml.hpp>
+
+
+namespace bdt
+{
+
+    const char RpcChannel::Magic[8] = { 'B', 'D', 'T', 'R', 'P', 'C', '1', '\n' };
+
+    //  milliseconds an older server has to show it does not know the hello
+    static const int HelloTimeout = 1000;
+    //  seconds before an older server is asked again
+    static const int LegacyInterval = 60;
+    static const size_t MaxFrameSize = 64 * 1024 * 1024;
+
+
+    static bool
+    WriteAll(int handle, const char * buffer, size_t size)
+    {
+        while ( size > 0 ) {
+            ssize_t done = send(handle,buffer,size,MSG_NOSIGNAL);
+            if ( done < 0 && errno == EINTR ) {
+                continue;
+            }
+            if ( done <= 0 ) {
+                return false;
+            }
+            buffer += done;
+            size -= done;
+        }
+        return true;
+    }
+
+
+    static bool
+    ReadAll(int handle, char * buffer, size_t size)
+    {
+        while ( size > 0 ) {
+            ssize_t done = recv(handle,buffer,size,0);
+            if ( done < 0 && errno == EINTR ) {
+                continue;
+            }
+            if ( done <= 0 ) {
+                return false;
+            }
+            buffer += done;
+            size -= done;
+        }
+        return true;
+    }
+
+
+    //  One socket of a channel, shared by the calls running on it
+    class RpcConnection
+    {
+    public:
+        RpcConnection(int handle, bool binary)
+        : handle_(handle), binary_(binary), id_(0), broken_(false),
+          reader_(boost::thread(&RpcConnection::ReadTask,this))
+        {
+        }
+
+        ~RpcConnection()
+        {
+            Break();
+            reader_.join();
+            close(handle_);
+        }
+
+        bool
+        IsBinary() const
+        {
+            return binary_;
+        }
+
+        bool
+        IsBroken()
+        {
+            boost::lock_guard<boost::mutex> lock(mutex_);
+            return broken_;
+        }
+
+        //  false when the socket breaks before the response
+        bool
+        Call(
+                unsigned char kind,
+                const string & request,
+                unsigned char & kindResponse,
+                string & response)
+        {
+            Pending pending;
+            pending.done = false;
+            pending.kind = RpcChannel::KindResponseNone;
+
+            unsigned int id;
+            {
+                boost::lock_guard<boost::mutex> lock(mutex_);
+                if ( broken_ ) {
+                    return false;
+                }
+                id = ++ id_;
+                pending_[id] = &pending;
+            }
+
+            bool written;
+            {
+                boost::lock_guard<boost::mutex> lock(mutexWrite_);
+                written = RpcChannel::WriteFrame(handle_,id,kind,request);
+            }
+            if ( ! written ) {
+                Break();
+            }
+
+            boost::unique_lock<boost::mutex> lock(mutex_);
+            try {
+                while ( ! pending.done ) {
+                    pending.condition.wait(lock);
+                }
+            } catch ( const boost::thread_interrupted & ) {
+                //  the response is dropped when it comes
+                pending_.erase(id);
+                throw;
+            }
+            kindResponse = pending.kind;
+            response.swap(pending.data);
+            return kindResponse != RpcChannel::KindResponseNone;
+        }
+
+    private:
+        struct Pending
+        {
+            bool done;
+            unsigned char kind;
+            string data;
+            boost::condition_variable condition;
+        };
+
+        typedef map<unsigned int, Pending *> MapPendingType;
+
+        int handle_;
+        bool binary_;
+        boost::mutex mutexWrite_;
+        boost::mutex mutex_;
+        MapPendingType pending_;
+        unsigned int id_;
+        bool broken_;
+        boost::thread reader_;
+
+        void
+        ReadTask()
+        {
+            while ( true ) {
+                unsigned int id;
+                unsigned char kind;
+                string data;
+                if ( ! RpcChannel::ReadFrame(handle_,id,kind,data) ) {
+                    break;
+                }
+                boost::lock_guard<boost::mutex> lock(mutex_);
+                MapPendingType::iterator i = pending_.find(id);
+                if ( i == pending_.end() ) {
+                    continue;
+                }
+                i->second->done = true;
+                i->second->kind = kind;
+                i->second->data.swap(data);
+                i->second->condition.notify_one();
+                pending_.erase(i);
+            }
+            Break();
+        }
+
+        //  the calls waiting on the socket fail, the reader stops
+        void
+        Break()
+        {
+            boost::lock_guard<boost::mutex> lock(mutex_);
+            if ( ! broken_ ) {
+                broken_ = true;
+                shutdown(handle_,SHUT_RDWR);
+            }
+            for ( MapPendingType::iterator i = pending_.begin();
+                    i != pending_.end();
+                    ++ i ) {
+                i->second->done = true;
+                i->second->condition.notify_one();
+            }
+            pending_.clear();
+        }
+    };
+
+
+    RpcChannel::RpcChannel(const string & service, int connections, bool binary)
+    : service_(service),
+      connections_(connections),
+      binary_(binary),
+      next_(0),
+      legacy_(0)
+    {
+        if ( connections_ < 0 ) {
+            connections_ = 0;
+        }
+        pool_.resize(connections_);
+        signal(SIGPIPE,SIG_IGN);
+    }
+
+
+    RpcChannel::~RpcChannel()
+    {
+    }
+
+
+    bool
+    RpcChannel::Call(
+            const string & method,
+            const xmlrpc_c::paramList & params,
+            xmlrpc_c::value & result)
+    {
+        boost::shared_ptr<RpcConnection> connection = GetConnection();
+        if ( NULL == connection.get() ) {
+            return CallOnce(method,params,result);
+        }
+
+        try {
+            string request;
+            unsigned char kind = KindCallBinary;
+            if ( ! connection->IsBinary()
+                    || ! RpcCodec::EncodeCall(method,params,request) ) {
+                kind = KindCallXml;
+                xmlrpc_c::xml::generateCall(method,params,&request);
+            }
+
+            string response;
+            if ( ! connection->Call(kind,request,kind,response) ) {
+                LogError(service_ << " breaks off " << method);
+                return false;
+            }
+
+            xmlrpc_c::rpcOutcome outcome;
+            if ( kind == KindResponseBinary ) {
+                if ( ! RpcCodec::DecodeResponse(response,outcome) ) {
+                    LogError(service_ << " returns a malformed " << method);
+                    return false;
+                }
+            } else {
+                xmlrpc_c::xml::parseResponse(response,&outcome);
+            }
+            if ( ! outcome.succeeded() ) {
+                xmlrpc_c::fault fault = outcome.getFault();
+                LogError(fault.getCode() << ":" << fault.getDescription());
+                return false;
+            }
+            result = outcome.getResult();
+            return true;
+        } catch ( std::exception const & e ) {
+            LogError(e.what());
+        }
+        return false;
+    }
+
+
+    boost::shared_ptr<RpcConnection>
+    RpcChannel::GetConnection()
+    {
+        boost::shared_ptr<RpcConnection> connection;
+        size_t slot = 0;
+        {
+            boost::lock_guard<boost::mutex> lock(mutex_);
+            if ( connections_ == 0 || time(NULL) < legacy_ ) {
+                return connection;
+            }
+            slot = next_++ % pool_.size();
+            connection = pool_[slot];
+            if ( NULL != connection.get() && ! connection->IsBroken() ) {
+                return connection;
+            }
+            connection.reset();
+        }
+
+        //  the connect and hello go without the lock, the calls on the
+        //  other sockets of the pool are not held up by a slow server
+        int handle = Factory::SocketClientHandle(service_);
+        if ( handle < 0 ) {
+            return connection;
+        }
+        unsigned char flags = 0;
+        if ( ! WriteHello(handle,binary_ ? FlagBinary : 0)
+                || ! ReadHello(handle,flags,HelloTimeout) ) {
+            LogInfo(service_ << " has no channel, a socket per call for "
+                    << LegacyInterval << " seconds");
+            close(handle);
+            boost::lock_guard<boost::mutex> lock(mutex_);
+            legacy_ = time(NULL) + LegacyInterval;
+            return connection;
+        }
+
+        //  a caller connecting the same slot meanwhile keeps its socket,
+        //  ours goes when the last reference is dropped
+        boost::shared_ptr<RpcConnection> fresh( new RpcConnection(
+                handle, binary_ && ( flags & FlagBinary ) ) );
+        boost::lock_guard<boost::mutex> lock(mutex_);
+        connection = pool_[slot];
+        if ( NULL == connection.get() || connection->IsBroken() ) {
+            pool_[slot] = fresh;
+            connection = fresh;
+        }
+        return connection;
+    }
+
+
+    bool
+    RpcChannel::CallOnce(
+            const string & method,
+            const xmlrpc_c::paramList & params,
+            xmlrpc_c::value & result)
+    {
+        int handle = Factory::SocketClientHandle(service_);
+        if ( handle < 0 ) {
+            LogError("GetHandle");
+            return false;
+        }
+
+        xmlrpc_c::clientXmlTransport_pstream transport(
+                xmlrpc_c::clientXmlTransport_pstream::constrOpt()
+                .fd(handle));
+        xmlrpc_c::client_xml client(&transport);
+        xmlrpc_c::rpc rpc(method,params);
+        xmlrpc_c::carriageParm_pstream carriage;
+
+        bool ret = false;
+        try {
+            rpc.call(&client,&carriage);
+            if ( ! rpc.isSuccessful() ) {
+                xmlrpc_c::fault fault = rpc.getFault();
+                LogError(fault.getCode() << ":" << fault.getDescription());
+            } else {
+                result = rpc.getResult();
+                ret = true;
+            }
+        } catch ( std::exception const & e ) {
+            LogError(e.what());
+        }
+
+        close(handle);
+
+        return ret;
+    }
+
+
+    bool
+    RpcChannel::ReadHello(int handle, unsigned char & flags, int timeout)
+    {
+        char hello[sizeof(Magic) + 1];
+        size_t size = 0;
+        while ( size < sizeof(hello) ) {
+            struct pollfd item;
+            item.fd = handle;
+            item.events = POLLIN;
+            item.revents = 0;
+            int ret = poll(&item,1,timeout);
+            if ( ret < 0 && errno == EINTR ) {
+                continue;
+            }
+            if ( ret <= 0 ) {
+                return false;
+            }
+            ssize_t done = recv(handle,hello+size,sizeof(hello)-size,0);
+            if ( done <= 0 ) {
+                return false;
+            }
+            size += done;
+        }
+        if ( 0 != memcmp(hello,Magic,sizeof(Magic)) ) {
+            return false;
+        }
+        flags = hello[sizeof(Magic)];
+        return true;
+    }
+
+
+    bool
+    RpcChannel::WriteHello(int handle, unsigned char flags)
+    {
+        char hello[sizeof(Magic) + 1];
+        memcpy(hello,Magic,sizeof(Magic));
+        hello[sizeof(Magic)] = flags;
+        return WriteAll(handle,hello,sizeof(hello));
+    }
+
+
+    bool
+    RpcChannel::ReadFrame(
+            int handle,
+            unsigned int & id,
+            unsigned char & kind,
+            string & data)
+    {
+        char header[9];
+        if ( ! ReadAll(handle,header,sizeof(header)) ) {
+            return false;
+        }
+        uint32_t size;
+        uint32_t number;
+        memcpy(&size,header,4);
+        memcpy(&number,header+4,4);
+        size = ntohl(size);
+        id = ntohl(number);
+        kind = header[8];
+        if ( size > MaxFrameSize ) {
+            LogError("Frame of " << size << " bytes");
+            return false;
+        }
+        data.resize(size);
+        return size == 0 || ReadAll(handle,&data[0],size);
+    }
+
+
+    bool
+    RpcChannel::WriteFrame(
+            int handle,
+            unsigned int id,
+            unsigned char kind,
+            const string & data)
+    {
+        string frame;
+        frame.reserve(9 + data.size());
+        uint32_t size = htonl(data.size());
+        uint32_t number = htonl(id);
+        frame.append(reinterpret_cast<const char *>(&size),4);
+        frame.append(reinterpret_cast<const char *>(&number),4);
+        frame.push_back(kind);
+        frame.append(data);
+        return WriteAll(handle,frame.data(),frame.size());
+    }
+
+}
@@ -0,0 +1,109 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * RpcChannel.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+
+#pragma once
+
+
+namespace bdt
+{
+    class RpcConnection;
+
+
+    //  The xmlrpc calls of a service over a few unix sockets kept open.
+    //  Every call on a socket has an id and is written without waiting for
+    //  the calls before it; a reader thread per socket hands the responses
+    //  back by id, in whatever order the server finishes them. The calls go
+    //  as XML or, when both ends agree on it at connect, in the compact
+    //  form of RpcCodec. A server that does not answer the hello is an
+    //  older one, it gets every call on a socket of its own for a while.
+    class RpcChannel
+    {
+    public:
+        //  connections 0 opens a socket per call
+        RpcChannel(const string & service, int connections, bool binary);
+
+        ~RpcChannel();
+
+        //  false when the service is not reached, breaks off, or faults
+        bool
+        Call(
+                const string & method,
+                const xmlrpc_c::paramList & params,
+                xmlrpc_c::value & result);
+
+        //  the socket of every call is prefixed with the hello, then
+        //  carries frames of length, id and kind in network order
+        static const char Magic[8];
+
+        static const unsigned char FlagBinary = 0x01;
+
+        enum Kind
+        {
+            KindCallXml = 1,
+            KindCallBinary = 2,
+            KindResponseXml = 3,
+            KindResponseBinary = 4,
+            //  the server has no response to give
+            KindResponseNone = 5,
+        };
+
+        static bool
+        ReadHello(int handle, unsigned char & flags, int timeout);
+
+        static bool
+        WriteHello(int handle, unsigned char flags);
+
+        static bool
+        ReadFrame(
+                int handle,
+                unsigned int & id,
+                unsigned char & kind,
+                string & data);
+
+        static bool
+        WriteFrame(
+                int handle,
+                unsigned int id,
+                unsigned char kind,
+                const string & data);
+
+    private:
+        string service_;
+        int connections_;
+        bool binary_;
+
+        boost::mutex mutex_;
+        vector<boost::shared_ptr<RpcConnection> > pool_;
+        size_t next_;
+        //  the server is taken for an older one until then
+        time_t legacy_;
+
+        boost::shared_ptr<RpcConnection>
+        GetConnection();
+
+        bool
+        CallOnce(
+                const string & method,
+                const xmlrpc_c::paramList & params,
+                xmlrpc_c::value & result);
+    };
+
+}
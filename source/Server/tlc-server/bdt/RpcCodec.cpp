@@ -0,0 +1,351 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * RpcCodec.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+
+
+
+#include "stdafx.h"
+#include "RpcCodec.h"
+
+
+namespace bdt
+{
+
+    static const char TypeInt = 'i';
+    static const char TypeI8 = 'l';
+    static const char TypeBoolean = 'b';
+    static const char TypeDouble = 'd';
+    static const char TypeString = 's';
+    static const char TypeNil = 'n';
+    static const char TypeArray = 'a';
+    static const char TypeStruct = 't';
+
+    static const char ResultSuccess = 0;
+    static const char ResultFault = 1;
+
+    //  nesting of arrays and structs
+    static const int MaxDepth = 64;
+
+
+    bool
+    RpcCodec::EncodeCall(
+            const string & method,
+            const xmlrpc_c::paramList & params,
+            string & data)
+    {
+        data.clear();
+        EncodeString(method,data);
+        EncodeNumber(params.size(),4,data);
+        for ( unsigned int i = 0; i < params.size(); ++ i ) {
+            if ( ! EncodeValue(params[i],data) ) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+
+    bool
+    RpcCodec::DecodeCall(
+            const string & data,
+            string & method,
+            xmlrpc_c::paramList & params)
+    {
+        size_t offset = 0;
+        unsigned long long count;
+        if ( ! DecodeString(data,offset,method)
+                || ! DecodeNumber(data,offset,4,count) ) {
+            return false;
+        }
+        params = xmlrpc_c::paramList();
+        for ( unsigned long long i = 0; i < count; ++ i ) {
+            xmlrpc_c::value value;
+            if ( ! DecodeValue(data,offset,0,value) ) {
+                return false;
+            }
+            params.add(value);
+        }
+        return offset == data.size();
+    }
+
+
+    bool
+    RpcCodec::EncodeResponse(
+            const xmlrpc_c::rpcOutcome & outcome,
+            string & data)
+    {
+        data.clear();
+        if ( outcome.succeeded() ) {
+            data.push_back(ResultSuccess);
+            return EncodeValue(outcome.getResult(),data);
+        }
+        xmlrpc_c::fault fault = outcome.getFault();
+        data.push_back(ResultFault);
+        EncodeNumber(static_cast<unsigned int>(fault.getCode()),4,data);
+        EncodeString(fault.getDescription(),data);
+        return true;
+    }
+
+
+    bool
+    RpcCodec::DecodeResponse(
+            const string & data,
+            xmlrpc_c::rpcOutcome & outcome)
+    {
+        if ( data.empty() ) {
+            return false;
+        }
+        size_t offset = 1;
+        if ( data[0] == ResultSuccess ) {
+            xmlrpc_c::value value;
+            if ( ! DecodeValue(data,offset,0,value) ) {
+                return false;
+            }
+            outcome = xmlrpc_c::rpcOutcome(value);
+        } else if ( data[0] == ResultFault ) {
+            unsigned long long code;
+            string description;
+            if ( ! DecodeNumber(data,offset,4,code)
+                    || ! DecodeString(data,offset,description) ) {
+                return false;
+            }
+            outcome = xmlrpc_c::rpcOutcome( xmlrpc_c::fault( description,
+                    static_cast<xmlrpc_c::fault::code_t>(
+                    static_cast<int>(code) ) ) );
+        } else {
+            return false;
+        }
+        return offset == data.size();
+    }
+
+
+    void
+    RpcCodec::EncodeNumber(unsigned long long number, int size, string & data)
+    {
+        for ( int i = size - 1; i >= 0; -- i ) {
+            data.push_back( static_cast<char>( (number >> (i * 8)) & 0xff ) );
+        }
+    }
+
+
+    bool
+    RpcCodec::DecodeNumber(
+            const string & data,
+            size_t & offset,
+            int size,
+            unsigned long long & number)
+    {
+        if ( data.size() - offset < static_cast<size_t>(size) ) {
+            return false;
+        }
+        number = 0;
+        for ( int i = 0; i < size; ++ i ) {
+            number = (number << 8)
+                    | static_cast<unsigned char>(data[offset++]);
+        }
+        return true;
+    }
+
+
+    void
+    RpcCodec::EncodeString(const string & value, string & data)
+    {
+        EncodeNumber(value.size(),4,data);
+        data.append(value);
+    }
+
+
+    bool
+    RpcCodec::DecodeString(const string & data, size_t & offset, string & value)
+    {
+        unsigned long long size;
+        if ( ! DecodeNumber(data,offset,4,size) ) {
+            return false;
+        }
+        if ( data.size() - offset < size ) {
+            return false;
+        }
+        value.assign(data,offset,size);
+        offset += size;
+        return true;
+    }
+
+
+    bool
+    RpcCodec::EncodeValue(const xmlrpc_c::value & value, string & data)
+    {
+        switch ( value.type() ) {
+        case xmlrpc_c::value::TYPE_INT:
+            data.push_back(TypeInt);
+            EncodeNumber( static_cast<unsigned int>(
+                    static_cast<int>(xmlrpc_c::value_int(value)) ), 4, data );
+            return true;
+        case xmlrpc_c::value::TYPE_I8:
+            data.push_back(TypeI8);
+            EncodeNumber( static_cast<unsigned long long>(
+                    static_cast<long long>(xmlrpc_c::value_i8(value)) ), 8, data );
+            return true;
+        case xmlrpc_c::value::TYPE_BOOLEAN:
+            data.push_back(TypeBoolean);
+            data.push_back( static_cast<bool>(
+                    xmlrpc_c::value_boolean(value) ) ? 1 : 0 );
+            return true;
+        case xmlrpc_c::value::TYPE_DOUBLE:
+            {
+                double number = xmlrpc_c::value_double(value);
+                unsigned long long bits;
+                memcpy(&bits,&number,sizeof(bits));
+                data.push_back(TypeDouble);
+                EncodeNumber(bits,8,data);
+            }
+            return true;
+        case xmlrpc_c::value::TYPE_STRING:
+            data.push_back(TypeString);
+            EncodeString(xmlrpc_c::value_string(value),data);
+            return true;
+        case xmlrpc_c::value::TYPE_NIL:
+            data.push_back(TypeNil);
+            return true;
+        case xmlrpc_c::value::TYPE_ARRAY:
+            {
+                vector<xmlrpc_c::value> items =
+                        xmlrpc_c::value_array(value).vectorValueValue();
+                data.push_back(TypeArray);
+                EncodeNumber(items.size(),4,data);
+                BOOST_FOREACH( const xmlrpc_c::value & item, items ) {
+                    if ( ! EncodeValue(item,data) ) {
+                        return false;
+                    }
+                }
+            }
+            return true;
+        case xmlrpc_c::value::TYPE_STRUCT:
+            {
+                map<string,xmlrpc_c::value> items =
+                        xmlrpc_c::value_struct(value);
+                data.push_back(TypeStruct);
+                EncodeNumber(items.size(),4,data);
+                for ( map<string,xmlrpc_c::value>::iterator i = items.begin();
+                        i != items.end();
+                        ++ i ) {
+                    EncodeString(i->first,data);
+                    if ( ! EncodeValue(i->second,data) ) {
+                        return false;
+                    }
+                }
+            }
+            return true;
+        default:
+            return false;
+        }
+    }
+
+
+    bool
+    RpcCodec::DecodeValue(
+            const string & data,
+            size_t & offset,
+            int depth,
+            xmlrpc_c::value & value)
+    {
+        if ( offset >= data.size() || depth > MaxDepth ) {
+            return false;
+        }
+        unsigned long long number;
+        string text;
+        switch ( data[offset++] ) {
+        case TypeInt:
+            if ( ! DecodeNumber(data,offset,4,number) ) {
+                return false;
+            }
+            value = xmlrpc_c::value_int( static_cast<int>(
+                    static_cast<unsigned int>(number) ) );
+            return true;
+        case TypeI8:
+            if ( ! DecodeNumber(data,offset,8,number) ) {
+                return false;
+            }
+            value = xmlrpc_c::value_i8( static_cast<long long>(number) );
+            return true;
+        case TypeBoolean:
+            if ( ! DecodeNumber(data,offset,1,number) ) {
+                return false;
+            }
+            value = xmlrpc_c::value_boolean( number != 0 );
+            return true;
+        case TypeDouble:
+            {
+                if ( ! DecodeNumber(data,offset,8,number) ) {
+                    return false;
+                }
+                double real;
+                memcpy(&real,&number,sizeof(real));
+                value = xmlrpc_c::value_double(real);
+            }
+            return true;
+        case TypeString:
+            if ( ! DecodeString(data,offset,text) ) {
+                return false;
+            }
+            value = xmlrpc_c::value_string(text);
+            return true;
+        case TypeNil:
+            value = xmlrpc_c::value_nil();
+            return true;
+        case TypeArray:
+            {
+                if ( ! DecodeNumber(data,offset,4,number) ) {
+                    return false;
+                }
+                vector<xmlrpc_c::value> items;
+                for ( unsigned long long i = 0; i < number; ++ i ) {
+                    xmlrpc_c::value item;
+                    if ( ! DecodeValue(data,offset,depth+1,item) ) {
+                        return false;
+                    }
+                    items.push_back(item);
+                }
+                value = xmlrpc_c::value_array(items);
+            }
+            return true;
+        case TypeStruct:
+            {
+                if ( ! DecodeNumber(data,offset,4,number) ) {
+                    return false;
+                }
+                map<string,xmlrpc_c::value> items;
+                for ( unsigned long long i = 0; i < number; ++ i ) {
+                    xmlrpc_c::value item;
+                    if ( ! DecodeString(data,offset,text)
+                            || ! DecodeValue(data,offset,depth+1,item) ) {
+                        return false;
+                    }
+                    items.insert( map<string,xmlrpc_c::value>::value_type(
+                            text, item ) );
+                }
+                value = xmlrpc_c::value_struct(items);
+            }
+            return true;
+        default:
+            return false;
+        }
+    }
+
+}
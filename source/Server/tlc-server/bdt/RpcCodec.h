@@ -0,0 +1,81 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * RpcCodec.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+
+#pragma once
+
+
+namespace bdt
+{
+
+    //  The compact form of the xmlrpc calls on an RpcChannel: a type byte
+    //  per value, integers in network order, strings and arrays behind
+    //  their length. Date times, byte strings and pointers have no compact
+    //  form, the calls carrying them go as XML.
+    class RpcCodec
+    {
+    public:
+        static bool
+        EncodeCall(
+                const string & method,
+                const xmlrpc_c::paramList & params,
+                string & data);
+
+        static bool
+        DecodeCall(
+                const string & data,
+                string & method,
+                xmlrpc_c::paramList & params);
+
+        static bool
+        EncodeResponse(const xmlrpc_c::rpcOutcome & outcome, string & data);
+
+        static bool
+        DecodeResponse(const string & data, xmlrpc_c::rpcOutcome & outcome);
+
+    private:
+        static void
+        EncodeNumber(unsigned long long number, int size, string & data);
+
+        static bool
+        DecodeNumber(
+                const string & data,
+                size_t & offset,
+                int size,
+                unsigned long long & number);
+
+        static void
+        EncodeString(const string & value, string & data);
+
+        static bool
+        DecodeString(const string & data, size_t & offset, string & value);
+
+        static bool
+        EncodeValue(const xmlrpc_c::value & value, string & data);
+
+        static bool
+        DecodeValue(
+                const string & data,
+                size_t & offset,
+                int depth,
+                xmlrpc_c::value & value);
+    };
+
+}
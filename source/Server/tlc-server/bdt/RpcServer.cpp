@@ -0,0 +1,227 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * RpcServer.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+
+
+
+#include "stdafx.h"
+#include "RpcServer.h"
+#include "RpcChannel.h"
+#include "RpcCodec.h"
+
+#include <poll.h>
+#include <xmlrpc-c/xml.hpp>
+
+
+namespace bdt
+{
+
+    //  milliseconds between the checks for interruption of a channel
+    static const int ChannelPoll = 1000;
+
+
+    //  The socket of a channel, closed after the last call on it
+    struct RpcServer::Channel
+    {
+        Channel(int handle)
+        : handle(handle)
+        {
+        }
+
+        ~Channel()
+        {
+            close(handle);
+        }
+
+        int handle;
+        boost::mutex mutex;
+    };
+
+
+    RpcServer::RpcServer(const string & service)
+    : SocketServer(service),
+      prepared_(false)
+    {
+    }
+
+
+    RpcServer::~RpcServer()
+    {
+        StopThreads();
+    }
+
+
+    void
+    RpcServer::AddMethod(const string & name, const xmlrpc_c::methodPtr & method)
+    {
+        registry_.addMethod(name,method);
+        methods_[name] = method;
+    }
+
+
+    void
+    RpcServer::ServiceThread(int handle)
+    {
+        LogDebug(handle);
+
+        {
+            boost::lock_guard<boost::mutex> lock(mutexMethod_);
+            if ( ! prepared_ ) {
+                AddMethods();
+                prepared_ = true;
+            }
+        }
+
+        char first = 0;
+        if ( 1 == recv(handle,&first,1,MSG_PEEK)
+                && first == RpcChannel::Magic[0] ) {
+            ChannelThread(handle);
+            return;
+        }
+
+        try {
+            xmlrpc_c::serverPstreamConn server(
+                    xmlrpc_c::serverPstreamConn::constrOpt()
+                    .socketFd(handle)
+                    .registryP(&registry_));
+
+            bool disconnect;
+            server.runOnce(&disconnect);
+            if ( disconnect ) {
+                LogError("Disconnect");
+            }
+        } catch ( std::exception const & e ) {
+            cerr << e.what() << endl;
+        }
+
+        close(handle);
+    }
+
+
+    void
+    RpcServer::ChannelThread(int handle)
+    {
+        boost::shared_ptr<Channel> channel(new Channel(handle));
+
+        unsigned char flags;
+        if ( ! RpcChannel::ReadHello(handle,flags,ChannelPoll)
+                || ! RpcChannel::WriteHello(handle,
+                        flags & RpcChannel::FlagBinary) ) {
+            LogWarn(handle << " fails in hello");
+            return;
+        }
+
+        while ( true ) {
+            struct pollfd item;
+            item.fd = handle;
+            item.events = POLLIN;
+            item.revents = 0;
+            int ret = poll(&item,1,ChannelPoll);
+            boost::this_thread::interruption_point();
+            if ( ret == 0 || ( ret < 0 && errno == EINTR ) ) {
+                continue;
+            }
+            unsigned int id;
+            unsigned char kind;
+            string request;
+            if ( ret < 0 || ! RpcChannel::ReadFrame(handle,id,kind,request) ) {
+                break;
+            }
+            StartThread( boost::bind( &RpcServer::CallThread, this,
+                    channel, id, kind, request ) );
+        }
+    }
+
+
+    void
+    RpcServer::CallThread(
+            boost::shared_ptr<Channel> channel,
+            unsigned int id,
+            unsigned char kind,
+            const string & request)
+    {
+        string response;
+        unsigned char kindResponse = RpcChannel::KindResponseNone;
+        try {
+            if ( kind == RpcChannel::KindCallBinary ) {
+                string method;
+                xmlrpc_c::paramList params;
+                xmlrpc_c::rpcOutcome outcome;
+                if ( RpcCodec::DecodeCall(request,method,params) ) {
+                    outcome = Execute(method,params);
+                } else {
+                    outcome = xmlrpc_c::rpcOutcome( xmlrpc_c::fault(
+                            "Malformed call", xmlrpc_c::fault::CODE_PARSE ) );
+                }
+                //  a result with no compact form goes back as XML, the
+                //  caller reads the response by its kind
+                if ( RpcCodec::EncodeResponse(outcome,response) ) {
+                    kindResponse = RpcChannel::KindResponseBinary;
+                } else {
+                    response.clear();
+                    xmlrpc_c::xml::generateResponse(outcome,&response);
+                    kindResponse = RpcChannel::KindResponseXml;
+                }
+            } else if ( kind == RpcChannel::KindCallXml ) {
+                registry_.processCall(request,&response);
+                kindResponse = RpcChannel::KindResponseXml;
+            } else {
+                LogError(id << " has kind " << static_cast<int>(kind));
+            }
+        } catch ( const boost::thread_interrupted & ) {
+            LogWarn(id << " is interrupted");
+            response.clear();
+            kindResponse = RpcChannel::KindResponseNone;
+        } catch ( std::exception const & e ) {
+            LogError(e.what());
+            response.clear();
+            kindResponse = RpcChannel::KindResponseNone;
+        }
+
+        boost::lock_guard<boost::mutex> lock(channel->mutex);
+        if ( ! RpcChannel::WriteFrame(channel->handle,id,kindResponse,response) ) {
+            //  the reader of the channel sees the end
+            shutdown(channel->handle,SHUT_RDWR);
+        }
+    }
+
+
+    xmlrpc_c::rpcOutcome
+    RpcServer::Execute(const string & method, const xmlrpc_c::paramList & params)
+    {
+        map<string,xmlrpc_c::methodPtr>::iterator i = methods_.find(method);
+        if ( i == methods_.end() ) {
+            return xmlrpc_c::rpcOutcome( xmlrpc_c::fault(
+                    "Method " + method + " is unknown",
+                    xmlrpc_c::fault::CODE_NO_SUCH_METHOD ) );
+        }
+        try {
+            xmlrpc_c::value result;
+            i->second->execute(params,&result);
+            return xmlrpc_c::rpcOutcome(result);
+        } catch ( const xmlrpc_c::fault & fault ) {
+            return xmlrpc_c::rpcOutcome(fault);
+        } catch ( std::exception const & e ) {
+            return xmlrpc_c::rpcOutcome( xmlrpc_c::fault(
+                    e.what(), xmlrpc_c::fault::CODE_INTERNAL ) );
+        }
+    }
+
+}
@@ -0,0 +1,76 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * RpcServer.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+
+#pragma once
+
+
+#include "SocketServer.h"
+
+
+namespace bdt
+{
+
+    //  Serves xmlrpc methods both to the one-call sockets of older clients
+    //  and to the channels of RpcChannel. A channel call runs in a thread
+    //  of its own, like a call on its own socket, so it can be interrupted
+    //  the same way.
+    class RpcServer : public SocketServer
+    {
+    public:
+        RpcServer(const string & service);
+
+        virtual
+        ~RpcServer();
+
+    protected:
+        void
+        AddMethod(const string & name, const xmlrpc_c::methodPtr & method);
+
+        //  called once, before the first call is served
+        virtual void
+        AddMethods() = 0;
+
+    private:
+        struct Channel;
+
+        boost::mutex mutexMethod_;
+        bool prepared_;
+        xmlrpc_c::registry registry_;
+        map<string,xmlrpc_c::methodPtr> methods_;
+
+        void
+        ServiceThread(int handle);
+
+        void
+        ChannelThread(int handle);
+
+        void
+        CallThread(
+                boost::shared_ptr<Channel> channel,
+                unsigned int id,
+                unsigned char kind,
+                const string & request);
+
+        xmlrpc_c::rpcOutcome
+        Execute(const string & method, const xmlrpc_c::paramList & params);
+    };
+
+}
@@ -28,6 +28,11 @@ namespace bdt
 
     ScheduleProxy::ScheduleProxy()
 //    : server_(new ScheduleProxyServer())
+    : channel_(ScheduleProxyServer::Service,
+            Factory::GetConfigure()->GetValueSize(
+                    Configure::RpcChannelConnections),
+            Factory::GetConfigure()->GetValueBool(
+                    Configure::RpcChannelBinary))
     {
         signal(SIGPIPE,SIG_IGN);
     }
@@ -45,17 +50,6 @@ namespace bdt
             bool share, int timeout, int priority,
             bool * ret )
     {
-        int handle = Factory::SocketClientHandle(ScheduleProxyServer::Service);
-        if ( handle < 0 ) {
-            LogError("GetHandle");
-            * ret = false;
-            return;
-        }
-
-        xmlrpc_c::clientXmlTransport_pstream transport(
-                xmlrpc_c::clientXmlTransport_pstream::constrOpt()
-                .fd(handle));
-        xmlrpc_c::client_xml client(&transport);
         string const method(ScheduleProxyServer::Request);
         xmlrpc_c::paramList params;
         params.add(xmlrpc_c::value_int(getpid()));
@@ -71,24 +65,17 @@ namespace bdt
         params.add(xmlrpc_c::value_boolean(share));
         params.add(xmlrpc_c::value_int(timeout));
         params.add(xmlrpc_c::value_int(priority));
-        xmlrpc_c::rpcPtr rpc(method,params);
-        xmlrpc_c::carriageParm_pstream carriage;
+        xmlrpc_c::value result;
 
         * ret = false;
         try {
-            rpc->call(&client,&carriage);
-            if ( ! rpc->isSuccessful() ) {
-                xmlrpc_c::fault fault = rpc->getFault();
-                LogError(fault.getCode() << ":" << fault.getDescription());
-            } else {
-                * ret = xmlrpc_c::value_boolean(rpc->getResult());
+            if ( channel_.Call(method,params,result) ) {
+                * ret = xmlrpc_c::value_boolean(result);
             }
         } catch ( std::exception const & e ) {
             LogError(e.what());
         }
 
-        close(handle);
-
         return;
     }
 
@@ -115,30 +102,16 @@ namespace bdt
             request->join();
         } catch ( const boost::thread_interrupted & e ) {
             LogWarn("Interrupt " << seed);
-            int handle = Factory::SocketClientHandle(
-                    ScheduleProxyServer::Service );
-            if ( handle >= 0 ) {
-                xmlrpc_c::clientXmlTransport_pstream transport(
-                        xmlrpc_c::clientXmlTransport_pstream::constrOpt()
-                        .fd(handle));
-                xmlrpc_c::client_xml client(&transport);
-                string const method(ScheduleProxyServer::Interrupt);
-                xmlrpc_c::paramList params;
-                params.add(xmlrpc_c::value_string(seed));
-                xmlrpc_c::rpcPtr rpc(method,params);
-                xmlrpc_c::carriageParm_pstream carriage;
-                rpc->call(&client,&carriage);
-                if ( ! rpc->isSuccessful() ) {
-                    xmlrpc_c::fault fault = rpc->getFault();
-                    LogError(fault.getCode() << ":" << fault.getDescription());
+            string const method(ScheduleProxyServer::Interrupt);
+            xmlrpc_c::paramList params;
+            params.add(xmlrpc_c::value_string(seed));
+            xmlrpc_c::value result;
+            if ( channel_.Call(method,params,result) ) {
+                if ( xmlrpc_c::value_boolean(result) ) {
+                    LogWarn("Success to interrupt " << seed);
                 } else {
-                    if ( xmlrpc_c::value_boolean(rpc->getResult()) ) {
-                        LogWarn("Success to interrupt " << seed);
-                    } else {
-                        LogWarn("Failure to interrupt " << seed);
-                    }
+                    LogWarn("Failure to interrupt " << seed);
                 }
-                close(handle);
             } else {
                 LogError("Cannot interrupt " << seed);
             }
@@ -161,16 +134,6 @@ namespace bdt
     {
         LogDebug(boost::join(tapes,",") << " " << share);
 
-        int handle = Factory::SocketClientHandle(ScheduleProxyServer::Service);
-        if ( handle < 0 ) {
-            LogError("GetHandle");
-            return;
-        }
-
-        xmlrpc_c::clientXmlTransport_pstream transport(
-                xmlrpc_c::clientXmlTransport_pstream::constrOpt()
-                .fd(handle));
-        xmlrpc_c::client_xml client(&transport);
         string const method(ScheduleProxyServer::Release);
         xmlrpc_c::paramList params;
         params.add(xmlrpc_c::value_int(getpid()));
@@ -182,23 +145,13 @@ namespace bdt
         }
         params.add(xmlrpc_c::value_array(data));
         params.add(xmlrpc_c::value_boolean(share));
-        xmlrpc_c::rpc rpc(method,params);
-        xmlrpc_c::carriageParm_pstream carriage;
+        xmlrpc_c::value result;
 
-        bool ret = false;
         try {
-            rpc.call(&client,&carriage);
-            if ( ! rpc.isSuccessful() ) {
-                xmlrpc_c::fault fault = rpc.getFault();
-                LogError(fault.getCode() << ":" << fault.getDescription());
-            } else {
-                ret = xmlrpc_c::value_boolean(rpc.getResult());
-            }
+            channel_.Call(method,params,result);
         } catch ( std::exception const & e ) {
             LogError(e.what());
         }
-
-        close(handle);
     }
 
 }
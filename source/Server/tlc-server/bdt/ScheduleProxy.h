@@ -23,6 +23,7 @@
 
 
 #include "ScheduleProxyServer.h"
+#include "RpcChannel.h"
 
 
 namespace bdt
@@ -46,6 +47,9 @@ namespace bdt
     private:
         auto_ptr<ScheduleProxyServer> server_;
 
+        //  kept open to the vfsserver for all the calls
+        RpcChannel channel_;
+
         void
         RequestTapesThread(
                 const string & seed,
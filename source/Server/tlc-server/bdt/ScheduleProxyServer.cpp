@@ -51,7 +51,7 @@ namespace bdt
 
 
     ScheduleProxyServer::ScheduleProxyServer()
-    : SocketServer(Service),
+    : RpcServer(Service),
 #ifdef MORE_TEST
       schedule_(new SchedulePriorityTape(new ResourceTapeSimulator())),
 #else
@@ -65,6 +65,7 @@ namespace bdt
 
     ScheduleProxyServer::~ScheduleProxyServer()
     {
+        StopThreads();
     }
 
 
@@ -376,37 +377,17 @@ namespace bdt
 
 
     void
-    ScheduleProxyServer::ServiceThread(int handle)
+    ScheduleProxyServer::AddMethods()
     {
-        LogDebug(handle);
-
-        try {
-            xmlrpc_c::registry registry;
-            xmlrpc_c::methodPtr const methodRelease(
-                    new ScheduleReleaseMethod(schedule_,&account_));
-            registry.addMethod(Release,methodRelease);
-            xmlrpc_c::methodPtr const methodRequest(
-                    new ScheduleRequestMethod(this,schedule_,&account_));
-            registry.addMethod(Request,methodRequest);
-            xmlrpc_c::methodPtr const methodInterrupt(
-                    new ScheduleInterruptMethod(this));
-            registry.addMethod(Interrupt,methodInterrupt);
-
-            xmlrpc_c::serverPstreamConn server(
-                    xmlrpc_c::serverPstreamConn::constrOpt()
-                    .socketFd(handle)
-                    .registryP(&registry));
-
-            bool disconnect;
-            server.runOnce(&disconnect);
-            if ( disconnect ) {
-                LogError("Disconnect");
-            }
-        } catch ( std::exception const & e ) {
-            cerr << e.what() << endl;
-        }
-
-        close(handle);
+        xmlrpc_c::methodPtr const methodRelease(
+                new ScheduleReleaseMethod(schedule_,&account_));
+        AddMethod(Release,methodRelease);
+        xmlrpc_c::methodPtr const methodRequest(
+                new ScheduleRequestMethod(this,schedule_,&account_));
+        AddMethod(Request,methodRequest);
+        xmlrpc_c::methodPtr const methodInterrupt(
+                new ScheduleInterruptMethod(this));
+        AddMethod(Interrupt,methodInterrupt);
     }
 
 }
@@ -22,14 +22,14 @@
 #pragma once
 
 
-#include "SocketServer.h"
+#include "RpcServer.h"
 #include "ScheduleAccount.h"
 
 
 namespace bdt
 {
 
-    class ScheduleProxyServer : public SocketServer
+    class ScheduleProxyServer : public RpcServer
     {
     public:
         ScheduleProxyServer();
@@ -56,7 +56,7 @@ namespace bdt
         ScheduleInterface * schedule_;
 
         void
-        ServiceThread(int handle);
+        AddMethods();
 
         ScheduleAccount account_;
 
@@ -23,6 +23,7 @@
 #include "ServiceServer.h"
 #include "CacheManager.h"
 #include "MetaManager.h"
+#include "EvictionIndex.h"
 #include "FileOperationTape.h"
 //#include "FileOperationMeta.h"
 //#include "FileOperationZero.h"
@@ -40,6 +41,7 @@ namespace bdt
 
     string const ServiceServer::Service("Client.");
     string const ServiceServer::ReleaseFile("Client.ReleaseFile");
+    string const ServiceServer::GetEvictionList("Client.GetEvictionList");
     string const ServiceServer::ReleaseInode("Client.ReleaseInode");
     string const ServiceServer::ReleaseTape("Client.ReleaseTape");
     string const ServiceServer::GetCacheCapacity("Client.GetCacheCapacity");
@@ -50,7 +52,7 @@ namespace bdt
     string const ServiceServer::SetCacheState("Client.SetCacheState");
 
     ServiceServer::ServiceServer()
-    : SocketServer( Service + Factory::GetService() ),
+    : RpcServer( Service + Factory::GetService() ),
       folderMeta_(Factory::GetMetaFolder() / Factory::GetService()),
       folderCache_(Factory::GetCacheFolder() / Factory::GetService())
     {
@@ -61,6 +63,7 @@ namespace bdt
 
     ServiceServer::~ServiceServer()
     {
+        StopThreads();
     }
 
 //    class ServiceImportMethod : public xmlrpc_c::method
@@ -1018,6 +1021,41 @@ namespace bdt
     };
 
 
+    class ServiceGetEvictionListMethod : public xmlrpc_c::method
+    {
+    public:
+        ServiceGetEvictionListMethod()
+        : meta_(Factory::GetMetaManager())
+        {
+            this->_signature = "A:i";
+            this->_help = "The least recently used files to release from cache";
+        }
+
+        void
+        execute(xmlrpc_c::paramList const & params,
+                xmlrpc_c::value * const ret)
+        {
+            int const count(params.getInt(0));
+
+            vector<EvictionItem> items;
+            meta_->GetEvictionList(count,items);
+            LogDebug(count << " : " << items.size());
+
+            vector<xmlrpc_c::value> data;
+            BOOST_FOREACH(const EvictionItem & item, items) {
+                map<string, xmlrpc_c::value> value;
+                value["path"] = xmlrpc_c::value_string(item.path.string());
+                value["atime"] = xmlrpc_c::value_i8(item.atime);
+                data.push_back(xmlrpc_c::value_struct(value));
+            }
+            * ret = xmlrpc_c::value_array(data);
+        }
+
+    private:
+        MetaManager * meta_;
+    };
+
+
     class ServiceGetCacheCapacityMethod : public xmlrpc_c::method
     {
 //        bool MetaManager::GetBackupList(vector<BackupItem> & list);
@@ -1079,12 +1117,14 @@ namespace bdt
     class ServiceSetThrottleMethod : public xmlrpc_c::method
     {
         //bool Throttle::Reset(int interval,long long valve);
+        //bool Throttle::ResetClient(int interval,long long valve);
 
     public:
         ServiceSetThrottleMethod()
         {
-            this->_signature = "b:ii";
-            this->_help = "Throttle::Reset";
+            this->_signature = "b:ii,b:iis";
+            this->_help = "Throttle::Reset, the optional scope \"client\" "
+                    "sets the limit of every client";
         }
 
         void
@@ -1093,12 +1133,26 @@ namespace bdt
         {
             int const interval(params.getInt(0));
             long long const valve(params.getI8(1));
+            string scope;
+            if ( params.size() > 2 ) {
+                scope = params.getString(2);
+            }
 
-            LogDebug(interval << " " << valve);
+            LogDebug(interval << " " << valve << " " << scope);
 
-            bool retVal = Factory::GetThrottle()->Reset(interval,valve);
+            bool retVal;
+            if ( scope.empty() ) {
+                retVal = Factory::GetThrottle()->Reset(interval,valve);
+            } else if ( scope == "client" ) {
+                retVal = Factory::GetThrottle()->ResetClient(interval,valve);
+            } else {
+                //  the process serves one share, its limit is the global one
+                LogError(scope << " is no scope");
+                retVal = false;
+            }
 
-            LogDebug(interval << " " << valve << " : " << retVal);
+            LogDebug(interval << " " << valve << " " << scope
+                    << " : " << retVal);
             * ret = xmlrpc_c::value_boolean(retVal);
         }
 
@@ -1434,65 +1488,48 @@ namespace bdt
 
 
     void
-    ServiceServer::ServiceThread(int handle)
+    ServiceServer::AddMethods()
     {
-        LogDebug(handle);
-
-        try {
-            xmlrpc_c::registry registry;
-
-            xmlrpc_c::methodPtr const methodReleaseFile(
-                    new ServiceReleaseFileMethod());
-            registry.addMethod(ReleaseFile,methodReleaseFile);
-
-//            xmlrpc_c::methodPtr const methodReleaseInode(
-//                    new ServiceReleaseInodeMethod(folderCache_,meta_.get()));
-//            registry.addMethod(ReleaseInode,methodReleaseInode);
-
-//            xmlrpc_c::methodPtr const methodReleaseTape(
-//                    new ServiceReleaseTapeMethod(
-//                        folderMeta_, folderCache_, meta_.get() ) );
-//            registry.addMethod(ReleaseTape,methodReleaseTape);
-
-            xmlrpc_c::methodPtr const methodGetCacheCapacity(
-                    new ServiceGetCacheCapacityMethod());
-            registry.addMethod(GetCacheCapacity, methodGetCacheCapacity );
-
-            xmlrpc_c::methodPtr const methodSetThrottle(
-                    new ServiceSetThrottleMethod());
-            registry.addMethod(SetThrottle,methodSetThrottle);
-
-//            xmlrpc_c::methodPtr const methodImport(
-//                    new ServiceImportMethod(meta_.get()) );
-//            registry.addMethod(Import,methodImport);
-
-            xmlrpc_c::methodPtr const methodSetName(
-                    new ServiceSetNameMethod() );
-            registry.addMethod(SetName,methodSetName);
-
-            xmlrpc_c::methodPtr const methodStopTape(
-                    new ServiceStopTapeMethod() );
-            registry.addMethod(StopTape,methodStopTape);
-
-            xmlrpc_c::methodPtr const methodSetCacheState(
-                    new ServiceSetCacheStateMethod() );
-            registry.addMethod(SetCacheState,methodSetCacheState);
-
-            xmlrpc_c::serverPstreamConn server(
-                    xmlrpc_c::serverPstreamConn::constrOpt()
-                    .socketFd(handle)
-                    .registryP(&registry));
-
-            bool disconnect;
-            server.runOnce(&disconnect);
-            if ( disconnect ) {
-                LogError("Disconnect");
-            }
-        } catch ( std::exception const & e ) {
-            cerr << e.what() << endl;
-        }
-
-        close(handle);
+        xmlrpc_c::methodPtr const methodReleaseFile(
+                new ServiceReleaseFileMethod());
+        AddMethod(ReleaseFile,methodReleaseFile);
+
+        xmlrpc_c::methodPtr const methodGetEvictionList(
+                new ServiceGetEvictionListMethod());
+        AddMethod(GetEvictionList,methodGetEvictionList);
+
+//        xmlrpc_c::methodPtr const methodReleaseInode(
+//                new ServiceReleaseInodeMethod(folderCache_,meta_.get()));
+//        AddMethod(ReleaseInode,methodReleaseInode);
+
+//        xmlrpc_c::methodPtr const methodReleaseTape(
+//                new ServiceReleaseTapeMethod(
+//                    folderMeta_, folderCache_, meta_.get() ) );
+//        AddMethod(ReleaseTape,methodReleaseTape);
+
+        xmlrpc_c::methodPtr const methodGetCacheCapacity(
+                new ServiceGetCacheCapacityMethod());
+        AddMethod(GetCacheCapacity, methodGetCacheCapacity );
+
+        xmlrpc_c::methodPtr const methodSetThrottle(
+                new ServiceSetThrottleMethod());
+        AddMethod(SetThrottle,methodSetThrottle);
+
+//        xmlrpc_c::methodPtr const methodImport(
+//                new ServiceImportMethod(meta_.get()) );
+//        AddMethod(Import,methodImport);
+
+        xmlrpc_c::methodPtr const methodSetName(
+                new ServiceSetNameMethod() );
+        AddMethod(SetName,methodSetName);
+
+        xmlrpc_c::methodPtr const methodStopTape(
+                new ServiceStopTapeMethod() );
+        AddMethod(StopTape,methodStopTape);
+
+        xmlrpc_c::methodPtr const methodSetCacheState(
+                new ServiceSetCacheStateMethod() );
+        AddMethod(SetCacheState,methodSetCacheState);
     }
 
 }
@@ -22,13 +22,13 @@
 #pragma once
 
 
-#include "SocketServer.h"
+#include "RpcServer.h"
 
 
 namespace bdt
 {
 
-    class ServiceServer : public SocketServer
+    class ServiceServer : public RpcServer
     {
     public:
         ServiceServer();
@@ -38,6 +38,7 @@ namespace bdt
 
         static string const Service;
         static string const ReleaseFile;
+        static string const GetEvictionList;
         static string const ReleaseInode;
         static string const ReleaseTape;
         static string const GetCacheCapacity;
@@ -53,7 +54,7 @@ namespace bdt
 //        auto_ptr<MetaManager> meta_;
 
         void
-        ServiceThread(int handle);
+        AddMethods();
 
     };
 
@@ -35,26 +35,54 @@ namespace bdt
 
 
     SocketServer::~SocketServer()
+    {
+        StopThreads();
+    }
+
+
+    void
+    SocketServer::StopThreads()
     {
         run_ = false;
-        thread_.join();
-        for ( ThreadList::iterator i = threads_.begin();
-                i != threads_.end();
-                ++ i ) {
-            i->second->interrupt();
+        if ( thread_.joinable() ) {
+            thread_.join();
         }
-        for ( ThreadList::iterator i = threads_.begin();
-                i != threads_.end();
-                ++ i ) {
-            i->second->join();
-            delete i->second;
-            i->second = NULL;
+        {
+            boost::lock_guard<boost::mutex> lock(mutexThread_);
+            for ( ThreadList::iterator i = threads_.begin();
+                    i != threads_.end();
+                    ++ i ) {
+                i->second->interrupt();
+            }
+        }
+        //  the threads take themselves off the list when they end
+        while ( true ) {
+            {
+                boost::lock_guard<boost::mutex> lock(mutexThread_);
+                if ( threads_.empty() ) {
+                    break;
+                }
+            }
+            boost::this_thread::sleep(boost::posix_time::milliseconds(10));
         }
     }
 
 
     void
-    SocketServer::ServerThread(int handle)
+    SocketServer::StartThread(const boost::function<void ()> & task)
+    {
+        boost::lock_guard<boost::mutex> lock(mutexThread_);
+        boost::thread * thread = new boost::thread(
+                &SocketServer::ServerThread, this, task);
+        if ( ! threads_.insert( ThreadList::value_type(
+                thread->get_id(), thread ) ).second ) {
+            LogError(thread->get_id());
+        }
+    }
+
+
+    void
+    SocketServer::ServerThread(boost::function<void ()> task)
     {
         boost::thread::id current = boost::this_thread::get_id();
 
@@ -67,7 +95,11 @@ namespace bdt
             boost::this_thread::yield();
         }
 
-        ServiceThread(handle);
+        try {
+            task();
+        } catch ( const boost::thread_interrupted & ) {
+            LogDebug(current << " is interrupted");
+        }
 
         boost::lock_guard<boost::mutex> lock(mutexThread_);
         ThreadList::iterator i = threads_.find(current);
@@ -109,13 +141,8 @@ namespace bdt
 
             int handle = accept(handleListen,NULL,NULL);
             if ( handle >= 0 ) {
-                boost::lock_guard<boost::mutex> lock(mutexThread_);
-                boost::thread * thread = new boost::thread(
-                        &SocketServer::ServerThread, this, handle);
-                if ( ! threads_.insert( ThreadList::value_type(
-                        thread->get_id(), thread ) ).second ) {
-                    LogError(thread->get_id());
-                }
+                StartThread( boost::bind(
+                        &SocketServer::ServiceThread, this, handle ) );
             } else {
                 LogError(service_ << " accept error");
             }
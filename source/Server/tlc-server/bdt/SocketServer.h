@@ -22,6 +22,9 @@
 #pragma once
 
 
+#include <boost/function.hpp>
+
+
 namespace bdt
 {
 
@@ -43,12 +46,22 @@ namespace bdt
         ServerTask();
 
         void
-        ServerThread(int handle);
+        ServerThread(boost::function<void ()> task);
 
         virtual void
         ServiceThread(int handle) = 0;
 
     protected:
+        //  the thread is on the list while task runs
+        void
+        StartThread(const boost::function<void ()> & task);
+
+        //  stops accepting and waits for the running threads after
+        //  interrupting them; a derived server calls it before its members
+        //  go away
+        void
+        StopThreads();
+
         typedef map<boost::thread::id,boost::thread *> ThreadList;
         ThreadList threads_;
         boost::mutex mutexThread_;
@@ -0,0 +1,127 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * TapeFolder.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+
+
+#include "stdafx.h"
+#include "TapeFolder.h"
+
+
+namespace bdt
+{
+
+    TapeFolder::TapeFolder(size_t capacity)
+    : capacity_(capacity), created_(0)
+    {
+    }
+
+
+    TapeFolder::~TapeFolder()
+    {
+    }
+
+
+    bool
+    TapeFolder::Create(const string & tape, const fs::path & folder)
+    {
+        {
+            boost::lock_guard<boost::mutex> lock(mutex_);
+            MapTapeType::iterator i = tapes_.find(tape);
+            if ( i != tapes_.end()
+                    && i->second.find(folder.string()) != i->second.end() ) {
+                return true;
+            }
+        }
+
+        if ( ! MakeFolder(folder) ) {
+            int error = errno;
+            LogError(tape << " fails to create " << folder
+                    << ": " << strerror(error));
+            errno = error;
+            return false;
+        }
+
+        boost::lock_guard<boost::mutex> lock(mutex_);
+        set<string> & folders = tapes_[tape];
+        if ( folders.size() >= capacity_ ) {
+            folders.clear();
+        }
+        folders.insert(folder.string());
+        return true;
+    }
+
+
+    void
+    TapeFolder::Forget(const string & tape)
+    {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+        tapes_.erase(tape);
+    }
+
+
+    unsigned long long
+    TapeFolder::GetCreated()
+    {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+        return created_;
+    }
+
+
+    bool
+    TapeFolder::MakeFolder(const fs::path & folder)
+    {
+        if ( folder.empty() ) {
+            errno = ENOENT;
+            return false;
+        }
+
+        //  the deepest folder first, most of the time only it is missing
+        if ( 0 == ::mkdir(folder.string().c_str(), 0755) ) {
+            boost::lock_guard<boost::mutex> lock(mutex_);
+            ++ created_;
+            return true;
+        }
+        if ( ENOENT == errno ) {
+            fs::path parent = folder.parent_path();
+            if ( parent == folder || ! MakeFolder(parent) ) {
+                return false;
+            }
+            if ( 0 == ::mkdir(folder.string().c_str(), 0755) ) {
+                boost::lock_guard<boost::mutex> lock(mutex_);
+                ++ created_;
+                return true;
+            }
+        }
+        if ( EEXIST != errno ) {
+            return false;
+        }
+
+        struct stat status;
+        if ( 0 != ::stat(folder.string().c_str(), &status) ) {
+            return false;
+        }
+        if ( ! S_ISDIR(status.st_mode) ) {
+            errno = ENOTDIR;
+            return false;
+        }
+        return true;
+    }
+
+}
@@ -0,0 +1,64 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * TapeFolder.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+
+
+#pragma once
+
+
+namespace bdt
+{
+
+    //  Creates the folders of the files written to the tapes, like
+    //  mkdir -p but in process. The folders known to exist are kept per
+    //  tape, they are trusted only as long as nothing else changes the
+    //  tape, so the caller forgets a tape when it takes it over.
+    class TapeFolder
+    {
+    public:
+        TapeFolder(size_t capacity);
+
+        ~TapeFolder();
+
+        //  folder and its missing parents, another thread creating them
+        //  at the same time is fine. false with errno on failure.
+        bool
+        Create(const string & tape, const fs::path & folder);
+
+        void
+        Forget(const string & tape);
+
+        //  the folders created since the start
+        unsigned long long
+        GetCreated();
+
+    private:
+        typedef map<string, set<string> > MapTapeType;
+
+        size_t capacity_;
+        boost::mutex mutex_;
+        MapTapeType tapes_;
+        unsigned long long created_;
+
+        bool
+        MakeFolder(const fs::path & folder);
+    };
+
+}
@@ -28,7 +28,12 @@ namespace bdt
 
     TapeManagerProxy::TapeManagerProxy()
     : folder_(Factory::GetTapeFolder()),
-      service_(Factory::GetService())
+      service_(Factory::GetService()),
+      channel_(TapeManagerProxyServer::Service,
+              Factory::GetConfigure()->GetValueSize(
+                      Configure::RpcChannelConnections),
+              Factory::GetConfigure()->GetValueBool(
+                      Configure::RpcChannelBinary))
     {
         signal(SIGPIPE,SIG_IGN);
     }
@@ -44,39 +49,21 @@ namespace bdt
     {
         LogDebug(tape << " " << status);
 
-        int handle = Factory::SocketClientHandle(
-                TapeManagerProxyServer::Service );
-        if ( handle < 0 ) {
-            LogError("GetHandle");
-            return false;
-        }
-
-        xmlrpc_c::clientXmlTransport_pstream transport(
-                xmlrpc_c::clientXmlTransport_pstream::constrOpt()
-                .fd(handle));
-        xmlrpc_c::client_xml client(&transport);
         string const method(TapeManagerProxyServer::SetTapeStatus);
         xmlrpc_c::paramList params;
         params.add(xmlrpc_c::value_string(tape));
         params.add(xmlrpc_c::value_int(status));
-        xmlrpc_c::rpc rpc(method,params);
-        xmlrpc_c::carriageParm_pstream carriage;
+        xmlrpc_c::value result;
 
         bool ret = false;
         try {
-            rpc.call(&client,&carriage);
-            if ( ! rpc.isSuccessful() ) {
-                xmlrpc_c::fault fault = rpc.getFault();
-                LogError(fault.getCode() << ":" << fault.getDescription());
-            } else {
-                ret = xmlrpc_c::value_boolean(rpc.getResult());
+            if ( channel_.Call(method,params,result) ) {
+                ret = xmlrpc_c::value_boolean(result);
             }
         } catch ( std::exception const & e ) {
             LogError(e.what());
         }
 
-        close(handle);
-
         return ret;
     }
 
@@ -88,39 +75,21 @@ namespace bdt
 
         enum TapeStatus status = STATUS_UNKNOWN;
 
-        int handle = Factory::SocketClientHandle(
-                TapeManagerProxyServer::Service );
-        if ( handle < 0 ) {
-            LogError("GetHandle");
-            return status;
-        }
-
-        xmlrpc_c::clientXmlTransport_pstream transport(
-                xmlrpc_c::clientXmlTransport_pstream::constrOpt()
-                .fd(handle));
-        xmlrpc_c::client_xml client(&transport);
         string const method(TapeManagerProxyServer::GetTapeStatus);
         xmlrpc_c::paramList params;
         params.add(xmlrpc_c::value_string(tape));
-        xmlrpc_c::rpc rpc(method,params);
-        xmlrpc_c::carriageParm_pstream carriage;
+        xmlrpc_c::value result;
 
         try {
-            rpc.call(&client,&carriage);
-            if ( ! rpc.isSuccessful() ) {
-                xmlrpc_c::fault fault = rpc.getFault();
-                LogError(fault.getCode() << ":" << fault.getDescription());
-            } else {
+            if ( channel_.Call(method,params,result) ) {
                 status = static_cast<enum TapeManagerInterface::TapeStatus>(
                         static_cast<int>(
-                        xmlrpc_c::value_int(rpc.getResult()) ) );
+                        xmlrpc_c::value_int(result) ) );
             }
         } catch ( std::exception const & e ) {
             LogError(e.what());
         }
 
-        close(handle);
-
         return status;
     }
 
@@ -129,31 +98,15 @@ namespace bdt
     TapeManagerProxy::GetShareAvailableTapes(const string& uuid,
     		vector<map<string, off_t> >& tapesList)
     {
-        int handle = Factory::SocketClientHandle(
-                TapeManagerProxyServer::Service );
-        if ( handle < 0 ) {
-            LogError("GetHandle");
-            return false;
-        }
-
-        xmlrpc_c::clientXmlTransport_pstream transport(
-                xmlrpc_c::clientXmlTransport_pstream::constrOpt()
-                .fd(handle));
-        xmlrpc_c::client_xml client(&transport);
         string const method(TapeManagerProxyServer::GetTapesUse);
         xmlrpc_c::paramList params;
         params.add(xmlrpc_c::value_string(uuid));
-        xmlrpc_c::rpc rpc(method,params);
-        xmlrpc_c::carriageParm_pstream carriage;
+        xmlrpc_c::value result;
 
         bool ret = false;
         try {
-            rpc.call(&client,&carriage);
-            if ( ! rpc.isSuccessful() ) {
-                xmlrpc_c::fault fault = rpc.getFault();
-                LogError(fault.getCode() << ":" << fault.getDescription());
-            } else {
-                vector<xmlrpc_c::value> data = xmlrpc_c::value_array(rpc.getResult()).vectorValueValue();
+            if ( channel_.Call(method,params,result) ) {
+                vector<xmlrpc_c::value> data = xmlrpc_c::value_array(result).vectorValueValue();
                 for ( vector<xmlrpc_c::value>::iterator i = data.begin(); i != data.end(); ++ i ) {
                 	xmlrpc_c::cstruct cdata = xmlrpc_c::value_struct(*i).cvalue();
                 	map<string, off_t> mapItem;
@@ -168,7 +121,6 @@ namespace bdt
             LogError(e.what());
         }
 
-        close(handle);
         return ret;
     }
 
@@ -180,17 +132,6 @@ namespace bdt
     {
         LogDebug(path << " " << size);
 
-        int handle = Factory::SocketClientHandle(
-                TapeManagerProxyServer::Service );
-        if ( handle < 0 ) {
-            LogError("GetHandle");
-            return false;
-        }
-
-        xmlrpc_c::clientXmlTransport_pstream transport(
-                xmlrpc_c::clientXmlTransport_pstream::constrOpt()
-                .fd(handle));
-        xmlrpc_c::client_xml client(&transport);
         string const method(TapeManagerProxyServer::GetTapesUse);
         xmlrpc_c::paramList params;
         string pathname =
@@ -198,19 +139,14 @@ namespace bdt
                 //fs::slash<char>::value + service_ + path.string();
         params.add(xmlrpc_c::value_string(pathname));
         params.add(xmlrpc_c::value_i8(size));
-        xmlrpc_c::rpc rpc(method,params);
-        xmlrpc_c::carriageParm_pstream carriage;
+        xmlrpc_c::value result;
 
         bool ret = false;
         tapes.clear();
         try {
-            rpc.call(&client,&carriage);
-            if ( ! rpc.isSuccessful() ) {
-                xmlrpc_c::fault fault = rpc.getFault();
-                LogError(fault.getCode() << ":" << fault.getDescription());
-            } else {
+            if ( channel_.Call(method,params,result) ) {
                 vector<xmlrpc_c::value> data = xmlrpc_c::value_array(
-                        rpc.getResult() ).vectorValueValue();
+                        result ).vectorValueValue();
                 for ( vector<xmlrpc_c::value>::iterator i = data.begin();
                         i != data.end();
                         ++ i ) {
@@ -222,8 +158,6 @@ namespace bdt
             LogError(e.what());
         }
 
-        close(handle);
-
         LogDebug(path << " " << size << " : " << boost::join(tapes,","));
 
         return ret;
@@ -240,17 +174,6 @@ namespace bdt
         LogDebug(boost::join(tapes,",")
                 << " " << fileNumber << " " << tapeSize);
 
-        int handle = Factory::SocketClientHandle(
-                TapeManagerProxyServer::Service );
-        if ( handle < 0 ) {
-            LogError("GetHandle");
-            return false;
-        }
-
-        xmlrpc_c::clientXmlTransport_pstream transport(
-                xmlrpc_c::clientXmlTransport_pstream::constrOpt()
-                .fd(handle));
-        xmlrpc_c::client_xml client(&transport);
         string const method(TapeManagerProxyServer::SetTapesUse);
         xmlrpc_c::paramList params;
         vector<xmlrpc_c::value> data;
@@ -263,24 +186,17 @@ namespace bdt
         params.add(xmlrpc_c::value_int(fileNumber));
         params.add(xmlrpc_c::value_i8(fileSize));
         params.add(xmlrpc_c::value_i8(tapeSize));
-        xmlrpc_c::rpc rpc(method,params);
-        xmlrpc_c::carriageParm_pstream carriage;
+        xmlrpc_c::value result;
 
         bool ret = false;
         try {
-            rpc.call(&client,&carriage);
-            if ( ! rpc.isSuccessful() ) {
-                xmlrpc_c::fault fault = rpc.getFault();
-                LogError(fault.getCode() << ":" << fault.getDescription());
-            } else {
-                ret = xmlrpc_c::value_boolean(rpc.getResult());
+            if ( channel_.Call(method,params,result) ) {
+                ret = xmlrpc_c::value_boolean(result);
             }
         } catch ( std::exception const & e ) {
             LogError(e.what());
         }
 
-        close(handle);
-
         return ret;
     }
 
@@ -294,32 +210,16 @@ namespace bdt
     {
         LogDebug(service);
 
-        int handle = Factory::SocketClientHandle(
-                TapeManagerProxyServer::Service );
-        if ( handle < 0 ) {
-            LogError("GetHandle");
-            return false;
-        }
-
-        xmlrpc_c::clientXmlTransport_pstream transport(
-                xmlrpc_c::clientXmlTransport_pstream::constrOpt()
-                .fd(handle));
-        xmlrpc_c::client_xml client(&transport);
         string const method(TapeManagerProxyServer::GetCapacity);
         xmlrpc_c::paramList params;
         params.add(xmlrpc_c::value_string(service));
-        xmlrpc_c::rpc rpc(method,params);
-        xmlrpc_c::carriageParm_pstream carriage;
+        xmlrpc_c::value result;
 
         bool ret = false;
         try {
-            rpc.call(&client,&carriage);
-            if ( ! rpc.isSuccessful() ) {
-                xmlrpc_c::fault fault = rpc.getFault();
-                LogError(fault.getCode() << ":" << fault.getDescription());
-            } else {
-                map<string,xmlrpc_c::value> data(
-                        xmlrpc_c::value_struct(rpc.getResult()) );
+            if ( channel_.Call(method,params,result) ) {
+                map<string,xmlrpc_c::value> data =
+                        xmlrpc_c::value_struct(result);
                 ret = xmlrpc_c::value_boolean(data["Result"]);
                 fileNumber = xmlrpc_c::value_int(data["FileNumber"]);
                 usedSize = xmlrpc_c::value_i8(data["UsedSize"]);
@@ -331,8 +231,6 @@ namespace bdt
             LogError(e.what());
         }
 
-        close(handle);
-
         return ret;
     }*/
 
@@ -349,39 +247,21 @@ namespace bdt
     {
         LogDebug(tape << " " << state);
 
-        int handle = Factory::SocketClientHandle(
-                TapeManagerProxyServer::Service );
-        if ( handle < 0 ) {
-            LogError("GetHandle");
-            return false;
-        }
-
-        xmlrpc_c::clientXmlTransport_pstream transport(
-                xmlrpc_c::clientXmlTransport_pstream::constrOpt()
-                .fd(handle));
-        xmlrpc_c::client_xml client(&transport);
         string const method(TapeManagerProxyServer::CheckTapeState);
         xmlrpc_c::paramList params;
         params.add(xmlrpc_c::value_string(tape));
         params.add(xmlrpc_c::value_int(state));
-        xmlrpc_c::rpc rpc(method,params);
-        xmlrpc_c::carriageParm_pstream carriage;
+        xmlrpc_c::value result;
 
         bool ret = false;
         try {
-            rpc.call(&client,&carriage);
-            if ( ! rpc.isSuccessful() ) {
-                xmlrpc_c::fault fault = rpc.getFault();
-                LogError(fault.getCode() << ":" << fault.getDescription());
-            } else {
-                ret = xmlrpc_c::value_boolean(rpc.getResult());
+            if ( channel_.Call(method,params,result) ) {
+                ret = xmlrpc_c::value_boolean(result);
             }
         } catch ( std::exception const & e ) {
             LogError(e.what());
         }
 
-        close(handle);
-
         return ret;
     }
 
@@ -392,39 +272,21 @@ namespace bdt
     {
         LogDebug(tape << " " << state);
 
-        int handle = Factory::SocketClientHandle(
-                TapeManagerProxyServer::Service );
-        if ( handle < 0 ) {
-            LogError("GetHandle");
-            return false;
-        }
-
-        xmlrpc_c::clientXmlTransport_pstream transport(
-                xmlrpc_c::clientXmlTransport_pstream::constrOpt()
-                .fd(handle));
-        xmlrpc_c::client_xml client(&transport);
         string const method(TapeManagerProxyServer::SetTapeStateNoLock);
         xmlrpc_c::paramList params;
         params.add(xmlrpc_c::value_string(tape));
         params.add(xmlrpc_c::value_int(state));
-        xmlrpc_c::rpc rpc(method,params);
-        xmlrpc_c::carriageParm_pstream carriage;
+        xmlrpc_c::value result;
 
         bool ret = false;
         try {
-            rpc.call(&client,&carriage);
-            if ( ! rpc.isSuccessful() ) {
-                xmlrpc_c::fault fault = rpc.getFault();
-                LogError(fault.getCode() << ":" << fault.getDescription());
-            } else {
-                ret = xmlrpc_c::value_boolean(rpc.getResult());
+            if ( channel_.Call(method,params,result) ) {
+                ret = xmlrpc_c::value_boolean(result);
             }
         } catch ( std::exception const & e ) {
             LogError(e.what());
         }
 
-        close(handle);
-
         return ret;
     }
 
@@ -434,38 +296,20 @@ namespace bdt
     {
         LogDebug(tape);
 
-        int handle = Factory::SocketClientHandle(
-                TapeManagerProxyServer::Service );
-        if ( handle < 0 ) {
-            LogError("GetHandle");
-            return false;
-        }
-
-        xmlrpc_c::clientXmlTransport_pstream transport(
-                xmlrpc_c::clientXmlTransport_pstream::constrOpt()
-                .fd(handle));
-        xmlrpc_c::client_xml client(&transport);
         string const method(TapeManagerProxyServer::LockTapeState);
         xmlrpc_c::paramList params;
         params.add(xmlrpc_c::value_string(tape));
-        xmlrpc_c::rpc rpc(method,params);
-        xmlrpc_c::carriageParm_pstream carriage;
+        xmlrpc_c::value result;
 
         bool ret = false;
         try {
-            rpc.call(&client,&carriage);
-            if ( ! rpc.isSuccessful() ) {
-                xmlrpc_c::fault fault = rpc.getFault();
-                LogError(fault.getCode() << ":" << fault.getDescription());
-            } else {
-                ret = xmlrpc_c::value_boolean(rpc.getResult());
+            if ( channel_.Call(method,params,result) ) {
+                ret = xmlrpc_c::value_boolean(result);
             }
         } catch ( std::exception const & e ) {
             LogError(e.what());
         }
 
-        close(handle);
-
         return ret;
     }
 
@@ -475,39 +319,21 @@ namespace bdt
     {
         LogDebug(tape << " " << state);
 
-        int handle = Factory::SocketClientHandle(
-                TapeManagerProxyServer::Service );
-        if ( handle < 0 ) {
-            LogError("GetHandle");
-            return false;
-        }
-
-        xmlrpc_c::clientXmlTransport_pstream transport(
-                xmlrpc_c::clientXmlTransport_pstream::constrOpt()
-                .fd(handle));
-        xmlrpc_c::client_xml client(&transport);
         string const method(TapeManagerProxyServer::SetTapeState);
         xmlrpc_c::paramList params;
         params.add(xmlrpc_c::value_string(tape));
         params.add(xmlrpc_c::value_int(state));
-        xmlrpc_c::rpc rpc(method,params);
-        xmlrpc_c::carriageParm_pstream carriage;
+        xmlrpc_c::value result;
 
         bool ret = false;
         try {
-            rpc.call(&client,&carriage);
-            if ( ! rpc.isSuccessful() ) {
-                xmlrpc_c::fault fault = rpc.getFault();
-                LogError(fault.getCode() << ":" << fault.getDescription());
-            } else {
-                ret = xmlrpc_c::value_boolean(rpc.getResult());
+            if ( channel_.Call(method,params,result) ) {
+                ret = xmlrpc_c::value_boolean(result);
             }
         } catch ( std::exception const & e ) {
             LogError(e.what());
         }
 
-        close(handle);
-
         return ret;
     }
 
@@ -517,39 +343,21 @@ namespace bdt
     {
         LogDebug(tape << " " << action);
 
-        int handle = Factory::SocketClientHandle(
-                TapeManagerProxyServer::Service );
-        if ( handle < 0 ) {
-            LogError("GetHandle");
-            return false;
-        }
-
-        xmlrpc_c::clientXmlTransport_pstream transport(
-                xmlrpc_c::clientXmlTransport_pstream::constrOpt()
-                .fd(handle));
-        xmlrpc_c::client_xml client(&transport);
         string const method(TapeManagerProxyServer::SetTapeAction);
         xmlrpc_c::paramList params;
         params.add(xmlrpc_c::value_string(tape));
         params.add(xmlrpc_c::value_int(action));
-        xmlrpc_c::rpc rpc(method,params);
-        xmlrpc_c::carriageParm_pstream carriage;
+        xmlrpc_c::value result;
 
         bool ret = false;
         try {
-            rpc.call(&client,&carriage);
-            if ( ! rpc.isSuccessful() ) {
-                xmlrpc_c::fault fault = rpc.getFault();
-                LogError(fault.getCode() << ":" << fault.getDescription());
-            } else {
-                ret = xmlrpc_c::value_boolean(rpc.getResult());
+            if ( channel_.Call(method,params,result) ) {
+                ret = xmlrpc_c::value_boolean(result);
             }
         } catch ( std::exception const & e ) {
             LogError(e.what());
         }
 
-        close(handle);
-
         return ret;
     }
     bool
@@ -557,34 +365,16 @@ namespace bdt
     {
     	bool ret = false;
 
-        int handle = Factory::SocketClientHandle(
-                TapeManagerProxyServer::Service );
-        if ( handle < 0 ) {
-            LogError("GetHandle");
-            return ret;
-        }
-
-        xmlrpc_c::clientXmlTransport_pstream transport(
-                xmlrpc_c::clientXmlTransport_pstream::constrOpt()
-                .fd(handle));
-        xmlrpc_c::client_xml client(&transport);
         string const method(TapeManagerProxyServer::GetDriveNum);
         xmlrpc_c::paramList params;
-        xmlrpc_c::rpc rpc(method,params);
-        xmlrpc_c::carriageParm_pstream carriage;
+        xmlrpc_c::value result;
 
         try
         {
-            rpc.call(&client,&carriage);
-            if ( ! rpc.isSuccessful() )
+            if ( channel_.Call(method,params,result) )
             {
-                xmlrpc_c::fault fault = rpc.getFault();
-                LogError(fault.getCode() << ":" << fault.getDescription());
-            }
-            else
-            {
-                map<string,xmlrpc_c::value> data(
-                        xmlrpc_c::value_struct(rpc.getResult()) );
+                map<string,xmlrpc_c::value> data =
+                        xmlrpc_c::value_struct(result);
                 ret = xmlrpc_c::value_boolean(data["Result"]);
                 driveNum = xmlrpc_c::value_int(data["driveNum"]);
                 LogDebug("GetDriveNum: driveNum = " << driveNum);
@@ -595,8 +385,6 @@ namespace bdt
             LogError(e.what());
         }
 
-        close(handle);
-
     	return ret;
     }
 
@@ -605,35 +393,17 @@ namespace bdt
     {
     	bool ret = false;
 
-        int handle = Factory::SocketClientHandle(
-                TapeManagerProxyServer::Service );
-        if ( handle < 0 ) {
-            LogError("GetHandle");
-            return ret;
-        }
-
-        xmlrpc_c::clientXmlTransport_pstream transport(
-                xmlrpc_c::clientXmlTransport_pstream::constrOpt()
-                .fd(handle));
-        xmlrpc_c::client_xml client(&transport);
         string const method(TapeManagerProxyServer::GetTapeActivity);
         xmlrpc_c::paramList params;
         params.add(xmlrpc_c::value_string(barcode));
-        xmlrpc_c::rpc rpc(method,params);
-        xmlrpc_c::carriageParm_pstream carriage;
+        xmlrpc_c::value result;
 
         try
         {
-            rpc.call(&client,&carriage);
-            if ( ! rpc.isSuccessful() )
+            if ( channel_.Call(method,params,result) )
             {
-                xmlrpc_c::fault fault = rpc.getFault();
-                LogError(fault.getCode() << ":" << fault.getDescription());
-            }
-            else
-            {
-                map<string,xmlrpc_c::value> data(
-                        xmlrpc_c::value_struct(rpc.getResult()) );
+                map<string,xmlrpc_c::value> data =
+                        xmlrpc_c::value_struct(result);
                 ret = xmlrpc_c::value_boolean(data["Result"]);
                 act = xmlrpc_c::value_int(data["activity"]);
                 percentage = xmlrpc_c::value_int(data["percentage"]);
@@ -645,8 +415,6 @@ namespace bdt
             LogError(e.what());
         }
 
-        close(handle);
-
     	return ret;
     }
 
@@ -23,6 +23,7 @@
 
 
 #include "TapeManagerProxyServer.h"
+#include "RpcChannel.h"
 
 
 namespace bdt
@@ -91,6 +92,9 @@ namespace bdt
 
         string service_;
 
+        //  kept open to the vfsserver for all the calls
+        RpcChannel channel_;
+
     };
 
 }
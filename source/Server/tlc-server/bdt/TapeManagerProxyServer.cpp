@@ -53,7 +53,7 @@ namespace bdt
 
 
     TapeManagerProxyServer::TapeManagerProxyServer()
-    : SocketServer(Service),
+    : RpcServer(Service),
       tape_(new TapeManagerSE())
     {
         Factory::ResetTapeManager(tape_);
@@ -62,6 +62,7 @@ namespace bdt
 
     TapeManagerProxyServer::~TapeManagerProxyServer()
     {
+        StopThreads();
     }
 
 
@@ -579,83 +580,62 @@ namespace bdt
     };
 
     void
-    TapeManagerProxyServer::ServiceThread(int handle)
+    TapeManagerProxyServer::AddMethods()
     {
-        LogDebug(handle);
+        xmlrpc_c::methodPtr const methodSetTapeStatus(
+                new TapeSetTapeStatusMethod(tape_));
+        AddMethod(SetTapeStatus,methodSetTapeStatus);
 
-        try {
-            xmlrpc_c::registry registry;
+        xmlrpc_c::methodPtr const methodGetTapeStatus(
+                new TapeGetTapeStatusMethod(tape_));
+        AddMethod(GetTapeStatus,methodGetTapeStatus);
 
-            xmlrpc_c::methodPtr const methodSetTapeStatus(
-                    new TapeSetTapeStatusMethod(tape_));
-            registry.addMethod(SetTapeStatus,methodSetTapeStatus);
+        xmlrpc_c::methodPtr const methodGetTapesUse(
+                new TapeGetTapesUseMethod(tape_));
+        AddMethod(GetTapesUse,methodGetTapesUse);
 
-            xmlrpc_c::methodPtr const methodGetTapeStatus(
-                    new TapeGetTapeStatusMethod(tape_));
-            registry.addMethod(GetTapeStatus,methodGetTapeStatus);
+        xmlrpc_c::methodPtr const methodSetTapesUse(
+                new TapeSetTapesUseMethod(tape_));
+        AddMethod(SetTapesUse,methodSetTapesUse);
 
-            xmlrpc_c::methodPtr const methodGetTapesUse(
-                    new TapeGetTapesUseMethod(tape_));
-            registry.addMethod(GetTapesUse,methodGetTapesUse);
+        /*xmlrpc_c::methodPtr const methodGetCapacity(
+                new TapeGetCapacityMethod(tape_));
+        AddMethod(GetCapacity,methodGetCapacity);*/
 
-            xmlrpc_c::methodPtr const methodSetTapesUse(
-                    new TapeSetTapesUseMethod(tape_));
-            registry.addMethod(SetTapesUse,methodSetTapesUse);
+        xmlrpc_c::methodPtr const methodCheckTapeState(
+                new TapeCheckTapeStateMethod(tape_));
+        AddMethod(CheckTapeState,methodCheckTapeState);
 
-            /*xmlrpc_c::methodPtr const methodGetCapacity(
-                    new TapeGetCapacityMethod(tape_));
-            registry.addMethod(GetCapacity,methodGetCapacity);*/
+        xmlrpc_c::methodPtr const methodLockTapeState(
+                new TapeLockTapeStateMethod(tape_));
+        AddMethod(LockTapeState,methodLockTapeState);
 
-            xmlrpc_c::methodPtr const methodCheckTapeState(
-                    new TapeCheckTapeStateMethod(tape_));
-            registry.addMethod(CheckTapeState,methodCheckTapeState);
+        xmlrpc_c::methodPtr const methodSetTapeStateNoLock(
+                new TapeSetTapeStateNoLockMethod(tape_));
+        AddMethod(SetTapeStateNoLock,methodSetTapeStateNoLock);
 
-            xmlrpc_c::methodPtr const methodLockTapeState(
-                    new TapeLockTapeStateMethod(tape_));
-            registry.addMethod(LockTapeState,methodLockTapeState);
+        xmlrpc_c::methodPtr const methodSetTapeState(
+                new TapeSetTapeStateMethod(tape_));
+        AddMethod(SetTapeState,methodSetTapeState);
 
-            xmlrpc_c::methodPtr const methodSetTapeStateNoLock(
-                    new TapeSetTapeStateNoLockMethod(tape_));
-            registry.addMethod(SetTapeStateNoLock,methodSetTapeStateNoLock);
+        xmlrpc_c::methodPtr const methodSetTapeAction(
+                new TapeSetTapeActionMethod(tape_));
+        AddMethod(SetTapeAction,methodSetTapeAction);
 
-            xmlrpc_c::methodPtr const methodSetTapeState(
-                    new TapeSetTapeStateMethod(tape_));
-            registry.addMethod(SetTapeState,methodSetTapeState);
+        xmlrpc_c::methodPtr const methodOpenMailSlot(
+                new TapeOpenMailSlotMethod(tape_));
+        AddMethod(OpenMailSlot, methodOpenMailSlot);
 
-            xmlrpc_c::methodPtr const methodSetTapeAction(
-                    new TapeSetTapeActionMethod(tape_));
-            registry.addMethod(SetTapeAction,methodSetTapeAction);
+        xmlrpc_c::methodPtr const methodInventoryLibrary(
+                new TapeInventoryLibraryMethod(tape_));
+        AddMethod(InventoryLibrary,methodInventoryLibrary);
 
-            xmlrpc_c::methodPtr const methodOpenMailSlot(
-                    new TapeOpenMailSlotMethod(tape_));
-            registry.addMethod(OpenMailSlot, methodOpenMailSlot);
+        xmlrpc_c::methodPtr const methodGetDriveNum(
+        		new TapeGetDriveNumMethod(tape_));
+        AddMethod(GetDriveNum,methodGetDriveNum);
 
-            xmlrpc_c::methodPtr const methodInventoryLibrary(
-                    new TapeInventoryLibraryMethod(tape_));
-            registry.addMethod(InventoryLibrary,methodInventoryLibrary);
-
-            xmlrpc_c::methodPtr const methodGetDriveNum(
-            		new TapeGetDriveNumMethod(tape_));
-            registry.addMethod(GetDriveNum,methodGetDriveNum);
-
-            xmlrpc_c::methodPtr const methodGetTapeActivity(
-            		new TapeGetTapeActivityMethod(tape_));
-            registry.addMethod(GetTapeActivity ,methodGetTapeActivity);
-
-            xmlrpc_c::serverPstreamConn server(
-                    xmlrpc_c::serverPstreamConn::constrOpt()
-                    .socketFd(handle)
-                    .registryP(&registry));
-
-            bool disconnect;
-            server.runOnce(&disconnect);
-            if ( disconnect ) {
-                LogError("Disconnect");
-            }
-        } catch ( std::exception const & e ) {
-            cerr << e.what() << endl;
-        }
-
-        close(handle);
+        xmlrpc_c::methodPtr const methodGetTapeActivity(
+        		new TapeGetTapeActivityMethod(tape_));
+        AddMethod(GetTapeActivity ,methodGetTapeActivity);
     }
 }
@@ -22,13 +22,13 @@
 #pragma once
 
 
-#include "SocketServer.h"
+#include "RpcServer.h"
 
 
 namespace bdt
 {
 
-    class TapeManagerProxyServer : public SocketServer
+    class TapeManagerProxyServer : public RpcServer
     {
     public:
         TapeManagerProxyServer();
@@ -57,7 +57,7 @@ namespace bdt
         TapeManagerInterface * tape_;
 
         void
-        ServiceThread(int handle);
+        AddMethods();
 
     };
 
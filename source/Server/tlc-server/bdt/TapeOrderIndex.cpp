@@ -0,0 +1,379 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * TapeOrderIndex.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+
+
+
+#include "stdafx.h"
+#include "TapeOrderIndex.h"
+
+
+namespace bdt
+{
+
+    static bool
+    LessNumber(
+            const pair<unsigned long long, off_t> & a,
+            const pair<unsigned long long, off_t> & b)
+    {
+        return a.first < b.first;
+    }
+
+
+    TapeOrderIndex::TapeOrderIndex(size_t tapes)
+    : tapes_(tapes), used_(0)
+    {
+        if ( tapes_ < 1 ) {
+            tapes_ = 1;
+        }
+    }
+
+
+    TapeOrderIndex::~TapeOrderIndex()
+    {
+    }
+
+
+    bool
+    TapeOrderIndex::IsLoaded(const string & tape)
+    {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+        return NULL != GetTape(tape);
+    }
+
+
+    bool
+    TapeOrderIndex::BeginLoad(const string & tape)
+    {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+
+        MapTapeType::iterator i = items_.find(tape);
+        if ( i != items_.end() ) {
+            return false;
+        }
+        Tape & item = items_[tape];
+        item.loaded = false;
+        item.used = 0;
+        item.holes = 0;
+        return true;
+    }
+
+
+    void
+    TapeOrderIndex::Load(const string & tape, vector<TapeOrderItem> & items)
+    {
+        //  sort out of the lock, the lookups of the other tapes go on
+        sort(items.begin(), items.end(), LessItem);
+        vector<NumberType> numbers;
+        numbers.reserve(items.size());
+        BOOST_FOREACH( const TapeOrderItem & item, items ) {
+            numbers.push_back( NumberType( item.number, item.block ) );
+        }
+        sort(numbers.begin(), numbers.end());
+
+        boost::lock_guard<boost::mutex> lock(mutex_);
+
+        Tape & item = items_[tape];
+        item.items.swap(items);
+        item.numbers.swap(numbers);
+        item.holes = 0;
+        item.loaded = true;
+        item.used = ++ used_;
+        BOOST_FOREACH( const Change & change, item.changes ) {
+            if ( change.add ) {
+                AddUnlock(item, change.item);
+            } else {
+                RemoveUnlock(item, change.item.number);
+            }
+        }
+        item.changes.clear();
+        LogInfo(tape << " has " << item.items.size() - item.holes
+                << " files in the order index");
+
+        size_t loaded = 0;
+        MapTapeType::iterator oldest = items_.end();
+        for ( MapTapeType::iterator i = items_.begin();
+                i != items_.end(); ++ i ) {
+            if ( ! i->second.loaded ) {
+                continue;
+            }
+            ++ loaded;
+            if ( oldest == items_.end()
+                    || i->second.used < oldest->second.used ) {
+                oldest = i;
+            }
+        }
+        if ( loaded > tapes_ ) {
+            LogInfo(oldest->first << " is dropped from the order index");
+            items_.erase(oldest);
+        }
+    }
+
+
+    void
+    TapeOrderIndex::Unload(const string & tape)
+    {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+        items_.erase(tape);
+    }
+
+
+    void
+    TapeOrderIndex::Add(const string & tape, const TapeOrderItem & item)
+    {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+
+        //  the catalog keeps the file only on the tape written last, the
+        //  older copies leave the order of their tapes
+        for ( MapTapeType::iterator i = items_.begin();
+                i != items_.end(); ++ i ) {
+            bool add = i->first == tape;
+            if ( i->second.loaded ) {
+                if ( add ) {
+                    AddUnlock(i->second, item);
+                } else {
+                    RemoveUnlock(i->second, item.number);
+                }
+            } else {
+                Change change;
+                change.add = add;
+                change.item = item;
+                i->second.changes.push_back(change);
+            }
+        }
+    }
+
+
+    void
+    TapeOrderIndex::Remove(unsigned long long number)
+    {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+
+        for ( MapTapeType::iterator i = items_.begin();
+                i != items_.end(); ++ i ) {
+            if ( i->second.loaded ) {
+                RemoveUnlock(i->second, number);
+            } else {
+                Change change;
+                change.add = false;
+                change.item.block = 0;
+                change.item.number = number;
+                change.item.size = 0;
+                i->second.changes.push_back(change);
+            }
+        }
+    }
+
+
+    bool
+    TapeOrderIndex::GetBlock(
+            const string & tape,
+            unsigned long long number,
+            off_t & block)
+    {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+
+        Tape * item = GetTape(tape);
+        if ( NULL == item ) {
+            return false;
+        }
+        vector<NumberType>::iterator n = lower_bound(
+                item->numbers.begin(), item->numbers.end(),
+                NumberType( number, 0 ), LessNumber );
+        if ( n == item->numbers.end() || n->first != number || n->second < 0 ) {
+            return false;
+        }
+        block = n->second;
+        return true;
+    }
+
+
+    bool
+    TapeOrderIndex::GetNext(
+            const string & tape,
+            unsigned long long number,
+            unsigned long long & next,
+            off_t & size)
+    {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+
+        Tape * item = GetTape(tape);
+        if ( NULL == item ) {
+            return false;
+        }
+        vector<NumberType>::iterator n = lower_bound(
+                item->numbers.begin(), item->numbers.end(),
+                NumberType( number, 0 ), LessNumber );
+        if ( n == item->numbers.end() || n->first != number || n->second < 0 ) {
+            return false;
+        }
+
+        TapeOrderItem key;
+        key.block = n->second;
+        key.number = number;
+        key.size = 0;
+        vector<TapeOrderItem>::iterator i = upper_bound(
+                item->items.begin(), item->items.end(), key, LessItem );
+        while ( i != item->items.end() && i->size < 0 ) {
+            ++ i;
+        }
+        if ( i == item->items.end() ) {
+            next = 0;
+            size = 0;
+        } else {
+            next = i->number;
+            size = i->size;
+        }
+        return true;
+    }
+
+
+    size_t
+    TapeOrderIndex::Size(const string & tape)
+    {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+
+        Tape * item = GetTape(tape);
+        if ( NULL == item ) {
+            return 0;
+        }
+        return item->items.size() - item->holes;
+    }
+
+
+    TapeOrderIndex::Tape *
+    TapeOrderIndex::GetTape(const string & tape)
+    {
+        MapTapeType::iterator i = items_.find(tape);
+        if ( i == items_.end() || ! i->second.loaded ) {
+            return NULL;
+        }
+        i->second.used = ++ used_;
+        return &i->second;
+    }
+
+
+    void
+    TapeOrderIndex::AddUnlock(Tape & tape, const TapeOrderItem & item)
+    {
+        vector<NumberType>::iterator n = lower_bound(
+                tape.numbers.begin(), tape.numbers.end(),
+                NumberType( item.number, 0 ), LessNumber );
+        if ( n != tape.numbers.end() && n->first == item.number ) {
+            if ( n->second >= 0 && n->second != item.block ) {
+                //  rewritten further on the tape
+                TapeOrderItem key = item;
+                key.block = n->second;
+                vector<TapeOrderItem>::iterator old = lower_bound(
+                        tape.items.begin(), tape.items.end(), key, LessItem );
+                if ( old != tape.items.end()
+                        && old->block == key.block
+                        && old->number == key.number
+                        && old->size >= 0 ) {
+                    old->size = -1;
+                    ++ tape.holes;
+                }
+            }
+            n->second = item.block;
+        } else {
+            tape.numbers.insert( n, NumberType( item.number, item.block ) );
+        }
+
+        vector<TapeOrderItem>::iterator i = lower_bound(
+                tape.items.begin(), tape.items.end(), item, LessItem );
+        if ( i != tape.items.end()
+                && i->block == item.block && i->number == item.number ) {
+            if ( i->size < 0 ) {
+                -- tape.holes;
+            }
+            i->size = item.size;
+        } else {
+            //  the backups append to the end of the tape
+            tape.items.insert( i, item );
+        }
+
+        if ( tape.holes * 2 > tape.items.size() ) {
+            Compact(tape);
+        }
+    }
+
+
+    void
+    TapeOrderIndex::RemoveUnlock(Tape & tape, unsigned long long number)
+    {
+        vector<NumberType>::iterator n = lower_bound(
+                tape.numbers.begin(), tape.numbers.end(),
+                NumberType( number, 0 ), LessNumber );
+        if ( n == tape.numbers.end() || n->first != number || n->second < 0 ) {
+            return;
+        }
+
+        TapeOrderItem key;
+        key.block = n->second;
+        key.number = number;
+        key.size = 0;
+        vector<TapeOrderItem>::iterator i = lower_bound(
+                tape.items.begin(), tape.items.end(), key, LessItem );
+        if ( i != tape.items.end()
+                && i->block == key.block && i->number == number
+                && i->size >= 0 ) {
+            i->size = -1;
+            ++ tape.holes;
+        }
+        n->second = -1;
+
+        if ( tape.holes * 2 > tape.items.size() ) {
+            Compact(tape);
+        }
+    }
+
+
+    void
+    TapeOrderIndex::Compact(Tape & tape)
+    {
+        vector<TapeOrderItem>::iterator i = tape.items.begin();
+        BOOST_FOREACH( const TapeOrderItem & item, tape.items ) {
+            if ( item.size >= 0 ) {
+                *i ++ = item;
+            }
+        }
+        tape.items.erase( i, tape.items.end() );
+
+        vector<NumberType>::iterator n = tape.numbers.begin();
+        BOOST_FOREACH( const NumberType & number, tape.numbers ) {
+            if ( number.second >= 0 ) {
+                *n ++ = number;
+            }
+        }
+        tape.numbers.erase( n, tape.numbers.end() );
+        tape.holes = 0;
+    }
+
+
+    bool
+    TapeOrderIndex::LessItem(const TapeOrderItem & a, const TapeOrderItem & b)
+    {
+        if ( a.block != b.block ) {
+            return a.block < b.block;
+        }
+        return a.number < b.number;
+    }
+
+}
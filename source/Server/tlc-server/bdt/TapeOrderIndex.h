@@ -0,0 +1,134 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * TapeOrderIndex.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+
+#pragma once
+
+
+namespace bdt
+{
+
+    struct TapeOrderItem
+    {
+        off_t block;
+        unsigned long long number;
+        off_t size;
+    };
+
+
+    //  The files of the tapes in the order they are on the tape, by start
+    //  block and by number for the files sharing the block of a pack. A
+    //  tape is loaded from the catalog once, backups and deletes change
+    //  it after; the changes made while it is loaded are applied to what
+    //  was loaded. Beyond tapes tapes the least recently used one is
+    //  dropped. The entries are kept in sorted arrays, a removed one stays
+    //  as a hole until the holes are half of a tape.
+    class TapeOrderIndex
+    {
+    public:
+        TapeOrderIndex(size_t tapes);
+
+        ~TapeOrderIndex();
+
+        bool
+        IsLoaded(const string & tape);
+
+        //  the changes from now on are kept for Load; false when the tape
+        //  is loaded or another one loads it
+        bool
+        BeginLoad(const string & tape);
+
+        void
+        Load(const string & tape, vector<TapeOrderItem> & items);
+
+        void
+        Unload(const string & tape);
+
+        //  a tape not loaded is left alone, the file leaves the other tapes
+        void
+        Add(const string & tape, const TapeOrderItem & item);
+
+        //  from all the tapes
+        void
+        Remove(unsigned long long number);
+
+        //  false when the tape is not loaded or the file is not on it
+        bool
+        GetBlock(
+                const string & tape,
+                unsigned long long number,
+                off_t & block);
+
+        //  next is 0 behind the last file of the tape
+        bool
+        GetNext(
+                const string & tape,
+                unsigned long long number,
+                unsigned long long & next,
+                off_t & size);
+
+        size_t
+        Size(const string & tape);
+
+    private:
+        typedef pair<unsigned long long, off_t> NumberType;
+
+        struct Change
+        {
+            bool add;
+            TapeOrderItem item;
+        };
+
+        struct Tape
+        {
+            bool loaded;
+            unsigned long long used;
+            size_t holes;
+            //  by block and number, a hole has size -1
+            vector<TapeOrderItem> items;
+            //  by number, with the block of the item; a hole has block -1
+            vector<NumberType> numbers;
+            vector<Change> changes;
+        };
+
+        typedef map<string, Tape> MapTapeType;
+
+        boost::mutex mutex_;
+        size_t tapes_;
+        unsigned long long used_;
+        MapTapeType items_;
+
+        Tape *
+        GetTape(const string & tape);
+
+        void
+        AddUnlock(Tape & tape, const TapeOrderItem & item);
+
+        void
+        RemoveUnlock(Tape & tape, unsigned long long number);
+
+        void
+        Compact(Tape & tape);
+
+        static bool
+        LessItem(const TapeOrderItem & a, const TapeOrderItem & b);
+    };
+
+}
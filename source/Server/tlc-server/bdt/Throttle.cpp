@@ -26,8 +26,13 @@
 namespace bdt
 {
 
+    const size_t Throttle::MaxClients;
+
+
     Throttle::Throttle(int interval,long long valve)
     {
+        SetBucket(global_,0,0);
+        SetBucket(client_,0,0);
         Reset(interval,valve);
     }
 
@@ -40,34 +45,40 @@ namespace bdt
     bool
     Throttle::Request(int size)
     {
-        boost::lock_guard<boost::mutex> lock(mutex_);
+        return Request(size,"");
+    }
 
+
+    bool
+    Throttle::Request(int size,const string & client)
+    {
         if ( size <= 0 ) {
             return true;
         }
-        if ( interval_ == 0 ) {
-            return true;
-        }
 
-        boost::posix_time::ptime current =
-                boost::posix_time::microsec_clock::local_time();
-        int duration = (current - current_).total_milliseconds();
-        if ( duration >= interval_ ) {
-            cumulate_ = cumulate_ - duration * valveMillisec_;
-            if ( cumulate_ < 0 ) {
-                cumulate_ = 0;
+        long long wait = 0;
+        {
+            boost::lock_guard<boost::mutex> lock(mutex_);
+
+            long long now = Now();
+            wait = Charge(global_,size,now);
+
+            if ( client_.rate > 0 && ! client.empty() ) {
+                MapBucketType::iterator i = clients_.find(client);
+                if ( i == clients_.end() ) {
+                    if ( clients_.size() >= MaxClients ) {
+                        RemoveIdleClients(now);
+                    }
+                    i = clients_.insert(
+                            MapBucketType::value_type(client,client_) ).first;
+                }
+                wait = max( wait, Charge(i->second,size,now) );
             }
-            current_ = current;
         }
 
-        if ( cumulate_ <= valve_ ) {
-            cumulate_ += size;
-            return true;
+        if ( wait > 0 ) {
+            Sleep(wait);
         }
-
-        int wait = (cumulate_ - valve_) / valveMillisec_;
-        cumulate_ += size;
-        boost::this_thread::sleep(boost::posix_time::milliseconds(wait));
         return true;
     }
 
@@ -77,27 +88,102 @@ namespace bdt
     {
         boost::lock_guard<boost::mutex> lock(mutex_);
 
-        interval_ = interval;
-        if ( interval_ < 0 ) {
-            interval_ = 0;
+        SetBucket(global_,interval,valve);
+        return true;
+    }
+
+
+    bool
+    Throttle::ResetClient(int interval,long long valve)
+    {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+
+        SetBucket(client_,interval,valve);
+        clients_.clear();
+        return true;
+    }
+
+
+    long long
+    Throttle::Now()
+    {
+        static const boost::posix_time::ptime epoch(
+                boost::gregorian::date(1970,1,1) );
+        return ( boost::posix_time::microsec_clock::universal_time()
+                - epoch ).total_microseconds();
+    }
+
+
+    void
+    Throttle::Sleep(long long microseconds)
+    {
+        boost::this_thread::sleep(
+                boost::posix_time::microseconds(microseconds) );
+    }
+
+
+    void
+    Throttle::SetBucket(Bucket & bucket,int interval,long long valve)
+    {
+        if ( interval <= 0 || valve <= 0 ) {
+            bucket.rate = 0;
+            bucket.valve = 0;
+        } else {
+            bucket.rate = static_cast<double>(valve) / interval / 1000;
+            bucket.valve = valve;
         }
+        bucket.tokens = bucket.valve;
+        bucket.update = -1;
+    }
+
 
-        valve_ = valve;
-        if ( valve_ < 0 ) {
-            valve_ = 0;
+    void
+    Throttle::Refill(Bucket & bucket,long long now)
+    {
+        if ( bucket.update >= 0 && now > bucket.update ) {
+            bucket.tokens += (now - bucket.update) * bucket.rate;
+            if ( bucket.tokens > bucket.valve ) {
+                bucket.tokens = bucket.valve;
+            }
+        }
+        if ( bucket.update < now ) {
+            bucket.update = now;
         }
+    }
 
-        if ( interval_ == 0 ) {
-            valveMillisec_ = 0;
-        } else {
-            valveMillisec_ = valve/interval;
+
+    long long
+    Throttle::Charge(Bucket & bucket,int size,long long now)
+    {
+        if ( bucket.rate <= 0 ) {
+            return 0;
         }
 
-        cumulate_ = 0;
-        current_ = boost::posix_time::microsec_clock::local_time();
+        Refill(bucket,now);
 
-        return true;
+        //  a request is let through while the bucket is not in debt and
+        //  pays for its size afterwards, the next request waits for it
+        long long wait = 0;
+        if ( bucket.tokens < 0 ) {
+            wait = static_cast<long long>( - bucket.tokens / bucket.rate );
+        }
+        bucket.tokens -= size;
+        return wait;
     }
 
-}
 
+    void
+    Throttle::RemoveIdleClients(long long now)
+    {
+        for ( MapBucketType::iterator i = clients_.begin();
+                i != clients_.end(); ) {
+            Refill(i->second,now);
+            if ( i->second.tokens >= i->second.valve ) {
+                clients_.erase(i++);
+            } else {
+                ++ i;
+            }
+        }
+    }
+
+}
@@ -25,6 +25,13 @@
 namespace bdt
 {
 
+    //  Token bucket write throttle. Every bucket refills valve bytes per
+    //  interval milliseconds and holds at most valve bytes. A request is
+    //  charged to the global bucket, which is the one of the share the
+    //  process serves, and to the bucket of its client; it waits for the
+    //  longer debt of the two.
+    //  The wait is computed under the lock and slept after it is released,
+    //  so writers with budget are never held up by a throttled one.
     class Throttle
     {
     public:
@@ -36,20 +43,54 @@ namespace bdt
         bool
         Request(int size);
 
+        bool
+        Request(int size,const string & client);
+
         bool
         Reset(int interval,long long valve);
 
+        bool
+        ResetClient(int interval,long long valve);
+
+    protected:
+        //  microseconds, overridden by tests
+        virtual long long
+        Now();
+
+        virtual void
+        Sleep(long long microseconds);
+
     private:
-        int interval_;
-        long long valve_;
-        long long valveMillisec_;
+        struct Bucket
+        {
+            //  bytes per microsecond, 0 for no limit
+            double rate;
+            double valve;
+            double tokens;
+            long long update;
+        };
+
+        typedef map<string, Bucket> MapBucketType;
+
+        static const size_t MaxClients = 1024;
 
         boost::mutex mutex_;
 
-        long long cumulate_;
-        boost::posix_time::ptime current_;
+        Bucket global_;
+        Bucket client_;
+        MapBucketType clients_;
+
+        static void
+        SetBucket(Bucket & bucket,int interval,long long valve);
 
+        static void
+        Refill(Bucket & bucket,long long now);
+
+        static long long
+        Charge(Bucket & bucket,int size,long long now);
+
+        void
+        RemoveIdleClients(long long now);
     };
 
 }
-
@@ -57,6 +57,7 @@ namespace fs = boost::filesystem;
 #include <utime.h>
 #include <time.h>
 #include <fcntl.h>
+#include <dirent.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/vfs.h>
@@ -0,0 +1,342 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * AttributeCacheTest.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: agent
+ */
+
+
+#include "stdafx.h"
+#include "../MetaManager.h"
+#include "../CacheManager.h"
+#include "../AttributeCache.h"
+#include "AttributeCacheTest.h"
+
+
+CPPUNIT_TEST_SUITE_REGISTRATION( AttributeCacheTest );
+
+
+static const string metaFolder = "meta.folder";
+static const string cacheFolder = "cache.folder";
+
+
+static InodeAttribute
+MakeAttribute(off_t size)
+{
+    InodeAttribute attribute;
+    memset(&attribute, 0, sizeof(attribute));
+    attribute.stat.st_size = size;
+    attribute.state = Inode::StateWrite;
+    attribute.online = Inode::OnlineStateOnline;
+    return attribute;
+}
+
+
+static void
+RecreateMetaManager(const string & cacheSize)
+{
+    Factory::ReleaseMetaManager();
+    Factory::GetConfigure()->SetValue(
+            Configure::AttributeCacheSize, cacheSize);
+    Factory::CreateMetaManager();
+}
+
+
+void
+AttributeCacheTest::setUp()
+{
+    fs::create_directory(metaFolder);
+    fs::create_directory(cacheFolder);
+
+    Factory::SetCacheFolder(cacheFolder);
+    Factory::CreateCacheManager();
+    Factory::CreateReadManager();
+    Factory::SetMetaFolder(metaFolder);
+    Factory::CreateMetaManager();
+}
+
+
+void
+AttributeCacheTest::tearDown()
+{
+    Factory::ReleaseMetaManager();
+    Factory::ReleaseReadManager();
+    Factory::ReleaseCacheManager();
+    Factory::GetConfigure()->SetValue(
+            Configure::AttributeCacheSize, "65536");
+
+    fs::remove_all(metaFolder);
+    fs::remove_all(cacheFolder);
+}
+
+
+void
+AttributeCacheTest::testGetPut()
+{
+    AttributeCache cache(1024, 60);
+    InodeAttribute attribute;
+    unsigned long long version;
+
+    CPPUNIT_ASSERT( cache.IsEnabled() );
+    CPPUNIT_ASSERT( false == cache.Get("/a", attribute, version) );
+    cache.Put("/a", MakeAttribute(10), version);
+    CPPUNIT_ASSERT( cache.Get("/a", attribute, version) );
+    CPPUNIT_ASSERT( 10 == attribute.stat.st_size );
+    CPPUNIT_ASSERT( Inode::StateWrite == attribute.state );
+    CPPUNIT_ASSERT( Inode::OnlineStateOnline == attribute.online );
+    CPPUNIT_ASSERT( 1 == cache.Size() );
+
+    cache.Put("/a", MakeAttribute(20), version);
+    CPPUNIT_ASSERT( cache.Get("/a", attribute, version) );
+    CPPUNIT_ASSERT( 20 == attribute.stat.st_size );
+    CPPUNIT_ASSERT( 1 == cache.Size() );
+
+    cache.Invalidate("/a");
+    CPPUNIT_ASSERT( false == cache.Get("/a", attribute, version) );
+    CPPUNIT_ASSERT( 0 == cache.Size() );
+
+    AttributeCache disabled(0, 60);
+    CPPUNIT_ASSERT( false == disabled.IsEnabled() );
+    CPPUNIT_ASSERT( false == disabled.Get("/a", attribute, version) );
+    disabled.Put("/a", MakeAttribute(10), version);
+    CPPUNIT_ASSERT( false == disabled.Get("/a", attribute, version) );
+}
+
+
+void
+AttributeCacheTest::testVersion()
+{
+    AttributeCache cache(1024, 60);
+    InodeAttribute attribute;
+    unsigned long long version, versionOld;
+
+    //  an attribute read before an invalidation must not be cached
+    CPPUNIT_ASSERT( false == cache.Get("/a", attribute, versionOld) );
+    cache.Invalidate("/a");
+    cache.Put("/a", MakeAttribute(10), versionOld);
+    CPPUNIT_ASSERT( false == cache.Get("/a", attribute, version) );
+
+    CPPUNIT_ASSERT( false == cache.Get("/b/c", attribute, versionOld) );
+    cache.InvalidateFolder("/b");
+    cache.Put("/b/c", MakeAttribute(10), versionOld);
+    CPPUNIT_ASSERT( false == cache.Get("/b/c", attribute, version) );
+
+    cache.Put("/b/c", MakeAttribute(10), version);
+    CPPUNIT_ASSERT( cache.Get("/b/c", attribute, version) );
+}
+
+
+void
+AttributeCacheTest::testCapacity()
+{
+    AttributeCache cache(64, 60);
+    InodeAttribute attribute;
+    unsigned long long version;
+
+    for ( int i = 0; i < 10000; ++ i ) {
+        string path = "/file" + boost::lexical_cast<string>(i);
+        cache.Get(path, attribute, version);
+        cache.Put(path, MakeAttribute(i), version);
+        CPPUNIT_ASSERT( cache.Size() <= 64 );
+    }
+    CPPUNIT_ASSERT( cache.Size() > 32 );
+
+    //  the most recent entries survive
+    CPPUNIT_ASSERT( cache.Get("/file9999", attribute, version) );
+    CPPUNIT_ASSERT( 9999 == attribute.stat.st_size );
+    CPPUNIT_ASSERT( false == cache.Get("/file0", attribute, version) );
+
+    cache.Clear();
+    CPPUNIT_ASSERT( 0 == cache.Size() );
+}
+
+
+void
+AttributeCacheTest::testTimeout()
+{
+    AttributeCache cache(1024, 1);
+    InodeAttribute attribute;
+    unsigned long long version;
+
+    cache.Get("/a", attribute, version);
+    cache.Put("/a", MakeAttribute(10), version);
+    CPPUNIT_ASSERT( cache.Get("/a", attribute, version) );
+
+    boost::this_thread::sleep( boost::posix_time::milliseconds(2100) );
+    CPPUNIT_ASSERT( false == cache.Get("/a", attribute, version) );
+    CPPUNIT_ASSERT( 0 == cache.Size() );
+}
+
+
+void
+AttributeCacheTest::testInvalidateFolder()
+{
+    AttributeCache cache(1024, 60);
+    InodeAttribute attribute;
+    unsigned long long version;
+
+    const char * paths[] = {
+            "/folder", "/folder/a", "/folder/b/c", "/folder-other", "/other" };
+    BOOST_FOREACH(const char * path, paths) {
+        cache.Get(path, attribute, version);
+        cache.Put(path, MakeAttribute(1), version);
+    }
+    CPPUNIT_ASSERT( 5 == cache.Size() );
+
+    cache.InvalidateFolder("/folder");
+    CPPUNIT_ASSERT( false == cache.Get("/folder", attribute, version) );
+    CPPUNIT_ASSERT( false == cache.Get("/folder/a", attribute, version) );
+    CPPUNIT_ASSERT( false == cache.Get("/folder/b/c", attribute, version) );
+    CPPUNIT_ASSERT( cache.Get("/folder-other", attribute, version) );
+    CPPUNIT_ASSERT( cache.Get("/other", attribute, version) );
+    CPPUNIT_ASSERT( 2 == cache.Size() );
+}
+
+
+void
+AttributeCacheTest::testMetaManager()
+{
+    MetaManager * meta = Factory::GetMetaManager();
+    struct stat stat;
+    auto_ptr<Inode> inode;
+
+    CPPUNIT_ASSERT( false == meta->GetStat("/file", stat) );
+    CPPUNIT_ASSERT( ENOENT == errno );
+
+    CPPUNIT_ASSERT( meta->CreateFile("/file", 0600) );
+    CPPUNIT_ASSERT( meta->GetStat("/file", stat) );
+    CPPUNIT_ASSERT( 0 == stat.st_size );
+
+    //  changes behind the back of MetaManager are seen after invalidation
+    inode.reset(meta->GetInode("/file"));
+    CPPUNIT_ASSERT( inode->SetSize(100) );
+    CPPUNIT_ASSERT( meta->GetStat("/file", stat) );
+    CPPUNIT_ASSERT( 0 == stat.st_size );
+    meta->InvalidateAttribute("/file");
+    CPPUNIT_ASSERT( meta->GetStat("/file", stat) );
+    CPPUNIT_ASSERT( 100 == stat.st_size );
+
+    InodeAttribute attribute;
+    CPPUNIT_ASSERT( meta->GetAttribute("/file", attribute) );
+    CPPUNIT_ASSERT( 100 == attribute.stat.st_size );
+    Inode::OnlineState online;
+    CPPUNIT_ASSERT( meta->GetOnline("/file", online) );
+    CPPUNIT_ASSERT( Inode::OnlineStateOnline == online );
+
+    //  rename
+    CPPUNIT_ASSERT( meta->RenameInode("/file", "/moved") );
+    CPPUNIT_ASSERT( false == meta->GetStat("/file", stat) );
+    CPPUNIT_ASSERT( meta->GetStat("/moved", stat) );
+    CPPUNIT_ASSERT( 100 == stat.st_size );
+
+    CPPUNIT_ASSERT( meta->CreateFolder("/folder", 0700) );
+    CPPUNIT_ASSERT( meta->RenameInode("/moved", "/folder/file") );
+    CPPUNIT_ASSERT( meta->GetStat("/folder/file", stat) );
+    CPPUNIT_ASSERT( meta->RenameInode("/folder", "/renamed") );
+    CPPUNIT_ASSERT( false == meta->GetStat("/folder/file", stat) );
+    CPPUNIT_ASSERT( meta->GetStat("/renamed/file", stat) );
+    CPPUNIT_ASSERT( 100 == stat.st_size );
+
+    //  write
+    CPPUNIT_ASSERT( meta->CreateFile("/write", 0600) );
+    CPPUNIT_ASSERT( meta->GetStat("/write", stat) );
+    CPPUNIT_ASSERT( 0 == stat.st_size );
+    {
+        auto_ptr<FileOperationInterface> file(
+                meta->GetFileOperation("/write", O_RDWR) );
+        CPPUNIT_ASSERT( NULL != file.get() );
+        char buffer[4096];
+        memset(buffer, 'a', sizeof(buffer));
+        size_t size;
+        CPPUNIT_ASSERT( file->Write(0, buffer, sizeof(buffer), size) );
+        CPPUNIT_ASSERT( meta->GetStat("/write", stat) );
+        CPPUNIT_ASSERT( 4096 == stat.st_size );
+    }
+    CPPUNIT_ASSERT( meta->GetStat("/write", stat) );
+    CPPUNIT_ASSERT( 4096 == stat.st_size );
+
+    //  delete
+    CPPUNIT_ASSERT( meta->DeleteInode("/renamed/file") );
+    CPPUNIT_ASSERT( false == meta->GetStat("/renamed/file", stat) );
+}
+
+
+static void
+GetStatTask(const vector<fs::path> & paths, size_t begin, size_t count,
+        size_t & success)
+{
+    MetaManager * meta = Factory::GetMetaManager();
+    struct stat stat;
+    success = 0;
+    for ( size_t i = 0; i < count; ++ i ) {
+        if ( meta->GetStat(paths[(begin + i) % paths.size()], stat) ) {
+            ++ success;
+        }
+    }
+}
+
+
+static double
+GetStatRate(const vector<fs::path> & paths, int threads, size_t count)
+{
+    boost::thread_group group;
+    vector<size_t> success(threads, 0);
+
+    boost::posix_time::ptime begin =
+            boost::posix_time::microsec_clock::local_time();
+    for ( int i = 0; i < threads; ++ i ) {
+        group.create_thread( boost::bind( &GetStatTask, boost::cref(paths),
+                i * 997, count / threads, boost::ref(success[i]) ) );
+    }
+    group.join_all();
+    boost::posix_time::ptime end =
+            boost::posix_time::microsec_clock::local_time();
+
+    for ( int i = 0; i < threads; ++ i ) {
+        CPPUNIT_ASSERT( count / threads == success[i] );
+    }
+    double duration = (end - begin).total_microseconds();
+    return duration > 0 ? count / threads * threads * 1000000.0 / duration : 0;
+}
+
+
+void
+AttributeCacheTest::testBenchmark()
+{
+    MetaManager * meta = Factory::GetMetaManager();
+    vector<fs::path> paths;
+    for ( int i = 0; i < 1000; ++ i ) {
+        fs::path path = "/bench" + boost::lexical_cast<string>(i);
+        CPPUNIT_ASSERT( meta->CreateFile(path, 0600) );
+        paths.push_back(path);
+    }
+
+    const int threads[] = { 1, 8, 64 };
+    const size_t count = 128000;
+    double rate[2][3];
+    for ( int cached = 0; cached < 2; ++ cached ) {
+        RecreateMetaManager(cached ? "65536" : "0");
+        for ( int i = 0; i < 3; ++ i ) {
+            rate[cached][i] = GetStatRate(paths, threads[i], count);
+            cout << "getattr " << threads[i] << " threads "
+                    << ( cached ? "with" : "without" ) << " cache: "
+                    << static_cast<long long>(rate[cached][i])
+                    << " ops/sec" << endl;
+        }
+    }
+
+    CPPUNIT_ASSERT( rate[1][0] > rate[0][0] );
+}
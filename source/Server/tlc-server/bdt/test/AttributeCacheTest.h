@@ -0,0 +1,48 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * AttributeCacheTest.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: agent
+ */
+
+
+#pragma once
+
+
+class AttributeCacheTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE( AttributeCacheTest );
+    CPPUNIT_TEST( testGetPut );
+    CPPUNIT_TEST( testVersion );
+    CPPUNIT_TEST( testCapacity );
+    CPPUNIT_TEST( testTimeout );
+    CPPUNIT_TEST( testInvalidateFolder );
+    CPPUNIT_TEST( testMetaManager );
+    CPPUNIT_TEST( testBenchmark );
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void setUp();
+    void tearDown();
+
+    void testGetPut();
+    void testVersion();
+    void testCapacity();
+    void testTimeout();
+    void testInvalidateFolder();
+    void testMetaManager();
+    void testBenchmark();
+};
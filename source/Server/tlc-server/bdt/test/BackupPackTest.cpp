@@ -0,0 +1,400 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * BackupPackTest.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+
+
+#include "stdafx.h"
+#include "../BackupPack.h"
+#include "../BackupWriter.h"
+#include "../FileDigest.h"
+#include "../FileOperationBitmap.h"
+#include "../ReadTask.h"
+#include "../ReadTaskPool.h"
+#include "BackupPackTest.h"
+
+
+CPPUNIT_TEST_SUITE_REGISTRATION( BackupPackTest );
+
+
+static const fs::path folder = "BackupPackTest";
+static const string cacheFolder = "BackupPackTest.cache";
+
+
+//  A drive which stops writing after a number of writes
+class PackTargetFail : public FileOperation
+{
+public:
+    PackTargetFail(const fs::path & path, int writes)
+    : FileOperation(path,0644,O_RDWR), writes_(writes)
+    {
+    }
+
+    bool
+    Write(off_t offset, const void * buffer, size_t bufsize, size_t & size)
+    {
+        if ( writes_ -- <= 0 ) {
+            errno = EIO;
+            return false;
+        }
+        return FileOperation::Write(offset,buffer,bufsize,size);
+    }
+
+private:
+    int writes_;
+};
+
+
+//  A drive which keeps nothing, for the files on tape and the bytes only
+class PackTargetSink : public FileOperationInterface
+{
+public:
+    PackTargetSink()
+    : size_(0)
+    {
+    }
+
+    bool
+    GetStat(struct stat & stat)
+    {
+        memset(&stat, 0, sizeof(stat));
+        stat.st_size = size_;
+        return true;
+    }
+
+    bool
+    Read(off_t offset, void * buffer, size_t bufsize, size_t & size)
+    {
+        size = 0;
+        return true;
+    }
+
+    bool
+    Write(off_t offset, const void * buffer, size_t bufsize, size_t & size)
+    {
+        size = bufsize;
+        size_ = max<off_t>( size_, offset + size );
+        return true;
+    }
+
+    bool
+    Truncate(off_t length)
+    {
+        size_ = length;
+        return true;
+    }
+
+    bool
+    Sync(bool data)
+    {
+        return true;
+    }
+
+private:
+    off_t size_;
+};
+
+
+static bool
+CheckAlways()
+{
+    return true;
+}
+
+
+static void
+WriteMember(const fs::path & path, size_t size)
+{
+    ofstream output(path.string().c_str(), ios::out|ios::binary);
+    for ( size_t i = 0; i < size; ++ i ) {
+        output.put( (char)rand() );
+    }
+}
+
+
+static string
+GetDigest(FileOperationInterface * file)
+{
+    FileDigest digest;
+    CPPUNIT_ASSERT( true == digest.EnableDigest(FileDigest::DIGEST_MD5) );
+    char buffer[16 * 1024];
+    off_t offset = 0;
+    while ( true ) {
+        size_t size = 0;
+        CPPUNIT_ASSERT( true == file->Read(offset,buffer,sizeof(buffer),size) );
+        if ( size == 0 ) {
+            break;
+        }
+        CPPUNIT_ASSERT( true == digest.UpdateContent(offset,buffer,size) );
+        offset += size;
+    }
+    string checksum;
+    CPPUNIT_ASSERT( true == digest.GetDigest(FileDigest::DIGEST_MD5,checksum) );
+    return checksum;
+}
+
+
+//  recalls a packed file into the cache, the digest of what arrives
+static string
+Recall(
+        ReadTaskPool * pool,
+        const fs::path & pathPack,
+        unsigned long long number,
+        off_t position,
+        off_t size)
+{
+    fs::path path = fs::path(cacheFolder) / boost::lexical_cast<string>(number);
+    FileOperationBitmap * target =
+            new FileOperationBitmap(path, 0600, O_RDWR, 16 * 1024);
+    CPPUNIT_ASSERT( true == target->TruncateBitmap(size) );
+
+    boost::shared_ptr<FileOperationInterface> pack(
+            new FileOperation(pathPack, O_RDONLY) );
+    {
+        ReadTask task( number, "barcode0",
+                new FileOperationRange(pack, position, size),
+                target, NULL, pool );
+        CPPUNIT_ASSERT( true == task.Prepare(0, size) );
+        for ( int i = 0; i < 500 && task.IsRunning(); ++ i ) {
+            boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+        }
+        CPPUNIT_ASSERT( false == task.IsRunning() );
+        CPPUNIT_ASSERT( true == task.IsValid() );
+    }
+
+    FileOperation file(path, O_RDONLY);
+    return GetDigest(&file);
+}
+
+
+void
+BackupPackTest::setUp()
+{
+    srand(1);
+    fs::remove_all(folder);
+    fs::create_directory(folder);
+    fs::remove_all(cacheFolder);
+    fs::create_directory(cacheFolder);
+    Factory::SetCacheFolder(cacheFolder);
+    Factory::CreateCacheManager();
+}
+
+
+void
+BackupPackTest::tearDown()
+{
+    Factory::ReleaseCacheManager();
+    fs::remove_all(cacheFolder);
+    fs::remove_all(folder);
+}
+
+
+void
+BackupPackTest::testRange()
+{
+    fs::path path = folder / "range";
+    WriteMember(path, 1000);
+    boost::shared_ptr<FileOperationInterface> file(
+            new FileOperation(path, O_RDWR) );
+
+    FileOperationRange range(file, 100, 300);
+    struct stat stat;
+    CPPUNIT_ASSERT( true == range.GetStat(stat) );
+    CPPUNIT_ASSERT( 300 == stat.st_size );
+
+    char buffer[1000];
+    char expect[1000];
+    size_t size = 0;
+    CPPUNIT_ASSERT( true == file->Read(0, expect, sizeof(expect), size) );
+    CPPUNIT_ASSERT( true == range.Read(0, buffer, sizeof(buffer), size) );
+    CPPUNIT_ASSERT( 300 == size );
+    CPPUNIT_ASSERT( 0 == memcmp(buffer, expect + 100, 300) );
+    CPPUNIT_ASSERT( true == range.Read(250, buffer, 100, size) );
+    CPPUNIT_ASSERT( 50 == size );
+    CPPUNIT_ASSERT( 0 == memcmp(buffer, expect + 350, 50) );
+    CPPUNIT_ASSERT( true == range.Read(300, buffer, 100, size) );
+    CPPUNIT_ASSERT( 0 == size );
+
+    //  no write beyond the part
+    CPPUNIT_ASSERT( false == range.Write(250, buffer, 100, size) );
+    CPPUNIT_ASSERT( EFBIG == errno );
+    CPPUNIT_ASSERT( false == range.Truncate(0) );
+
+    //  an open part grows with the writes
+    FileOperationRange open(file, 1000, -1);
+    CPPUNIT_ASSERT( 0 == open.GetEnd() );
+    CPPUNIT_ASSERT( true == open.Write(0, expect, 200, size) );
+    CPPUNIT_ASSERT( true == open.Write(100, expect, 50, size) );
+    CPPUNIT_ASSERT( 200 == open.GetEnd() );
+    CPPUNIT_ASSERT( true == file->GetStat(stat) );
+    CPPUNIT_ASSERT( 1200 == stat.st_size );
+}
+
+
+void
+BackupPackTest::testRoundTrip()
+{
+    const int count = 200;
+    vector<boost::shared_ptr<FileOperationInterface> > targets;
+    targets.push_back( boost::shared_ptr<FileOperationInterface>(
+            new FileOperation(folder / "pack0", 0644, O_RDWR) ) );
+    targets.push_back( boost::shared_ptr<FileOperationInterface>(
+            new FileOperation(folder / "pack1", 0644, O_RDWR) ) );
+
+    BackupPack pack(targets);
+    BackupWriter writer(4, 16 * 1024);
+    vector<off_t> positions;
+    vector<off_t> sizes;
+    vector<string> digests;
+    for ( int i = 0; i < count; ++ i ) {
+        //  an empty file takes no place
+        size_t size = i == 10 ? 0 : rand() % (64 * 1024) + 1;
+        fs::path path = folder / boost::lexical_cast<string>(i);
+        WriteMember(path, size);
+        FileOperation source(path, O_RDONLY);
+
+        positions.push_back(pack.GetSize());
+        vector<bool> done;
+        vector<bool> written;
+        off_t sizeCopy = 0;
+        CPPUNIT_ASSERT( true == writer.Copy( &source, pack.Next(),
+                CheckAlways, done, written, sizeCopy ) );
+        pack.Finish();
+        CPPUNIT_ASSERT( true == done[0] && true == done[1] );
+        CPPUNIT_ASSERT( (off_t)size == sizeCopy );
+        CPPUNIT_ASSERT( positions[i] + sizeCopy == pack.GetSize() );
+        sizes.push_back(sizeCopy);
+        digests.push_back(GetDigest(&source));
+    }
+    targets.clear();
+
+    CPPUNIT_ASSERT( fs::file_size(folder / "pack0") == (uintmax_t)pack.GetSize() );
+    CPPUNIT_ASSERT( fs::file_size(folder / "pack1") == (uintmax_t)pack.GetSize() );
+
+    //  every file comes back by itself from either pack
+    ReadTaskPool pool(4, 2, 4, 16 * 1024);
+    for ( int i = 0; i < count; ++ i ) {
+        if ( sizes[i] == 0 ) {
+            continue;
+        }
+        fs::path pathPack = folder / ( i % 2 ? "pack1" : "pack0" );
+        CPPUNIT_ASSERT_MESSAGE( boost::lexical_cast<string>(i),
+                digests[i] == Recall( &pool, pathPack, i + 1,
+                        positions[i], sizes[i] ) );
+    }
+}
+
+
+void
+BackupPackTest::testFailure()
+{
+    const size_t size = 64 * 1024;
+    vector<boost::shared_ptr<FileOperationInterface> > targets;
+    targets.push_back( boost::shared_ptr<FileOperationInterface>(
+            new PackTargetFail(folder / "pack0", 6) ) );
+    targets.push_back( boost::shared_ptr<FileOperationInterface>(
+            new FileOperation(folder / "pack1", 0644, O_RDWR) ) );
+
+    //  the first drive fails in the second file, the others go on
+    BackupPack pack(targets);
+    BackupWriter writer(4, 16 * 1024);
+    vector<string> digests;
+    for ( int i = 0; i < 4; ++ i ) {
+        fs::path path = folder / boost::lexical_cast<string>(i);
+        WriteMember(path, size);
+        FileOperation source(path, O_RDONLY);
+
+        CPPUNIT_ASSERT( (off_t)(i * size) == pack.GetSize() );
+        vector<bool> done;
+        vector<bool> written;
+        off_t sizeCopy = 0;
+        CPPUNIT_ASSERT( true == writer.Copy( &source, pack.Next(),
+                CheckAlways, done, written, sizeCopy ) );
+        pack.Finish();
+        CPPUNIT_ASSERT( ( i == 0 ) == done[0] );
+        CPPUNIT_ASSERT( true == done[1] );
+        digests.push_back(GetDigest(&source));
+    }
+    targets.clear();
+
+    ReadTaskPool pool(4, 2, 4, 16 * 1024);
+    CPPUNIT_ASSERT( digests[0] == Recall( &pool, folder / "pack0", 1,
+            0, size ) );
+    for ( int i = 0; i < 4; ++ i ) {
+        CPPUNIT_ASSERT( digests[i] == Recall( &pool, folder / "pack1",
+                i + 2, i * size, size ) );
+    }
+}
+
+
+void
+BackupPackTest::testSmallFiles()
+{
+    //  1M objects of 16K into packs of 1G
+    const int count = 1000 * 1000;
+    const size_t size = 16 * 1024;
+    const off_t packSize = 1024 * 1024 * 1024;
+    fs::path path = folder / "object";
+    WriteMember(path, size);
+    FileOperation source(path, O_RDONLY);
+
+    BackupWriter writer(8, 512 * 1024);
+    int packs = 0;
+    off_t total = 0;
+    boost::posix_time::ptime begin =
+            boost::posix_time::microsec_clock::local_time();
+    for ( int i = 0; i < count; ) {
+        vector<boost::shared_ptr<FileOperationInterface> > targets(1,
+                boost::shared_ptr<FileOperationInterface>(new PackTargetSink()) );
+        BackupPack pack(targets);
+        for ( ; i < count && pack.GetSize() < packSize; ++ i ) {
+            vector<bool> done;
+            vector<bool> written;
+            off_t sizeCopy = 0;
+            CPPUNIT_ASSERT( true == writer.Copy( &source, pack.Next(),
+                    CheckAlways, done, written, sizeCopy ) );
+            pack.Finish();
+        }
+        total += pack.GetSize();
+        ++ packs;
+    }
+    int duration = (boost::posix_time::microsec_clock::local_time()
+            - begin).total_milliseconds();
+    CPPUNIT_ASSERT( (off_t)count * (off_t)size == total );
+    CPPUNIT_ASSERT( 16 == packs );
+
+    //  a file of its own for each object, on a sample
+    const int sample = 10 * 1000;
+    fs::create_directory(folder / "files");
+    boost::scoped_array<char> buffer(new char[size]());
+    begin = boost::posix_time::microsec_clock::local_time();
+    for ( int i = 0; i < sample; ++ i ) {
+        FileOperation file( folder / "files" / boost::lexical_cast<string>(i),
+                0644, O_RDWR );
+        size_t sizeWrite = 0;
+        CPPUNIT_ASSERT( true == file.Write(0, buffer.get(), size, sizeWrite) );
+    }
+    int durationFiles = (boost::posix_time::microsec_clock::local_time()
+            - begin).total_milliseconds();
+
+    cout << endl << count << " objects of 16K, packed: " << packs
+            << " files on tape, " << duration << " ms; one file each: "
+            << count << " files on tape, " << durationFiles * (count / sample)
+            << " ms (" << durationFiles << " ms for " << sample << ")" << endl;
+}
@@ -0,0 +1,238 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * BackupQueueTest.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+
+
+
+#include "stdafx.h"
+#include "../BackupQueue.h"
+#include "BackupQueueTest.h"
+#include <sys/resource.h>
+
+
+CPPUNIT_TEST_SUITE_REGISTRATION( BackupQueueTest );
+
+
+static boost::posix_time::ptime
+Now()
+{
+    return boost::posix_time::microsec_clock::local_time();
+}
+
+
+//  cpu time of the calling thread in milliseconds
+static int
+ThreadTime()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_THREAD,&usage);
+    return usage.ru_utime.tv_sec * 1000 + usage.ru_utime.tv_usec / 1000
+            + usage.ru_stime.tv_sec * 1000 + usage.ru_stime.tv_usec / 1000;
+}
+
+
+//  the loop of the backup thread, takes the ready files as they come
+class BackupWaiter
+{
+public:
+    BackupWaiter(BackupQueue * queue)
+    : queue_(queue), wakeups_(0), time_(0)
+    {
+    }
+
+    void
+    Run(int count)
+    {
+        int begin = ThreadTime();
+        while ( (int)ready_.size() < count ) {
+            queue_->Wait(60 * 1000);
+            ++ wakeups_;
+            vector<fs::path> paths;
+            queue_->GetReady(paths);
+            BOOST_FOREACH( const fs::path & path, paths ) {
+                ready_.push_back( make_pair( path, Now() ) );
+                queue_->Done(path);
+            }
+        }
+        time_ = ThreadTime() - begin;
+    }
+
+    BackupQueue * queue_;
+    int wakeups_;
+    int time_;
+    vector<pair<fs::path, boost::posix_time::ptime> > ready_;
+};
+
+
+void
+BackupQueueTest::setUp()
+{
+}
+
+
+void
+BackupQueueTest::tearDown()
+{
+}
+
+
+void
+BackupQueueTest::testOrder()
+{
+    BackupQueue queue;
+    boost::posix_time::ptime now = Now();
+    vector<fs::path> paths;
+
+    queue.Push("/b", now - boost::posix_time::seconds(2));
+    queue.Push("/a", now - boost::posix_time::seconds(1));
+    queue.Push("/c", now + boost::posix_time::hours(1));
+    CPPUNIT_ASSERT( 3 == queue.Size() );
+
+    queue.GetReady(paths);
+    CPPUNIT_ASSERT( 2 == paths.size() );
+    CPPUNIT_ASSERT( "/a" == paths[0] );
+    CPPUNIT_ASSERT( "/b" == paths[1] );
+
+    //  ready until done
+    queue.GetReady(paths);
+    CPPUNIT_ASSERT( 2 == paths.size() );
+    queue.Done("/a");
+    queue.GetReady(paths);
+    CPPUNIT_ASSERT( 1 == paths.size() );
+    CPPUNIT_ASSERT( "/b" == paths[0] );
+
+    //  written again, it waits once more
+    queue.Push("/b", now + boost::posix_time::hours(1));
+    queue.GetReady(paths);
+    CPPUNIT_ASSERT( paths.empty() );
+    CPPUNIT_ASSERT( 2 == queue.Size() );
+
+    queue.Push("/c", now);
+    queue.GetReady(paths);
+    CPPUNIT_ASSERT( 1 == paths.size() );
+    CPPUNIT_ASSERT( "/c" == paths[0] );
+    CPPUNIT_ASSERT( 2 == queue.Size() );
+
+    queue.Done("/c");
+    queue.Done("/x");
+    CPPUNIT_ASSERT( 1 == queue.Size() );
+}
+
+
+void
+BackupQueueTest::testWait()
+{
+    BackupQueue queue;
+
+    boost::posix_time::ptime begin = Now();
+    CPPUNIT_ASSERT( false == queue.Wait(50) );
+    int duration = (Now() - begin).total_milliseconds();
+    CPPUNIT_ASSERT( duration >= 50 && duration < 500 );
+
+    //  a ready file does not wake the waiter again
+    queue.Push("/a", Now());
+    CPPUNIT_ASSERT( true == queue.Wait(0) );
+    CPPUNIT_ASSERT( false == queue.Wait(50) );
+
+    //  an earlier time wakes a waiter sleeping for a later one
+    queue.Push("/b", Now() + boost::posix_time::hours(1));
+    BackupWaiter waiter(&queue);
+    boost::thread thread( boost::bind( &BackupWaiter::Run, &waiter, 2 ) );
+    boost::this_thread::sleep(boost::posix_time::milliseconds(50));
+    boost::posix_time::ptime time = Now() + boost::posix_time::milliseconds(100);
+    queue.Push("/c", time);
+    thread.join();
+
+    CPPUNIT_ASSERT( 2 == waiter.ready_.size() );
+    CPPUNIT_ASSERT( "/a" == waiter.ready_[0].first );
+    CPPUNIT_ASSERT( "/c" == waiter.ready_[1].first );
+    int latency = (waiter.ready_[1].second - time).total_milliseconds();
+    CPPUNIT_ASSERT_MESSAGE( boost::lexical_cast<string>(latency),
+            latency >= 0 && latency < 50 );
+    CPPUNIT_ASSERT( 1 == queue.Size() );
+}
+
+
+void
+BackupQueueTest::testIdleHandlers()
+{
+    //  files open without writes stay out of the queue, the ones written
+    //  lately wait for their time
+    const int count = 100 * 1000;
+    const int files = 10;
+    BackupQueue queue;
+    boost::posix_time::ptime now = Now();
+    for ( int i = 0; i < count; ++ i ) {
+        queue.Push( "/idle/" + boost::lexical_cast<string>(i),
+                now + boost::posix_time::hours(1) );
+    }
+
+    //  the old loop asked every open handler each second
+    vector<boost::shared_ptr<boost::mutex> > handlers;
+    for ( int i = 0; i < count; ++ i ) {
+        handlers.push_back( boost::shared_ptr<boost::mutex>(
+                new boost::mutex() ) );
+    }
+    boost::posix_time::ptime begin = Now();
+    int ready = 0;
+    BOOST_FOREACH( boost::shared_ptr<boost::mutex> & handler, handlers ) {
+        boost::lock_guard<boost::mutex> lock(*handler);
+        if ( Now() - now > boost::posix_time::hours(1) ) {
+            ++ ready;
+        }
+    }
+    int scan = (Now() - begin).total_microseconds();
+    CPPUNIT_ASSERT( 0 == ready );
+
+    BackupWaiter waiter(&queue);
+    boost::thread thread( boost::bind(
+            &BackupWaiter::Run, &waiter, files ) );
+
+    //  files closed after writing, ready 200 ms apart
+    vector<boost::posix_time::ptime> times;
+    now = Now();
+    for ( int i = 0; i < files; ++ i ) {
+        times.push_back( now + boost::posix_time::milliseconds(200*(i+1)) );
+        queue.Push( "/file/" + boost::lexical_cast<string>(i), times[i] );
+    }
+    thread.join();
+
+    CPPUNIT_ASSERT( files == (int)waiter.ready_.size() );
+    int latency = 0;
+    for ( int i = 0; i < files; ++ i ) {
+        CPPUNIT_ASSERT( "/file/" + boost::lexical_cast<string>(i)
+                == waiter.ready_[i].first );
+        int late = (waiter.ready_[i].second - times[i]).total_milliseconds();
+        CPPUNIT_ASSERT( late >= 0 );
+        latency = max(latency,late);
+    }
+    int duration = (Now() - now).total_milliseconds();
+
+    cout << endl << count << " idle handlers, one scan: " << scan / 1000.0
+            << " ms; " << files << " files over " << duration
+            << " ms, wakeups: " << waiter.wakeups_ << ", latency: "
+            << latency << " ms, cpu: " << waiter.time_ << " ms" << endl;
+    CPPUNIT_ASSERT_MESSAGE( boost::lexical_cast<string>(latency),
+            latency < 50 );
+    CPPUNIT_ASSERT( waiter.wakeups_ <= files + 1 );
+    CPPUNIT_ASSERT_MESSAGE( boost::lexical_cast<string>(waiter.time_),
+            waiter.time_ < 20 );
+    CPPUNIT_ASSERT( count == (int)queue.Size() );
+}
@@ -0,0 +1,298 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * BackupWriterTest.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+
+
+#include "stdafx.h"
+#include "../BackupWriter.h"
+#include "../FileOperationDelay.h"
+#include "BackupWriterTest.h"
+
+
+CPPUNIT_TEST_SUITE_REGISTRATION( BackupWriterTest );
+
+
+static const string sourceFile = "backup.source";
+static const string tapeFile0 = "backup.tape0";
+static const string tapeFile1 = "backup.tape1";
+static const size_t bufsize = 64 * 1024;
+static const int chunks = 50;
+
+
+//  A drive which stops writing after a number of writes
+class FileOperationFail : public FileOperationDelay
+{
+public:
+    FileOperationFail(const fs::path & path, int delayWrite, int writes)
+    : FileOperationDelay(path,0644,O_RDWR|O_CREAT,0,0,delayWrite),
+      writes_(writes)
+    {
+    }
+
+    bool
+    Write(off_t offset, const void * buffer, size_t bufsize, size_t & size)
+    {
+        if ( writes_ -- <= 0 ) {
+            errno = EIO;
+            return false;
+        }
+        return FileOperationDelay::Write(offset,buffer,bufsize,size);
+    }
+
+private:
+    int writes_;
+};
+
+
+//  what the drives of a copy did, in the order they did it
+struct WriteTrace
+{
+    WriteTrace() : active(0), maxActive(0), maxLead(0), slowAtFastEnd(-1)
+    {
+        writes[0] = writes[1] = 0;
+    }
+
+    boost::mutex mutex;
+    int active;
+    int maxActive;
+    int writes[2];
+    //  chunks the fast drive wrote ahead of the slow one
+    int maxLead;
+    //  chunks the slow drive had written when the fast one was done
+    int slowAtFastEnd;
+};
+
+
+//  A drive which records its writes in the trace, drive 0 is the fast one
+class FileOperationTrace : public FileOperationDelay
+{
+public:
+    FileOperationTrace(const fs::path & path, int delayWrite,
+            WriteTrace & trace, int drive, int chunks)
+    : FileOperationDelay(path,0644,O_RDWR|O_CREAT,0,0,delayWrite),
+      trace_(trace), drive_(drive), chunks_(chunks)
+    {
+    }
+
+    bool
+    Write(off_t offset, const void * buffer, size_t bufsize, size_t & size)
+    {
+        {
+            boost::lock_guard<boost::mutex> lock(trace_.mutex);
+            trace_.maxActive = max(trace_.maxActive, ++ trace_.active);
+            if ( drive_ == 0 ) {
+                trace_.maxLead = max( trace_.maxLead,
+                        trace_.writes[0] - trace_.writes[1] );
+            }
+        }
+        bool ret = FileOperationDelay::Write(offset,buffer,bufsize,size);
+        {
+            boost::lock_guard<boost::mutex> lock(trace_.mutex);
+            -- trace_.active;
+            if ( ++ trace_.writes[drive_] == chunks_ && drive_ == 0 ) {
+                trace_.slowAtFastEnd = trace_.writes[1];
+            }
+        }
+        return ret;
+    }
+
+private:
+    WriteTrace & trace_;
+    int drive_;
+    int chunks_;
+};
+
+
+static bool
+CheckCount(int & count)
+{
+    return count -- > 0;
+}
+
+
+static bool
+CheckAlways()
+{
+    return true;
+}
+
+
+static string
+ReadFile(const string & pathname)
+{
+    ifstream input(pathname.c_str(), ios::in|ios::binary);
+    return string( istreambuf_iterator<char>(input),
+            istreambuf_iterator<char>() );
+}
+
+
+void
+BackupWriterTest::setUp()
+{
+    srand(1);
+    ofstream output(sourceFile.c_str(), ios::out|ios::binary);
+    for ( size_t i = 0; i < bufsize * chunks + 1000; ++ i ) {
+        output.put( (char)rand() );
+    }
+}
+
+
+void
+BackupWriterTest::tearDown()
+{
+    fs::remove(sourceFile);
+    fs::remove(tapeFile0);
+    fs::remove(tapeFile1);
+}
+
+
+void
+BackupWriterTest::testCopy()
+{
+    //  two drives, one three times slower than the other
+    const int buffers = 8;
+    WriteTrace trace;
+    FileOperation source(sourceFile,O_RDONLY);
+    FileOperationTrace tape0(tapeFile0,5,trace,0,chunks + 1);
+    FileOperationTrace tape1(tapeFile1,15,trace,1,chunks + 1);
+    vector<FileOperationInterface *> targets;
+    targets.push_back(&tape0);
+    targets.push_back(&tape1);
+
+    BackupWriter writer(buffers,bufsize);
+    vector<bool> done;
+    vector<bool> written;
+    off_t size = 0;
+    CPPUNIT_ASSERT( true == writer.Copy( &source, targets,
+            CheckAlways, done, written, size ) );
+
+    CPPUNIT_ASSERT( (off_t)(bufsize * chunks + 1000) == size );
+    CPPUNIT_ASSERT( true == done[0] && true == done[1] );
+    CPPUNIT_ASSERT( true == written[0] && true == written[1] );
+    string data = ReadFile(sourceFile);
+    CPPUNIT_ASSERT( data == ReadFile(tapeFile0) );
+    CPPUNIT_ASSERT( data == ReadFile(tapeFile1) );
+
+    //  the drives write at the same time, the fast one runs ahead by at
+    //  most the buffers and is done before the slow one
+    CPPUNIT_ASSERT( chunks + 1 == trace.writes[0] );
+    CPPUNIT_ASSERT( chunks + 1 == trace.writes[1] );
+    CPPUNIT_ASSERT( 2 == trace.maxActive );
+    CPPUNIT_ASSERT( trace.maxLead > 1 );
+    CPPUNIT_ASSERT( trace.maxLead <= buffers );
+    CPPUNIT_ASSERT( trace.slowAtFastEnd >= chunks + 1 - buffers );
+    CPPUNIT_ASSERT( trace.slowAtFastEnd < chunks + 1 );
+
+    //  the writer is used again for the next file
+    fs::remove(tapeFile0);
+    fs::remove(tapeFile1);
+    FileOperation sourceNext(sourceFile,O_RDONLY);
+    FileOperationDelay tapeNext0(tapeFile0,0644,O_RDWR|O_CREAT,0,0,0);
+    FileOperationDelay tapeNext1(tapeFile1,0644,O_RDWR|O_CREAT,0,0,0);
+    targets.clear();
+    targets.push_back(&tapeNext0);
+    targets.push_back(&tapeNext1);
+    size = 0;
+    CPPUNIT_ASSERT( true == writer.Copy( &sourceNext, targets,
+            CheckAlways, done, written, size ) );
+    CPPUNIT_ASSERT( true == done[0] && true == done[1] );
+    CPPUNIT_ASSERT( data == ReadFile(tapeFile0) );
+    CPPUNIT_ASSERT( data == ReadFile(tapeFile1) );
+}
+
+
+void
+BackupWriterTest::testFailure()
+{
+    FileOperation source(sourceFile,O_RDONLY);
+    FileOperationFail tape0(tapeFile0,1,10);
+    FileOperationDelay tape1(tapeFile1,0644,O_RDWR|O_CREAT,0,0,1);
+    vector<FileOperationInterface *> targets;
+    targets.push_back(&tape0);
+    targets.push_back(&tape1);
+
+    BackupWriter writer(4,bufsize);
+    vector<bool> done;
+    vector<bool> written;
+    off_t size = 0;
+    CPPUNIT_ASSERT( true == writer.Copy( &source, targets,
+            CheckAlways, done, written, size ) );
+    CPPUNIT_ASSERT( false == done[0] );
+    CPPUNIT_ASSERT( true == written[0] );
+    CPPUNIT_ASSERT( true == done[1] );
+    CPPUNIT_ASSERT( ReadFile(sourceFile) == ReadFile(tapeFile1) );
+
+    //  no copy at all when every drive fails
+    fs::remove(tapeFile0);
+    fs::remove(tapeFile1);
+    FileOperationFail tape2(tapeFile0,1,0);
+    FileOperationFail tape3(tapeFile1,1,3);
+    targets.clear();
+    targets.push_back(&tape2);
+    targets.push_back(&tape3);
+    CPPUNIT_ASSERT( false == writer.Copy( &source, targets,
+            CheckAlways, done, written, size ) );
+    CPPUNIT_ASSERT( false == done[0] && false == done[1] );
+}
+
+
+void
+BackupWriterTest::testCheck()
+{
+    FileOperation source(sourceFile,O_RDONLY);
+    FileOperationDelay tape0(tapeFile0,0644,O_RDWR|O_CREAT,0,0,0);
+    FileOperationDelay tape1(tapeFile1,0644,O_RDWR|O_CREAT,0,0,0);
+    vector<FileOperationInterface *> targets;
+    targets.push_back(&tape0);
+    targets.push_back(&tape1);
+
+    //  the file changes in the middle of the backup
+    BackupWriter writer(4,bufsize);
+    vector<bool> done;
+    vector<bool> written;
+    off_t size = 0;
+    int count = 10;
+    CPPUNIT_ASSERT( false == writer.Copy( &source, targets,
+            boost::bind(CheckCount,boost::ref(count)), done, written, size ) );
+    CPPUNIT_ASSERT( false == done[0] && false == done[1] );
+    CPPUNIT_ASSERT( (off_t)(bufsize * 10) == size );
+}
+
+
+void
+BackupWriterTest::testEmpty()
+{
+    fs::remove(sourceFile);
+    ofstream(sourceFile.c_str());
+
+    FileOperation source(sourceFile,O_RDONLY);
+    FileOperationDelay tape0(tapeFile0,0644,O_RDWR|O_CREAT,0,0,0);
+    vector<FileOperationInterface *> targets(1,&tape0);
+
+    BackupWriter writer(4,bufsize);
+    vector<bool> done;
+    vector<bool> written;
+    off_t size = -1;
+    CPPUNIT_ASSERT( true == writer.Copy( &source, targets,
+            CheckAlways, done, written, size ) );
+    CPPUNIT_ASSERT( 0 == size );
+    CPPUNIT_ASSERT( true == done[0] );
+    CPPUNIT_ASSERT( false == written[0] );
+}
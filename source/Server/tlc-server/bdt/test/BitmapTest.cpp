@@ -0,0 +1,511 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * BitmapTest.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+
+#include "stdafx.h"
+#include "../Bitmap.h"
+#include "BitmapTest.h"
+
+
+CPPUNIT_TEST_SUITE_REGISTRATION( BitmapTest );
+
+
+//  keeps the length and the bitmap in memory instead of extended attributes
+class BitmapMemory : public BitmapIO
+{
+public:
+    BitmapMemory()
+    : length_(0), saves_(0), savesSynced_(0), synced_(false), failSync_(false)
+    {
+    }
+
+    bool
+    GetLength(off_t & length)
+    {
+        length = length_;
+        return true;
+    }
+
+    bool
+    SetLength(off_t length)
+    {
+        length_ = length;
+        return true;
+    }
+
+    bool
+    GetBitmap(void * buffer,int & size)
+    {
+        if ( bitmap_.empty() ) {
+            errno = ENODATA;
+            return false;
+        }
+        if ( buffer == NULL || size == 0 ) {
+            size = bitmap_.size();
+            return true;
+        }
+        if ( size < (int)bitmap_.size() ) {
+            errno = ERANGE;
+            return false;
+        }
+        size = bitmap_.size();
+        memcpy(buffer,&bitmap_[0],size);
+        return true;
+    }
+
+    bool
+    SetBitmap(const void * buffer,int size)
+    {
+        const unsigned char * p = static_cast<const unsigned char *>(buffer);
+        bitmap_.assign(p,p + size);
+        ++ saves_;
+        if ( synced_ ) {
+            ++ savesSynced_;
+        }
+        synced_ = false;
+        return true;
+    }
+
+    bool
+    SyncData()
+    {
+        if ( failSync_ ) {
+            errno = EIO;
+            return false;
+        }
+        synced_ = true;
+        return true;
+    }
+
+    off_t length_;
+    vector<unsigned char> bitmap_;
+    int saves_;
+    //  saves that came right after a sync of the data
+    int savesSynced_;
+    bool synced_;
+    bool failSync_;
+};
+
+
+static bool
+CheckModel(const vector<bool> & blocks,
+        off_t sizeBlock, off_t length, off_t offset, off_t size)
+{
+    if ( size == 0 ) {
+        return true;
+    }
+    if ( offset + size > length ) {
+        return false;
+    }
+    off_t last = (offset + size + sizeBlock - 1) / sizeBlock;
+    for ( off_t i = offset / sizeBlock; i < last; ++ i ) {
+        if ( ! blocks[i] ) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+static off_t
+GetRandom(off_t limit)
+{
+    return ( ((off_t)rand() << 31) | rand() ) % limit;
+}
+
+
+void
+BitmapTest::setUp()
+{
+}
+
+
+void
+BitmapTest::tearDown()
+{
+}
+
+
+void
+BitmapTest::testAligned()
+{
+    //  block aligned writes, the bitmap has to match the model exactly
+    const off_t sizeBlock = 1000;
+    const off_t count = 300;
+    const off_t length = sizeBlock * (count - 1) + 357;
+
+    for ( int seed = 1; seed <= 20; ++ seed ) {
+        srand(seed);
+        BitmapMemory io;
+        vector<bool> blocks(count,false);
+        auto_ptr<Bitmap> bitmap(new Bitmap(&io,sizeBlock));
+        CPPUNIT_ASSERT( true == bitmap->TruncateBitmap(length) );
+
+        int writes = 1 + rand() % 60;
+        for ( int i = 0; i < writes; ++ i ) {
+            off_t first = GetRandom(count);
+            off_t offset = first * sizeBlock;
+            off_t end = min(length, offset + (1 + GetRandom(20)) * sizeBlock);
+            bitmap->MarkBitmap(offset,end - offset);
+            for ( off_t b = first; b < end / sizeBlock; ++ b ) {
+                blocks[b] = true;
+            }
+            if ( end == length ) {
+                blocks[count - 1] = true;
+            }
+        }
+
+        for ( int i = 0; i < 2000; ++ i ) {
+            off_t offset = GetRandom(length + sizeBlock);
+            off_t size = GetRandom(sizeBlock * 8);
+            CPPUNIT_ASSERT_MESSAGE(
+                    boost::lexical_cast<string>(seed) + " " +
+                    boost::lexical_cast<string>(offset) + " " +
+                    boost::lexical_cast<string>(size),
+                    CheckModel(blocks,sizeBlock,length,offset,size)
+                    == bitmap->CheckBitmap(offset,size) );
+        }
+        bool full = CheckModel(blocks,sizeBlock,length,0,length);
+        CPPUNIT_ASSERT( full == bitmap->IsFull() );
+
+        //  the saved runs load back to the same blocks
+        bitmap.reset();
+        bitmap.reset(new Bitmap(&io));
+        size_t size = 0;
+        CPPUNIT_ASSERT( true == bitmap->GetBlockSize(size) );
+        CPPUNIT_ASSERT( sizeBlock == (off_t)size );
+        for ( off_t b = 0; b < count; ++ b ) {
+            off_t offset = b * sizeBlock;
+            CPPUNIT_ASSERT( blocks[b] == bitmap->CheckBitmap(
+                    offset, min(sizeBlock, length - offset)) );
+        }
+        CPPUNIT_ASSERT( full == bitmap->IsFull() );
+    }
+}
+
+
+void
+BitmapTest::testUnaligned()
+{
+    //  writes of any offset and size, a block may only be marked when
+    //  every byte of it was written
+    const off_t sizeBlock = 64;
+    const off_t length = sizeBlock * 400 - 10;
+    const off_t count = (length + sizeBlock - 1) / sizeBlock;
+
+    for ( int seed = 1; seed <= 20; ++ seed ) {
+        srand(seed);
+        BitmapMemory io;
+        vector<bool> bytes(length,false);
+        Bitmap bitmap(&io,sizeBlock);
+        CPPUNIT_ASSERT( true == bitmap.TruncateBitmap(length) );
+
+        off_t offset = 0;
+        for ( int i = 0; i < 500; ++ i ) {
+            if ( rand() % 3 ) {
+                //  continue the last write
+                offset = offset % length;
+            } else {
+                offset = GetRandom(length);
+            }
+            off_t size = min(length - offset, 1 + GetRandom(sizeBlock * 3));
+            bitmap.MarkBitmap(offset,size);
+            for ( off_t o = offset; o < offset + size; ++ o ) {
+                bytes[o] = true;
+            }
+            offset += size;
+        }
+
+        for ( off_t b = 0; b < count; ++ b ) {
+            off_t begin = b * sizeBlock;
+            off_t end = min(length, begin + sizeBlock);
+            if ( ! bitmap.CheckBitmap(begin,end - begin) ) {
+                continue;
+            }
+            for ( off_t o = begin; o < end; ++ o ) {
+                CPPUNIT_ASSERT_MESSAGE(
+                        boost::lexical_cast<string>(seed) + " " +
+                        boost::lexical_cast<string>(o),
+                        bytes[o] );
+            }
+        }
+
+        //  one sequential pass fills the gaps
+        for ( off_t o = 0; o < length; o += 100 ) {
+            bitmap.MarkBitmap(o,min((off_t)100,length - o));
+        }
+        CPPUNIT_ASSERT( true == bitmap.IsFull() );
+    }
+}
+
+
+void
+BitmapTest::testLegacy()
+{
+    //  a bitmap saved by an older version: the block size followed by one
+    //  bit per block
+    const unsigned long sizeBlock = 4096;
+    const off_t length = sizeBlock * 20 - 100;
+    BitmapMemory io;
+    io.length_ = length;
+    io.bitmap_.resize(sizeof(sizeBlock) + 3, 0);
+    memcpy(&io.bitmap_[0],&sizeBlock,sizeof(sizeBlock));
+    //  blocks 0 - 9, 12 and 19
+    io.bitmap_[sizeof(sizeBlock) + 0] = 0xff;
+    io.bitmap_[sizeof(sizeBlock) + 1] = 0x13;
+    io.bitmap_[sizeof(sizeBlock) + 2] = 0x08;
+    const bool expect[] = {
+        true, true, true, true, true, true, true, true, true, true,
+        false, false, true, false, false, false, false, false, false, true,
+    };
+
+    for ( int round = 0; round < 2; ++ round ) {
+        Bitmap bitmap(&io);
+        size_t size = 0;
+        CPPUNIT_ASSERT( true == bitmap.GetBlockSize(size) );
+        CPPUNIT_ASSERT( sizeBlock == size );
+        for ( int b = 0; b < 20; ++ b ) {
+            off_t offset = b * sizeBlock;
+            CPPUNIT_ASSERT_MESSAGE(
+                    boost::lexical_cast<string>(round) + " " +
+                    boost::lexical_cast<string>(b),
+                    expect[b] == bitmap.CheckBitmap(
+                            offset, min((off_t)sizeBlock, length - offset)) );
+        }
+        CPPUNIT_ASSERT( true == bitmap.CheckBitmap(0, sizeBlock * 10) );
+        CPPUNIT_ASSERT( false == bitmap.CheckBitmap(0, sizeBlock * 10 + 1) );
+        CPPUNIT_ASSERT( false == bitmap.IsFull() );
+    }
+
+    //  saved again as runs
+    unsigned long head = 0;
+    memcpy(&head,&io.bitmap_[0],sizeof(head));
+    CPPUNIT_ASSERT( sizeBlock != head );
+    CPPUNIT_ASSERT( io.bitmap_.size() < sizeof(sizeBlock) * 2 + 8 );
+}
+
+
+void
+BitmapTest::testLarge()
+{
+    //  1TB in 64KB blocks needs 2MB as a plain bitmap
+    const off_t sizeBlock = 64 * 1024;
+    const off_t length = 1024LL * 1024 * 1024 * 1024;
+    const off_t chunk = 1024LL * 1024 * 1024;
+    BitmapMemory io;
+
+    {
+        Bitmap bitmap(&io,sizeBlock);
+        CPPUNIT_ASSERT( true == bitmap.TruncateBitmap(length) );
+        for ( off_t o = 0; o < length; o += chunk * 2 ) {
+            bitmap.MarkBitmap(o,chunk);
+        }
+        CPPUNIT_ASSERT( false == bitmap.IsFull() );
+    }
+
+    {
+        Bitmap bitmap(&io);
+        CPPUNIT_ASSERT( length == io.length_ );
+        for ( off_t o = 0; o < length; o += chunk ) {
+            bool expect = (o / chunk) % 2 == 0;
+            CPPUNIT_ASSERT( expect == bitmap.CheckBitmap(o,chunk) );
+            CPPUNIT_ASSERT( false == bitmap.CheckBitmap(o,chunk * 2) );
+        }
+        for ( off_t o = chunk; o < length; o += chunk * 2 ) {
+            bitmap.MarkBitmap(o,chunk);
+        }
+        CPPUNIT_ASSERT( true == bitmap.IsFull() );
+    }
+
+    {
+        Bitmap bitmap(&io);
+        CPPUNIT_ASSERT( true == bitmap.IsFull() );
+        CPPUNIT_ASSERT( true == bitmap.CheckBitmap(length - 1,1) );
+        CPPUNIT_ASSERT( false == bitmap.CheckBitmap(length - 1,2) );
+        CPPUNIT_ASSERT( io.bitmap_.size() < 32 );
+    }
+}
+
+
+void
+BitmapTest::testSave()
+{
+    const off_t sizeBlock = 1024;
+    BitmapMemory io;
+
+    {
+        //  by count, writes inside a block are not saved at all
+        Bitmap bitmap(&io,sizeBlock,4,0);
+        CPPUNIT_ASSERT( true == bitmap.TruncateBitmap(sizeBlock * 100) );
+        int saves = io.saves_;
+        int savesSynced = io.savesSynced_;
+        for ( off_t o = 0; o < sizeBlock * 10; o += 256 ) {
+            bitmap.MarkBitmap(o,256);
+            CPPUNIT_ASSERT( saves + (o + 256) / (sizeBlock * 4)
+                    == io.saves_ );
+            //  every batch is saved behind a sync of its data
+            CPPUNIT_ASSERT( io.saves_ - saves
+                    == io.savesSynced_ - savesSynced );
+        }
+
+        //  the saved bitmap lags at most 3 blocks behind
+        Bitmap saved(&io);
+        CPPUNIT_ASSERT( true == saved.CheckBitmap(0,sizeBlock * 8) );
+        CPPUNIT_ASSERT( false == saved.CheckBitmap(0,sizeBlock * 9) );
+        CPPUNIT_ASSERT( true == bitmap.CheckBitmap(0,sizeBlock * 10) );
+    }
+
+    {
+        //  everything is saved on close
+        Bitmap saved(&io);
+        CPPUNIT_ASSERT( true == saved.CheckBitmap(0,sizeBlock * 10) );
+        CPPUNIT_ASSERT( false == saved.CheckBitmap(0,sizeBlock * 11) );
+    }
+
+    {
+        //  by time
+        Bitmap bitmap(&io,sizeBlock,0,50);
+        int saves = io.saves_;
+        bitmap.MarkBitmap(sizeBlock * 10,sizeBlock);
+        bitmap.MarkBitmap(sizeBlock * 11,sizeBlock);
+        CPPUNIT_ASSERT( saves == io.saves_ );
+        boost::this_thread::sleep(boost::posix_time::milliseconds(60));
+        bitmap.MarkBitmap(sizeBlock * 12,sizeBlock);
+        CPPUNIT_ASSERT( saves + 1 == io.saves_ );
+        bitmap.MarkBitmap(sizeBlock * 13,sizeBlock);
+        CPPUNIT_ASSERT( saves + 1 == io.saves_ );
+
+        Bitmap saved(&io);
+        CPPUNIT_ASSERT( true == saved.CheckBitmap(0,sizeBlock * 13) );
+        CPPUNIT_ASSERT( false == saved.CheckBitmap(0,sizeBlock * 14) );
+    }
+
+    {
+        //  a failed sync keeps the batch pending
+        Bitmap bitmap(&io,sizeBlock,2,0);
+        int saves = io.saves_;
+        int savesSynced = io.savesSynced_;
+        io.failSync_ = true;
+        bitmap.MarkBitmap(sizeBlock * 20,sizeBlock * 2);
+        CPPUNIT_ASSERT( saves == io.saves_ );
+        io.failSync_ = false;
+        bitmap.MarkBitmap(sizeBlock * 22,sizeBlock);
+        CPPUNIT_ASSERT( saves + 1 == io.saves_ );
+        CPPUNIT_ASSERT( savesSynced + 1 == io.savesSynced_ );
+
+        Bitmap saved(&io);
+        CPPUNIT_ASSERT( true == saved.CheckBitmap(sizeBlock * 20,sizeBlock * 3) );
+    }
+
+    {
+        //  saving every change needs no sync
+        Bitmap bitmap(&io,sizeBlock);
+        int savesSynced = io.savesSynced_;
+        bitmap.MarkBitmap(sizeBlock * 30,sizeBlock);
+        CPPUNIT_ASSERT( savesSynced == io.savesSynced_ );
+    }
+}
+
+
+void
+BitmapTest::testCheckSpeed()
+{
+    const off_t sizeBlock = 64 * 1024;
+    const off_t length = 1024LL * 1024 * 1024 * 1024;
+    const off_t count = length / sizeBlock;
+    srand(1);
+
+    //  random recalls of 64KB to 4MB fill about half of the file
+    Bitmap bitmap(NULL,sizeBlock);
+    CPPUNIT_ASSERT( true == bitmap.TruncateBitmap(length) );
+    vector<bool> blocks(count,false);
+    off_t marked = 0;
+    int writes = 0;
+    while ( marked < count / 2 ) {
+        off_t first = GetRandom(count);
+        off_t last = min(count, first + 1 + GetRandom(64));
+        bitmap.MarkBitmap(first * sizeBlock,(last - first) * sizeBlock);
+        for ( off_t b = first; b < last; ++ b ) {
+            if ( ! blocks[b] ) {
+                blocks[b] = true;
+                ++ marked;
+            }
+        }
+        ++ writes;
+    }
+
+    const int checks = 1000 * 1000;
+    vector<off_t> offsets;
+    vector<off_t> sizes;
+    for ( int i = 0; i < checks; ++ i ) {
+        offsets.push_back(GetRandom(length));
+        sizes.push_back(1 + GetRandom(1024 * 1024));
+    }
+
+    int found = 0;
+    boost::posix_time::ptime begin =
+            boost::posix_time::microsec_clock::local_time();
+    for ( int i = 0; i < checks; ++ i ) {
+        if ( bitmap.CheckBitmap(offsets[i],sizes[i]) ) {
+            ++ found;
+        }
+    }
+    double random = (boost::posix_time::microsec_clock::local_time()
+            - begin).total_microseconds() * 1000.0 / checks;
+
+    int expect = 0;
+    for ( int i = 0; i < checks; ++ i ) {
+        if ( CheckModel(blocks,sizeBlock,length,offsets[i],sizes[i]) ) {
+            ++ expect;
+        }
+    }
+    CPPUNIT_ASSERT( expect == found );
+
+    //  a whole file check, all present but the last block
+    Bitmap full(NULL,sizeBlock);
+    CPPUNIT_ASSERT( true == full.TruncateBitmap(length) );
+    full.MarkBitmap(0,length - sizeBlock);
+    vector<bool> fullBlocks(count,true);
+    fullBlocks[count - 1] = false;
+
+    const int rounds = 1000;
+    begin = boost::posix_time::microsec_clock::local_time();
+    for ( int i = 0; i < rounds; ++ i ) {
+        CPPUNIT_ASSERT( false == full.CheckBitmap(0,length) );
+    }
+    double whole = (boost::posix_time::microsec_clock::local_time()
+            - begin).total_microseconds() * 1000.0 / rounds;
+
+    //  testing the bits one at a time
+    const int roundsBits = 5;
+    begin = boost::posix_time::microsec_clock::local_time();
+    for ( int i = 0; i < roundsBits; ++ i ) {
+        CPPUNIT_ASSERT( false ==
+                CheckModel(fullBlocks,sizeBlock,length,0,length) );
+    }
+    double wholeBits = (boost::posix_time::microsec_clock::local_time()
+            - begin).total_microseconds() * 1000.0 / roundsBits;
+
+    cout << endl << "1TB in " << count << " blocks, " << writes
+            << " random writes, CheckBitmap of up to 1MB: " << random
+            << " ns, whole file: " << whole << " ns, bit by bit: "
+            << wholeBits << " ns" << endl;
+    CPPUNIT_ASSERT( whole * 100 < wholeBits );
+}
@@ -0,0 +1,221 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * CacheCapacityTest.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+
+#include "stdafx.h"
+#include "../CacheCapacity.h"
+#include "../FileOperation.h"
+#include "CacheCapacityTest.h"
+
+
+CPPUNIT_TEST_SUITE_REGISTRATION( CacheCapacityTest );
+
+
+static const fs::path folder("CacheCapacityTest.folder");
+
+static const off_t MB = 1024 * 1024;
+
+
+static off_t
+GetFree()
+{
+    struct statfs stat;
+    CPPUNIT_ASSERT( 0 == statfs(folder.string().c_str(), &stat) );
+    return (off_t)stat.f_bsize * stat.f_bfree;
+}
+
+
+static off_t
+GetAllocated(const fs::path & path)
+{
+    struct stat stat;
+    CPPUNIT_ASSERT( 0 == ::stat(path.string().c_str(), &stat) );
+    return (off_t)stat.st_blocks * 512;
+}
+
+
+//  writes files the way the cache does, checking the capacity before and
+//  reserving after every write
+static void
+WriteFiles(CacheCapacity * capacity, int id, int files, off_t size,
+        size_t chunk, bool reserve)
+{
+    vector<char> buffer(chunk,'C');
+    for ( int i = 0; i < files; ++ i ) {
+        fs::path path = folder / ( boost::lexical_cast<string>(id) + "."
+                + boost::lexical_cast<string>(i) );
+        FileOperation file(path,0644,O_WRONLY);
+        for ( off_t o = 0; o < size; o += chunk ) {
+            off_t usedCapacity,freeCapacity;
+            CPPUNIT_ASSERT( true ==
+                    capacity->GetCapacity(usedCapacity,freeCapacity) );
+            size_t written = 0;
+            CPPUNIT_ASSERT( true ==
+                    file.Write(o,&buffer[0],chunk,written) );
+            if ( reserve ) {
+                capacity->Reserve(written);
+            }
+        }
+    }
+}
+
+
+void
+CacheCapacityTest::setUp()
+{
+    fs::create_directory(folder);
+}
+
+
+void
+CacheCapacityTest::tearDown()
+{
+    fs::remove_all(folder);
+}
+
+
+void
+CacheCapacityTest::testEstimate()
+{
+    //  no periodic sync during the test, only the reservations count
+    CacheCapacity capacity(folder, 3600 * 1000, 0);
+    off_t usedCapacity,freeCapacity;
+    CPPUNIT_ASSERT( true == capacity.GetCapacity(usedCapacity,freeCapacity) );
+    off_t freeBefore = freeCapacity;
+
+    const int threads = 8;
+    const int files = 8;
+    const off_t size = 4 * MB;
+    boost::thread_group group;
+    for ( int i = 0; i < threads; ++ i ) {
+        group.create_thread( boost::bind( &WriteFiles,
+                &capacity, i, files, size, 64 * 1024, true ) );
+    }
+    group.join_all();
+    sync();
+
+    const off_t written = threads * files * size;
+    CPPUNIT_ASSERT( true == capacity.GetCapacity(usedCapacity,freeCapacity) );
+    CPPUNIT_ASSERT( freeBefore - written == freeCapacity );
+    off_t freeReal = GetFree();
+    off_t diff = freeCapacity > freeReal ?
+            freeCapacity - freeReal : freeReal - freeCapacity;
+    cout << endl << written / MB << " MB written by " << threads
+            << " threads, estimate off statfs by " << diff / 1024 << " KB"
+            << endl;
+    CPPUNIT_ASSERT( diff < written / 20 + 4 * MB );
+
+    //  purge half of the files
+    for ( int i = 0; i < threads; ++ i ) {
+        for ( int j = 0; j < files / 2; ++ j ) {
+            fs::path path = folder / ( boost::lexical_cast<string>(i) + "."
+                    + boost::lexical_cast<string>(j) );
+            off_t allocated = GetAllocated(path);
+            fs::remove(path);
+            capacity.Release(allocated);
+        }
+    }
+    sync();
+
+    CPPUNIT_ASSERT( true == capacity.GetCapacity(usedCapacity,freeCapacity) );
+    freeReal = GetFree();
+    diff = freeCapacity > freeReal ?
+            freeCapacity - freeReal : freeReal - freeCapacity;
+    CPPUNIT_ASSERT( diff < written / 20 + 4 * MB );
+}
+
+
+void
+CacheCapacityTest::testThreshold()
+{
+    const off_t slack = 256 * MB;
+    off_t usedCapacity,freeCapacity;
+
+    //  far from any threshold the space used behind its back is not seen
+    CacheCapacity far(folder, 3600 * 1000, slack);
+    CPPUNIT_ASSERT( true == far.GetCapacity(usedCapacity,freeCapacity) );
+    off_t freeFar = freeCapacity;
+
+    //  near a threshold every call asks the file system
+    CacheCapacity near(folder, 3600 * 1000, slack);
+    near.AddThreshold(GetFree());
+    CPPUNIT_ASSERT( true == near.GetCapacity(usedCapacity,freeCapacity) );
+    off_t freeNear = freeCapacity;
+
+    CacheCapacity dummy(folder, 0, 0);
+    WriteFiles(&dummy, 0, 1, 32 * MB, MB, false);
+    sync();
+
+    CPPUNIT_ASSERT( true == far.GetCapacity(usedCapacity,freeCapacity) );
+    CPPUNIT_ASSERT( freeFar == freeCapacity );
+    CPPUNIT_ASSERT( true == near.GetCapacity(usedCapacity,freeCapacity) );
+    CPPUNIT_ASSERT_MESSAGE(
+            boost::lexical_cast<string>(freeNear - freeCapacity),
+            freeNear - freeCapacity > 16 * MB );
+
+    //  reservations that bring the estimate close to a threshold make the
+    //  next call check the real value
+    CacheCapacity reserved(folder, 3600 * 1000, slack);
+    CPPUNIT_ASSERT( true == reserved.GetCapacity(usedCapacity,freeCapacity) );
+    off_t freeReserved = freeCapacity;
+    reserved.AddThreshold(freeReserved - 2 * slack);
+    reserved.Reserve(slack / 2);
+    CPPUNIT_ASSERT( true == reserved.GetCapacity(usedCapacity,freeCapacity) );
+    CPPUNIT_ASSERT( freeReserved - slack / 2 == freeCapacity );
+    reserved.Reserve(slack);
+    CPPUNIT_ASSERT( true == reserved.GetCapacity(usedCapacity,freeCapacity) );
+    CPPUNIT_ASSERT( freeCapacity > freeReserved - slack / 2 );
+}
+
+
+void
+CacheCapacityTest::testSmallWrite()
+{
+    const int count = 50 * 1000;
+    const size_t chunk = 4096;
+    double rates[2];
+    double calls[2];
+
+    for ( int cached = 0; cached < 2; ++ cached ) {
+        //  interval 0 asks statfs on every call like before
+        CacheCapacity capacity(folder, cached ? 1000 : 0, 0);
+        boost::posix_time::ptime begin =
+                boost::posix_time::microsec_clock::local_time();
+        WriteFiles(&capacity, cached, 1, count * chunk, chunk, true);
+        int duration = (boost::posix_time::microsec_clock::local_time()
+                - begin).total_milliseconds();
+        rates[cached] = count * 1000.0 / max(duration, 1);
+
+        begin = boost::posix_time::microsec_clock::local_time();
+        for ( int i = 0; i < count; ++ i ) {
+            off_t usedCapacity,freeCapacity;
+            capacity.GetCapacity(usedCapacity,freeCapacity);
+        }
+        calls[cached] = (boost::posix_time::microsec_clock::local_time()
+                - begin).total_microseconds() * 1000.0 / count;
+    }
+
+    cout << endl << count << " writes of " << chunk << " bytes, statfs every"
+            << " write: " << (int)rates[0] << " writes/s ("
+            << (int)calls[0] << " ns per check), estimated: "
+            << (int)rates[1] << " writes/s (" << (int)calls[1]
+            << " ns per check)" << endl;
+    CPPUNIT_ASSERT( calls[1] * 2 < calls[0] );
+}
@@ -0,0 +1,269 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * CacheNumberTest.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+
+
+#include "stdafx.h"
+#include "../CacheNumber.h"
+#include "../CacheManager.h"
+#include "CacheNumberTest.h"
+#include <sys/wait.h>
+
+
+CPPUNIT_TEST_SUITE_REGISTRATION( CacheNumberTest );
+
+
+static const string journalFile = "number.journal";
+static const string cacheFolder = "cache.folder";
+
+
+static size_t
+GetLineCount(const string & pathname)
+{
+    ifstream input(pathname.c_str());
+    size_t count = 0;
+    string line;
+    while ( getline(input,line) ) {
+        ++ count;
+    }
+    return count;
+}
+
+
+//  A child creates cache files until it is killed, the numbers it got are
+//  reported through a pipe
+static vector<unsigned long long>
+CreateAndKill()
+{
+    int fds[2];
+    CPPUNIT_ASSERT( 0 == pipe(fds) );
+    pid_t pid = fork();
+    CPPUNIT_ASSERT( pid >= 0 );
+    if ( pid == 0 ) {
+        close(fds[0]);
+        Factory::CreateCacheManager();
+        CacheManager * cache = Factory::GetCacheManager();
+        while ( true ) {
+            unsigned long long number;
+            if ( ! cache->CreateNewFile(number) ) {
+                _exit(1);
+            }
+            if ( write(fds[1],&number,sizeof(number)) != sizeof(number) ) {
+                _exit(1);
+            }
+        }
+    }
+
+    close(fds[1]);
+    vector<unsigned long long> numbers;
+    unsigned long long number = 0;
+    CPPUNIT_ASSERT( (ssize_t)sizeof(number)
+            == read(fds[0],&number,sizeof(number)) );
+    numbers.push_back(number);
+    usleep(rand() % 20000);
+    kill(pid,SIGKILL);
+    int status = 0;
+    waitpid(pid,&status,0);
+    CPPUNIT_ASSERT( WIFSIGNALED(status) );
+
+    while ( read(fds[0],&number,sizeof(number)) == sizeof(number) ) {
+        numbers.push_back(number);
+    }
+    close(fds[0]);
+    return numbers;
+}
+
+
+void
+CacheNumberTest::setUp()
+{
+    fs::remove(journalFile);
+    fs::create_directory(cacheFolder);
+    Factory::SetCacheFolder(cacheFolder);
+}
+
+
+void
+CacheNumberTest::tearDown()
+{
+    fs::remove(journalFile);
+    fs::remove_all(cacheFolder);
+}
+
+
+void
+CacheNumberTest::testReserve()
+{
+    CacheNumber numbers(journalFile, 100);
+    CPPUNIT_ASSERT( true == numbers.IsEmpty() );
+    CPPUNIT_ASSERT( true == numbers.Reset(10) );
+    CPPUNIT_ASSERT( false == numbers.IsEmpty() );
+
+    unsigned long long number = 0;
+    for ( unsigned long long i = 11; i <= 250; ++ i ) {
+        CPPUNIT_ASSERT( true == numbers.Next(number) );
+        CPPUNIT_ASSERT( i == number );
+    }
+    //  the reset and three ranges of 100
+    CPPUNIT_ASSERT( 4 == GetLineCount(journalFile) );
+
+    //  a number taken by the caller inside the range costs no record
+    CPPUNIT_ASSERT( true == numbers.Use(300) );
+    CPPUNIT_ASSERT( true == numbers.Use(200) );
+    CPPUNIT_ASSERT( 4 == GetLineCount(journalFile) );
+    CPPUNIT_ASSERT( true == numbers.Next(number) );
+    CPPUNIT_ASSERT( 301 == number );
+
+    CPPUNIT_ASSERT( true == numbers.Use(1000) );
+    CPPUNIT_ASSERT( 5 == GetLineCount(journalFile) );
+    CPPUNIT_ASSERT( true == numbers.Next(number) );
+    CPPUNIT_ASSERT( 1001 == number );
+}
+
+
+void
+CacheNumberTest::testRestart()
+{
+    unsigned long long number = 0;
+    {
+        CacheNumber numbers(journalFile, 100);
+        CPPUNIT_ASSERT( true == numbers.Reset(0) );
+        for ( int i = 0; i < 5; ++ i ) {
+            CPPUNIT_ASSERT( true == numbers.Next(number) );
+        }
+    }
+
+    //  a clean shutdown hands back the rest of the range
+    {
+        CacheNumber numbers(journalFile, 100);
+        CPPUNIT_ASSERT( false == numbers.IsEmpty() );
+        CPPUNIT_ASSERT( true == numbers.Next(number) );
+        CPPUNIT_ASSERT( 6 == number );
+    }
+
+    //  a record cut short by a crash is ignored, the range before it is not
+    //  handed back
+    {
+        ofstream output(journalFile.c_str(), ios::out|ios::app);
+        output << "100";
+    }
+    CacheNumber numbers(journalFile, 100);
+    CPPUNIT_ASSERT( false == numbers.IsEmpty() );
+    CPPUNIT_ASSERT( true == numbers.Next(number) );
+    CPPUNIT_ASSERT( 7 == number );
+}
+
+
+void
+CacheNumberTest::testCompact()
+{
+    unsigned long long number = 0;
+    {
+        CacheNumber numbers(journalFile, 1);
+        CPPUNIT_ASSERT( true == numbers.Reset(0) );
+        for ( int i = 0; i < 5000; ++ i ) {
+            CPPUNIT_ASSERT( true == numbers.Next(number) );
+        }
+    }
+    CPPUNIT_ASSERT( GetLineCount(journalFile) < 2000 );
+
+    CacheNumber numbers(journalFile, 1);
+    CPPUNIT_ASSERT( true == numbers.Next(number) );
+    CPPUNIT_ASSERT( 5001 == number );
+}
+
+
+void
+CacheNumberTest::testCrash()
+{
+    srand(1);
+    set<unsigned long long> used;
+    unsigned long long last = 0;
+    int lost = 0;
+    for ( int round = 0; round < 20; ++ round ) {
+        vector<unsigned long long> numbers = CreateAndKill();
+        CPPUNIT_ASSERT( false == numbers.empty() );
+        BOOST_FOREACH( unsigned long long number, numbers ) {
+            CPPUNIT_ASSERT_MESSAGE( boost::lexical_cast<string>(number),
+                    number > last );
+            CPPUNIT_ASSERT( used.insert(number).second );
+            last = number;
+        }
+
+        //  the next start continues behind everything handed out
+        Factory::CreateCacheManager();
+        unsigned long long number = 0;
+        CPPUNIT_ASSERT( true == Factory::GetCacheManager()->CreateNewFile(
+                number ) );
+        CPPUNIT_ASSERT_MESSAGE( boost::lexical_cast<string>(number) + " "
+                + boost::lexical_cast<string>(last), number > last );
+        CPPUNIT_ASSERT( used.insert(number).second );
+        lost += number - last - 1;
+        last = number;
+        Factory::ReleaseCacheManager();
+    }
+    cout << endl << used.size() << " numbers in 20 crashes, "
+            << lost << " skipped" << endl;
+}
+
+
+void
+CacheNumberTest::testShared()
+{
+    //  the scan of vfsserver opens the journal of the running vfsclient,
+    //  it hands back nothing the client reserved after it
+    unsigned long long number = 0;
+    {
+        CacheNumber client(journalFile, 100);
+        CPPUNIT_ASSERT( true == client.Reset(0) );
+        {
+            CacheNumber scan(journalFile, 100);
+            CPPUNIT_ASSERT( false == scan.IsEmpty() );
+            for ( int i = 0; i < 150; ++ i ) {
+                CPPUNIT_ASSERT( true == client.Next(number) );
+            }
+        }
+        CPPUNIT_ASSERT( 3 == GetLineCount(journalFile) );
+
+        //  started while the client runs, or after it crashed
+        CacheNumber restart(journalFile, 100);
+        CPPUNIT_ASSERT( true == restart.Next(number) );
+        CPPUNIT_ASSERT_MESSAGE( boost::lexical_cast<string>(number),
+                number > 200 );
+    }
+
+    //  both reserve and compact the same journal
+    set<unsigned long long> used;
+    {
+        CacheNumber first(journalFile, 1);
+        CacheNumber second(journalFile, 3);
+        for ( int i = 0; i < 3000; ++ i ) {
+            CPPUNIT_ASSERT( true == first.Next(number) );
+            CPPUNIT_ASSERT( used.insert(number).second );
+            CPPUNIT_ASSERT( true == second.Next(number) );
+            CPPUNIT_ASSERT( used.insert(number).second );
+        }
+    }
+    CPPUNIT_ASSERT( GetLineCount(journalFile) < 2000 );
+
+    CacheNumber numbers(journalFile, 1);
+    CPPUNIT_ASSERT( true == numbers.Next(number) );
+    CPPUNIT_ASSERT( number > * used.rbegin() );
+}
@@ -0,0 +1,45 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * CacheNumberTest.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+
+
+#pragma once
+
+
+class CacheNumberTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE( CacheNumberTest );
+    CPPUNIT_TEST( testReserve );
+    CPPUNIT_TEST( testRestart );
+    CPPUNIT_TEST( testCompact );
+    CPPUNIT_TEST( testCrash );
+    CPPUNIT_TEST( testShared );
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void setUp();
+    void tearDown();
+
+    void testReserve();
+    void testRestart();
+    void testCompact();
+    void testCrash();
+    void testShared();
+};
@@ -0,0 +1,433 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * CatalogJournalTest.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+
+
+
+#include "stdafx.h"
+#include "../CatalogJournal.h"
+#include "CatalogJournalTest.h"
+
+
+CPPUNIT_TEST_SUITE_REGISTRATION( CatalogJournalTest );
+
+
+static const fs::path folder("/tmp/bdt-catalog-journal");
+static const fs::path pathname(folder / "catalog.journal");
+
+
+//  The catalog as files and their copies on the tapes. It may be down, and
+//  it may apply a record but fail to say so, like a commit whose answer is
+//  lost with the connection.
+class CatalogSimulator : public CatalogApplierInterface
+{
+public:
+    CatalogSimulator()
+    : down_(false), lost_(0), sequence_(0), records_(0), again_(0),
+      disorder_(0)
+    {
+    }
+
+    virtual size_t
+    Apply(const vector<CatalogRecord> & records)
+    {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+        if ( down_ ) {
+            return 0;
+        }
+        const CatalogRecord & record = records[0];
+        if ( record.sequence == sequence_ ) {
+            ++ again_;
+        } else if ( record.sequence != sequence_ + 1 ) {
+            ++ disorder_;
+        }
+        sequence_ = record.sequence;
+        ++ records_;
+        Change(record);
+        if ( lost_ > 0 && rand() % lost_ == 0 ) {
+            return 0;
+        }
+        return 1;
+    }
+
+    void
+    Change(const CatalogRecord & record)
+    {
+        const vector<string> & values = record.values;
+        switch ( record.type ) {
+        case CatalogRecord::TypeAddFiles:
+            for ( size_t i = 0; i + 6 < values.size(); i += 7 ) {
+                files_[values[i+1]] = values[i+2];
+                copies_[values[i+1] + "@" + values[i]] = values[i+3];
+            }
+            break;
+        case CatalogRecord::TypeDeleteFile:
+            Delete(values[0]);
+            break;
+        case CatalogRecord::TypeDeleteFolder:
+            for ( map<string,string>::iterator i = files_.begin();
+                    i != files_.end(); ) {
+                string number = (i ++)->first;
+                if ( boost::starts_with(files_[number], values[0] + "/") ) {
+                    Delete(number);
+                }
+            }
+            break;
+        case CatalogRecord::TypeRenameFile:
+            if ( files_.find(values[0]) != files_.end() ) {
+                files_[values[0]] = values[1];
+            }
+            break;
+        case CatalogRecord::TypeRenameFolder:
+            for ( map<string,string>::iterator i = files_.begin();
+                    i != files_.end(); ++ i ) {
+                if ( boost::starts_with(i->second, values[0] + "/") ) {
+                    i->second = values[1]
+                            + i->second.substr(values[0].size());
+                }
+            }
+            break;
+        }
+    }
+
+    void
+    Delete(const string & number)
+    {
+        files_.erase(number);
+        copies_.erase(copies_.lower_bound(number + "@"),
+                copies_.lower_bound(number + "A"));
+    }
+
+    void
+    SetDown(bool down)
+    {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+        down_ = down;
+    }
+
+    boost::mutex mutex_;
+    bool down_;
+    int lost_;
+    unsigned long long sequence_;
+    int records_;
+    int again_;
+    int disorder_;
+    map<string,string> files_;
+    map<string,string> copies_;
+};
+
+
+//  a backup batch now and then a rename or delete, as the shares do
+static void
+MakeRecord(int i, CatalogRecord & record)
+{
+    string folder = "/f" + boost::lexical_cast<string>(rand() % 20);
+    string number = boost::lexical_cast<string>(rand() % (i + 1) + 1);
+    record.share = "share";
+    record.values.clear();
+    switch ( rand() % 10 ) {
+    case 0:
+        record.type = CatalogRecord::TypeRenameFile;
+        record.values.push_back(number);
+        record.values.push_back(folder + "/r" + number);
+        break;
+    case 1:
+        record.type = CatalogRecord::TypeRenameFolder;
+        record.values.push_back(folder);
+        record.values.push_back("/f" + boost::lexical_cast<string>(rand() % 20));
+        break;
+    case 2:
+        record.type = CatalogRecord::TypeDeleteFile;
+        record.values.push_back(number);
+        break;
+    case 3:
+        if ( rand() % 10 == 0 ) {
+            record.type = CatalogRecord::TypeDeleteFolder;
+            record.values.push_back(folder);
+            break;
+        }
+    default:
+        record.type = CatalogRecord::TypeAddFiles;
+        for ( int j = 0; j < 10; ++ j ) {
+            string file = boost::lexical_cast<string>(i * 10 + j + 1);
+            for ( int k = 0; k < 2; ++ k ) {
+                record.values.push_back("tape" + boost::lexical_cast<string>(k));
+                record.values.push_back(file);
+                record.values.push_back(folder + "/" + file);
+                record.values.push_back(boost::lexical_cast<string>(rand()));
+                record.values.push_back("1024");
+                record.values.push_back("");
+                record.values.push_back("0");
+            }
+        }
+        break;
+    }
+}
+
+
+static void
+Append(CatalogJournal * journal, int count, int * failed)
+{
+    CatalogRecord record;
+    record.type = CatalogRecord::TypeDeleteFile;
+    record.share = "share";
+    for ( int i = 0; i < count; ++ i ) {
+        record.values.assign(1, boost::lexical_cast<string>(i));
+        if ( ! journal->Append(record) ) {
+            ++ *failed;
+        }
+    }
+}
+
+
+void
+CatalogJournalTest::setUp()
+{
+    fs::remove_all(folder);
+    fs::create_directories(folder);
+}
+
+
+void
+CatalogJournalTest::tearDown()
+{
+    fs::remove_all(folder);
+}
+
+
+void
+CatalogJournalTest::testOutage()
+{
+    const int count = 3000;
+    CatalogSimulator catalog;
+    CatalogSimulator expect;
+    catalog.lost_ = 200;
+    srand(1);
+
+    auto_ptr<CatalogJournal> journal(
+            new CatalogJournal(pathname, &catalog, 3600) );
+    for ( int i = 0; i < count; ++ i ) {
+        CatalogRecord record;
+        MakeRecord(i,record);
+        CPPUNIT_ASSERT( journal->Append(record) );
+        expect.Change(record);
+
+        //  two outages, the backup goes on and the server restarts during
+        //  the second one
+        if ( i == 500 || i == 1500 ) {
+            catalog.SetDown(true);
+        } else if ( i == 1000 || i == 2500 ) {
+            catalog.SetDown(false);
+        } else if ( i == 2000 ) {
+            CPPUNIT_ASSERT( journal->GetPending() > 0 );
+            journal.reset();
+            journal.reset( new CatalogJournal(pathname, &catalog, 3600) );
+            CPPUNIT_ASSERT( journal->GetPending() > 0 );
+        }
+    }
+    CPPUNIT_ASSERT( journal->Flush(60 * 1000) );
+    CPPUNIT_ASSERT( 0 == journal->GetPending() );
+
+    cout << endl << count << " changes, " << catalog.records_
+            << " applied, " << catalog.again_ << " applied again" << endl;
+    CPPUNIT_ASSERT( 0 == catalog.disorder_ );
+    CPPUNIT_ASSERT( catalog.again_ > 0 );
+    CPPUNIT_ASSERT( count == (int)catalog.sequence_ );
+    CPPUNIT_ASSERT( expect.files_.size() > 0 );
+    CPPUNIT_ASSERT( expect.files_ == catalog.files_ );
+    CPPUNIT_ASSERT( expect.copies_ == catalog.copies_ );
+
+    //  nothing is applied again after a restart once all of it is applied
+    int records = catalog.records_;
+    journal.reset( new CatalogJournal(pathname, &catalog, 3600) );
+    CPPUNIT_ASSERT( 0 == journal->GetPending() );
+    CPPUNIT_ASSERT( journal->Flush(1000) );
+    CPPUNIT_ASSERT( records == catalog.records_ );
+}
+
+
+void
+CatalogJournalTest::testIncomplete()
+{
+    CatalogSimulator catalog;
+    catalog.SetDown(true);
+    CatalogRecord record;
+    record.type = CatalogRecord::TypeRenameFile;
+    record.share = "share";
+    record.values.push_back("1");
+    record.values.push_back("/a");
+
+    auto_ptr<CatalogJournal> journal(
+            new CatalogJournal(pathname, &catalog, 3600) );
+    for ( int i = 0; i < 10; ++ i ) {
+        CPPUNIT_ASSERT( journal->Append(record) );
+    }
+    journal.reset();
+
+    //  a crash in the middle of a write
+    off_t size = fs::file_size(pathname);
+    {
+        ofstream output(pathname.string().c_str(), ios::out|ios::app|ios::binary);
+        output.write("\x40\x00\x00\x00\x01\x02", 6);
+    }
+    CPPUNIT_ASSERT( size + 6 == (off_t)fs::file_size(pathname) );
+
+    journal.reset( new CatalogJournal(pathname, &catalog, 3600) );
+    CPPUNIT_ASSERT( 10 == journal->GetPending() );
+    CPPUNIT_ASSERT( size == (off_t)fs::file_size(pathname) );
+    CPPUNIT_ASSERT( journal->Append(record) );
+    journal.reset();
+
+    catalog.SetDown(false);
+    journal.reset( new CatalogJournal(pathname, &catalog, 3600) );
+    CPPUNIT_ASSERT( 11 == journal->GetPending() );
+    CPPUNIT_ASSERT( journal->Flush(10 * 1000) );
+    CPPUNIT_ASSERT( 11 == catalog.records_ );
+    CPPUNIT_ASSERT( 0 == catalog.disorder_ );
+}
+
+
+void
+CatalogJournalTest::testLag()
+{
+    CatalogSimulator catalog;
+    catalog.SetDown(true);
+    //  the age is in whole seconds, a lag of 1 may be reached by the
+    //  first flush already
+    CatalogJournal journal(pathname, &catalog, 2);
+
+    CatalogRecord record;
+    record.type = CatalogRecord::TypeDeleteFile;
+    record.share = "share";
+    record.values.push_back("1");
+    CPPUNIT_ASSERT( journal.Append(record) );
+    CPPUNIT_ASSERT( false == journal.Flush(100) );
+    CPPUNIT_ASSERT( false == journal.IsLagging() );
+
+    boost::this_thread::sleep(boost::posix_time::milliseconds(3500));
+    CPPUNIT_ASSERT( true == journal.IsLagging() );
+
+    catalog.SetDown(false);
+    CPPUNIT_ASSERT( journal.Flush(10 * 1000) );
+    for ( int i = 0; i < 30 && journal.IsLagging(); ++ i ) {
+        boost::this_thread::sleep(boost::posix_time::milliseconds(100));
+    }
+    CPPUNIT_ASSERT( false == journal.IsLagging() );
+}
+
+
+void
+CatalogJournalTest::testFlushRelated()
+{
+    CatalogSimulator catalog;
+    catalog.SetDown(true);
+    CatalogJournal journal(pathname, &catalog, 3600);
+
+    CatalogRecord record;
+    record.share = "share";
+    record.type = CatalogRecord::TypeAddFiles;
+    const char * values[] = { "tape0", "1", "/f/1", "4096", "1024", "", "0" };
+    record.values.assign(values, values + CatalogRecord::FileValues);
+    CPPUNIT_ASSERT( journal.Append(record) );
+    record.type = CatalogRecord::TypeDeleteFile;
+    record.values.assign(1, "2");
+    CPPUNIT_ASSERT( journal.Append(record) );
+    record.type = CatalogRecord::TypeRenameFolder;
+    record.values.assign(1, "/f");
+    record.values.push_back("/g");
+    CPPUNIT_ASSERT( journal.Append(record) );
+
+    //  the lookups of other files and tapes do not wait for the catalog
+    boost::posix_time::ptime begin =
+            boost::posix_time::microsec_clock::universal_time();
+    CPPUNIT_ASSERT( true == journal.FlushFile(5000, "3") );
+    CPPUNIT_ASSERT( true == journal.FlushTape(5000, "tape1") );
+    int duration = (boost::posix_time::microsec_clock::universal_time()
+            - begin).total_milliseconds();
+    CPPUNIT_ASSERT_MESSAGE(
+            boost::lexical_cast<string>(duration), duration < 1000 );
+
+    CPPUNIT_ASSERT( false == journal.FlushFile(100, "1") );
+    CPPUNIT_ASSERT( false == journal.FlushFile(100, "2") );
+    CPPUNIT_ASSERT( false == journal.FlushTape(100, "tape0") );
+    CPPUNIT_ASSERT( false == journal.Flush(100) );
+
+    vector<string> deletes;
+    journal.GetPendingDeletes(deletes);
+    CPPUNIT_ASSERT( 1 == deletes.size() );
+    CPPUNIT_ASSERT( "2" == deletes[0] );
+
+    catalog.SetDown(false);
+    CPPUNIT_ASSERT( true == journal.FlushFile(10 * 1000, "1") );
+    CPPUNIT_ASSERT( true == journal.FlushTape(10 * 1000, "tape0") );
+    CPPUNIT_ASSERT( true == journal.Flush(10 * 1000) );
+    deletes.clear();
+    journal.GetPendingDeletes(deletes);
+    CPPUNIT_ASSERT( 0 == deletes.size() );
+    CPPUNIT_ASSERT( "/g/1" == catalog.files_["1"] );
+}
+
+
+void
+CatalogJournalTest::testGroupCommit()
+{
+    const int threads = 16;
+    const int count = 200;
+    CatalogSimulator catalog;
+    int failed = 0;
+
+    //  one writer after the other, every record is synced by itself
+    {
+        CatalogJournal journal(pathname, &catalog, 3600);
+        boost::posix_time::ptime begin =
+                boost::posix_time::microsec_clock::local_time();
+        Append(&journal, count, &failed);
+        int duration = (boost::posix_time::microsec_clock::local_time()
+                - begin).total_milliseconds();
+        cout << endl << count << " changes by one writer in "
+                << duration << " ms";
+        CPPUNIT_ASSERT( journal.Flush(10 * 1000) );
+    }
+
+    CatalogJournal journal(pathname, &catalog, 3600);
+    boost::posix_time::ptime begin =
+            boost::posix_time::microsec_clock::local_time();
+    boost::thread_group group;
+    vector<int> failures(threads, 0);
+    for ( int i = 0; i < threads; ++ i ) {
+        group.create_thread( boost::bind(
+                &Append, &journal, count, &failures[i] ) );
+    }
+    group.join_all();
+    int duration = (boost::posix_time::microsec_clock::local_time()
+            - begin).total_milliseconds();
+    cout << ", " << threads * count << " by " << threads
+            << " writers in " << duration << " ms" << endl;
+    CPPUNIT_ASSERT( journal.Flush(30 * 1000) );
+
+    CPPUNIT_ASSERT( 0 == failed );
+    for ( int i = 0; i < threads; ++ i ) {
+        CPPUNIT_ASSERT( 0 == failures[i] );
+    }
+    CPPUNIT_ASSERT( (threads + 1) * count == catalog.records_ );
+    CPPUNIT_ASSERT( (threads + 1) * count == (int)catalog.sequence_ );
+    CPPUNIT_ASSERT( 0 == catalog.disorder_ );
+    CPPUNIT_ASSERT( 0 == catalog.again_ );
+}
@@ -0,0 +1,517 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * EvictionIndexTest.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+
+
+#include "stdafx.h"
+#include "../EvictionIndex.h"
+#include "../MetaManager.h"
+#include "../CacheManager.h"
+#include "EvictionIndexTest.h"
+
+
+CPPUNIT_TEST_SUITE_REGISTRATION( EvictionIndexTest );
+
+
+static const string indexFile = "eviction.lru";
+static const string metaFolder = "meta.folder";
+static const string cacheFolder = "cache.folder";
+
+
+static vector<string>
+GetPaths(EvictionIndex & index, size_t count)
+{
+    vector<EvictionItem> items;
+    index.GetOldest(count,items);
+    vector<string> paths;
+    BOOST_FOREACH( const EvictionItem & item, items ) {
+        paths.push_back(item.path.string());
+    }
+    return paths;
+}
+
+
+static size_t
+GetLineCount(const string & pathname)
+{
+    ifstream input(pathname.c_str());
+    size_t count = 0;
+    string line;
+    while ( getline(input,line) ) {
+        ++ count;
+    }
+    return count;
+}
+
+
+void
+EvictionIndexTest::setUp()
+{
+    fs::remove(indexFile);
+    fs::create_directory(metaFolder);
+    fs::create_directory(cacheFolder);
+}
+
+
+void
+EvictionIndexTest::tearDown()
+{
+    fs::remove(indexFile);
+    fs::remove_all(metaFolder);
+    fs::remove_all(cacheFolder);
+}
+
+
+void
+EvictionIndexTest::testOrder()
+{
+    EvictionIndex index(indexFile, 1000);
+
+    index.Touch("/a", 100);
+    index.Touch("/b", 200);
+    index.Touch("/c", 300);
+    index.Touch("/a", 400);
+    CPPUNIT_ASSERT( 3 == index.Size() );
+
+    vector<EvictionItem> items;
+    index.GetOldest(2, items);
+    CPPUNIT_ASSERT( 2 == items.size() );
+    CPPUNIT_ASSERT( "/b" == items[0].path.string() );
+    CPPUNIT_ASSERT( 200 == items[0].atime );
+    CPPUNIT_ASSERT( "/c" == items[1].path.string() );
+
+    index.Remove("/b");
+    index.Remove("/none");
+    vector<string> paths = GetPaths(index, 10);
+    CPPUNIT_ASSERT( 2 == paths.size() );
+    CPPUNIT_ASSERT( "/c" == paths[0] );
+    CPPUNIT_ASSERT( "/a" == paths[1] );
+}
+
+
+void
+EvictionIndexTest::testRename()
+{
+    EvictionIndex index(indexFile, 1000);
+
+    index.Touch("/d/x", 100);
+    index.Touch("/d0/z", 200);
+    index.Touch("/d/e/y", 300);
+    index.Touch("/f", 400);
+    index.Touch("/d", 500);
+
+    //  a folder moves the entries below it, not the ones sharing its name
+    index.Rename("/d", "/g");
+    vector<string> paths = GetPaths(index, 10);
+    CPPUNIT_ASSERT( 5 == paths.size() );
+    CPPUNIT_ASSERT( "/g/x" == paths[0] );
+    CPPUNIT_ASSERT( "/d0/z" == paths[1] );
+    CPPUNIT_ASSERT( "/g/e/y" == paths[2] );
+    CPPUNIT_ASSERT( "/f" == paths[3] );
+    CPPUNIT_ASSERT( "/g" == paths[4] );
+
+    //  a file renamed over another one keeps its own access time
+    index.Rename("/f", "/g/x");
+    paths = GetPaths(index, 10);
+    CPPUNIT_ASSERT( 4 == paths.size() );
+    CPPUNIT_ASSERT( "/d0/z" == paths[0] );
+    CPPUNIT_ASSERT( "/g/e/y" == paths[1] );
+    CPPUNIT_ASSERT( "/g/x" == paths[2] );
+    CPPUNIT_ASSERT( "/g" == paths[3] );
+
+    index.Remove("/g/x");
+    index.Touch("/g/x", 600);
+    CPPUNIT_ASSERT( "/g/x" == GetPaths(index, 10)[3] );
+
+    //  a folder moved over one with entries of the same names replaces
+    //  them, none is left behind without its index entry
+    index.Touch("/h/x", 700);
+    index.Touch("/h/e/y", 800);
+    index.Rename("/g", "/h");
+    paths = GetPaths(index, 10);
+    CPPUNIT_ASSERT( 4 == index.Size() );
+    CPPUNIT_ASSERT( 4 == paths.size() );
+    CPPUNIT_ASSERT( "/d0/z" == paths[0] );
+    CPPUNIT_ASSERT( "/h/e/y" == paths[1] );
+    CPPUNIT_ASSERT( "/h" == paths[2] );
+    CPPUNIT_ASSERT( "/h/x" == paths[3] );
+    index.Remove("/h/x");
+    index.Remove("/h/e/y");
+    index.Remove("/h");
+    index.Remove("/d0/z");
+    CPPUNIT_ASSERT( 0 == index.Size() );
+    CPPUNIT_ASSERT( 0 == GetPaths(index, 10).size() );
+}
+
+
+void
+EvictionIndexTest::testCursor()
+{
+    EvictionIndex index(indexFile, 1000);
+    for ( int i = 0; i < 10; ++ i ) {
+        index.Touch("/" + boost::lexical_cast<string>(i), i);
+    }
+
+    vector<EvictionItem> items;
+    index.GetOldest(3, items, "/4");
+    CPPUNIT_ASSERT( 3 == items.size() );
+    CPPUNIT_ASSERT( "/5" == items[0].path.string() );
+    CPPUNIT_ASSERT( "/7" == items[2].path.string() );
+
+    items.clear();
+    index.GetOldest(3, items, "/8");
+    CPPUNIT_ASSERT( 1 == items.size() );
+    CPPUNIT_ASSERT( "/9" == items[0].path.string() );
+
+    items.clear();
+    index.GetOldest(3, items, "/9");
+    CPPUNIT_ASSERT( 0 == items.size() );
+
+    //  the cursor is gone, the walk starts over
+    index.Remove("/4");
+    items.clear();
+    index.GetOldest(3, items, "/4");
+    CPPUNIT_ASSERT( 3 == items.size() );
+    CPPUNIT_ASSERT( "/0" == items[0].path.string() );
+}
+
+
+void
+EvictionIndexTest::testPersist()
+{
+    {
+        EvictionIndex index(indexFile, 1000);
+        index.Touch("/a", 100);
+        index.Touch("/d/b", 200);
+        index.Touch("/c", 300);
+        index.Touch("/a", 400);
+        index.Rename("/d", "/e");
+        index.Touch("/f", 500);
+        index.Remove("/c");
+    }
+
+    EvictionIndex index(indexFile, 1000);
+    vector<EvictionItem> items;
+    index.GetOldest(10, items);
+    CPPUNIT_ASSERT( 3 == items.size() );
+    CPPUNIT_ASSERT( "/e/b" == items[0].path.string() );
+    CPPUNIT_ASSERT( 200 == items[0].atime );
+    CPPUNIT_ASSERT( "/a" == items[1].path.string() );
+    CPPUNIT_ASSERT( 400 == items[1].atime );
+    CPPUNIT_ASSERT( "/f" == items[2].path.string() );
+
+    //  a record cut short by a crash is ignored
+    {
+        ofstream output(indexFile.c_str(), ios::out|ios::app);
+        output << "T\t600";
+    }
+    EvictionIndex reload(indexFile, 1000);
+    CPPUNIT_ASSERT( 3 == reload.Size() );
+}
+
+
+void
+EvictionIndexTest::testEscape()
+{
+    const string names[] = { "/a\tb", "/c\nT\t1\t/d", "/e\\nf", "/g\\" };
+    {
+        EvictionIndex index(indexFile, 1000);
+        for ( int i = 0; i < 4; ++ i ) {
+            index.Touch(names[i], 100 + i);
+        }
+        index.Rename(names[0], names[0] + "\n");
+        index.Remove(names[3]);
+    }
+    CPPUNIT_ASSERT( 7 == GetLineCount(indexFile) );
+
+    EvictionIndex index(indexFile, 1000);
+    vector<string> paths = GetPaths(index, 10);
+    CPPUNIT_ASSERT( 3 == paths.size() );
+    CPPUNIT_ASSERT( names[0] + "\n" == paths[0] );
+    CPPUNIT_ASSERT( names[1] == paths[1] );
+    CPPUNIT_ASSERT( names[2] == paths[2] );
+}
+
+
+void
+EvictionIndexTest::testCompact()
+{
+    const int count = 10000;
+    {
+        EvictionIndex index(indexFile, 0);
+        index.Touch("/b", 0);
+        for ( int i = 1; i <= count; ++ i ) {
+            index.Touch("/a", i);
+        }
+        //  a touch only appends, the journal is rewritten by Save
+        CPPUNIT_ASSERT( (size_t)count + 1 == GetLineCount(indexFile) );
+        CPPUNIT_ASSERT( true == index.Save() );
+        CPPUNIT_ASSERT( 2 == GetLineCount(indexFile) );
+    }
+
+    EvictionIndex index(indexFile, 0);
+    vector<EvictionItem> items;
+    index.GetOldest(10, items);
+    CPPUNIT_ASSERT( 2 == items.size() );
+    CPPUNIT_ASSERT( "/b" == items[0].path.string() );
+    CPPUNIT_ASSERT( "/a" == items[1].path.string() );
+    CPPUNIT_ASSERT( count == items[1].atime );
+}
+
+
+static void
+TouchFiles(EvictionIndex * index, int files, int count)
+{
+    for ( int i = 1; i <= count; ++ i ) {
+        index->Touch("/" + boost::lexical_cast<string>(i % files), i);
+    }
+}
+
+
+void
+EvictionIndexTest::testCompactConcurrent()
+{
+    //  the touches made while the journal is rewritten are not lost
+    const int files = 100;
+    const int count = 200000;
+    {
+        EvictionIndex index(indexFile, 0);
+        boost::thread thread(TouchFiles, &index, files, count);
+        size_t saves = 0;
+        while ( ! thread.timed_join(boost::posix_time::milliseconds(1)) ) {
+            CPPUNIT_ASSERT( true == index.Save() );
+            ++ saves;
+        }
+        CPPUNIT_ASSERT( saves > 0 );
+    }
+
+    EvictionIndex index(indexFile, 0);
+    vector<EvictionItem> items;
+    index.GetOldest(files + 1, items);
+    CPPUNIT_ASSERT( (size_t)files == items.size() );
+    for ( int i = 0; i < files; ++ i ) {
+        CPPUNIT_ASSERT( count - files + 1 + i == items[i].atime );
+    }
+}
+
+
+void
+EvictionIndexTest::testMetaManager()
+{
+    Factory::SetCacheFolder(cacheFolder);
+    Factory::CreateCacheManager();
+    Factory::CreateReadManager();
+    Factory::SetMetaFolder(metaFolder);
+    Factory::CreateMetaManager();
+
+    MetaManager * meta = Factory::GetMetaManager();
+    char buffer[1024] = "Hello,World!\n";
+    size_t size;
+
+    const string files[] = { "/file0", "/file1", "/file2" };
+    for ( int i = 0; i < 3; ++ i ) {
+        CPPUNIT_ASSERT( true == meta->CreateFile(files[i],0644) );
+        auto_ptr<FileOperationInterface> file(
+                meta->GetFileOperation(files[i],O_RDWR) );
+        CPPUNIT_ASSERT( true == file->Write(0,buffer,sizeof(buffer),size) );
+    }
+
+    CPPUNIT_ASSERT( true == meta->RenameInode(files[1], "/file3") );
+    CPPUNIT_ASSERT( true == meta->DeleteInode(files[2]) );
+
+    //  only the files on tape can be released
+    vector<EvictionItem> items;
+    meta->GetEvictionList(10, items);
+    CPPUNIT_ASSERT( 0 == items.size() );
+    const string released[] = { files[0], "/file3" };
+    for ( int i = 0; i < 2; ++ i ) {
+        auto_ptr<Inode> inode( meta->GetInode(released[i]) );
+        CPPUNIT_ASSERT( true == inode->SetState(Inode::StateBegin) );
+    }
+
+    //  open again, file0 is the most recently used one now
+    auto_ptr<FileOperationInterface> file(
+            meta->GetFileOperation(files[0],O_RDONLY) );
+    file.reset();
+    meta->GetEvictionList(10, items);
+    CPPUNIT_ASSERT( 2 == items.size() );
+    CPPUNIT_ASSERT( "/file3" == items[0].path.string() );
+    CPPUNIT_ASSERT( files[0] == items[1].path.string() );
+
+    //  a backlog not on tape yet at the head of the index does not hide
+    //  the files behind it
+    for ( int i = 0; i < 50; ++ i ) {
+        string path = "/backlog" + boost::lexical_cast<string>(i);
+        CPPUNIT_ASSERT( true == meta->CreateFile(path,0644) );
+        auto_ptr<FileOperationInterface> file(
+                meta->GetFileOperation(path,O_RDWR) );
+        CPPUNIT_ASSERT( true == file->Write(0,buffer,sizeof(buffer),size) );
+    }
+    file.reset( meta->GetFileOperation("/file3",O_RDONLY) );
+    file.reset( meta->GetFileOperation(files[0],O_RDONLY) );
+    file.reset();
+    items.clear();
+    meta->GetEvictionList(2, items);
+    CPPUNIT_ASSERT( 2 == items.size() );
+    CPPUNIT_ASSERT( "/file3" == items[0].path.string() );
+    CPPUNIT_ASSERT( files[0] == items[1].path.string() );
+    items.clear();
+    meta->GetEvictionList(1, items);
+    CPPUNIT_ASSERT( 1 == items.size() );
+    CPPUNIT_ASSERT( "/file3" == items[0].path.string() );
+    for ( int i = 0; i < 50; ++ i ) {
+        CPPUNIT_ASSERT( true == meta->DeleteInode(
+                "/backlog" + boost::lexical_cast<string>(i) ) );
+    }
+
+    Factory::ReleaseMetaManager();
+    Factory::ReleaseReadManager();
+    Factory::ReleaseCacheManager();
+
+    //  the index is back after a restart without a scan
+    fs::path pathname = fs::path(cacheFolder) / (Factory::GetService() + ".lru");
+    EvictionIndex index(pathname, 1000);
+    vector<string> paths = GetPaths(index, 10);
+    CPPUNIT_ASSERT( 2 == paths.size() );
+    CPPUNIT_ASSERT( "/file3" == paths[0] );
+    CPPUNIT_ASSERT( files[0] == paths[1] );
+}
+
+
+//  The walk of CacheMonitorServer::ScanFolder, every stub is read before the
+//  oldest one is known
+static void
+ScanFolder(
+        CacheManager * cache,
+        const fs::path & folder,
+        map<time_t, vector<fs::path> > & files)
+{
+    fs::directory_iterator end;
+    for ( fs::directory_iterator i(folder); i != end; ++ i ) {
+        if ( fs::is_directory(i->status()) ) {
+            ScanFolder(cache, i->path(), files);
+            continue;
+        }
+        struct stat stat;
+        if ( 0 != ::stat(i->path().string().c_str(),&stat) ) {
+            continue;
+        }
+        ExtendedAttribute ea(i->path());
+        unsigned long long number;
+        long state;
+        long long size;
+        int valuesize;
+        if ( ! ea.GetValue(Inode::ATTRIBUTE_NUMBER,
+                    &number, sizeof(number), valuesize)
+                || ! ea.GetValue(Inode::ATTRIBUTE_STATE,
+                    &state, sizeof(state), valuesize)
+                || state != Inode::StateBegin
+                || ! ea.GetValue(Inode::ATTRIBUTE_SIZE,
+                    &size, sizeof(size), valuesize)
+                || size <= 0
+                || ! cache->ExistFile(number) ) {
+            continue;
+        }
+        files[stat.st_atime].push_back(i->path());
+    }
+}
+
+
+void
+EvictionIndexTest::testFirstEviction()
+{
+    const int count = 1000 * 1000;
+    const int countFolder = 1000;
+    const int countCache = 64;
+
+    Factory::SetCacheFolder(cacheFolder);
+    Factory::CreateCacheManager();
+    CacheManager * cache = Factory::GetCacheManager();
+
+    //  the stubs share a few cache files, a scan checks the cache file of
+    //  every stub all the same
+    for ( int i = 1; i <= countCache; ++ i ) {
+        CPPUNIT_ASSERT( true == cache->CreateFile(i) );
+    }
+
+    boost::posix_time::ptime begin =
+            boost::posix_time::microsec_clock::local_time();
+    {
+        EvictionIndex index(indexFile, 1000);
+        for ( int i = 0; i < count; ++ i ) {
+            fs::path path = "/" + boost::lexical_cast<string>(i / countFolder)
+                    + "/" + boost::lexical_cast<string>(i);
+            fs::path pathname = fs::path(metaFolder) / path;
+            if ( i % countFolder == 0 ) {
+                fs::create_directory(pathname.parent_path());
+            }
+            ofstream(pathname.string().c_str());
+            Inode inode(pathname);
+            CPPUNIT_ASSERT( true == inode.SetNumber(i % countCache + 1) );
+            CPPUNIT_ASSERT( true == inode.SetState(Inode::StateBegin) );
+            CPPUNIT_ASSERT( true == inode.SetSize(1024) );
+            index.Touch(path, i);
+        }
+    }
+    int durationCreate = (boost::posix_time::microsec_clock::local_time()
+            - begin).total_milliseconds();
+
+    begin = boost::posix_time::microsec_clock::local_time();
+    map<time_t, vector<fs::path> > files;
+    ScanFolder(cache, metaFolder, files);
+    CPPUNIT_ASSERT( false == files.empty() );
+    fs::path scanned = files.begin()->second[0];
+    int durationScan = (boost::posix_time::microsec_clock::local_time()
+            - begin).total_milliseconds();
+
+    //  a restart loads the index, the oldest entry is checked like the
+    //  service does before it is released
+    begin = boost::posix_time::microsec_clock::local_time();
+    EvictionIndex index(indexFile, 1000);
+    vector<EvictionItem> items;
+    index.GetOldest(1, items);
+    CPPUNIT_ASSERT( 1 == items.size() );
+    Inode inode( fs::path(metaFolder) / items[0].path );
+    unsigned long long number;
+    long state;
+    CPPUNIT_ASSERT( true == inode.GetNumber(number) );
+    CPPUNIT_ASSERT( true == inode.GetState(state) );
+    CPPUNIT_ASSERT( true == cache->ExistFile(number) );
+    int durationIndex = (boost::posix_time::microsec_clock::local_time()
+            - begin).total_milliseconds();
+
+    begin = boost::posix_time::microsec_clock::local_time();
+    items.clear();
+    index.GetOldest(1, items);
+    int durationRunning = (boost::posix_time::microsec_clock::local_time()
+            - begin).total_microseconds();
+
+    CPPUNIT_ASSERT( count == (int)index.Size() );
+    CPPUNIT_ASSERT( "/0/0" == items[0].path.string() );
+
+    cout << endl << count << " stubs (" << durationCreate << " ms to create),"
+            << " first eviction after a scan: " << durationScan << " ms,"
+            << " after loading the index: " << durationIndex << " ms,"
+            << " from the running index: " << durationRunning << " us"
+            << endl;
+    CPPUNIT_ASSERT( durationIndex * 4 < durationScan );
+
+    Factory::ReleaseCacheManager();
+}
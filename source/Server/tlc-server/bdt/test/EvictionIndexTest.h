@@ -0,0 +1,53 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * EvictionIndexTest.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+
+
+#pragma once
+
+
+class EvictionIndexTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE( EvictionIndexTest );
+    CPPUNIT_TEST( testOrder );
+    CPPUNIT_TEST( testRename );
+    CPPUNIT_TEST( testCursor );
+    CPPUNIT_TEST( testPersist );
+    CPPUNIT_TEST( testEscape );
+    CPPUNIT_TEST( testCompact );
+    CPPUNIT_TEST( testCompactConcurrent );
+    CPPUNIT_TEST( testMetaManager );
+    CPPUNIT_TEST( testFirstEviction );
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void setUp();
+    void tearDown();
+
+    void testOrder();
+    void testRename();
+    void testCursor();
+    void testPersist();
+    void testEscape();
+    void testCompact();
+    void testCompactConcurrent();
+    void testMetaManager();
+    void testFirstEviction();
+};
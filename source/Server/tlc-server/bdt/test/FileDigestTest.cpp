@@ -34,6 +34,39 @@ const string digest4KSHA1 = "1ceaf73df40e531df3bfb26b4fb7cd95fb7bff1d";
 const string digest4KMD5 = "620f0b67a91f7f74151bc5be745b7110";
 
 
+//  digest of the whole buffer by OpenSSL
+static string
+Reference(const EVP_MD * md, const char * buffer, size_t length)
+{
+    EVP_MD_CTX * ctx = EVP_MD_CTX_create();
+    EVP_DigestInit_ex(ctx,md,NULL);
+    EVP_DigestUpdate(ctx,buffer,length);
+    unsigned char value[EVP_MAX_MD_SIZE];
+    unsigned int size;
+    EVP_DigestFinal_ex(ctx,value,&size);
+    EVP_MD_CTX_free(ctx);
+
+    char hex[3];
+    string output;
+    for ( unsigned int i = 0; i < size; ++ i ) {
+        snprintf(hex,sizeof(hex),"%02x",value[i]);
+        output += hex;
+    }
+    return output;
+}
+
+
+static void
+CheckDigest(FileDigest & object, const char * buffer, size_t length)
+{
+    string digest;
+    CPPUNIT_ASSERT(true==object.GetDigest(FileDigest::DIGEST_MD5,digest));
+    CPPUNIT_ASSERT(digest==Reference(EVP_md5(),buffer,length));
+    CPPUNIT_ASSERT(true==object.GetDigest(FileDigest::DIGEST_SHA1,digest));
+    CPPUNIT_ASSERT(digest==Reference(EVP_sha1(),buffer,length));
+}
+
+
 void
 FileDigestTest::setUp()
 {
@@ -321,3 +354,225 @@ FileDigestTest::testFileDigest()
     CPPUNIT_ASSERT(true==object->IsValid());
 }
 
+
+
+void
+FileDigestTest::testShuffle()
+{
+    const size_t size = 4 * 1024 * 1024;
+    const size_t block = 64 * 1024;
+    boost::scoped_array<char> buffer(new char[size]);
+    srand(1);
+    for ( size_t i = 0; i < size; ++ i ) {
+        buffer[i] = rand();
+    }
+
+    //  blocks written by a few writers, each in order, interleaved
+    vector<size_t> blocks;
+    for ( size_t i = 0; i < size / block; ++ i ) {
+        blocks.push_back(i);
+    }
+    for ( int round = 0; round < 8; ++ round ) {
+        vector<size_t> order(blocks);
+        if ( round == 0 ) {
+            reverse(order.begin(),order.end());
+        } else {
+            random_shuffle(order.begin(),order.end());
+        }
+
+        FileDigest object(size);
+        CPPUNIT_ASSERT(true==object.EnableDigest(FileDigest::DIGEST_MD5));
+        CPPUNIT_ASSERT(true==object.EnableDigest(FileDigest::DIGEST_SHA1));
+        BOOST_FOREACH( size_t i, order ) {
+            CPPUNIT_ASSERT(true==object.UpdateContent(
+                    i*block,buffer.get()+i*block,block));
+        }
+        CPPUNIT_ASSERT(true==object.IsValid());
+        CheckDigest(object,buffer.get(),size);
+    }
+
+    //  random extents in a small window, one digest only
+    for ( int round = 0; round < 8; ++ round ) {
+        FileDigest object(size / 4);
+        CPPUNIT_ASSERT(true==object.EnableDigest(FileDigest::DIGEST_MD5));
+        CPPUNIT_ASSERT(true==object.EnableDigest(FileDigest::DIGEST_SHA1));
+        vector<pair<size_t,size_t> > extents;
+        for ( size_t offset = 0; offset < size; ) {
+            size_t length = min(size - offset,(size_t)rand() % block + 1);
+            extents.push_back(make_pair(offset,length));
+            offset += length;
+        }
+        //  shuffle within groups that fit in the window
+        for ( size_t i = 0; i < extents.size(); i += 16 ) {
+            random_shuffle(extents.begin()+i,
+                    extents.begin()+min(extents.size(),i+16));
+        }
+        for ( size_t i = 0; i < extents.size(); ++ i ) {
+            CPPUNIT_ASSERT(true==object.UpdateContent(extents[i].first,
+                    buffer.get()+extents[i].first,extents[i].second));
+        }
+        CPPUNIT_ASSERT(true==object.IsValid());
+        CheckDigest(object,buffer.get(),size);
+    }
+
+    FileDigest single(size);
+    CPPUNIT_ASSERT(true==single.EnableDigest(FileDigest::DIGEST_SHA1));
+    for ( size_t i = size / block; i > 0; -- i ) {
+        CPPUNIT_ASSERT(true==single.UpdateContent(
+                (i-1)*block,buffer.get()+(i-1)*block,block));
+    }
+    string digest;
+    CPPUNIT_ASSERT(true==single.GetDigest(FileDigest::DIGEST_SHA1,digest));
+    CPPUNIT_ASSERT(digest==Reference(EVP_sha1(),buffer.get(),size));
+    CPPUNIT_ASSERT(false==single.GetDigest(FileDigest::DIGEST_MD5,digest));
+}
+
+
+void
+FileDigestTest::testOverlap()
+{
+    const size_t size = 256 * 1024;
+    boost::scoped_array<char> buffer(new char[size]);
+    boost::scoped_array<char> old(new char[size]);
+    srand(2);
+    for ( size_t i = 0; i < size; ++ i ) {
+        buffer[i] = rand();
+        old[i] = rand();
+    }
+
+    //  rewrites ahead of the digest, the last one wins
+    FileDigest object(size);
+    CPPUNIT_ASSERT(true==object.EnableDigest(FileDigest::DIGEST_MD5));
+    CPPUNIT_ASSERT(true==object.EnableDigest(FileDigest::DIGEST_SHA1));
+    CPPUNIT_ASSERT(true==object.UpdateContent(
+            10000,old.get()+10000,100000));
+    CPPUNIT_ASSERT(true==object.UpdateContent(
+            50000,old.get()+50000,150000));
+    CPPUNIT_ASSERT(true==object.UpdateContent(
+            20000,buffer.get()+20000,20000));
+    CPPUNIT_ASSERT(true==object.UpdateContent(
+            60000,buffer.get()+60000,size-60000));
+    CPPUNIT_ASSERT(true==object.UpdateContent(
+            40000,buffer.get()+40000,20000));
+    CPPUNIT_ASSERT(true==object.UpdateContent(
+            5000,buffer.get()+5000,15000));
+    CPPUNIT_ASSERT(true==object.UpdateContent(0,buffer.get(),5000));
+    CPPUNIT_ASSERT(true==object.IsValid());
+    CheckDigest(object,buffer.get(),size);
+
+    //  a write behind the digested data
+    FileDigest behind(size);
+    CPPUNIT_ASSERT(true==behind.EnableDigest(FileDigest::DIGEST_MD5));
+    CPPUNIT_ASSERT(true==behind.EnableDigest(FileDigest::DIGEST_SHA1));
+    CPPUNIT_ASSERT(true==behind.UpdateContent(0,buffer.get(),1000));
+    CPPUNIT_ASSERT(true==behind.UpdateContent(2000,buffer.get()+2000,1000));
+    CPPUNIT_ASSERT(true==behind.UpdateContent(1000,buffer.get()+1000,1000));
+    CPPUNIT_ASSERT(false==behind.UpdateContent(500,buffer.get()+500,1000));
+    CPPUNIT_ASSERT(false==behind.IsValid());
+    string digest;
+    CPPUNIT_ASSERT(false==behind.GetDigest(FileDigest::DIGEST_MD5,digest));
+}
+
+
+void
+FileDigestTest::testHole()
+{
+    const size_t size = 8 * 1024 * 1024;
+    boost::scoped_array<char> buffer(new char[size]);
+    memset(buffer.get(),0,size);
+    srand(3);
+    for ( size_t i = 0; i < 64 * 1024; ++ i ) {
+        buffer[i] = rand();
+        buffer[size/2+i] = rand();
+    }
+
+    //  the hole is filled when the size is known
+    FileDigest end(1024 * 1024);
+    CPPUNIT_ASSERT(true==end.EnableDigest(FileDigest::DIGEST_MD5));
+    CPPUNIT_ASSERT(true==end.EnableDigest(FileDigest::DIGEST_SHA1));
+    CPPUNIT_ASSERT(true==end.UpdateContent(
+            size/2,buffer.get()+size/2,64*1024));
+    CPPUNIT_ASSERT(true==end.UpdateContent(0,buffer.get(),64*1024));
+    CPPUNIT_ASSERT(true==end.UpdateSize(size));
+    CheckDigest(end,buffer.get(),size);
+
+    //  beyond the window the gap is a hole at once
+    FileDigest window(32 * 1024);
+    CPPUNIT_ASSERT(true==window.EnableDigest(FileDigest::DIGEST_MD5));
+    CPPUNIT_ASSERT(true==window.EnableDigest(FileDigest::DIGEST_SHA1));
+    CPPUNIT_ASSERT(true==window.UpdateContent(0,buffer.get(),64*1024));
+    CPPUNIT_ASSERT(true==window.UpdateContent(
+            size/2,buffer.get()+size/2,64*1024));
+    CPPUNIT_ASSERT(false==window.UpdateContent(
+            size/4,buffer.get()+size/4,1024));
+    CPPUNIT_ASSERT(false==window.IsValid());
+
+    //  a large hole in one piece
+    FileDigest large(0);
+    CPPUNIT_ASSERT(true==large.EnableDigest(FileDigest::DIGEST_MD5));
+    CPPUNIT_ASSERT(true==large.EnableDigest(FileDigest::DIGEST_SHA1));
+    CPPUNIT_ASSERT(true==large.UpdateContent(0,buffer.get(),64*1024));
+    CPPUNIT_ASSERT(true==large.UpdateContent(
+            size/2,buffer.get()+size/2,64*1024));
+    CPPUNIT_ASSERT(true==large.UpdateSize(size));
+    CheckDigest(large,buffer.get(),size);
+}
+
+
+void
+FileDigestTest::testPerformance()
+{
+    const size_t size = 1024 * 1024 * 1024;
+    const size_t block = 1024 * 1024;
+    boost::scoped_array<char> buffer(new char[block]);
+    srand(4);
+    for ( size_t i = 0; i < block; ++ i ) {
+        buffer[i] = rand();
+    }
+
+    //  the old way, both digests one after the other in the writer
+    boost::posix_time::ptime begin =
+            boost::posix_time::microsec_clock::local_time();
+    EVP_MD_CTX * md5 = EVP_MD_CTX_create();
+    EVP_MD_CTX * sha1 = EVP_MD_CTX_create();
+    EVP_DigestInit_ex(md5,EVP_md5(),NULL);
+    EVP_DigestInit_ex(sha1,EVP_sha1(),NULL);
+    for ( size_t offset = 0; offset < size; offset += block ) {
+        EVP_DigestUpdate(md5,buffer.get(),block);
+        EVP_DigestUpdate(sha1,buffer.get(),block);
+    }
+    unsigned char value[EVP_MAX_MD_SIZE];
+    unsigned int length;
+    EVP_DigestFinal_ex(md5,value,&length);
+    EVP_DigestFinal_ex(sha1,value,&length);
+    EVP_MD_CTX_free(md5);
+    EVP_MD_CTX_free(sha1);
+    int serial = (boost::posix_time::microsec_clock::local_time()
+            - begin).total_milliseconds();
+
+    //  two writers, one block apart
+    begin = boost::posix_time::microsec_clock::local_time();
+    FileDigest object(16 * block);
+    CPPUNIT_ASSERT(true==object.EnableDigest(FileDigest::DIGEST_MD5));
+    CPPUNIT_ASSERT(true==object.EnableDigest(FileDigest::DIGEST_SHA1));
+    for ( size_t offset = 0; offset < size; offset += 2 * block ) {
+        CPPUNIT_ASSERT(true==object.UpdateContent(
+                offset+block,buffer.get(),block));
+        CPPUNIT_ASSERT(true==object.UpdateContent(
+                offset,buffer.get(),block));
+    }
+    string digest;
+    CPPUNIT_ASSERT(true==object.GetDigest(FileDigest::DIGEST_SHA1,digest));
+    int parallel = (boost::posix_time::microsec_clock::local_time()
+            - begin).total_milliseconds();
+
+    cout << endl << size / block << " MB, MD5 and SHA1 in turn: " << serial
+            << " ms, out of order on threads: " << parallel << " ms ("
+            << boost::thread::hardware_concurrency() << " cores)" << endl;
+    if ( boost::thread::hardware_concurrency() > 1 ) {
+        CPPUNIT_ASSERT( parallel < serial );
+    } else {
+        //  only the copy of the data is left on one core
+        CPPUNIT_ASSERT( parallel < serial * 3 / 2 );
+    }
+}
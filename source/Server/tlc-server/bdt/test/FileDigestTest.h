@@ -26,6 +26,10 @@ class FileDigestTest : public CppUnit::TestFixture
 {
     CPPUNIT_TEST_SUITE( FileDigestTest );
     CPPUNIT_TEST( testFileDigest );
+    CPPUNIT_TEST( testShuffle );
+    CPPUNIT_TEST( testOverlap );
+    CPPUNIT_TEST( testHole );
+    CPPUNIT_TEST( testPerformance );
     CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -33,5 +37,9 @@ public:
     void tearDown();
 
     void testFileDigest();
+    void testShuffle();
+    void testOverlap();
+    void testHole();
+    void testPerformance();
 };
 
@@ -59,25 +59,12 @@ FileMetaParserTest::tearDown()
 void
 FileMetaParserTest::testMetaSingle()
 {
-    MetaManager * meta = Factory::GetMetaManager();
-    CPPUNIT_ASSERT( true == meta->CreateFile(testFile,0600) );
-    auto_ptr<Inode> inode(meta->GetInode(testFile));
-
-    char buffer[1024];
-    ifstream input("single.xattr", std::ios::in|std::ios::binary);
-    size_t length = input.readsome(buffer,sizeof(buffer)-1);
-    buffer[length] = '\0';
-    string content = buffer;
-
-    CPPUNIT_ASSERT(inode->SetExtendedAttribute("user.swift.metadata", buffer, 10));
-    CPPUNIT_ASSERT(inode->SetExtendedAttribute("user.swift.metadata1", buffer + 10, 10));
-    CPPUNIT_ASSERT(inode->SetExtendedAttribute("user.swift.metadata2", buffer + 20, length - 20));
-
-    CPPUNIT_ASSERT(parser_.ParseSwiftMeta(testFile));
-    CPPUNIT_ASSERT(parser_.GetName() == "/AUTH_a7b3d7d404a14df993313de181b794e2/ss/etc/swift/swift.conf");
+    //  in chunks of 10 bytes
+    testMetaGoldenSub("object-p0.pickle", 10);
+    CPPUNIT_ASSERT(parser_.GetName() == "/AUTH_7b4e0995cdb5423d94adf4d7bc93b89a/CC/etc/swift/swift.conf");
     CPPUNIT_ASSERT(! parser_.IsMultiple());
     CPPUNIT_ASSERT(! parser_.IsManifest());
-    CPPUNIT_ASSERT(parser_.GetNumber() == -1);
+    CPPUNIT_ASSERT(parser_.GetNumber() == 0);
     CPPUNIT_ASSERT(parser_.GetTotal() == 1);
 }
 
@@ -85,8 +72,6 @@ FileMetaParserTest::testMetaSingle()
 void
 FileMetaParserTest::testMetaMultiple()
 {
-    MetaManager * meta = Factory::GetMetaManager();
-
     for (int i=0; i<5; ++i) {
         testMetaMultipleSub(i);
     }
@@ -96,21 +81,7 @@ FileMetaParserTest::testMetaMultiple()
 void
 FileMetaParserTest::testMetaMultipleSub(int number)
 {
-    MetaManager * meta = Factory::GetMetaManager();
-    CPPUNIT_ASSERT( true == meta->CreateFile(testFile,0600) );
-    auto_ptr<Inode> inode(meta->GetInode(testFile));
-
-    char buffer[1024];
-    string path = boost::lexical_cast<string>(number) + ".attr";
-    ifstream input(path.c_str(), std::ios::in|std::ios::binary);
-    size_t length = input.readsome(buffer,sizeof(buffer)-1);
-    buffer[length] = '\0';
-    string content = buffer;
-
-    CPPUNIT_ASSERT(inode->SetExtendedAttribute("user.swift.metadata", buffer, 40));
-    CPPUNIT_ASSERT(inode->SetExtendedAttribute("user.swift.metadata1", buffer + 40, length - 40));
-
-    CPPUNIT_ASSERT(parser_.ParseSwiftMeta(testFile));
+    testMetaGoldenSub("segment" + boost::lexical_cast<string>(number) + "-p2.pickle", 40);
     string name = "/AUTH_7b4e0995cdb5423d94adf4d7bc93b89a/CC_segments/large/l_3twrhUYtQWN6Rji.bin/1422305129.671900/5000000000/1000000000/0000000";
     name += boost::lexical_cast<string>(number);
     CPPUNIT_ASSERT(parser_.GetName() == name);
@@ -120,29 +91,13 @@ FileMetaParserTest::testMetaMultipleSub(int number)
             parser_.GetManifest() == "/1422305129.671900/5000000000/1000000000/");
     CPPUNIT_ASSERT(parser_.GetNumber() == number);
     CPPUNIT_ASSERT(parser_.GetTotal() == 5);
-
-    inode.reset();
-    CPPUNIT_ASSERT( true == meta->DeleteInode(testFile) );
 }
 
 
 void
 FileMetaParserTest::testMetaMultipleManifest()
 {
-    MetaManager * meta = Factory::GetMetaManager();
-    CPPUNIT_ASSERT( true == meta->CreateFile(testFile,0600) );
-    auto_ptr<Inode> inode(meta->GetInode(testFile));
-
-    char buffer[1024];
-    ifstream input("manifest.attr", std::ios::in|std::ios::binary);
-    size_t length = input.readsome(buffer,sizeof(buffer)-1);
-    buffer[length] = '\0';
-    string content = buffer;
-
-    CPPUNIT_ASSERT(inode->SetExtendedAttribute("user.swift.metadata", buffer, 40));
-    CPPUNIT_ASSERT(inode->SetExtendedAttribute("user.swift.metadata1", buffer + 40, length - 40));
-
-    CPPUNIT_ASSERT(parser_.ParseSwiftMeta(testFile));
+    testMetaGoldenSub("manifest-p2.pickle", 40);
     string name = "/AUTH_7b4e0995cdb5423d94adf4d7bc93b89a/CC/large/l_3twrhUYtQWN6Rji.bin";
     CPPUNIT_ASSERT(parser_.GetName() == name);
     CPPUNIT_ASSERT(parser_.IsMultiple());
@@ -151,8 +106,79 @@ FileMetaParserTest::testMetaMultipleManifest()
             parser_.GetManifest() == "/1422305129.671900/5000000000/1000000000/");
     CPPUNIT_ASSERT(parser_.GetNumber() == -1);
     CPPUNIT_ASSERT(parser_.GetTotal() == 5);
+}
+
+
+
+void
+FileMetaParserTest::testMetaGolden()
+{
+    const string account = "/AUTH_7b4e0995cdb5423d94adf4d7bc93b89a";
+    const string manifest = "/1422305129.671900/5000000000/1000000000/";
+
+    const char * protocols[] = { "p0", "p2" };
+    BOOST_FOREACH( const char * protocol, protocols ) {
+        string suffix = string("-") + protocol + ".pickle";
+
+        testMetaGoldenSub("object" + suffix);
+        CPPUNIT_ASSERT(parser_.GetName()
+                == account + "/CC/etc/swift/swift.conf");
+        CPPUNIT_ASSERT(! parser_.IsMultiple());
+        CPPUNIT_ASSERT(! parser_.IsManifest());
+        CPPUNIT_ASSERT(parser_.GetNumber() == 0);
+        CPPUNIT_ASSERT(parser_.GetTotal() == 1);
+
+        testMetaGoldenSub("segment" + suffix);
+        CPPUNIT_ASSERT(parser_.IsMultiple());
+        CPPUNIT_ASSERT(! parser_.IsManifest());
+        CPPUNIT_ASSERT(parser_.GetManifest() == manifest);
+        CPPUNIT_ASSERT(parser_.GetNumber() == 3);
+        CPPUNIT_ASSERT(parser_.GetTotal() == 5);
+
+        testMetaGoldenSub("manifest" + suffix);
+        CPPUNIT_ASSERT(parser_.GetName()
+                == account + "/CC/large/l_3twrhUYtQWN6Rji.bin");
+        CPPUNIT_ASSERT(parser_.IsMultiple());
+        CPPUNIT_ASSERT(parser_.IsManifest());
+        CPPUNIT_ASSERT(parser_.GetManifest() == manifest);
+        CPPUNIT_ASSERT(parser_.GetNumber() == -1);
+        CPPUNIT_ASSERT(parser_.GetTotal() == 5);
+
+        testMetaGoldenSub("unicode" + suffix);
+        CPPUNIT_ASSERT(parser_.GetName() == account + "/CC/caf\xc3\xa9/"
+                "\xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e \\ line\nbreak.txt");
+        CPPUNIT_ASSERT(! parser_.IsMultiple());
+    }
+}
+
+
+void
+FileMetaParserTest::testMetaGoldenSub(const string & name, size_t chunk)
+{
+    MetaManager * meta = Factory::GetMetaManager();
+    CPPUNIT_ASSERT( true == meta->CreateFile(testFile,0600) );
+    auto_ptr<Inode> inode(meta->GetInode(testFile));
+
+    ifstream input( ("swift/" + name).c_str(),
+            std::ios::in | std::ios::binary );
+    CPPUNIT_ASSERT_MESSAGE( name, input.good() );
+    stringstream stream;
+    stream << input.rdbuf();
+    string content = stream.str();
+
+    //  split as Swift does, in chunks of 254 bytes unless told
+    for ( size_t i = 0; i * chunk < content.size(); ++ i ) {
+        string key = "user.swift.metadata";
+        if ( i > 0 ) {
+            key += boost::lexical_cast<string>(i);
+        }
+        CPPUNIT_ASSERT(inode->SetExtendedAttribute( key,
+                content.data() + i * chunk,
+                min(chunk, content.size() - i * chunk) ));
+    }
+
+    CPPUNIT_ASSERT_MESSAGE( name, parser_.ParseSwiftMeta(testFile) );
 
     inode.reset();
     CPPUNIT_ASSERT( true == meta->DeleteInode(testFile) );
 }
-
@@ -31,6 +31,7 @@ class FileMetaParserTest : public CppUnit::TestFixture
     CPPUNIT_TEST( testMetaSingle );
     CPPUNIT_TEST( testMetaMultiple );
     CPPUNIT_TEST( testMetaMultipleManifest );
+    CPPUNIT_TEST( testMetaGolden );
     CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -40,9 +41,11 @@ public:
     void testMetaSingle();
     void testMetaMultiple();
     void testMetaMultipleManifest();
+    void testMetaGolden();
 
 private:
     void testMetaMultipleSub(int number);
+    void testMetaGoldenSub(const string & name, size_t chunk = 254);
     FileMetaParser parser_;
 };
 
@@ -20,6 +20,7 @@
 
 
 #include "stdafx.h"
+#include <sys/wait.h>
 #include "../FileOperationBitmap.h"
 #include "FileOperationBitmapTest.h"
 
@@ -32,6 +33,76 @@ static const string testFile = "FileOperationBitmapTest";
 static const fs::path fileTest(testFile);
 
 
+static unsigned char
+GetPattern(off_t offset)
+{
+    return (unsigned char)(offset % 251 + 1);
+}
+
+
+//  writes the test file in a child process, which is killed at a random
+//  point; returns the end of the last write the child reported
+static off_t
+WriteAndKill(off_t length, size_t sizeBlock,
+        int saveBlocks, int saveInterval, bool sequential)
+{
+    int fds[2];
+    CPPUNIT_ASSERT( 0 == pipe(fds) );
+    int seed = rand();
+    pid_t pid = fork();
+    CPPUNIT_ASSERT( pid >= 0 );
+    if ( pid == 0 ) {
+        close(fds[0]);
+        srand(seed);
+        FileOperationBitmap file(
+                fileTest,O_RDWR,sizeBlock,saveBlocks,saveInterval);
+        vector<unsigned char> buffer(sizeBlock * 3);
+        off_t offset = 0;
+        while ( true ) {
+            if ( ! sequential && rand() % 4 == 0 ) {
+                offset = rand() % length;
+            }
+            if ( offset >= length ) {
+                if ( sequential ) {
+                    pause();
+                }
+                offset = 0;
+            }
+            size_t size = min( (size_t)(length - offset),
+                    (size_t)(1 + rand() % buffer.size()) );
+            for ( size_t i = 0; i < size; ++ i ) {
+                buffer[i] = GetPattern(offset + i);
+            }
+            size_t written = 0;
+            if ( ! file.Write(offset,&buffer[0],size,written) ) {
+                _exit(1);
+            }
+            offset += written;
+            if ( write(fds[1],&offset,sizeof(offset)) != sizeof(offset) ) {
+                _exit(1);
+            }
+        }
+    }
+
+    close(fds[1]);
+    off_t reported = 0;
+    CPPUNIT_ASSERT( (ssize_t)sizeof(reported)
+            == read(fds[0],&reported,sizeof(reported)) );
+    usleep(rand() % 10000);
+    kill(pid,SIGKILL);
+    int status = 0;
+    waitpid(pid,&status,0);
+    CPPUNIT_ASSERT( WIFSIGNALED(status) );
+
+    off_t value = 0;
+    while ( read(fds[0],&value,sizeof(value)) == sizeof(value) ) {
+        reported = value;
+    }
+    close(fds[0]);
+    return reported;
+}
+
+
 void
 FileOperationBitmapTest::setUp()
 {
@@ -233,3 +304,64 @@ FileOperationBitmapTest::testClose()
     CPPUNIT_ASSERT( true == file->CheckBitmap( 0, bufsize ) );
 }
 
+
+void
+FileOperationBitmapTest::testCrash()
+{
+    const size_t sizeBlock = 4096;
+    const off_t length = sizeBlock * 256;
+    const int saveBlocks = 8;
+    srand(1);
+
+    int claimedTotal = 0;
+    for ( int round = 0; round < 40; ++ round ) {
+        bool sequential = round % 2 == 0;
+        {
+            FileOperationBitmap file(fileTest,0644,O_RDWR,sizeBlock);
+            CPPUNIT_ASSERT( true == file.TruncateBitmap(length) );
+        }
+
+        off_t reported = WriteAndKill( length, sizeBlock,
+                saveBlocks, sequential ? 0 : 5, sequential );
+
+        FileOperationBitmap file(fileTest,O_RDWR,sizeBlock);
+        vector<unsigned char> data(length,0);
+        size_t size = 0;
+        CPPUNIT_ASSERT( true == file.Read(0,&data[0],length,size) );
+
+        //  no block is marked that the child did not write
+        off_t claimed = 0;
+        off_t prefix = -1;
+        for ( off_t b = 0; b < length / (off_t)sizeBlock; ++ b ) {
+            off_t offset = b * sizeBlock;
+            if ( ! file.CheckBitmap(offset,sizeBlock) ) {
+                if ( prefix < 0 ) {
+                    prefix = b;
+                }
+                continue;
+            }
+            ++ claimed;
+            for ( off_t o = offset; o < offset + (off_t)sizeBlock; ++ o ) {
+                CPPUNIT_ASSERT_MESSAGE(
+                        boost::lexical_cast<string>(round) + " " +
+                        boost::lexical_cast<string>(o),
+                        GetPattern(o) == data[o] );
+            }
+        }
+        if ( prefix < 0 ) {
+            prefix = length / sizeBlock;
+        }
+        claimedTotal += claimed;
+
+        //  and at most the pending blocks are lost
+        if ( sequential ) {
+            CPPUNIT_ASSERT_MESSAGE(
+                    boost::lexical_cast<string>(reported) + " " +
+                    boost::lexical_cast<string>(prefix),
+                    reported / (off_t)sizeBlock - prefix < saveBlocks );
+        }
+
+        fs::remove(fileTest);
+    }
+    CPPUNIT_ASSERT( claimedTotal > 0 );
+}
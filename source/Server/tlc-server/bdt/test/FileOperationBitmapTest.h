@@ -30,6 +30,7 @@ class FileOperationBitmapTest : public CppUnit::TestFixture
     CPPUNIT_TEST( testBitmap );
     CPPUNIT_TEST( testBitmapPartial );
     CPPUNIT_TEST( testClose );
+    CPPUNIT_TEST( testCrash );
     CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -41,5 +42,6 @@ public:
     void testBitmap();
     void testBitmapPartial();
     void testClose();
+    void testCrash();
 };
 
@@ -0,0 +1,237 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * FolderIdCacheTest.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+
+#include "stdafx.h"
+#include "../FolderIdCache.h"
+#include "FolderIdCacheTest.h"
+
+
+CPPUNIT_TEST_SUITE_REGISTRATION( FolderIdCacheTest );
+
+
+static bool
+GetId(FolderIdCache & cache, const string & path, long long & id)
+{
+    unsigned long long version;
+    return cache.Get(path, id, version);
+}
+
+
+static void
+PutId(FolderIdCache & cache, const string & path, long long id)
+{
+    long long unused;
+    unsigned long long version;
+    cache.Get(path, unused, version);
+    cache.Put(path, id, version);
+}
+
+
+//  /d<i>/ for the first level, /d<i>/d<j>/ below it
+static string
+GetFolder(int i, int j)
+{
+    string path = "/d" + boost::lexical_cast<string>(i) + "/";
+    if ( j >= 0 ) {
+        path += "d" + boost::lexical_cast<string>(j) + "/";
+    }
+    return path;
+}
+
+
+void
+FolderIdCacheTest::setUp()
+{
+}
+
+
+void
+FolderIdCacheTest::tearDown()
+{
+}
+
+
+void
+FolderIdCacheTest::testLRU()
+{
+    FolderIdCache cache(3);
+    long long id = 0;
+
+    CPPUNIT_ASSERT( false == GetId(cache, "/a/", id) );
+    PutId(cache, "/a/", 1);
+    PutId(cache, "/b/", 2);
+    PutId(cache, "/c/", 3);
+    CPPUNIT_ASSERT( true == GetId(cache, "/a/", id) );
+    CPPUNIT_ASSERT( 1 == id );
+
+    //  /b/ is the least recently used one
+    PutId(cache, "/d/", 4);
+    CPPUNIT_ASSERT( 3 == cache.Size() );
+    CPPUNIT_ASSERT( false == GetId(cache, "/b/", id) );
+    CPPUNIT_ASSERT( true == GetId(cache, "/a/", id) );
+    CPPUNIT_ASSERT( true == GetId(cache, "/c/", id) );
+    CPPUNIT_ASSERT( true == GetId(cache, "/d/", id) );
+    CPPUNIT_ASSERT( 4 == id );
+
+    PutId(cache, "/d/", 5);
+    CPPUNIT_ASSERT( true == GetId(cache, "/d/", id) );
+    CPPUNIT_ASSERT( 5 == id );
+    CPPUNIT_ASSERT( 3 == cache.Size() );
+
+    cache.Clear();
+    CPPUNIT_ASSERT( 0 == cache.Size() );
+
+    FolderIdCache disabled(0);
+    PutId(disabled, "/a/", 1);
+    CPPUNIT_ASSERT( false == GetId(disabled, "/a/", id) );
+}
+
+
+void
+FolderIdCacheTest::testRename()
+{
+    FolderIdCache cache(100);
+    long long id = 0;
+
+    PutId(cache, "/a/", 1);
+    PutId(cache, "/a/b/", 2);
+    PutId(cache, "/a/b/c/", 3);
+    PutId(cache, "/ab/", 4);
+    PutId(cache, "/x/", 5);
+    PutId(cache, "/x/old/", 6);
+
+    //  /x/ is overridden, /ab/ only shares the first letters
+    cache.Rename("/a/", "/x/");
+    CPPUNIT_ASSERT( false == GetId(cache, "/a/", id) );
+    CPPUNIT_ASSERT( false == GetId(cache, "/a/b/", id) );
+    CPPUNIT_ASSERT( false == GetId(cache, "/x/old/", id) );
+    CPPUNIT_ASSERT( true == GetId(cache, "/x/", id) );
+    CPPUNIT_ASSERT( 1 == id );
+    CPPUNIT_ASSERT( true == GetId(cache, "/x/b/", id) );
+    CPPUNIT_ASSERT( 2 == id );
+    CPPUNIT_ASSERT( true == GetId(cache, "/x/b/c/", id) );
+    CPPUNIT_ASSERT( 3 == id );
+    CPPUNIT_ASSERT( true == GetId(cache, "/ab/", id) );
+    CPPUNIT_ASSERT( 4 == id );
+    CPPUNIT_ASSERT( 4 == cache.Size() );
+
+    //  into a folder below itself
+    cache.Rename("/x/b/", "/x/b/c/b/");
+    CPPUNIT_ASSERT( true == GetId(cache, "/x/b/c/b/", id) );
+    CPPUNIT_ASSERT( 2 == id );
+    CPPUNIT_ASSERT( true == GetId(cache, "/x/b/c/b/c/", id) );
+    CPPUNIT_ASSERT( 3 == id );
+    CPPUNIT_ASSERT( false == GetId(cache, "/x/b/", id) );
+
+    cache.Erase("/x/");
+    CPPUNIT_ASSERT( 1 == cache.Size() );
+    CPPUNIT_ASSERT( true == GetId(cache, "/ab/", id) );
+}
+
+
+void
+FolderIdCacheTest::testVersion()
+{
+    FolderIdCache cache(100);
+    long long id = 0;
+    unsigned long long version;
+
+    //  the id read from the catalog before the rename is stale
+    CPPUNIT_ASSERT( false == cache.Get("/a/", id, version) );
+    cache.Rename("/a/", "/b/");
+    cache.Put("/a/", 1, version);
+    CPPUNIT_ASSERT( false == GetId(cache, "/a/", id) );
+
+    CPPUNIT_ASSERT( false == cache.Get("/a/", id, version) );
+    cache.Erase("/c/");
+    cache.Put("/a/", 1, version);
+    CPPUNIT_ASSERT( false == GetId(cache, "/a/", id) );
+
+    CPPUNIT_ASSERT( false == cache.Get("/a/", id, version) );
+    cache.Put("/a/", 1, version);
+    CPPUNIT_ASSERT( true == GetId(cache, "/a/", id) );
+    CPPUNIT_ASSERT( 1 == id );
+}
+
+
+void
+FolderIdCacheTest::testPerformance()
+{
+    //  1M folders, a thousand first level ones with a thousand below each
+    const int count = 1000;
+    FolderIdCache cache(count * count + count);
+    vector<string> paths;
+    paths.reserve(count * count);
+    for ( int i = 0; i < count; ++ i ) {
+        for ( int j = 0; j < count; ++ j ) {
+            paths.push_back(GetFolder(i, j));
+        }
+    }
+
+    boost::posix_time::ptime begin =
+            boost::posix_time::microsec_clock::local_time();
+    for ( size_t i = 0; i < paths.size(); ++ i ) {
+        PutId(cache, paths[i], i + 1);
+    }
+    for ( int i = 0; i < count; ++ i ) {
+        PutId(cache, GetFolder(i, -1), 0);
+    }
+    boost::posix_time::ptime loaded =
+            boost::posix_time::microsec_clock::local_time();
+
+    srand(1);
+    const int lookups = 1000 * 1000;
+    size_t found = 0;
+    for ( int i = 0; i < lookups; ++ i ) {
+        long long id;
+        size_t k = rand() % paths.size();
+        if ( GetId(cache, paths[k], id) && id == (long long)k + 1 ) {
+            ++ found;
+        }
+    }
+    boost::posix_time::ptime looked =
+            boost::posix_time::microsec_clock::local_time();
+
+    //  renames of first level folders, a thousand cached folders each
+    const int renames = 100;
+    for ( int i = 0; i < renames; ++ i ) {
+        cache.Rename(GetFolder(i, -1),
+                "/renamed" + boost::lexical_cast<string>(i) + "/");
+    }
+    boost::posix_time::ptime renamed =
+            boost::posix_time::microsec_clock::local_time();
+
+    CPPUNIT_ASSERT( lookups == (int)found );
+    CPPUNIT_ASSERT( (size_t)(count * count + count) == cache.Size() );
+    long long id;
+    CPPUNIT_ASSERT( true == GetId(cache, "/renamed0/d5/", id) );
+    CPPUNIT_ASSERT( 6 == id );
+    CPPUNIT_ASSERT( false == GetId(cache, GetFolder(0, 5), id) );
+
+    double lookup = (looked - loaded).total_microseconds() / (double)lookups;
+    double rename = (renamed - looked).total_microseconds() / 1000.0 / renames;
+    cout << endl << paths.size() << " folders cached in "
+            << (loaded - begin).total_milliseconds() << " ms, lookup "
+            << lookup << " us, rename of " << count << " folders "
+            << rename << " ms" << endl;
+    CPPUNIT_ASSERT( lookup < 50 );
+    CPPUNIT_ASSERT( rename < 500 );
+}
@@ -0,0 +1,406 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * InodeTab * FuseBDTLowLevelTest.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+
+#include "stdafx.h"
+#include "../MetaManager.h"
+#include "../CacheManager.h"
+#include "../FileOperationInterface.h"
+#include "../../FuseBase.h"
+#include "../../FuseBDTLowLevel.h"
+#include "FuseBDTLowLevelTest.h"
+
+
+CPPUNIT_TEST_SUITE_REGISTRATION( FuseBDTLowLevelTest );
+
+
+static const string metaFolder = "meta.folder";
+static const string cacheFolder = "cache.folder";
+
+
+//  the replies of the frontend are kept in the request instead of being
+//  sent to the kernel
+struct fuse_req
+{
+    void * userdata;
+    int error;
+    struct fuse_entry_param entry;
+    struct stat attr;
+    struct fuse_file_info info;
+    string buffer;
+};
+
+
+//  what the fake fuse_add_direntry writes in front of every name
+struct DirEntry
+{
+    ino_t ino;
+    off_t offset;
+    size_t size;
+};
+
+
+extern "C"
+{
+
+void * fuse_req_userdata(fuse_req_t req)
+{
+    return req->userdata;
+}
+
+
+const struct fuse_ctx * fuse_req_ctx(fuse_req_t)
+{
+    static struct fuse_ctx context = { 0, 0, 0, 0 };
+    return &context;
+}
+
+
+int fuse_reply_err(fuse_req_t req, int err)
+{
+    req->error = err;
+    return 0;
+}
+
+
+void fuse_reply_none(fuse_req_t req)
+{
+    req->error = 0;
+}
+
+
+int fuse_reply_entry(fuse_req_t req, const struct fuse_entry_param * e)
+{
+    req->error = 0;
+    req->entry = *e;
+    return 0;
+}
+
+
+int fuse_reply_create(fuse_req_t req, const struct fuse_entry_param * e,
+        const struct fuse_file_info * fi)
+{
+    req->error = 0;
+    req->entry = *e;
+    req->info = *fi;
+    return 0;
+}
+
+
+int fuse_reply_attr(fuse_req_t req, const struct stat * attr, double)
+{
+    req->error = 0;
+    req->attr = *attr;
+    return 0;
+}
+
+
+int fuse_reply_open(fuse_req_t req, const struct fuse_file_info * fi)
+{
+    req->error = 0;
+    req->info = *fi;
+    return 0;
+}
+
+
+int fuse_reply_write(fuse_req_t req, size_t)
+{
+    req->error = 0;
+    return 0;
+}
+
+
+int fuse_reply_buf(fuse_req_t req, const char * buf, size_t size)
+{
+    req->error = 0;
+    req->buffer.assign(buf ? buf : "", size);
+    return 0;
+}
+
+
+int fuse_reply_statfs(fuse_req_t req, const struct statvfs *)
+{
+    req->error = 0;
+    return 0;
+}
+
+
+int fuse_reply_xattr(fuse_req_t req, size_t)
+{
+    req->error = 0;
+    return 0;
+}
+
+
+size_t fuse_add_direntry(fuse_req_t, char * buf, size_t bufsize,
+        const char * name, const struct stat * stbuf, off_t off)
+{
+    size_t size = sizeof(DirEntry) + strlen(name);
+    if ( NULL == buf || bufsize < size ) {
+        return size;
+    }
+    DirEntry entry;
+    entry.ino = stbuf->st_ino;
+    entry.offset = off;
+    entry.size = size;
+    memcpy(buf, &entry, sizeof(entry));
+    memcpy(buf + sizeof(entry), name, strlen(name));
+    return size;
+}
+
+}
+
+
+//  the path based frontend reduced to what lookup, getattr and readdir
+//  need, straight on the meta manager
+class FuseMeta : public FuseBase
+{
+public:
+    virtual int getattr (const char * pathname, struct stat * stbuf)
+    {
+        if ( ! Factory::GetMetaManager()->GetStat(pathname, *stbuf) ) {
+            return - errno;
+        }
+        return 0;
+    }
+
+    virtual int opendir(const char * pathname, struct fuse_file_info * info)
+    {
+        auto_ptr<Inode> inode(
+                Factory::GetMetaManager()->GetInode(pathname) );
+        if ( NULL == inode.get() ) {
+            return - ENOENT;
+        }
+        info->fh = reinterpret_cast<uint64_t>( ::opendir(
+                inode->Path().string().c_str() ) );
+        return info->fh == 0 ? - errno : 0;
+    }
+
+    virtual int readdir(const char * pathname, void * buf,
+            fuse_fill_dir_t filler, off_t, struct fuse_file_info * info)
+    {
+        DIR * dir = reinterpret_cast<DIR *>(info->fh);
+        FolderEntry entry;
+        while ( Factory::GetMetaManager()->ReadFolder(
+                pathname, dir, entry ) ) {
+            filler( buf, entry.name.c_str(), &entry.stat, entry.offset );
+        }
+        return - errno;
+    }
+
+    virtual int releasedir(const char *, struct fuse_file_info * info)
+    {
+        ::closedir( reinterpret_cast<DIR *>(info->fh) );
+        return 0;
+    }
+};
+
+
+static struct fuse_req
+MakeRequest(FuseBDTLowLevel & fuse)
+{
+    struct fuse_req req;
+    req.userdata = &fuse;
+    req.error = -1;
+    memset(&req.entry, 0, sizeof(req.entry));
+    memset(&req.attr, 0, sizeof(req.attr));
+    memset(&req.info, 0, sizeof(req.info));
+    return req;
+}
+
+
+static fuse_ino_t
+Lookup(FuseBDTLowLevel & fuse, fuse_ino_t parent, const char * name)
+{
+    struct fuse_req req = MakeRequest(fuse);
+    FuseBDTLowLevel::FuseOperations.lookup(&req, parent, name);
+    CPPUNIT_ASSERT( 0 == req.error );
+    CPPUNIT_ASSERT( req.entry.ino == req.entry.attr.st_ino );
+    return req.entry.ino;
+}
+
+
+static struct stat
+GetAttr(FuseBDTLowLevel & fuse, fuse_ino_t ino)
+{
+    struct fuse_req req = MakeRequest(fuse);
+    FuseBDTLowLevel::FuseOperations.getattr(&req, ino, NULL);
+    CPPUNIT_ASSERT( 0 == req.error );
+    return req.attr;
+}
+
+
+static ino_t
+GetStubInode(const fs::path & path)
+{
+    struct stat stat;
+    fs::path pathStub = Factory::GetMetaFolder() / Factory::GetService();
+    pathStub /= path;
+    CPPUNIT_ASSERT_ERRNO_( 0 == ::lstat( pathStub.string().c_str(), &stat ) );
+    return stat.st_ino;
+}
+
+
+void
+FuseBDTLowLevelTest::setUp()
+{
+    fs::create_directory(metaFolder);
+    fs::create_directory(cacheFolder);
+
+    Factory::SetCacheFolder(cacheFolder);
+    Factory::CreateCacheManager();
+    Factory::CreateReadManager();
+    Factory::SetMetaFolder(metaFolder);
+    Factory::CreateMetaManager();
+}
+
+
+void
+FuseBDTLowLevelTest::tearDown()
+{
+    Factory::ReleaseMetaManager();
+    Factory::ReleaseReadManager();
+    Factory::ReleaseCacheManager();
+
+    fs::remove_all(metaFolder);
+    fs::remove_all(cacheFolder);
+}
+
+
+void
+FuseBDTLowLevelTest::testLookup()
+{
+    MetaManager * meta = Factory::GetMetaManager();
+    FuseMeta bdt;
+    FuseBDTLowLevel fuse(&bdt);
+
+    CPPUNIT_ASSERT( meta->CreateFolder("/folder", 0700) );
+    CPPUNIT_ASSERT( meta->CreateFile("/folder/file", 0600) );
+
+    fuse_ino_t folder = Lookup(fuse, FUSE_ROOT_ID, "folder");
+    fuse_ino_t file = Lookup(fuse, folder, "file");
+    CPPUNIT_ASSERT( folder == GetStubInode("/folder") );
+    CPPUNIT_ASSERT( file == GetStubInode("/folder/file") );
+    CPPUNIT_ASSERT( file == Lookup(fuse, folder, "file") );
+
+    CPPUNIT_ASSERT( file == GetAttr(fuse, file).st_ino );
+    CPPUNIT_ASSERT( S_ISREG(GetAttr(fuse, file).st_mode) );
+    CPPUNIT_ASSERT( S_ISDIR(GetAttr(fuse, folder).st_mode) );
+
+    struct fuse_req req = MakeRequest(fuse);
+    FuseBDTLowLevel::FuseOperations.lookup(&req, folder, "none");
+    CPPUNIT_ASSERT( ENOENT == req.error );
+
+    req = MakeRequest(fuse);
+    FuseBDTLowLevel::FuseOperations.getattr(&req, file + folder, NULL);
+    CPPUNIT_ASSERT( ENOENT == req.error );
+}
+
+
+void
+FuseBDTLowLevelTest::testGetattrOpen()
+{
+    MetaManager * meta = Factory::GetMetaManager();
+    FuseMeta bdt;
+    FuseBDTLowLevel fuse(&bdt);
+
+    CPPUNIT_ASSERT( meta->CreateFile("/file", 0600) );
+    fuse_ino_t file = Lookup(fuse, FUSE_ROOT_ID, "file");
+
+    //  an open file reports the size of its cache file, its inode number
+    //  stays the one of the meta stub
+    auto_ptr<FileOperationInterface> operation(
+            meta->GetFileOperation("/file", O_RDWR) );
+    CPPUNIT_ASSERT( NULL != operation.get() );
+    char buffer[1000];
+    memset(buffer, 'a', sizeof(buffer));
+    size_t size = 0;
+    CPPUNIT_ASSERT( operation->Write(0, buffer, sizeof(buffer), size) );
+    CPPUNIT_ASSERT( sizeof(buffer) == size );
+
+    struct stat stat = GetAttr(fuse, file);
+    CPPUNIT_ASSERT( file == stat.st_ino );
+    CPPUNIT_ASSERT( sizeof(buffer) == stat.st_size );
+    CPPUNIT_ASSERT( file == Lookup(fuse, FUSE_ROOT_ID, "file") );
+    CPPUNIT_ASSERT( file == GetStubInode("/file") );
+
+    operation.reset();
+    CPPUNIT_ASSERT( file == Lookup(fuse, FUSE_ROOT_ID, "file") );
+}
+
+
+void
+FuseBDTLowLevelTest::testReaddir()
+{
+    MetaManager * meta = Factory::GetMetaManager();
+    FuseMeta bdt;
+    FuseBDTLowLevel fuse(&bdt);
+
+    CPPUNIT_ASSERT( meta->CreateFolder("/folder", 0700) );
+    CPPUNIT_ASSERT( meta->CreateFile("/folder/file0", 0600) );
+    CPPUNIT_ASSERT( meta->CreateFile("/folder/file1", 0600) );
+    CPPUNIT_ASSERT( meta->CreateFolder("/folder/sub", 0700) );
+    fuse_ino_t folder = Lookup(fuse, FUSE_ROOT_ID, "folder");
+
+    struct fuse_req req = MakeRequest(fuse);
+    FuseBDTLowLevel::FuseOperations.opendir(&req, folder, &req.info);
+    CPPUNIT_ASSERT( 0 == req.error );
+    struct fuse_file_info info = req.info;
+
+    //  a small buffer makes the listing take several calls
+    map<string, ino_t> names;
+    off_t offset = 0;
+    for ( ; ; ) {
+        req = MakeRequest(fuse);
+        FuseBDTLowLevel::FuseOperations.readdir(
+                &req, folder, 48, offset, &info );
+        CPPUNIT_ASSERT( 0 == req.error );
+        if ( req.buffer.empty() ) {
+            break;
+        }
+        size_t position = 0;
+        while ( position + sizeof(DirEntry) <= req.buffer.size() ) {
+            DirEntry entry;
+            memcpy(&entry, &req.buffer[position], sizeof(entry));
+            if ( position + entry.size > req.buffer.size() ) {
+                break;
+            }
+            names[ req.buffer.substr( position + sizeof(entry),
+                    entry.size - sizeof(entry) ) ] = entry.ino;
+            position += entry.size;
+            offset = entry.offset;
+        }
+        CPPUNIT_ASSERT( position > 0 );
+    }
+
+    req = MakeRequest(fuse);
+    FuseBDTLowLevel::FuseOperations.releasedir(&req, folder, &info);
+    CPPUNIT_ASSERT( 0 == req.error );
+
+    CPPUNIT_ASSERT( 5 == names.size() );
+    CPPUNIT_ASSERT( names.count(".") && names.count("..") );
+    CPPUNIT_ASSERT( names["file0"] == GetStubInode("/folder/file0") );
+    CPPUNIT_ASSERT( names["file1"] == GetStubInode("/folder/file1") );
+    CPPUNIT_ASSERT( names["sub"] == GetStubInode("/folder/sub") );
+
+    //  the inode numbers of the listing are the ones of a lookup
+    CPPUNIT_ASSERT( names["file0"] == Lookup(fuse, folder, "file0") );
+    CPPUNIT_ASSERT( names["sub"] == Lookup(fuse, folder, "sub") );
+}
@@ -0,0 +1,247 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * InodeTableTest.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: agent
+ */
+
+
+#include "stdafx.h"
+#include "../MetaManager.h"
+#include "../CacheManager.h"
+#include "../InodeTable.h"
+#include "InodeTableTest.h"
+
+
+CPPUNIT_TEST_SUITE_REGISTRATION( InodeTableTest );
+
+
+static const string metaFolder = "meta.folder";
+static const string cacheFolder = "cache.folder";
+
+
+//  the same steps as the lookup of the low level fuse frontend
+static unsigned long long
+LookupInode(InodeTable & table, const fs::path & path)
+{
+    auto_ptr<Inode> inode( Factory::GetMetaManager()->GetInode(path) );
+    CPPUNIT_ASSERT( NULL != inode.get() );
+    struct stat stat;
+    CPPUNIT_ASSERT( inode->GetStat(stat) );
+    unsigned long long ino = table.Lookup(path, stat);
+    CPPUNIT_ASSERT( ino == stat.st_ino );
+    return ino;
+}
+
+
+static fs::path
+GetInodePath(InodeTable & table, unsigned long long ino)
+{
+    fs::path path;
+    CPPUNIT_ASSERT( table.GetPath(ino, path) );
+    return path;
+}
+
+
+void
+InodeTableTest::setUp()
+{
+    fs::create_directory(metaFolder);
+    fs::create_directory(cacheFolder);
+
+    Factory::SetCacheFolder(cacheFolder);
+    Factory::CreateCacheManager();
+    Factory::CreateReadManager();
+    Factory::SetMetaFolder(metaFolder);
+    Factory::CreateMetaManager();
+}
+
+
+void
+InodeTableTest::tearDown()
+{
+    Factory::ReleaseMetaManager();
+    Factory::ReleaseReadManager();
+    Factory::ReleaseCacheManager();
+
+    fs::remove_all(metaFolder);
+    fs::remove_all(cacheFolder);
+}
+
+
+void
+InodeTableTest::testLookup()
+{
+    MetaManager * meta = Factory::GetMetaManager();
+    InodeTable table;
+
+    CPPUNIT_ASSERT( 1 == table.Size() );
+    CPPUNIT_ASSERT( "/" == GetInodePath(table, InodeTable::RootInode) );
+
+    CPPUNIT_ASSERT( meta->CreateFile("/file", 0600) );
+    CPPUNIT_ASSERT( meta->CreateFolder("/folder", 0700) );
+
+    unsigned long long file = LookupInode(table, "/file");
+    unsigned long long folder = LookupInode(table, "/folder");
+    CPPUNIT_ASSERT( file != folder );
+    CPPUNIT_ASSERT( file != InodeTable::RootInode );
+    CPPUNIT_ASSERT( 3 == table.Size() );
+
+    CPPUNIT_ASSERT( file == LookupInode(table, "/file") );
+    CPPUNIT_ASSERT( 3 == table.Size() );
+    CPPUNIT_ASSERT( "/file" == GetInodePath(table, file) );
+    CPPUNIT_ASSERT( "/folder" == GetInodePath(table, folder) );
+
+    fs::path path;
+    CPPUNIT_ASSERT( ! table.GetPath(file + folder, path) );
+    CPPUNIT_ASSERT( ENOENT == errno );
+
+    //  a stub on the number of the root folder is refused, not mapped
+    struct stat stat;
+    memset(&stat, 0, sizeof(stat));
+    stat.st_ino = InodeTable::RootInode;
+    CPPUNIT_ASSERT( 0 == table.Lookup("/other", stat) );
+    CPPUNIT_ASSERT( EIO == errno );
+    CPPUNIT_ASSERT( 3 == table.Size() );
+    CPPUNIT_ASSERT( "/" == GetInodePath(table, InodeTable::RootInode) );
+}
+
+
+void
+InodeTableTest::testForget()
+{
+    MetaManager * meta = Factory::GetMetaManager();
+    InodeTable table;
+
+    CPPUNIT_ASSERT( meta->CreateFile("/file", 0600) );
+    unsigned long long file = LookupInode(table, "/file");
+    CPPUNIT_ASSERT( file == LookupInode(table, "/file") );
+
+    fs::path path;
+    table.Forget(file, 1);
+    CPPUNIT_ASSERT( table.GetPath(file, path) );
+    table.Forget(file, 1);
+    CPPUNIT_ASSERT( ! table.GetPath(file, path) );
+    CPPUNIT_ASSERT( 1 == table.Size() );
+
+    //  the kernel gets the same number on the next lookup
+    CPPUNIT_ASSERT( file == LookupInode(table, "/file") );
+
+    table.Forget(InodeTable::RootInode, 100);
+    CPPUNIT_ASSERT( table.GetPath(InodeTable::RootInode, path) );
+}
+
+
+void
+InodeTableTest::testRenameFile()
+{
+    MetaManager * meta = Factory::GetMetaManager();
+    InodeTable table;
+
+    CPPUNIT_ASSERT( meta->CreateFolder("/folder", 0700) );
+    CPPUNIT_ASSERT( meta->CreateFile("/file", 0600) );
+    unsigned long long file = LookupInode(table, "/file");
+
+    CPPUNIT_ASSERT( meta->RenameInode("/file", "/renamed") );
+    table.Rename("/file", "/renamed");
+    CPPUNIT_ASSERT( "/renamed" == GetInodePath(table, file) );
+    CPPUNIT_ASSERT( file == LookupInode(table, "/renamed") );
+
+    CPPUNIT_ASSERT( meta->RenameInode("/renamed", "/folder/file") );
+    table.Rename("/renamed", "/folder/file");
+    CPPUNIT_ASSERT( "/folder/file" == GetInodePath(table, file) );
+    CPPUNIT_ASSERT( file == LookupInode(table, "/folder/file") );
+    CPPUNIT_ASSERT( 2 == table.Size() );
+}
+
+
+void
+InodeTableTest::testRenameFileOverride()
+{
+    MetaManager * meta = Factory::GetMetaManager();
+    InodeTable table;
+
+    CPPUNIT_ASSERT( meta->CreateFile("/file", 0600) );
+    CPPUNIT_ASSERT( meta->CreateFile("/target", 0600) );
+    unsigned long long file = LookupInode(table, "/file");
+    unsigned long long target = LookupInode(table, "/target");
+
+    CPPUNIT_ASSERT( meta->RenameInode("/file", "/target") );
+    table.Rename("/file", "/target");
+
+    fs::path path;
+    CPPUNIT_ASSERT( ! table.GetPath(target, path) );
+    CPPUNIT_ASSERT( "/target" == GetInodePath(table, file) );
+    CPPUNIT_ASSERT( file == LookupInode(table, "/target") );
+
+    table.Forget(target, 1);
+    CPPUNIT_ASSERT( 2 == table.Size() );
+}
+
+
+void
+InodeTableTest::testRenameFolder()
+{
+    MetaManager * meta = Factory::GetMetaManager();
+    InodeTable table;
+
+    CPPUNIT_ASSERT( meta->CreateFolder("/folder", 0700) );
+    CPPUNIT_ASSERT( meta->CreateFolder("/folder/sub", 0700) );
+    CPPUNIT_ASSERT( meta->CreateFile("/folder/file", 0600) );
+    CPPUNIT_ASSERT( meta->CreateFile("/folder/sub/file", 0600) );
+    CPPUNIT_ASSERT( meta->CreateFile("/folder-other", 0600) );
+
+    unsigned long long folder = LookupInode(table, "/folder");
+    unsigned long long sub = LookupInode(table, "/folder/sub");
+    unsigned long long file = LookupInode(table, "/folder/file");
+    unsigned long long subfile = LookupInode(table, "/folder/sub/file");
+    unsigned long long other = LookupInode(table, "/folder-other");
+
+    CPPUNIT_ASSERT( meta->RenameInode("/folder", "/renamed") );
+    table.Rename("/folder", "/renamed");
+
+    CPPUNIT_ASSERT( "/renamed" == GetInodePath(table, folder) );
+    CPPUNIT_ASSERT( "/renamed/sub" == GetInodePath(table, sub) );
+    CPPUNIT_ASSERT( "/renamed/file" == GetInodePath(table, file) );
+    CPPUNIT_ASSERT( "/renamed/sub/file" == GetInodePath(table, subfile) );
+    CPPUNIT_ASSERT( "/folder-other" == GetInodePath(table, other) );
+
+    CPPUNIT_ASSERT( folder == LookupInode(table, "/renamed") );
+    CPPUNIT_ASSERT( sub == LookupInode(table, "/renamed/sub") );
+    CPPUNIT_ASSERT( file == LookupInode(table, "/renamed/file") );
+    CPPUNIT_ASSERT( subfile == LookupInode(table, "/renamed/sub/file") );
+    CPPUNIT_ASSERT( 6 == table.Size() );
+}
+
+
+void
+InodeTableTest::testDelete()
+{
+    MetaManager * meta = Factory::GetMetaManager();
+    InodeTable table;
+
+    CPPUNIT_ASSERT( meta->CreateFile("/file", 0600) );
+    unsigned long long file = LookupInode(table, "/file");
+
+    CPPUNIT_ASSERT( meta->DeleteInode("/file") );
+    table.Remove("/file");
+
+    fs::path path;
+    CPPUNIT_ASSERT( ! table.GetPath(file, path) );
+    CPPUNIT_ASSERT( 2 == table.Size() );
+    table.Forget(file, 1);
+    CPPUNIT_ASSERT( 1 == table.Size() );
+}
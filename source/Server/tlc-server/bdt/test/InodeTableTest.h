@@ -0,0 +1,46 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * InodeTableTest.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: agent
+ */
+
+
+#pragma once
+
+
+class InodeTableTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE( InodeTableTest );
+    CPPUNIT_TEST( testLookup );
+    CPPUNIT_TEST( testForget );
+    CPPUNIT_TEST( testRenameFile );
+    CPPUNIT_TEST( testRenameFileOverride );
+    CPPUNIT_TEST( testRenameFolder );
+    CPPUNIT_TEST( testDelete );
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void setUp();
+    void tearDown();
+
+    void testLookup();
+    void testForget();
+    void testRenameFile();
+    void testRenameFileOverride();
+    void testRenameFolder();
+    void testDelete();
+};
@@ -23,6 +23,7 @@
 #include "../MetaManager.h"
 #include "../CacheManager.h"
 #include "../FileOperationDelay.h"
+#include "../AttributeCache.h"
 #include "MetaManagerTest.h"
 
 
@@ -57,6 +58,10 @@ MetaManagerTest::tearDown()
     Factory::ReleaseMetaManager();
     Factory::ReleaseReadManager();
     Factory::ReleaseCacheManager();
+    Factory::GetConfigure()->SetValue(
+            Configure::AttributeCacheSize, "65536");
+    Factory::GetConfigure()->SetValue(
+            Configure::AttributeCacheTimeout, "5");
 
     fs::remove_all(metaFolder);
     fs::remove_all(metaFolderNone);
@@ -692,3 +697,353 @@ MetaManagerTest::testPersist()
     meta->GetBackupList(list);
     CPPUNIT_ASSERT( 3 == list.size() );
 }
+
+
+static void
+ReadFolder(const fs::path & path, map<string, FolderEntry> & entries)
+{
+    MetaManager * meta = Factory::GetMetaManager();
+    DIR * dir = ::opendir( (fs::path(metaFolder) / path).string().c_str() );
+    CPPUNIT_ASSERT( NULL != dir );
+
+    entries.clear();
+    FolderEntry entry;
+    while ( meta->ReadFolder(path, dir, entry) ) {
+        CPPUNIT_ASSERT( entries.find(entry.name) == entries.end() );
+        entries[entry.name] = entry;
+    }
+    CPPUNIT_ASSERT( 0 == errno );
+    ::closedir(dir);
+}
+
+
+void
+MetaManagerTest::testReadFolder()
+{
+    MetaManager * meta = Factory::GetMetaManager();
+    map<string, FolderEntry> entries;
+    char buffer[4096];
+    size_t size;
+
+    CPPUNIT_ASSERT( true == meta->CreateFolder("/folder",0755) );
+    CPPUNIT_ASSERT( true == meta->CreateFolder("/folder/sub",0755) );
+    CPPUNIT_ASSERT( true == meta->CreateFile("/folder/empty",0644) );
+    CPPUNIT_ASSERT( true == meta->CreateFile("/folder/sized",0644) );
+    CPPUNIT_ASSERT( true == meta->CreateFile("/folder/open",0644) );
+    auto_ptr<Inode> inode( meta->GetInode("/folder/sized") );
+    CPPUNIT_ASSERT( true == inode->SetSize(100000) );
+
+    auto_ptr<FileOperationInterface> file(
+            meta->GetFileOperation("/folder/open",O_RDWR) );
+    memset(buffer,'a',sizeof(buffer));
+    CPPUNIT_ASSERT( true == file->Write(0,buffer,sizeof(buffer),size) );
+
+    ReadFolder("/folder", entries);
+    CPPUNIT_ASSERT( 6 == entries.size() );
+    CPPUNIT_ASSERT( entries.find(".") != entries.end() );
+    CPPUNIT_ASSERT( entries.find("..") != entries.end() );
+    CPPUNIT_ASSERT( S_ISDIR(entries["sub"].stat.st_mode) );
+    CPPUNIT_ASSERT( S_ISREG(entries["empty"].stat.st_mode) );
+    CPPUNIT_ASSERT( 0 == entries["empty"].stat.st_size );
+    CPPUNIT_ASSERT( 100000 == entries["sized"].stat.st_size );
+    CPPUNIT_ASSERT( (100000 + 511) / 512 == entries["sized"].stat.st_blocks );
+    CPPUNIT_ASSERT( 4096 == entries["open"].stat.st_size );
+
+    //  the same attributes as getattr, with the inode number of the stub
+    const char * names[] = { "sub", "empty", "sized", "open" };
+    BOOST_FOREACH( const char * name, names ) {
+        struct stat stat, stub;
+        fs::path path = fs::path("/folder") / name;
+        CPPUNIT_ASSERT( true == meta->GetStat(path,stat) );
+        CPPUNIT_ASSERT( stat.st_size == entries[name].stat.st_size );
+        CPPUNIT_ASSERT( stat.st_mode == entries[name].stat.st_mode );
+        CPPUNIT_ASSERT( 0 == ::lstat(
+                (fs::path(metaFolder) / path).string().c_str(), &stub ) );
+        CPPUNIT_ASSERT( stub.st_ino == entries[name].stat.st_ino );
+    }
+
+    //  a changed size is seen after the attribute is invalidated
+    CPPUNIT_ASSERT( true == inode->SetSize(200000) );
+    meta->InvalidateAttribute("/folder/sized");
+    ReadFolder("/folder", entries);
+    CPPUNIT_ASSERT( 200000 == entries["sized"].stat.st_size );
+}
+
+
+void
+MetaManagerTest::testReadFolderLarge()
+{
+    const int count = 50000;
+    const fs::path folder = "/large";
+
+    //  compare with a getattr per entry, without the attribute cache
+    Factory::ReleaseMetaManager();
+    Factory::GetConfigure()->SetValue(Configure::AttributeCacheSize, "0");
+    Factory::CreateMetaManager();
+    MetaManager * meta = Factory::GetMetaManager();
+
+    CPPUNIT_ASSERT( true == meta->CreateFolder(folder,0755) );
+    for ( int i = 0; i < count; ++ i ) {
+        fs::path path = folder / ( "object" + boost::lexical_cast<string>(i) );
+        int handle = ::creat(
+                (fs::path(metaFolder) / path).string().c_str(), 0644 );
+        CPPUNIT_ASSERT( handle >= 0 );
+        Inode inode(handle);
+        CPPUNIT_ASSERT( true == inode.SetSize(i) );
+        ::close(handle);
+    }
+
+    DIR * dir = ::opendir( (fs::path(metaFolder) / folder).string().c_str() );
+    CPPUNIT_ASSERT( NULL != dir );
+
+    boost::posix_time::ptime begin =
+            boost::posix_time::microsec_clock::local_time();
+    int found = 0;
+    struct dirent * ent;
+    while ( NULL != ( ent = ::readdir(dir) ) ) {
+        struct stat stat;
+        CPPUNIT_ASSERT( true == meta->GetStat(folder / ent->d_name,stat) );
+        ++ found;
+    }
+    boost::posix_time::ptime middle =
+            boost::posix_time::microsec_clock::local_time();
+
+    ::rewinddir(dir);
+    vector<FolderEntry> entries;
+    FolderEntry entry;
+    while ( meta->ReadFolder(folder,dir,entry) ) {
+        entries.push_back(entry);
+    }
+    boost::posix_time::ptime end =
+            boost::posix_time::microsec_clock::local_time();
+
+    cout << endl << count << " entries, getattr per entry: "
+            << (middle - begin).total_milliseconds() << " ms, one pass: "
+            << (end - middle).total_milliseconds() << " ms" << endl;
+
+    CPPUNIT_ASSERT( count + 2 == found );
+    CPPUNIT_ASSERT( count + 2 == entries.size() );
+    BOOST_FOREACH( const FolderEntry & entry, entries ) {
+        if ( entry.name == "." || entry.name == ".." ) {
+            continue;
+        }
+        CPPUNIT_ASSERT( boost::lexical_cast<off_t>( entry.name.substr(6) )
+                == entry.stat.st_size );
+    }
+
+    //  a listing resumes after the offset of the last entry filled
+    ::seekdir(dir, entries[count / 2].offset);
+    CPPUNIT_ASSERT( true == meta->ReadFolder(folder,dir,entry) );
+    CPPUNIT_ASSERT( entries[count / 2 + 1].name == entry.name );
+    CPPUNIT_ASSERT( entries[count / 2 + 1].stat.st_size == entry.stat.st_size );
+    ::seekdir(dir, entries[count + 1].offset);
+    CPPUNIT_ASSERT( false == meta->ReadFolder(folder,dir,entry) );
+
+    //  with the attribute cache, the getattr following the listing of
+    //  every entry is a hit. The sizes are changed behind the cache, so a
+    //  getattr reading the meta folder would see the new one.
+    Factory::ReleaseMetaManager();
+    Factory::GetConfigure()->SetValue(Configure::AttributeCacheSize,
+            boost::lexical_cast<string>(count * 4));
+    Factory::GetConfigure()->SetValue(Configure::AttributeCacheTimeout, "3600");
+    Factory::CreateMetaManager();
+    meta = Factory::GetMetaManager();
+
+    ::rewinddir(dir);
+    while ( meta->ReadFolder(folder,dir,entry) ) {
+    }
+    ::closedir(dir);
+
+    for ( int i = 0; i < count; ++ i ) {
+        fs::path path = folder / ( "object" + boost::lexical_cast<string>(i) );
+        int handle = ::open(
+                (fs::path(metaFolder) / path).string().c_str(), O_RDWR );
+        CPPUNIT_ASSERT( handle >= 0 );
+        Inode inode(handle);
+        CPPUNIT_ASSERT( true == inode.SetSize(i + 1) );
+        ::close(handle);
+    }
+
+    int hits = 0;
+    for ( int i = 0; i < count; ++ i ) {
+        fs::path path = folder / ( "object" + boost::lexical_cast<string>(i) );
+        struct stat stat;
+        CPPUNIT_ASSERT( true == meta->GetStat(path,stat) );
+        if ( stat.st_size == i ) {
+            ++ hits;
+        }
+    }
+    CPPUNIT_ASSERT_EQUAL( count, hits );
+
+    struct stat stat;
+    meta->InvalidateAttribute(folder / "object0");
+    CPPUNIT_ASSERT( true == meta->GetStat(folder / "object0",stat) );
+    CPPUNIT_ASSERT( 1 == stat.st_size );
+}
+
+
+static const int stressFolders = 8;
+static const int stressFiles = 16;
+static const size_t stressSize = 512;
+
+
+static fs::path
+StressPath(int folder, int file)
+{
+    return "/stress" + boost::lexical_cast<string>(folder)
+            + "/file" + boost::lexical_cast<string>(file);
+}
+
+
+static void
+StressOpenTask(int folder, int count, int & failures)
+{
+    MetaManager * meta = Factory::GetMetaManager();
+    char buffer[stressSize];
+    memset(buffer,'a' + folder,sizeof(buffer));
+    size_t size;
+
+    failures = 0;
+    for ( int i = 0; i < count; ++ i ) {
+        fs::path path = StressPath(folder, i % stressFiles);
+        auto_ptr<FileOperationInterface> file(
+                meta->GetFileOperation(path,O_RDWR) );
+        struct stat stat;
+        if ( NULL == file.get()
+                || ! file->Write(0,buffer,sizeof(buffer),size)
+                || ! meta->GetActiveStat(path,stat) ) {
+            ++ failures;
+        }
+    }
+}
+
+
+static void
+StressRenameTask(int & renames)
+{
+    MetaManager * meta = Factory::GetMetaManager();
+    char buffer[stressSize];
+    memset(buffer,'r',sizeof(buffer));
+    size_t size;
+
+    //  keeps a file of the folder open while the folder is renamed
+    renames = 0;
+    fs::path from = "/rename", to = "/renamed";
+    if ( ! fs::exists( fs::path(metaFolder) / from ) ) {
+        swap(from,to);
+    }
+    try {
+        while ( true ) {
+            boost::this_thread::interruption_point();
+            auto_ptr<FileOperationInterface> file( meta->GetFileOperation(
+                    from / ( "file" + boost::lexical_cast<string>(
+                    renames % stressFiles ) ), O_RDWR ) );
+            if ( NULL != file.get() ) {
+                file->Write(0,buffer,sizeof(buffer),size);
+            }
+            if ( meta->RenameInode(from,to) ) {
+                swap(from,to);
+                ++ renames;
+            }
+        }
+    } catch ( const boost::thread_interrupted & e ) {
+    }
+}
+
+
+static void
+StressBackupListTask(int & scans)
+{
+    MetaManager * meta = Factory::GetMetaManager();
+
+    scans = 0;
+    try {
+        while ( true ) {
+            boost::this_thread::interruption_point();
+            vector<BackupItem> list;
+            meta->GetBackupList(list);
+            ++ scans;
+        }
+    } catch ( const boost::thread_interrupted & e ) {
+    }
+}
+
+
+void
+MetaManagerTest::testHandlerStress()
+{
+    MetaManager * meta = Factory::GetMetaManager();
+
+    for ( int folder = 0; folder < stressFolders; ++ folder ) {
+        CPPUNIT_ASSERT( true == meta->CreateFolder(
+                StressPath(folder,0).parent_path(),0755) );
+        for ( int file = 0; file < stressFiles; ++ file ) {
+            CPPUNIT_ASSERT( true == meta->CreateFile(
+                    StressPath(folder,file),0644) );
+        }
+    }
+    CPPUNIT_ASSERT( true == meta->CreateFolder("/rename",0755) );
+    for ( int file = 0; file < stressFiles; ++ file ) {
+        CPPUNIT_ASSERT( true == meta->CreateFile(
+                "/rename/file" + boost::lexical_cast<string>(file),0644) );
+    }
+
+    const int threads[] = { 1, 8, 32 };
+    const int count = 16000;
+    int renames = 0, scans = 0;
+    BOOST_FOREACH( int thread, threads ) {
+        boost::thread renamer( boost::bind(
+                &StressRenameTask, boost::ref(renames) ) );
+        boost::thread lister( boost::bind(
+                &StressBackupListTask, boost::ref(scans) ) );
+
+        boost::thread_group group;
+        vector<int> failures(thread, 0);
+        boost::posix_time::ptime begin =
+                boost::posix_time::microsec_clock::local_time();
+        for ( int i = 0; i < thread; ++ i ) {
+            group.create_thread( boost::bind( &StressOpenTask,
+                    i % stressFolders, count / thread,
+                    boost::ref(failures[i]) ) );
+        }
+        group.join_all();
+        boost::posix_time::ptime end =
+                boost::posix_time::microsec_clock::local_time();
+        long long duration = (end - begin).total_microseconds() + 1;
+
+        renamer.interrupt();
+        lister.interrupt();
+        renamer.join();
+        lister.join();
+
+        BOOST_FOREACH( int failure, failures ) {
+            CPPUNIT_ASSERT( 0 == failure );
+        }
+        cout << endl << "open/release " << thread << " threads: "
+                << count * 1000000LL / duration
+                << " ops/sec, " << renames << " folder renames, "
+                << scans << " backup list scans" << endl;
+    }
+
+    //  every handler is released and reports the data written
+    for ( int folder = 0; folder < stressFolders; ++ folder ) {
+        for ( int file = 0; file < stressFiles; ++ file ) {
+            struct stat stat;
+            fs::path path = StressPath(folder,file);
+            CPPUNIT_ASSERT( false == meta->IsFileInUse(path) );
+            CPPUNIT_ASSERT( true == meta->GetStat(path,stat) );
+            CPPUNIT_ASSERT( stressSize == stat.st_size );
+        }
+    }
+
+    //  the handlers of the renamed folder follow its final name
+    fs::path folder = fs::exists( fs::path(metaFolder) / "rename" )
+            ? "/rename" : "/renamed";
+    for ( int file = 0; file < stressFiles; ++ file ) {
+        struct stat stat;
+        fs::path path = folder / ( "file" + boost::lexical_cast<string>(file) );
+        CPPUNIT_ASSERT( false == meta->IsFileInUse(path) );
+        CPPUNIT_ASSERT( true == meta->GetStat(path,stat) );
+        CPPUNIT_ASSERT( 0 == stat.st_size || stressSize == stat.st_size );
+    }
+}
@@ -38,6 +38,9 @@ class MetaManagerTest : public CppUnit::TestFixture
     CPPUNIT_TEST( testBackupOnDelete );
     CPPUNIT_TEST( testBackupOnRename );
     CPPUNIT_TEST( testPersist );
+    CPPUNIT_TEST( testReadFolder );
+    CPPUNIT_TEST( testReadFolderLarge );
+    CPPUNIT_TEST( testHandlerStress );
     CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -57,5 +60,8 @@ public:
     void testBackupOnDelete();
     void testBackupOnRename();
     void testPersist();
+    void testReadFolder();
+    void testReadFolderLarge();
+    void testHandlerStress();
 };
 
@@ -0,0 +1,214 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * PickleParserTest.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+
+
+
+#include "stdafx.h"
+#include "../PickleParser.h"
+#include "PickleParserTest.h"
+
+
+CPPUNIT_TEST_SUITE_REGISTRATION( PickleParserTest );
+
+
+static const string account = "/AUTH_7b4e0995cdb5423d94adf4d7bc93b89a";
+static const string segment =
+        "large/l_3twrhUYtQWN6Rji.bin/1422305129.671900/5000000000/1000000000/";
+
+
+//  the metadata of Swift objects, pickled by python 2 as Swift does, and
+//  by python 3 for unicode, ints and bools
+static string
+ReadGolden(const string & name)
+{
+    ifstream input( ("swift/" + name).c_str(),
+            std::ios::in | std::ios::binary );
+    CPPUNIT_ASSERT_MESSAGE( name, input.good() );
+    stringstream content;
+    content << input.rdbuf();
+    return content.str();
+}
+
+
+static void
+CheckGolden(const string & name, const PickleParser::DictType & expect)
+{
+    PickleParser parser;
+    PickleParser::DictType dict;
+    CPPUNIT_ASSERT_MESSAGE( name, parser.Parse(ReadGolden(name),dict) );
+    CPPUNIT_ASSERT_MESSAGE( name, expect.size() == dict.size() );
+    BOOST_FOREACH( const PickleParser::DictType::value_type & pair, expect ) {
+        PickleParser::DictType::iterator i = dict.find(pair.first);
+        CPPUNIT_ASSERT_MESSAGE( name + " " + pair.first, i != dict.end() );
+        CPPUNIT_ASSERT_MESSAGE( name + " " + i->second,
+                pair.second == i->second );
+    }
+}
+
+
+void
+PickleParserTest::setUp()
+{
+}
+
+
+void
+PickleParserTest::tearDown()
+{
+}
+
+
+void
+PickleParserTest::testGolden()
+{
+    PickleParser::DictType object;
+    object["Content-Length"] = "1024";
+    object["name"] = account + "/CC/etc/swift/swift.conf";
+    object["Content-Type"] = "application/octet-stream";
+    object["ETag"] = "d41d8cd98f00b204e9800998ecf8427e";
+    object["X-Timestamp"] = "1422305129.67190";
+    object["X-Object-Meta-Mtime"] = "1422305000.000000";
+    CheckGolden("object-p0.pickle",object);
+    CheckGolden("object-p1.pickle",object);
+    CheckGolden("object-p2.pickle",object);
+
+    PickleParser::DictType part;
+    part["Content-Length"] = "1000000000";
+    part["name"] = account + "/CC_segments/" + segment + "00000003";
+    part["Content-Type"] = "application/octet-stream";
+    part["ETag"] = "6b9ef1d5d2bd4c8a9e3b3d9a8c2b7f10";
+    part["X-Timestamp"] = "1422305131.12345";
+    CheckGolden("segment-p0.pickle",part);
+    CheckGolden("segment-p2.pickle",part);
+
+    PickleParser::DictType manifest;
+    manifest["Content-Length"] = "0";
+    manifest["name"] = account + "/CC/large/l_3twrhUYtQWN6Rji.bin";
+    manifest["Content-Type"] = "application/octet-stream";
+    manifest["ETag"] = "d41d8cd98f00b204e9800998ecf8427e";
+    manifest["X-Timestamp"] = "1422305140.00000";
+    manifest["X-Object-Meta-Mtime"] = "1422305000.000000";
+    manifest["X-Object-Manifest"] = "CC_segments/" + segment;
+    CheckGolden("manifest-p0.pickle",manifest);
+    CheckGolden("manifest-p2.pickle",manifest);
+
+    PickleParser::DictType unicode;
+    unicode["name"] = account + "/CC/caf\xc3\xa9/"
+            "\xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e \\ line\nbreak.txt";
+    unicode["Content-Length"] = "2048";
+    unicode["X-Delete-At"] = "1422999999";
+    unicode["X-Static-Large-Object"] = "True";
+    unicode["X-Object-Meta-Mtime"] = "1422305000.000000";
+    unicode["X-Object-Sysmeta-Size"] = "6000000000";
+    CheckGolden("unicode-p0.pickle",unicode);
+    CheckGolden("unicode-p2.pickle",unicode);
+}
+
+
+void
+PickleParserTest::testOpcodes()
+{
+    PickleParser parser;
+    PickleParser::DictType dict;
+
+    //  memo, DICT from a mark, escapes of a str repr
+    string data = "(S'a\\'b\\x41\\n'\np0\ng0\nS\"\\\\\"\np1\nI-5\ndp2\n"
+            "S'n'\nNs.";
+    CPPUNIT_ASSERT( true == parser.Parse(data,dict) );
+    CPPUNIT_ASSERT( 3 == dict.size() );
+    CPPUNIT_ASSERT( "a'bA\n" == dict["a'bA\n"] );
+    CPPUNIT_ASSERT( "-5" == dict["\\"] );
+    CPPUNIT_ASSERT( "None" == dict["n"] );
+
+    //  protocol 2 numbers and constants
+    const char binary[] =
+            "\x80\x02}q\x00(X\x01\x00\x00\x00" "a"
+            "J\xfb\xff\xff\xff"
+            "X\x01\x00\x00\x00" "b" "\x8a\x02\x00\x80"
+            "X\x01\x00\x00\x00" "c" "\x8a\x00"
+            "X\x01\x00\x00\x00" "d" "G\x3f\xf8\x00\x00\x00\x00\x00\x00"
+            "X\x01\x00\x00\x00" "e" "\x89"
+            "U\x01" "f" "M\x00\x01"
+            "u.";
+    data.assign(binary,sizeof(binary)-1);
+    CPPUNIT_ASSERT( true == parser.Parse(data,dict) );
+    CPPUNIT_ASSERT( 6 == dict.size() );
+    CPPUNIT_ASSERT( "-5" == dict["a"] );
+    CPPUNIT_ASSERT( "-32768" == dict["b"] );
+    CPPUNIT_ASSERT( "0" == dict["c"] );
+    CPPUNIT_ASSERT( "1.5" == dict["d"] );
+    CPPUNIT_ASSERT( "False" == dict["e"] );
+    CPPUNIT_ASSERT( "256" == dict["f"] );
+}
+
+
+void
+PickleParserTest::testInvalid()
+{
+    PickleParser parser;
+    PickleParser::DictType dict;
+    string object = ReadGolden("object-p2.pickle");
+
+    //  cut anywhere
+    for ( size_t i = 0; i < object.size(); ++ i ) {
+        CPPUNIT_ASSERT( false == parser.Parse(object.substr(0,i),dict) );
+        CPPUNIT_ASSERT( dict.empty() );
+    }
+
+    //  not a dict of strings
+    CPPUNIT_ASSERT( false == parser.Parse("S'a'\n.",dict) );
+    CPPUNIT_ASSERT( false == parser.Parse("(lp0\n.",dict) );
+    CPPUNIT_ASSERT( false == parser.Parse("(dp0\nS'a'\n(dp1\ns.",dict) );
+    CPPUNIT_ASSERT( false == parser.Parse("(dp0\nS'a'\ns.",dict) );
+    CPPUNIT_ASSERT( false == parser.Parse("\x80\x03}.",dict) );
+    CPPUNIT_ASSERT( false == parser.Parse("(dp0\ng1\ng1\ns.",dict) );
+    CPPUNIT_ASSERT( false == parser.Parse("(dp0\nS'a\nS'b'\ns.",dict) );
+    CPPUNIT_ASSERT( false == parser.Parse("(dp0\nVa\\u12\nS'b'\ns.",dict) );
+    CPPUNIT_ASSERT( false == parser.Parse("}(X\xff\xff\xff\xffu.",dict) );
+    CPPUNIT_ASSERT( false == parser.Parse("cos\nsystem\n.",dict) );
+
+    CPPUNIT_ASSERT( true == parser.Parse("}.",dict) );
+    CPPUNIT_ASSERT( dict.empty() );
+}
+
+
+void
+PickleParserTest::testPerformance()
+{
+    const int count = 100 * 1000;
+    string object = ReadGolden("object-p2.pickle");
+    string text = ReadGolden("object-p0.pickle");
+
+    PickleParser parser;
+    PickleParser::DictType dict;
+    boost::posix_time::ptime begin =
+            boost::posix_time::microsec_clock::local_time();
+    for ( int i = 0; i < count; ++ i ) {
+        CPPUNIT_ASSERT( true == parser.Parse(i % 2 ? object : text,dict) );
+    }
+    int duration = (boost::posix_time::microsec_clock::local_time()
+            - begin).total_milliseconds();
+
+    cout << endl << count << " Swift metadata parsed in " << duration
+            << " ms" << endl;
+    CPPUNIT_ASSERT( 6 == dict.size() );
+    CPPUNIT_ASSERT( duration < 5000 );
+}
@@ -21,21 +21,266 @@
 
 #include "stdafx.h"
 #include "../ReadTask.h"
+#include "../ReadTaskPool.h"
+#include "../CacheManager.h"
+#include "../FileOperationBitmap.h"
 #include "ReadTaskTest.h"
+#include <sys/resource.h>
 
 
 CPPUNIT_TEST_SUITE_REGISTRATION( ReadTaskTest );
 
 
+static const string cacheFolder = "ReadTaskTest.cache";
+
+
+//  Reads running on a tape at once
+struct TapeCounter
+{
+    boost::mutex mutex;
+    int current;
+    int peak;
+};
+
+
+//  Tape file of the simulator, every read takes delay milliseconds
+class RecallSourceSimulator : public FileOperationInterface
+{
+public:
+    RecallSourceSimulator(TapeCounter & counter, off_t length, int delay)
+    : counter_(counter), length_(length), delay_(delay)
+    {
+    }
+
+    bool
+    GetStat(struct stat & stat)
+    {
+        memset(&stat, 0, sizeof(stat));
+        stat.st_size = length_;
+        return true;
+    }
+
+    bool
+    Read(off_t offset, void * buffer, size_t bufsize, size_t & size)
+    {
+        {
+            boost::lock_guard<boost::mutex> lock(counter_.mutex);
+            counter_.peak = max(counter_.peak, ++ counter_.current);
+        }
+        boost::this_thread::sleep(boost::posix_time::milliseconds(delay_));
+        size = offset < length_ ? min<off_t>(bufsize, length_ - offset) : 0;
+        memset(buffer, (int)(offset & 0xff), size);
+        {
+            boost::lock_guard<boost::mutex> lock(counter_.mutex);
+            -- counter_.current;
+        }
+        return true;
+    }
+
+    bool
+    Write(off_t offset, const void * buffer, size_t bufsize, size_t & size)
+    {
+        errno = EROFS;
+        return false;
+    }
+
+    bool
+    Truncate(off_t length)
+    {
+        errno = EROFS;
+        return false;
+    }
+
+    bool
+    Sync(bool data)
+    {
+        return true;
+    }
+
+private:
+    TapeCounter & counter_;
+    off_t length_;
+    int delay_;
+};
+
+
+//  Cache file of the benchmark, every write of data takes delay
+//  milliseconds
+class DelayBitmap : public FileOperationBitmap
+{
+public:
+    DelayBitmap(const fs::path & path, unsigned long sizeBlock, int delay)
+    : FileOperationBitmap(path, 0600, O_RDWR, sizeBlock), delay_(delay)
+    {
+    }
+
+    bool
+    WriteData(off_t offset, const void * buffer, size_t bufsize, size_t & size)
+    {
+        boost::this_thread::sleep(boost::posix_time::milliseconds(delay_));
+        return FileOperationBitmap::WriteData(offset, buffer, bufsize, size);
+    }
+
+private:
+    int delay_;
+};
+
+
+static size_t
+GetThreadCount()
+{
+    size_t count = 0;
+    for ( fs::directory_iterator i("/proc/self/task");
+            i != fs::directory_iterator();
+            ++ i ) {
+        ++ count;
+    }
+    return count;
+}
+
+
+static long long
+GetCpuTime()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return ( usage.ru_utime.tv_sec + usage.ru_stime.tv_sec ) * 1000000LL
+            + usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
+
+
+static ReadTask *
+CreateReadTask(
+        const string & tape,
+        TapeCounter & counter,
+        off_t length,
+        int delay,
+        ReadTaskPool * pool)
+{
+    CacheManager * cache = Factory::GetCacheManager();
+    unsigned long long number;
+    CPPUNIT_ASSERT( true == cache->CreateNewFile(number) );
+    CPPUNIT_ASSERT( true == cache->DeleteFile(number) );
+    CPPUNIT_ASSERT( true == cache->CreateFile(number) );
+    {
+        auto_ptr<FileOperationBitmap> file(
+                cache->GetFileOperationBitmap(number,O_RDWR) );
+        CPPUNIT_ASSERT( NULL != file.get() );
+        CPPUNIT_ASSERT( true == file->TruncateBitmap(length) );
+    }
+    FileOperationBitmap * target =
+            cache->GetFileOperationBitmap(number,O_WRONLY);
+    CPPUNIT_ASSERT( NULL != target );
+    return new ReadTask( number, tape,
+            new RecallSourceSimulator(counter,length,delay),
+            target, NULL, pool );
+}
+
+
+static void
+PrepareTask(
+        const vector<ReadTask *> & tasks,
+        size_t begin,
+        size_t step,
+        off_t length,
+        size_t & failure)
+{
+    for ( size_t i = begin; i < tasks.size(); i += step ) {
+        if ( ! tasks[i]->Prepare(0,length) ) {
+            ++ failure;
+        }
+    }
+}
+
+
+static size_t
+PrepareTasks(const vector<ReadTask *> & tasks, size_t clients, off_t length)
+{
+    boost::thread_group group;
+    vector<size_t> failures(clients, 0);
+    for ( size_t i = 0; i < clients; ++ i ) {
+        group.create_thread( boost::bind( &PrepareTask, boost::cref(tasks),
+                i, clients, length, boost::ref(failures[i]) ) );
+    }
+    group.join_all();
+
+    size_t failure = 0;
+    BOOST_FOREACH( size_t f, failures ) {
+        failure += f;
+    }
+    return failure;
+}
+
+
+static bool
+WaitTasks(const vector<ReadTask *> & tasks, int timeout)
+{
+    for ( int i = 0; i < timeout; i += 10 ) {
+        bool running = false;
+        BOOST_FOREACH( ReadTask * task, tasks ) {
+            if ( task->IsRunning() ) {
+                running = true;
+                break;
+            }
+        }
+        if ( ! running ) {
+            return true;
+        }
+        boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+    }
+    return false;
+}
+
+
+//  MB/s of one recall through a pool with the given number of buffers
+static double
+GetCopyRate(size_t buffers, int delayRead, int delayWrite)
+{
+    const off_t length = 32 * 1024 * 1024;
+    const size_t sizeBlock = 16 * 1024 * 1024;
+    const size_t bufsize = 256 * 1024;
+
+    fs::path path = fs::path(cacheFolder) / "pipeline";
+    fs::remove(path);
+    DelayBitmap * target = new DelayBitmap(path, sizeBlock, delayWrite);
+    CPPUNIT_ASSERT( true == target->TruncateBitmap(length) );
+
+    TapeCounter counter;
+    counter.current = 0;
+    counter.peak = 0;
+    ReadTaskPool pool(1, 1, buffers, bufsize);
+
+    boost::posix_time::ptime begin =
+            boost::posix_time::microsec_clock::local_time();
+    ReadTask task( 1, "barcode0",
+            new RecallSourceSimulator(counter, length, delayRead),
+            target, NULL, &pool );
+    CPPUNIT_ASSERT( true == task.Prepare(0, length) );
+    vector<ReadTask *> tasks(1, &task);
+    CPPUNIT_ASSERT( true == WaitTasks(tasks, 10 * 1000) );
+    CPPUNIT_ASSERT( true == task.IsValid() );
+    double duration = (boost::posix_time::microsec_clock::local_time()
+            - begin).total_microseconds();
+
+    return length / duration;
+}
+
+
 void
 ReadTaskTest::setUp()
 {
+    fs::remove_all(cacheFolder);
+    fs::create_directory(cacheFolder);
+    Factory::SetCacheFolder(cacheFolder);
+    Factory::CreateCacheManager();
 }
 
 
 void
 ReadTaskTest::tearDown()
 {
+    Factory::ReleaseCacheManager();
+    fs::remove_all(cacheFolder);
 }
 
 
@@ -45,3 +290,129 @@ ReadTaskTest::testRequest()
     CPPUNIT_FAIL("TODO");
 }
 
+
+void
+ReadTaskTest::testTapeLimit()
+{
+    const off_t length = 64 * 1024;
+    ReadTaskPool pool(8, 2, 2, 16 * 1024);
+    TapeCounter counters[2];
+    vector<ReadTask *> tasks;
+
+    for ( int i = 0; i < 2; ++ i ) {
+        counters[i].current = 0;
+        counters[i].peak = 0;
+    }
+    for ( int i = 0; i < 40; ++ i ) {
+        tasks.push_back( CreateReadTask( "barcode" +
+                boost::lexical_cast<string>(i % 2), counters[i % 2],
+                length, 2, &pool ) );
+    }
+
+    CPPUNIT_ASSERT( 0 == PrepareTasks(tasks, 40, length) );
+    CPPUNIT_ASSERT( true == WaitTasks(tasks, 5000) );
+    BOOST_FOREACH( ReadTask * task, tasks ) {
+        CPPUNIT_ASSERT( true == task->IsValid() );
+        delete task;
+    }
+
+    for ( int i = 0; i < 2; ++ i ) {
+        CPPUNIT_ASSERT_MESSAGE(
+                boost::lexical_cast<string>(counters[i].peak),
+                counters[i].peak == 2 );
+    }
+}
+
+
+void
+ReadTaskTest::testStress()
+{
+    const size_t count = 2000;
+    const size_t tapes = 20;
+    const size_t threads = 16;
+    const off_t length = 64 * 1024;
+
+    size_t threadsBase = GetThreadCount();
+    ReadTaskPool pool(threads, 1, 2, 16 * 1024);
+    TapeCounter counters[tapes];
+    vector<ReadTask *> tasks;
+
+    for ( size_t i = 0; i < tapes; ++ i ) {
+        counters[i].current = 0;
+        counters[i].peak = 0;
+    }
+    for ( size_t i = 0; i < count; ++ i ) {
+        tasks.push_back( CreateReadTask( "barcode" +
+                boost::lexical_cast<string>(i % tapes), counters[i % tapes],
+                length, 1, &pool ) );
+    }
+
+    //  the recalls wait for their first request without a thread, the
+    //  pool has a worker and a writer per thread
+    size_t threadsOpen = GetThreadCount();
+    CPPUNIT_ASSERT_MESSAGE(
+            boost::lexical_cast<string>(threadsOpen),
+            threadsOpen <= threadsBase + threads * 2 );
+
+    long long cpu = GetCpuTime();
+    boost::this_thread::sleep(boost::posix_time::milliseconds(200));
+    long long cpuIdle = GetCpuTime() - cpu;
+    CPPUNIT_ASSERT_MESSAGE(
+            boost::lexical_cast<string>(cpuIdle),
+            cpuIdle < 50 * 1000 );
+
+    const size_t clients = 50;
+    cpu = GetCpuTime();
+    boost::posix_time::ptime begin =
+            boost::posix_time::microsec_clock::local_time();
+    CPPUNIT_ASSERT( 0 == PrepareTasks(tasks, clients, length) );
+    CPPUNIT_ASSERT( true == WaitTasks(tasks, 60 * 1000) );
+    int duration = (boost::posix_time::microsec_clock::local_time()
+            - begin).total_milliseconds();
+    long long cpuRecall = GetCpuTime() - cpu;
+
+    BOOST_FOREACH( ReadTask * task, tasks ) {
+        CPPUNIT_ASSERT( true == task->IsValid() );
+        CPPUNIT_ASSERT( false == task->IsRunning() );
+        delete task;
+    }
+    for ( size_t i = 0; i < tapes; ++ i ) {
+        CPPUNIT_ASSERT( 1 == counters[i].peak );
+    }
+
+    cout << endl << count << " recalls on " << tapes << " tapes: "
+            << threadsOpen - threadsBase << " threads, "
+            << cpuIdle / 1000 << " ms cpu idle, "
+            << cpuRecall / 1000 << " ms cpu in " << duration << " ms"
+            << endl;
+    CPPUNIT_ASSERT_MESSAGE(
+            boost::lexical_cast<string>(cpuRecall),
+            cpuRecall < 10 * 1000 * 1000 );
+}
+
+
+void
+ReadTaskTest::testPipeline()
+{
+    //  tape and disk speed from the delay of a 256KB buffer
+    const int delays[][2] = { { 4, 4 }, { 2, 6 }, { 6, 2 } };
+    const double bufsize = 256 * 1024 / 1000.0;
+
+    cout << endl;
+    for ( size_t i = 0; i < sizeof(delays) / sizeof(delays[0]); ++ i ) {
+        int delayRead = delays[i][0];
+        int delayWrite = delays[i][1];
+        double tape = bufsize / delayRead;
+        double disk = bufsize / delayWrite;
+        double single = GetCopyRate(1, delayRead, delayWrite);
+        double dual = GetCopyRate(2, delayRead, delayWrite);
+        cout << "tape " << tape << " MB/s, disk " << disk << " MB/s: "
+                << "one buffer " << single << " MB/s (serial "
+                << 1 / (1 / tape + 1 / disk) << "), two buffers "
+                << dual << " MB/s (min " << min(tape,disk) << ")" << endl;
+        CPPUNIT_ASSERT( dual > single );
+        CPPUNIT_ASSERT_MESSAGE(
+                boost::lexical_cast<string>(dual),
+                dual >= 0.8 * min(tape,disk) );
+    }
+}
@@ -26,6 +26,9 @@ class ReadTaskTest : public CppUnit::TestFixture
 {
     CPPUNIT_TEST_SUITE( ReadTaskTest );
     CPPUNIT_TEST( testRequest );
+    CPPUNIT_TEST( testTapeLimit );
+    CPPUNIT_TEST( testStress );
+    CPPUNIT_TEST( testPipeline );
     CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -33,5 +36,8 @@ public:
     void tearDown();
 
     void testRequest();
+    void testTapeLimit();
+    void testStress();
+    void testPipeline();
 };
 
@@ -0,0 +1,291 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * RecallQueueTest.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+
+#include "stdafx.h"
+#include "../RecallQueue.h"
+#include "../FileOperation.h"
+#include "../FileOperationRecall.h"
+#include "RecallQueueTest.h"
+
+
+CPPUNIT_TEST_SUITE_REGISTRATION( RecallQueueTest );
+
+
+static const string barcode = "barcode0";
+static const string sourceFile = "recall.file";
+
+
+//  Head of a simulated tape, every recall is a locate from the last
+//  position followed by a read of readTime milliseconds
+class RecallSimulator
+{
+public:
+    RecallSimulator(RecallQueue * queue, int readTime)
+    : queue_(queue), readTime_(readTime), position_(0), distance_(0)
+    {
+    }
+
+    void
+    Recall(off_t block, int arrival)
+    {
+        boost::this_thread::sleep(boost::posix_time::milliseconds(arrival));
+        {
+            boost::lock_guard<boost::mutex> lock(mutex_);
+            arrivals_.push_back(block);
+        }
+        if ( ! queue_->Enter(barcode, block, 60 * 1000) ) {
+            return;
+        }
+        {
+            boost::lock_guard<boost::mutex> lock(mutex_);
+            distance_ += block > position_ ?
+                    block - position_ : position_ - block;
+            position_ = block;
+            grants_.push_back(block);
+        }
+        if ( readTime_ > 0 ) {
+            boost::this_thread::sleep(
+                    boost::posix_time::milliseconds(readTime_));
+        }
+        queue_->Leave(barcode);
+    }
+
+    static unsigned long long
+    GetDistance(const vector<off_t> & blocks)
+    {
+        unsigned long long distance = 0;
+        off_t position = 0;
+        BOOST_FOREACH( off_t block, blocks ) {
+            distance += block > position ? block - position : position - block;
+            position = block;
+        }
+        return distance;
+    }
+
+    RecallQueue * queue_;
+    int readTime_;
+    boost::mutex mutex_;
+    off_t position_;
+    unsigned long long distance_;
+    vector<off_t> arrivals_;
+    vector<off_t> grants_;
+};
+
+
+void
+RecallQueueTest::setUp()
+{
+    ofstream f(sourceFile.c_str());
+    f << "0123456789";
+}
+
+
+void
+RecallQueueTest::tearDown()
+{
+    fs::remove(sourceFile);
+}
+
+
+void
+RecallQueueTest::testOrder()
+{
+    RecallQueue queue(100);
+    RecallSimulator simulator(&queue, 1);
+    const off_t blocks[] = { 700, 100, 900, 300, 500, 200, 800, 400 };
+
+    boost::thread_group group;
+    for ( size_t i = 0; i < sizeof(blocks) / sizeof(blocks[0]); ++ i ) {
+        group.create_thread( boost::bind(
+                &RecallSimulator::Recall, &simulator, blocks[i], 0 ) );
+    }
+    group.join_all();
+
+    CPPUNIT_ASSERT( 8 == simulator.grants_.size() );
+    for ( size_t i = 1; i < simulator.grants_.size(); ++ i ) {
+        CPPUNIT_ASSERT( simulator.grants_[i-1] < simulator.grants_[i] );
+    }
+    CPPUNIT_ASSERT( 900 == simulator.distance_ );
+    CPPUNIT_ASSERT( true == queue.IsIdle(barcode) );
+}
+
+
+void
+RecallQueueTest::testElevator()
+{
+    RecallQueue queue(0);
+    RecallSimulator simulator(&queue, 0);
+
+    CPPUNIT_ASSERT( true == queue.Enter(barcode, 500, 1000) );
+
+    //  arrive while the tape is busy at 500
+    const off_t blocks[] = { 100, 700, 300, 900 };
+    boost::thread_group group;
+    for ( size_t i = 0; i < sizeof(blocks) / sizeof(blocks[0]); ++ i ) {
+        group.create_thread( boost::bind(
+                &RecallSimulator::Recall, &simulator, blocks[i], 0 ) );
+    }
+    while ( true ) {
+        boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+        boost::lock_guard<boost::mutex> lock(simulator.mutex_);
+        if ( simulator.arrivals_.size() == 4 ) {
+            break;
+        }
+    }
+    boost::this_thread::sleep(boost::posix_time::milliseconds(20));
+    queue.Leave(barcode);
+    group.join_all();
+
+    //  the sweep continues upwards, 100 and 300 wait for the next one
+    const off_t expect[] = { 700, 900, 100, 300 };
+    CPPUNIT_ASSERT( 4 == simulator.grants_.size() );
+    for ( size_t i = 0; i < 4; ++ i ) {
+        CPPUNIT_ASSERT_MESSAGE(
+                boost::lexical_cast<string>(simulator.grants_[i]),
+                expect[i] == simulator.grants_[i] );
+    }
+    CPPUNIT_ASSERT( true == queue.IsIdle(barcode) );
+}
+
+
+void
+RecallQueueTest::testTimeout()
+{
+    RecallQueue queue(0);
+
+    CPPUNIT_ASSERT( true == queue.Enter(barcode, 500, 1000) );
+
+    boost::posix_time::ptime begin =
+            boost::posix_time::microsec_clock::local_time();
+    CPPUNIT_ASSERT( false == queue.Enter(barcode, 600, 50) );
+    int duration = (boost::posix_time::microsec_clock::local_time()
+            - begin).total_milliseconds();
+    CPPUNIT_ASSERT_MESSAGE(
+            boost::lexical_cast<string>(duration),
+            duration >= 50 && duration < 500 );
+
+    CPPUNIT_ASSERT( false == queue.IsIdle(barcode) );
+    queue.Leave(barcode);
+    CPPUNIT_ASSERT( true == queue.IsIdle(barcode) );
+
+    //  the window does not outlast the timeout
+    RecallQueue window(1000);
+    begin = boost::posix_time::microsec_clock::local_time();
+    CPPUNIT_ASSERT( false == window.Enter(barcode, 100, 50) );
+    duration = (boost::posix_time::microsec_clock::local_time()
+            - begin).total_milliseconds();
+    CPPUNIT_ASSERT( duration < 500 );
+    CPPUNIT_ASSERT( true == window.IsIdle(barcode) );
+}
+
+
+void
+RecallQueueTest::testTapes()
+{
+    RecallQueue queue(0);
+
+    CPPUNIT_ASSERT( true == queue.Enter("barcode1", 500, 1000) );
+    CPPUNIT_ASSERT( true == queue.Enter("barcode2", 900, 50) );
+    CPPUNIT_ASSERT( false == queue.Enter("barcode1", 100, 50) );
+
+    queue.Leave("barcode1");
+    CPPUNIT_ASSERT( true == queue.IsIdle("barcode1") );
+    CPPUNIT_ASSERT( false == queue.IsIdle("barcode2") );
+    queue.Leave("barcode2");
+    CPPUNIT_ASSERT( true == queue.IsIdle("barcode2") );
+}
+
+
+void
+RecallQueueTest::testSeekDistance()
+{
+    //  a burst of recalls on one tape in random order, with late arrivals
+    //  while the first sweep is running
+    const int count = 500;
+    const off_t blocks = 10 * 1000 * 1000;
+    srand(1);
+    vector<off_t> recalls;
+    vector<int> arrivals;
+    for ( int i = 0; i < count; ++ i ) {
+        recalls.push_back( (off_t)rand() % blocks );
+        arrivals.push_back( rand() % 400 );
+    }
+
+    RecallQueue queue(50);
+    RecallSimulator simulator(&queue, 1);
+
+    boost::posix_time::ptime begin =
+            boost::posix_time::microsec_clock::local_time();
+    boost::thread_group group;
+    for ( int i = 0; i < count; ++ i ) {
+        group.create_thread( boost::bind( &RecallSimulator::Recall,
+                &simulator, recalls[i], arrivals[i] ) );
+    }
+    group.join_all();
+    int duration = (boost::posix_time::microsec_clock::local_time()
+            - begin).total_milliseconds();
+
+    CPPUNIT_ASSERT( count == (int)simulator.grants_.size() );
+    CPPUNIT_ASSERT( simulator.distance_
+            == RecallSimulator::GetDistance(simulator.grants_) );
+
+    //  without the queue the recalls hit the tape in arrival order
+    unsigned long long before =
+            RecallSimulator::GetDistance(simulator.arrivals_);
+    unsigned long long after = simulator.distance_;
+    cout << endl << count << " recalls, seek distance in arrival order: "
+            << before << " blocks, ordered: " << after << " blocks ("
+            << duration << " ms)" << endl;
+    CPPUNIT_ASSERT( after * 4 < before );
+}
+
+
+void
+RecallQueueTest::testReleaseOnIdle()
+{
+    RecallQueue queue(0);
+
+    //  the turn is held across the reads of the recall
+    CPPUNIT_ASSERT( true == queue.Enter(barcode, 500, 1000) );
+    auto_ptr<FileOperationInterface> first( new FileOperationRecall(
+            new FileOperation(sourceFile, O_RDONLY), &queue, barcode ) );
+    char buffer[10];
+    size_t size;
+    CPPUNIT_ASSERT( true == first->Read(0, buffer, sizeof(buffer), size) );
+    CPPUNIT_ASSERT( 10 == size );
+    CPPUNIT_ASSERT( true == first->Read(5, buffer, sizeof(buffer), size) );
+    CPPUNIT_ASSERT( false == queue.Enter(barcode, 600, 50) );
+
+    //  an idle reader passes it on, the source stays open
+    first->Idle();
+    CPPUNIT_ASSERT( true == queue.Enter(barcode, 600, 50) );
+    auto_ptr<FileOperationInterface> second( new FileOperationRecall(
+            new FileOperation(sourceFile, O_RDONLY), &queue, barcode ) );
+
+    //  neither a second idle nor the close leave again
+    first->Idle();
+    first.reset();
+    CPPUNIT_ASSERT( false == queue.IsIdle(barcode) );
+
+    //  closed while holding the turn
+    second.reset();
+    CPPUNIT_ASSERT( true == queue.IsIdle(barcode) );
+}
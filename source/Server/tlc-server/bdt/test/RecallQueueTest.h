@@ -0,0 +1,46 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * RecallQueueTest.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+
+#pragma once
+
+
+class RecallQueueTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE( RecallQueueTest );
+    CPPUNIT_TEST( testOrder );
+    CPPUNIT_TEST( testElevator );
+    CPPUNIT_TEST( testTimeout );
+    CPPUNIT_TEST( testTapes );
+    CPPUNIT_TEST( testSeekDistance );
+    CPPUNIT_TEST( testReleaseOnIdle );
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void setUp();
+    void tearDown();
+
+    void testOrder();
+    void testElevator();
+    void testTimeout();
+    void testTapes();
+    void testSeekDistance();
+    void testReleaseOnIdle();
+};
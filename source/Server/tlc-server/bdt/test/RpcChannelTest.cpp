@@ -0,0 +1,732 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * RpcChannelTest.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+
+
+
+#include "stdafx.h"
+#include "../RpcServer.h"
+#include "../RpcChannel.h"
+#include "../RpcCodec.h"
+#include "RpcChannelTest.h"
+
+
+CPPUNIT_TEST_SUITE_REGISTRATION( RpcChannelTest );
+CPPUNIT_TEST_SUITE_NAMED_REGISTRATION( RpcChannelBenchmark, "Benchmark" );
+
+
+static const string service = "RpcTest"
+        + boost::lexical_cast<string>(getpid());
+
+
+//  Methods shaped like the ones of ScheduleProxyServer
+class TestServer : public RpcServer
+{
+public:
+    TestServer(const string & name) : RpcServer(name), meetings_(0)
+    {
+    }
+
+    ~TestServer()
+    {
+        StopThreads();
+    }
+
+    bool
+    InsertSeed(const string & seed)
+    {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+        return seeds_.insert( map<string,boost::thread::id>::value_type(
+                seed, boost::this_thread::get_id() ) ).second;
+    }
+
+    void
+    RemoveSeed(const string & seed)
+    {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+        seeds_.erase(seed);
+    }
+
+    bool
+    InterruptThread(const string & seed)
+    {
+        boost::thread::id id;
+        {
+            boost::lock_guard<boost::mutex> lock(mutex_);
+            map<string,boost::thread::id>::iterator i = seeds_.find(seed);
+            if ( i == seeds_.end() ) {
+                return false;
+            }
+            id = i->second;
+        }
+        boost::lock_guard<boost::mutex> lock(mutexThread_);
+        ThreadList::iterator i = threads_.find(id);
+        if ( i == threads_.end() ) {
+            return false;
+        }
+        i->second->interrupt();
+        return true;
+    }
+
+    //  holds the call until count calls have come, false when they do
+    //  not come in time
+    bool
+    Meet(int count)
+    {
+        boost::system_time const deadline =
+                boost::get_system_time() + boost::posix_time::seconds(10);
+        boost::unique_lock<boost::mutex> lock(mutex_);
+        ++ meetings_;
+        met_.notify_all();
+        while ( meetings_ < count ) {
+            if ( ! met_.timed_wait(lock,deadline) ) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    int
+    Meetings()
+    {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+        return meetings_;
+    }
+
+private:
+    boost::mutex mutex_;
+    map<string,boost::thread::id> seeds_;
+    boost::condition_variable met_;
+    int meetings_;
+
+    void
+    AddMethods();
+};
+
+
+class TestRequestMethod : public xmlrpc_c::method
+{
+public:
+    void
+    execute(xmlrpc_c::paramList const & params,
+            xmlrpc_c::value * const ret)
+    {
+        params.getInt(0);
+        params.getString(1);
+        xmlrpc_c::carray const data(params.getArray(2));
+        params.getBoolean(3);
+        params.getBoolean(4);
+        params.getInt(5);
+        params.getInt(6);
+        * ret = xmlrpc_c::value_boolean( ! data.empty() );
+    }
+};
+
+
+class TestReleaseMethod : public xmlrpc_c::method
+{
+public:
+    void
+    execute(xmlrpc_c::paramList const & params,
+            xmlrpc_c::value * const ret)
+    {
+        params.getInt(0);
+        xmlrpc_c::carray const data(params.getArray(1));
+        params.getBoolean(2);
+        * ret = xmlrpc_c::value_boolean(true);
+    }
+};
+
+
+class TestEchoMethod : public xmlrpc_c::method
+{
+public:
+    void
+    execute(xmlrpc_c::paramList const & params,
+            xmlrpc_c::value * const ret)
+    {
+        * ret = params[0];
+    }
+};
+
+
+class TestFaultMethod : public xmlrpc_c::method
+{
+public:
+    void
+    execute(xmlrpc_c::paramList const & params,
+            xmlrpc_c::value * const ret)
+    {
+        throw xmlrpc_c::fault("Test fault", xmlrpc_c::fault::CODE_INTERNAL);
+    }
+};
+
+
+class TestSleepMethod : public xmlrpc_c::method
+{
+public:
+    TestSleepMethod(TestServer * server) : server_(server)
+    {
+    }
+
+    void
+    execute(xmlrpc_c::paramList const & params,
+            xmlrpc_c::value * const ret)
+    {
+        string const seed(params.getString(0));
+        int const duration(params.getInt(1));
+        server_->InsertSeed(seed);
+        try {
+            boost::this_thread::sleep(
+                    boost::posix_time::milliseconds(duration));
+        } catch ( const boost::thread_interrupted & ) {
+            server_->RemoveSeed(seed);
+            throw;
+        }
+        server_->RemoveSeed(seed);
+        * ret = xmlrpc_c::value_int(duration);
+    }
+
+private:
+    TestServer * server_;
+};
+
+
+class TestMeetMethod : public xmlrpc_c::method
+{
+public:
+    TestMeetMethod(TestServer * server) : server_(server)
+    {
+    }
+
+    void
+    execute(xmlrpc_c::paramList const & params,
+            xmlrpc_c::value * const ret)
+    {
+        * ret = xmlrpc_c::value_boolean( server_->Meet(params.getInt(0)) );
+    }
+
+private:
+    TestServer * server_;
+};
+
+
+//  a result with no compact form
+class TestBytesMethod : public xmlrpc_c::method
+{
+public:
+    void
+    execute(xmlrpc_c::paramList const & params,
+            xmlrpc_c::value * const ret)
+    {
+        vector<unsigned char> data(params.getInt(0));
+        for ( size_t i = 0; i < data.size(); ++ i ) {
+            data[i] = static_cast<unsigned char>(i);
+        }
+        * ret = xmlrpc_c::value_bytestring(data);
+    }
+};
+
+
+class TestInterruptMethod : public xmlrpc_c::method
+{
+public:
+    TestInterruptMethod(TestServer * server) : server_(server)
+    {
+    }
+
+    void
+    execute(xmlrpc_c::paramList const & params,
+            xmlrpc_c::value * const ret)
+    {
+        * ret = xmlrpc_c::value_boolean(
+                server_->InterruptThread(params.getString(0)) );
+    }
+
+private:
+    TestServer * server_;
+};
+
+
+void
+TestServer::AddMethods()
+{
+    AddMethod("Test.Request", xmlrpc_c::methodPtr(new TestRequestMethod()));
+    AddMethod("Test.Release", xmlrpc_c::methodPtr(new TestReleaseMethod()));
+    AddMethod("Test.Echo", xmlrpc_c::methodPtr(new TestEchoMethod()));
+    AddMethod("Test.Fault", xmlrpc_c::methodPtr(new TestFaultMethod()));
+    AddMethod("Test.Sleep", xmlrpc_c::methodPtr(new TestSleepMethod(this)));
+    AddMethod("Test.Meet", xmlrpc_c::methodPtr(new TestMeetMethod(this)));
+    AddMethod("Test.Bytes", xmlrpc_c::methodPtr(new TestBytesMethod()));
+    AddMethod("Test.Interrupt",
+            xmlrpc_c::methodPtr(new TestInterruptMethod(this)));
+}
+
+
+//  A server of before the channels, one call per socket
+class LegacyServer : public SocketServer
+{
+public:
+    LegacyServer(const string & name) : SocketServer(name)
+    {
+    }
+
+    ~LegacyServer()
+    {
+        StopThreads();
+    }
+
+private:
+    void
+    ServiceThread(int handle)
+    {
+        try {
+            xmlrpc_c::registry registry;
+            registry.addMethod("Test.Echo",
+                    xmlrpc_c::methodPtr(new TestEchoMethod()));
+            xmlrpc_c::serverPstreamConn server(
+                    xmlrpc_c::serverPstreamConn::constrOpt()
+                    .socketFd(handle)
+                    .registryP(&registry));
+            bool disconnect;
+            server.runOnce(&disconnect);
+        } catch ( std::exception const & e ) {
+        }
+        close(handle);
+    }
+};
+
+
+//  waits until the server listens
+static void
+WaitServer(const string & name)
+{
+    for ( int i = 0; i < 100; ++ i ) {
+        if ( fs::exists("/tmp/.socket.VS." + name) ) {
+            int handle = Factory::SocketClientHandle(name);
+            if ( handle >= 0 ) {
+                close(handle);
+                return;
+            }
+        }
+        boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+    }
+}
+
+
+static xmlrpc_c::paramList
+MakeRequest(const string & seed)
+{
+    xmlrpc_c::paramList params;
+    params.add(xmlrpc_c::value_int(getpid()));
+    params.add(xmlrpc_c::value_string(seed));
+    vector<xmlrpc_c::value> data;
+    data.push_back(xmlrpc_c::value_string("barcode0"));
+    data.push_back(xmlrpc_c::value_string("barcode1"));
+    params.add(xmlrpc_c::value_array(data));
+    params.add(xmlrpc_c::value_boolean(true));
+    params.add(xmlrpc_c::value_boolean(false));
+    params.add(xmlrpc_c::value_int(3600));
+    params.add(xmlrpc_c::value_int(2));
+    return params;
+}
+
+
+static xmlrpc_c::paramList
+MakeRelease()
+{
+    xmlrpc_c::paramList params;
+    params.add(xmlrpc_c::value_int(getpid()));
+    vector<xmlrpc_c::value> data;
+    data.push_back(xmlrpc_c::value_string("barcode0"));
+    data.push_back(xmlrpc_c::value_string("barcode1"));
+    params.add(xmlrpc_c::value_array(data));
+    params.add(xmlrpc_c::value_boolean(false));
+    return params;
+}
+
+
+static xmlrpc_c::value
+MakeValue()
+{
+    map<string,xmlrpc_c::value> data;
+    data["Result"] = xmlrpc_c::value_boolean(true);
+    data["FileNumber"] = xmlrpc_c::value_int(-7);
+    data["UsedSize"] = xmlrpc_c::value_i8(1LL << 40);
+    data["Rate"] = xmlrpc_c::value_double(0.25);
+    data["Name"] = xmlrpc_c::value_string(string("a\x1b" "b\0c", 5));
+    data["None"] = xmlrpc_c::value_nil();
+    vector<xmlrpc_c::value> tapes;
+    tapes.push_back(xmlrpc_c::value_string("barcode0"));
+    tapes.push_back(xmlrpc_c::value_array(vector<xmlrpc_c::value>()));
+    data["Tapes"] = xmlrpc_c::value_array(tapes);
+    return xmlrpc_c::value_struct(data);
+}
+
+
+static void
+CheckValue(const xmlrpc_c::value & value)
+{
+    map<string,xmlrpc_c::value> data = xmlrpc_c::value_struct(value);
+    CPPUNIT_ASSERT( 7 == data.size() );
+    CPPUNIT_ASSERT( true == xmlrpc_c::value_boolean(data["Result"]) );
+    CPPUNIT_ASSERT( -7 == xmlrpc_c::value_int(data["FileNumber"]) );
+    CPPUNIT_ASSERT( (1LL << 40) == xmlrpc_c::value_i8(data["UsedSize"]) );
+    CPPUNIT_ASSERT( 0.25 == xmlrpc_c::value_double(data["Rate"]) );
+    CPPUNIT_ASSERT( string("a\x1b" "b\0c", 5)
+            == xmlrpc_c::value_string(data["Name"]).cvalue() );
+    CPPUNIT_ASSERT( xmlrpc_c::value::TYPE_NIL == data["None"].type() );
+    vector<xmlrpc_c::value> tapes =
+            xmlrpc_c::value_array(data["Tapes"]).vectorValueValue();
+    CPPUNIT_ASSERT( 2 == tapes.size() );
+    CPPUNIT_ASSERT( "barcode0" == xmlrpc_c::value_string(tapes[0]).cvalue() );
+    CPPUNIT_ASSERT( 0 == xmlrpc_c::value_array(tapes[1]).size() );
+}
+
+
+//  Callers sharing a channel, each calls count times
+class Caller
+{
+public:
+    Caller(RpcChannel * channel, int count)
+    : channel_(channel), count_(count), calls_(0), failures_(0), latency_(0)
+    {
+    }
+
+    void
+    Call(int index)
+    {
+        string seed = "seed" + boost::lexical_cast<string>(index);
+        xmlrpc_c::paramList request = MakeRequest(seed);
+        xmlrpc_c::paramList release = MakeRelease();
+        for ( int i = 0; i < count_; ++ i ) {
+            boost::posix_time::ptime begin =
+                    boost::posix_time::microsec_clock::universal_time();
+            xmlrpc_c::value result;
+            bool ret = ( i % 2 == 0 ) ?
+                    channel_->Call("Test.Request",request,result) :
+                    channel_->Call("Test.Release",release,result);
+            long long duration =
+                    (boost::posix_time::microsec_clock::universal_time()
+                    - begin).total_microseconds();
+            boost::lock_guard<boost::mutex> lock(mutex_);
+            ++ calls_;
+            latency_ += duration;
+            if ( ! ret || ! xmlrpc_c::value_boolean(result) ) {
+                ++ failures_;
+            }
+        }
+    }
+
+    void
+    Sleep(int duration)
+    {
+        xmlrpc_c::paramList params;
+        params.add(xmlrpc_c::value_string(
+                boost::lexical_cast<string>(boost::this_thread::get_id())));
+        params.add(xmlrpc_c::value_int(duration));
+        xmlrpc_c::value result;
+        bool ret = channel_->Call("Test.Sleep",params,result);
+        boost::lock_guard<boost::mutex> lock(mutex_);
+        ++ calls_;
+        if ( ! ret || duration != xmlrpc_c::value_int(result) ) {
+            ++ failures_;
+        }
+    }
+
+    void
+    Meet(int count)
+    {
+        xmlrpc_c::paramList params;
+        params.add(xmlrpc_c::value_int(count));
+        xmlrpc_c::value result;
+        bool ret = channel_->Call("Test.Meet",params,result);
+        boost::lock_guard<boost::mutex> lock(mutex_);
+        ++ calls_;
+        if ( ! ret || ! xmlrpc_c::value_boolean(result) ) {
+            ++ failures_;
+        }
+    }
+
+    RpcChannel * channel_;
+    int count_;
+    boost::mutex mutex_;
+    int calls_;
+    int failures_;
+    long long latency_;
+};
+
+
+void
+RpcChannelTest::setUp()
+{
+}
+
+
+void
+RpcChannelTest::tearDown()
+{
+}
+
+
+void
+RpcChannelTest::testCodec()
+{
+    xmlrpc_c::paramList params;
+    params.add(MakeValue());
+    params.add(xmlrpc_c::value_string(""));
+    string data;
+    CPPUNIT_ASSERT( true == RpcCodec::EncodeCall("Test.Echo",params,data) );
+
+    string method;
+    xmlrpc_c::paramList decoded;
+    CPPUNIT_ASSERT( true == RpcCodec::DecodeCall(data,method,decoded) );
+    CPPUNIT_ASSERT( "Test.Echo" == method );
+    CPPUNIT_ASSERT( 2 == decoded.size() );
+    CheckValue(decoded[0]);
+    CPPUNIT_ASSERT( "" == decoded.getString(1) );
+
+    //  cut short anywhere
+    for ( size_t i = 0; i < data.size(); ++ i ) {
+        CPPUNIT_ASSERT( false == RpcCodec::DecodeCall(
+                data.substr(0,i), method, decoded ) );
+    }
+
+    //  nested deeper than the limit
+    xmlrpc_c::value value = xmlrpc_c::value_int(1);
+    for ( int i = 0; i < 100; ++ i ) {
+        value = xmlrpc_c::value_array(vector<xmlrpc_c::value>(1,value));
+    }
+    xmlrpc_c::paramList deep;
+    deep.add(value);
+    CPPUNIT_ASSERT( true == RpcCodec::EncodeCall("Test.Echo",deep,data) );
+    CPPUNIT_ASSERT( false == RpcCodec::DecodeCall(data,method,decoded) );
+
+    xmlrpc_c::rpcOutcome outcome;
+    CPPUNIT_ASSERT( true == RpcCodec::EncodeResponse(
+            xmlrpc_c::rpcOutcome(MakeValue()), data ) );
+    CPPUNIT_ASSERT( true == RpcCodec::DecodeResponse(data,outcome) );
+    CPPUNIT_ASSERT( true == outcome.succeeded() );
+    CheckValue(outcome.getResult());
+
+    CPPUNIT_ASSERT( true == RpcCodec::EncodeResponse( xmlrpc_c::rpcOutcome(
+            xmlrpc_c::fault("Test fault",xmlrpc_c::fault::CODE_TYPE) ), data ) );
+    CPPUNIT_ASSERT( true == RpcCodec::DecodeResponse(data,outcome) );
+    CPPUNIT_ASSERT( false == outcome.succeeded() );
+    CPPUNIT_ASSERT( xmlrpc_c::fault::CODE_TYPE == outcome.getFault().getCode() );
+    CPPUNIT_ASSERT( "Test fault" == outcome.getFault().getDescription() );
+}
+
+
+void
+RpcChannelTest::testCall()
+{
+    TestServer server(service);
+    WaitServer(service);
+
+    for ( int binary = 0; binary < 2; ++ binary ) {
+        for ( int connections = 0; connections < 3; ++ connections ) {
+            RpcChannel channel(service, connections, binary != 0);
+            xmlrpc_c::value result;
+
+            CPPUNIT_ASSERT( true == channel.Call(
+                    "Test.Request", MakeRequest("seed"), result ) );
+            CPPUNIT_ASSERT( true == xmlrpc_c::value_boolean(result) );
+            CPPUNIT_ASSERT( true == channel.Call(
+                    "Test.Release", MakeRelease(), result ) );
+            CPPUNIT_ASSERT( true == xmlrpc_c::value_boolean(result) );
+
+            xmlrpc_c::paramList params;
+            params.add(MakeValue());
+            CPPUNIT_ASSERT( true == channel.Call("Test.Echo",params,result) );
+            CheckValue(result);
+
+            CPPUNIT_ASSERT( false == channel.Call(
+                    "Test.Fault", xmlrpc_c::paramList(), result ) );
+            CPPUNIT_ASSERT( false == channel.Call(
+                    "Test.None", xmlrpc_c::paramList(), result ) );
+            //  still usable after the faults
+            CPPUNIT_ASSERT( true == channel.Call("Test.Echo",params,result) );
+            CheckValue(result);
+
+            //  a binary call answered in XML
+            xmlrpc_c::paramList size;
+            size.add(xmlrpc_c::value_int(300));
+            CPPUNIT_ASSERT( true == channel.Call("Test.Bytes",size,result) );
+            vector<unsigned char> data =
+                    xmlrpc_c::value_bytestring(result).vectorUcharValue();
+            CPPUNIT_ASSERT( 300 == data.size() );
+            CPPUNIT_ASSERT( 43 == data[299] );
+        }
+    }
+
+    //  no server
+    RpcChannel channel(service + "None", 2, true);
+    xmlrpc_c::value result;
+    CPPUNIT_ASSERT( false == channel.Call(
+            "Test.Release", MakeRelease(), result ) );
+}
+
+
+void
+RpcChannelTest::testPipeline()
+{
+    TestServer server(service);
+    WaitServer(service);
+
+    //  one socket, the calls do not wait for each other: every call is
+    //  held by the server until all of them are in
+    RpcChannel channel(service, 1, true);
+    Caller caller(&channel, 0);
+
+    boost::thread_group group;
+    for ( int i = 0; i < 8; ++ i ) {
+        group.create_thread( boost::bind( &Caller::Meet, &caller, 8 ) );
+    }
+    group.join_all();
+
+    CPPUNIT_ASSERT( 8 == caller.calls_ );
+    CPPUNIT_ASSERT( 0 == caller.failures_ );
+    CPPUNIT_ASSERT( 8 == server.Meetings() );
+}
+
+
+void
+RpcChannelTest::testLegacy()
+{
+    LegacyServer server(service);
+    WaitServer(service);
+
+    RpcChannel channel(service, 2, true);
+    xmlrpc_c::paramList params;
+    params.add(MakeValue());
+    for ( int i = 0; i < 4; ++ i ) {
+        xmlrpc_c::value result;
+        CPPUNIT_ASSERT( true == channel.Call("Test.Echo",params,result) );
+        CheckValue(result);
+    }
+}
+
+
+void
+RpcChannelTest::testInterrupt()
+{
+    TestServer server(service);
+    WaitServer(service);
+
+    RpcChannel channel(service, 1, true);
+    Caller caller(&channel, 0);
+
+    //  the server interrupts the call, the caller gets no response; a
+    //  call that sleeps to its end succeeds
+    boost::thread sleep( boost::bind( &Caller::Sleep, &caller, 600000 ) );
+    string seed = boost::lexical_cast<string>(sleep.get_id());
+    xmlrpc_c::paramList params;
+    params.add(xmlrpc_c::value_string(seed));
+    xmlrpc_c::value result;
+    bool interrupted = false;
+    for ( int i = 0; i < 100 && ! interrupted; ++ i ) {
+        boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+        CPPUNIT_ASSERT( true == channel.Call("Test.Interrupt",params,result) );
+        interrupted = xmlrpc_c::value_boolean(result);
+    }
+    CPPUNIT_ASSERT( true == interrupted );
+    sleep.join();
+    CPPUNIT_ASSERT( 1 == caller.calls_ );
+    CPPUNIT_ASSERT( 1 == caller.failures_ );
+
+    //  the caller is interrupted while the server holds its call, the
+    //  response that comes once the next call frees it is dropped
+    boost::thread wait( boost::bind( &Caller::Meet, &caller, 2 ) );
+    for ( int i = 0; i < 1000 && server.Meetings() < 1; ++ i ) {
+        boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+    }
+    CPPUNIT_ASSERT( 1 == server.Meetings() );
+    wait.interrupt();
+    wait.join();
+    CPPUNIT_ASSERT( 1 == caller.calls_ );
+
+    params = xmlrpc_c::paramList();
+    params.add(xmlrpc_c::value_int(2));
+    CPPUNIT_ASSERT( true == channel.Call("Test.Meet",params,result) );
+    CPPUNIT_ASSERT( true == xmlrpc_c::value_boolean(result) );
+
+    params = xmlrpc_c::paramList();
+    params.add(MakeValue());
+    CPPUNIT_ASSERT( true == channel.Call("Test.Echo",params,result) );
+    CheckValue(result);
+}
+
+
+void
+RpcChannelBenchmark::setUp()
+{
+}
+
+
+void
+RpcChannelBenchmark::tearDown()
+{
+}
+
+
+void
+RpcChannelBenchmark::testRoundTrip()
+{
+    TestServer server(service);
+    WaitServer(service);
+
+    const int callers[] = { 1, 4, 16, 64, 256 };
+    const char * names[] = { "socket per call", "channel xml", "channel binary" };
+    const int total = 4000;
+
+    cout << endl << "Request/Release round trips, " << total
+            << " calls per run" << endl;
+    cout << "callers  mode             latency(us)  calls/s" << endl;
+    for ( size_t c = 0; c < sizeof(callers) / sizeof(callers[0]); ++ c ) {
+        double rates[3];
+        for ( int mode = 0; mode < 3; ++ mode ) {
+            RpcChannel channel(service, mode == 0 ? 0 : 4, mode == 2);
+            int count = total / callers[c];
+            Caller caller(&channel, count);
+
+            boost::posix_time::ptime begin =
+                    boost::posix_time::microsec_clock::universal_time();
+            boost::thread_group group;
+            for ( int i = 0; i < callers[c]; ++ i ) {
+                group.create_thread( boost::bind( &Caller::Call, &caller, i ) );
+            }
+            group.join_all();
+            long long duration =
+                    (boost::posix_time::microsec_clock::universal_time()
+                    - begin).total_microseconds();
+
+            CPPUNIT_ASSERT( count * callers[c] == caller.calls_ );
+            CPPUNIT_ASSERT( 0 == caller.failures_ );
+            rates[mode] = caller.calls_ * 1000000.0 / duration;
+            cout << setw(7) << callers[c] << "  " << setw(15) << left
+                    << names[mode] << right << "  " << setw(11)
+                    << caller.latency_ / caller.calls_ << "  " << setw(7)
+                    << (long long)rates[mode] << endl;
+        }
+        //  loose, the machine may be busy
+        CPPUNIT_ASSERT( rates[2] * 2 > rates[0] );
+    }
+}
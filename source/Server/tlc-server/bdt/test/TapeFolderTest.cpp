@@ -0,0 +1,205 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * TapeFolderTest.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+
+
+#include "stdafx.h"
+#include "../TapeFolder.h"
+#include "TapeFolderTest.h"
+
+
+CPPUNIT_TEST_SUITE_REGISTRATION( TapeFolderTest );
+
+
+static const fs::path root = "tapefolder";
+static const string barcode = "barcode0";
+
+
+//  same layout as the backup path of a cache number on tape
+static fs::path
+GetTapePath(unsigned long long number)
+{
+    fs::path path = root / barcode;
+    for ( int i = 7; i >= 0; -- i ) {
+        ostringstream os;
+        os << setw(2) << setfill('0') << hex << ((number >> (i * 8)) & 0xff);
+        path /= os.str();
+    }
+    return path;
+}
+
+
+static bool
+WriteFile(const fs::path & path)
+{
+    int handle = ::open(path.string().c_str(), O_CREAT|O_WRONLY|O_TRUNC, 0644);
+    if ( handle < 0 ) {
+        return false;
+    }
+    bool ret = ::write(handle, "x", 1) == 1;
+    ::close(handle);
+    return ret;
+}
+
+
+static void
+CreateFolders(TapeFolder * folders, int offset, bool * result)
+{
+    for ( int i = 0; i < 200; ++ i ) {
+        if ( ! folders->Create( barcode,
+                root / barcode / "a" / boost::lexical_cast<string>(
+                        (i + offset) % 50 ) / "b" / "c" ) ) {
+            * result = false;
+        }
+    }
+}
+
+
+void
+TapeFolderTest::setUp()
+{
+    fs::remove_all(root);
+    fs::create_directories(root / barcode);
+}
+
+
+void
+TapeFolderTest::tearDown()
+{
+    fs::remove_all(root);
+}
+
+
+void
+TapeFolderTest::testCreate()
+{
+    TapeFolder folders(1000);
+
+    fs::path folder = root / barcode / "00" / "01" / "02";
+    CPPUNIT_ASSERT( true == folders.Create(barcode, folder) );
+    CPPUNIT_ASSERT( true == fs::is_directory(folder) );
+    CPPUNIT_ASSERT( 3 == folders.GetCreated() );
+
+    //  known, no system call at all
+    CPPUNIT_ASSERT( true == folders.Create(barcode, folder) );
+    CPPUNIT_ASSERT( 3 == folders.GetCreated() );
+
+    //  only the missing ones
+    CPPUNIT_ASSERT( true == folders.Create(barcode, folder / "03") );
+    CPPUNIT_ASSERT( true == folders.Create(barcode, root / barcode / "00") );
+    CPPUNIT_ASSERT( 4 == folders.GetCreated() );
+
+    //  a file in the way
+    CPPUNIT_ASSERT( true == WriteFile(folder / "file") );
+    CPPUNIT_ASSERT( false == folders.Create(barcode, folder / "file") );
+    CPPUNIT_ASSERT( ENOTDIR == errno );
+    CPPUNIT_ASSERT( false == folders.Create(barcode, folder / "file" / "04") );
+    CPPUNIT_ASSERT( ENOTDIR == errno );
+}
+
+
+void
+TapeFolderTest::testRace()
+{
+    TapeFolder folders(1000);
+
+    bool result = true;
+    boost::thread_group group;
+    for ( int i = 0; i < 8; ++ i ) {
+        group.create_thread( boost::bind( CreateFolders,
+                &folders, i * 7, &result ) );
+    }
+    group.join_all();
+
+    CPPUNIT_ASSERT( true == result );
+    CPPUNIT_ASSERT( 151 == folders.GetCreated() );
+    for ( int i = 0; i < 50; ++ i ) {
+        CPPUNIT_ASSERT( true == fs::is_directory( root / barcode / "a"
+                / boost::lexical_cast<string>(i) / "b" / "c" ) );
+    }
+}
+
+
+void
+TapeFolderTest::testForget()
+{
+    TapeFolder folders(2);
+
+    fs::path folder = root / barcode / "00";
+    CPPUNIT_ASSERT( true == folders.Create(barcode, folder) );
+
+    //  removed behind its back, it is still known
+    fs::remove_all(folder);
+    CPPUNIT_ASSERT( true == folders.Create(barcode, folder) );
+    CPPUNIT_ASSERT( false == fs::exists(folder) );
+
+    folders.Forget(barcode);
+    CPPUNIT_ASSERT( true == folders.Create(barcode, folder) );
+    CPPUNIT_ASSERT( true == fs::is_directory(folder) );
+
+    //  the cache of a tape is cleared when it is full
+    CPPUNIT_ASSERT( true == folders.Create(barcode, root / barcode / "01") );
+    fs::remove_all(folder);
+    CPPUNIT_ASSERT( true == folders.Create(barcode, root / barcode / "02") );
+    CPPUNIT_ASSERT( true == folders.Create(barcode, folder) );
+    CPPUNIT_ASSERT( true == fs::is_directory(folder) );
+}
+
+
+void
+TapeFolderTest::testSmallFiles()
+{
+    //  the backup of 100k small files in a row
+    const int count = 100 * 1000;
+    TapeFolder folders(100000);
+
+    boost::posix_time::ptime begin =
+            boost::posix_time::microsec_clock::local_time();
+    for ( int i = 1; i <= count; ++ i ) {
+        fs::path path = GetTapePath(i);
+        CPPUNIT_ASSERT( true == folders.Create(barcode, path.parent_path()) );
+        CPPUNIT_ASSERT( true == WriteFile(path) );
+    }
+    int duration = (boost::posix_time::microsec_clock::local_time()
+            - begin).total_milliseconds();
+    unsigned long long created = folders.GetCreated();
+    //  7 for the first file, then one every 256 files and one at 64k
+    CPPUNIT_ASSERT( 7 + (count >> 8) + 1 == created );
+
+    //  the same with a shell per file, on a sample as it is slow
+    const int sample = 1000;
+    fs::remove_all(root / barcode);
+    fs::create_directories(root / barcode);
+    begin = boost::posix_time::microsec_clock::local_time();
+    for ( int i = 1; i <= sample; ++ i ) {
+        fs::path path = GetTapePath(i);
+        string cmd = "mkdir -p " + path.parent_path().string();
+        CPPUNIT_ASSERT( 0 == std::system(cmd.c_str()) );
+        CPPUNIT_ASSERT( true == WriteFile(path) );
+    }
+    int durationShell = (boost::posix_time::microsec_clock::local_time()
+            - begin).total_milliseconds();
+
+    cout << endl << count << " small files, in process: " << duration
+            << " ms, " << created << " mkdir, 0 processes; mkdir -p: "
+            << durationShell * (count / sample) << " ms (" << durationShell
+            << " ms for " << sample << "), " << count << " processes" << endl;
+    CPPUNIT_ASSERT( duration < durationShell * (count / sample) );
+}
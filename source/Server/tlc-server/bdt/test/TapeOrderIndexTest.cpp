@@ -0,0 +1,335 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * TapeOrderIndexTest.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+
+
+
+#include "stdafx.h"
+#include "../TapeOrderIndex.h"
+#include "TapeOrderIndexTest.h"
+
+
+CPPUNIT_TEST_SUITE_REGISTRATION( TapeOrderIndexTest );
+
+
+static const string barcode = "barcode0";
+
+
+static TapeOrderItem
+MakeItem(off_t block, unsigned long long number, off_t size)
+{
+    TapeOrderItem item;
+    item.block = block;
+    item.number = number;
+    item.size = size;
+    return item;
+}
+
+
+//  the numbers from number on, in tape order
+static vector<unsigned long long>
+Walk(TapeOrderIndex & index, const string & tape, unsigned long long number)
+{
+    vector<unsigned long long> numbers;
+    off_t size;
+    while ( 0 != number ) {
+        numbers.push_back(number);
+        if ( ! index.GetNext(tape, number, number, size) ) {
+            break;
+        }
+    }
+    return numbers;
+}
+
+
+void
+TapeOrderIndexTest::setUp()
+{
+}
+
+
+void
+TapeOrderIndexTest::tearDown()
+{
+}
+
+
+void
+TapeOrderIndexTest::testOrder()
+{
+    TapeOrderIndex index(4);
+
+    unsigned long long number;
+    off_t size, block;
+    CPPUNIT_ASSERT( false == index.IsLoaded(barcode) );
+    CPPUNIT_ASSERT( false == index.GetNext(barcode, 1, number, size) );
+
+    //  12 and 11 are in the pack at block 300
+    vector<TapeOrderItem> items;
+    items.push_back( MakeItem(500, 5, 50) );
+    items.push_back( MakeItem(100, 7, 70) );
+    items.push_back( MakeItem(300, 12, 120) );
+    items.push_back( MakeItem(900, 2, 20) );
+    items.push_back( MakeItem(300, 11, 110) );
+    CPPUNIT_ASSERT( true == index.BeginLoad(barcode) );
+    CPPUNIT_ASSERT( false == index.BeginLoad(barcode) );
+    index.Load(barcode, items);
+    CPPUNIT_ASSERT( true == index.IsLoaded(barcode) );
+    CPPUNIT_ASSERT( 5 == index.Size(barcode) );
+
+    const unsigned long long expect[] = { 7, 11, 12, 5, 2 };
+    vector<unsigned long long> numbers = Walk(index, barcode, 7);
+    CPPUNIT_ASSERT( 5 == numbers.size() );
+    for ( size_t i = 0; i < numbers.size(); ++ i ) {
+        CPPUNIT_ASSERT( expect[i] == numbers[i] );
+    }
+
+    CPPUNIT_ASSERT( true == index.GetNext(barcode, 12, number, size) );
+    CPPUNIT_ASSERT( 5 == number && 50 == size );
+    CPPUNIT_ASSERT( true == index.GetNext(barcode, 2, number, size) );
+    CPPUNIT_ASSERT( 0 == number );
+    CPPUNIT_ASSERT( false == index.GetNext(barcode, 3, number, size) );
+    CPPUNIT_ASSERT( false == index.GetNext("barcode1", 7, number, size) );
+
+    CPPUNIT_ASSERT( true == index.GetBlock(barcode, 11, block) );
+    CPPUNIT_ASSERT( 300 == block );
+    CPPUNIT_ASSERT( false == index.GetBlock(barcode, 3, block) );
+}
+
+
+void
+TapeOrderIndexTest::testChange()
+{
+    TapeOrderIndex index(4);
+
+    vector<TapeOrderItem> items;
+    for ( unsigned long long i = 1; i <= 10; ++ i ) {
+        items.push_back( MakeItem(i * 100, i, 1) );
+    }
+    index.BeginLoad(barcode);
+    index.Load(barcode, items);
+
+    //  not loaded, left alone
+    index.Add("barcode1", MakeItem(100, 99, 1));
+    CPPUNIT_ASSERT( false == index.IsLoaded("barcode1") );
+
+    //  a backup appends, a rewrite moves the file to the end
+    index.Add(barcode, MakeItem(1100, 11, 1));
+    index.Add(barcode, MakeItem(1200, 3, 1));
+    CPPUNIT_ASSERT( 11 == index.Size(barcode) );
+    off_t block;
+    CPPUNIT_ASSERT( true == index.GetBlock(barcode, 3, block) );
+    CPPUNIT_ASSERT( 1200 == block );
+
+    index.Remove(5);
+    index.Remove(5);
+    index.Remove(99);
+    CPPUNIT_ASSERT( 10 == index.Size(barcode) );
+    CPPUNIT_ASSERT( false == index.GetBlock(barcode, 5, block) );
+
+    const unsigned long long expect[] = { 1, 2, 4, 6, 7, 8, 9, 10, 11, 3 };
+    vector<unsigned long long> numbers = Walk(index, barcode, 1);
+    CPPUNIT_ASSERT( 10 == numbers.size() );
+    for ( size_t i = 0; i < numbers.size(); ++ i ) {
+        CPPUNIT_ASSERT( expect[i] == numbers[i] );
+    }
+
+    //  the holes are compacted on the way, the order stays
+    for ( unsigned long long i = 4; i <= 10; ++ i ) {
+        index.Remove(i);
+    }
+    CPPUNIT_ASSERT( 4 == index.Size(barcode) );
+    numbers = Walk(index, barcode, 1);
+    CPPUNIT_ASSERT( 4 == numbers.size() );
+    CPPUNIT_ASSERT( 1 == numbers[0] && 2 == numbers[1] );
+    CPPUNIT_ASSERT( 11 == numbers[2] && 3 == numbers[3] );
+
+    //  added back at its old block
+    index.Add(barcode, MakeItem(500, 5, 2));
+    off_t size;
+    unsigned long long next;
+    CPPUNIT_ASSERT( true == index.GetNext(barcode, 2, next, size) );
+    CPPUNIT_ASSERT( 5 == next && 2 == size );
+}
+
+
+void
+TapeOrderIndexTest::testLoad()
+{
+    TapeOrderIndex index(4);
+
+    //  what the catalog says, read while the backup and a delete go on
+    vector<TapeOrderItem> items;
+    items.push_back( MakeItem(100, 1, 1) );
+    items.push_back( MakeItem(200, 2, 1) );
+    items.push_back( MakeItem(300, 3, 1) );
+
+    CPPUNIT_ASSERT( true == index.BeginLoad(barcode) );
+    index.Add(barcode, MakeItem(400, 4, 1));
+    index.Remove(2);
+    index.Add(barcode, MakeItem(300, 3, 1));
+    CPPUNIT_ASSERT( false == index.IsLoaded(barcode) );
+    off_t block;
+    CPPUNIT_ASSERT( false == index.GetBlock(barcode, 1, block) );
+
+    index.Load(barcode, items);
+    vector<unsigned long long> numbers = Walk(index, barcode, 1);
+    CPPUNIT_ASSERT( 3 == numbers.size() );
+    CPPUNIT_ASSERT( 1 == numbers[0] && 3 == numbers[1] && 4 == numbers[2] );
+
+    //  a failed load starts over
+    CPPUNIT_ASSERT( true == index.BeginLoad("barcode1") );
+    index.Unload("barcode1");
+    CPPUNIT_ASSERT( true == index.BeginLoad("barcode1") );
+}
+
+
+void
+TapeOrderIndexTest::testTapes()
+{
+    TapeOrderIndex index(2);
+
+    const string tapes[] = { "barcode1", "barcode2", "barcode3" };
+    vector<TapeOrderItem> items;
+    for ( int i = 0; i < 2; ++ i ) {
+        items.assign( 1, MakeItem(100, 1, 1) );
+        index.BeginLoad(tapes[i]);
+        index.Load(tapes[i], items);
+    }
+    off_t block;
+    CPPUNIT_ASSERT( true == index.GetBlock(tapes[0], 1, block) );
+
+    //  barcode2 is the least recently used
+    items.assign( 1, MakeItem(100, 1, 1) );
+    index.BeginLoad(tapes[2]);
+    index.Load(tapes[2], items);
+    CPPUNIT_ASSERT( true == index.IsLoaded(tapes[0]) );
+    CPPUNIT_ASSERT( false == index.IsLoaded(tapes[1]) );
+    CPPUNIT_ASSERT( true == index.IsLoaded(tapes[2]) );
+
+    //  a delete reaches all of them
+    index.Remove(1);
+    CPPUNIT_ASSERT( 0 == index.Size(tapes[0]) );
+    CPPUNIT_ASSERT( 0 == index.Size(tapes[2]) );
+}
+
+
+void
+TapeOrderIndexTest::testRewrite()
+{
+    TapeOrderIndex index(4);
+
+    const string tapes[] = { "barcode1", "barcode2", "barcode3" };
+    vector<TapeOrderItem> items;
+    for ( int i = 0; i < 2; ++ i ) {
+        items.clear();
+        items.push_back( MakeItem(100, 1, 1) );
+        items.push_back( MakeItem(200, 2, 1) );
+        items.push_back( MakeItem(300, 3, 1) );
+        index.BeginLoad(tapes[i]);
+        index.Load(tapes[i], items);
+    }
+    index.BeginLoad(tapes[2]);
+
+    //  written again to barcode2, the copy on barcode1 is not read any more
+    index.Add(tapes[1], MakeItem(400, 2, 1));
+    off_t block;
+    CPPUNIT_ASSERT( false == index.GetBlock(tapes[0], 2, block) );
+    vector<unsigned long long> numbers = Walk(index, tapes[0], 1);
+    CPPUNIT_ASSERT( 2 == numbers.size() );
+    CPPUNIT_ASSERT( 1 == numbers[0] && 3 == numbers[1] );
+    CPPUNIT_ASSERT( true == index.GetBlock(tapes[1], 2, block) );
+    CPPUNIT_ASSERT( 400 == block );
+
+    //  and a tape being loaded drops what the catalog still had
+    items.assign( 1, MakeItem(100, 2, 1) );
+    index.Load(tapes[2], items);
+    CPPUNIT_ASSERT( 0 == index.Size(tapes[2]) );
+}
+
+
+void
+TapeOrderIndexTest::testPreReadPlan()
+{
+    //  a tape of 2M files of 1 to 64 blocks, every tenth packed by ten
+    const unsigned long long count = 2 * 1000 * 1000;
+    srand(1);
+    vector<TapeOrderItem> items;
+    items.reserve(count);
+    off_t block = 0;
+    for ( unsigned long long i = 1; i <= count; ++ i ) {
+        items.push_back( MakeItem(block, i, 64 * 1024) );
+        if ( i % 100 >= 10 || i % 10 == 0 ) {
+            block += 1 + rand() % 64;
+        }
+    }
+    random_shuffle(items.begin(), items.end());
+
+    TapeOrderIndex index(4);
+    boost::posix_time::ptime begin =
+            boost::posix_time::microsec_clock::local_time();
+    index.BeginLoad(barcode);
+    index.Load(barcode, items);
+    int load = (boost::posix_time::microsec_clock::local_time()
+            - begin).total_milliseconds();
+    CPPUNIT_ASSERT( count == index.Size(barcode) );
+
+    //  every plan walks the files behind the one read, as a pre-read of
+    //  a cache worth of small files does
+    const int plans = 10 * 1000;
+    const int depth = 64;
+    unsigned long long lookups = 0;
+    begin = boost::posix_time::microsec_clock::local_time();
+    for ( int i = 0; i < plans; ++ i ) {
+        unsigned long long number = 1 + (unsigned long long)rand() % count;
+        off_t start;
+        CPPUNIT_ASSERT( index.GetBlock(barcode, number, start) );
+        off_t size;
+        for ( int j = 0; j < depth && 0 != number; ++ j ) {
+            off_t last = start;
+            CPPUNIT_ASSERT( index.GetNext(barcode, number, number, size) );
+            ++ lookups;
+            if ( 0 != number ) {
+                CPPUNIT_ASSERT( index.GetBlock(barcode, number, start) );
+                CPPUNIT_ASSERT( start >= last );
+            }
+        }
+    }
+    int plan = (boost::posix_time::microsec_clock::local_time()
+            - begin).total_milliseconds();
+
+    //  deletes and backups go on while the tape is read
+    begin = boost::posix_time::microsec_clock::local_time();
+    for ( int i = 0; i < plans; ++ i ) {
+        index.Remove( 1 + (unsigned long long)rand() % count );
+        index.Add(barcode, MakeItem(++ block, count + i + 1, 1));
+    }
+    int change = (boost::posix_time::microsec_clock::local_time()
+            - begin).total_milliseconds();
+
+    cout << endl << count << " files loaded in " << load << " ms, "
+            << lookups << " neighbour lookups in " << plan << " ms ("
+            << plan * 1000.0 / lookups << " us each), "
+            << plans << " deletes and backups in " << change << " ms, "
+            << count * (sizeof(TapeOrderItem) + 16) / 1024 / 1024
+            << " MB" << endl;
+    //  a lookup of the catalog takes milliseconds, the index microseconds
+    CPPUNIT_ASSERT( plan * 1000.0 / lookups < 20 );
+}
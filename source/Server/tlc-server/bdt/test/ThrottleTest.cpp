@@ -118,3 +118,213 @@ ThrottleTest::testRequest()
     CPPUNIT_ASSERT( duration <= 1 );
 }
 
+
+
+//  a throttle on a clock that only moves when the test moves it
+class FakeClockThrottle : public Throttle
+{
+public:
+    FakeClockThrottle(int interval,long long valve)
+    : Throttle(interval,valve), now_(0), wait_(0)
+    {
+    }
+
+    long long now_;
+    long long wait_;
+
+protected:
+    virtual long long
+    Now()
+    {
+        return now_;
+    }
+
+    virtual void
+    Sleep(long long microseconds)
+    {
+        wait_ = microseconds;
+    }
+};
+
+
+//  Runs the writers on the fake clock, always the one which is earliest
+//  is next. Returns the bytes of every writer written until the end.
+static vector<long long>
+SimulateWriters(
+        FakeClockThrottle & throttle,
+        const vector<string> & clients,
+        int size,
+        long long end)
+{
+    vector<long long> times(clients.size(), 0);
+    vector<long long> written(clients.size(), 0);
+
+    while ( true ) {
+        size_t next = min_element(times.begin(), times.end()) - times.begin();
+        if ( times[next] >= end ) {
+            break;
+        }
+        throttle.now_ = times[next];
+        throttle.wait_ = 0;
+        throttle.Request(size,clients[next]);
+        times[next] += throttle.wait_ + 1;
+        if ( times[next] <= end ) {
+            written[next] += size;
+        }
+    }
+    return written;
+}
+
+
+static void
+CheckRate(long long written, double rate, long long duration)
+{
+    double expect = rate * duration / 1000000;
+    CPPUNIT_ASSERT_MESSAGE(
+            boost::lexical_cast<string>(written) + " for "
+            + boost::lexical_cast<string>(expect),
+            written >= expect * 0.98 && written <= expect * 1.02 );
+}
+
+
+static void
+CheckFair(const vector<long long> & written)
+{
+    long long least = * min_element(written.begin(), written.end());
+    long long most = * max_element(written.begin(), written.end());
+    CPPUNIT_ASSERT_MESSAGE(
+            boost::lexical_cast<string>(least) + " - "
+            + boost::lexical_cast<string>(most),
+            least >= most * 0.98 );
+}
+
+
+static long long
+Sum(const vector<long long> & written)
+{
+    long long sum = 0;
+    BOOST_FOREACH( long long value, written ) {
+        sum += value;
+    }
+    return sum;
+}
+
+
+void
+ThrottleTest::testRate()
+{
+    //  100 MB/s, bursts of 10 MB
+    const long long duration = 60LL * 1000000;
+    FakeClockThrottle throttle(100, 10LL * 1024 * 1024);
+    vector<string> clients(1, "pid:1");
+
+    vector<long long> written =
+            SimulateWriters(throttle, clients, 128 * 1024, duration);
+    CheckRate(written[0], 100.0 * 1024 * 1024, duration);
+
+    //  a new rate applies at once
+    throttle.Reset(1000, 20LL * 1024 * 1024);
+    throttle.now_ = 0;
+    written = SimulateWriters(throttle, clients, 4096, duration);
+    CheckRate(written[0], 20.0 * 1024 * 1024, duration);
+
+    //  no limit
+    throttle.Reset(0, 0);
+    throttle.wait_ = 0;
+    CPPUNIT_ASSERT( true == throttle.Request(1024 * 1024 * 1024) );
+    CPPUNIT_ASSERT( true == throttle.Request(1024 * 1024 * 1024) );
+    CPPUNIT_ASSERT( 0 == throttle.wait_ );
+}
+
+
+void
+ThrottleTest::testFairness()
+{
+    const long long duration = 60LL * 1000000;
+    FakeClockThrottle throttle(1000, 64LL * 1024 * 1024);
+    vector<string> clients;
+    for ( int i = 0; i < 16; ++ i ) {
+        clients.push_back( "pid:" + boost::lexical_cast<string>(i) );
+    }
+
+    vector<long long> written =
+            SimulateWriters(throttle, clients, 64 * 1024, duration);
+    CheckRate(Sum(written), 64.0 * 1024 * 1024, duration);
+    CheckFair(written);
+
+    //  with a limit per client which is above the fair share
+    throttle.Reset(1000, 64LL * 1024 * 1024);
+    throttle.ResetClient(1000, 16LL * 1024 * 1024);
+    written = SimulateWriters(throttle, clients, 64 * 1024, duration);
+    CheckRate(Sum(written), 64.0 * 1024 * 1024, duration);
+    CheckFair(written);
+}
+
+
+void
+ThrottleTest::testHierarchy()
+{
+    const long long duration = 60LL * 1000000;
+    FakeClockThrottle throttle(1000, 64LL * 1024 * 1024);
+    vector<string> clients;
+    for ( int i = 0; i < 4; ++ i ) {
+        clients.push_back( "uid:" + boost::lexical_cast<string>(i) );
+    }
+
+    //  the global rate is below the clients together
+    throttle.Reset(1000, 32LL * 1024 * 1024);
+    throttle.ResetClient(1000, 16LL * 1024 * 1024);
+    vector<long long> written =
+            SimulateWriters(throttle, clients, 64 * 1024, duration);
+    CheckRate(Sum(written), 32.0 * 1024 * 1024, duration);
+    CheckFair(written);
+
+    //  every client is below its share of the global rate
+    throttle.Reset(1000, 64LL * 1024 * 1024);
+    throttle.ResetClient(1000, 4LL * 1024 * 1024);
+    written = SimulateWriters(throttle, clients, 64 * 1024, duration);
+    BOOST_FOREACH( long long value, written ) {
+        CheckRate(value, 4.0 * 1024 * 1024, duration);
+    }
+
+    //  removing the client limit
+    throttle.ResetClient(0, 0);
+    throttle.Reset(0, 0);
+    throttle.wait_ = 0;
+    CPPUNIT_ASSERT( true == throttle.Request(1024 * 1024 * 1024, "uid:0") );
+    CPPUNIT_ASSERT( true == throttle.Request(1024 * 1024 * 1024, "uid:0") );
+    CPPUNIT_ASSERT( 0 == throttle.wait_ );
+}
+
+
+static void
+RequestTask(Throttle * throttle, const string & client, int size)
+{
+    throttle->Request(size, client);
+}
+
+
+void
+ThrottleTest::testSleepUnlocked()
+{
+    //  4 KB per 10 ms and client
+    Throttle throttle(0, 0);
+    throttle.ResetClient(10, 4096);
+
+    //  the slow client goes 200 ms into debt
+    CPPUNIT_ASSERT( true == throttle.Request(4096 + 81920, "slow") );
+    boost::thread slow( boost::bind(&RequestTask, &throttle, "slow", 4096) );
+    boost::this_thread::sleep( boost::posix_time::milliseconds(20) );
+
+    //  while it sleeps another client with budget goes on
+    boost::posix_time::ptime begin =
+            boost::posix_time::microsec_clock::local_time();
+    CPPUNIT_ASSERT( true == throttle.Request(4096, "fast") );
+    boost::posix_time::ptime end =
+            boost::posix_time::microsec_clock::local_time();
+    CPPUNIT_ASSERT( (end - begin).total_milliseconds() <= 5 );
+
+    CPPUNIT_ASSERT( false == slow.timed_join(
+            boost::posix_time::milliseconds(50) ) );
+    slow.join();
+}
@@ -26,6 +26,10 @@ class ThrottleTest : public CppUnit::TestFixture
 {
     CPPUNIT_TEST_SUITE( ThrottleTest );
     CPPUNIT_TEST( testRequest );
+    CPPUNIT_TEST( testRate );
+    CPPUNIT_TEST( testFairness );
+    CPPUNIT_TEST( testHierarchy );
+    CPPUNIT_TEST( testSleepUnlocked );
     CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -33,5 +37,9 @@ public:
     void tearDown();
 
     void testRequest();
+    void testRate();
+    void testFairness();
+    void testHierarchy();
+    void testSleepUnlocked();
 };
 
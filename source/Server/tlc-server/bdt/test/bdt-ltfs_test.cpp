@@ -33,6 +33,12 @@ int main ( int argc, char * argv[] )
 {
     CppUnit::Test * suite
         = CppUnit::TestFactoryRegistry::getRegistry().makeTest();
+    //  the benchmarks load the machine for minutes and print their
+    //  numbers, they only run on request
+    if ( argc > 1 && string(argv[1]) == "--benchmark" ) {
+        suite = CppUnit::TestFactoryRegistry::getRegistry("Benchmark")
+                .makeTest();
+    }
     CppUnit::TextUi::TestRunner runner;
     runner.addTest( suite );
     tape::Error error;
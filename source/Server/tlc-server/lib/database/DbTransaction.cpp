@@ -0,0 +1,101 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * DbTransaction.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+#include "ConnectionPool.h"
+#include "DbTransaction.h"
+
+DbTransaction::DbTransaction(Connection* conn)
+{
+	conn_ = conn;
+	bActive_ = false;
+	errorCode_ = 0;
+	try{
+		conn_->setAutoCommit(false);
+		bActive_ = true;
+	}
+	catch (sql::SQLException& e){
+		LtfsLogError("DbTransaction SQLState:"<<e.getSQLState() <<"  ErrorCode:"<<e.getErrorCode());
+	}
+	catch(std::exception& e){
+		LtfsLogError("DbTransaction exception " << e.what());
+	}
+}
+
+DbTransaction::~DbTransaction(void)
+{
+	if(bActive_){
+		Rollback();
+	}
+}
+
+
+bool DbTransaction::Commit()
+{
+	if(!bActive_){
+		return false;
+	}
+
+	try{
+		conn_->commit();
+		conn_->setAutoCommit(true);
+		bActive_ = false;
+		return true;
+	}
+	catch (sql::SQLException& e){
+		LtfsLogError("Commit SQLState:"<<e.getSQLState() <<"  ErrorCode:"<<e.getErrorCode());
+		errorCode_ = e.getErrorCode();
+	}
+	catch(std::exception& e){
+		LtfsLogError("Commit exception " << e.what());
+	}
+	return false;
+}
+
+int DbTransaction::GetErrorCode()
+{
+	return errorCode_;
+}
+
+bool DbTransaction::Rollback()
+{
+	if(!bActive_){
+		return false;
+	}
+
+	// the connection goes back to the pool in autocommit mode anyway
+	bActive_ = false;
+	try{
+		conn_->rollback();
+		conn_->setAutoCommit(true);
+		return true;
+	}
+	catch (sql::SQLException& e){
+		LtfsLogError("Rollback SQLState:"<<e.getSQLState() <<"  ErrorCode:"<<e.getErrorCode());
+	}
+	catch(std::exception& e){
+		LtfsLogError("Rollback exception " << e.what());
+	}
+	try{
+		conn_->setAutoCommit(true);
+	}
+	catch(std::exception& e){
+		LtfsLogError("Rollback exception " << e.what());
+	}
+	return false;
+}
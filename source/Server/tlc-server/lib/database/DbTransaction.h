@@ -0,0 +1,47 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * DbTransaction.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+#pragma once
+#include <cppconn/driver.h>
+#include <cppconn/statement.h>
+#include <cppconn/exception.h>
+#include <mysql_connection.h>
+#include "stdafx.h"
+
+using namespace sql;
+
+// Runs the statements on conn as one transaction, the ones not committed
+// are rolled back when it goes out of scope
+class DbTransaction
+{
+public:
+	DbTransaction(Connection* conn);
+
+	virtual
+	~DbTransaction(void);
+
+	bool Commit();
+	bool Rollback();
+	// the code of the SQL error failing Commit
+	int GetErrorCode();
+private:
+	Connection* conn_;
+	bool bActive_;
+	int errorCode_;
+};
@@ -25,7 +25,9 @@
 #include "../bdt/stdafx.h"
 #include "../bdt/ExtendedAttribute.h"
 #include "../bdt/Inode.h"
+#include "../bdt/FolderIdCache.h"
 #include "../lib/database/DbLock.h"
+#include "../lib/database/DbTransaction.h"
 
 using namespace bdt;
 namespace ltfs_management
@@ -33,6 +35,15 @@ namespace ltfs_management
 	#define CATALOG_DB_MAJOR_VERSION	1
 	#define LIBRARY_DB_MINOR_VERSION	0
 	static const string CATALOG_DB_VERSION_COMMENT	= "Original";
+	// rows in one multi-row statement of a batch
+	#define CATALOG_BATCH_ROWS			500
+	// rows moved from the tables of one tape into Tape_File at a time
+	#define CATALOG_MIGRATE_ROWS		1000
+	// seconds a table emptied is kept, for the reads that had it in their
+	// statement before
+	#define CATALOG_DROP_DELAY			60
+	// folder ids kept in process, for all the shares
+	#define CATALOG_FOLDER_CACHE_SIZE	(1000 * 1000)
 
     CatalogDbManager * CatalogDbManager::instance_ = NULL;
     boost::mutex CatalogDbManager::instanceMutex_;
@@ -69,6 +80,7 @@ namespace ltfs_management
     CatalogDbManager::CatalogDbManager()
     {
     	tableMap_.clear();
+    	folderCache_.reset(new FolderIdCache(CATALOG_FOLDER_CACHE_SIZE));
     	cPool_.reset(new ConnectionPool());
     	CreateDatabase();
         InitDB();
@@ -77,6 +89,9 @@ namespace ltfs_management
 
     CatalogDbManager::~CatalogDbManager()
     {
+    	// the thread uses the connections of the pool, it stops first
+    	thread_->interrupt();
+    	thread_->join();
     }
 
     string UUID2SQL(const string& uuid)
@@ -93,6 +108,59 @@ namespace ltfs_management
     	return strRet;
     }
 
+    // splits a meta path into its folder, ending with '/', and its name
+    static bool SplitMetaPath(const string& path, string& folder, string& name)
+    {
+    	size_t begin = 0;
+    	while(begin < path.length() && isspace((unsigned char)path[begin])){
+    		begin++;
+    	}
+    	size_t pos = path.length();
+    	while(pos > begin){
+    		pos = path.rfind('/', pos - 1);
+    		if(pos == string::npos || pos < begin){
+    			return false;
+    		}
+    		if(pos + 1 < path.length() && !isspace((unsigned char)path[pos + 1])){
+    			folder = path.substr(begin, pos + 1 - begin);
+    			name = path.substr(pos + 1);
+    			return true;
+    		}
+    	}
+    	return false;
+    }
+
+    // statements of at most CATALOG_BATCH_ROWS rows each, joined by sep
+    static void BatchSQL(const string& head, const vector<string>& rows, const string& sep, const string& tail, vector<string>& sqls)
+    {
+    	for(unsigned int i = 0; i < rows.size(); i += CATALOG_BATCH_ROWS){
+    		string strSQL = head;
+    		for(unsigned int j = i; j < rows.size() && j < i + CATALOG_BATCH_ROWS; j++){
+    			if(j != i){
+    				strSQL += sep;
+    			}
+    			strSQL += rows[j];
+    		}
+    		strSQL += tail;
+    		sqls.push_back(strSQL);
+    	}
+    }
+
+    // the condition on the paths starting with prefix, the like uses the
+    // index on path and the binary compare keeps the case
+    static string GetPrefixForSQL(const string& prefix)
+    {
+    	string pattern;
+    	for(unsigned int i = 0; i < prefix.length(); i++){
+    		if(prefix[i] == '|' || prefix[i] == '%' || prefix[i] == '_'){
+    			pattern += '|';
+    		}
+    		pattern += prefix[i];
+    	}
+    	string quoted = "'" + QuotaStringForSQL(prefix) + "'";
+    	return "path like '" + QuotaStringForSQL(pattern) + "%' escape '|' and left(path, char_length(" + quoted + ")) = binary " + quoted;
+    }
+
     void
     CatalogDbManager::InitDB()
     {
@@ -102,7 +170,8 @@ namespace ltfs_management
 			{
 				InitNewDB();
 			}
-
+			InitTapeFileTable();
+			FindLegacyTables();
 		}
 		catch (sql::SQLException& e)
 		{
@@ -208,7 +277,155 @@ namespace ltfs_management
 		return exist;
 	}
 
-	bool CatalogDbManager::CreateTables(const string& shareUuid, const string& barcode)
+	bool CatalogDbManager::PrepareFolderTable(const string& shareUuid)
+	{
+		string tableName = "Meta_Folder_" + UUID2SQL(shareUuid);
+		{
+			boost::unique_lock<boost::mutex> lock(folderTablesMutex_);
+			if(folderTables_.find(tableName) != folderTables_.end()){
+				return true;
+			}
+		}
+		if(!TableExists(tableName)){
+			return false;
+		}
+
+		boost::scoped_ptr<PreparedStatement> preStmt;
+		boost::scoped_ptr<ResultSet> rs;
+		GET_CONNECTION(connection, false);
+		string strSQL = "";
+
+		try{
+			// the tables of older versions have no hash of the path yet
+			strSQL = "SELECT column_name FROM information_schema.COLUMNS WHERE table_schema=DATABASE() AND table_name=? AND column_name='path_hash'";
+			PREPARE_SQL(strSQL);
+			preStmt->setString(1, tableName);
+			rs.reset(preStmt->executeQuery());
+			if(!rs->next()){
+				strSQL = "ALTER TABLE " + tableName + " ADD COLUMN path_hash BINARY(16), \
+						ADD INDEX iMetaFolderHash (path_hash), ADD INDEX iMetaFolderPath (path(255))";
+				PREPARE_SQL(strSQL);
+				preStmt->executeUpdate();
+				strSQL = "UPDATE " + tableName + " SET path_hash=UNHEX(MD5(path))";
+				PREPARE_SQL(strSQL);
+				preStmt->executeUpdate();
+			}
+
+			// a folder is added once, the rows older versions added again for
+			// it are merged into the first one before its hash is made unique
+			strSQL = "SELECT non_unique FROM information_schema.STATISTICS WHERE table_schema=DATABASE() AND table_name=? AND index_name='iMetaFolderHash'";
+			PREPARE_SQL(strSQL);
+			preStmt->setString(1, tableName);
+			rs.reset(preStmt->executeQuery());
+			bool indexed = rs->next();
+			if(!indexed || rs->getInt(1) != 0){
+				LtfsLogInfo("PrepareFolderTable: merging the folders of " << tableName);
+				strSQL = "UPDATE " + tableName + " SET path_hash=UNHEX(MD5(path)) WHERE path_hash IS NULL";
+				PREPARE_SQL(strSQL);
+				preStmt->executeUpdate();
+				string duplicates = "(SELECT id FROM (SELECT DISTINCT d.id FROM " + tableName + " d JOIN " + tableName
+						+ " k ON k.path_hash=d.path_hash AND k.id<d.id) x)";
+				string fileTable = "Meta_File_" + UUID2SQL(shareUuid);
+				if(TableExists(fileTable)){
+					strSQL = "UPDATE " + fileTable + " SET meta_folder=(SELECT MIN(k.id) FROM " + tableName + " d JOIN " + tableName
+							+ " k ON k.path_hash=d.path_hash WHERE d.id=" + fileTable + ".meta_folder) WHERE meta_folder IN " + duplicates;
+					PREPARE_SQL(strSQL);
+					preStmt->executeUpdate();
+				}
+				strSQL = "DELETE FROM " + tableName + " WHERE id IN " + duplicates;
+				PREPARE_SQL(strSQL);
+				preStmt->executeUpdate();
+				strSQL = "ALTER TABLE " + tableName + (indexed ? " DROP INDEX iMetaFolderHash," : "")
+						+ " ADD UNIQUE INDEX iMetaFolderHash (path_hash)";
+				PREPARE_SQL(strSQL);
+				preStmt->executeUpdate();
+			}
+		}
+		catch (sql::SQLException& e){
+			LtfsLogError("PrepareFolderTable \""<<strSQL <<"\" SQLState:"<<e.getSQLState() <<"  ErrorCode:"<<e.getErrorCode());
+			return false;
+		}
+		catch(std::exception& e){
+			LtfsLogError("PrepareFolderTable exception " << e.what());
+			return false;
+		}
+
+		boost::unique_lock<boost::mutex> lock(folderTablesMutex_);
+		folderTables_.insert(tableName);
+		return true;
+	}
+
+	// the ids of the folders, from the cache or the catalog, the ones not in
+	// the catalog are added. The version is taken before the first lookup.
+	bool CatalogDbManager::GetFolderIds(Connection* connection, const string& shareUuid, const set<string>& folders, map<string, long long>& folderIdMap, unsigned long long& version)
+	{
+		string sUuid = UUID2SQL(shareUuid);
+		boost::scoped_ptr<PreparedStatement> preStmt;
+		boost::scoped_ptr<ResultSet> rs;
+		string strSQL = "";
+
+		set<string> misses;
+		for(set<string>::const_iterator it = folders.begin(); it != folders.end(); it++){
+			long long id = 0;
+			unsigned long long current = 0;
+			if(folderCache_->Get(sUuid + ":" + *it, id, current)){
+				folderIdMap[*it] = id;
+			}else{
+				misses.insert(*it);
+			}
+			if(it == folders.begin()){
+				version = current;
+			}
+		}
+
+		// the second pass adds the folders not found by the first
+		for(int pass = 0; pass < 2 && !misses.empty(); pass++){
+			vector<string> sqls;
+			vector<string> rows;
+			if(pass == 1){
+				for(set<string>::iterator it = misses.begin(); it != misses.end(); it++){
+					string path = "'" + QuotaStringForSQL(*it) + "'";
+					rows.push_back(path + ",UNHEX(MD5(" + path + "))");
+				}
+				// a folder another batch added meanwhile is left as it is
+				BatchSQL("insert ignore into Meta_Folder_" + sUuid + "(path, path_hash) values (", rows, "),(", ")", sqls);
+				for(unsigned int i = 0; i < sqls.size(); i++){
+					strSQL = sqls[i];
+					PREPARE_SQL(strSQL);
+					preStmt->executeUpdate();
+				}
+				sqls.clear();
+				rows.clear();
+			}
+			for(set<string>::iterator it = misses.begin(); it != misses.end(); it++){
+				rows.push_back("UNHEX(MD5('" + QuotaStringForSQL(*it) + "'))");
+			}
+			BatchSQL("select id, path from Meta_Folder_" + sUuid + " where path_hash in (", rows, ",", ")", sqls);
+			for(unsigned int i = 0; i < sqls.size(); i++){
+				// a locking read sees the rows committed since the transaction began
+				strSQL = pass == 1 ? sqls[i] + " lock in share mode" : sqls[i];
+				PREPARE_SQL(strSQL);
+				rs.reset(preStmt->executeQuery());
+				while(rs->next()){
+					string path = rs->getString("path");
+					if(misses.erase(path) > 0){
+						folderIdMap[path] = rs->getInt64("id");
+					}
+				}
+			}
+		}
+		return misses.empty();
+	}
+
+	void CatalogDbManager::PutFolderIds(const string& shareUuid, const map<string, long long>& folderIdMap, unsigned long long version)
+	{
+		string sUuid = UUID2SQL(shareUuid);
+		for(map<string, long long>::const_iterator it = folderIdMap.begin(); it != folderIdMap.end(); it++){
+			folderCache_->Put(sUuid + ":" + it->first, it->second, version);
+		}
+	}
+
+	bool CatalogDbManager::CreateTables(const string& shareUuid)
 	{
 		string sUuid = UUID2SQL(shareUuid);
         string strSQL;
@@ -244,28 +461,17 @@ namespace ltfs_management
 			tableName = "Meta_Folder_" + sUuid;
 			if(tableMap_.find(tableName) == tableMap_.end()){
 				if(!TableExists(tableName)){
+					// the folders are looked up by the md5 of their path, renamed by its prefix
 					strSQL = "CREATE TABLE IF NOT EXISTS " + tableName + " (id INTEGER PRIMARY KEY NOT NULL auto_increment, \
-							path VARCHAR(512) ) ENGINE=InnoDB DEFAULT CHARSET=utf8;";
-					LtfsLogInfo("CreateTables: strSQL = " << strSQL);
-					stmt->execute(strSQL);
-					tableMap_[tableName] = true;
-				}
-			}
-
-			tableName = "File_" + barcode + "_" + sUuid;
-			if(barcode != "" && tableMap_.find(tableName) == tableMap_.end()){
-				if(!TableExists(tableName)){
-					strSQL = "CREATE TABLE IF NOT EXISTS " + tableName + " (uuid BIGINT PRIMARY KEY  NOT NULL, \
-							offset BIGINT NOT NULL, \
-							flag integer NOT NULL, \
-							size BIGINT NOT NULL) \
+							path VARCHAR(512), path_hash BINARY(16), \
+							UNIQUE INDEX iMetaFolderHash (path_hash), INDEX iMetaFolderPath (path(255)) ) \
 							ENGINE=InnoDB DEFAULT CHARSET=utf8;";
 					LtfsLogInfo("CreateTables: strSQL = " << strSQL);
 					stmt->execute(strSQL);
 					tableMap_[tableName] = true;
-					strSQL = "ALTER TABLE " + tableName + " ADD INDEX iTapeFileIndex (uuid, offset, flag);";
-					LtfsLogDebug("Creating Index for " << tableName << ". sql = " << strSQL);
-					stmt->execute(strSQL);
+				}
+				if(!PrepareFolderTable(sUuid)){
+					return false;
 				}
 			}
 
@@ -280,6 +486,239 @@ namespace ltfs_management
 		return false;
 	}
 
+	// one table for the files of all the tapes and shares, a file packed
+	// with others has the pack and its position in it, the pack is empty
+	// when the file is on its own. Tape_Share has the tapes that had files
+	// of a share, as the tables per tape did.
+	bool CatalogDbManager::InitTapeFileTable()
+	{
+		string strSQL;
+		boost::scoped_ptr<Statement> stmt;
+		GET_CONNECTION(connection, false);
+
+		try{
+			stmt.reset( connection->createStatement() );
+			strSQL = "CREATE TABLE IF NOT EXISTS Tape_File (share VARCHAR(64) NOT NULL, tape VARCHAR(32) NOT NULL, \
+					uuid BIGINT NOT NULL, offset BIGINT NOT NULL, flag integer NOT NULL, size BIGINT NOT NULL, \
+					pack VARCHAR(128) NOT NULL DEFAULT '', position BIGINT NOT NULL DEFAULT 0, \
+					PRIMARY KEY (share, tape, uuid), \
+					INDEX iTapeFileUuid (share, uuid), \
+					INDEX iTapeFileOffset (share, tape, flag, offset)) \
+					ENGINE=InnoDB DEFAULT CHARSET=utf8;";
+			stmt->execute(strSQL);
+			strSQL = "CREATE TABLE IF NOT EXISTS Tape_Share (share VARCHAR(64) NOT NULL, tape VARCHAR(32) NOT NULL, \
+					PRIMARY KEY (share, tape)) ENGINE=InnoDB DEFAULT CHARSET=utf8;";
+			stmt->execute(strSQL);
+			return true;
+		}
+		catch (sql::SQLException& e){
+			LtfsLogError("InitTapeFileTable \""<<strSQL <<"\" SQLState:"<<e.getSQLState() <<"  ErrorCode:"<<e.getErrorCode());
+		}
+		catch(std::exception& e){
+			LtfsLogError("InitTapeFileTable exception " << e.what());
+		}
+		return false;
+	}
+
+	// the File_<barcode>_<share> tables of older versions, they are read
+	// along with Tape_File until MigrateTapeFiles has moved their rows
+	void CatalogDbManager::FindLegacyTables()
+	{
+		string strSQL;
+		boost::scoped_ptr<PreparedStatement> preStmt;
+		boost::scoped_ptr<ResultSet> rs;
+		GET_CONNECTION_VOID(connection);
+
+		try{
+			set<string> packTables;
+			strSQL = "select table_name from information_schema.TABLES where table_schema=DATABASE() and table_name like 'Pack|_%' escape '|'";
+			PREPARE_SQL(strSQL);
+			rs.reset(preStmt->executeQuery());
+			while(rs->next()){
+				packTables.insert(rs->getString("table_name"));
+			}
+
+			vector<string> shares;
+			strSQL = "select table_name from information_schema.TABLES where table_schema=DATABASE() and table_name like 'File|_%' escape '|'";
+			PREPARE_SQL(strSQL);
+			rs.reset(preStmt->executeQuery());
+			boost::unique_lock<boost::mutex> lock(legacyMutex_);
+			while(rs->next()){
+				// the barcodes have no '_', the shares do
+				string tableName = rs->getString("table_name");
+				size_t pos = tableName.find('_', 5);
+				if(pos == string::npos){
+					continue;
+				}
+				string barcode = tableName.substr(5, pos - 5);
+				string sUuid = tableName.substr(pos + 1);
+				legacyTables_[make_pair(sUuid, barcode)] = packTables.find("Pack_" + barcode + "_" + sUuid) != packTables.end();
+				shares.push_back("('" + QuotaStringForSQL(sUuid) + "','" + QuotaStringForSQL(barcode) + "')");
+			}
+			lock.unlock();
+
+			vector<string> sqls;
+			BatchSQL("insert ignore into Tape_Share values ", shares, ",", "", sqls);
+			for(unsigned int i = 0; i < sqls.size(); i++){
+				strSQL = sqls[i];
+				PREPARE_SQL(strSQL);
+				preStmt->executeUpdate();
+			}
+			if(shares.size() > 0){
+				LtfsLogInfo(shares.size() << " tape file tables to move into Tape_File");
+			}
+		}
+		catch (sql::SQLException& e){
+			LtfsLogError("FindLegacyTables \""<<strSQL <<"\" SQLState:"<<e.getSQLState() <<"  ErrorCode:"<<e.getErrorCode());
+		}
+		catch(std::exception& e){
+			LtfsLogError("FindLegacyTables exception " << e.what());
+		}
+	}
+
+	void CatalogDbManager::GetLegacyTapes(const string& shareUuid, const string& barcode, map<string, bool>& tapes)
+	{
+		string sUuid = UUID2SQL(shareUuid);
+		boost::unique_lock<boost::mutex> lock(legacyMutex_);
+		map<pair<string, string>, bool>::iterator it = legacyTables_.lower_bound(make_pair(sUuid, barcode));
+		for(; it != legacyTables_.end() && it->first.first == sUuid; it++){
+			if(barcode != "" && it->first.second != barcode){
+				break;
+			}
+			tapes[it->first.second] = it->second;
+		}
+	}
+
+	// the rows of the share, or of one tape of it, as a table named
+	// Tape_File, with the ones of the tapes not moved yet
+	string CatalogDbManager::GetTapeFileSource(const string& shareUuid, const string& barcode)
+	{
+		string sUuid = UUID2SQL(shareUuid);
+		map<string, bool> tapes;
+		GetLegacyTapes(sUuid, barcode, tapes);
+		if(tapes.empty()){
+			return "Tape_File";
+		}
+
+		string source = "(select share, tape, uuid, offset, flag, size, pack, position from Tape_File where share='" + sUuid + "'";
+		if(barcode != ""){
+			source += " and tape='" + QuotaStringForSQL(barcode) + "'";
+		}
+		for(map<string, bool>::iterator it = tapes.begin(); it != tapes.end(); it++){
+			string suffix = it->first + "_" + sUuid;
+			source += " union all select '" + sUuid + "', '" + it->first + "', f.uuid, f.offset, f.flag, f.size, ";
+			if(it->second){
+				source += "coalesce(p.pack, ''), coalesce(p.position, 0) from File_" + suffix + " f left join Pack_" + suffix + " p on p.uuid=f.uuid";
+			}else{
+				source += "'', 0 from File_" + suffix + " f";
+			}
+		}
+		source += ") as Tape_File";
+		return source;
+	}
+
+	bool CatalogDbManager::MigrateTapeFiles(unsigned int rows)
+	{
+		{
+			boost::unique_lock<boost::mutex> lock(legacyMutex_);
+			if(legacyTables_.empty() && legacyDrops_.empty()){
+				return false;
+			}
+		}
+		boost::scoped_ptr<PreparedStatement> preStmt;
+		boost::scoped_ptr<ResultSet> rs;
+		GET_CONNECTION(connection, true);
+		string strSQL = "";
+
+		try{
+			// the tables emptied a while ago, no reader uses them any more
+			vector<string> drops;
+			pair<string, string> key;
+			bool packed = false;
+			{
+				boost::unique_lock<boost::mutex> lock(legacyMutex_);
+				boost::posix_time::ptime expired = boost::posix_time::second_clock::universal_time()
+						- boost::posix_time::seconds(CATALOG_DROP_DELAY);
+				for(map<string, boost::posix_time::ptime>::iterator it = legacyDrops_.begin(); it != legacyDrops_.end(); ){
+					if(it->second <= expired){
+						drops.push_back(it->first);
+						legacyDrops_.erase(it++);
+					}else{
+						it++;
+					}
+				}
+				if(!legacyTables_.empty()){
+					key = legacyTables_.begin()->first;
+					packed = legacyTables_.begin()->second;
+				}
+			}
+			for(unsigned int i = 0; i < drops.size(); i++){
+				strSQL = "drop table if exists " + drops[i];
+				PREPARE_SQL(strSQL);
+				preStmt->executeUpdate();
+			}
+			if(key.first == ""){
+				return !drops.empty();
+			}
+
+			string suffix = key.second + "_" + key.first;
+			string fileTable = "File_" + suffix;
+			string packTable = "Pack_" + suffix;
+			strSQL = "select uuid from " + fileTable + " order by uuid limit " + boost::lexical_cast<string>(rows);
+			PREPARE_SQL(strSQL);
+			rs.reset(preStmt->executeQuery());
+			vector<string> uuids;
+			while(rs->next()){
+				uuids.push_back(boost::lexical_cast<string>(rs->getInt64("uuid")));
+			}
+			if(uuids.empty()){
+				boost::unique_lock<boost::mutex> lock(legacyMutex_);
+				legacyTables_.erase(key);
+				boost::posix_time::ptime now = boost::posix_time::second_clock::universal_time();
+				legacyDrops_[fileTable] = now;
+				if(packed){
+					legacyDrops_[packTable] = now;
+				}
+				LtfsLogInfo(fileTable << " moved into Tape_File");
+				return true;
+			}
+
+			// the rows written by AddTapeFiles since are newer than the
+			// ones moved, the reads see either table but never both
+			string uuidList = "(";
+			for(unsigned int i = 0; i < uuids.size(); i++){
+				uuidList += uuids[i] + ",";
+			}
+			uuidList[uuidList.length() - 1] = ')';
+			DbTransaction transaction(connection.get());
+			strSQL = "insert ignore into Tape_File select '" + key.first + "', '" + key.second + "', f.uuid, f.offset, f.flag, f.size, ";
+			if(packed){
+				strSQL += "coalesce(p.pack, ''), coalesce(p.position, 0) from " + fileTable + " f left join " + packTable + " p on p.uuid=f.uuid";
+			}else{
+				strSQL += "'', 0 from " + fileTable + " f";
+			}
+			strSQL += " where f.uuid in " + uuidList;
+			PREPARE_SQL(strSQL);
+			preStmt->executeUpdate();
+			strSQL = "delete from " + fileTable + " where uuid in " + uuidList;
+			PREPARE_SQL(strSQL);
+			preStmt->executeUpdate();
+			if(packed){
+				strSQL = "delete from " + packTable + " where uuid in " + uuidList;
+				PREPARE_SQL(strSQL);
+				preStmt->executeUpdate();
+			}
+			return transaction.Commit();
+		}
+		catch (sql::SQLException& e){
+			LtfsLogError("MigrateTapeFiles \""<<strSQL <<"\" SQLState:"<<e.getSQLState() <<"  ErrorCode:"<<e.getErrorCode());
+		}
+		catch(std::exception& e){
+			LtfsLogError("MigrateTapeFiles exception " << e.what());
+		}
+		return false;
+	}
+
     void
     CatalogDbManager::InitNewDB()
     {
@@ -315,175 +754,161 @@ namespace ltfs_management
 
     bool CatalogDbManager::AddTapeFiles(const string& shareUuid, map<string, vector<TapeFileInfo> >& fileInfoMap)
     {
+    	SetLastError(0);
     	InitShareSizeMap(shareUuid);
-    	bool bRet = true;
 		string sUuid = UUID2SQL(shareUuid);
 		boost::scoped_ptr<PreparedStatement> preStmt;
 		boost::scoped_ptr<ResultSet> rs;
     	GET_CONNECTION(connection, false);
     	string strSQL = "";
-    	vector<string> folderList;
-    	vector<string> fileNameList;
-    	map<string, UInt64_t> numberSizeMap;
-    	for(map<string, vector<TapeFileInfo> >::iterator itTape = fileInfoMap.begin(); itTape != fileInfoMap.end(); itTape++){
-    		string barcode = itTape->first;
-    		if(!CreateTables(sUuid, barcode)){
-    			return false;
-    		}
+    	if(!CreateTables(sUuid)){
+    		return false;
     	}
 
-		string dbLockStr = "lock table Meta_File_" + sUuid + " write,  Meta_Folder_" + sUuid + " write ";
-        vector<string> tapes;
-        if(!TapeDbManager::Instance()->GetTapeGroupCartridgeList(shareUuid, tapes)){
-        	LtfsLogError("Failed to get tape list to delete uuid from tape file tables");
-        }else{
-        	for(unsigned int i = 0; i < tapes.size(); i++){
-        		string tapeTable = "File_" + tapes[i] + "_" + sUuid;
-        		if(TableExists(tapeTable)){
-        			dbLockStr += ", " + tapeTable + " write";
-        		}
-        	}
-        }
-    	DbLock dbLock(connection.get(), dbLockStr);
+		// the tables of older versions not moved into Tape_File yet
+		map<string, bool> legacyTapes;
+		GetLegacyTapes(sUuid, "", legacyTapes);
 
-		try{
-			string uuids = "(";
-			map<string, vector<TapeFileInfo> >::iterator itTape = fileInfoMap.begin();
-			if(itTape != fileInfoMap.end()){
-				for(unsigned int i = 0; i < itTape->second.size(); i++){
-					if(i != 0){
-						uuids += ",";
-					}
-					uuids += itTape->second[i].mUuid;
+		// every file once, the copies on the tapes share its meta row
+		map<string, const TapeFileInfo*> files;
+		map<string, pair<string, string> > paths;
+		set<string> folders;
+		for(map<string, vector<TapeFileInfo> >::iterator itTape = fileInfoMap.begin(); itTape != fileInfoMap.end(); itTape++){
+			for(unsigned int i = 0; i < itTape->second.size(); i++){
+				const TapeFileInfo& fileInfo = itTape->second[i];
+				if(files.find(fileInfo.mUuid) != files.end()){
+					continue;
 				}
+				string metaFolder;
+				string fileName;
+				if(!SplitMetaPath(fileInfo.mMetaFilePath, metaFolder, fileName)){
+					LtfsLogError("File path not correct: " << fileInfo.mMetaFilePath);
+					continue;
+				}
+				files[fileInfo.mUuid] = &fileInfo;
+				paths[fileInfo.mUuid] = make_pair(metaFolder, fileName);
+				folders.insert(metaFolder);
 			}
-			uuids += ")";
-			strSQL = "select uuid, size from Meta_File_" + sUuid + " where uuid in " + uuids;
-			PREPARE_SQL(strSQL);
-			rs.reset(preStmt->executeQuery());
-			while(rs->next()){
-				numberSizeMap[boost::lexical_cast<string>(rs->getInt64("uuid"))] = rs->getInt64("size");
-			}
-		}
-		catch (sql::SQLException& e){
-			LtfsLogError("AddTapeFile \""<<strSQL <<"\" SQLState:"<<e.getSQLState() <<"  ErrorCode:"<<e.getErrorCode());
 		}
-		catch(std::exception& e){
-			LtfsLogError("AddTapeFile exception " << e.what());
+		if(files.empty()){
+			return true;
 		}
 
-    	for(map<string, vector<TapeFileInfo> >::iterator itTape = fileInfoMap.begin(); itTape != fileInfoMap.end(); itTape++){
-    		string barcode = itTape->first;
-    		// check create database
-    		if(!CreateTables(sUuid, barcode)){
-    			return false;
-    		}
+		// a transaction instead of table locks, the readers keep on reading
+		// the rows as they were before the batch
+		map<string, UInt64_t> numberSizeMap;
+		map<string, long long> folderIdMap;
+		unsigned long long version = 0;
+		try{
+			DbTransaction transaction(connection.get());
+			vector<string> sqls;
 
-			map<string, off_t> folerIdMap;
-			for(unsigned int i = 0; i < itTape->second.size(); i++){
-				TapeFileInfo fileInfo = itTape->second[i];
-				regex matchPath("^\\s*(.*\\/)(\\S+.*)$");
-				cmatch match;
-				if(!regex_match(fileInfo.mMetaFilePath.c_str(), match, matchPath)){
-					LtfsLogError("File path not correct: " << fileInfo.mMetaFilePath);
-					folderList.push_back("");
-					fileNameList.push_back("");
-					continue;
-				}
-				string fileName = match[2];
-				string metaFolder = match[1];
-				folerIdMap[metaFolder] = 0;
-				folderList.push_back(metaFolder);
-				fileNameList.push_back(fileName);
-			}
-			for(map<string, off_t>::iterator it = folerIdMap.begin(); it != folerIdMap.end(); it++){
-				try{
-					long long metaFolderId = 0;
-					// check and insert if folder not in database
-					strSQL = "select id from Meta_Folder_" + sUuid + " where path='" + QuotaStringForSQL(it->first) + "'";
-					PREPARE_SQL(strSQL);
-					rs.reset(preStmt->executeQuery());
-					if(rs->next()){
-						metaFolderId = rs->getInt64("id");
-					}else{
-						strSQL = "insert into Meta_Folder_" + sUuid + "(path) values('" + QuotaStringForSQL(it->first) + "')";
-						PREPARE_SQL(strSQL);
-						preStmt->executeUpdate();
-
-						strSQL = "select id from Meta_Folder_" + sUuid + " where path='" + QuotaStringForSQL(it->first) + "'";
-						PREPARE_SQL(strSQL);
-						rs.reset(preStmt->executeQuery());
-						if(rs->next()){
-							metaFolderId = rs->getInt64("id");
-						}
-					}
-					folerIdMap[it->first] = metaFolderId;
-				}
-				catch (sql::SQLException& e){
-					LtfsLogError("AddTapeFile \""<<strSQL <<"\" SQLState:"<<e.getSQLState() <<"  ErrorCode:"<<e.getErrorCode());
-				}
-				catch(std::exception& e){
-					LtfsLogError("AddTapeFile exception " << e.what());
+			vector<string> uuids;
+			for(map<string, const TapeFileInfo*>::iterator it = files.begin(); it != files.end(); it++){
+				uuids.push_back(it->first);
+			}
+			BatchSQL("select uuid, size from Meta_File_" + sUuid + " where uuid in (", uuids, ",", ")", sqls);
+			for(unsigned int i = 0; i < sqls.size(); i++){
+				strSQL = sqls[i];
+				PREPARE_SQL(strSQL);
+				rs.reset(preStmt->executeQuery());
+				while(rs->next()){
+					numberSizeMap[boost::lexical_cast<string>(rs->getInt64("uuid"))] = rs->getInt64("size");
 				}
 			}
 
-			for(unsigned int i = 0; i < itTape->second.size(); i++){
-				TapeFileInfo fileInfo = itTape->second[i];
-				string metaFolder = folderList[i];
-				string fileName = fileNameList[i];
-				if(fileNameList[i] == "" || metaFolder == ""){
-					LtfsLogError("File path not correct: " << fileInfo.mMetaFilePath);
-					continue;
-				}
-				long long metaFolderId = 0;
-				if(folerIdMap.find(metaFolder) == folerIdMap.end()){
-					LtfsLogError("metaFolder not found: " << metaFolder);
+			strSQL = "";
+			GetFolderIds(connection.get(), sUuid, folders, folderIdMap, version);
+
+			vector<string> metaRows;
+			for(map<string, const TapeFileInfo*>::iterator it = files.begin(); it != files.end(); ){
+				const pair<string, string>& path = paths[it->first];
+				if(folderIdMap.find(path.first) == folderIdMap.end()){
+					LtfsLogError("metaFolder not found: " << path.first);
+					files.erase(it++);
 					continue;
 				}
-				metaFolderId = folerIdMap[metaFolder];
-				try{
-					for(unsigned int i = 0; i < tapes.size(); i++){
-						string tapeTable = "File_" + tapes[i] + "_" + sUuid;
-						LtfsLogDebug("tapeTable = " << tapeTable << ", barcode = " << barcode << ", tapes[" << i << "] = " << tapes[i]);
-						if(tapes[i] != barcode && TableExists(tapeTable)){
-							strSQL = "update " + tapeTable + " set flag=1 where uuid='" + fileInfo.mUuid + "'";
-							PREPARE_SQL(strSQL);
-							preStmt->executeUpdate();
-						}
-					}
-					// insert/update into Meta_File
-					strSQL = "replace into Meta_File_" + sUuid + " values('" + fileInfo.mUuid + "'";
-					strSQL += ",'" + QuotaStringForSQL(fileName) + "'";
-					strSQL += "," + boost::lexical_cast<string>(metaFolderId);
-					strSQL += ", 0, " + boost::lexical_cast<string>(fileInfo.mSize) + ")";
-					PREPARE_SQL(strSQL);
-					preStmt->executeUpdate();
-
-					strSQL = "replace into File_" + barcode + "_" + sUuid + " values('" + fileInfo.mUuid + "'";
-					strSQL += "," + boost::lexical_cast<string>(fileInfo.mOffset);
-					strSQL += ",0, " + boost::lexical_cast<string>(fileInfo.mSize) + ")";
-					PREPARE_SQL(strSQL);
-					preStmt->executeUpdate();
+				metaRows.push_back("('" + it->first + "','" + QuotaStringForSQL(path.second) + "',"
+						+ boost::lexical_cast<string>(folderIdMap[path.first]) + ",0,"
+						+ boost::lexical_cast<string>(it->second->mSize) + ")");
+				it++;
+			}
+			sqls.clear();
+			BatchSQL("replace into Meta_File_" + sUuid + " values ", metaRows, ",", "", sqls);
+
+			// the copies written before are stale, the ones written now
+			// replace them below
+			uuids.clear();
+			for(map<string, const TapeFileInfo*>::iterator it = files.begin(); it != files.end(); it++){
+				uuids.push_back(it->first);
+			}
+			BatchSQL("update Tape_File set flag=1 where share='" + sUuid + "' and uuid in (", uuids, ",", ")", sqls);
+			for(map<string, bool>::iterator it = legacyTapes.begin(); it != legacyTapes.end(); it++){
+				BatchSQL("update File_" + it->first + "_" + sUuid + " set flag=1 where uuid in (", uuids, ",", ")", sqls);
+			}
 
-					{
-						boost::unique_lock<boost::mutex> lock(shareSizeMapMutex_);
-						LtfsLogDebug("GetTotalSize: add uuid: " << fileInfo.mUuid << ", shareUuid = " << shareUuid << ", size: " << fileInfo.mSize << ". shareSizeMap_[shareUuid] = " << shareSizeMap_[shareUuid]);
-						shareSizeMap_[shareUuid] += fileInfo.mSize;
-						if(numberSizeMap.find(fileInfo.mUuid) != numberSizeMap.end()){
-							shareSizeMap_[shareUuid] -= numberSizeMap[fileInfo.mUuid];
-							LtfsLogDebug("GetTotalSize: add uuid: " << fileInfo.mUuid << ", numberSizeMap[fileInfo.mUuid] = " << numberSizeMap[fileInfo.mUuid] << ". shareSizeMap_[shareUuid] = " << shareSizeMap_[shareUuid]);
-						}
+			// a file packed before may be on its own now, or in another pack
+			vector<string> tapeRows;
+			for(map<string, vector<TapeFileInfo> >::iterator itTape = fileInfoMap.begin(); itTape != fileInfoMap.end(); itTape++){
+				string tape = QuotaStringForSQL(itTape->first);
+				vector<string> written;
+				for(unsigned int i = 0; i < itTape->second.size(); i++){
+					const TapeFileInfo& fileInfo = itTape->second[i];
+					if(files.find(fileInfo.mUuid) == files.end()){
+						continue;
 					}
+					tapeRows.push_back("('" + sUuid + "','" + tape + "'," + fileInfo.mUuid + ","
+							+ boost::lexical_cast<string>(fileInfo.mOffset) + ",0,"
+							+ boost::lexical_cast<string>(fileInfo.mSize) + ",'" + QuotaStringForSQL(fileInfo.mPack) + "',"
+							+ boost::lexical_cast<string>(fileInfo.mPosition) + ")");
+					written.push_back(fileInfo.mUuid);
 				}
-				catch (sql::SQLException& e){
-					LtfsLogError("AddTapeFiles \""<<strSQL <<"\" SQLState:"<<e.getSQLState() <<"  ErrorCode:"<<e.getErrorCode());
-				}
-				catch(std::exception& e){
-					LtfsLogError("AddTapeFiles exception " << e.what());
+				// the rows of the tape not moved yet would shadow the new ones
+				map<string, bool>::iterator itLegacy = legacyTapes.find(itTape->first);
+				if(itLegacy != legacyTapes.end()){
+					string suffix = itTape->first + "_" + sUuid;
+					BatchSQL("delete from File_" + suffix + " where uuid in (", written, ",", ")", sqls);
+					if(itLegacy->second){
+						BatchSQL("delete from Pack_" + suffix + " where uuid in (", written, ",", ")", sqls);
+					}
 				}
-			}//for
-    	}//for
-    	return bRet;
+				sqls.push_back("insert ignore into Tape_Share values ('" + sUuid + "','" + tape + "')");
+			}
+			BatchSQL("replace into Tape_File values ", tapeRows, ",", "", sqls);
+
+			for(unsigned int i = 0; i < sqls.size(); i++){
+				strSQL = sqls[i];
+				PREPARE_SQL(strSQL);
+				preStmt->executeUpdate();
+			}
+			strSQL = "";
+			if(!transaction.Commit()){
+				SetLastError(transaction.GetErrorCode());
+				return false;
+			}
+		}
+		catch (sql::SQLException& e){
+			LtfsLogError("AddTapeFiles \""<<strSQL <<"\" SQLState:"<<e.getSQLState() <<"  ErrorCode:"<<e.getErrorCode());
+			SetLastError(e.getErrorCode());
+			return false;
+		}
+		catch(std::exception& e){
+			LtfsLogError("AddTapeFiles exception " << e.what());
+			return false;
+		}
+
+		// the folders added by the batch are cached once they are committed
+		PutFolderIds(sUuid, folderIdMap, version);
+
+		boost::unique_lock<boost::mutex> lock(shareSizeMapMutex_);
+		for(map<string, const TapeFileInfo*>::iterator it = files.begin(); it != files.end(); it++){
+			shareSizeMap_[shareUuid] += it->second->mSize;
+			if(numberSizeMap.find(it->first) != numberSizeMap.end()){
+				shareSizeMap_[shareUuid] -= numberSizeMap[it->first];
+			}
+		}
+		LtfsLogDebug("GetTotalSize: added " << files.size() << " files, shareSizeMap_[shareUuid] = " << shareSizeMap_[shareUuid]);
+    	return true;
     }
 
 	bool CatalogDbManager::SetFileCorrupted(const string& shareUuid, const string& shareName, const string& uuid, bool bCorrupted)
@@ -540,6 +965,7 @@ namespace ltfs_management
 
 	bool CatalogDbManager::RenameMetaFile(const string& shareUuid, const string& uuid, const string& newPathName)
 	{
+		SetLastError(0);
 		string sUuid = UUID2SQL(shareUuid);
 		boost::scoped_ptr<PreparedStatement> preStmt;
 		boost::scoped_ptr<ResultSet> rs;
@@ -551,43 +977,34 @@ namespace ltfs_management
     		string folderPath = GetFolderPath(newPathName) + "/";
     		string fileName = GetFileName(newPathName);
 
-    		if(!TableExists("Meta_File_" + sUuid) || !TableExists("Meta_Folder_" + sUuid)){
+    		if(!TableExists("Meta_File_" + sUuid) || !PrepareFolderTable(sUuid)){
     			return true;
     		}
-    		string dbLockStr = "lock table Meta_File_" + sUuid + " write, Meta_Folder_" + sUuid + " write";
-        	DbLock dbLock(connection.get(), dbLockStr);
 
-    		string tableName = "Meta_Folder_" + sUuid;
-    		strSQL = "select id from " + tableName + " where path='" + QuotaStringForSQL(folderPath) + "'";
+    		set<string> folders;
+    		folders.insert(folderPath);
+    		map<string, long long> folderIdMap;
+    		unsigned long long version = 0;
+    		DbTransaction transaction(connection.get());
+    		if(!GetFolderIds(connection.get(), sUuid, folders, folderIdMap, version)){
+    			LtfsLogError("metaFolder not found: " << folderPath);
+    			return false;
+    		}
+			strSQL = "update Meta_File_" + sUuid + " set meta_folder=" + boost::lexical_cast<string>(folderIdMap[folderPath]) + ", filename='";
+			strSQL += QuotaStringForSQL(fileName) + "' where uuid='" + uuid + "'";
 			PREPARE_SQL(strSQL);
-			rs.reset(preStmt->executeQuery());
-			long long folderId = -1;
-			if(rs->next()){
-				folderId = rs->getInt64("id");
-			}
-			if(folderId <= 0){
-				strSQL = "insert into " + tableName + "(path) values('" + QuotaStringForSQL(folderPath) + "')";
-				PREPARE_SQL(strSQL);
-				preStmt->executeUpdate();
-	    		strSQL = "select id from " + tableName + " where path='" + QuotaStringForSQL(folderPath) + "'";
-	    		PREPARE_SQL(strSQL);
-				rs.reset(preStmt->executeQuery());
-				if(rs->next()){
-					folderId = rs->getInt64("id");
-				}
+			preStmt->executeUpdate();
+			if(!transaction.Commit()){
+				SetLastError(transaction.GetErrorCode());
+				return false;
 			}
-    		tableName = "Meta_File_" + sUuid;
-    		if(TableExists(tableName)){
-				strSQL = "update " + tableName + " set meta_folder=" + boost::lexical_cast<string>(folderId) + ", filename='";
-				strSQL += QuotaStringForSQL(fileName) + "' where uuid='" + uuid + "'";
-				PREPARE_SQL(strSQL);
-				preStmt->executeUpdate();
-    		}
+			PutFolderIds(sUuid, folderIdMap, version);
             return true;
 		}
 		catch (sql::SQLException& e)
 		{
 			LtfsLogError("RenameMetaFile \""<<strSQL <<"\" SQLState:"<<e.getSQLState() <<"  ErrorCode:"<<e.getErrorCode());
+			SetLastError(e.getErrorCode());
 		}
     	catch(std::exception& e)
 		{
@@ -598,41 +1015,59 @@ namespace ltfs_management
 
 	bool CatalogDbManager::RenameMetaFolder(const string& shareUuid, const string& oldFolder, const string& newFolder)
 	{
+		SetLastError(0);
 		string sUuid = UUID2SQL(shareUuid);
 		boost::scoped_ptr<PreparedStatement> preStmt;
     	GET_CONNECTION(connection, false);
     	string strSQL = "";
 
+		string folderOld = oldFolder;
+		string folderNew = newFolder;
+		if(folderOld[folderOld.length() - 1] != '/'){
+			folderOld += "/";
+		}
+		if(folderNew[folderNew.length() - 1] != '/'){
+			folderNew += "/";
+		}
+
     	try
 		{
     		string tableName = "Meta_Folder_" + sUuid;
-    		if(!TableExists(tableName)){
+    		if(!PrepareFolderTable(sUuid)){
     			return true;
     		}
-    		string dbLockStr = "lock table " + tableName + " write";
-        	DbLock dbLock(connection.get(), dbLockStr);
 
-    		string folderOld = oldFolder;
-    		string folderNew = newFolder;
-    		if(folderOld[folderOld.length() - 1] != '/'){
-    			folderOld += "/";
+    		// the folders left at the target without files give way, the
+    		// hashes are unique
+    		if(TableExists("Meta_File_" + sUuid)){
+    			strSQL = "delete from " + tableName + " where " + GetPrefixForSQL(folderNew)
+    					+ " and not exists (select 1 from Meta_File_" + sUuid + " f where f.meta_folder=" + tableName + ".id)";
+    			PREPARE_SQL(strSQL);
+    			preStmt->executeUpdate();
     		}
-    		if(folderNew[folderNew.length() - 1] != '/'){
-    			folderNew += "/";
-    		}
-            strSQL = "update " + tableName + " set path=replace(path, '" + QuotaStringForSQL(folderOld) + "', '" + QuotaStringForSQL(folderNew) + "')";
+
+    		// the folder and the ones below it in one statement, the hash
+    		// is set from the path already renamed
+    		string oldPath = "'" + QuotaStringForSQL(folderOld) + "'";
+            strSQL = "update " + tableName + " set path=concat('" + QuotaStringForSQL(folderNew) + "', substring(path, char_length(" + oldPath + ") + 1)), ";
+            strSQL += "path_hash=UNHEX(MD5(path)) where " + GetPrefixForSQL(folderOld);
 			PREPARE_SQL(strSQL);
             preStmt->executeUpdate();
+            folderCache_->Rename(sUuid + ":" + folderOld, sUuid + ":" + folderNew);
             return true;
 		}
 		catch (sql::SQLException& e)
 		{
 			LtfsLogError("RenameMetaFolder \""<<strSQL <<"\" SQLState:"<<e.getSQLState() <<"  ErrorCode:"<<e.getErrorCode());
+			SetLastError(e.getErrorCode());
 		}
     	catch(std::exception& e)
 		{
 			LtfsLogError("RenameMetaFolder exception " << e.what());
 		}
+		// whether the rename reached the catalog is not known
+		folderCache_->Erase(sUuid + ":" + folderOld);
+		folderCache_->Erase(sUuid + ":" + folderNew);
 		return false;
 	}
 
@@ -650,94 +1085,135 @@ namespace ltfs_management
             deleteFolders_.clear();
             lock.unlock();
             if(deleteFiles.size() <= 0 && deleteFolders.size() <=0){
-                boost::this_thread::sleep(boost::posix_time::milliseconds(100));
+            	// the tables of older versions are moved while idle
+            	if(!MigrateTapeFiles(CATALOG_MIGRATE_ROWS)){
+            		boost::this_thread::sleep(boost::posix_time::milliseconds(100));
+            	}
             	continue;
             }
 
-            boost::scoped_ptr<PreparedStatement> preStmt;
-            GET_CONNECTION_COTINUE(connection);
-        	string strSQL = "";
-
-    		string dbLockStr = "";
-    		if(deleteFiles.size() >0){
-				for(map<string, vector<string> >::iterator it = deleteFiles.begin(); it != deleteFiles.end(); it++){
-					string tableName = "Meta_File_" + it->first;
-					if(TableExists(tableName) && it->second.size() > 0){
-						if(dbLockStr.length() <= 0){
-							dbLockStr = "lock table ";
-						}else{
-							dbLockStr += ",";
-						}
-						dbLockStr += tableName + " write";
-					}
-				}
-    		}
-			if(deleteFolders.size() > 0){
-				for(map<string, vector<string> >::iterator it = deleteFolders.begin(); it != deleteFolders.end(); it++){
-					string tableName = "Meta_Folder_" + it->first;
-					if(TableExists(tableName) && it->second.size() > 0){
-						if(dbLockStr.length() <= 0){
-							dbLockStr = "lock table ";
-						}else{
-							dbLockStr += ",";
-						}
-						dbLockStr += tableName + " write";
-					}
-				}
+			for(map<string, vector<string> >::iterator it = deleteFiles.begin(); it != deleteFiles.end(); it++){
+				DeleteMetaFiles(it->first, it->second);
+			}
+			for(map<string, vector<string> >::iterator it = deleteFolders.begin(); it != deleteFolders.end(); it++){
+				DeleteMetaFolders(it->first, it->second);
 			}
-        	DbLock dbLock(connection.get(), dbLockStr);
-        	vector<string>  refreshShares;
+		}//while
+	}
 
-			if(deleteFiles.size() >0){
-				for(map<string, vector<string> >::iterator it = deleteFiles.begin(); it != deleteFiles.end(); it++){
-					string tableName = "Meta_File_" + it->first;
-					if(TableExists(tableName) && it->second.size() > 0){
-						strSQL = "delete from " + tableName + " where uuid in (";
-						for(unsigned int i = 0; i < it->second.size(); i++){
-							strSQL += "'" + it->second[i] + "',";
-						}
-						strSQL[strSQL.length() - 1] = ')';
-						try{
-							PREPARE_SQL(strSQL);
-							preStmt->executeUpdate();
-						}catch (sql::SQLException& e){
-							LtfsLogError("Delete File \""<<strSQL <<"\" SQLState:"<<e.getSQLState() <<"  ErrorCode:"<<e.getErrorCode());
-						}catch(std::exception& e){
-							LtfsLogError("Delete File exception " << e.what());
-						}
-						refreshShares.push_back(it->first);
-					}//if
-				}//for
-			}//if
-
-
-			if(deleteFolders.size() > 0){
-				for(map<string, vector<string> >::iterator it = deleteFolders.begin(); it != deleteFolders.end(); it++){
-					string tableName = "Meta_Folder_" + it->first;
-					if(TableExists(tableName) && it->second.size() > 0){
-						for(unsigned int i = 0; i < it->second.size(); i++){
-							strSQL = "delete from Meta_Folder_" + tableName + " where path like '%" + QuotaStringForSQL(it->second[i]) + "%'";
-							try{
-								PREPARE_SQL(strSQL);
-								preStmt->executeUpdate();
-							}catch (sql::SQLException& e){
-								LtfsLogError("Delete folder \""<<strSQL <<"\" SQLState:"<<e.getSQLState() <<"  ErrorCode:"<<e.getErrorCode());
-							}catch(std::exception& e){
-								LtfsLogError("Delete folder exception " << e.what());
-							}
-						}//for
-					}//if
-				}//for
-			}//if
+	bool CatalogDbManager::DeleteMetaFiles(const string& shareUuid, const vector<string>& uuids)
+	{
+		SetLastError(0);
+		string sUuid = UUID2SQL(shareUuid);
+		string tableName = "Meta_File_" + sUuid;
+		if(uuids.size() <= 0 || !TableExists(tableName)){
+			return true;
+		}
+		boost::scoped_ptr<PreparedStatement> preStmt;
+		GET_CONNECTION(connection, false);
+		string strSQL = "";
 
+		try{
+			vector<string> values;
+			for(unsigned int i = 0; i < uuids.size(); i++){
+				values.push_back("'" + uuids[i] + "'");
+			}
+			vector<string> sqls;
+			BatchSQL("delete from " + tableName + " where uuid in (", values, ",", ")", sqls);
+			DbLock dbLock(connection.get(), "lock table " + tableName + " write");
+			for(unsigned int i = 0; i < sqls.size(); i++){
+				strSQL = sqls[i];
+				PREPARE_SQL(strSQL);
+				preStmt->executeUpdate();
+			}
 			dbLock.UnLockTables();
+
 			//updater total size of shares
-			for(unsigned int i = 0; i < refreshShares.size(); i++){
-				off_t totalSize = GetTotalSize(refreshShares[i]);
-				boost::unique_lock<boost::mutex> lock(shareSizeMapMutex_);
-				shareSizeMap_[refreshShares[i]] = totalSize;
+			off_t totalSize = GetTotalSize(sUuid);
+			boost::unique_lock<boost::mutex> lock(shareSizeMapMutex_);
+			shareSizeMap_[sUuid] = totalSize;
+			return true;
+		}
+		catch (sql::SQLException& e){
+			LtfsLogError("Delete File \""<<strSQL <<"\" SQLState:"<<e.getSQLState() <<"  ErrorCode:"<<e.getErrorCode());
+			SetLastError(e.getErrorCode());
+		}
+		catch(std::exception& e){
+			LtfsLogError("Delete File exception " << e.what());
+		}
+		return false;
+	}
+
+	bool CatalogDbManager::DeleteMetaFolders(const string& shareUuid, const vector<string>& folders)
+	{
+		SetLastError(0);
+		string sUuid = UUID2SQL(shareUuid);
+		string tableName = "Meta_Folder_" + sUuid;
+		if(folders.size() <= 0 || !TableExists(tableName)){
+			return true;
+		}
+		boost::scoped_ptr<PreparedStatement> preStmt;
+		GET_CONNECTION(connection, false);
+		string strSQL = "";
+
+		try{
+			DbLock dbLock(connection.get(), "lock table " + tableName + " write");
+			for(unsigned int i = 0; i < folders.size(); i++){
+				string folder = folders[i];
+				if(folder.empty() || folder[folder.length() - 1] != '/'){
+					folder += "/";
+				}
+				strSQL = "delete from " + tableName + " where " + GetPrefixForSQL(folder);
+				folderCache_->Erase(sUuid + ":" + folder);
+				PREPARE_SQL(strSQL);
+				preStmt->executeUpdate();
 			}
-		}//while
+			return true;
+		}
+		catch (sql::SQLException& e){
+			LtfsLogError("Delete folder \""<<strSQL <<"\" SQLState:"<<e.getSQLState() <<"  ErrorCode:"<<e.getErrorCode());
+			SetLastError(e.getErrorCode());
+		}
+		catch(std::exception& e){
+			LtfsLogError("Delete folder exception " << e.what());
+		}
+		return false;
+	}
+
+	int CatalogDbManager::GetLastError()
+	{
+		int * code = lastError_.get();
+		return code == NULL ? 0 : * code;
+	}
+
+	void CatalogDbManager::SetLastError(int code)
+	{
+		if(lastError_.get() == NULL){
+			lastError_.reset(new int(code));
+		}else{
+			* lastError_ = code;
+		}
+	}
+
+	bool CatalogDbManager::IsAvailable()
+	{
+		boost::scoped_ptr<PreparedStatement> preStmt;
+		boost::scoped_ptr<ResultSet> rs;
+		GET_CONNECTION(connection, false);
+		string strSQL = "select 1";
+
+		try{
+			PREPARE_SQL(strSQL);
+			rs.reset(preStmt->executeQuery());
+			return rs->next();
+		}
+		catch (sql::SQLException& e){
+			LtfsLogError("IsAvailable \""<<strSQL <<"\" SQLState:"<<e.getSQLState() <<"  ErrorCode:"<<e.getErrorCode());
+		}
+		catch(std::exception& e){
+			LtfsLogError("IsAvailable exception " << e.what());
+		}
+		return false;
 	}
 
 	bool CatalogDbManager::DeleteUuid(const string& shareUuid, const string& uuid)
@@ -767,19 +1243,33 @@ namespace ltfs_management
     	try
 		{
     		strSQL = "drop table if exists ";
-            vector<string> tapes;
-            if(!TapeDbManager::Instance()->GetTapeGroupCartridgeList(shareUuid, tapes)){
-            	LtfsLogError("Failed to get tape list to delete uuid from tape file tables");
-            	return false;
-            }else{
-				for(unsigned int i = 0; i < tapes.size(); i++){
-					strSQL += " File_" + tapes[i] + "_" + sUuid + ", ";
-				}
+            map<string, bool> tapes;
+            GetLegacyTapes(sUuid, "", tapes);
+            for(map<string, bool>::iterator it = tapes.begin(); it != tapes.end(); it++){
+				strSQL += " File_" + it->first + "_" + sUuid + ", ";
+				strSQL += " Pack_" + it->first + "_" + sUuid + ", ";
             }
             strSQL += " Meta_File_" + sUuid + ", ";
             strSQL += " Meta_Folder_" + sUuid;
 			PREPARE_SQL(strSQL);
             preStmt->executeUpdate();
+            {
+				boost::unique_lock<boost::mutex> lock(legacyMutex_);
+				for(map<string, bool>::iterator it = tapes.begin(); it != tapes.end(); it++){
+					legacyTables_.erase(make_pair(sUuid, it->first));
+				}
+            }
+            strSQL = "delete from Tape_File where share='" + sUuid + "'";
+			PREPARE_SQL(strSQL);
+            preStmt->executeUpdate();
+            strSQL = "delete from Tape_Share where share='" + sUuid + "'";
+			PREPARE_SQL(strSQL);
+            preStmt->executeUpdate();
+            {
+				boost::unique_lock<boost::mutex> lock(folderTablesMutex_);
+				folderTables_.erase("Meta_Folder_" + sUuid);
+            }
+            folderCache_->Erase(sUuid + ":");
 
             return true;
 		}
@@ -829,42 +1319,29 @@ namespace ltfs_management
     	try
 		{
     		backupInfo.clear();
-    		// delete files in File_XXX
             vector<string> tapes;
             if(!TapeDbManager::Instance()->GetTapeGroupCartridgeList(shareUuid, tapes)){
             	LtfsLogError("GetBackupPath: Failed to get tape list.");
             	return false;
             }
-            string dbLockStr = "";
-            for(unsigned int i = 0; i < tapes.size(); i++){
-            	string tableName = "File_" + tapes[i] + "_" + sUuid;
-            	if(TableExists(tableName)){
-					if(dbLockStr.length() <= 0){
-						dbLockStr = "lock table ";
-					}else{
-						dbLockStr += ", ";
-					}
-					dbLockStr += tableName + " read";
-            	}
-            }
-        	DbLock dbLock(connection.get(), dbLockStr);
+            set<string> groupTapes(tapes.begin(), tapes.end());
 
-            for(unsigned int i = 0; i < tapes.size(); i++){
-            	string tableName = "File_" + tapes[i] + "_" + sUuid;
-            	if(TableExists(tableName)){
-					strSQL = "select size from " + tableName + " where uuid='" + uuid + "'";
-					PREPARE_SQL(strSQL);
-					rs.reset(preStmt->executeQuery());
-					if(rs->next()){
-						string fullPath = COMM_MOUNT_PATH + "/" + tapes[i] + "/" + filePath;
-						BackupInfo item;
-						item.mUuid = uuid;
-						item.mSize = rs->getInt64("size");
-						item.mTapeFilePath = fullPath;
-						backupInfo[tapes[i]] = item;
-					}
-            	}
-            }
+            // the copies on all the tapes at once
+			strSQL = "select tape, size from " + GetTapeFileSource(sUuid, "") + " where share='" + sUuid + "' and uuid='" + uuid + "'";
+			PREPARE_SQL(strSQL);
+			rs.reset(preStmt->executeQuery());
+			while(rs->next()){
+				string tape = rs->getString("tape");
+				if(groupTapes.find(tape) == groupTapes.end()){
+					continue;
+				}
+				string fullPath = COMM_MOUNT_PATH + "/" + tape + "/" + filePath;
+				BackupInfo item;
+				item.mUuid = uuid;
+				item.mSize = rs->getInt64("size");
+				item.mTapeFilePath = fullPath;
+				backupInfo[tape] = item;
+			}
             return true;
 		}
 		catch (sql::SQLException& e)
@@ -887,9 +1364,9 @@ namespace ltfs_management
     	string strSQL = "";
 
 		try{
+			// a single select reads a consistent view, no table lock to wait
+			// for a batch being written
 			if(TableExists("Meta_File_" + sUuid) && TableExists("Meta_Folder_" + sUuid)){
-	            string dbLockStr = "lock table Meta_File_" + sUuid + " read, Meta_Folder_" + sUuid + " read";
-	        	DbLock dbLock(connection.get(), dbLockStr);
 				strSQL = "select filename, path from Meta_File_" + sUuid + " left join Meta_Folder_" \
 				+ sUuid + " on Meta_File_" + sUuid + ".meta_folder=Meta_Folder_" + sUuid \
 				+ ".id where Meta_File_" + sUuid + ".uuid='" + uuid + "'";
@@ -933,15 +1410,20 @@ namespace ltfs_management
     	off_t size = 0;
 
 		try{
-			string tableName = "Meta_File_" + sUuid;
 			if(barcode != ""){
-				tableName = "File_" + barcode + "_" + sUuid;
+				strSQL = "select sum(size) as total from " + GetTapeFileSource(sUuid, barcode);
+				strSQL += " where share='" + sUuid + "' and tape='" + QuotaStringForSQL(barcode) + "'";
+				PREPARE_SQL(strSQL);
+				rs.reset(preStmt->executeQuery());
+				if(rs->next()){
+					size = rs->getUInt64("total");
+				}
+				return size;
 			}
+			string tableName = "Meta_File_" + sUuid;
 			if(!TableExists(tableName)){
 				return 0;
 			}
-            string dbLockStr = "lock table " + tableName + " read";
-        	DbLock dbLock(connection.get(), dbLockStr);
 			strSQL = "select sum(size) as total from " + tableName;
 			PREPARE_SQL(strSQL);
 			rs.reset(preStmt->executeQuery());
@@ -969,12 +1451,10 @@ namespace ltfs_management
     	string strSQL = "";
 
 		try{
-			string tableName = "File_" + barcode + "_" + sUuid;
-            string dbLockStr = "lock table Meta_File_" + sUuid + " read, Meta_Folder_" + sUuid + " read, " + tableName + " read";
-            LtfsLogInfo("DBG: File 9");
-        	DbLock dbLock(connection.get(), dbLockStr);
+			string source = GetTapeFileSource(sUuid, barcode);
+			string tapeCond = "share='" + sUuid + "' and tape='" + QuotaStringForSQL(barcode) + "'";
 			// get offset of cur file
-			strSQL = "select offset from " + tableName + " where uuid='" + curUuid + "'";
+			strSQL = "select offset from " + source + " where " + tapeCond + " and uuid='" + curUuid + "'";
 			off_t curOffset = 0;
 			PREPARE_SQL(strSQL);
 			rs.reset(preStmt->executeQuery());
@@ -982,7 +1462,7 @@ namespace ltfs_management
 				curOffset = rs->getUInt64("offset");
 			}
 			// get uuid of next file
-			strSQL = "select uuid from " + tableName + " where flag=0 and offset > ";
+			strSQL = "select uuid from " + source + " where " + tapeCond + " and flag=0 and offset > ";
 			strSQL += boost::lexical_cast<string>(curOffset) + " order by offset ASC limit 1";
 			PREPARE_SQL(strSQL);
 			rs.reset(preStmt->executeQuery());;
@@ -1007,6 +1487,101 @@ namespace ltfs_management
 		return false;
 	}
 
+	bool CatalogDbManager::GetTapeFileOffset(const string& shareUuid, const string& barcode, const string& uuid, off_t& offset)
+	{
+		string sUuid = UUID2SQL(shareUuid);
+		boost::scoped_ptr<PreparedStatement> preStmt;
+		boost::scoped_ptr<ResultSet> rs;
+    	GET_CONNECTION(connection, false);
+    	string strSQL = "";
+
+		try{
+			strSQL = "select offset from " + GetTapeFileSource(sUuid, barcode);
+			strSQL += " where share='" + sUuid + "' and tape='" + QuotaStringForSQL(barcode) + "' and uuid='" + uuid + "'";
+			PREPARE_SQL(strSQL);
+			rs.reset(preStmt->executeQuery());
+			if(rs->next()){
+				offset = rs->getUInt64("offset");
+				return true;
+			}
+		}
+		catch (sql::SQLException& e){
+			LtfsLogError("GetTapeFileOffset \""<<strSQL <<"\" SQLState:"<<e.getSQLState() <<"  ErrorCode:"<<e.getErrorCode());
+		}
+		catch(std::exception& e){
+			LtfsLogError("GetTapeFileOffset exception " << e.what());
+		}
+
+		return false;
+	}
+
+	bool CatalogDbManager::GetTapeFiles(const string& shareUuid, const string& barcode, vector<TapeFileOrder>& files)
+	{
+		string sUuid = UUID2SQL(shareUuid);
+		boost::scoped_ptr<PreparedStatement> preStmt;
+		boost::scoped_ptr<ResultSet> rs;
+    	GET_CONNECTION(connection, false);
+    	string strSQL = "";
+
+		try{
+			strSQL = "select Tape_File.uuid, Tape_File.offset, m.size from " + GetTapeFileSource(sUuid, barcode);
+			strSQL += " join Meta_File_" + sUuid + " m on m.uuid=Tape_File.uuid";
+			strSQL += " where Tape_File.share='" + sUuid + "' and Tape_File.tape='" + QuotaStringForSQL(barcode) + "' and Tape_File.flag=0";
+			PREPARE_SQL(strSQL);
+			rs.reset(preStmt->executeQuery());
+			files.clear();
+			files.reserve(rs->rowsCount());
+			while(rs->next()){
+				TapeFileOrder file;
+				file.mUuid = rs->getUInt64("uuid");
+				file.mOffset = rs->getUInt64("offset");
+				file.mSize = rs->getUInt64("size");
+				files.push_back(file);
+			}
+			return true;
+		}
+		catch (sql::SQLException& e){
+			LtfsLogError("GetTapeFiles \""<<strSQL <<"\" SQLState:"<<e.getSQLState() <<"  ErrorCode:"<<e.getErrorCode());
+		}
+		catch(std::exception& e){
+			LtfsLogError("GetTapeFiles exception " << e.what());
+		}
+
+		return false;
+	}
+
+	bool CatalogDbManager::GetTapeFilePack(const string& shareUuid, const string& barcode, const string& uuid, string& pack, off_t& position, off_t& size)
+	{
+		string sUuid = UUID2SQL(shareUuid);
+		boost::scoped_ptr<PreparedStatement> preStmt;
+		boost::scoped_ptr<ResultSet> rs;
+    	GET_CONNECTION(connection, false);
+    	string strSQL = "";
+    	pack = "";
+
+		try{
+			// the pack is empty for a file on its own
+			strSQL = "select pack, position, size from " + GetTapeFileSource(sUuid, barcode);
+			strSQL += " where share='" + sUuid + "' and tape='" + QuotaStringForSQL(barcode) + "' and uuid='" + uuid + "'";
+			PREPARE_SQL(strSQL);
+			rs.reset(preStmt->executeQuery());
+			if(rs->next() && rs->getString("pack") != ""){
+				pack = rs->getString("pack");
+				position = rs->getUInt64("position");
+				size = rs->getUInt64("size");
+			}
+			return true;
+		}
+		catch (sql::SQLException& e){
+			LtfsLogError("GetTapeFilePack \""<<strSQL <<"\" SQLState:"<<e.getSQLState() <<"  ErrorCode:"<<e.getErrorCode());
+		}
+		catch(std::exception& e){
+			LtfsLogError("GetTapeFilePack exception " << e.what());
+		}
+
+		return false;
+	}
+
 	bool CatalogDbManager::NeedDeleteFileOnTape(const string& shareUuid, const string& barcode)
 	{
 		vector<string> uuids;
@@ -1024,15 +1599,16 @@ namespace ltfs_management
 		boost::scoped_ptr<ResultSet> rs;
     	GET_CONNECTION(connection, false);
     	string strSQL = "";
-    	string tableName = "File_" + barcode + "_" + sUuid;
-    	if(!TableExists(tableName)){
-    		// table not exists, assume tape has files
-    		return true;
-    	}
-        string dbLockStr = "lock table " + tableName + " read";
-    	DbLock dbLock(connection.get(), dbLockStr);
+    	string tapeCond = "share='" + sUuid + "' and tape='" + QuotaStringForSQL(barcode) + "'";
 		try{
-			strSQL = "select uuid from " + tableName + " limit 1";
+			strSQL = "select tape from Tape_Share where " + tapeCond;
+			PREPARE_SQL(strSQL);
+			rs.reset(preStmt->executeQuery());
+			if(!rs->next()){
+	    		// no file of the share was ever on the tape, assume tape has files
+				return true;
+			}
+			strSQL = "select uuid from " + GetTapeFileSource(sUuid, barcode) + " where " + tapeCond + " limit 1";
 			PREPARE_SQL(strSQL);
 			rs.reset(preStmt->executeQuery());
 			while(rs->next()){
@@ -1059,17 +1635,10 @@ namespace ltfs_management
     	GET_CONNECTION(connection, false);
     	uuids.clear();
     	string strSQL = "";
-    	string tableName = "File_" + barcode + "_" + sUuid;
-    	if(!TableExists(tableName)){
-    		LtfsLogDebug("No need to delete files on tape " << barcode);
-    		return true;
-    	}
-        string dbLockStr = "lock table Meta_File_" + sUuid + " read, " + tableName + " read";
-    	DbLock dbLock(connection.get(), dbLockStr);
-
 		try{
-			strSQL = "select uuid from " + tableName + " where uuid not in (select uuid from Meta_File_" + sUuid;
-			strSQL += ") or flag=1 ";
+			strSQL = "select uuid from " + GetTapeFileSource(sUuid, barcode);
+			strSQL += " where share='" + sUuid + "' and tape='" + QuotaStringForSQL(barcode) + "'";
+			strSQL += " and (uuid not in (select uuid from Meta_File_" + sUuid + ") or flag=1)";
 			if(limit > 0){
 				strSQL += " limit " + boost::lexical_cast<string>(limit);
 			}
@@ -1097,24 +1666,35 @@ namespace ltfs_management
 		boost::scoped_ptr<ResultSet> rs;
     	GET_CONNECTION(connection, false);
     	string strSQL = "";
-    	string tableName = "File_" + barcode + "_" + sUuid;
     	if(uuids.size() <= 0){
     		return true;
     	}
 
 		try{
-            string dbLockStr = "lock table " + tableName + " write";
-        	DbLock dbLock(connection.get(), dbLockStr);
+			map<string, bool> tapes;
+			GetLegacyTapes(sUuid, barcode, tapes);
+			DbTransaction transaction(connection.get());
 
-			strSQL = "delete from " + tableName + " where uuid in (";
+			string uuidList = "(";
 			for(unsigned int i = 0; i < uuids.size(); i++){
-				strSQL += uuids[i] + ",";
+				uuidList += uuids[i] + ",";
 			}
-			strSQL[strSQL.length() - 1] = ')';
+			uuidList[uuidList.length() - 1] = ')';
+			strSQL = "delete from Tape_File where share='" + sUuid + "' and tape='" + QuotaStringForSQL(barcode) + "' and uuid in " + uuidList;
 			LtfsLogDebug("delete files on tape sql: " << strSQL << ".");
 			PREPARE_SQL(strSQL);
        		preStmt->executeUpdate();
-			return true;
+			for(map<string, bool>::iterator it = tapes.begin(); it != tapes.end(); it++){
+				strSQL = "delete from File_" + it->first + "_" + sUuid + " where uuid in " + uuidList;
+				PREPARE_SQL(strSQL);
+				preStmt->executeUpdate();
+				if(it->second){
+					strSQL = "delete from Pack_" + it->first + "_" + sUuid + " where uuid in " + uuidList;
+					PREPARE_SQL(strSQL);
+					preStmt->executeUpdate();
+				}
+			}
+			return transaction.Commit();
 		}
 		catch (sql::SQLException& e){
 			LtfsLogError("NeedDeleteFileOnTape \""<<strSQL <<"\" SQLState:"<<e.getSQLState() <<"  ErrorCode:"<<e.getErrorCode());
@@ -1135,22 +1715,17 @@ namespace ltfs_management
 		boost::scoped_ptr<ResultSet> rs;
     	GET_CONNECTION(connection, false);
     	string strSQL = "";
-    	string tapeTableName = "File_" + barcode + "_" + sUuid;
-    	if(!TableExists(tapeTableName)){
-    		LtfsLogInfo("Table not exists: " << tapeTableName);
-    		return true;
-    	}
     	string metaTableName = "Meta_File_" + sUuid;
     	if(!TableExists(metaTableName)){
     		LtfsLogInfo("Table not exists: " << metaTableName);
     		return true;
     	}
-        string dbLockStr = "lock table " + metaTableName + " read, " + tapeTableName + " read";
-    	DbLock dbLock(connection.get(), dbLockStr);
+    	DbLock dbLock(connection.get());
 
 		try{
-			strSQL = "select uuid from " + tapeTableName + " where uuid in (select uuid from Meta_File_" + sUuid;
-			strSQL += ")";
+			strSQL = "select uuid from " + GetTapeFileSource(sUuid, barcode);
+			strSQL += " where share='" + sUuid + "' and tape='" + QuotaStringForSQL(barcode) + "'";
+			strSQL += " and uuid in (select uuid from Meta_File_" + sUuid + ")";
 			PREPARE_SQL(strSQL);
 			rs.reset(preStmt->executeQuery());
 			vector<string> uuids;
@@ -1165,8 +1740,7 @@ namespace ltfs_management
 				}
 			}
 			if(corruptedUuids.size() >0 && TableExists("Meta_Folder_" + sUuid)){
-	            dbLockStr = "lock table " + metaTableName + " read, Meta_Folder_" + sUuid + " read, " + tapeTableName + " read";
-	            dbLock.UnLockTables();
+	            string dbLockStr = "lock table " + metaTableName + " read, Meta_Folder_" + sUuid + " read";
 	        	dbLock.LockTables(dbLockStr);
 				strSQL = "select filename, path from Meta_File_" + sUuid + " left join Meta_Folder_" \
 				+ sUuid + " on Meta_File_" + sUuid + ".meta_folder=Meta_Folder_" + sUuid \
@@ -32,6 +32,11 @@
 
 using namespace sql;
 
+namespace bdt
+{
+	class FolderIdCache;
+}
+
 namespace ltfs_management
 {
 
@@ -49,6 +54,15 @@ namespace ltfs_management
 		string	mMetaFilePath;				// full path name on meta (including file name)
 		unsigned long long mOffset;
 		unsigned long long mSize;
+		string	mPack;						// file on tape packing it with others, empty when on its own
+		unsigned long long mPosition;		// where it starts in the pack
+	};
+
+	struct TapeFileOrder
+	{
+		unsigned long long mUuid;
+		unsigned long long mOffset;			// start block, the one of the pack when packed
+		unsigned long long mSize;
 	};
 
 	struct BackupInfo
@@ -93,6 +107,14 @@ namespace ltfs_management
 		bool RenameMetaFolder(const string& shareUuid, const string& oldFolder, const string& newFolder);
 		bool DeleteUuid(const string& shareUuid, const string& uuid);//
 		bool DeleteMetaFolder(const string& shareUuid, const string& folderPath);
+		// delete at once, DeleteUuid and DeleteMetaFolder queue it
+		bool DeleteMetaFiles(const string& shareUuid, const vector<string>& uuids);
+		bool DeleteMetaFolders(const string& shareUuid, const vector<string>& folders);
+		// the database answers
+		bool IsAvailable();
+		// the code of the SQL error failing the last change of the calling
+		// thread, 0 when it failed without one
+		int GetLastError();
 
 		// Get path to be backup on tape
 		bool GetPathForBackup(const string& uuid, string& backupPath);
@@ -101,6 +123,11 @@ namespace ltfs_management
 
 		bool GetMetaFilePath(const string& shareUuid, const string& uuid, string& metaFilePath);
 		bool GetNextTapeFile(const string& shareUuid, const string& barcode, const string& curUuid, off_t& size, string& nextUuid);
+		bool GetTapeFileOffset(const string& shareUuid, const string& barcode, const string& uuid, off_t& offset);
+		// pack is empty when the file is on the tape by itself
+		bool GetTapeFilePack(const string& shareUuid, const string& barcode, const string& uuid, string& pack, off_t& position, off_t& size);
+		// the files on the tape still in the share, in no order
+		bool GetTapeFiles(const string& shareUuid, const string& barcode, vector<TapeFileOrder>& files);
 
 		bool DeleteShare(const string& shareUuid);
 		bool GetTotalSize(const string& shareUuid, off_t& size);
@@ -114,7 +141,7 @@ namespace ltfs_management
 
 	private:
 		CatalogDbManager();
-		bool CreateTables(const string& shareUuid, const string& barcode);
+		bool CreateTables(const string& shareUuid);
 		off_t GetTotalSize(const string& shareUuid, const string& barcode = "");
 		void InitShareSizeMap(const string& shareUuid);
 
@@ -131,8 +158,19 @@ namespace ltfs_management
 
 		bool
 		TableExists(const string & tableName);
+		bool PrepareFolderTable(const string& shareUuid);
+		bool GetFolderIds(Connection* connection, const string& shareUuid, const set<string>& folders, map<string, long long>& folderIdMap, unsigned long long& version);
+		void PutFolderIds(const string& shareUuid, const map<string, long long>& folderIdMap, unsigned long long version);
+		bool InitTapeFileTable();
+		void FindLegacyTables();
+		void GetLegacyTapes(const string& shareUuid, const string& barcode, map<string, bool>& tapes);
+		string GetTapeFileSource(const string& shareUuid, const string& barcode);
+		// moves some rows of a table of older versions into Tape_File,
+		// false when there is nothing left to move
+		bool MigrateTapeFiles(unsigned int rows);
 		void ReleaseConnection(Connection * conn);
     	void DbThread();
+		void SetLastError(int code);
 
 	private:
 		boost::shared_mutex 			rwMutex_;
@@ -150,6 +188,16 @@ namespace ltfs_management
 		boost::mutex 					deleteMutex_;
 		map<string, UInt64_t>			shareSizeMap_;
 		boost::mutex 					shareSizeMapMutex_;
+		auto_ptr<bdt::FolderIdCache>	folderCache_;
+		set<string>						folderTables_;
+		boost::mutex 					folderTablesMutex_;
+		// (share, barcode) of the tables of older versions, true when
+		// the tape has a pack table too
+		map<pair<string, string>, bool>	legacyTables_;
+		// the tables emptied, with the time they were
+		map<string, boost::posix_time::ptime>	legacyDrops_;
+		boost::mutex 					legacyMutex_;
+		boost::thread_specific_ptr<int>	lastError_;
 	};
 
 } /* namespace ltfs_management */
@@ -0,0 +1,995 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * CatalogDbManagerTest.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#include "stdafx.h"
+#include "../CatalogDbManager.h"
+#include "SqliteConnector.h"
+#include "TapeDbManagerSimulator.h"
+#include "CatalogDbManagerTest.h"
+
+using namespace ltfs_management;
+
+CPPUNIT_TEST_SUITE_REGISTRATION( CatalogDbManagerTest );
+CPPUNIT_TEST_SUITE_NAMED_REGISTRATION( CatalogFolderBenchmark, "Benchmark" );
+
+static const string TEST_DIR = "/tmp/catalog-test";
+static const string SHARE = "share-0001";
+static const string SHARE_SQL = "share_0001";
+static const string TAPE1 = "TAPE01L6";
+static const string TAPE2 = "TAPE02L6";
+
+
+static Connection *
+Connect()
+{
+	return get_driver_instance()->connect(COMM_DB_SERVER, COMM_DEFDB_USER, COMM_DEFDB_PASS);
+}
+
+static void
+Execute(const string& sql)
+{
+	boost::scoped_ptr<Connection> connection(Connect());
+	boost::scoped_ptr<Statement> stmt(connection->createStatement());
+	stmt->execute(sql);
+}
+
+// the first column of the first row
+static long long
+Query(const string& sql)
+{
+	boost::scoped_ptr<Connection> connection(Connect());
+	boost::scoped_ptr<Statement> stmt(connection->createStatement());
+	boost::scoped_ptr<ResultSet> rs(stmt->executeQuery(sql));
+	return rs->next() ? rs->getInt64(1) : -1;
+}
+
+static TapeFileInfo
+GetFileInfo(unsigned long long number, const string& path, unsigned long long offset, unsigned long long size,
+		const string& pack = "", unsigned long long position = 0)
+{
+	TapeFileInfo info;
+	info.mUuid = boost::lexical_cast<string>(number);
+	info.mMetaFilePath = path;
+	info.mOffset = offset;
+	info.mSize = size;
+	info.mPack = pack;
+	info.mPosition = position;
+	return info;
+}
+
+// count files in folders of 100 on the tape, numbered from first
+static void
+GetFileInfos(unsigned long long first, int count, unsigned long long offset, vector<TapeFileInfo>& infos)
+{
+	for(int i = 0; i < count; i++){
+		unsigned long long number = first + i;
+		string path = "/batch" + boost::lexical_cast<string>(first) + "/d" + boost::lexical_cast<string>(i / 100)
+				+ "/f" + boost::lexical_cast<string>(number);
+		infos.push_back(GetFileInfo(number, path, offset + i * 10, 1000 + i));
+	}
+}
+
+// the path of the file, empty when it is not in the catalog
+static string
+GetPath(CatalogDbManager * catalog, unsigned long long number)
+{
+	string path;
+	if(!catalog->GetMetaFilePath(SHARE, boost::lexical_cast<string>(number), path)){
+		return "";
+	}
+	return path;
+}
+
+static long long
+GetFolderId(unsigned long long number)
+{
+	return Query("select meta_folder from Meta_File_" + SHARE_SQL + " where uuid=" + boost::lexical_cast<string>(number));
+}
+
+static bool
+AddFile(CatalogDbManager * catalog, unsigned long long number, const string& path)
+{
+	map<string, vector<TapeFileInfo> > files;
+	files[TAPE1].push_back(GetFileInfo(number, path, number * 100, 10));
+	return catalog->AddTapeFiles(SHARE, files);
+}
+
+// the rows in statements of 500
+static void
+InsertRows(Connection * connection, const string& table, const vector<string>& rows)
+{
+	boost::scoped_ptr<Statement> stmt(connection->createStatement());
+	for(size_t i = 0; i < rows.size(); i += 500){
+		string sql = "insert into " + table + " values ";
+		for(size_t j = i; j < rows.size() && j < i + 500; j++){
+			sql += (j > i ? "," : "") + rows[j];
+		}
+		stmt->execute(sql);
+	}
+}
+
+// the File_ table of a tape of an older version with the files numbered
+// from first, at offset number * 10, and every tenth one in a pack when
+// packed. The meta rows of the files are added too.
+static void
+CreateLegacyTape(const string& barcode, unsigned long long first, int count, bool packed)
+{
+	boost::scoped_ptr<Connection> connection(Connect());
+	boost::scoped_ptr<Statement> stmt(connection->createStatement());
+	string suffix = barcode + "_" + SHARE_SQL;
+	stmt->execute("CREATE TABLE IF NOT EXISTS Meta_Folder_" + SHARE_SQL + " (id INTEGER PRIMARY KEY NOT NULL auto_increment, "
+			"path VARCHAR(512)) ENGINE=InnoDB DEFAULT CHARSET=utf8");
+	stmt->execute("CREATE TABLE IF NOT EXISTS Meta_File_" + SHARE_SQL + " (uuid BIGINT PRIMARY KEY NOT NULL, filename TEXT NOT NULL, "
+			"meta_folder integer NOT NULL, corrupted BOOL, size BIGINT NOT NULL) ENGINE=InnoDB DEFAULT CHARSET=utf8");
+	stmt->execute("insert ignore into Meta_Folder_" + SHARE_SQL + " values (1, '/m/')");
+	stmt->execute("CREATE TABLE File_" + suffix + " (uuid BIGINT PRIMARY KEY, offset BIGINT, flag integer, size BIGINT)");
+	if(packed){
+		stmt->execute("CREATE TABLE Pack_" + suffix + " (uuid BIGINT PRIMARY KEY, pack VARCHAR(128), position BIGINT)");
+	}
+	vector<string> files;
+	vector<string> packs;
+	vector<string> metas;
+	for(unsigned long long number = first; number < first + count; number++){
+		string n = boost::lexical_cast<string>(number);
+		files.push_back("(" + n + "," + n + "0,0,10)");
+		if(number % 10 == 0){
+			packs.push_back("(" + n + ",'pack-" + boost::lexical_cast<string>(number / 100) + "'," + n + ")");
+		}
+		metas.push_back("(" + n + ",'f" + n + "',1,0,10)");
+	}
+	InsertRows(connection.get(), "File_" + suffix, files);
+	if(packed){
+		InsertRows(connection.get(), "Pack_" + suffix, packs);
+	}
+	stmt->execute("delete from Meta_File_" + SHARE_SQL + " where uuid >= " + boost::lexical_cast<string>(first)
+			+ " and uuid < " + boost::lexical_cast<string>(first + count));
+	InsertRows(connection.get(), "Meta_File_" + SHARE_SQL, metas);
+}
+
+// waits up to seconds for the query to give the count
+static bool
+WaitForCount(const string& sql, long long count, int seconds)
+{
+	for(int i = 0; i < seconds * 100; i++){
+		if(Query(sql) == count){
+			return true;
+		}
+		boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+	}
+	return false;
+}
+
+static long long
+CountLegacyTables()
+{
+	return Query("select count(*) from sqlite_master where type='table' and (name like 'File|_%' escape '|' or name like 'Pack|_%' escape '|')");
+}
+
+// the emptied tables are dropped a while after they are no longer read, a
+// read on them after that fails
+static void
+DropLegacyTables(const string& tape1, const string& tape2)
+{
+	boost::this_thread::sleep(boost::posix_time::milliseconds(300));
+	CPPUNIT_ASSERT_EQUAL( 3LL, CountLegacyTables() );
+	Execute("drop table File_" + tape1 + "_" + SHARE_SQL + ", Pack_" + tape1 + "_" + SHARE_SQL
+			+ ", File_" + tape2 + "_" + SHARE_SQL);
+}
+
+static void
+SetTapes(const string& tape1, const string& tape2)
+{
+	vector<string> tapes;
+	tapes.push_back(tape1);
+	tapes.push_back(tape2);
+	TapeDbManagerSimulator::SetTapes(SHARE, tapes);
+}
+
+void
+CatalogDbManagerTest::setUp()
+{
+	fs::remove_all(TEST_DIR);
+	fs::create_directories(TEST_DIR);
+	sql::sqlite::SetDatabase(TEST_DIR + "/CatalogDb.sqlite");
+	vector<string> tapes;
+	tapes.push_back(TAPE1);
+	tapes.push_back(TAPE2);
+	TapeDbManagerSimulator::SetTapes(SHARE, tapes);
+}
+
+void
+CatalogDbManagerTest::tearDown()
+{
+	CatalogDbManager::Destroy();
+	TapeDbManagerSimulator::Clear();
+	fs::remove_all(TEST_DIR);
+}
+
+void
+CatalogDbManagerTest::testAddTapeFiles()
+{
+	CatalogDbManager * catalog = CatalogDbManager::Instance();
+
+	//  file 1 on both tapes, file 2 packed on the first one
+	map<string, vector<TapeFileInfo> > files;
+	files[TAPE1].push_back(GetFileInfo(1, "/a/one", 100, 10));
+	files[TAPE1].push_back(GetFileInfo(2, "/a/b/two", 200, 20, "pack-1", 512));
+	files[TAPE2].push_back(GetFileInfo(1, "/a/one", 300, 10));
+	CPPUNIT_ASSERT( catalog->AddTapeFiles(SHARE, files) );
+
+	string path;
+	CPPUNIT_ASSERT( catalog->GetMetaFilePath(SHARE, "1", path) );
+	CPPUNIT_ASSERT_EQUAL( string("/a/one"), path );
+	CPPUNIT_ASSERT( catalog->GetMetaFilePath(SHARE, "2", path) );
+	CPPUNIT_ASSERT_EQUAL( string("/a/b/two"), path );
+	CPPUNIT_ASSERT_EQUAL( 2LL, Query("select count(*) from Meta_Folder_" + SHARE_SQL) );
+
+	off_t offset = 0;
+	CPPUNIT_ASSERT( catalog->GetTapeFileOffset(SHARE, TAPE1, "1", offset) );
+	CPPUNIT_ASSERT_EQUAL( (off_t)100, offset );
+	CPPUNIT_ASSERT( catalog->GetTapeFileOffset(SHARE, TAPE2, "1", offset) );
+	CPPUNIT_ASSERT_EQUAL( (off_t)300, offset );
+
+	string pack;
+	off_t position = 0;
+	off_t size = 0;
+	CPPUNIT_ASSERT( catalog->GetTapeFilePack(SHARE, TAPE1, "2", pack, position, size) );
+	CPPUNIT_ASSERT_EQUAL( string("pack-1"), pack );
+	CPPUNIT_ASSERT_EQUAL( (off_t)512, position );
+	CPPUNIT_ASSERT_EQUAL( (off_t)20, size );
+
+	map<string, BackupInfo> backupInfo;
+	CPPUNIT_ASSERT( catalog->GetBackupInfo(SHARE, "1", backupInfo) );
+	CPPUNIT_ASSERT_EQUAL( (size_t)2, backupInfo.size() );
+	CPPUNIT_ASSERT_EQUAL( (off_t)10, backupInfo[TAPE2].mSize );
+
+	//  a file counts once in the share, whatever its copies
+	off_t total = 0;
+	CPPUNIT_ASSERT( catalog->GetTotalSize(SHARE, total) );
+	CPPUNIT_ASSERT_EQUAL( (off_t)30, total );
+
+	//  written again on the first tape, the copy on the second is stale
+	files.clear();
+	files[TAPE1].push_back(GetFileInfo(1, "/a/one", 400, 15));
+	CPPUNIT_ASSERT( catalog->AddTapeFiles(SHARE, files) );
+	CPPUNIT_ASSERT( catalog->GetTapeFileOffset(SHARE, TAPE1, "1", offset) );
+	CPPUNIT_ASSERT_EQUAL( (off_t)400, offset );
+	vector<string> uuids;
+	CPPUNIT_ASSERT( catalog->GetFilesToDelete(SHARE, TAPE2, uuids) );
+	CPPUNIT_ASSERT_EQUAL( (size_t)1, uuids.size() );
+	CPPUNIT_ASSERT_EQUAL( string("1"), uuids[0] );
+	uuids.clear();
+	CPPUNIT_ASSERT( catalog->GetFilesToDelete(SHARE, TAPE1, uuids) );
+	CPPUNIT_ASSERT( uuids.empty() );
+	CPPUNIT_ASSERT( catalog->GetTotalSize(SHARE, total) );
+	CPPUNIT_ASSERT_EQUAL( (off_t)35, total );
+	CPPUNIT_ASSERT_EQUAL( 2LL, Query("select count(*) from Meta_Folder_" + SHARE_SQL) );
+}
+
+void
+CatalogDbManagerTest::testAddTapeFilesRollback()
+{
+	CatalogDbManager * catalog = CatalogDbManager::Instance();
+
+	map<string, vector<TapeFileInfo> > files;
+	files[TAPE1].push_back(GetFileInfo(1, "/a/one", 100, 10));
+	CPPUNIT_ASSERT( catalog->AddTapeFiles(SHARE, files) );
+
+	//  the last statement of the batch fails, none of it is kept
+	Execute("create trigger FailTapeFile before insert on Tape_File when new.uuid = 3 "
+			"begin select raise(abort, 'refused'); end");
+	files.clear();
+	files[TAPE1].push_back(GetFileInfo(1, "/a/one", 500, 50));
+	files[TAPE1].push_back(GetFileInfo(2, "/new/two", 600, 20));
+	files[TAPE1].push_back(GetFileInfo(3, "/new/three", 700, 30));
+	CPPUNIT_ASSERT( false == catalog->AddTapeFiles(SHARE, files) );
+	//  the code of the refusal is kept for the caller to tell it from a lost connection
+	CPPUNIT_ASSERT( 0 != catalog->GetLastError() );
+
+	off_t offset = 0;
+	CPPUNIT_ASSERT( catalog->GetTapeFileOffset(SHARE, TAPE1, "1", offset) );
+	CPPUNIT_ASSERT_EQUAL( (off_t)100, offset );
+	string path;
+	CPPUNIT_ASSERT( false == catalog->GetMetaFilePath(SHARE, "2", path) );
+	CPPUNIT_ASSERT_EQUAL( 0LL, Query("select count(*) from Tape_File where flag=1") );
+	CPPUNIT_ASSERT_EQUAL( 1LL, Query("select count(*) from Meta_Folder_" + SHARE_SQL) );
+	off_t total = 0;
+	CPPUNIT_ASSERT( catalog->GetTotalSize(SHARE, total) );
+	CPPUNIT_ASSERT_EQUAL( (off_t)10, total );
+
+	//  the folder of the failed batch was not cached, it is added again
+	Execute("drop trigger FailTapeFile");
+	CPPUNIT_ASSERT( catalog->AddTapeFiles(SHARE, files) );
+	CPPUNIT_ASSERT_EQUAL( 0, catalog->GetLastError() );
+	CPPUNIT_ASSERT( catalog->GetMetaFilePath(SHARE, "3", path) );
+	CPPUNIT_ASSERT_EQUAL( string("/new/three"), path );
+	CPPUNIT_ASSERT( catalog->GetTotalSize(SHARE, total) );
+	CPPUNIT_ASSERT_EQUAL( (off_t)100, total );
+}
+
+// reads the files of the first batch until stopped, the time of each read
+// is kept with the number of files of the second batch it saw
+struct CatalogReader
+{
+	CatalogReader(CatalogDbManager * catalog, int count)
+	: catalog_(catalog), count_(count), stop_(false), errors_(0)
+	{
+	}
+
+	void
+	Run()
+	{
+		boost::scoped_ptr<Connection> connection(Connect());
+		for(int i = 0; !stop_; i++){
+			string uuid = boost::lexical_cast<string>(1 + i % count_);
+			boost::posix_time::ptime begin = boost::posix_time::microsec_clock::local_time();
+			off_t offset = 0;
+			string path;
+			if(!catalog_->GetTapeFileOffset(SHARE, TAPE1, uuid, offset)
+					|| offset != (off_t)(i % count_) * 10
+					|| !catalog_->GetMetaFilePath(SHARE, uuid, path)){
+				errors_++;
+			}
+			boost::scoped_ptr<Statement> stmt(connection->createStatement());
+			boost::scoped_ptr<ResultSet> rs(stmt->executeQuery("select count(*) from Tape_File where tape='" + TAPE2 + "'"));
+			rs->next();
+			long long seen = rs->getInt64(1);
+			boost::posix_time::ptime end = boost::posix_time::microsec_clock::local_time();
+			boost::unique_lock<boost::mutex> lock(mutex_);
+			reads_.push_back(make_pair(make_pair(begin, end), seen));
+		}
+	}
+
+	CatalogDbManager * catalog_;
+	int count_;
+	volatile bool stop_;
+	int errors_;
+	boost::mutex mutex_;
+	vector<pair<pair<boost::posix_time::ptime, boost::posix_time::ptime>, long long> > reads_;
+};
+
+void
+CatalogDbManagerTest::testAddTapeFilesConcurrentRead()
+{
+	CatalogDbManager * catalog = CatalogDbManager::Instance();
+	const int count = 10 * 1000;
+
+	map<string, vector<TapeFileInfo> > files;
+	GetFileInfos(1, count, 0, files[TAPE1]);
+	boost::posix_time::ptime begin = boost::posix_time::microsec_clock::local_time();
+	CPPUNIT_ASSERT( catalog->AddTapeFiles(SHARE, files) );
+	boost::posix_time::ptime end = boost::posix_time::microsec_clock::local_time();
+	CPPUNIT_ASSERT_EQUAL( (long long)count, Query("select count(*) from Tape_File") );
+	CPPUNIT_ASSERT_EQUAL( (long long)count / 100, Query("select count(*) from Meta_Folder_" + SHARE_SQL) );
+	long long first = (end - begin).total_milliseconds();
+
+	//  the second batch is written while the first is read
+	CatalogReader reader(catalog, count);
+	boost::thread thread(boost::bind(&CatalogReader::Run, &reader));
+	boost::this_thread::sleep(boost::posix_time::milliseconds(100));
+	unsigned long long waits = sql::sqlite::GetLockWaitCount();
+	files.clear();
+	GetFileInfos(count + 1, count, 0, files[TAPE2]);
+	begin = boost::posix_time::microsec_clock::local_time();
+	CPPUNIT_ASSERT( catalog->AddTapeFiles(SHARE, files) );
+	end = boost::posix_time::microsec_clock::local_time();
+	boost::this_thread::sleep(boost::posix_time::milliseconds(100));
+	reader.stop_ = true;
+	thread.join();
+
+	//  the reads during the batch did not wait for it, and saw all of it
+	//  or none
+	size_t during = 0;
+	long long longest = 0;
+	for(size_t i = 0; i < reader.reads_.size(); i++){
+		const pair<boost::posix_time::ptime, boost::posix_time::ptime>& read = reader.reads_[i].first;
+		long long seen = reader.reads_[i].second;
+		CPPUNIT_ASSERT( seen == 0 || seen == count );
+		if(read.first > begin && read.second < end){
+			during++;
+			longest = max(longest, (long long)(read.second - read.first).total_milliseconds());
+		}
+	}
+	long long second = (end - begin).total_milliseconds();
+	cout << endl << count << " files added in " << first << " ms, " << second << " ms while read, "
+			<< during << " reads during the batch, the longest " << longest << " ms" << endl;
+	CPPUNIT_ASSERT_EQUAL( 0, reader.errors_ );
+	CPPUNIT_ASSERT_EQUAL( waits, sql::sqlite::GetLockWaitCount() );
+	CPPUNIT_ASSERT( during > 0 );
+	CPPUNIT_ASSERT( longest * 2 < second );
+	CPPUNIT_ASSERT_EQUAL( 2LL * count, Query("select count(*) from Tape_File") );
+}
+
+void
+CatalogDbManagerTest::testFolderHashUpgrade()
+{
+	//  the tables of an older version, without the hash of the path
+	Execute("CREATE TABLE Meta_Folder_" + SHARE_SQL + " (id INTEGER PRIMARY KEY NOT NULL auto_increment, "
+			"path VARCHAR(512)) ENGINE=InnoDB DEFAULT CHARSET=utf8");
+	Execute("CREATE TABLE Meta_File_" + SHARE_SQL + " (uuid BIGINT PRIMARY KEY NOT NULL, filename TEXT NOT NULL, "
+			"meta_folder integer NOT NULL, corrupted BOOL, size BIGINT NOT NULL) ENGINE=InnoDB DEFAULT CHARSET=utf8");
+	Execute("insert into Meta_Folder_" + SHARE_SQL + "(path) values ('/a/'),('/a/b/'),('/a/')");
+	Execute("insert into Meta_File_" + SHARE_SQL + " values (1,'one',1,0,10),(4,'four',3,0,10)");
+
+	CatalogDbManager * catalog = CatalogDbManager::Instance();
+	CPPUNIT_ASSERT_EQUAL( string("/a/one"), GetPath(catalog, 1) );
+	CPPUNIT_ASSERT( AddFile(catalog, 2, "/a/b/two") );
+
+	//  the hashes of the folders there are filled, and their ids are kept;
+	//  a folder added twice is merged into its first row
+	CPPUNIT_ASSERT_EQUAL( 2LL, Query("select count(*) from Meta_Folder_" + SHARE_SQL) );
+	CPPUNIT_ASSERT_EQUAL( 1LL, GetFolderId(4) );
+	CPPUNIT_ASSERT_EQUAL( string("/a/four"), GetPath(catalog, 4) );
+	CPPUNIT_ASSERT_EQUAL( 2LL, GetFolderId(2) );
+	CPPUNIT_ASSERT_EQUAL( string("/a/b/two"), GetPath(catalog, 2) );
+	CPPUNIT_ASSERT_EQUAL( 0LL, Query("select count(*) from Meta_Folder_" + SHARE_SQL + " where path_hash is null") );
+	CPPUNIT_ASSERT_EQUAL( 1LL, Query("select count(*) from Meta_Folder_" + SHARE_SQL
+			+ " where path='/a/b/' and hex(path_hash)='F218DC3054693D47457E30C57B8B2425'") );
+	CPPUNIT_ASSERT_EQUAL( 1LL, Query("select count(*) from sqlite_master where type='index' and tbl_name='Meta_Folder_"
+			+ SHARE_SQL + "' and name like '%iMetaFolderHash' and sql like 'create unique index%'") );
+
+	//  upgraded once, a new instance finds the column there
+	CatalogDbManager::Destroy();
+	catalog = CatalogDbManager::Instance();
+	CPPUNIT_ASSERT( AddFile(catalog, 3, "/a/three") );
+	CPPUNIT_ASSERT_EQUAL( 1LL, GetFolderId(3) );
+	CPPUNIT_ASSERT_EQUAL( 2LL, Query("select count(*) from Meta_Folder_" + SHARE_SQL) );
+}
+
+void
+CatalogDbManagerTest::testRenameMetaFolder()
+{
+	CatalogDbManager * catalog = CatalogDbManager::Instance();
+	CPPUNIT_ASSERT( AddFile(catalog, 1, "/a/b/one") );
+	CPPUNIT_ASSERT( AddFile(catalog, 2, "/a/b/c/two") );
+	CPPUNIT_ASSERT( AddFile(catalog, 3, "/a/bc/three") );
+	CPPUNIT_ASSERT( AddFile(catalog, 4, "/A/b/four") );
+	CPPUNIT_ASSERT( AddFile(catalog, 5, "/a_b/five") );
+	CPPUNIT_ASSERT( AddFile(catalog, 6, "/axb/six") );
+
+	//  the folder and the ones below it, not the ones sharing a prefix of
+	//  its name or differing in case
+	CPPUNIT_ASSERT( catalog->RenameMetaFolder(SHARE, "/a/b", "/z") );
+	CPPUNIT_ASSERT_EQUAL( string("/z/one"), GetPath(catalog, 1) );
+	CPPUNIT_ASSERT_EQUAL( string("/z/c/two"), GetPath(catalog, 2) );
+	CPPUNIT_ASSERT_EQUAL( string("/a/bc/three"), GetPath(catalog, 3) );
+	CPPUNIT_ASSERT_EQUAL( string("/A/b/four"), GetPath(catalog, 4) );
+
+	//  the wildcards of like are matched as they are
+	CPPUNIT_ASSERT( catalog->RenameMetaFolder(SHARE, "/a_b/", "/y/") );
+	CPPUNIT_ASSERT_EQUAL( string("/y/five"), GetPath(catalog, 5) );
+	CPPUNIT_ASSERT_EQUAL( string("/axb/six"), GetPath(catalog, 6) );
+
+	//  the hashes follow the paths
+	long long folders = Query("select count(*) from Meta_Folder_" + SHARE_SQL);
+	CPPUNIT_ASSERT_EQUAL( 6LL, folders );
+	CPPUNIT_ASSERT_EQUAL( folders, Query("select count(*) from Meta_Folder_" + SHARE_SQL + " where path_hash=unhex(md5(path))") );
+	CPPUNIT_ASSERT_EQUAL( 1LL, Query("select count(*) from Meta_Folder_" + SHARE_SQL
+			+ " where path='/z/' and hex(path_hash)='54045C98B49791C4E925ABCD3A2BC0F6'") );
+
+	//  the cached ids follow them too: the renamed folder is found, the
+	//  old one is added again
+	CPPUNIT_ASSERT( AddFile(catalog, 7, "/z/c/seven") );
+	CPPUNIT_ASSERT_EQUAL( GetFolderId(2), GetFolderId(7) );
+	CPPUNIT_ASSERT( AddFile(catalog, 8, "/a/b/c/eight") );
+	CPPUNIT_ASSERT( GetFolderId(2) != GetFolderId(8) );
+	CPPUNIT_ASSERT_EQUAL( string("/a/b/c/eight"), GetPath(catalog, 8) );
+	CPPUNIT_ASSERT_EQUAL( folders + 1, Query("select count(*) from Meta_Folder_" + SHARE_SQL) );
+
+	//  a folder left without files at the target gives way to the renamed one
+	CPPUNIT_ASSERT( AddFile(catalog, 9, "/x/nine") );
+	vector<string> uuids(1, "9");
+	CPPUNIT_ASSERT( catalog->DeleteMetaFiles(SHARE, uuids) );
+	CPPUNIT_ASSERT_EQUAL( folders + 2, Query("select count(*) from Meta_Folder_" + SHARE_SQL) );
+	CPPUNIT_ASSERT( catalog->RenameMetaFolder(SHARE, "/z/c/", "/x/") );
+	CPPUNIT_ASSERT_EQUAL( string("/x/two"), GetPath(catalog, 2) );
+	CPPUNIT_ASSERT_EQUAL( string("/x/seven"), GetPath(catalog, 7) );
+	CPPUNIT_ASSERT_EQUAL( folders + 1, Query("select count(*) from Meta_Folder_" + SHARE_SQL) );
+}
+
+// adds the files of the batches, each with its own folder and the ones all
+// of them share
+static void
+AddFolderBatches(CatalogDbManager * catalog, int first, int batches, int * failures)
+{
+	for(int batch = 0; batch < batches; batch++){
+		map<string, vector<TapeFileInfo> > files;
+		for(int i = 0; i < 10; i++){
+			int number = first + batch * 10 + i;
+			string folder = i % 2 == 0 ? "/shared/" + boost::lexical_cast<string>(batch % 5)
+					: "/own/" + boost::lexical_cast<string>(number);
+			files[TAPE1].push_back(GetFileInfo(number, folder + "/f" + boost::lexical_cast<string>(number), number * 10, 10));
+		}
+		if(!catalog->AddTapeFiles(SHARE, files)){
+			(* failures)++;
+		}
+	}
+}
+
+void
+CatalogDbManagerTest::testFolderConcurrentAdd()
+{
+	CatalogDbManager * catalog = CatalogDbManager::Instance();
+	CPPUNIT_ASSERT( AddFile(catalog, 1, "/a/one") );
+
+	//  a folder is kept once however the batches adding it meet
+	const int threads = 4;
+	const int batches = 20;
+	int failures[threads] = { 0 };
+	boost::thread_group group;
+	for(int i = 0; i < threads; i++){
+		group.create_thread(boost::bind(AddFolderBatches, catalog, 1000 * (i + 1), batches, &failures[i]));
+	}
+	group.join_all();
+	for(int i = 0; i < threads; i++){
+		CPPUNIT_ASSERT_EQUAL( 0, failures[i] );
+	}
+	CPPUNIT_ASSERT_EQUAL( 1LL + 5 + threads * batches * 5, Query("select count(*) from Meta_Folder_" + SHARE_SQL) );
+	CPPUNIT_ASSERT_EQUAL( 1LL + threads * batches * 10, Query("select count(*) from Meta_File_" + SHARE_SQL) );
+	CPPUNIT_ASSERT_EQUAL( string("/shared/3/f1038"), GetPath(catalog, 1038) );
+
+	//  and the catalog refuses a second row for it
+	bool refused = false;
+	try{
+		Execute("insert into Meta_Folder_" + SHARE_SQL + "(path, path_hash) values ('/a/', unhex(md5('/a/')))");
+	}catch(const sql::SQLException&){
+		refused = true;
+	}
+	CPPUNIT_ASSERT( refused );
+}
+
+void
+CatalogDbManagerTest::testRenameMetaFolderRollback()
+{
+	CatalogDbManager * catalog = CatalogDbManager::Instance();
+	CPPUNIT_ASSERT( AddFile(catalog, 1, "/a/b/one") );
+	CPPUNIT_ASSERT( AddFile(catalog, 2, "/a/b/c/two") );
+
+	//  the folder below fails after the first was renamed
+	Execute("create trigger FailRename before update on Meta_Folder_" + SHARE_SQL
+			+ " when new.path like '/z/c/%' begin select raise(abort, 'refused'); end");
+	CPPUNIT_ASSERT( false == catalog->RenameMetaFolder(SHARE, "/a/b/", "/z/") );
+	Execute("drop trigger FailRename");
+
+	//  none of them is renamed, in the table or in the cache
+	CPPUNIT_ASSERT_EQUAL( 0LL, Query("select count(*) from Meta_Folder_" + SHARE_SQL + " where path like '/z/%'") );
+	CPPUNIT_ASSERT_EQUAL( string("/a/b/one"), GetPath(catalog, 1) );
+	CPPUNIT_ASSERT_EQUAL( string("/a/b/c/two"), GetPath(catalog, 2) );
+	CPPUNIT_ASSERT( AddFile(catalog, 3, "/a/b/three") );
+	CPPUNIT_ASSERT_EQUAL( GetFolderId(1), GetFolderId(3) );
+	CPPUNIT_ASSERT( AddFile(catalog, 4, "/a/b/c/four") );
+	CPPUNIT_ASSERT_EQUAL( GetFolderId(2), GetFolderId(4) );
+	CPPUNIT_ASSERT( AddFile(catalog, 5, "/z/five") );
+	CPPUNIT_ASSERT_EQUAL( string("/z/five"), GetPath(catalog, 5) );
+	CPPUNIT_ASSERT_EQUAL( 3LL, Query("select count(*) from Meta_Folder_" + SHARE_SQL) );
+
+	//  and it is done when tried again
+	CPPUNIT_ASSERT( catalog->RenameMetaFolder(SHARE, "/a/b/", "/x/") );
+	CPPUNIT_ASSERT_EQUAL( string("/x/c/four"), GetPath(catalog, 4) );
+	CPPUNIT_ASSERT( AddFile(catalog, 6, "/x/c/six") );
+	CPPUNIT_ASSERT_EQUAL( GetFolderId(2), GetFolderId(6) );
+}
+
+void
+CatalogDbManagerTest::testRenameMetaFileRollback()
+{
+	CatalogDbManager * catalog = CatalogDbManager::Instance();
+	CPPUNIT_ASSERT( AddFile(catalog, 1, "/a/one") );
+
+	//  the folder added for the new path goes with the failed update
+	Execute("create trigger FailRename before update on Meta_File_" + SHARE_SQL
+			+ " begin select raise(abort, 'refused'); end");
+	CPPUNIT_ASSERT( false == catalog->RenameMetaFile(SHARE, "1", "/new/one") );
+	CPPUNIT_ASSERT( 0 != catalog->GetLastError() );
+	Execute("drop trigger FailRename");
+	CPPUNIT_ASSERT_EQUAL( string("/a/one"), GetPath(catalog, 1) );
+	CPPUNIT_ASSERT_EQUAL( 1LL, Query("select count(*) from Meta_Folder_" + SHARE_SQL) );
+
+	//  and its id was not cached, the next file there adds it again
+	CPPUNIT_ASSERT( AddFile(catalog, 2, "/new/two") );
+	CPPUNIT_ASSERT_EQUAL( string("/new/two"), GetPath(catalog, 2) );
+	CPPUNIT_ASSERT( catalog->RenameMetaFile(SHARE, "1", "/new/one") );
+	CPPUNIT_ASSERT_EQUAL( string("/new/one"), GetPath(catalog, 1) );
+	CPPUNIT_ASSERT_EQUAL( GetFolderId(2), GetFolderId(1) );
+	CPPUNIT_ASSERT_EQUAL( 2LL, Query("select count(*) from Meta_Folder_" + SHARE_SQL) );
+}
+
+void
+CatalogDbManagerTest::testMigrateTapeFiles()
+{
+	const string legacy1 = "LEGACY1L6";
+	const string legacy2 = "LEGACY2L6";
+	const string tape1 = "share='" + SHARE_SQL + "' and tape='" + legacy1 + "'";
+	SetTapes(legacy1, legacy2);
+	CatalogDbManager::Instance();
+	CatalogDbManager::Destroy();
+	CreateLegacyTape(legacy1, 1, 2500, true);
+	CreateLegacyTape(legacy2, 1, 10, false);
+
+	//  the second batch fails until the gate is emptied
+	Execute("create table Migrate_Gate (id integer)");
+	Execute("insert into Migrate_Gate values (1)");
+	Execute("create trigger MigrateGate before insert on Tape_File when new.uuid > 1000 "
+			"and (select count(*) from Migrate_Gate) > 0 begin select raise(abort, 'gate'); end");
+	CatalogDbManager * catalog = CatalogDbManager::Instance();
+	CPPUNIT_ASSERT( WaitForCount("select count(*) from Tape_File where " + tape1, 1000, 10) );
+	boost::this_thread::sleep(boost::posix_time::milliseconds(300));
+
+	//  the batch that failed left nothing behind, the one before is whole
+	CPPUNIT_ASSERT_EQUAL( 1000LL, Query("select count(*) from Tape_File where " + tape1) );
+	CPPUNIT_ASSERT_EQUAL( 1500LL, Query("select count(*) from File_" + legacy1 + "_" + SHARE_SQL) );
+	CPPUNIT_ASSERT_EQUAL( 150LL, Query("select count(*) from Pack_" + legacy1 + "_" + SHARE_SQL) );
+	CPPUNIT_ASSERT_EQUAL( 1000LL, Query("select max(uuid) from Tape_File where " + tape1) );
+
+	//  the reads see the files on either side
+	off_t offset = 0;
+	CPPUNIT_ASSERT( catalog->GetTapeFileOffset(SHARE, legacy1, "1000", offset) );
+	CPPUNIT_ASSERT_EQUAL( (off_t)10000, offset );
+	CPPUNIT_ASSERT( catalog->GetTapeFileOffset(SHARE, legacy1, "1001", offset) );
+	CPPUNIT_ASSERT_EQUAL( (off_t)10010, offset );
+	string pack;
+	off_t position = 0;
+	off_t size = 0;
+	CPPUNIT_ASSERT( catalog->GetTapeFilePack(SHARE, legacy1, "1000", pack, position, size) );
+	CPPUNIT_ASSERT_EQUAL( string("pack-10"), pack );
+	CPPUNIT_ASSERT( catalog->GetTapeFilePack(SHARE, legacy1, "2000", pack, position, size) );
+	CPPUNIT_ASSERT_EQUAL( string("pack-20"), pack );
+	CPPUNIT_ASSERT_EQUAL( (off_t)2000, position );
+	CPPUNIT_ASSERT( catalog->GetTapeFilePack(SHARE, legacy1, "2001", pack, position, size) );
+	CPPUNIT_ASSERT_EQUAL( string(""), pack );
+	string next;
+	CPPUNIT_ASSERT( catalog->GetNextTapeFile(SHARE, legacy1, "1000", size, next) );
+	CPPUNIT_ASSERT_EQUAL( string("1001"), next );
+	map<string, BackupInfo> backupInfo;
+	CPPUNIT_ASSERT( catalog->GetBackupInfo(SHARE, "5", backupInfo) );
+	CPPUNIT_ASSERT_EQUAL( (size_t)2, backupInfo.size() );
+	CPPUNIT_ASSERT( catalog->GetBackupInfo(SHARE, "1500", backupInfo) );
+	CPPUNIT_ASSERT_EQUAL( (size_t)1, backupInfo.size() );
+	vector<string> uuids;
+	CPPUNIT_ASSERT( catalog->GetFilesToDelete(SHARE, legacy1, uuids) );
+	CPPUNIT_ASSERT( uuids.empty() );
+
+	//  stopped there, it goes on from there when started again
+	CatalogDbManager::Destroy();
+	CPPUNIT_ASSERT_EQUAL( 2500LL, Query("select count(*) from Tape_File where " + tape1) 
+			+ Query("select count(*) from File_" + legacy1 + "_" + SHARE_SQL) );
+	Execute("delete from Migrate_Gate");
+	catalog = CatalogDbManager::Instance();
+
+	//  the rows are moved 1000 at a time, and read meanwhile. The tables
+	//  emptied are kept a while for the reads begun before.
+	set<long long> moved;
+	const string legacyRows = "select (select count(*) from File_" + legacy1 + "_" + SHARE_SQL + ") + (select count(*) from File_"
+			+ legacy2 + "_" + SHARE_SQL + ")";
+	for(int i = 0; i < 1000 && Query(legacyRows) > 0; i++){
+		moved.insert(Query("select count(*) from Tape_File where " + tape1));
+		unsigned long long number = 1 + (i * 997) % 2500;
+		CPPUNIT_ASSERT( catalog->GetTapeFileOffset(SHARE, legacy1, boost::lexical_cast<string>(number), offset) );
+		CPPUNIT_ASSERT_EQUAL( (off_t)number * 10, offset );
+		boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+	}
+	CPPUNIT_ASSERT_EQUAL( 0LL, Query(legacyRows) );
+	DropLegacyTables(legacy1, legacy2);
+	for(set<long long>::iterator it = moved.begin(); it != moved.end(); it++){
+		CPPUNIT_ASSERT( *it == 1000 || *it == 2000 || *it == 2500 );
+	}
+
+	//  all of them, with their packs
+	CPPUNIT_ASSERT_EQUAL( 2500LL, Query("select count(*) from Tape_File where " + tape1) );
+	CPPUNIT_ASSERT_EQUAL( 250LL, Query("select count(*) from Tape_File where " + tape1 + " and pack<>''") );
+	CPPUNIT_ASSERT_EQUAL( 10LL, Query("select count(*) from Tape_File where tape='" + legacy2 + "'") );
+	CPPUNIT_ASSERT( catalog->GetTapeFilePack(SHARE, legacy1, "2000", pack, position, size) );
+	CPPUNIT_ASSERT_EQUAL( string("pack-20"), pack );
+	CPPUNIT_ASSERT_EQUAL( (off_t)2000, position );
+	CPPUNIT_ASSERT( catalog->GetNextTapeFile(SHARE, legacy1, "2499", size, next) );
+	CPPUNIT_ASSERT_EQUAL( string("2500"), next );
+	CPPUNIT_ASSERT( catalog->GetBackupInfo(SHARE, "5", backupInfo) );
+	CPPUNIT_ASSERT_EQUAL( (size_t)2, backupInfo.size() );
+	CPPUNIT_ASSERT_EQUAL( 2500LL, Query("select count(*) from Meta_File_" + SHARE_SQL) );
+}
+
+void
+CatalogDbManagerTest::testMigrateTapeFilesDuplicate()
+{
+	const string legacy1 = "LEGACY1L6";
+	const string legacy2 = "LEGACY2L6";
+	SetTapes(legacy1, legacy2);
+
+	//  a file moved before, still in the table of the tape
+	CatalogDbManager::Instance();
+	CatalogDbManager::Destroy();
+	CreateLegacyTape(legacy1, 1, 20, true);
+	CreateLegacyTape(legacy2, 1, 10, false);
+	Execute("insert into Tape_File values ('" + SHARE_SQL + "','" + legacy1 + "',3,9999,0,77,'',0)");
+
+	//  the rows of older versions wait while files are added
+	Execute("create table Migrate_Gate (id integer)");
+	Execute("insert into Migrate_Gate values (1)");
+	Execute("create trigger MigrateGate before insert on Tape_File when new.offset < 1000000 "
+			"and (select count(*) from Migrate_Gate) > 0 begin select raise(abort, 'gate'); end");
+	CatalogDbManager * catalog = CatalogDbManager::Instance();
+	map<string, vector<TapeFileInfo> > files;
+	files[legacy1].push_back(GetFileInfo(5, "/m/f5", 2000000, 10));
+	files[legacy1].push_back(GetFileInfo(7, "/m/f7", 2000100, 10));
+	CPPUNIT_ASSERT( catalog->AddTapeFiles(SHARE, files) );
+
+	//  the files added replace their rows there, and their copies on the
+	//  other tape are stale
+	off_t offset = 0;
+	CPPUNIT_ASSERT( catalog->GetTapeFileOffset(SHARE, legacy1, "7", offset) );
+	CPPUNIT_ASSERT_EQUAL( (off_t)2000100, offset );
+	string pack;
+	off_t position = 0;
+	off_t size = 0;
+	CPPUNIT_ASSERT( catalog->GetTapeFilePack(SHARE, legacy1, "5", pack, position, size) );
+	CPPUNIT_ASSERT_EQUAL( string(""), pack );
+	CPPUNIT_ASSERT_EQUAL( 18LL, Query("select count(*) from File_" + legacy1 + "_" + SHARE_SQL) );
+	vector<string> uuids;
+	CPPUNIT_ASSERT( catalog->GetFilesToDelete(SHARE, legacy2, uuids) );
+	CPPUNIT_ASSERT_EQUAL( (size_t)2, uuids.size() );
+
+	Execute("delete from Migrate_Gate");
+	CPPUNIT_ASSERT( WaitForCount("select (select count(*) from File_" + legacy1 + "_" + SHARE_SQL + ") + (select count(*) from File_"
+			+ legacy2 + "_" + SHARE_SQL + ")", 0, 10) );
+	DropLegacyTables(legacy1, legacy2);
+
+	//  the rows moved before are kept over the ones of the old table
+	CPPUNIT_ASSERT_EQUAL( 20LL, Query("select count(*) from Tape_File where tape='" + legacy1 + "'") );
+	CPPUNIT_ASSERT( catalog->GetTapeFileOffset(SHARE, legacy1, "3", offset) );
+	CPPUNIT_ASSERT_EQUAL( (off_t)9999, offset );
+	CPPUNIT_ASSERT( catalog->GetTapeFileOffset(SHARE, legacy1, "7", offset) );
+	CPPUNIT_ASSERT_EQUAL( (off_t)2000100, offset );
+	CPPUNIT_ASSERT( catalog->GetTapeFilePack(SHARE, legacy1, "5", pack, position, size) );
+	CPPUNIT_ASSERT_EQUAL( string(""), pack );
+	CPPUNIT_ASSERT( catalog->GetTapeFilePack(SHARE, legacy1, "10", pack, position, size) );
+	CPPUNIT_ASSERT_EQUAL( string("pack-0"), pack );
+
+	//  the copies on both tapes are there, the stale ones still to delete
+	CPPUNIT_ASSERT_EQUAL( 2LL, Query("select count(*) from Tape_File where uuid=1") );
+	map<string, BackupInfo> backupInfo;
+	CPPUNIT_ASSERT( catalog->GetBackupInfo(SHARE, "1", backupInfo) );
+	CPPUNIT_ASSERT_EQUAL( (size_t)2, backupInfo.size() );
+	CPPUNIT_ASSERT( catalog->GetFilesToDelete(SHARE, legacy2, uuids) );
+	CPPUNIT_ASSERT_EQUAL( (size_t)2, uuids.size() );
+	sort(uuids.begin(), uuids.end());
+	CPPUNIT_ASSERT_EQUAL( string("5"), uuids[0] );
+	CPPUNIT_ASSERT_EQUAL( string("7"), uuids[1] );
+}
+
+void
+CatalogDbManagerTest::testBackupInfoManyTapes()
+{
+	const int tapeCount = 5000;
+	CatalogDbManager * catalog = CatalogDbManager::Instance();
+
+	//  two files on each tape, each file on two tapes
+	vector<string> tapes;
+	map<string, vector<TapeFileInfo> > files;
+	for(int i = 0; i < tapeCount; i++){
+		char barcode[16];
+		snprintf(barcode, sizeof(barcode), "T%04dL6", i);
+		tapes.push_back(barcode);
+		unsigned long long first = i + 1;
+		unsigned long long second = (i + 1) % tapeCount + 1;
+		files[barcode].push_back(GetFileInfo(first, "/m/f" + boost::lexical_cast<string>(first), 10, first));
+		files[barcode].push_back(GetFileInfo(second, "/m/f" + boost::lexical_cast<string>(second), 20, second));
+	}
+	TapeDbManagerSimulator::SetTapes(SHARE, tapes);
+	CPPUNIT_ASSERT( catalog->AddTapeFiles(SHARE, files) );
+
+	//  the same files in a table per tape, as older versions had them.
+	//  They are created after the catalog started, it does not move them.
+	boost::scoped_ptr<Connection> connection(Connect());
+	boost::scoped_ptr<Statement> stmt(connection->createStatement());
+	connection->setAutoCommit(false);
+	for(int i = 0; i < tapeCount; i++){
+		const vector<TapeFileInfo>& infos = files[tapes[i]];
+		string table = "File_" + tapes[i] + "_" + SHARE_SQL;
+		stmt->execute("CREATE TABLE " + table + " (uuid BIGINT PRIMARY KEY, offset BIGINT, flag integer, size BIGINT)");
+		stmt->execute("insert into " + table + " values (" + infos[0].mUuid + ",10,0," + infos[0].mUuid + "),("
+				+ infos[1].mUuid + ",20,0," + infos[1].mUuid + ")");
+	}
+	connection->commit();
+	connection->setAutoCommit(true);
+
+	//  a lookup as the older versions did it, one query per tape of the
+	//  group. Their check of each table and their table locks are left
+	//  out, it costs less than it did.
+	const int lookups = 20;
+	boost::posix_time::ptime begin = boost::posix_time::microsec_clock::local_time();
+	vector<map<string, long long> > oldInfos(lookups);
+	for(int n = 0; n < lookups; n++){
+		string uuid = boost::lexical_cast<string>(1 + n * (tapeCount / lookups));
+		for(int i = 0; i < tapeCount; i++){
+			boost::scoped_ptr<ResultSet> rs(stmt->executeQuery("select size from File_" + tapes[i] + "_" + SHARE_SQL
+					+ " where uuid='" + uuid + "'"));
+			if(rs->next()){
+				oldInfos[n][tapes[i]] = rs->getInt64("size");
+			}
+		}
+	}
+	boost::posix_time::ptime end = boost::posix_time::microsec_clock::local_time();
+	long long oldTime = (end - begin).total_microseconds();
+
+	//  each connection of the pool reads the schema with the new tables
+	//  once, before it is timed
+	for(int n = 0; n < lookups * 2; n++){
+		map<string, BackupInfo> backupInfo;
+		CPPUNIT_ASSERT( catalog->GetBackupInfo(SHARE, "1", backupInfo) );
+	}
+	begin = boost::posix_time::microsec_clock::local_time();
+	vector<map<string, long long> > newInfos(lookups);
+	for(int n = 0; n < lookups; n++){
+		string uuid = boost::lexical_cast<string>(1 + n * (tapeCount / lookups));
+		map<string, BackupInfo> backupInfo;
+		CPPUNIT_ASSERT( catalog->GetBackupInfo(SHARE, uuid, backupInfo) );
+		for(map<string, BackupInfo>::iterator it = backupInfo.begin(); it != backupInfo.end(); it++){
+			newInfos[n][it->first] = it->second.mSize;
+		}
+	}
+	end = boost::posix_time::microsec_clock::local_time();
+	long long newTime = (end - begin).total_microseconds();
+	for(int n = 0; n < lookups; n++){
+		CPPUNIT_ASSERT_EQUAL( (size_t)2, oldInfos[n].size() );
+		CPPUNIT_ASSERT( oldInfos[n] == newInfos[n] );
+	}
+
+	//  the next file on a tape, from its table and from Tape_File
+	long long oldNextTime = 0;
+	long long newNextTime = 0;
+	for(int n = 0; n < lookups; n++){
+		const string& tape = tapes[n * (tapeCount / lookups)];
+		const string& uuid = files[tape][0].mUuid;
+		string table = "File_" + tape + "_" + SHARE_SQL;
+		begin = boost::posix_time::microsec_clock::local_time();
+		boost::scoped_ptr<ResultSet> rs(stmt->executeQuery("select offset from " + table + " where uuid='" + uuid + "'"));
+		CPPUNIT_ASSERT( rs->next() );
+		string offset = rs->getString("offset");
+		rs.reset(stmt->executeQuery("select uuid from " + table + " where flag=0 and offset > " + offset
+				+ " order by offset ASC limit 1"));
+		CPPUNIT_ASSERT( rs->next() );
+		string oldNext = rs->getString("uuid");
+		rs.reset(stmt->executeQuery("select size from Meta_File_" + SHARE_SQL + " where uuid=" + oldNext));
+		CPPUNIT_ASSERT( rs->next() );
+		off_t oldSize = rs->getInt64("size");
+		end = boost::posix_time::microsec_clock::local_time();
+		oldNextTime += (end - begin).total_microseconds();
+
+		begin = boost::posix_time::microsec_clock::local_time();
+		string newNext;
+		off_t newSize = 0;
+		CPPUNIT_ASSERT( catalog->GetNextTapeFile(SHARE, tape, uuid, newSize, newNext) );
+		end = boost::posix_time::microsec_clock::local_time();
+		newNextTime += (end - begin).total_microseconds();
+		CPPUNIT_ASSERT_EQUAL( oldNext, newNext );
+		CPPUNIT_ASSERT_EQUAL( oldSize, newSize );
+	}
+
+	cout << endl << tapeCount << " tapes, " << lookups << " lookups: backup info " << oldTime / 1000 << " ms by tape, "
+			<< newTime / 1000 << " ms in Tape_File; next file " << oldNextTime / 1000 << " ms by tape, "
+			<< newNextTime / 1000 << " ms in Tape_File" << endl;
+	CPPUNIT_ASSERT( newTime < oldTime );
+}
+
+void
+CatalogFolderBenchmark::setUp()
+{
+	fs::remove_all(TEST_DIR);
+	fs::create_directories(TEST_DIR);
+	sql::sqlite::SetDatabase(TEST_DIR + "/CatalogDb.sqlite");
+	vector<string> tapes;
+	tapes.push_back(TAPE1);
+	TapeDbManagerSimulator::SetTapes(SHARE, tapes);
+}
+
+void
+CatalogFolderBenchmark::tearDown()
+{
+	CatalogDbManager::Destroy();
+	TapeDbManagerSimulator::Clear();
+	fs::remove_all(TEST_DIR);
+}
+
+static string
+GetBenchmarkFolder(int top, int sub)
+{
+	return "/t" + boost::lexical_cast<string>(top) + "/s" + boost::lexical_cast<string>(sub) + "/";
+}
+
+static long long
+GetMicroseconds(const boost::posix_time::ptime& begin)
+{
+	return (boost::posix_time::microsec_clock::local_time() - begin).total_microseconds();
+}
+
+void
+CatalogFolderBenchmark::testFolderLatency()
+{
+	const int tops = 1000;
+	const int subs = 999;
+	const int lookups = 2000;
+	const int renames = 20;
+
+	//  the tables are created by the catalog, then 1M folders are added
+	//  below it: 1000 top folders with 999 folders each
+	CatalogDbManager * catalog = CatalogDbManager::Instance();
+	CPPUNIT_ASSERT( AddFile(catalog, 1, "/file/one") );
+	boost::posix_time::ptime begin = boost::posix_time::microsec_clock::local_time();
+	{
+		boost::scoped_ptr<Connection> connection(Connect());
+		connection->setAutoCommit(false);
+		vector<string> rows;
+		for(int top = 0; top < tops; top++){
+			rows.push_back("(null,'/t" + boost::lexical_cast<string>(top) + "/',unhex(md5('/t" + boost::lexical_cast<string>(top) + "/')))");
+			for(int sub = 0; sub < subs; sub++){
+				string path = GetBenchmarkFolder(top, sub);
+				rows.push_back("(null,'" + path + "',unhex(md5('" + path + "')))");
+			}
+		}
+		InsertRows(connection.get(), "Meta_Folder_" + SHARE_SQL + "(id,path,path_hash)", rows);
+		connection->commit();
+	}
+	long long fillTime = GetMicroseconds(begin);
+	long long folders = Query("select count(*) from Meta_Folder_" + SHARE_SQL);
+	CPPUNIT_ASSERT( folders >= tops * (subs + 1) );
+
+	//  a file moved to a folder: the first time it is looked up by its
+	//  hash in the table, the second time it comes from the cache
+	srand(1);
+	vector<string> targets;
+	for(int n = 0; n < lookups; n++){
+		targets.push_back(GetBenchmarkFolder(rand() % tops, rand() % subs) + "one");
+	}
+	long long lookupTime[2] = { 0, 0 };
+	for(int pass = 0; pass < 2; pass++){
+		begin = boost::posix_time::microsec_clock::local_time();
+		for(int n = 0; n < lookups; n++){
+			CPPUNIT_ASSERT( catalog->RenameMetaFile(SHARE, "1", targets[n]) );
+		}
+		lookupTime[pass] = GetMicroseconds(begin);
+	}
+	CPPUNIT_ASSERT_EQUAL( targets[lookups - 1], GetPath(catalog, 1) );
+	CPPUNIT_ASSERT_EQUAL( folders, Query("select count(*) from Meta_Folder_" + SHARE_SQL) );
+
+	//  a top folder with its 999 folders, and a folder without any below it
+	long long renameTopTime = 0;
+	long long renameLeafTime = 0;
+	for(int n = 0; n < renames; n++){
+		string top = "/t" + boost::lexical_cast<string>(n) + "/";
+		string renamed = "/r" + boost::lexical_cast<string>(n) + "/";
+		begin = boost::posix_time::microsec_clock::local_time();
+		CPPUNIT_ASSERT( catalog->RenameMetaFolder(SHARE, top, renamed) );
+		renameTopTime += GetMicroseconds(begin);
+
+		string leaf = GetBenchmarkFolder(tops - 1 - n, 0);
+		begin = boost::posix_time::microsec_clock::local_time();
+		CPPUNIT_ASSERT( catalog->RenameMetaFolder(SHARE, leaf, leaf + "renamed") );
+		renameLeafTime += GetMicroseconds(begin);
+	}
+	CPPUNIT_ASSERT_EQUAL( (long long)(subs + 1), Query("select count(*) from Meta_Folder_" + SHARE_SQL
+			+ " where path like '/r0/%' and path_hash=unhex(md5(path))") );
+	CPPUNIT_ASSERT_EQUAL( 0LL, Query("select count(*) from Meta_Folder_" + SHARE_SQL + " where path like '/t0/%'") );
+	CPPUNIT_ASSERT_EQUAL( folders, Query("select count(*) from Meta_Folder_" + SHARE_SQL) );
+
+	cout << endl << folders << " folders added in " << fillTime / 1000 << " ms; file moved to a folder by hash "
+			<< lookupTime[0] / lookups << " us, from the cache " << lookupTime[1] / lookups << " us; rename of a folder with "
+			<< subs << " below " << renameTopTime / renames / 1000 << " ms, without " << renameLeafTime / renames / 1000
+			<< " ms" << endl;
+}
@@ -0,0 +1,70 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * CatalogDbManagerTest.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#pragma once
+
+
+class CatalogDbManagerTest : public CppUnit::TestFixture
+{
+	CPPUNIT_TEST_SUITE( CatalogDbManagerTest );
+	CPPUNIT_TEST( testAddTapeFiles );
+	CPPUNIT_TEST( testAddTapeFilesRollback );
+	CPPUNIT_TEST( testAddTapeFilesConcurrentRead );
+	CPPUNIT_TEST( testFolderHashUpgrade );
+	CPPUNIT_TEST( testFolderConcurrentAdd );
+	CPPUNIT_TEST( testRenameMetaFolder );
+	CPPUNIT_TEST( testRenameMetaFolderRollback );
+	CPPUNIT_TEST( testRenameMetaFileRollback );
+	CPPUNIT_TEST( testMigrateTapeFiles );
+	CPPUNIT_TEST( testMigrateTapeFilesDuplicate );
+	CPPUNIT_TEST( testBackupInfoManyTapes );
+	CPPUNIT_TEST_SUITE_END();
+
+public:
+	void setUp();
+	void tearDown();
+
+	void testAddTapeFiles();
+	void testAddTapeFilesRollback();
+	void testAddTapeFilesConcurrentRead();
+	void testFolderHashUpgrade();
+	void testFolderConcurrentAdd();
+	void testRenameMetaFolder();
+	void testRenameMetaFolderRollback();
+	void testRenameMetaFileRollback();
+	void testMigrateTapeFiles();
+	void testMigrateTapeFilesDuplicate();
+	void testBackupInfoManyTapes();
+};
+
+// measures the folder lookups and renames on a large catalog, run on
+// request only, see bdt-catalog_test.cpp
+class CatalogFolderBenchmark : public CppUnit::TestFixture
+{
+	CPPUNIT_TEST_SUITE( CatalogFolderBenchmark );
+	CPPUNIT_TEST( testFolderLatency );
+	CPPUNIT_TEST_SUITE_END();
+
+public:
+	void setUp();
+	void tearDown();
+
+	void testFolderLatency();
+};
@@ -0,0 +1,1069 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SqliteConnector.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#include <sqlite3.h>
+#include <openssl/evp.h>
+#include <vector>
+#include <set>
+#include <map>
+#include <memory>
+#include <boost/thread.hpp>
+#include <boost/regex.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/algorithm/string.hpp>
+#include <cppconn/driver.h>
+#include "SqliteConnector.h"
+
+using namespace std;
+
+namespace sql
+{
+	namespace sqlite
+	{
+		static boost::mutex mutex_;
+		static boost::condition_variable lockChanged_;
+		static string database_ = "CatalogDb.sqlite";
+		static unsigned long long statements_ = 0;
+		static unsigned long long lockWaits_ = 0;
+
+		// the connections holding a LOCK TABLES on a table
+		struct TableLock
+		{
+			TableLock() : writer(NULL) {}
+			set<const void*> readers;
+			const void* writer;
+		};
+		static map<string, TableLock> tableLocks_;
+		// the tables written by the open transaction of a connection
+		static map<const void*, set<string> > tablesWritten_;
+
+		void SetDatabase(const string& path)
+		{
+			boost::unique_lock<boost::mutex> lock(mutex_);
+			database_ = path;
+		}
+
+		static string GetDatabase()
+		{
+			boost::unique_lock<boost::mutex> lock(mutex_);
+			return database_;
+		}
+
+		unsigned long long GetStatementCount()
+		{
+			boost::unique_lock<boost::mutex> lock(mutex_);
+			return statements_;
+		}
+
+		unsigned long long GetLockWaitCount()
+		{
+			boost::unique_lock<boost::mutex> lock(mutex_);
+			return lockWaits_;
+		}
+
+		// true when a table is locked by another connection against the
+		// access, called with mutex_ held
+		static bool Conflicts(const void* owner, const map<string, bool>& tables)
+		{
+			for(map<string, bool>::const_iterator it = tables.begin(); it != tables.end(); it++){
+				map<string, TableLock>::const_iterator itLock = tableLocks_.find(it->first);
+				if(itLock == tableLocks_.end()){
+					continue;
+				}
+				if(itLock->second.writer != NULL && itLock->second.writer != owner){
+					return true;
+				}
+				if(it->second){
+					const set<const void*>& readers = itLock->second.readers;
+					if(readers.size() > 1 || (readers.size() == 1 && *readers.begin() != owner)){
+						return true;
+					}
+				}
+			}
+			return false;
+		}
+
+		static void UnlockTables(const void* owner)
+		{
+			boost::unique_lock<boost::mutex> lock(mutex_);
+			for(map<string, TableLock>::iterator it = tableLocks_.begin(); it != tableLocks_.end(); ){
+				it->second.readers.erase(owner);
+				if(it->second.writer == owner){
+					it->second.writer = NULL;
+				}
+				if(it->second.writer == NULL && it->second.readers.empty()){
+					tableLocks_.erase(it++);
+				}else{
+					it++;
+				}
+			}
+			lockChanged_.notify_all();
+		}
+
+		// true when a table is written by the open transaction of another
+		// connection, called with mutex_ held
+		static bool WrittenByOthers(const void* owner, const map<string, bool>& tables)
+		{
+			for(map<const void*, set<string> >::const_iterator it = tablesWritten_.begin(); it != tablesWritten_.end(); it++){
+				if(it->first == owner){
+					continue;
+				}
+				for(map<string, bool>::const_iterator itTable = tables.begin(); itTable != tables.end(); itTable++){
+					if(it->second.find(itTable->first) != it->second.end()){
+						return true;
+					}
+				}
+			}
+			return false;
+		}
+
+		static void EndTransaction(const void* owner)
+		{
+			boost::unique_lock<boost::mutex> lock(mutex_);
+			tablesWritten_.erase(owner);
+			lockChanged_.notify_all();
+		}
+
+		// a new LOCK TABLES drops the locks the connection had, it waits
+		// for the transactions writing the tables as the metadata locks of
+		// MySQL do
+		static void LockTables(const void* owner, const map<string, bool>& tables)
+		{
+			UnlockTables(owner);
+			boost::unique_lock<boost::mutex> lock(mutex_);
+			bool waited = false;
+			while(Conflicts(owner, tables) || WrittenByOthers(owner, tables)){
+				waited = true;
+				lockChanged_.wait(lock);
+			}
+			if(waited){
+				lockWaits_++;
+			}
+			for(map<string, bool>::const_iterator it = tables.begin(); it != tables.end(); it++){
+				if(it->second){
+					tableLocks_[it->first].writer = owner;
+				}else{
+					tableLocks_[it->first].readers.insert(owner);
+				}
+			}
+		}
+
+		// the words of the statement out of its literals
+		static void GetWords(const string& sql, set<string>& words)
+		{
+			string word;
+			bool literal = false;
+			for(size_t i = 0; i <= sql.length(); i++){
+				char c = i < sql.length() ? sql[i] : ' ';
+				if(c == '\''){
+					literal = !literal;
+				}
+				if(!literal && (isalnum((unsigned char)c) || c == '_')){
+					word += c;
+				}else if(!word.empty()){
+					words.insert(word);
+					word.clear();
+				}
+			}
+		}
+
+		// waits for the table locks of the others, the table written in a
+		// transaction is kept until it ends
+		static void WaitTables(const void* owner, const string& sql, bool transaction)
+		{
+			static const boost::regex writes("^\\s*(insert|replace|update|delete|alter|drop|create)\\b", boost::regex::perl | boost::regex::icase);
+			static const boost::regex target("^\\s*(?:(?:insert|replace)(?:\\s+or\\s+\\w+)?\\s+into|update|delete\\s+from)\\s+(\\w+)", boost::regex::perl | boost::regex::icase);
+			set<string> words;
+			GetWords(sql, words);
+			bool write = boost::regex_search(sql, writes);
+			boost::smatch match;
+			bool written = transaction && boost::regex_search(sql, match, target);
+
+			boost::unique_lock<boost::mutex> lock(mutex_);
+			map<string, bool> tables;
+			for(set<string>::iterator it = words.begin(); it != words.end(); it++){
+				if(tableLocks_.find(*it) != tableLocks_.end()){
+					tables[*it] = write;
+				}
+			}
+			bool waited = false;
+			while(Conflicts(owner, tables)){
+				waited = true;
+				lockChanged_.wait(lock);
+			}
+			if(waited){
+				lockWaits_++;
+			}
+			if(written){
+				tablesWritten_[owner].insert(match[1]);
+			}
+			statements_++;
+		}
+
+		// the literals are taken out as \1<index>\2 while the statement is
+		// rewritten, the MySQL escapes in them are undone
+		static string MaskLiterals(const string& sql, vector<string>& literals)
+		{
+			string masked;
+			for(size_t i = 0; i < sql.length(); i++){
+				if(sql[i] != '\''){
+					masked += sql[i];
+					continue;
+				}
+				string literal;
+				for(i++; i < sql.length(); i++){
+					if(sql[i] == '\\' && i + 1 < sql.length()){
+						char c = sql[++i];
+						if(c == 'n'){
+							c = '\n';
+						}else if(c == 't'){
+							c = '\t';
+						}else if(c == '0'){
+							c = '\0';
+						}
+						literal += c;
+					}else if(sql[i] == '\'' && i + 1 < sql.length() && sql[i + 1] == '\''){
+						literal += sql[++i];
+					}else if(sql[i] == '\''){
+						break;
+					}else{
+						literal += sql[i];
+					}
+				}
+				masked += "\1" + boost::lexical_cast<string>(literals.size()) + "\2";
+				literals.push_back(literal);
+			}
+			return masked;
+		}
+
+		static string UnmaskLiterals(const string& masked, const vector<string>& literals)
+		{
+			string sql;
+			for(size_t i = 0; i < masked.length(); i++){
+				if(masked[i] != '\1'){
+					sql += masked[i];
+					continue;
+				}
+				size_t end = masked.find('\2', i);
+				string literal = literals[boost::lexical_cast<size_t>(masked.substr(i + 1, end - i - 1))];
+				sql += "'" + boost::replace_all_copy(literal, "'", "''") + "'";
+				i = end;
+			}
+			return sql;
+		}
+
+		// the parts of a list separated by sep out of any parentheses
+		static void SplitList(const string& list, char sep, vector<string>& parts)
+		{
+			int depth = 0;
+			size_t begin = 0;
+			for(size_t i = 0; i <= list.length(); i++){
+				if(i == list.length() || (list[i] == sep && depth == 0)){
+					parts.push_back(boost::trim_copy(list.substr(begin, i - begin)));
+					begin = i + 1;
+				}else if(list[i] == '('){
+					depth++;
+				}else if(list[i] == ')'){
+					depth--;
+				}
+			}
+		}
+
+		// the indexes are per table in MySQL, per database here
+		static string CreateIndex(const string& table, const string& name, const string& columns, bool unique, bool ifNotExists)
+		{
+			static const boost::regex prefix("\\(\\s*\\d+\\s*\\)");
+			return string("create ") + (unique ? "unique " : "") + "index " + (ifNotExists ? "if not exists " : "")
+					+ table + "_" + name + " on " + table + " (" + boost::regex_replace(columns, prefix, "") + ")";
+		}
+
+		enum LockRequest
+		{
+			LOCK_NONE,
+			LOCK_TABLES,
+			UNLOCK_TABLES
+		};
+
+		// the statements of SQLite doing what the one of MySQL does
+		static LockRequest Translate(const string& sql, vector<string>& statements, map<string, bool>& tables)
+		{
+			const boost::regex::flag_type flags = boost::regex::perl | boost::regex::icase;
+			vector<string> literals;
+			string s = boost::trim_copy(MaskLiterals(sql, literals));
+			while(!s.empty() && s[s.length() - 1] == ';'){
+				s.erase(s.length() - 1);
+				boost::trim_right(s);
+			}
+
+			static const boost::regex insertIgnore("\\binsert\\s+ignore\\b", flags);
+			static const boost::regex autoIncrement("\\bauto_increment\\b", flags);
+			static const boost::regex engine("\\bengine\\s*=\\s*\\w+", flags);
+			static const boost::regex charset("\\bdefault\\s+charset\\s*=\\s*\\w+", flags);
+			static const boost::regex binary("=\\s*binary\\s+", flags);
+			static const boost::regex left("\\bleft\\s*\\(", flags);
+			static const boost::regex database("\\bdatabase\\s*\\(\\s*\\)", flags);
+			static const boost::regex schemaTables("\\binformation_schema\\.tables\\b", flags);
+			static const boost::regex schemaColumns("\\binformation_schema\\.columns\\b", flags);
+			static const boost::regex schemaStatistics("\\binformation_schema\\.statistics\\b", flags);
+			static const boost::regex shareMode("\\s+lock\\s+in\\s+share\\s+mode\\s*$", flags);
+			s = boost::regex_replace(s, insertIgnore, "insert or ignore");
+			s = boost::regex_replace(s, autoIncrement, "");
+			s = boost::regex_replace(s, engine, "");
+			s = boost::regex_replace(s, charset, "");
+			s = boost::regex_replace(s, binary, "= ");
+			s = boost::regex_replace(s, left, "mysql_left(");
+			s = boost::regex_replace(s, database, "'CatalogDb'");
+			s = boost::regex_replace(s, schemaTables,
+					"(select name as table_name, 'CatalogDb' as table_schema from sqlite_master where type='table')");
+			s = boost::regex_replace(s, schemaColumns,
+					"(select m.name as table_name, c.name as column_name, 'CatalogDb' as table_schema "
+					"from sqlite_master m join pragma_table_info(m.name) c where m.type='table')");
+			s = boost::regex_replace(s, schemaStatistics,
+					"(select m.name as table_name, substr(i.name, length(m.name) + 2) as index_name, 1 - i.[unique] as non_unique, "
+					"'CatalogDb' as table_schema from sqlite_master m join pragma_index_list(m.name) i where m.type='table')");
+			// a single writer, the rows read are the ones committed
+			s = boost::regex_replace(s, shareMode, "");
+
+			static const boost::regex createDatabase("create\\s+database\\b.*", flags);
+			static const boost::regex lockTables("lock\\s+tables?\\s+(.*)", flags);
+			static const boost::regex unlockTables("unlock\\s+tables?", flags);
+			static const boost::regex lockItem("(\\w+)\\b.*\\bwrite\\b.*", flags);
+			static const boost::regex alterTable("alter\\s+table\\s+(\\w+)\\s+(.*)", flags);
+			static const boost::regex addIndex("add\\s+(unique\\s+)?(?:index|key)\\s+(\\w+)\\s*\\((.*)\\)", flags);
+			static const boost::regex dropIndex("drop\\s+(?:index|key)\\s+(\\w+)", flags);
+			static const boost::regex createTable("create\\s+table\\s+(if\\s+not\\s+exists\\s+)?(\\w+)\\s*\\((.*)\\)\\s*", flags);
+			static const boost::regex tableIndex("(unique\\s+)?(?:index|key)\\s+(\\w+)\\s*\\((.*)\\)", flags);
+			static const boost::regex dropTable("drop\\s+table\\s+(if\\s+exists\\s+)?(.*)", flags);
+			static const boost::regex update("(update\\s+\\w+\\s+set\\s+)(.*)", flags);
+			static const boost::regex where("\\swhere\\s", flags);
+			static const boost::regex assignment("([\\w.]+)\\s*=\\s*(.*)", flags);
+			boost::smatch match;
+			vector<string> masked;
+			if(boost::regex_match(s, match, createDatabase)){
+				// one database for all the schemas
+			}else if(boost::regex_match(s, match, unlockTables)){
+				return UNLOCK_TABLES;
+			}else if(boost::regex_match(s, match, lockTables)){
+				vector<string> items;
+				SplitList(match[1], ',', items);
+				for(unsigned int i = 0; i < items.size(); i++){
+					boost::smatch item;
+					bool write = boost::regex_match(items[i], item, lockItem);
+					tables[items[i].substr(0, items[i].find_first_of(" \t\r\n"))] = write;
+				}
+				return LOCK_TABLES;
+			}else if(boost::regex_match(s, match, alterTable)){
+				string table = match[1];
+				vector<string> clauses;
+				SplitList(match[2], ',', clauses);
+				for(unsigned int i = 0; i < clauses.size(); i++){
+					boost::smatch index;
+					if(boost::regex_match(clauses[i], index, addIndex)){
+						masked.push_back(CreateIndex(table, index[2], index[3], index[1].matched, false));
+					}else if(boost::regex_match(clauses[i], index, dropIndex)){
+						masked.push_back("drop index " + table + "_" + string(index[1]));
+					}else{
+						masked.push_back("alter table " + table + " " + clauses[i]);
+					}
+				}
+			}else if(boost::regex_match(s, match, createTable)){
+				bool ifNotExists = match[1].matched;
+				string table = match[2];
+				vector<string> clauses;
+				vector<string> columns;
+				vector<string> indexes;
+				SplitList(match[3], ',', clauses);
+				for(unsigned int i = 0; i < clauses.size(); i++){
+					boost::smatch index;
+					if(boost::regex_match(clauses[i], index, tableIndex)){
+						indexes.push_back(CreateIndex(table, index[2], index[3], index[1].matched, ifNotExists));
+					}else{
+						columns.push_back(clauses[i]);
+					}
+				}
+				masked.push_back(string("create table ") + (ifNotExists ? "if not exists " : "") + table + " (" + boost::join(columns, ", ") + ")");
+				masked.insert(masked.end(), indexes.begin(), indexes.end());
+			}else if(boost::regex_match(s, match, dropTable)){
+				vector<string> names;
+				SplitList(match[2], ',', names);
+				for(unsigned int i = 0; i < names.size(); i++){
+					masked.push_back(string("drop table ") + (match[1].matched ? "if exists " : "") + names[i]);
+				}
+			}else if(boost::regex_match(s, match, update)){
+				// MySQL sets the columns from left to right, a later one sees
+				// the value given to an earlier one
+				string rest = match[2];
+				string tail;
+				int depth = 0;
+				for(size_t i = 0; i < rest.length(); i++){
+					if(rest[i] == '('){
+						depth++;
+					}else if(rest[i] == ')'){
+						depth--;
+					}else if(depth == 0 && boost::regex_search(rest.substr(i, 7), where, boost::match_continuous)){
+						tail = rest.substr(i);
+						rest = rest.substr(0, i);
+						break;
+					}
+				}
+				vector<string> assignments;
+				SplitList(rest, ',', assignments);
+				vector<pair<string, string> > values;
+				for(unsigned int i = 0; i < assignments.size(); i++){
+					boost::smatch value;
+					if(!boost::regex_match(assignments[i], value, assignment)){
+						values.clear();
+						break;
+					}
+					string expression = value[2];
+					for(unsigned int j = 0; j < values.size(); j++){
+						boost::regex column("(?<![\\w.])" + values[j].first + "\\b", flags);
+						expression = boost::regex_replace(expression, column, "(" + values[j].second + ")", boost::regex_constants::format_literal);
+					}
+					values.push_back(make_pair(string(value[1]), expression));
+				}
+				if(values.empty()){
+					masked.push_back(s);
+				}else{
+					string statement = match[1];
+					for(unsigned int i = 0; i < values.size(); i++){
+						statement += (i == 0 ? "" : ", ") + values[i].first + "=" + values[i].second;
+					}
+					masked.push_back(statement + tail);
+				}
+			}else{
+				masked.push_back(s);
+			}
+
+			for(unsigned int i = 0; i < masked.size(); i++){
+				statements.push_back(UnmaskLiterals(masked[i], literals));
+			}
+			return LOCK_NONE;
+		}
+
+		static void Md5(sqlite3_context* context, int argc, sqlite3_value** argv)
+		{
+			if(sqlite3_value_type(argv[0]) == SQLITE_NULL){
+				sqlite3_result_null(context);
+				return;
+			}
+			const unsigned char* text = sqlite3_value_text(argv[0]);
+			unsigned char digest[EVP_MAX_MD_SIZE];
+			unsigned int length = 0;
+			EVP_Digest(text, sqlite3_value_bytes(argv[0]), digest, &length, EVP_md5(), NULL);
+			static const char hex[] = "0123456789abcdef";
+			string result;
+			for(unsigned int i = 0; i < length; i++){
+				result += hex[digest[i] >> 4];
+				result += hex[digest[i] & 0xf];
+			}
+			sqlite3_result_text(context, result.c_str(), result.length(), SQLITE_TRANSIENT);
+		}
+
+		static void Unhex(sqlite3_context* context, int argc, sqlite3_value** argv)
+		{
+			if(sqlite3_value_type(argv[0]) == SQLITE_NULL){
+				sqlite3_result_null(context);
+				return;
+			}
+			string text = (const char*)sqlite3_value_text(argv[0]);
+			string result;
+			for(size_t i = 0; i + 1 < text.length(); i += 2){
+				result += (char)strtol(text.substr(i, 2).c_str(), NULL, 16);
+			}
+			sqlite3_result_blob(context, result.data(), result.length(), SQLITE_TRANSIENT);
+		}
+
+		static void Concat(sqlite3_context* context, int argc, sqlite3_value** argv)
+		{
+			string result;
+			for(int i = 0; i < argc; i++){
+				if(sqlite3_value_type(argv[i]) == SQLITE_NULL){
+					sqlite3_result_null(context);
+					return;
+				}
+				result.append((const char*)sqlite3_value_text(argv[i]), sqlite3_value_bytes(argv[i]));
+			}
+			sqlite3_result_text(context, result.c_str(), result.length(), SQLITE_TRANSIENT);
+		}
+
+		// the bytes of the first count characters of utf8
+		static size_t Utf8Bytes(const string& text, long long count)
+		{
+			size_t i = 0;
+			for(; i < text.length(); i++){
+				if(((unsigned char)text[i] & 0xc0) != 0x80 && count-- <= 0){
+					break;
+				}
+			}
+			return i;
+		}
+
+		static void CharLength(sqlite3_context* context, int argc, sqlite3_value** argv)
+		{
+			if(sqlite3_value_type(argv[0]) == SQLITE_NULL){
+				sqlite3_result_null(context);
+				return;
+			}
+			string text((const char*)sqlite3_value_text(argv[0]), sqlite3_value_bytes(argv[0]));
+			long long length = 0;
+			for(size_t i = 0; i < text.length(); i++){
+				if(((unsigned char)text[i] & 0xc0) != 0x80){
+					length++;
+				}
+			}
+			sqlite3_result_int64(context, length);
+		}
+
+		static void Left(sqlite3_context* context, int argc, sqlite3_value** argv)
+		{
+			if(sqlite3_value_type(argv[0]) == SQLITE_NULL){
+				sqlite3_result_null(context);
+				return;
+			}
+			string text((const char*)sqlite3_value_text(argv[0]), sqlite3_value_bytes(argv[0]));
+			size_t bytes = Utf8Bytes(text, sqlite3_value_int64(argv[1]));
+			sqlite3_result_text(context, text.c_str(), bytes, SQLITE_TRANSIENT);
+		}
+
+		struct Value
+		{
+			Value() : type(SQLITE_NULL), integer(0), real(0) {}
+			int type;
+			long long integer;
+			double real;
+			string text;
+		};
+
+		class SqliteResultSet : public ResultSet
+		{
+		public:
+			SqliteResultSet()
+			: row_(0)
+			{
+			}
+
+			bool
+			next()
+			{
+				if(row_ <= rows_.size()){
+					row_++;
+				}
+				return row_ <= rows_.size();
+			}
+
+			void
+			close()
+			{
+			}
+
+			size_t
+			rowsCount() const
+			{
+				return rows_.size();
+			}
+
+			bool
+			isNull(uint32_t columnIndex) const
+			{
+				return Get(columnIndex).type == SQLITE_NULL;
+			}
+
+			bool
+			isNull(const SQLString& columnLabel) const
+			{
+				return isNull(Find(columnLabel));
+			}
+
+			SQLString
+			getString(uint32_t columnIndex) const
+			{
+				const Value& value = Get(columnIndex);
+				switch(value.type){
+				case SQLITE_NULL:
+					return "";
+				case SQLITE_INTEGER:
+					return boost::lexical_cast<string>(value.integer);
+				case SQLITE_FLOAT:
+					return boost::lexical_cast<string>(value.real);
+				default:
+					return value.text;
+				}
+			}
+
+			SQLString
+			getString(const SQLString& columnLabel) const
+			{
+				return getString(Find(columnLabel));
+			}
+
+			bool
+			getBoolean(uint32_t columnIndex) const
+			{
+				return getInt64(columnIndex) != 0;
+			}
+
+			bool
+			getBoolean(const SQLString& columnLabel) const
+			{
+				return getBoolean(Find(columnLabel));
+			}
+
+			int32_t
+			getInt(uint32_t columnIndex) const
+			{
+				return (int32_t)getInt64(columnIndex);
+			}
+
+			int32_t
+			getInt(const SQLString& columnLabel) const
+			{
+				return getInt(Find(columnLabel));
+			}
+
+			uint32_t
+			getUInt(uint32_t columnIndex) const
+			{
+				return (uint32_t)getInt64(columnIndex);
+			}
+
+			uint32_t
+			getUInt(const SQLString& columnLabel) const
+			{
+				return getUInt(Find(columnLabel));
+			}
+
+			int64_t
+			getInt64(uint32_t columnIndex) const
+			{
+				const Value& value = Get(columnIndex);
+				switch(value.type){
+				case SQLITE_NULL:
+					return 0;
+				case SQLITE_INTEGER:
+					return value.integer;
+				case SQLITE_FLOAT:
+					return (int64_t)value.real;
+				default:
+					return strtoll(value.text.c_str(), NULL, 10);
+				}
+			}
+
+			int64_t
+			getInt64(const SQLString& columnLabel) const
+			{
+				return getInt64(Find(columnLabel));
+			}
+
+			uint64_t
+			getUInt64(uint32_t columnIndex) const
+			{
+				return (uint64_t)getInt64(columnIndex);
+			}
+
+			uint64_t
+			getUInt64(const SQLString& columnLabel) const
+			{
+				return getUInt64(Find(columnLabel));
+			}
+
+			vector<string> columns_;
+			vector<vector<Value> > rows_;
+
+		private:
+			const Value&
+			Get(uint32_t columnIndex) const
+			{
+				if(row_ == 0 || row_ > rows_.size()){
+					throw SQLException("No current row", "S1000");
+				}
+				if(columnIndex == 0 || columnIndex > columns_.size()){
+					throw SQLException("Invalid column index " + boost::lexical_cast<string>(columnIndex), "S1002");
+				}
+				return rows_[row_ - 1][columnIndex - 1];
+			}
+
+			uint32_t
+			Find(const SQLString& columnLabel) const
+			{
+				for(unsigned int i = 0; i < columns_.size(); i++){
+					if(boost::iequals(columns_[i], columnLabel)){
+						return i + 1;
+					}
+				}
+				throw SQLException("Invalid column label " + columnLabel, "S0022");
+			}
+
+			size_t row_;
+		};
+
+		struct Parameter
+		{
+			Parameter() : type(SQLITE_NULL), integer(0) {}
+			int type;
+			long long integer;
+			string text;
+		};
+
+		class SqliteConnection : public Connection
+		{
+		public:
+			SqliteConnection(const string& path)
+			: db_(NULL), autoCommit_(true), transaction_(false)
+			{
+				if(SQLITE_OK != sqlite3_open_v2(path.c_str(), &db_, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, NULL)){
+					string error = db_ ? sqlite3_errmsg(db_) : "out of memory";
+					sqlite3_close(db_);
+					db_ = NULL;
+					throw SQLException("Can't open " + path + ": " + error, "08001", 2002);
+				}
+				sqlite3_busy_timeout(db_, 60 * 1000);
+				Exec("pragma journal_mode=wal");
+				Exec("pragma synchronous=normal");
+				sqlite3_create_function(db_, "md5", 1, SQLITE_UTF8 | SQLITE_DETERMINISTIC, NULL, Md5, NULL, NULL);
+				sqlite3_create_function(db_, "unhex", 1, SQLITE_UTF8 | SQLITE_DETERMINISTIC, NULL, Unhex, NULL, NULL);
+				sqlite3_create_function(db_, "concat", -1, SQLITE_UTF8 | SQLITE_DETERMINISTIC, NULL, Concat, NULL, NULL);
+				sqlite3_create_function(db_, "char_length", 1, SQLITE_UTF8 | SQLITE_DETERMINISTIC, NULL, CharLength, NULL, NULL);
+				sqlite3_create_function(db_, "mysql_left", 2, SQLITE_UTF8 | SQLITE_DETERMINISTIC, NULL, Left, NULL, NULL);
+			}
+
+			~SqliteConnection()
+			{
+				close();
+			}
+
+			void
+			close()
+			{
+				if(db_ != NULL){
+					UnlockTables(this);
+					EndTransaction(this);
+					sqlite3_close_v2(db_);
+					db_ = NULL;
+				}
+			}
+
+			bool
+			isClosed()
+			{
+				return db_ == NULL;
+			}
+
+			void
+			commit()
+			{
+				if(transaction_){
+					transaction_ = false;
+					EndTransaction(this);
+					Exec("commit");
+				}
+			}
+
+			void
+			rollback()
+			{
+				if(transaction_){
+					transaction_ = false;
+					EndTransaction(this);
+					Exec("rollback");
+				}
+			}
+
+			bool
+			getAutoCommit()
+			{
+				return autoCommit_;
+			}
+
+			void
+			setAutoCommit(bool autoCommit)
+			{
+				if(autoCommit && !autoCommit_){
+					commit();
+				}
+				autoCommit_ = autoCommit;
+			}
+
+			void
+			setSchema(const SQLString& catalog)
+			{
+			}
+
+			Statement *
+			createStatement();
+
+			PreparedStatement *
+			prepareStatement(const SQLString& sql);
+
+			// runs the statement, the result set of the last statement
+			// having one is returned, NULL when there is none
+			int
+			Run(const string& sql, const map<unsigned int, Parameter>& parameters, ResultSet** result)
+			{
+				if(db_ == NULL){
+					throw SQLException("Connection is closed", "08003", 2006);
+				}
+				vector<string> statements;
+				map<string, bool> tables;
+				LockRequest request = Translate(sql, statements, tables);
+				if(request == LOCK_TABLES){
+					LockTables(this, tables);
+					return 0;
+				}else if(request == UNLOCK_TABLES){
+					UnlockTables(this);
+					return 0;
+				}
+
+				// a transaction takes the write lock at once, as a row lock of
+				// InnoDB would be taken by its first write
+				if(!autoCommit_ && !transaction_){
+					Exec("begin immediate");
+					transaction_ = true;
+				}
+				int changes = 0;
+				auto_ptr<SqliteResultSet> rows;
+				for(unsigned int i = 0; i < statements.size(); i++){
+					WaitTables(this, statements[i], transaction_);
+					sqlite3_stmt* stmt = NULL;
+					if(SQLITE_OK != sqlite3_prepare_v2(db_, statements[i].c_str(), -1, &stmt, NULL)){
+						Throw(statements[i]);
+					}
+					for(map<unsigned int, Parameter>::const_iterator it = parameters.begin(); it != parameters.end(); it++){
+						if(it->second.type == SQLITE_INTEGER){
+							sqlite3_bind_int64(stmt, it->first, it->second.integer);
+						}else if(it->second.type == SQLITE_TEXT){
+							sqlite3_bind_text(stmt, it->first, it->second.text.c_str(), it->second.text.length(), SQLITE_TRANSIENT);
+						}else{
+							sqlite3_bind_null(stmt, it->first);
+						}
+					}
+					int count = sqlite3_column_count(stmt);
+					auto_ptr<SqliteResultSet> current(new SqliteResultSet());
+					for(int j = 0; j < count; j++){
+						current->columns_.push_back(sqlite3_column_name(stmt, j));
+					}
+					int rc = SQLITE_OK;
+					while(SQLITE_ROW == (rc = sqlite3_step(stmt))){
+						vector<Value> row(count);
+						for(int j = 0; j < count; j++){
+							row[j].type = sqlite3_column_type(stmt, j);
+							if(row[j].type == SQLITE_INTEGER){
+								row[j].integer = sqlite3_column_int64(stmt, j);
+							}else if(row[j].type == SQLITE_FLOAT){
+								row[j].real = sqlite3_column_double(stmt, j);
+							}else if(row[j].type != SQLITE_NULL){
+								row[j].text.assign((const char*)sqlite3_column_blob(stmt, j), sqlite3_column_bytes(stmt, j));
+							}
+						}
+						current->rows_.push_back(row);
+					}
+					sqlite3_finalize(stmt);
+					if(rc != SQLITE_DONE){
+						Throw(statements[i]);
+					}
+					if(count > 0){
+						rows = current;
+					}
+					changes += sqlite3_changes(db_);
+				}
+				if(result != NULL){
+					*result = rows.release();
+				}
+				return changes;
+			}
+
+		private:
+			void
+			Exec(const string& sql)
+			{
+				if(SQLITE_OK != sqlite3_exec(db_, sql.c_str(), NULL, NULL, NULL)){
+					Throw(sql);
+				}
+			}
+
+			void
+			Throw(const string& sql)
+			{
+				throw SQLException(string(sqlite3_errmsg(db_)) + ": " + sql, "HY000", sqlite3_extended_errcode(db_));
+			}
+
+			sqlite3* db_;
+			bool autoCommit_;
+			bool transaction_;
+		};
+
+		// a Statement is a PreparedStatement with its sql given each time
+		class SqliteStatement : public PreparedStatement
+		{
+		public:
+			SqliteStatement(SqliteConnection* connection, const string& sql)
+			: connection_(connection), sql_(sql)
+			{
+			}
+
+			bool
+			execute(const SQLString& sql)
+			{
+				ResultSet* result = NULL;
+				connection_->Run(sql, parameters_, &result);
+				delete result;
+				return result != NULL;
+			}
+
+			ResultSet *
+			executeQuery(const SQLString& sql)
+			{
+				ResultSet* result = NULL;
+				connection_->Run(sql, parameters_, &result);
+				return result != NULL ? result : new SqliteResultSet();
+			}
+
+			int
+			executeUpdate(const SQLString& sql)
+			{
+				ResultSet* result = NULL;
+				int changes = connection_->Run(sql, parameters_, &result);
+				delete result;
+				return changes;
+			}
+
+			void
+			close()
+			{
+			}
+
+			bool
+			execute()
+			{
+				return execute(sql_);
+			}
+
+			ResultSet *
+			executeQuery()
+			{
+				return executeQuery(sql_);
+			}
+
+			int
+			executeUpdate()
+			{
+				return executeUpdate(sql_);
+			}
+
+			void
+			clearParameters()
+			{
+				parameters_.clear();
+			}
+
+			void
+			setNull(unsigned int parameterIndex, int sqlType)
+			{
+				parameters_[parameterIndex] = Parameter();
+			}
+
+			void
+			setBoolean(unsigned int parameterIndex, bool value)
+			{
+				setInt64(parameterIndex, value ? 1 : 0);
+			}
+
+			void
+			setInt(unsigned int parameterIndex, int32_t value)
+			{
+				setInt64(parameterIndex, value);
+			}
+
+			void
+			setUInt(unsigned int parameterIndex, uint32_t value)
+			{
+				setInt64(parameterIndex, value);
+			}
+
+			void
+			setInt64(unsigned int parameterIndex, int64_t value)
+			{
+				Parameter& parameter = parameters_[parameterIndex];
+				parameter.type = SQLITE_INTEGER;
+				parameter.integer = value;
+			}
+
+			void
+			setUInt64(unsigned int parameterIndex, uint64_t value)
+			{
+				setInt64(parameterIndex, (int64_t)value);
+			}
+
+			void
+			setString(unsigned int parameterIndex, const SQLString& value)
+			{
+				Parameter& parameter = parameters_[parameterIndex];
+				parameter.type = SQLITE_TEXT;
+				parameter.text = value;
+			}
+
+		private:
+			SqliteConnection* connection_;
+			string sql_;
+			map<unsigned int, Parameter> parameters_;
+		};
+
+		Statement *
+		SqliteConnection::createStatement()
+		{
+			return new SqliteStatement(this, "");
+		}
+
+		PreparedStatement *
+		SqliteConnection::prepareStatement(const SQLString& sql)
+		{
+			return new SqliteStatement(this, sql);
+		}
+
+		class SqliteDriver : public Driver
+		{
+		public:
+			Connection *
+			connect(const SQLString& hostName, const SQLString& userName, const SQLString& password)
+			{
+				return new SqliteConnection(GetDatabase());
+			}
+
+			Connection *
+			connect(ConnectOptionsMap& options)
+			{
+				return new SqliteConnection(GetDatabase());
+			}
+
+			const SQLString&
+			getName()
+			{
+				static const SQLString name("SQLite");
+				return name;
+			}
+		};
+	}
+}
+
+extern "C" sql::Driver * get_driver_instance()
+{
+	static sql::sqlite::SqliteDriver driver;
+	return &driver;
+}
@@ -0,0 +1,50 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SqliteConnector.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#pragma once
+
+#include <string>
+
+// The connections of get_driver_instance() go to one SQLite file instead
+// of the MySQL server. The statements are rewritten from the MySQL dialect
+// the catalog uses, the file is in WAL mode so a transaction writing does
+// not stop the readers, as with InnoDB. LOCK TABLES is kept between the
+// connections of the process, a statement on a table another connection
+// has locked waits for UNLOCK TABLES, and LOCK TABLES waits for the
+// transactions of the others writing the tables.
+namespace sql
+{
+	namespace sqlite
+	{
+		// the file of all the connections made after, all the schemas
+		// share it
+		void
+		SetDatabase(const std::string& path);
+
+		// statements run by all the connections
+		unsigned long long
+		GetStatementCount();
+
+		// statements that had to wait for the table lock of another
+		// connection
+		unsigned long long
+		GetLockWaitCount();
+	}
+}
@@ -0,0 +1,67 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * TapeDbManagerSimulator.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#include "stdafx.h"
+#include "TapeDbManagerSimulator.h"
+
+namespace ltfs_management
+{
+
+	static boost::mutex groupsMutex_;
+	static map<string, vector<string> > groups_;
+
+	TapeDbManager * TapeDbManager::instance_ = NULL;
+	boost::mutex TapeDbManager::instanceMutex_;
+
+	TapeDbManager::TapeDbManager()
+	{
+	}
+
+	TapeDbManager::~TapeDbManager()
+	{
+	}
+
+	bool
+	TapeDbManager::GetTapeGroupCartridgeList(const string& group, vector<string>& list)
+	{
+		boost::unique_lock<boost::mutex> lock(groupsMutex_);
+		map<string, vector<string> >::iterator it = groups_.find(group);
+		if(it == groups_.end()){
+			return false;
+		}
+		list.insert(list.end(), it->second.begin(), it->second.end());
+		return true;
+	}
+
+	void
+	TapeDbManagerSimulator::SetTapes(const string& group, const vector<string>& tapes)
+	{
+		boost::unique_lock<boost::mutex> lock(groupsMutex_);
+		groups_[group] = tapes;
+	}
+
+	void
+	TapeDbManagerSimulator::Clear()
+	{
+		boost::unique_lock<boost::mutex> lock(groupsMutex_);
+		groups_.clear();
+	}
+
+} /* namespace ltfs_management */
@@ -0,0 +1,40 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * TapeDbManagerSimulator.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#pragma once
+
+#include "../TapeDbManager.h"
+
+namespace ltfs_management
+{
+
+	// TapeDbManager with the tapes of the groups kept in memory, the
+	// catalog asks it for the tapes of a share
+	class TapeDbManagerSimulator
+	{
+	public:
+		static void
+		SetTapes(const string& group, const vector<string>& tapes);
+
+		static void
+		Clear();
+	};
+
+} /* namespace ltfs_management */
@@ -0,0 +1,83 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * connection.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#pragma once
+
+#include <map>
+#include "prepared_statement.h"
+
+namespace sql
+{
+
+	class ConnectPropertyVal
+	{
+	public:
+		ConnectPropertyVal()
+		{
+		}
+
+		ConnectPropertyVal(const SQLString& value)
+		: value_(value)
+		{
+		}
+
+	private:
+		SQLString value_;
+	};
+
+	typedef std::map<SQLString, ConnectPropertyVal> ConnectOptionsMap;
+
+	class Connection
+	{
+	public:
+		virtual
+		~Connection()
+		{
+		}
+
+		virtual void
+		close() = 0;
+
+		virtual bool
+		isClosed() = 0;
+
+		virtual void
+		commit() = 0;
+
+		virtual void
+		rollback() = 0;
+
+		virtual bool
+		getAutoCommit() = 0;
+
+		virtual void
+		setAutoCommit(bool autoCommit) = 0;
+
+		virtual void
+		setSchema(const SQLString& catalog) = 0;
+
+		virtual Statement *
+		createStatement() = 0;
+
+		virtual PreparedStatement *
+		prepareStatement(const SQLString& sql) = 0;
+	};
+
+}
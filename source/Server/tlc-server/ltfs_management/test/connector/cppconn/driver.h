@@ -0,0 +1,48 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * driver.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#pragma once
+
+#include "connection.h"
+
+namespace sql
+{
+
+	class Driver
+	{
+	public:
+		virtual
+		~Driver()
+		{
+		}
+
+		virtual Connection *
+		connect(const SQLString& hostName, const SQLString& userName, const SQLString& password) = 0;
+
+		virtual Connection *
+		connect(ConnectOptionsMap& options) = 0;
+
+		virtual const SQLString&
+		getName() = 0;
+	};
+
+}
+
+extern "C" sql::Driver * get_driver_instance();
@@ -0,0 +1,64 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * exception.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+// The part of the MySQL Connector/C++ interface the catalog uses, served
+// by SqliteConnector.cpp so the tests run without a MySQL server.
+
+#pragma once
+
+#include <string>
+#include <stdexcept>
+
+namespace sql
+{
+
+	typedef std::string SQLString;
+
+	class SQLException : public std::runtime_error
+	{
+	public:
+		SQLException(const std::string& reason, const std::string& sqlState = "HY000", int errorCode = 0)
+		: std::runtime_error(reason), sqlState_(sqlState), errorCode_(errorCode)
+		{
+		}
+
+		virtual
+		~SQLException() throw()
+		{
+		}
+
+		const std::string&
+		getSQLState() const
+		{
+			return sqlState_;
+		}
+
+		int
+		getErrorCode() const
+		{
+			return errorCode_;
+		}
+
+	private:
+		std::string sqlState_;
+		int errorCode_;
+	};
+
+}
@@ -0,0 +1,74 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * prepared_statement.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#pragma once
+
+#include "statement.h"
+
+namespace sql
+{
+
+	class PreparedStatement : public Statement
+	{
+	public:
+		virtual
+		~PreparedStatement()
+		{
+		}
+
+		using Statement::execute;
+		using Statement::executeQuery;
+		using Statement::executeUpdate;
+
+		virtual bool
+		execute() = 0;
+
+		virtual ResultSet *
+		executeQuery() = 0;
+
+		virtual int
+		executeUpdate() = 0;
+
+		virtual void
+		clearParameters() = 0;
+
+		virtual void
+		setNull(unsigned int parameterIndex, int sqlType) = 0;
+
+		virtual void
+		setBoolean(unsigned int parameterIndex, bool value) = 0;
+
+		virtual void
+		setInt(unsigned int parameterIndex, int32_t value) = 0;
+
+		virtual void
+		setUInt(unsigned int parameterIndex, uint32_t value) = 0;
+
+		virtual void
+		setInt64(unsigned int parameterIndex, int64_t value) = 0;
+
+		virtual void
+		setUInt64(unsigned int parameterIndex, uint64_t value) = 0;
+
+		virtual void
+		setString(unsigned int parameterIndex, const SQLString& value) = 0;
+	};
+
+}
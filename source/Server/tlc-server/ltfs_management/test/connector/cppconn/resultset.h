@@ -0,0 +1,89 @@
+/* Copyright (c) 2012 BDT Media Automation GmbH
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * resultset.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "exception.h"
+
+namespace sql
+{
+
+	class ResultSet
+	{
+	public:
+		virtual
+		~ResultSet()
+		{
+		}
+
+		virtual bool
+		next() = 0;
+
+		virtual void
+		close() = 0;
+
+		virtual size_t
+		rowsCount() const = 0;
+
+		virtual bool
+		isNull(uint32_t columnIndex) const = 0;
+
+		virtual bool
+		isNull(const SQLString& columnLabel) const = 0;
+
+		virtual SQLString
+		getString(uint32_t columnIndex) const = 0;
+
+		virtual SQLString
+		getString(const SQLString& columnLabel) const = 0;
+
+		virtual bool
+		getBoolean(uint32_t columnIndex) const = 0;
+
+		virtual bool
+		getBoolean(const SQLString& columnLabel) const = 0;
+
+		virtual int32_t
+		getInt(uint32_t columnIndex) const = 0;
+
+		virtual int32_t
+		getInt(const SQLString& columnLabel) const = 0;
+
+		virtual uint32_t
+		getUInt(uint32_t columnIndex) const = 0;
+
+		virtual uint32_t
+		getUInt(const SQLString& columnLabel) const = 0;
+
+		virtual int64_t
+		getInt64(uint32_t columnIndex) const = 0;
+
+		virtual int64_t
+		getInt64(const SQLString& columnLabel) const = 0;
+
+		virtual uint64_t
+		getUInt64(uint32_t columnIndex) const = 0;
+
+		virtual uint64_t
+		getUInt64(const SQLString& columnLabel) const = 0;
+	};
+
+}